@@ -7,19 +7,20 @@
 #define ANKI_SHADERS_MS_COMMON_VERT_GLSL
 
 #include "shaders/MsFsCommon.glsl"
+#include "shaders/Pack.glsl"
 
 //
-// Input
+// Input. The position is quantized and the world transform dequantizes it. Its W is the sign of the bitangent
 //
-layout(location = POSITION_LOCATION) in highp vec3 in_position;
+layout(location = POSITION_LOCATION) in highp vec4 in_position;
 layout(location = TEXTURE_COORDINATE_LOCATION) in highp vec2 in_uv;
 
 #if PASS == COLOR || TESSELLATION
-layout(location = NORMAL_LOCATION) in mediump vec4 in_normal;
+layout(location = NORMAL_LOCATION) in mediump vec2 in_normal;
 #endif
 
 #if PASS == COLOR
-layout(location = TANGENT_LOCATION) in mediump vec4 in_tangent;
+layout(location = TANGENT_LOCATION) in mediump vec2 in_tangent;
 #endif
 
 //
@@ -68,9 +69,9 @@ void writePositionAndUv(in mat4 mvp)
 #endif
 
 #if TESSELLATION
-	gl_Position = vec4(in_position, 1.0);
+	gl_Position = vec4(in_position.xyz, 1.0);
 #else
-	ANKI_WRITE_POSITION(mvp * vec4(in_position, 1.0));
+	ANKI_WRITE_POSITION(mvp * vec4(in_position.xyz, 1.0));
 #endif
 }
 
@@ -82,9 +83,9 @@ void writeNormalAndTangent(in mat3 normalMat)
 #if TESSELLATION
 
 	// Passthrough
-	out_normal = in_normal.xyz;
+	out_normal = unpackOctahedral(in_normal);
 #if PASS == COLOR
-	out_tangent = in_tangent;
+	out_tangent = vec4(unpackOctahedral(in_tangent), in_position.w);
 
 #if CALC_BITANGENT_IN_VERT
 #error TODO
@@ -95,9 +96,9 @@ void writeNormalAndTangent(in mat3 normalMat)
 #else
 
 #if PASS == COLOR
-	out_normal = normalMat * in_normal.xyz;
-	out_tangent.xyz = normalMat * in_tangent.xyz;
-	out_tangent.w = in_tangent.w;
+	out_normal = normalMat * unpackOctahedral(in_normal);
+	out_tangent.xyz = normalMat * unpackOctahedral(in_tangent);
+	out_tangent.w = in_position.w;
 
 #if CALC_BITANGENT_IN_VERT
 	out_bitangent = cross(out_normal, out_tangent.xyz) * in_tangent.w;
@@ -114,7 +115,7 @@ void writeNormalAndTangent(in mat3 normalMat)
 #define writeVertPosViewSpace_DEFINED
 void writeVertPosViewSpace(in mat4 modelViewMat)
 {
-	out_vertPosViewSpace = vec3(modelViewMat * vec4(in_position, 1.0));
+	out_vertPosViewSpace = vec3(modelViewMat * vec4(in_position.xyz, 1.0));
 }
 #endif
 
@@ -122,9 +123,9 @@ void writeVertPosViewSpace(in mat4 modelViewMat)
 #define writeParallax_DEFINED
 void writeParallax(in mat3 normalMat, in mat4 modelViewMat)
 {
-	vec3 n = normalMat * in_normal.xyz;
-	vec3 t = normalMat * in_tangent.xyz;
-	vec3 b = cross(n, t) * in_tangent.w;
+	vec3 n = normalMat * unpackOctahedral(in_normal);
+	vec3 t = normalMat * unpackOctahedral(in_tangent);
+	vec3 b = cross(n, t) * in_position.w;
 	mat3 invTbn = transpose(mat3(t, b, n));
 
 	writeVertPosViewSpace(modelViewMat);
@@ -29,6 +29,18 @@ vec3 unpackNormal(in vec2 enc)
 	return normalize(normal);
 }
 
+/// Decode a normal that is stored with the octahedral encoding. See MeshLoader.
+vec3 unpackOctahedral(in vec2 enc)
+{
+	vec3 n = vec3(enc, 1.0 - abs(enc.x) - abs(enc.y));
+	if(n.z < 0.0)
+	{
+		n.xy = (1.0 - abs(n.yx)) * vec2((n.x >= 0.0) ? 1.0 : -1.0, (n.y >= 0.0) ? 1.0 : -1.0);
+	}
+
+	return normalize(n);
+}
+
 #if GL_ES || __VERSION__ < 400
 
 // Vectorized version. See clean one at <= r1048
@@ -0,0 +1,32 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+// Clears a region of the shadow atlas or restores it from the static layer. RESTORE 1 restores a spot light region
+// and RESTORE 2 restores a face of an omni light
+
+#include "shaders/Common.glsl"
+
+#if RESTORE == 1
+layout(ANKI_TEX_BINDING(0, 0)) uniform sampler2D u_staticDepth;
+#elif RESTORE == 2
+layout(ANKI_TEX_BINDING(0, 0)) uniform sampler2DArray u_staticDepth;
+
+layout(ANKI_UBO_BINDING(0, 0), std140) uniform u0_
+{
+	uvec4 u_layerPad3;
+};
+#endif
+
+void main()
+{
+#if RESTORE == 1
+	// The static layer has the same layout as the atlas
+	gl_FragDepth = texelFetch(u_staticDepth, ivec2(gl_FragCoord.xy), 0).r;
+#elif RESTORE == 2
+	gl_FragDepth = texelFetch(u_staticDepth, ivec3(ivec2(gl_FragCoord.xy), int(u_layerPad3.x)), 0).r;
+#else
+	gl_FragDepth = 1.0;
+#endif
+}
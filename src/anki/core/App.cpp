@@ -221,7 +221,7 @@ Error App::initInternal(const ConfigSet& config_, AllocAlignedCallback allocCb,
 	//
 	m_physics = m_heapAlloc.newInstance<PhysicsWorld>();
 
-	ANKI_CHECK(m_physics->create(m_allocCb, m_allocCbData));
+	ANKI_CHECK(m_physics->create(m_allocCb, m_allocCbData, config));
 
 	//
 	// Resource FS
@@ -354,6 +354,9 @@ Error App::mainLoop()
 
 		ANKI_CHECK(m_scene->update(prevUpdateTime, crntTime, *m_renderer));
 
+		// Upload the meshes that were loaded before they are drawn
+		m_resources->flushGeometryUploads();
+
 		ANKI_CHECK(m_renderer->render(*m_scene));
 
 		// Pause and sync async loader. That will force all tasks before the
@@ -362,11 +365,27 @@ Error App::mainLoop()
 
 		m_gr->swapBuffers();
 
+		// Build the material variants that were drawn with a fallback
+		m_resources->buildPendingMaterialVariants();
+
+		// Swap the streamed textures and request the next mips
+		m_resources->updateTextureStreaming();
+
 		// Update the trace info with some async loader stats
 		U64 asyncTaskCount = m_resources->getAsyncLoader().getCompletedTaskCount();
 		ANKI_TRACE_INC_COUNTER(RESOURCE_ASYNC_TASKS, asyncTaskCount - m_resourceCompletedAsyncTaskCount);
 		m_resourceCompletedAsyncTaskCount = asyncTaskCount;
 
+		// And with the residency stats
+		ResourceResidencyStats residencyStats;
+		m_resources->getResidencyStats(residencyStats);
+		ANKI_TRACE_INC_COUNTER(RESOURCE_RESIDENCY_HITS, residencyStats.m_hits - m_resourceResidencyHits);
+		ANKI_TRACE_INC_COUNTER(RESOURCE_RESIDENCY_MISSES, residencyStats.m_misses - m_resourceResidencyMisses);
+		ANKI_TRACE_INC_COUNTER(RESOURCE_RESIDENCY_EVICTIONS, residencyStats.m_evictions - m_resourceResidencyEvictions);
+		m_resourceResidencyHits = residencyStats.m_hits;
+		m_resourceResidencyMisses = residencyStats.m_misses;
+		m_resourceResidencyEvictions = residencyStats.m_evictions;
+
 		// Now resume the loader
 		m_resources->getAsyncLoader().resume();
 
@@ -163,6 +163,9 @@ private:
 	String m_cacheDir; ///< This is used as a cache
 	F32 m_timerTick;
 	U64 m_resourceCompletedAsyncTaskCount = 0;
+	U64 m_resourceResidencyHits = 0;
+	U64 m_resourceResidencyMisses = 0;
+	U64 m_resourceResidencyEvictions = 0;
 
 	ANKI_USE_RESULT Error initInternal(const ConfigSet& config, AllocAlignedCallback allocCb, void* allocCbUserData);
 
@@ -19,6 +19,12 @@ Config::Config()
 	newOption("sm.bilinearEnabled", true);
 	newOption("sm.resolution", 512);
 	newOption("sm.maxLights", 4);
+	newOption("sm.staticCaching", true);
+	newOption("sm.spotAtlasResolution", 2048);
+	newOption("sm.spotAtlasPages", 1);
+	newOption("sm.spotMinResolution", 128);
+	newOption("sm.spotMaxResolution", 1024);
+	newOption("sm.spotTexelBudget", 2048 * 2048);
 
 	newOption("is.maxPointLights", 384);
 	newOption("is.maxSpotLights", 16);
@@ -49,6 +55,7 @@ Config::Config()
 	newOption("ir.enabled", true);
 	newOption("ir.rendererSize", 128);
 	newOption("ir.cubemapTextureArraySize", 32);
+	newOption("ir.maxFacesPerFrame", 2);
 	newOption("sslr.enabled", true);
 	newOption("sslr.startRoughnes", 0.2);
 
@@ -59,11 +66,22 @@ Config::Config()
 	newOption("width", 1280);
 	newOption("height", 768);
 	newOption("renderingQuality", 1.0); // Applies only to MainRenderer
+	newOption("dynamicResolution", false); // Only computes and reports a scale for the GPU frame time. Nothing scales yet
+	newOption("dynamicResolutionTargetFrameTime", 1.0 / 60.0); // In seconds
+	newOption("dynamicResolutionMinScale", 0.5);
 	newOption("lodDistance", 10.0); // Distance that used to calculate the LOD
+	newOption("lodScreenError", 1.0); // The max error of a mesh LOD on the screen in pixels
+	newOption("lodHysteresis", 0.25); // The band around lodScreenError that a LOD has to cross to change
+	newOption("lodTriangleBudget", 0); // The triangles of the camera in a frame. Zero to disable
 	newOption("samples", 1);
 	newOption("tessellation", true);
 	newOption("clusterSizeZ", 32);
 	newOption("imageReflectionMaxDistance", 30.0);
+	newOption("staticGeometryClusterSize", 32.0); // The max size of the clusters of the merged static geometry
+	newOption("sectorStreamingLoadDistance", 1); // The sectors that many portals away from the camera get loaded
+	newOption("sectorStreamingUnloadDistance", 2); // The sectors further than that many portals get unloaded
+	newOption("sectorStreamingFileBudget", 0); // The max file bytes of the loaded sectors. Zero for no limit
+	newOption("sectorStreamingTimeBudget", 0.002); // The seconds that creating the streamed models can take per frame
 
 	//
 	// GR
@@ -73,6 +91,13 @@ Config::Config()
 	newOption("gr.vertexPerFrameMemorySize", 1024 * 1024 * 10);
 	newOption("gr.transferPerFrameMemorySize", 1024 * 1024 * 128);
 	newOption("gr.transferPersistentMemorySize", (4096 / 4) * (4096 / 4) * 16 * 4);
+	newOption("gr.framesInFlight", 2); // The frames the GPU can have while the next one is recorded. Up to 2
+	newOption("gr.pipelineCacheThreads", 2);
+
+	//
+	// Physics
+	//
+	newOption("physics.threadCount", 2); // The worker threads of the Newton step
 
 	//
 	// Resource
@@ -80,6 +105,16 @@ Config::Config()
 	newOption("maxTextureSize", 1024 * 1024);
 	newOption("textureAnisotropy", 8);
 	newOption("dataPaths", ".");
+	newOption("materialVariantBuildsPerFrame", 0);
+	newOption("compiledResourceCache", true);
+	newOption("textureResidencyBudget", 128 * 1024 * 1024); // Memory of the unreferenced textures that stay loaded
+	newOption("meshResidencyBudget", 32 * 1024 * 1024);
+	newOption("resourceResidencyBudget", 1024 * 1024); // The rest of the types
+	newOption("textureStreamingBudget", 0); // Memory of the streamed texture mips. Zero disables the streaming
+	newOption("textureStreamingBaseSize", 64); // The max size of the mips that are always resident
+	newOption("textureStreamingUnseenFrames", 60); // Frames without requests before a texture can lose its mips
+	newOption("geometryVertexMemorySize", 64 * 1024 * 1024); // The shared vertex buffer of all the meshes
+	newOption("geometryIndexMemorySize", 16 * 1024 * 1024); // The shared index buffer of all the meshes
 
 	//
 	// Window
@@ -15,6 +15,7 @@ static Array<const char*, U(TraceEventType::COUNT)> eventNames = {{"SCENE_UPDATE
 	"SCENE_DELETE_STUFF",
 	"SCENE_PHYSICS_UPDATE",
 	"SCENE_NODES_UPDATE",
+	"SCENE_SKINNING",
 	"SCENE_VISIBILITY_TESTS",
 	"VIS_TEST",
 	"VIS_COMBINE_RESULTS",
@@ -35,6 +36,7 @@ static Array<const char*, U(TraceEventType::COUNT)> eventNames = {{"SCENE_UPDATE
 	"GL_BIND_RESOURCES",
 	"GL_BIND_PPLINE",
 	"GL_CMD_BUFFER_DESTROY",
+	"GL_THROTTLE",
 	"VK_ACQUIRE_IMAGE",
 	"VK_QUEUE_SUBMIT",
 	"SWAP_BUFFERS",
@@ -47,16 +49,44 @@ static Array<const char*, U(TraceCounterType::COUNT)> counterNames = {{"GR_DRAWC
 	"GR_PIPELINES_CREATED",
 	"GR_PIPELINE_BINDS_SKIPPED",
 	"GR_PIPELINE_BINDS_HAPPENED",
+	"GR_PIPELINE_SUB_STATES_SKIPPED",
+	"GR_CAPABILITY_CALLS_SKIPPED",
+	"GR_BLEND_CALLS_SKIPPED",
+	"GR_DEPTH_STENCIL_CALLS_SKIPPED",
+	"GR_RASTERIZER_CALLS_SKIPPED",
+	"GR_TEXTURE_BINDS_SKIPPED",
+	"GR_SAMPLER_BINDS_SKIPPED",
+	"GR_BUFFER_BINDS_SKIPPED",
+	"GR_PIPELINE_CACHE_HITS",
+	"GR_PIPELINE_CACHE_MISSES",
+	"GR_FRAMES_AHEAD",
 	"VK_PIPELINE_BARRIERS",
 	"VK_CMD_BUFFER_CREATE",
 	"VK_FENCE_CREATE",
 	"VK_SEMAPHORE_CREATE",
 	"RENDERER_LIGHTS",
 	"RENDERER_SHADOW_PASSES",
+	"RENDERER_SHADOW_STATIC_RENDERS",
+	"RENDERER_SHADOW_DYNAMIC_ONLY_PASSES",
 	"RENDERER_MERGED_DRAWCALLS",
 	"RENDERER_REFLECTIONS",
+	"RENDERER_REFLECTION_FACES",
+	"RENDERER_RESOLUTION_SCALE",
+	"RENDERER_LOD_0",
+	"RENDERER_LOD_1",
+	"RENDERER_LOD_2",
+	"RENDERER_LOD_TRANSITIONS",
+	"RENDERER_TRIANGLES",
+	"RENDERER_LOD_ERROR_BIAS",
+	"RENDERER_GRAPH_PEAK_MEMORY",
+	"RENDERER_GRAPH_SAVED_MEMORY",
 	"RESOURCE_ASYNC_TASKS",
-	"SCENE_NODES_UPDATED"}};
+	"RESOURCE_RESIDENCY_HITS",
+	"RESOURCE_RESIDENCY_MISSES",
+	"RESOURCE_RESIDENCY_EVICTIONS",
+	"SCENE_NODES_UPDATED",
+	"SCENE_SECTORS_LOADED",
+	"SCENE_SECTORS_UNLOADED"}};
 
 #define ANKI_TRACE_FILE_ERROR()                                                                                        \
 	if(err)                                                                                                            \
@@ -35,8 +35,8 @@ Error AnimationEvent::update(F32 prevUpdateTime, F32 crntTime)
 	ANKI_ASSERT(getSceneNode());
 	MoveComponent& move = getSceneNode()->getComponent<MoveComponent>();
 
-	Vec3 pos;
-	Quat rot;
+	Vec3 pos(0.0);
+	Quat rot = Quat::getIdentity();
 	F32 scale = 1.0;
 	m_anim->interpolate(0, crntTime, pos, rot, scale);
 
@@ -15,6 +15,7 @@ namespace anki
 // Forward
 class ConfigSet;
 class NativeWindow;
+class PipelinePersistentCache;
 
 /// @addtogroup graphics
 /// @{
@@ -59,6 +60,9 @@ public:
 	/// Wait for all work to finish.
 	void finish();
 
+	/// The seconds that the GPU spent on the last frame that it finished. Zero if it's not known yet.
+	F64 getGpuFrameTime() const;
+
 	/// Create a new graphics object.
 	template<typename T, typename... Args>
 	GrObjectPtr<T> newInstanceCached(U64 hash, GrObjectCache* cache, Args&&... args)
@@ -118,16 +122,23 @@ anki_internal:
 		return m_cacheDir.toCString();
 	}
 
-	U64& getUuidIndex()
+	Atomic<U64>& getUuidIndex()
 	{
 		return m_uuidIndex;
 	}
 
+	/// Null if the manager is not initialized.
+	PipelinePersistentCache* getPipelinePersistentCache()
+	{
+		return m_pplinePersistentCache.get();
+	}
+
 private:
 	GrAllocator<U8> m_alloc; ///< Keep it first to get deleted last
 	String m_cacheDir;
 	UniquePtr<GrManagerImpl> m_impl;
-	U64 m_uuidIndex = 1;
+	UniquePtr<PipelinePersistentCache> m_pplinePersistentCache;
+	Atomic<U64> m_uuidIndex = {1};
 };
 /// @}
 
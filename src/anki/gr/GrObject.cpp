@@ -13,7 +13,7 @@ namespace anki
 GrObject::GrObject(GrManager* manager, GrObjectType type, U64 hash, GrObjectCache* cache)
 	: m_refcount(0)
 	, m_manager(manager)
-	, m_uuid(m_manager->getUuidIndex()++)
+	, m_uuid(m_manager->getUuidIndex().fetchAdd(1))
 	, m_hash(hash)
 	, m_type(type)
 	, m_cache(cache)
@@ -4,6 +4,8 @@
 // http://www.anki3d.org/LICENSE
 
 #include <anki/gr/GrObjectCache.h>
+#include <anki/gr/Pipeline.h>
+#include <anki/gr/common/PipelinePersistentCache.h>
 
 namespace anki
 {
@@ -31,4 +33,10 @@ void GrObjectCache::unregisterObject(GrObject* obj)
 	obj->m_cache = nullptr;
 }
 
+Bool GrObjectCache::tryGetPrecreated(const PipelineInitInfo& init, PipelinePtr& ppline)
+{
+	PipelinePersistentCache* pcache = m_gr->getPipelinePersistentCache();
+	return pcache && pcache->tryGet(init, ppline);
+}
+
 } // end namespace anki
@@ -70,6 +70,16 @@ private:
 
 	/// Unregister an object from the cache.
 	void unregisterObject(GrObject* obj);
+
+	/// Try to get an object that was created ahead of time. Only pipelines can be pre-created.
+	template<typename T, typename TArg>
+	Bool tryGetPrecreated(const TArg&, GrObjectPtr<T>&)
+	{
+		return false;
+	}
+
+	/// Try to get a pipeline that PipelinePersistentCache pre-created.
+	Bool tryGetPrecreated(const PipelineInitInfo& init, PipelinePtr& ppline);
 };
 
 template<typename T, typename TArg>
@@ -82,7 +92,19 @@ inline GrObjectPtr<T> GrObjectCache::newInstance(const TArg& arg, U64 overrideHa
 	GrObject* ptr = tryFind(hash);
 	if(ptr == nullptr)
 	{
-		auto tptr = m_gr->template newInstanceCached<T>(hash, this, arg);
+		GrObjectPtr<T> tptr;
+		if(tryGetPrecreated(arg, tptr))
+		{
+			// Adopt it
+			ANKI_ASSERT(tptr->m_cache == nullptr);
+			tptr->m_hash = hash;
+			tptr->m_cache = this;
+		}
+		else
+		{
+			tptr = m_gr->template newInstanceCached<T>(hash, this, arg);
+		}
+
 		m_map.pushBack(m_gr->getAllocator(), hash, tptr.get());
 		return tptr;
 	}
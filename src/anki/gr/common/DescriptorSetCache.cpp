@@ -0,0 +1,304 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/common/DescriptorSetCache.h>
+#include <anki/util/Hash.h>
+
+namespace anki
+{
+
+/// A cached set.
+class DescriptorSetCacheEntry
+{
+public:
+	DescriptorSetCacheKey m_key;
+	U64 m_hash = 0;
+	DescriptorSetCacheSet* m_set = nullptr;
+
+	U32 m_refcount = 0;
+	U64 m_lastUsedFrame = 0;
+
+	/// The next entry with the same hash.
+	DescriptorSetCacheEntry* m_nextSameHash = nullptr;
+
+	/// @name LRU list
+	/// @{
+	DescriptorSetCacheEntry* m_lruPrev = nullptr;
+	DescriptorSetCacheEntry* m_lruNext = nullptr;
+	/// @}
+};
+
+U64 DescriptorSetCacheKey::computeHash() const
+{
+	ANKI_ASSERT(m_wordCount <= MAX_WORDS);
+	const U64 seed = m_layout ^ m_wordCount;
+	return (m_wordCount) ? anki::computeHash(&m_words[0], m_wordCount * sizeof(U64), seed) : seed;
+}
+
+Bool DescriptorSetCacheKey::operator==(const DescriptorSetCacheKey& b) const
+{
+	if(m_layout != b.m_layout || m_wordCount != b.m_wordCount)
+	{
+		return false;
+	}
+
+	for(U i = 0; i < m_wordCount; ++i)
+	{
+		if(m_words[i] != b.m_words[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+DescriptorSetCache::~DescriptorSetCache()
+{
+	destroy();
+}
+
+void DescriptorSetCache::destroy()
+{
+	while(m_lruHead)
+	{
+		Entry* entry = m_lruHead;
+		lruRemove(entry);
+		removeFromMap(entry);
+		deleteEntry(entry);
+	}
+
+	ANKI_ASSERT(m_map.isEmpty() && "Some sets are still referenced");
+	m_map.destroy(m_alloc);
+}
+
+void DescriptorSetCache::init(
+	GenericMemoryPoolAllocator<U8> alloc, DescriptorSetCacheInterface* iface, U32 recycleAge, U32 deleteAge)
+{
+	ANKI_ASSERT(iface);
+	ANKI_ASSERT(recycleAge > 0 && deleteAge >= recycleAge);
+	m_alloc = alloc;
+	m_iface = iface;
+	m_recycleAge = recycleAge;
+	m_deleteAge = deleteAge;
+}
+
+void DescriptorSetCache::insertToMap(Entry* entry)
+{
+	auto it = m_map.find(entry->m_hash);
+	if(it != m_map.getEnd())
+	{
+		// Collision, chain it after the first
+		Entry* first = *it;
+		entry->m_nextSameHash = first->m_nextSameHash;
+		first->m_nextSameHash = entry;
+	}
+	else
+	{
+		entry->m_nextSameHash = nullptr;
+		m_map.pushBack(m_alloc, entry->m_hash, entry);
+	}
+}
+
+void DescriptorSetCache::removeFromMap(Entry* entry)
+{
+	auto it = m_map.find(entry->m_hash);
+	ANKI_ASSERT(it != m_map.getEnd());
+
+	Entry* first = *it;
+	if(first == entry)
+	{
+		if(entry->m_nextSameHash)
+		{
+			*it = entry->m_nextSameHash;
+		}
+		else
+		{
+			m_map.erase(m_alloc, it);
+		}
+	}
+	else
+	{
+		Entry* prev = first;
+		while(prev->m_nextSameHash != entry)
+		{
+			prev = prev->m_nextSameHash;
+			ANKI_ASSERT(prev);
+		}
+
+		prev->m_nextSameHash = entry->m_nextSameHash;
+	}
+
+	entry->m_nextSameHash = nullptr;
+}
+
+void DescriptorSetCache::lruPushBack(Entry* entry)
+{
+	ANKI_ASSERT(entry->m_lruPrev == nullptr && entry->m_lruNext == nullptr);
+
+	entry->m_lruPrev = m_lruTail;
+	if(m_lruTail)
+	{
+		m_lruTail->m_lruNext = entry;
+	}
+	else
+	{
+		m_lruHead = entry;
+	}
+
+	m_lruTail = entry;
+}
+
+void DescriptorSetCache::lruRemove(Entry* entry)
+{
+	if(entry->m_lruPrev)
+	{
+		entry->m_lruPrev->m_lruNext = entry->m_lruNext;
+	}
+	else
+	{
+		ANKI_ASSERT(m_lruHead == entry);
+		m_lruHead = entry->m_lruNext;
+	}
+
+	if(entry->m_lruNext)
+	{
+		entry->m_lruNext->m_lruPrev = entry->m_lruPrev;
+	}
+	else
+	{
+		ANKI_ASSERT(m_lruTail == entry);
+		m_lruTail = entry->m_lruPrev;
+	}
+
+	entry->m_lruPrev = entry->m_lruNext = nullptr;
+}
+
+void DescriptorSetCache::deleteEntry(Entry* entry)
+{
+	ANKI_ASSERT(entry->m_refcount == 0);
+	m_iface->deleteSet(entry->m_set);
+	m_alloc.deleteInstance(entry);
+
+	ANKI_ASSERT(m_stats.m_setCount > 0);
+	--m_stats.m_setCount;
+}
+
+Error DescriptorSetCache::acquire(const DescriptorSetCacheKey& key, void* userData, DescriptorSetCacheHandle& handle)
+{
+	ANKI_ASSERT(m_iface && "Not initialized");
+	ANKI_ASSERT(!handle);
+	const U64 hash = key.computeHash();
+
+	LockGuard<Mutex> lock(m_mtx);
+
+	// Search the cache
+	Entry* entry = nullptr;
+	auto it = m_map.find(hash);
+	if(it != m_map.getEnd())
+	{
+		entry = *it;
+		while(entry && !(entry->m_key == key))
+		{
+			entry = entry->m_nextSameHash;
+		}
+	}
+
+	if(entry)
+	{
+		++m_stats.m_hits;
+
+		if(entry->m_refcount++ == 0)
+		{
+			lruRemove(entry);
+		}
+	}
+	else
+	{
+		++m_stats.m_misses;
+
+		// Try to recycle the least recently used set with the same layout that the GPU can't be using any more
+		Entry* candidate = m_lruHead;
+		while(candidate && m_frame - candidate->m_lastUsedFrame >= m_recycleAge)
+		{
+			if(candidate->m_key.m_layout == key.m_layout)
+			{
+				entry = candidate;
+				break;
+			}
+
+			candidate = candidate->m_lruNext;
+		}
+
+		if(entry)
+		{
+			++m_stats.m_recycled;
+			lruRemove(entry);
+			removeFromMap(entry);
+		}
+		else
+		{
+			DescriptorSetCacheSet* set = nullptr;
+			ANKI_CHECK(m_iface->newSet(key.m_layout, set));
+			ANKI_ASSERT(set);
+
+			entry = m_alloc.newInstance<Entry>();
+			entry->m_set = set;
+			++m_stats.m_setCount;
+		}
+
+		entry->m_key = key;
+		entry->m_hash = hash;
+		entry->m_refcount = 1;
+		insertToMap(entry);
+
+		m_iface->writeSet(entry->m_set, userData);
+	}
+
+	handle.m_set = entry->m_set;
+	handle.m_entry = entry;
+	return ErrorCode::NONE;
+}
+
+void DescriptorSetCache::release(DescriptorSetCacheHandle& handle)
+{
+	ANKI_ASSERT(handle);
+	Entry* entry = handle.m_entry;
+
+	LockGuard<Mutex> lock(m_mtx);
+
+	ANKI_ASSERT(entry->m_refcount > 0);
+	if(--entry->m_refcount == 0)
+	{
+		entry->m_lastUsedFrame = m_frame;
+		lruPushBack(entry);
+	}
+
+	handle = DescriptorSetCacheHandle();
+}
+
+void DescriptorSetCache::endFrame()
+{
+	LockGuard<Mutex> lock(m_mtx);
+
+	++m_frame;
+
+	// The LRU list is sorted by age so delete from the head
+	while(m_lruHead && m_frame - m_lruHead->m_lastUsedFrame > m_deleteAge)
+	{
+		Entry* entry = m_lruHead;
+		lruRemove(entry);
+		removeFromMap(entry);
+		deleteEntry(entry);
+	}
+}
+
+void DescriptorSetCache::getStats(DescriptorSetCacheStats& stats) const
+{
+	LockGuard<Mutex> lock(m_mtx);
+	stats = m_stats;
+}
+
+} // end namespace anki
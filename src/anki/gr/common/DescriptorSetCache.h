@@ -0,0 +1,167 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/Common.h>
+#include <anki/util/HashMap.h>
+#include <anki/util/Thread.h>
+
+namespace anki
+{
+
+// Forward
+class DescriptorSetCacheEntry;
+
+/// @addtogroup graphics
+/// @{
+
+/// The bindings of a descriptor set in a hashable form. The bound objects should be identified by their UUIDs and not
+/// by their backend handles because handles get recycled.
+class DescriptorSetCacheKey
+{
+public:
+	static const U MAX_WORDS = 3 * (MAX_TEXTURE_BINDINGS + MAX_UNIFORM_BUFFER_BINDINGS + MAX_STORAGE_BUFFER_BINDINGS)
+		+ 2 * MAX_IMAGE_BINDINGS;
+
+	U64 m_layout = 0; ///< Sets can only be recycled for keys with the same layout.
+	Array<U64, MAX_WORDS> m_words;
+	U32 m_wordCount = 0;
+
+	void pushBack(U64 word)
+	{
+		m_words[m_wordCount++] = word;
+	}
+
+	U64 computeHash() const;
+
+	Bool operator==(const DescriptorSetCacheKey& b) const;
+};
+
+/// The user defined descriptor set.
+class DescriptorSetCacheSet
+{
+};
+
+/// The user defined methods to create and write descriptor sets.
+class DescriptorSetCacheInterface
+{
+public:
+	virtual ~DescriptorSetCacheInterface()
+	{
+	}
+
+	/// Create a set with the given layout.
+	virtual ANKI_USE_RESULT Error newSet(U64 layout, DescriptorSetCacheSet*& set) = 0;
+
+	/// Delete a set.
+	virtual void deleteSet(DescriptorSetCacheSet* set) = 0;
+
+	/// Write the bindings to a new or recycled set.
+	/// @param userData What was passed to DescriptorSetCache::acquire.
+	virtual void writeSet(DescriptorSetCacheSet* set, void* userData) = 0;
+};
+
+/// The output of DescriptorSetCache::acquire.
+class DescriptorSetCacheHandle
+{
+	friend class DescriptorSetCache;
+
+public:
+	DescriptorSetCacheSet* m_set = nullptr;
+
+	operator Bool() const
+	{
+		return m_set != nullptr;
+	}
+
+private:
+	DescriptorSetCacheEntry* m_entry = nullptr;
+};
+
+class DescriptorSetCacheStats
+{
+public:
+	U32 m_hits = 0;
+	U32 m_misses = 0;
+	U32 m_recycled = 0; ///< Misses that recycled an old set.
+	U32 m_setCount = 0; ///< The number of sets the cache owns.
+};
+
+/// A cache of descriptor sets addressed by their bindings. Sets that are not referenced stay in the cache to be found
+/// again. After a number of frames they can be recycled for other bindings of the same layout and after some more
+/// frames they are deleted. It's thread-safe.
+class DescriptorSetCache : public NonCopyable
+{
+public:
+	DescriptorSetCache()
+	{
+	}
+
+	~DescriptorSetCache();
+
+	/// @param recycleAge Unreferenced sets older than that number of frames can be rewritten. It should be at least
+	///                   the number of frames the GPU is behind.
+	/// @param deleteAge Unreferenced sets older than that number of frames are deleted.
+	void init(GenericMemoryPoolAllocator<U8> alloc,
+		DescriptorSetCacheInterface* iface,
+		U32 recycleAge = MAX_FRAMES_IN_FLIGHT,
+		U32 deleteAge = 60);
+
+	/// Delete the cached sets. All sets should have been released.
+	void destroy();
+
+	/// Find a set with the same bindings or create a new one. The set is referenced until release() is called.
+	ANKI_USE_RESULT Error acquire(const DescriptorSetCacheKey& key, void* userData, DescriptorSetCacheHandle& handle);
+
+	/// Release a set acquired by acquire().
+	void release(DescriptorSetCacheHandle& handle);
+
+	/// Call it once a frame. It ages the unreferenced sets and deletes the oldest.
+	void endFrame();
+
+	void getStats(DescriptorSetCacheStats& stats) const;
+
+private:
+	using Entry = DescriptorSetCacheEntry;
+
+	/// The hash is already there.
+	class Hasher
+	{
+	public:
+		U64 operator()(U64 hash) const
+		{
+			return hash;
+		}
+	};
+
+	GenericMemoryPoolAllocator<U8> m_alloc;
+	DescriptorSetCacheInterface* m_iface = nullptr;
+	U32 m_recycleAge = 0;
+	U32 m_deleteAge = 0;
+	U64 m_frame = 0;
+
+	/// Key hash to a list of entries with that hash.
+	HashMap<U64, Entry*, Hasher> m_map;
+
+	/// The unreferenced entries. The head is the least recently used.
+	Entry* m_lruHead = nullptr;
+	Entry* m_lruTail = nullptr;
+
+	DescriptorSetCacheStats m_stats;
+
+	mutable Mutex m_mtx;
+
+	void insertToMap(Entry* entry);
+	void removeFromMap(Entry* entry);
+
+	void lruPushBack(Entry* entry);
+	void lruRemove(Entry* entry);
+
+	void deleteEntry(Entry* entry);
+};
+/// @}
+
+} // end namespace anki
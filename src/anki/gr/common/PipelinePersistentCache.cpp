@@ -0,0 +1,547 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/common/PipelinePersistentCache.h>
+#include <anki/gr/GrManager.h>
+#include <anki/util/File.h>
+#include <anki/util/Filesystem.h>
+#include <anki/util/Logger.h>
+#include <anki/core/Trace.h>
+#include <cstring>
+
+namespace anki
+{
+
+/// The pipelines that haven't been seen for that number of runs are dropped from the cache.
+static const U32 MAX_PIPELINE_AGE = 8;
+
+static const char* CACHE_FILENAME = "pipelines.cache";
+static const char CACHE_MAGIC[8] = {'A', 'N', 'K', 'I', 'P', 'P', 'C', '1'};
+
+class PipelinePersistentCacheHeader
+{
+public:
+	Array<char, 8> m_magic;
+	U32 m_stateSize;
+	U32 m_shaderCount;
+	U32 m_pipelineCount;
+};
+
+class PipelinePersistentCacheShader
+{
+public:
+	U64 m_hash = 0;
+	ShaderType m_type = ShaderType::COUNT;
+	String m_source;
+	ShaderPtr m_precreated;
+};
+
+class PipelinePersistentCachePipeline
+{
+public:
+	enum class Status : U8
+	{
+		PENDING, ///< Loaded and not created yet.
+		PRECREATED, ///< Created by the threads and waiting to be used.
+		USED ///< Seen in this run.
+	};
+
+	PipelineInitInfoState m_state;
+	Array<U64, U(ShaderType::COUNT)> m_shaders;
+	U32 m_age = 0; ///< The number of runs since it was last used.
+	Status m_status = Status::USED;
+	PipelinePtr m_precreated;
+};
+
+PipelinePersistentCache::PipelinePersistentCache(GrManager* manager)
+	: m_manager(manager)
+{
+	ANKI_ASSERT(manager);
+}
+
+PipelinePersistentCache::~PipelinePersistentCache()
+{
+	if(waitPrecreation())
+	{
+		ANKI_LOGE("A pipeline pre-creation thread failed");
+	}
+
+	if(!m_filename.isEmpty() && save())
+	{
+		ANKI_LOGE("Failed to save the pipeline cache");
+	}
+
+	// Delete the records. The objects will call unregisterShader so don't hold the lock while releasing them
+	GrAllocator<U8> alloc = getAllocator();
+
+	for(ShaderRecord* rec : m_shaders)
+	{
+		rec->m_precreated.reset(nullptr);
+		rec->m_source.destroy(alloc);
+		alloc.deleteInstance(rec);
+	}
+
+	for(PipelineRecord* rec : m_pplines)
+	{
+		alloc.deleteInstance(rec);
+	}
+
+	m_shaders.destroy(alloc);
+	m_pplines.destroy(alloc);
+	m_shaderUuids.destroy(alloc);
+	m_toPrecreate.destroy(alloc);
+	m_threads.destroy(alloc);
+	m_filename.destroy(alloc);
+}
+
+GrAllocator<U8> PipelinePersistentCache::getAllocator() const
+{
+	return m_manager->getAllocator();
+}
+
+U64 PipelinePersistentCache::computeStableHash(
+	const PipelineInitInfoState& state, const Array<U64, U(ShaderType::COUNT)>& shaders)
+{
+	U64 h = computeHash(&state, sizeof(state));
+	return appendHash(&shaders[0], sizeof(shaders), h);
+}
+
+Error PipelinePersistentCache::init(CString cacheDir, U threadCount)
+{
+	ANKI_ASSERT(!cacheDir.isEmpty());
+	GrAllocator<U8> alloc = getAllocator();
+
+	StringAuto filename(alloc);
+	filename.sprintf("%s/%s", &cacheDir[0], CACHE_FILENAME);
+	m_filename.create(alloc, filename.toCString());
+
+	ANKI_CHECK(load());
+
+	if(threadCount == 0 || m_pplines.isEmpty())
+	{
+		return ErrorCode::NONE;
+	}
+
+	// Gather the pipelines to pre-create. The records are not deleted before the threads are done
+	U count = 0;
+	for(PipelineRecord* rec : m_pplines)
+	{
+		(void)rec;
+		++count;
+	}
+
+	m_toPrecreate.create(alloc, count);
+	count = 0;
+	for(PipelineRecord* rec : m_pplines)
+	{
+		m_toPrecreate[count++] = rec;
+	}
+
+	threadCount = min<U>(threadCount, count);
+	m_threads.create(alloc, threadCount);
+	for(U i = 0; i < threadCount; ++i)
+	{
+		m_threads[i] = alloc.newInstance<Thread>("PplinePrecreate");
+		m_threads[i]->start(this, precreateThreadCallback);
+	}
+
+	ANKI_LOGI("Pre-creating %u pipelines on %u threads", count, threadCount);
+	return ErrorCode::NONE;
+}
+
+Error PipelinePersistentCache::waitPrecreation()
+{
+	Error err = ErrorCode::NONE;
+	GrAllocator<U8> alloc = getAllocator();
+
+	for(Thread*& thread : m_threads)
+	{
+		if(thread)
+		{
+			Error err2 = thread->join();
+			if(err2)
+			{
+				err = err2;
+			}
+
+			alloc.deleteInstance(thread);
+			thread = nullptr;
+		}
+	}
+
+	return err;
+}
+
+Error PipelinePersistentCache::load()
+{
+	if(!fileExists(m_filename.toCString()))
+	{
+		return ErrorCode::NONE;
+	}
+
+	GrAllocator<U8> alloc = getAllocator();
+	File file;
+	ANKI_CHECK(file.open(m_filename.toCString(), FileOpenFlag::READ | FileOpenFlag::BINARY));
+
+	PipelinePersistentCacheHeader header;
+	ANKI_CHECK(file.read(&header, sizeof(header)));
+
+	if(memcmp(&header.m_magic[0], &CACHE_MAGIC[0], sizeof(CACHE_MAGIC)) != 0
+		|| header.m_stateSize != sizeof(PipelineInitInfoState))
+	{
+		ANKI_LOGW("Ignoring incompatible pipeline cache: %s", &m_filename[0]);
+		return ErrorCode::NONE;
+	}
+
+	LockGuard<Mutex> lock(m_mtx);
+
+	for(U i = 0; i < header.m_shaderCount; ++i)
+	{
+		U64 hash;
+		U32 type;
+		U32 length;
+		ANKI_CHECK(file.read(&hash, sizeof(hash)));
+		ANKI_CHECK(file.read(&type, sizeof(type)));
+		ANKI_CHECK(file.read(&length, sizeof(length)));
+
+		if(type >= U(ShaderType::COUNT) || length == 0 || m_shaders.find(hash) != m_shaders.getEnd())
+		{
+			ANKI_LOGE("Corrupted pipeline cache: %s", &m_filename[0]);
+			return ErrorCode::USER_DATA;
+		}
+
+		ShaderRecord* rec = alloc.newInstance<ShaderRecord>();
+		rec->m_hash = hash;
+		rec->m_type = ShaderType(type);
+		rec->m_source.create(alloc, ' ', length);
+		m_shaders.pushBack(alloc, hash, rec);
+
+		ANKI_CHECK(file.read(&rec->m_source[0], length));
+	}
+
+	for(U i = 0; i < header.m_pipelineCount; ++i)
+	{
+		PipelineRecord* rec = alloc.newInstance<PipelineRecord>();
+		Error err = file.read(&rec->m_state, sizeof(rec->m_state));
+		if(!err)
+		{
+			err = file.read(&rec->m_shaders[0], sizeof(rec->m_shaders));
+		}
+
+		if(!err)
+		{
+			err = file.read(&rec->m_age, sizeof(rec->m_age));
+		}
+
+		const U64 hash = computeStableHash(rec->m_state, rec->m_shaders);
+		if(err || m_pplines.find(hash) != m_pplines.getEnd())
+		{
+			alloc.deleteInstance(rec);
+			ANKI_LOGE("Corrupted pipeline cache: %s", &m_filename[0]);
+			return ErrorCode::USER_DATA;
+		}
+
+		++rec->m_age;
+		rec->m_status = PipelineRecord::Status::PENDING;
+		m_pplines.pushBack(alloc, hash, rec);
+	}
+
+	return ErrorCode::NONE;
+}
+
+Error PipelinePersistentCache::save()
+{
+	File file;
+	ANKI_CHECK(file.open(m_filename.toCString(), FileOpenFlag::WRITE | FileOpenFlag::BINARY));
+
+	LockGuard<Mutex> lock(m_mtx);
+
+	// Count the live records
+	PipelinePersistentCacheHeader header;
+	memcpy(&header.m_magic[0], &CACHE_MAGIC[0], sizeof(CACHE_MAGIC));
+	header.m_stateSize = sizeof(PipelineInitInfoState);
+	header.m_shaderCount = 0;
+	header.m_pipelineCount = 0;
+
+	for(PipelineRecord* rec : m_pplines)
+	{
+		if(rec->m_age <= MAX_PIPELINE_AGE)
+		{
+			++header.m_pipelineCount;
+		}
+	}
+
+	// Write only the shaders that the live pipelines use
+	auto shaderUsed = [&](U64 hash) -> Bool {
+		for(PipelineRecord* rec : m_pplines)
+		{
+			if(rec->m_age <= MAX_PIPELINE_AGE)
+			{
+				for(U64 h : rec->m_shaders)
+				{
+					if(h == hash)
+					{
+						return true;
+					}
+				}
+			}
+		}
+
+		return false;
+	};
+
+	for(const ShaderRecord* rec : m_shaders)
+	{
+		if(shaderUsed(rec->m_hash))
+		{
+			++header.m_shaderCount;
+		}
+	}
+
+	ANKI_CHECK(file.write(&header, sizeof(header)));
+
+	for(const ShaderRecord* it : m_shaders)
+	{
+		const ShaderRecord& rec = *it;
+		U64 hash = rec.m_hash;
+		if(!shaderUsed(hash))
+		{
+			continue;
+		}
+
+		U32 type = U32(rec.m_type);
+		U32 length = rec.m_source.getLength();
+		ANKI_CHECK(file.write(&hash, sizeof(hash)));
+		ANKI_CHECK(file.write(&type, sizeof(type)));
+		ANKI_CHECK(file.write(&length, sizeof(length)));
+		ANKI_CHECK(file.write(const_cast<char*>(&rec.m_source[0]), length));
+	}
+
+	for(PipelineRecord* rec : m_pplines)
+	{
+		if(rec->m_age <= MAX_PIPELINE_AGE)
+		{
+			ANKI_CHECK(file.write(&rec->m_state, sizeof(rec->m_state)));
+			ANKI_CHECK(file.write(&rec->m_shaders[0], sizeof(rec->m_shaders)));
+			ANKI_CHECK(file.write(&rec->m_age, sizeof(rec->m_age)));
+		}
+	}
+
+	return ErrorCode::NONE;
+}
+
+void PipelinePersistentCache::registerShader(const Shader& shader, ShaderType type, CString source)
+{
+	ANKI_ASSERT(!source.isEmpty());
+	GrAllocator<U8> alloc = getAllocator();
+
+	U64 hash = computeHash(&source[0], source.getLength());
+	U32 type32 = U32(type);
+	hash = appendHash(&type32, sizeof(type32), hash);
+
+	LockGuard<Mutex> lock(m_mtx);
+
+	if(m_shaders.find(hash) == m_shaders.getEnd())
+	{
+		ShaderRecord* rec = alloc.newInstance<ShaderRecord>();
+		rec->m_hash = hash;
+		rec->m_type = type;
+		rec->m_source.create(alloc, source);
+		m_shaders.pushBack(alloc, hash, rec);
+	}
+
+	ANKI_ASSERT(m_shaderUuids.find(shader.getUuid()) == m_shaderUuids.getEnd());
+	m_shaderUuids.pushBack(alloc, shader.getUuid(), hash);
+}
+
+void PipelinePersistentCache::unregisterShader(const Shader& shader)
+{
+	LockGuard<Mutex> lock(m_mtx);
+
+	auto it = m_shaderUuids.find(shader.getUuid());
+	if(it != m_shaderUuids.getEnd())
+	{
+		m_shaderUuids.erase(getAllocator(), it);
+	}
+}
+
+Bool PipelinePersistentCache::tryGet(const PipelineInitInfo& init, PipelinePtr& ppline)
+{
+	Bool hit = false;
+
+	{
+		LockGuard<Mutex> lock(m_mtx);
+
+		Array<U64, U(ShaderType::COUNT)> shaders;
+		Bool known = true;
+		for(U i = 0; i < U(ShaderType::COUNT); ++i)
+		{
+			shaders[i] = 0;
+			if(init.m_shaders[i].isCreated())
+			{
+				auto it = m_shaderUuids.find(init.m_shaders[i]->getUuid());
+				if(it == m_shaderUuids.getEnd())
+				{
+					known = false;
+					break;
+				}
+
+				shaders[i] = *it;
+			}
+		}
+
+		if(known)
+		{
+			const U64 hash = computeStableHash(init, shaders);
+			auto it = m_pplines.find(hash);
+			if(it == m_pplines.getEnd())
+			{
+				PipelineRecord* rec = getAllocator().newInstance<PipelineRecord>();
+				rec->m_state = init;
+				rec->m_shaders = shaders;
+				m_pplines.pushBack(getAllocator(), hash, rec);
+				++m_stats.m_recorded;
+			}
+			else
+			{
+				PipelineRecord& rec = **it;
+				if(rec.m_status == PipelineRecord::Status::PRECREATED)
+				{
+					ppline = rec.m_precreated;
+					rec.m_precreated.reset(nullptr);
+					hit = true;
+				}
+
+				if(rec.m_status != PipelineRecord::Status::USED)
+				{
+					rec.m_status = PipelineRecord::Status::USED;
+					rec.m_age = 0;
+					++m_stats.m_recorded;
+				}
+			}
+		}
+
+		if(hit)
+		{
+			++m_stats.m_hits;
+		}
+		else
+		{
+			++m_stats.m_misses;
+		}
+	}
+
+	if(hit)
+	{
+		ANKI_TRACE_INC_COUNTER(GR_PIPELINE_CACHE_HITS, 1);
+	}
+	else
+	{
+		ANKI_TRACE_INC_COUNTER(GR_PIPELINE_CACHE_MISSES, 1);
+	}
+
+	return hit;
+}
+
+void PipelinePersistentCache::getStats(PipelinePersistentCacheStats& stats) const
+{
+	LockGuard<Mutex> lock(m_mtx);
+	stats = m_stats;
+}
+
+Error PipelinePersistentCache::precreateThreadCallback(ThreadCallbackInfo& info)
+{
+	PipelinePersistentCache& self = *static_cast<PipelinePersistentCache*>(info.m_userData);
+
+	while(1)
+	{
+		const U32 idx = self.m_nextToPrecreate.fetchAdd(1);
+		if(idx >= self.m_toPrecreate.getSize())
+		{
+			break;
+		}
+
+		self.precreate(*self.m_toPrecreate[idx]);
+	}
+
+	return ErrorCode::NONE;
+}
+
+ShaderPtr PipelinePersistentCache::getOrCreateShader(ShaderRecord& rec)
+{
+	{
+		LockGuard<Mutex> lock(m_mtx);
+		if(rec.m_precreated.isCreated())
+		{
+			return rec.m_precreated;
+		}
+	}
+
+	// Create it without holding the lock because Shader::init will call registerShader. The source is immutable so no
+	// need to lock
+	ShaderPtr shader = m_manager->newInstance<Shader>(rec.m_type, rec.m_source.toCString());
+
+	LockGuard<Mutex> lock(m_mtx);
+	if(!rec.m_precreated.isCreated())
+	{
+		rec.m_precreated = shader;
+	}
+
+	// Another thread may have created it as well. Keep the first
+	return rec.m_precreated;
+}
+
+void PipelinePersistentCache::precreate(PipelineRecord& rec)
+{
+	PipelineInitInfo init;
+	Array<ShaderRecord*, U(ShaderType::COUNT)> shaders = {};
+
+	{
+		LockGuard<Mutex> lock(m_mtx);
+
+		// Used in the meantime, the user created it already
+		if(rec.m_status != PipelineRecord::Status::PENDING)
+		{
+			return;
+		}
+
+		static_cast<PipelineInitInfoState&>(init) = rec.m_state;
+
+		for(U i = 0; i < U(ShaderType::COUNT); ++i)
+		{
+			if(rec.m_shaders[i])
+			{
+				auto it = m_shaders.find(rec.m_shaders[i]);
+				if(it == m_shaders.getEnd())
+				{
+					ANKI_LOGW("Missing shader source for a cached pipeline");
+					return;
+				}
+
+				shaders[i] = *it;
+			}
+		}
+	}
+
+	for(U i = 0; i < U(ShaderType::COUNT); ++i)
+	{
+		if(shaders[i])
+		{
+			init.m_shaders[i] = getOrCreateShader(*shaders[i]);
+		}
+	}
+
+	PipelinePtr ppline = m_manager->newInstance<Pipeline>(init);
+
+	LockGuard<Mutex> lock(m_mtx);
+	if(rec.m_status == PipelineRecord::Status::PENDING)
+	{
+		rec.m_precreated = ppline;
+		rec.m_status = PipelineRecord::Status::PRECREATED;
+		++m_stats.m_precreated;
+	}
+}
+
+} // end namespace anki
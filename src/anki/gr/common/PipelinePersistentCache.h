@@ -0,0 +1,108 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/Pipeline.h>
+#include <anki/gr/Shader.h>
+#include <anki/util/HashMap.h>
+#include <anki/util/DynamicArray.h>
+#include <anki/util/Thread.h>
+
+namespace anki
+{
+
+// Forward
+class PipelinePersistentCacheShader;
+class PipelinePersistentCachePipeline;
+
+/// @addtogroup graphics
+/// @{
+
+class PipelinePersistentCacheStats
+{
+public:
+	U32 m_hits = 0; ///< Pipelines that were found pre-created.
+	U32 m_misses = 0;
+	U32 m_precreated = 0; ///< Pipelines that the threads created.
+	U32 m_recorded = 0; ///< Pipelines seen in this run.
+};
+
+/// Remembers the pipelines of a run and pre-creates them on some threads at the beginning of the next run. Pipelines are
+/// identified by their state and the sources of their shaders since the shader UUIDs change from run to run.
+class PipelinePersistentCache : public NonCopyable
+{
+public:
+	PipelinePersistentCache(GrManager* manager);
+
+	/// Waits for the threads and saves the cache.
+	~PipelinePersistentCache();
+
+	/// Load the cache of the previous runs and start pre-creating the pipelines.
+	/// @param threadCount The number of threads that will pre-create. If zero nothing will be pre-created.
+	ANKI_USE_RESULT Error init(CString cacheDir, U threadCount);
+
+	/// Write all the pipelines seen so far to the disk.
+	ANKI_USE_RESULT Error save();
+
+	/// Wait for the pre-creation threads to finish.
+	ANKI_USE_RESULT Error waitPrecreation();
+
+	/// Record a pipeline and get it if it's pre-created. It's thread-safe.
+	/// @return True if it was pre-created.
+	Bool tryGet(const PipelineInitInfo& init, PipelinePtr& ppline);
+
+	void getStats(PipelinePersistentCacheStats& stats) const;
+
+anki_internal:
+	GrAllocator<U8> getAllocator() const;
+
+	/// Called by Shader::init to associate the shader with its source.
+	void registerShader(const Shader& shader, ShaderType type, CString source);
+
+	/// Called when a shader is destroyed.
+	void unregisterShader(const Shader& shader);
+
+private:
+	using ShaderRecord = PipelinePersistentCacheShader;
+	using PipelineRecord = PipelinePersistentCachePipeline;
+
+	/// The hashes are already there.
+	class Hasher
+	{
+	public:
+		U64 operator()(U64 hash) const
+		{
+			return hash;
+		}
+	};
+
+	GrManager* m_manager;
+	String m_filename;
+
+	HashMap<U64, ShaderRecord*, Hasher> m_shaders; ///< Source hash to shader.
+	HashMap<U64, PipelineRecord*, Hasher> m_pplines; ///< Stable hash to pipeline.
+	HashMap<U64, U64, Hasher> m_shaderUuids; ///< Shader UUID to source hash.
+
+	DynamicArray<PipelineRecord*> m_toPrecreate;
+	Atomic<U32> m_nextToPrecreate = {0};
+	DynamicArray<Thread*> m_threads;
+
+	PipelinePersistentCacheStats m_stats;
+	mutable Mutex m_mtx;
+
+	ANKI_USE_RESULT Error load();
+
+	static ANKI_USE_RESULT Error precreateThreadCallback(ThreadCallbackInfo& info);
+
+	void precreate(PipelineRecord& rec);
+
+	ShaderPtr getOrCreateShader(ShaderRecord& rec);
+
+	static U64 computeStableHash(const PipelineInitInfoState& state, const Array<U64, U(ShaderType::COUNT)>& shaders);
+};
+/// @}
+
+} // end namespace anki
@@ -0,0 +1,344 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/common/TlsfGpuAllocator.h>
+
+namespace anki
+{
+
+/// A free or used range of the memory.
+class TlsfGpuAllocatorBlock
+{
+public:
+	PtrSize m_offset = 0;
+	PtrSize m_size = 0;
+
+	/// The neighbours in memory.
+	TlsfGpuAllocatorBlock* m_prevPhysical = nullptr;
+	TlsfGpuAllocatorBlock* m_nextPhysical = nullptr;
+
+	/// The neighbours in the free list.
+	TlsfGpuAllocatorBlock* m_prevFree = nullptr;
+	TlsfGpuAllocatorBlock* m_nextFree = nullptr;
+
+	Bool8 m_free = false;
+};
+
+/// Index of the most significant bit.
+static U32 getMsb(U64 x)
+{
+	ANKI_ASSERT(x);
+#if defined(__GNUC__)
+	return 63 - __builtin_clzll(x);
+#else
+#error "Unimplemented"
+#endif
+}
+
+/// Index of the least significant bit.
+static U32 getLsb(U32 x)
+{
+	ANKI_ASSERT(x);
+#if defined(__GNUC__)
+	return __builtin_ctz(x);
+#else
+#error "Unimplemented"
+#endif
+}
+
+TlsfGpuAllocator::~TlsfGpuAllocator()
+{
+	if(m_allocationCount > 0)
+	{
+		ANKI_LOGW("Forgot to free memory");
+	}
+
+	Block* block = m_first;
+	while(block)
+	{
+		Block* next = block->m_nextPhysical;
+		m_alloc.deleteInstance(block);
+		block = next;
+	}
+}
+
+void TlsfGpuAllocator::init(GenericMemoryPoolAllocator<U8> alloc, PtrSize size)
+{
+	ANKI_ASSERT(m_size == 0);
+	ANKI_ASSERT(size >= GRANULARITY && size <= PtrSize(MAX_U32) + 1);
+
+	m_alloc = alloc;
+	m_size = getAlignedRoundDown(GRANULARITY, size);
+
+	m_flBitmap = 0;
+	for(U32 fl = 0; fl < FL_COUNT; ++fl)
+	{
+		m_slBitmaps[fl] = 0;
+		for(U32 sl = 0; sl < SL_COUNT; ++sl)
+		{
+			m_freeLists[fl][sl] = nullptr;
+		}
+	}
+
+	m_first = m_alloc.newInstance<Block>();
+	m_first->m_size = m_size;
+	m_first->m_free = true;
+	insertFreeBlock(m_first);
+}
+
+inline void TlsfGpuAllocator::mapping(PtrSize size, U32& fl, U32& sl)
+{
+	// The first level is the power of two of the size and the second level splits it linearly. The small sizes have
+	// a list for every size
+	const PtrSize units = size / GRANULARITY;
+	if(units < SL_COUNT)
+	{
+		fl = 0;
+		sl = U32(units);
+	}
+	else
+	{
+		const U32 msb = getMsb(units);
+		fl = msb - SL_BITS + 1;
+		sl = U32(units >> (msb - SL_BITS)) - SL_COUNT;
+	}
+
+	ANKI_ASSERT(fl < FL_COUNT && sl < SL_COUNT);
+
+	// The compiler can't prove from the assertion that the lists are in bounds and -Warray-bounds complains
+	fl = min(fl, FL_COUNT - 1);
+	sl = min(sl, SL_COUNT - 1);
+}
+
+void TlsfGpuAllocator::insertFreeBlock(Block* block)
+{
+	ANKI_ASSERT(block->m_free);
+	U32 fl, sl;
+	mapping(block->m_size, fl, sl);
+
+	Block*& head = m_freeLists[fl][sl];
+	block->m_prevFree = nullptr;
+	block->m_nextFree = head;
+	if(head)
+	{
+		head->m_prevFree = block;
+	}
+	head = block;
+
+	m_flBitmap |= 1u << fl;
+	m_slBitmaps[fl] |= 1u << sl;
+}
+
+void TlsfGpuAllocator::removeFreeBlock(Block* block)
+{
+	ANKI_ASSERT(block->m_free);
+	U32 fl, sl;
+	mapping(block->m_size, fl, sl);
+
+	if(block->m_prevFree)
+	{
+		block->m_prevFree->m_nextFree = block->m_nextFree;
+	}
+	else
+	{
+		ANKI_ASSERT(m_freeLists[fl][sl] == block);
+		m_freeLists[fl][sl] = block->m_nextFree;
+	}
+
+	if(block->m_nextFree)
+	{
+		block->m_nextFree->m_prevFree = block->m_prevFree;
+	}
+
+	block->m_prevFree = block->m_nextFree = nullptr;
+
+	if(m_freeLists[fl][sl] == nullptr)
+	{
+		m_slBitmaps[fl] &= ~(1u << sl);
+		if(m_slBitmaps[fl] == 0)
+		{
+			m_flBitmap &= ~(1u << fl);
+		}
+	}
+}
+
+TlsfGpuAllocatorBlock* TlsfGpuAllocator::findFreeBlock(PtrSize size) const
+{
+	// Round the size up to the next list so every block of that list and the ones after it fit
+	PtrSize rounded = size;
+	const PtrSize units = size / GRANULARITY;
+	if(units >= SL_COUNT)
+	{
+		rounded += (PtrSize(GRANULARITY) << (getMsb(units) - SL_BITS)) - 1;
+	}
+
+	U32 fl, sl;
+	mapping(rounded, fl, sl);
+
+	U32 slBitmap = m_slBitmaps[fl] & (MAX_U32 << sl);
+	if(slBitmap == 0 && fl + 1 < FL_COUNT)
+	{
+		const U32 flBitmap = m_flBitmap & (MAX_U32 << (fl + 1));
+		if(flBitmap)
+		{
+			fl = getLsb(flBitmap);
+			slBitmap = m_slBitmaps[fl];
+		}
+	}
+
+	if(slBitmap)
+	{
+		return m_freeLists[fl][getLsb(slBitmap)];
+	}
+
+	// The list of the size might have a large enough block. That matters when the memory is almost full
+	mapping(size, fl, sl);
+	for(Block* block = m_freeLists[fl][sl]; block; block = block->m_nextFree)
+	{
+		if(block->m_size >= size)
+		{
+			return block;
+		}
+	}
+
+	return nullptr;
+}
+
+TlsfGpuAllocatorBlock* TlsfGpuAllocator::splitBlock(Block* block, PtrSize size)
+{
+	ANKI_ASSERT(size > 0 && size < block->m_size);
+	ANKI_ASSERT(isAligned(GRANULARITY, size));
+
+	Block* second = m_alloc.newInstance<Block>();
+	second->m_offset = block->m_offset + size;
+	second->m_size = block->m_size - size;
+	second->m_prevPhysical = block;
+	second->m_nextPhysical = block->m_nextPhysical;
+	if(second->m_nextPhysical)
+	{
+		second->m_nextPhysical->m_prevPhysical = second;
+	}
+
+	block->m_size = size;
+	block->m_nextPhysical = second;
+
+	return second;
+}
+
+void TlsfGpuAllocator::mergeWithNext(Block* block)
+{
+	Block* next = block->m_nextPhysical;
+	ANKI_ASSERT(next && !next->m_prevFree && !next->m_nextFree);
+
+	block->m_size += next->m_size;
+	block->m_nextPhysical = next->m_nextPhysical;
+	if(block->m_nextPhysical)
+	{
+		block->m_nextPhysical->m_prevPhysical = block;
+	}
+
+	m_alloc.deleteInstance(next);
+}
+
+Error TlsfGpuAllocator::allocate(PtrSize size, U32 alignment, TlsfGpuAllocatorHandle& handle)
+{
+	ANKI_ASSERT(m_size > 0);
+	ANKI_ASSERT(size > 0);
+	ANKI_ASSERT(alignment > 0 && isAligned(GRANULARITY, alignment));
+	ANKI_ASSERT(!handle);
+
+	// Search for a block that fits the worst case of the alignment padding
+	size = getAlignedRoundUp(GRANULARITY, size);
+	const PtrSize searchSize = size + alignment - GRANULARITY;
+	if(searchSize > m_size)
+	{
+		return ErrorCode::OUT_OF_MEMORY;
+	}
+
+	Block* block = findFreeBlock(searchSize);
+	if(!block)
+	{
+		return ErrorCode::OUT_OF_MEMORY;
+	}
+
+	removeFreeBlock(block);
+
+	// The padding becomes a free block. Its previous block is used because the free blocks are always merged
+	const PtrSize padding = getAlignedRoundUp(alignment, block->m_offset) - block->m_offset;
+	if(padding > 0)
+	{
+		Block* aligned = splitBlock(block, padding);
+		insertFreeBlock(block);
+		block = aligned;
+	}
+
+	// Same for the rest of the block
+	if(block->m_size > size)
+	{
+		Block* rest = splitBlock(block, size);
+		rest->m_free = true;
+		insertFreeBlock(rest);
+	}
+
+	block->m_free = false;
+	++m_allocationCount;
+
+	handle.m_block = block;
+	handle.m_offset = block->m_offset;
+	return ErrorCode::NONE;
+}
+
+void TlsfGpuAllocator::free(TlsfGpuAllocatorHandle& handle)
+{
+	Block* block = handle.m_block;
+	ANKI_ASSERT(block && !block->m_free);
+	ANKI_ASSERT(m_allocationCount > 0);
+
+	block->m_free = true;
+	--m_allocationCount;
+
+	Block* next = block->m_nextPhysical;
+	if(next && next->m_free)
+	{
+		removeFreeBlock(next);
+		mergeWithNext(block);
+	}
+
+	Block* prev = block->m_prevPhysical;
+	if(prev && prev->m_free)
+	{
+		removeFreeBlock(prev);
+		mergeWithNext(prev);
+		block = prev;
+	}
+
+	insertFreeBlock(block);
+	handle = TlsfGpuAllocatorHandle();
+}
+
+void TlsfGpuAllocator::getStats(TlsfGpuAllocatorStats& stats) const
+{
+	stats.m_usedSize = 0;
+	stats.m_freeSize = 0;
+	stats.m_largestFreeSize = 0;
+	stats.m_allocationCount = m_allocationCount;
+	stats.m_freeBlockCount = 0;
+
+	for(const Block* block = m_first; block; block = block->m_nextPhysical)
+	{
+		if(block->m_free)
+		{
+			stats.m_freeSize += block->m_size;
+			stats.m_largestFreeSize = max(stats.m_largestFreeSize, block->m_size);
+			++stats.m_freeBlockCount;
+		}
+		else
+		{
+			stats.m_usedSize += block->m_size;
+		}
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,116 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/Common.h>
+
+namespace anki
+{
+
+// Forward
+class TlsfGpuAllocatorBlock;
+
+/// @addtogroup graphics
+/// @{
+
+/// The output of an allocation.
+class TlsfGpuAllocatorHandle
+{
+	friend class TlsfGpuAllocator;
+
+public:
+	PtrSize m_offset = 0;
+
+	operator Bool() const
+	{
+		return m_block != nullptr;
+	}
+
+private:
+	TlsfGpuAllocatorBlock* m_block = nullptr;
+};
+
+class TlsfGpuAllocatorStats
+{
+public:
+	PtrSize m_usedSize; ///< The memory of the allocations including the alignment padding.
+	PtrSize m_freeSize;
+	PtrSize m_largestFreeSize; ///< The largest allocation that can succeed if there is no alignment.
+	U32 m_allocationCount;
+	U32 m_freeBlockCount; ///< Many free blocks for the same free size means fragmentation.
+};
+
+/// Sub-allocates a range of GPU memory with the two level segregated fit algorithm. It only does the bookkeeping, the
+/// memory is owned by someone else. Allocations and frees are constant time and the free neighbours get merged. It's
+/// not thread-safe.
+class TlsfGpuAllocator : public NonCopyable
+{
+public:
+	/// All the sizes are rounded up to that and the alignments should be multiple of it.
+	static const U32 GRANULARITY = 4;
+
+	TlsfGpuAllocator()
+	{
+	}
+
+	~TlsfGpuAllocator();
+
+	/// @param alloc The allocator of the bookkeeping.
+	/// @param size The size of the memory. Up to 4GB.
+	void init(GenericMemoryPoolAllocator<U8> alloc, PtrSize size);
+
+	/// Allocate memory.
+	/// @param size The size of the allocation.
+	/// @param alignment The alignment of the offset. It doesn't have to be a power of two (eg a vertex stride).
+	/// @param[out] handle The allocation.
+	/// @return ErrorCode::OUT_OF_MEMORY if there is no free block that is large enough.
+	ANKI_USE_RESULT Error allocate(PtrSize size, U32 alignment, TlsfGpuAllocatorHandle& handle);
+
+	/// Free allocated memory. It invalidates the handle.
+	void free(TlsfGpuAllocatorHandle& handle);
+
+	void getStats(TlsfGpuAllocatorStats& stats) const;
+
+	PtrSize getSize() const
+	{
+		return m_size;
+	}
+
+private:
+	using Block = TlsfGpuAllocatorBlock;
+
+	static const U32 SL_BITS = 4;
+	static const U32 SL_COUNT = 1 << SL_BITS;
+	static const U32 FL_COUNT = 32;
+
+	GenericMemoryPoolAllocator<U8> m_alloc;
+	PtrSize m_size = 0;
+	Block* m_first = nullptr; ///< The block with offset 0. The rest are linked to it.
+
+	U32 m_flBitmap = 0; ///< A bit for every first level with a free block.
+	Array<U32, FL_COUNT> m_slBitmaps; ///< A bit for every second level list with a free block.
+	Array2d<Block*, FL_COUNT, SL_COUNT> m_freeLists;
+
+	U32 m_allocationCount = 0;
+
+	static void mapping(PtrSize size, U32& fl, U32& sl);
+
+	void insertFreeBlock(Block* block);
+
+	void removeFreeBlock(Block* block);
+
+	/// Find a free block that fits the size. It doesn't remove it from the free lists.
+	Block* findFreeBlock(PtrSize size) const;
+
+	/// Break the block in two and return the second part. The second part is not in the free lists.
+	Block* splitBlock(Block* block, PtrSize size);
+
+	/// Merge a block with the next one and delete the next one.
+	void mergeWithNext(Block* block);
+};
+/// @}
+
+} // end namespace anki
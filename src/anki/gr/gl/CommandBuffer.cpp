@@ -81,134 +81,26 @@ void CommandBuffer::finish()
 
 void CommandBuffer::setViewport(U16 minx, U16 miny, U16 maxx, U16 maxy)
 {
-	class ViewportCommand final : public GlCommand
-	{
-	public:
-		Array<U16, 4> m_value;
-
-		ViewportCommand(U16 a, U16 b, U16 c, U16 d)
-		{
-			m_value = {{a, b, c, d}};
-		}
-
-		Error operator()(GlState& state)
-		{
-			if(state.m_viewport[0] != m_value[0] || state.m_viewport[1] != m_value[1]
-				|| state.m_viewport[2] != m_value[2]
-				|| state.m_viewport[3] != m_value[3])
-			{
-				glViewport(m_value[0], m_value[1], m_value[2], m_value[3]);
-
-				state.m_viewport = m_value;
-			}
-
-			return ErrorCode::NONE;
-		}
-	};
-
-#if ANKI_ASSERTS_ENABLED
-	m_impl->m_dbg.m_viewport = true;
-#endif
-	m_impl->pushBackNewCommand<ViewportCommand>(minx, miny, maxx, maxy);
+	m_impl->setViewport(minx, miny, maxx, maxy);
 }
 
 void CommandBuffer::setPolygonOffset(F32 factor, F32 units)
 {
-	class SetPolygonOffsetCommand final : public GlCommand
-	{
-	public:
-		F32 m_factor;
-		F32 m_units;
-
-		SetPolygonOffsetCommand(F32 factor, F32 units)
-			: m_factor(factor)
-			, m_units(units)
-		{
-		}
-
-		Error operator()(GlState& state)
-		{
-			if(m_factor == 0.0 && m_units == 0.0)
-			{
-				glDisable(GL_POLYGON_OFFSET_FILL);
-			}
-			else
-			{
-				glEnable(GL_POLYGON_OFFSET_FILL);
-				glPolygonOffset(m_factor, m_units);
-			}
-
-			return ErrorCode::NONE;
-		}
-	};
-
-#if ANKI_ASSERTS_ENABLED
-	m_impl->m_dbg.m_polygonOffset = true;
-#endif
-	m_impl->pushBackNewCommand<SetPolygonOffsetCommand>(factor, units);
+	m_impl->setPolygonOffset(factor, units);
 }
 
 void CommandBuffer::bindPipeline(PipelinePtr ppline)
 {
-	class BindPipelineCommand final : public GlCommand
-	{
-	public:
-		PipelinePtr m_ppline;
-
-		BindPipelineCommand(PipelinePtr& ppline)
-			: m_ppline(ppline)
-		{
-		}
-
-		Error operator()(GlState& state)
-		{
-			if(state.m_lastPplineBoundUuid != m_ppline->getUuid())
-			{
-				ANKI_TRACE_START_EVENT(GL_BIND_PPLINE);
-
-				PipelineImpl& impl = *m_ppline->m_impl;
-				impl.bind(state);
-				state.m_lastPplineBoundUuid = m_ppline->getUuid();
-				ANKI_TRACE_INC_COUNTER(GR_PIPELINE_BINDS_HAPPENED, 1);
-
-				ANKI_TRACE_STOP_EVENT(GL_BIND_PPLINE);
-			}
-			else
-			{
-				ANKI_TRACE_INC_COUNTER(GR_PIPELINE_BINDS_SKIPPED, 1);
-			}
-
-			return ErrorCode::NONE;
-		}
-	};
-
-	m_impl->pushBackNewCommand<BindPipelineCommand>(ppline);
+	m_impl->bindPipeline(ppline);
 }
 
 void CommandBuffer::beginRenderPass(FramebufferPtr fb)
 {
-	class BindFramebufferCommand final : public GlCommand
-	{
-	public:
-		FramebufferPtr m_fb;
-
-		BindFramebufferCommand(FramebufferPtr fb)
-			: m_fb(fb)
-		{
-		}
-
-		Error operator()(GlState& state)
-		{
-			m_fb->m_impl->bind(state);
-			return ErrorCode::NONE;
-		}
-	};
-
 	ANKI_ASSERT(!m_impl->m_dbg.m_insideRenderPass);
 #if ANKI_ASSERTS_ENABLED
 	m_impl->m_dbg.m_insideRenderPass = true;
 #endif
-	m_impl->pushBackNewCommand<BindFramebufferCommand>(fb);
+	m_impl->beginRenderPass(fb);
 }
 
 void CommandBuffer::endRenderPass()
@@ -511,23 +403,6 @@ void CommandBuffer::copyTextureSurfaceToTextureSurface(
 void CommandBuffer::setBufferBarrier(
 	BufferPtr buff, BufferUsageBit prevUsage, BufferUsageBit nextUsage, PtrSize offset, PtrSize size)
 {
-	class SetBufferMemBarrierCommand final : public GlCommand
-	{
-	public:
-		GLenum m_barrier;
-
-		SetBufferMemBarrierCommand(GLenum barrier)
-			: m_barrier(barrier)
-		{
-		}
-
-		Error operator()(GlState&)
-		{
-			glMemoryBarrier(m_barrier);
-			return ErrorCode::NONE;
-		}
-	};
-
 	GLenum d = GL_NONE;
 	BufferUsageBit all = prevUsage | nextUsage;
 
@@ -568,7 +443,7 @@ void CommandBuffer::setBufferBarrier(
 	}
 
 	ANKI_ASSERT(d);
-	m_impl->pushBackNewCommand<SetBufferMemBarrierCommand>(d);
+	m_impl->setMemoryBarrier(d);
 }
 
 void CommandBuffer::setTextureSurfaceBarrier(
@@ -676,107 +551,17 @@ void CommandBuffer::writeOcclusionQueryResultToBuffer(OcclusionQueryPtr query, P
 
 void CommandBuffer::setStencilCompareMask(FaceSelectionMask face, U32 mask)
 {
-	class SetStencilCompareMask final : public GlCommand
-	{
-	public:
-		FaceSelectionMask m_face;
-		U32 m_mask;
-
-		SetStencilCompareMask(FaceSelectionMask face, U32 mask)
-			: m_face(face)
-			, m_mask(mask)
-		{
-		}
-
-		Error operator()(GlState& state)
-		{
-			if(!!(m_face & FaceSelectionMask::FRONT) && state.m_stencilCompareMask[0] != m_mask)
-			{
-				state.m_stencilCompareMask[0] = m_mask;
-				state.m_glStencilFuncSeparateDirtyMask |= 1 << 0;
-			}
-
-			if(!!(m_face & FaceSelectionMask::BACK) && state.m_stencilCompareMask[1] != m_mask)
-			{
-				state.m_stencilCompareMask[1] = m_mask;
-				state.m_glStencilFuncSeparateDirtyMask |= 1 << 1;
-			}
-
-			return ErrorCode::NONE;
-		}
-	};
-
-	m_impl->pushBackNewCommand<SetStencilCompareMask>(face, mask);
+	m_impl->setStencilCompareMask(face, mask);
 }
 
 void CommandBuffer::setStencilWriteMask(FaceSelectionMask face, U32 mask)
 {
-	class SetStencilWriteMask final : public GlCommand
-	{
-	public:
-		FaceSelectionMask m_face;
-		U32 m_mask;
-
-		SetStencilWriteMask(FaceSelectionMask face, U32 mask)
-			: m_face(face)
-			, m_mask(mask)
-		{
-		}
-
-		Error operator()(GlState& state)
-		{
-			if(!!(m_face & FaceSelectionMask::FRONT) && state.m_stencilWriteMask[0] != m_mask)
-			{
-				glStencilMaskSeparate(GL_FRONT, m_mask);
-				state.m_stencilWriteMask[0] = m_mask;
-			}
-
-			if(!!(m_face & FaceSelectionMask::BACK) && state.m_stencilWriteMask[1] != m_mask)
-			{
-				glStencilMaskSeparate(GL_BACK, m_mask);
-				state.m_stencilWriteMask[1] = m_mask;
-			}
-
-			return ErrorCode::NONE;
-		}
-	};
-
-	m_impl->pushBackNewCommand<SetStencilWriteMask>(face, mask);
+	m_impl->setStencilWriteMask(face, mask);
 }
 
 void CommandBuffer::setStencilReference(FaceSelectionMask face, U32 ref)
 {
-	class SetStencilRefMask final : public GlCommand
-	{
-	public:
-		FaceSelectionMask m_face;
-		U32 m_ref;
-
-		SetStencilRefMask(FaceSelectionMask face, U32 ref)
-			: m_face(face)
-			, m_ref(ref)
-		{
-		}
-
-		Error operator()(GlState& state)
-		{
-			if(!!(m_face & FaceSelectionMask::FRONT) && state.m_stencilRef[0] != m_ref)
-			{
-				state.m_stencilRef[0] = m_ref;
-				state.m_glStencilFuncSeparateDirtyMask |= 1 << 0;
-			}
-
-			if(!!(m_face & FaceSelectionMask::BACK) && state.m_stencilRef[1] != m_ref)
-			{
-				state.m_stencilRef[1] = m_ref;
-				state.m_glStencilFuncSeparateDirtyMask |= 1 << 1;
-			}
-
-			return ErrorCode::NONE;
-		}
-	};
-
-	m_impl->pushBackNewCommand<SetStencilRefMask>(face, ref);
+	m_impl->setStencilReference(face, ref);
 }
 
 } // end namespace anki
@@ -9,9 +9,15 @@
 #include <anki/gr/gl/GlState.h>
 #include <anki/gr/gl/Error.h>
 
+#include <anki/gr/Pipeline.h>
+#include <anki/gr/gl/PipelineImpl.h>
+#include <anki/gr/ResourceGroup.h>
 #include <anki/gr/gl/ResourceGroupImpl.h>
+#include <anki/gr/Framebuffer.h>
+#include <anki/gr/gl/FramebufferImpl.h>
 #include <anki/gr/OcclusionQuery.h>
 #include <anki/gr/gl/OcclusionQueryImpl.h>
+#include <anki/gr/Buffer.h>
 #include <anki/gr/gl/BufferImpl.h>
 
 #include <anki/util/Logger.h>
@@ -21,11 +27,106 @@
 namespace anki
 {
 
+/// @name Packets
+/// @{
+
+class ViewportPacket
+{
+public:
+	Array<U16, 4> m_value;
+};
+
+class PolygonOffsetPacket
+{
+public:
+	F32 m_factor;
+	F32 m_units;
+};
+
+class StencilPacket
+{
+public:
+	FaceSelectionMask m_face;
+	U32 m_value;
+};
+
+class ObjectPacket
+{
+public:
+	U32 m_objectIdx;
+};
+
+class BindResourcesPacket
+{
+public:
+	U32 m_objectIdx;
+	U8 m_slot;
+	Bool8 m_hasInfo; ///< If true a TransientMemoryInfo follows the packet.
+};
+
+class DrawElementsPacket
+{
+public:
+	DrawElementsIndirectInfo m_info;
+};
+
+class DrawArraysPacket
+{
+public:
+	DrawArraysIndirectInfo m_info;
+};
+
+class DrawIndirectPacket
+{
+public:
+	PtrSize m_offset;
+	U32 m_drawCount;
+	U32 m_objectIdx;
+};
+
+class DispatchPacket
+{
+public:
+	Array<U32, 3> m_size;
+};
+
+class MemoryBarrierPacket
+{
+public:
+	GLenum m_barrier;
+};
+/// @}
+
+template<typename TPacket>
+static const TPacket& getPacket(const GlCommandHeader& header)
+{
+	return *reinterpret_cast<const TPacket*>(reinterpret_cast<const U8*>(&header) + GL_COMMAND_HEADER_SIZE);
+}
+
+static GLenum getIndexType(U indexSize)
+{
+	GLenum indicesType = 0;
+	switch(indexSize)
+	{
+	case 2:
+		indicesType = GL_UNSIGNED_SHORT;
+		break;
+	case 4:
+		indicesType = GL_UNSIGNED_INT;
+		break;
+	default:
+		ANKI_ASSERT(0);
+		break;
+	};
+
+	return indicesType;
+}
+
 void CommandBufferImpl::init(const CommandBufferInitInfo& init)
 {
 	auto& pool = m_manager->getAllocator().getMemoryPool();
 
-	m_alloc = CommandBufferAllocator<GlCommand*>(
+	m_alloc = CommandBufferAllocator<U8>(
 		pool.getAllocationCallback(), pool.getAllocationCallbackUserData(), init.m_hints.m_chunkSize, 1.0, 0, false);
 
 	m_flags = init.m_flags;
@@ -36,21 +137,53 @@ void CommandBufferImpl::destroy()
 	ANKI_TRACE_START_EVENT(GL_CMD_BUFFER_DESTROY);
 
 #if ANKI_DEBUG
-	if(!m_executed && m_firstCommand)
+	if(!m_executed && m_commandCount)
 	{
 		ANKI_LOGW("Chain contains commands but never executed. "
 				  "This should only happen on exceptions");
 	}
 #endif
 
-	GlCommand* command = m_firstCommand;
-	while(command != nullptr)
+	// Call the destructors of the custom commands and free the chunks
+	GlCommandChunk* chunk = m_firstChunk;
+	while(chunk)
+	{
+		U8* it = chunk->getData();
+		U8* end = it + chunk->m_size;
+		while(it < end)
+		{
+			GlCommandHeader& header = *reinterpret_cast<GlCommandHeader*>(it);
+			if(header.m_type == GlCommandType::CUSTOM)
+			{
+				GlCommand* command = reinterpret_cast<GlCommand*>(it + GL_COMMAND_HEADER_SIZE);
+				command->~GlCommand();
+			}
+
+			it += header.m_size;
+		}
+
+		GlCommandChunk* next = chunk->m_next; // Get next before deleting
+		m_alloc.getMemoryPool().free(chunk);
+		chunk = next;
+	}
+
+	m_firstChunk = m_lastChunk = nullptr;
+	m_commandCount = 0;
+
+	// Release the references
+	for(U i = 0; i < m_objectRefCount; ++i)
 	{
-		GlCommand* next = command->m_nextCommand; // Get next before deleting
-		m_alloc.deleteInstance(command);
-		command = next;
+		GrObject* obj = m_objectRefs[i];
+		if(obj->getRefcount().fetchSub(1) == 1)
+		{
+			DefaultPtrDeleter<GrObject> deleter;
+			deleter(obj);
+		}
 	}
 
+	m_objectRefs.destroy(m_alloc);
+	m_objectRefCount = 0;
+
 	ANKI_ASSERT(m_alloc.getMemoryPool().getUsersCount() == 1
 		&& "Someone is holding a reference to the command buffer's allocator");
 
@@ -59,10 +192,68 @@ void CommandBufferImpl::destroy()
 	ANKI_TRACE_STOP_EVENT(GL_CMD_BUFFER_DESTROY);
 }
 
+void* CommandBufferImpl::allocatePacket(GlCommandType type, PtrSize size)
+{
+	ANKI_ASSERT(!m_immutable);
+	ANKI_ASSERT(type < GlCommandType::COUNT);
+
+	const PtrSize packetSize = GL_COMMAND_HEADER_SIZE + getAlignedRoundUp(GL_COMMAND_ALIGNMENT, size);
+	ANKI_ASSERT(packetSize <= MAX_U32);
+
+	// Get a new chunk if needed
+	if(m_lastChunk == nullptr || m_lastChunk->m_size + packetSize > m_lastChunk->m_capacity)
+	{
+		U32 capacity = (m_lastChunk) ? min<U32>(m_lastChunk->m_capacity * 2, MAX_CHUNK_SIZE) : MIN_CHUNK_SIZE;
+		capacity = max<U32>(capacity, packetSize);
+
+		const PtrSize dataOffset = getAlignedRoundUp(GL_COMMAND_ALIGNMENT, sizeof(GlCommandChunk));
+		GlCommandChunk* chunk =
+			static_cast<GlCommandChunk*>(m_alloc.getMemoryPool().allocate(dataOffset + capacity, GL_COMMAND_ALIGNMENT));
+		ANKI_ASSERT(chunk);
+		chunk->m_next = nullptr;
+		chunk->m_size = 0;
+		chunk->m_capacity = capacity;
+
+		if(m_lastChunk)
+		{
+			m_lastChunk->m_next = chunk;
+		}
+		else
+		{
+			m_firstChunk = chunk;
+		}
+
+		m_lastChunk = chunk;
+	}
+
+	U8* mem = m_lastChunk->getData() + m_lastChunk->m_size;
+	m_lastChunk->m_size += packetSize;
+	++m_commandCount;
+
+	GlCommandHeader& header = *reinterpret_cast<GlCommandHeader*>(mem);
+	header.m_type = type;
+	header.m_size = packetSize;
+
+	return mem + GL_COMMAND_HEADER_SIZE;
+}
+
+U32 CommandBufferImpl::pushBackObjectReference(GrObject* obj)
+{
+	ANKI_ASSERT(obj);
+
+	if(m_objectRefCount == m_objectRefs.getSize())
+	{
+		m_objectRefs.resize(m_alloc, max<U32>(16, m_objectRefCount * 2));
+	}
+
+	obj->getRefcount().fetchAdd(1);
+	m_objectRefs[m_objectRefCount] = obj;
+	return m_objectRefCount++;
+}
+
 Error CommandBufferImpl::executeAllCommands()
 {
-	ANKI_ASSERT(m_firstCommand != nullptr && "Empty command buffer");
-	ANKI_ASSERT(m_lastCommand != nullptr && "Empty command buffer");
+	ANKI_ASSERT(m_commandCount > 0 && "Empty command buffer");
 #if ANKI_DEBUG
 	m_executed = true;
 #endif
@@ -70,267 +261,396 @@ Error CommandBufferImpl::executeAllCommands()
 	Error err = ErrorCode::NONE;
 	GlState& state = m_manager->getImplementation().getState();
 
-	GlCommand* command = m_firstCommand;
-
-	while(command != nullptr && !err)
+	const GlCommandChunk* chunk = m_firstChunk;
+	while(chunk && !err)
 	{
-		err = (*command)(state);
-		ANKI_CHECK_GL_ERROR();
+		const U8* it = const_cast<GlCommandChunk*>(chunk)->getData();
+		const U8* end = it + chunk->m_size;
+
+		while(it < end && !err)
+		{
+			const GlCommandHeader& header = *reinterpret_cast<const GlCommandHeader*>(it);
+			err = executeCommand(header, state);
+			ANKI_CHECK_GL_ERROR();
+
+			it += header.m_size;
+		}
 
-		command = command->m_nextCommand;
+		chunk = chunk->m_next;
 	}
 
 	return err;
 }
 
-CommandBufferImpl::InitHints CommandBufferImpl::computeInitHints() const
+Error CommandBufferImpl::executeCommand(const GlCommandHeader& header, GlState& state) const
 {
-	InitHints out;
-	out.m_chunkSize = m_alloc.getMemoryPool().getMemoryCapacity();
+	Error err = ErrorCode::NONE;
 
-	return out;
-}
+	switch(header.m_type)
+	{
+	case GlCommandType::CUSTOM:
+	{
+		GlCommand& command = const_cast<GlCommand&>(getPacket<GlCommand>(header));
+		err = command(state);
+		break;
+	}
+	case GlCommandType::SET_VIEWPORT:
+	{
+		const ViewportPacket& p = getPacket<ViewportPacket>(header);
+		if(state.m_viewport[0] != p.m_value[0] || state.m_viewport[1] != p.m_value[1]
+			|| state.m_viewport[2] != p.m_value[2]
+			|| state.m_viewport[3] != p.m_value[3])
+		{
+			glViewport(p.m_value[0], p.m_value[1], p.m_value[2], p.m_value[3]);
+			state.m_viewport = p.m_value;
+		}
+		break;
+	}
+	case GlCommandType::SET_POLYGON_OFFSET:
+	{
+		const PolygonOffsetPacket& p = getPacket<PolygonOffsetPacket>(header);
+		if(p.m_factor == 0.0 && p.m_units == 0.0)
+		{
+			state.enableCapability(GL_POLYGON_OFFSET_FILL, false);
+		}
+		else
+		{
+			state.enableCapability(GL_POLYGON_OFFSET_FILL, true);
 
-GrAllocator<U8> CommandBufferImpl::getAllocator() const
-{
-	return m_manager->getAllocator();
-}
+			if(state.m_polygonOffsetFactor != p.m_factor || state.m_polygonOffsetUnits != p.m_units)
+			{
+				glPolygonOffset(p.m_factor, p.m_units);
+				state.m_polygonOffsetFactor = p.m_factor;
+				state.m_polygonOffsetUnits = p.m_units;
+			}
+			else
+			{
+				ANKI_TRACE_INC_COUNTER(GR_RASTERIZER_CALLS_SKIPPED, 1);
+			}
+		}
+		break;
+	}
+	case GlCommandType::SET_STENCIL_COMPARE_MASK:
+	{
+		const StencilPacket& p = getPacket<StencilPacket>(header);
+		if(!!(p.m_face & FaceSelectionMask::FRONT) && state.m_stencilCompareMask[0] != p.m_value)
+		{
+			state.m_stencilCompareMask[0] = p.m_value;
+			state.m_glStencilFuncSeparateDirtyMask |= 1 << 0;
+		}
 
-class BindResourcesCommand final : public GlCommand
-{
-public:
-	ResourceGroupPtr m_rc;
-	TransientMemoryInfo m_info;
-	U8 m_slot;
+		if(!!(p.m_face & FaceSelectionMask::BACK) && state.m_stencilCompareMask[1] != p.m_value)
+		{
+			state.m_stencilCompareMask[1] = p.m_value;
+			state.m_glStencilFuncSeparateDirtyMask |= 1 << 1;
+		}
+		break;
+	}
+	case GlCommandType::SET_STENCIL_WRITE_MASK:
+	{
+		const StencilPacket& p = getPacket<StencilPacket>(header);
+		if(!!(p.m_face & FaceSelectionMask::FRONT) && state.m_stencilWriteMask[0] != p.m_value)
+		{
+			glStencilMaskSeparate(GL_FRONT, p.m_value);
+			state.m_stencilWriteMask[0] = p.m_value;
+		}
 
-	BindResourcesCommand(ResourceGroupPtr rc, U8 slot, const TransientMemoryInfo* info)
-		: m_rc(rc)
-		, m_slot(slot)
+		if(!!(p.m_face & FaceSelectionMask::BACK) && state.m_stencilWriteMask[1] != p.m_value)
+		{
+			glStencilMaskSeparate(GL_BACK, p.m_value);
+			state.m_stencilWriteMask[1] = p.m_value;
+		}
+		break;
+	}
+	case GlCommandType::SET_STENCIL_REFERENCE:
 	{
-		if(info)
+		const StencilPacket& p = getPacket<StencilPacket>(header);
+		if(!!(p.m_face & FaceSelectionMask::FRONT) && state.m_stencilRef[0] != p.m_value)
 		{
-			m_info = *info;
+			state.m_stencilRef[0] = p.m_value;
+			state.m_glStencilFuncSeparateDirtyMask |= 1 << 0;
 		}
+
+		if(!!(p.m_face & FaceSelectionMask::BACK) && state.m_stencilRef[1] != p.m_value)
+		{
+			state.m_stencilRef[1] = p.m_value;
+			state.m_glStencilFuncSeparateDirtyMask |= 1 << 1;
+		}
+		break;
 	}
+	case GlCommandType::BIND_PIPELINE:
+	{
+		const ObjectPacket& p = getPacket<ObjectPacket>(header);
+		Pipeline& ppline = getObjectReference<Pipeline>(p.m_objectIdx);
+		if(state.m_lastPplineBoundUuid != ppline.getUuid())
+		{
+			ANKI_TRACE_START_EVENT(GL_BIND_PPLINE);
+
+			ppline.m_impl->bind(state);
+			state.m_lastPplineBoundUuid = ppline.getUuid();
+			ANKI_TRACE_INC_COUNTER(GR_PIPELINE_BINDS_HAPPENED, 1);
 
-	Error operator()(GlState& state)
+			ANKI_TRACE_STOP_EVENT(GL_BIND_PPLINE);
+		}
+		else
+		{
+			ANKI_TRACE_INC_COUNTER(GR_PIPELINE_BINDS_SKIPPED, 1);
+		}
+		break;
+	}
+	case GlCommandType::BIND_RESOURCE_GROUP:
 	{
+		static const TransientMemoryInfo EMPTY_INFO;
+
 		ANKI_TRACE_START_EVENT(GL_BIND_RESOURCES);
-		m_rc->m_impl->bind(m_slot, m_info, state);
+		const BindResourcesPacket& p = getPacket<BindResourcesPacket>(header);
+		const TransientMemoryInfo& info = (p.m_hasInfo)
+			? *reinterpret_cast<const TransientMemoryInfo*>(
+				  reinterpret_cast<const U8*>(&p) + getAlignedRoundUp(GL_COMMAND_ALIGNMENT, sizeof(p)))
+			: EMPTY_INFO;
+
+		getObjectReference<ResourceGroup>(p.m_objectIdx).m_impl->bind(p.m_slot, info, state);
 		ANKI_TRACE_STOP_EVENT(GL_BIND_RESOURCES);
-		return ErrorCode::NONE;
+		break;
 	}
-};
+	case GlCommandType::BEGIN_RENDER_PASS:
+	{
+		const ObjectPacket& p = getPacket<ObjectPacket>(header);
+		getObjectReference<Framebuffer>(p.m_objectIdx).m_impl->bind(state);
+		break;
+	}
+	case GlCommandType::DRAW_ELEMENTS:
+	{
+		const DrawElementsIndirectInfo& info = getPacket<DrawElementsPacket>(header).m_info;
+
+		state.flushVertexState();
+		state.flushStencilState();
+		glDrawElementsInstancedBaseVertexBaseInstance(state.m_topology,
+			info.m_count,
+			getIndexType(state.m_indexSize),
+			numberToPtr<const void*>(info.m_firstIndex * state.m_indexSize),
+			info.m_instanceCount,
+			info.m_baseVertex,
+			info.m_baseInstance);
+
+		ANKI_TRACE_INC_COUNTER(GR_DRAWCALLS, 1);
+		ANKI_TRACE_INC_COUNTER(GR_VERTICES, info.m_instanceCount * info.m_count);
+		break;
+	}
+	case GlCommandType::DRAW_ARRAYS:
+	{
+		const DrawArraysIndirectInfo& info = getPacket<DrawArraysPacket>(header).m_info;
 
-void CommandBufferImpl::bindResourceGroup(ResourceGroupPtr rc, U slot, const TransientMemoryInfo* info)
-{
-	ANKI_ASSERT(rc.isCreated());
+		state.flushVertexState();
+		state.flushStencilState();
+		glDrawArraysInstancedBaseInstance(
+			state.m_topology, info.m_first, info.m_count, info.m_instanceCount, info.m_baseInstance);
 
-	pushBackNewCommand<BindResourcesCommand>(rc, slot, info);
-}
+		ANKI_TRACE_INC_COUNTER(GR_DRAWCALLS, 1);
+		break;
+	}
+	case GlCommandType::DRAW_ELEMENTS_INDIRECT:
+	{
+		const DrawIndirectPacket& p = getPacket<DrawIndirectPacket>(header);
 
-void CommandBufferImpl::drawElements(U32 count, U32 instanceCount, U32 firstIndex, U32 baseVertex, U32 baseInstance)
-{
-	class DrawElementsCommand : public GlCommand
+		state.flushVertexState();
+		state.flushStencilState();
+		const BufferImpl& buff = *getObjectReference<Buffer>(p.m_objectIdx).m_impl;
+
+		ANKI_ASSERT(p.m_offset + sizeof(DrawElementsIndirectInfo) * p.m_drawCount <= buff.m_size);
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buff.getGlName());
+
+		glMultiDrawElementsIndirect(state.m_topology,
+			getIndexType(state.m_indexSize),
+			numberToPtr<void*>(p.m_offset),
+			p.m_drawCount,
+			sizeof(DrawElementsIndirectInfo));
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		break;
+	}
+	case GlCommandType::DRAW_ARRAYS_INDIRECT:
 	{
-	public:
-		DrawElementsIndirectInfo m_info;
+		const DrawIndirectPacket& p = getPacket<DrawIndirectPacket>(header);
 
-		DrawElementsCommand(const DrawElementsIndirectInfo& info)
-			: m_info(info)
-		{
-		}
+		state.flushVertexState();
+		state.flushStencilState();
+		const BufferImpl& buff = *getObjectReference<Buffer>(p.m_objectIdx).m_impl;
 
-		Error operator()(GlState& state)
-		{
-			GLenum indicesType = 0;
-			switch(state.m_indexSize)
-			{
-			case 2:
-				indicesType = GL_UNSIGNED_SHORT;
-				break;
-			case 4:
-				indicesType = GL_UNSIGNED_INT;
-				break;
-			default:
-				ANKI_ASSERT(0);
-				break;
-			};
-
-			state.flushVertexState();
-			state.flushStencilState();
-			glDrawElementsInstancedBaseVertexBaseInstance(state.m_topology,
-				m_info.m_count,
-				indicesType,
-				(const void*)(PtrSize)(m_info.m_firstIndex * state.m_indexSize),
-				m_info.m_instanceCount,
-				m_info.m_baseVertex,
-				m_info.m_baseInstance);
-
-			ANKI_TRACE_INC_COUNTER(GR_DRAWCALLS, 1);
-			ANKI_TRACE_INC_COUNTER(GR_VERTICES, m_info.m_instanceCount * m_info.m_count);
-
-			return ErrorCode::NONE;
-		}
-	};
+		ANKI_ASSERT(p.m_offset + sizeof(DrawArraysIndirectInfo) * p.m_drawCount <= buff.m_size);
 
-	ANKI_ASSERT(m_dbg.m_insideRenderPass);
-	DrawElementsIndirectInfo info(count, instanceCount, firstIndex, baseVertex, baseInstance);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buff.getGlName());
 
-	checkDrawcall();
-	pushBackNewCommand<DrawElementsCommand>(info);
+		glMultiDrawArraysIndirect(
+			state.m_topology, numberToPtr<void*>(p.m_offset), p.m_drawCount, sizeof(DrawArraysIndirectInfo));
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		break;
+	}
+	case GlCommandType::DISPATCH_COMPUTE:
+	{
+		const DispatchPacket& p = getPacket<DispatchPacket>(header);
+		glDispatchCompute(p.m_size[0], p.m_size[1], p.m_size[2]);
+		break;
+	}
+	case GlCommandType::MEMORY_BARRIER:
+	{
+		glMemoryBarrier(getPacket<MemoryBarrierPacket>(header).m_barrier);
+		break;
+	}
+	default:
+		ANKI_ASSERT(!"Unknown packet");
+	}
+
+	return err;
 }
 
-void CommandBufferImpl::drawArrays(U32 count, U32 instanceCount, U32 first, U32 baseInstance)
+CommandBufferImpl::InitHints CommandBufferImpl::computeInitHints() const
 {
-	class DrawArraysCommand final : public GlCommand
-	{
-	public:
-		DrawArraysIndirectInfo m_info;
+	InitHints out;
+	out.m_chunkSize = m_alloc.getMemoryPool().getMemoryCapacity();
 
-		DrawArraysCommand(const DrawArraysIndirectInfo& info)
-			: m_info(info)
-		{
-		}
+	return out;
+}
 
-		Error operator()(GlState& state)
-		{
-			state.flushVertexState();
-			state.flushStencilState();
-			glDrawArraysInstancedBaseInstance(
-				state.m_topology, m_info.m_first, m_info.m_count, m_info.m_instanceCount, m_info.m_baseInstance);
+GrAllocator<U8> CommandBufferImpl::getAllocator() const
+{
+	return m_manager->getAllocator();
+}
 
-			ANKI_TRACE_INC_COUNTER(GR_DRAWCALLS, 1);
-			return ErrorCode::NONE;
-		}
-	};
+void CommandBufferImpl::setViewport(U16 minx, U16 miny, U16 maxx, U16 maxy)
+{
+#if ANKI_ASSERTS_ENABLED
+	m_dbg.m_viewport = true;
+#endif
+	ViewportPacket& p = pushBackNewPacket<ViewportPacket>(GlCommandType::SET_VIEWPORT);
+	p.m_value = {{minx, miny, maxx, maxy}};
+}
 
-	ANKI_ASSERT(m_dbg.m_insideRenderPass);
-	DrawArraysIndirectInfo info(count, instanceCount, first, baseInstance);
+void CommandBufferImpl::setPolygonOffset(F32 factor, F32 units)
+{
+#if ANKI_ASSERTS_ENABLED
+	m_dbg.m_polygonOffset = true;
+#endif
+	PolygonOffsetPacket& p = pushBackNewPacket<PolygonOffsetPacket>(GlCommandType::SET_POLYGON_OFFSET);
+	p.m_factor = factor;
+	p.m_units = units;
+}
 
-	checkDrawcall();
-	pushBackNewCommand<DrawArraysCommand>(info);
+void CommandBufferImpl::setStencilCompareMask(FaceSelectionMask face, U32 mask)
+{
+	StencilPacket& p = pushBackNewPacket<StencilPacket>(GlCommandType::SET_STENCIL_COMPARE_MASK);
+	p.m_face = face;
+	p.m_value = mask;
 }
 
-void CommandBufferImpl::drawElementsIndirect(U32 drawCount, PtrSize offset, BufferPtr indirectBuff)
+void CommandBufferImpl::setStencilWriteMask(FaceSelectionMask face, U32 mask)
 {
-	class DrawElementsIndirectCommand final : public GlCommand
-	{
-	public:
-		U32 m_drawCount;
-		PtrSize m_offset;
-		BufferPtr m_buff;
-
-		DrawElementsIndirectCommand(U32 drawCount, PtrSize offset, BufferPtr buff)
-			: m_drawCount(drawCount)
-			, m_offset(offset)
-			, m_buff(buff)
-		{
-			ANKI_ASSERT(drawCount > 0);
-			ANKI_ASSERT((m_offset % 4) == 0);
-		}
+	StencilPacket& p = pushBackNewPacket<StencilPacket>(GlCommandType::SET_STENCIL_WRITE_MASK);
+	p.m_face = face;
+	p.m_value = mask;
+}
 
-		Error operator()(GlState& state)
-		{
-			state.flushVertexState();
-			state.flushStencilState();
-			const BufferImpl& buff = *m_buff->m_impl;
+void CommandBufferImpl::setStencilReference(FaceSelectionMask face, U32 ref)
+{
+	StencilPacket& p = pushBackNewPacket<StencilPacket>(GlCommandType::SET_STENCIL_REFERENCE);
+	p.m_face = face;
+	p.m_value = ref;
+}
 
-			ANKI_ASSERT(m_offset + sizeof(DrawElementsIndirectInfo) * m_drawCount <= buff.m_size);
+void CommandBufferImpl::bindPipeline(PipelinePtr ppline)
+{
+	ANKI_ASSERT(ppline.isCreated());
+	U32 idx = pushBackObjectReference(ppline.get());
 
-			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buff.getGlName());
+	ObjectPacket& p = pushBackNewPacket<ObjectPacket>(GlCommandType::BIND_PIPELINE);
+	p.m_objectIdx = idx;
+}
 
-			GLenum indicesType = 0;
-			switch(state.m_indexSize)
-			{
-			case 2:
-				indicesType = GL_UNSIGNED_SHORT;
-				break;
-			case 4:
-				indicesType = GL_UNSIGNED_INT;
-				break;
-			default:
-				ANKI_ASSERT(0);
-				break;
-			};
-
-			glMultiDrawElementsIndirect(state.m_topology,
-				indicesType,
-				numberToPtr<void*>(m_offset),
-				m_drawCount,
-				sizeof(DrawElementsIndirectInfo));
-
-			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
-			return ErrorCode::NONE;
-		}
-	};
+void CommandBufferImpl::beginRenderPass(FramebufferPtr fb)
+{
+	ANKI_ASSERT(fb.isCreated());
+	U32 idx = pushBackObjectReference(fb.get());
 
-	checkDrawcall();
-	pushBackNewCommand<DrawElementsIndirectCommand>(drawCount, offset, indirectBuff);
+	ObjectPacket& p = pushBackNewPacket<ObjectPacket>(GlCommandType::BEGIN_RENDER_PASS);
+	p.m_objectIdx = idx;
 }
 
-void CommandBufferImpl::drawArraysIndirect(U32 drawCount, PtrSize offset, BufferPtr indirectBuff)
+void CommandBufferImpl::bindResourceGroup(ResourceGroupPtr rc, U slot, const TransientMemoryInfo* info)
 {
-	class DrawArraysIndirectCommand final : public GlCommand
+	ANKI_ASSERT(rc.isCreated());
+	U32 idx = pushBackObjectReference(rc.get());
+
+	const PtrSize packetSize = getAlignedRoundUp(GL_COMMAND_ALIGNMENT, sizeof(BindResourcesPacket));
+	BindResourcesPacket& p = pushBackNewPacket<BindResourcesPacket>(GlCommandType::BIND_RESOURCE_GROUP,
+		(info) ? (packetSize - sizeof(BindResourcesPacket) + sizeof(TransientMemoryInfo)) : 0);
+	p.m_objectIdx = idx;
+	p.m_slot = slot;
+	p.m_hasInfo = info != nullptr;
+
+	if(info)
 	{
-	public:
-		U32 m_drawCount;
-		PtrSize m_offset;
-		BufferPtr m_buff;
-
-		DrawArraysIndirectCommand(U32 drawCount, PtrSize offset, BufferPtr buff)
-			: m_drawCount(drawCount)
-			, m_offset(offset)
-			, m_buff(buff)
-		{
-			ANKI_ASSERT(drawCount > 0);
-			ANKI_ASSERT((m_offset % 4) == 0);
-		}
+		memcpy(reinterpret_cast<U8*>(&p) + packetSize, info, sizeof(*info));
+	}
+}
 
-		Error operator()(GlState& state)
-		{
-			state.flushVertexState();
-			state.flushStencilState();
-			const BufferImpl& buff = *m_buff->m_impl;
+void CommandBufferImpl::drawElements(U32 count, U32 instanceCount, U32 firstIndex, U32 baseVertex, U32 baseInstance)
+{
+	ANKI_ASSERT(m_dbg.m_insideRenderPass);
+	checkDrawcall();
 
-			ANKI_ASSERT(m_offset + sizeof(DrawArraysIndirectInfo) * m_drawCount <= buff.m_size);
+	DrawElementsPacket& p = pushBackNewPacket<DrawElementsPacket>(GlCommandType::DRAW_ELEMENTS);
+	p.m_info = DrawElementsIndirectInfo(count, instanceCount, firstIndex, baseVertex, baseInstance);
+}
 
-			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buff.getGlName());
+void CommandBufferImpl::drawArrays(U32 count, U32 instanceCount, U32 first, U32 baseInstance)
+{
+	ANKI_ASSERT(m_dbg.m_insideRenderPass);
+	checkDrawcall();
 
-			glMultiDrawArraysIndirect(
-				state.m_topology, numberToPtr<void*>(m_offset), m_drawCount, sizeof(DrawArraysIndirectInfo));
+	DrawArraysPacket& p = pushBackNewPacket<DrawArraysPacket>(GlCommandType::DRAW_ARRAYS);
+	p.m_info = DrawArraysIndirectInfo(count, instanceCount, first, baseInstance);
+}
 
-			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
-			return ErrorCode::NONE;
-		}
-	};
+void CommandBufferImpl::drawElementsIndirect(U32 drawCount, PtrSize offset, BufferPtr indirectBuff)
+{
+	ANKI_ASSERT(drawCount > 0);
+	ANKI_ASSERT((offset % 4) == 0);
+	checkDrawcall();
+	U32 idx = pushBackObjectReference(indirectBuff.get());
+
+	DrawIndirectPacket& p = pushBackNewPacket<DrawIndirectPacket>(GlCommandType::DRAW_ELEMENTS_INDIRECT);
+	p.m_offset = offset;
+	p.m_drawCount = drawCount;
+	p.m_objectIdx = idx;
+}
 
+void CommandBufferImpl::drawArraysIndirect(U32 drawCount, PtrSize offset, BufferPtr indirectBuff)
+{
+	ANKI_ASSERT(drawCount > 0);
+	ANKI_ASSERT((offset % 4) == 0);
 	checkDrawcall();
-	pushBackNewCommand<DrawArraysIndirectCommand>(drawCount, offset, indirectBuff);
+	U32 idx = pushBackObjectReference(indirectBuff.get());
+
+	DrawIndirectPacket& p = pushBackNewPacket<DrawIndirectPacket>(GlCommandType::DRAW_ARRAYS_INDIRECT);
+	p.m_offset = offset;
+	p.m_drawCount = drawCount;
+	p.m_objectIdx = idx;
 }
 
 void CommandBufferImpl::dispatchCompute(U32 groupCountX, U32 groupCountY, U32 groupCountZ)
 {
 	ANKI_ASSERT(!m_dbg.m_insideRenderPass);
 
-	class DispatchCommand final : public GlCommand
-	{
-	public:
-		Array<U32, 3> m_size;
-
-		DispatchCommand(U32 x, U32 y, U32 z)
-			: m_size({{x, y, z}})
-		{
-		}
-
-		Error operator()(GlState&)
-		{
-			glDispatchCompute(m_size[0], m_size[1], m_size[2]);
-			return ErrorCode::NONE;
-		}
-	};
+	DispatchPacket& p = pushBackNewPacket<DispatchPacket>(GlCommandType::DISPATCH_COMPUTE);
+	p.m_size = {{groupCountX, groupCountY, groupCountZ}};
+}
 
-	pushBackNewCommand<DispatchCommand>(groupCountX, groupCountY, groupCountZ);
+void CommandBufferImpl::setMemoryBarrier(GLenum barrier)
+{
+	MemoryBarrierPacket& p = pushBackNewPacket<MemoryBarrierPacket>(GlCommandType::MEMORY_BARRIER);
+	p.m_barrier = barrier;
 }
 
 } // end namespace anki
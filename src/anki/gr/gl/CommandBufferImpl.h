@@ -5,9 +5,11 @@
 
 #pragma once
 
+#include <anki/gr/gl/Common.h>
 #include <anki/gr/CommandBuffer.h>
 #include <anki/util/Assert.h>
 #include <anki/util/Allocator.h>
+#include <anki/util/DynamicArray.h>
 
 namespace anki
 {
@@ -21,12 +23,11 @@ class GlState;
 template<typename T>
 using CommandBufferAllocator = StackAllocator<T>;
 
-/// The base of all GL commands.
+/// The base of the GL commands that don't have a dedicated packet type. They are constructed in place inside the
+/// command stream and they are executed through a virtual call.
 class GlCommand
 {
 public:
-	GlCommand* m_nextCommand = nullptr;
-
 	virtual ~GlCommand()
 	{
 	}
@@ -35,7 +36,58 @@ public:
 	virtual ANKI_USE_RESULT Error operator()(GlState& state) = 0;
 };
 
-/// A number of GL commands organized in a chain
+/// The type of a packet in the command stream.
+enum class GlCommandType : U8
+{
+	CUSTOM, ///< A GlCommand constructed in place.
+	SET_VIEWPORT,
+	SET_POLYGON_OFFSET,
+	SET_STENCIL_COMPARE_MASK,
+	SET_STENCIL_WRITE_MASK,
+	SET_STENCIL_REFERENCE,
+	BIND_PIPELINE,
+	BIND_RESOURCE_GROUP,
+	BEGIN_RENDER_PASS,
+	DRAW_ELEMENTS,
+	DRAW_ARRAYS,
+	DRAW_ELEMENTS_INDIRECT,
+	DRAW_ARRAYS_INDIRECT,
+	DISPATCH_COMPUTE,
+	MEMORY_BARRIER,
+
+	COUNT
+};
+
+/// The header of every packet in the command stream. The payload follows.
+class GlCommandHeader
+{
+public:
+	GlCommandType m_type;
+	U32 m_size; ///< The size of the packet in bytes including the header.
+};
+
+/// All packets are aligned to that.
+const PtrSize GL_COMMAND_ALIGNMENT = 8;
+
+/// The size of the header after alignment.
+const PtrSize GL_COMMAND_HEADER_SIZE = (sizeof(GlCommandHeader) + GL_COMMAND_ALIGNMENT - 1) & ~(GL_COMMAND_ALIGNMENT - 1);
+
+/// A chunk of linear memory that holds packets.
+class GlCommandChunk
+{
+public:
+	GlCommandChunk* m_next;
+	U32 m_size; ///< Used bytes.
+	U32 m_capacity; ///< The size of the data.
+
+	U8* getData()
+	{
+		return reinterpret_cast<U8*>(this) + getAlignedRoundUp(GL_COMMAND_ALIGNMENT, sizeof(GlCommandChunk));
+	}
+};
+
+/// A stream of GL commands. The commands are tagged POD packets stored in chunks of linear memory. The GrObjects that
+/// the packets reference are kept alive by a side table and the packets store an index to that table.
 class CommandBufferImpl
 {
 public:
@@ -78,10 +130,29 @@ public:
 	/// Compute initialization hints.
 	InitHints computeInitHints() const;
 
-	/// Create a new command and add it to the chain.
+	/// Create a new custom command in place and add it to the stream.
 	template<typename TCommand, typename... TArgs>
 	void pushBackNewCommand(TArgs&&... args);
 
+	/// Allocate a new packet at the end of the stream.
+	/// @param extraSize Payload that follows the packet.
+	template<typename TPacket>
+	TPacket& pushBackNewPacket(GlCommandType type, PtrSize extraSize = 0)
+	{
+		void* mem = allocatePacket(type, sizeof(TPacket) + extraSize);
+		return *::new(mem) TPacket();
+	}
+
+	/// Add an object to the side table and return its index.
+	U32 pushBackObjectReference(GrObject* obj);
+
+	template<typename T>
+	T& getObjectReference(U32 idx) const
+	{
+		ANKI_ASSERT(idx < m_objectRefCount);
+		return *static_cast<T*>(m_objectRefs[idx]);
+	}
+
 	/// Execute all commands
 	ANKI_USE_RESULT Error executeAllCommands();
 
@@ -106,9 +177,25 @@ public:
 
 	Bool isEmpty() const
 	{
-		return m_firstCommand == nullptr;
+		return m_commandCount == 0;
 	}
 
+	void setViewport(U16 minx, U16 miny, U16 maxx, U16 maxy);
+
+	void setPolygonOffset(F32 factor, F32 units);
+
+	void setStencilCompareMask(FaceSelectionMask face, U32 mask);
+
+	void setStencilWriteMask(FaceSelectionMask face, U32 mask);
+
+	void setStencilReference(FaceSelectionMask face, U32 ref);
+
+	void bindPipeline(PipelinePtr ppline);
+
+	void beginRenderPass(FramebufferPtr fb);
+
+	void setMemoryBarrier(GLenum barrier);
+
 	void bindResourceGroup(ResourceGroupPtr rc, U slot, const TransientMemoryInfo* info);
 
 	void drawElements(U32 count, U32 instanceCount = 1, U32 firstIndex = 0, U32 baseVertex = 0, U32 baseInstance = 0);
@@ -137,10 +224,21 @@ public:
 	}
 
 private:
+	static const U32 MIN_CHUNK_SIZE = 4 * 1024;
+	static const U32 MAX_CHUNK_SIZE = 64 * 1024;
+
 	GrManager* m_manager = nullptr;
-	GlCommand* m_firstCommand = nullptr;
-	GlCommand* m_lastCommand = nullptr;
+	GlCommandChunk* m_firstChunk = nullptr;
+	GlCommandChunk* m_lastChunk = nullptr;
+	U32 m_commandCount = 0;
 	CommandBufferAllocator<U8> m_alloc;
+
+	/// @name Side table of object references
+	/// @{
+	DynamicArray<GrObject*> m_objectRefs;
+	U32 m_objectRefCount = 0;
+	/// @}
+
 	Bool8 m_immutable = false;
 	CommandBufferFlag m_flags;
 
@@ -150,6 +248,10 @@ private:
 
 	void destroy();
 
+	void* allocatePacket(GlCommandType type, PtrSize size);
+
+	ANKI_USE_RESULT Error executeCommand(const GlCommandHeader& header, GlState& state) const;
+
 	void checkDrawcall() const
 	{
 		ANKI_ASSERT(m_dbg.m_viewport == true);
@@ -160,22 +262,9 @@ private:
 template<typename TCommand, typename... TArgs>
 inline void CommandBufferImpl::pushBackNewCommand(TArgs&&... args)
 {
-	ANKI_ASSERT(!m_immutable);
-	TCommand* newCommand = m_alloc.template newInstance<TCommand>(std::forward<TArgs>(args)...);
-
-	if(m_firstCommand != nullptr)
-	{
-		ANKI_ASSERT(m_lastCommand != nullptr);
-		ANKI_ASSERT(m_lastCommand->m_nextCommand == nullptr);
-		m_lastCommand->m_nextCommand = newCommand;
-		m_lastCommand = newCommand;
-	}
-	else
-	{
-		ANKI_ASSERT(m_lastCommand == nullptr);
-		m_firstCommand = newCommand;
-		m_lastCommand = newCommand;
-	}
+	static_assert(alignof(TCommand) <= GL_COMMAND_ALIGNMENT, "Wrong alignment");
+	void* mem = allocatePacket(GlCommandType::CUSTOM, sizeof(TCommand));
+	::new(mem) TCommand(std::forward<TArgs>(args)...);
 }
 /// @}
 
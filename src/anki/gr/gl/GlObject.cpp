@@ -6,6 +6,7 @@
 #include <anki/gr/gl/GlObject.h>
 #include <anki/gr/GrManager.h>
 #include <anki/gr/gl/GrManagerImpl.h>
+#include <anki/gr/gl/GlState.h>
 #include <anki/gr/gl/RenderingThread.h>
 #include <anki/gr/CommandBuffer.h>
 #include <anki/gr/gl/CommandBufferImpl.h>
@@ -56,9 +57,10 @@ public:
 	{
 	}
 
-	Error operator()(GlState&)
+	Error operator()(GlState& state)
 	{
 		m_callback(1, &m_glName);
+		state.invalidateResourceBindings();
 		return ErrorCode::NONE;
 	}
 };
@@ -84,6 +86,7 @@ void GlObject::destroyDeferred(GlDeleteFunction deleteCallback)
 	else
 	{
 		deleteCallback(1, &m_glName);
+		manager.getImplementation().getState().invalidateResourceBindings();
 	}
 
 	m_glName = 0;
@@ -175,4 +175,167 @@ void GlState::flushStencilState()
 	}
 }
 
+void GlState::enableCapability(GLenum cap, Bool enable)
+{
+	U8 bit;
+	switch(cap)
+	{
+	case GL_BLEND:
+		bit = 1 << 0;
+		break;
+	case GL_DEPTH_TEST:
+		bit = 1 << 1;
+		break;
+	case GL_STENCIL_TEST:
+		bit = 1 << 2;
+		break;
+	case GL_CULL_FACE:
+		bit = 1 << 3;
+		break;
+	case GL_PRIMITIVE_RESTART:
+		bit = 1 << 4;
+		break;
+	case GL_POLYGON_OFFSET_FILL:
+		bit = 1 << 5;
+		break;
+	default:
+		ANKI_ASSERT(0 && "Capability not tracked");
+		bit = 0;
+	}
+
+	if(Bool(m_enabledCapabilities & bit) == enable)
+	{
+		ANKI_TRACE_INC_COUNTER(GR_CAPABILITY_CALLS_SKIPPED, 1);
+		return;
+	}
+
+	if(enable)
+	{
+		glEnable(cap);
+		m_enabledCapabilities |= bit;
+	}
+	else
+	{
+		glDisable(cap);
+		m_enabledCapabilities &= ~bit;
+	}
+}
+
+/// Find the range of names that differ from the shadowed ones and update the shadow.
+/// @return The number of names that need to be bound starting from first.
+static U updateBindingRange(GLuint* shadow, U& first, U count, const GLuint* names)
+{
+	U begin = MAX_U;
+	U end = 0;
+	for(U i = 0; i < count; ++i)
+	{
+		const GLuint name = (names) ? names[i] : 0;
+		if(shadow[first + i] != name)
+		{
+			shadow[first + i] = name;
+			begin = min(begin, i);
+			end = i + 1;
+		}
+	}
+
+	if(begin == MAX_U)
+	{
+		return 0;
+	}
+
+	first += begin;
+	return end - begin;
+}
+
+void GlState::bindTextures(U first, U count, const GLuint* names)
+{
+	ANKI_ASSERT(first + count <= m_textureUnits.getSize());
+	ANKI_ASSERT(names);
+
+	U newFirst = first;
+	const U newCount = updateBindingRange(&m_textureUnits[0], newFirst, count, names);
+	if(newCount)
+	{
+		glBindTextures(newFirst, newCount, names + (newFirst - first));
+	}
+
+	ANKI_TRACE_INC_COUNTER(GR_TEXTURE_BINDS_SKIPPED, count - newCount);
+}
+
+void GlState::bindSamplers(U first, U count, const GLuint* names)
+{
+	ANKI_ASSERT(first + count <= m_samplerUnits.getSize());
+
+	U newFirst = first;
+	const U newCount = updateBindingRange(&m_samplerUnits[0], newFirst, count, names);
+	if(newCount)
+	{
+		glBindSamplers(newFirst, newCount, (names) ? (names + (newFirst - first)) : nullptr);
+	}
+
+	ANKI_TRACE_INC_COUNTER(GR_SAMPLER_BINDS_SKIPPED, count - newCount);
+}
+
+void GlState::bindBufferRange(GLenum target, U binding, GLuint name, GLintptr offset, GLsizeiptr range)
+{
+	GlBufferBinding* b;
+	if(target == GL_UNIFORM_BUFFER)
+	{
+		b = &m_uniformBufferBindings[binding];
+	}
+	else
+	{
+		ANKI_ASSERT(target == GL_SHADER_STORAGE_BUFFER);
+		b = &m_storageBufferBindings[binding];
+	}
+
+	if(b->m_name == name && b->m_offset == offset && b->m_range == range)
+	{
+		ANKI_TRACE_INC_COUNTER(GR_BUFFER_BINDS_SKIPPED, 1);
+		return;
+	}
+
+	glBindBufferRange(target, binding, name, offset, range);
+	b->m_name = name;
+	b->m_offset = offset;
+	b->m_range = range;
+}
+
+void GlState::bindIndexBuffer(GLuint name)
+{
+	if(m_indexBuffName == name)
+	{
+		ANKI_TRACE_INC_COUNTER(GR_BUFFER_BINDS_SKIPPED, 1);
+		return;
+	}
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, name);
+	m_indexBuffName = name;
+}
+
+void GlState::invalidateResourceBindings()
+{
+	for(GLuint& name : m_textureUnits)
+	{
+		name = MAX_U32;
+	}
+
+	for(GLuint& name : m_samplerUnits)
+	{
+		name = MAX_U32;
+	}
+
+	for(GlBufferBinding& b : m_uniformBufferBindings)
+	{
+		b.m_name = MAX_U32;
+	}
+
+	for(GlBufferBinding& b : m_storageBufferBindings)
+	{
+		b.m_name = MAX_U32;
+	}
+
+	m_indexBuffName = MAX_U32;
+}
+
 } // end namespace anki
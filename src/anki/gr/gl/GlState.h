@@ -6,6 +6,7 @@
 #pragma once
 
 #include <anki/gr/gl/Common.h>
+#include <anki/gr/Pipeline.h>
 #include <anki/util/DynamicArray.h>
 
 namespace anki
@@ -17,6 +18,43 @@ class ConfigSet;
 /// @addtogroup opengl
 /// @{
 
+/// The hashes of the pipeline sub-states. Used to find the parts of the pipeline state that need to change.
+class GlPipelineStateHashes
+{
+public:
+	U64 m_vertex = 0;
+	U64 m_inputAssembler = 0;
+	U64 m_tessellation = 0;
+	U64 m_viewport = 0;
+	U64 m_rasterizer = 0;
+	U64 m_depthStencil = 0;
+	U64 m_color = 0;
+
+	/// Get the sub-states that differ.
+	PipelineSubStateBit diff(const GlPipelineStateHashes& b) const
+	{
+		PipelineSubStateBit mask = PipelineSubStateBit::NONE;
+		mask |= (m_vertex != b.m_vertex) ? PipelineSubStateBit::VERTEX : PipelineSubStateBit::NONE;
+		mask |= (m_inputAssembler != b.m_inputAssembler) ? PipelineSubStateBit::INPUT_ASSEMBLER
+														 : PipelineSubStateBit::NONE;
+		mask |= (m_tessellation != b.m_tessellation) ? PipelineSubStateBit::TESSELLATION : PipelineSubStateBit::NONE;
+		mask |= (m_viewport != b.m_viewport) ? PipelineSubStateBit::VIEWPORT : PipelineSubStateBit::NONE;
+		mask |= (m_rasterizer != b.m_rasterizer) ? PipelineSubStateBit::RASTERIZER : PipelineSubStateBit::NONE;
+		mask |= (m_depthStencil != b.m_depthStencil) ? PipelineSubStateBit::DEPTH_STENCIL : PipelineSubStateBit::NONE;
+		mask |= (m_color != b.m_color) ? PipelineSubStateBit::COLOR : PipelineSubStateBit::NONE;
+		return mask;
+	}
+};
+
+/// A shadow of a glBindBufferRange binding.
+class GlBufferBinding
+{
+public:
+	GLuint m_name = 0;
+	GLintptr m_offset = 0;
+	GLsizeiptr m_range = 0;
+};
+
 /// Part of the global state. It's essentialy a cache of the state mainly used for optimizations and other stuff
 class GlState
 {
@@ -32,8 +70,28 @@ public:
 	/// @{
 	Array<U16, 4> m_viewport = {{0, 0, 0, 0}};
 
-	GLenum m_blendSfunc = GL_ONE;
-	GLenum m_blendDfunc = GL_ZERO;
+	U8 m_enabledCapabilities = 0; ///< A mask of the capabilities that are glEnable'd. See enableCapability.
+
+	Array<GLenum, MAX_COLOR_ATTACHMENTS> m_blendSrcFuncs = {{GL_ONE, GL_ONE, GL_ONE, GL_ONE}};
+	Array<GLenum, MAX_COLOR_ATTACHMENTS> m_blendDstFuncs = {{GL_ZERO, GL_ZERO, GL_ZERO, GL_ZERO}};
+	Array<GLenum, MAX_COLOR_ATTACHMENTS> m_blendEquations = {{GL_FUNC_ADD, GL_FUNC_ADD, GL_FUNC_ADD, GL_FUNC_ADD}};
+
+	GLenum m_depthCompareFunc = GL_LESS;
+	Array2d<GLenum, 2, 3> m_stencilOps = {{{{GL_KEEP, GL_KEEP, GL_KEEP}}, {{GL_KEEP, GL_KEEP, GL_KEEP}}}};
+
+	GLenum m_polygonMode = GL_FILL;
+	GLenum m_cullFace = GL_BACK;
+	F32 m_polygonOffsetFactor = 0.0;
+	F32 m_polygonOffsetUnits = 0.0;
+	/// @}
+
+	/// @name Bound resources. MAX_U32 means that the binding is unknown
+	/// @{
+	Array<GLuint, MAX_TEXTURE_BINDINGS * MAX_BOUND_RESOURCE_GROUPS> m_textureUnits;
+	Array<GLuint, MAX_TEXTURE_BINDINGS * MAX_BOUND_RESOURCE_GROUPS> m_samplerUnits;
+	Array<GlBufferBinding, MAX_UNIFORM_BUFFER_BINDINGS * MAX_BOUND_RESOURCE_GROUPS> m_uniformBufferBindings;
+	Array<GlBufferBinding, MAX_STORAGE_BUFFER_BINDINGS * MAX_BOUND_RESOURCE_GROUPS> m_storageBufferBindings;
+	GLuint m_indexBuffName = 0;
 	/// @}
 
 	/// @name Pipeline/resource group state
@@ -49,17 +107,7 @@ public:
 	GLenum m_topology = 0;
 	U8 m_indexSize = 4;
 
-	class
-	{
-	public:
-		U64 m_vertex = 0;
-		U64 m_inputAssembler = 0;
-		U64 m_tessellation = 0;
-		U64 m_viewport = 0;
-		U64 m_rasterizer = 0;
-		U64 m_depthStencil = 0;
-		U64 m_color = 0;
-	} m_stateHashes;
+	GlPipelineStateHashes m_stateHashes;
 
 	Array2d<Bool, MAX_COLOR_ATTACHMENTS, 4> m_colorWriteMasks = {{{{true, true, true, true}},
 		{{true, true, true, true}},
@@ -79,6 +127,7 @@ public:
 	GlState(GrManager* manager)
 		: m_manager(manager)
 	{
+		invalidateResourceBindings();
 	}
 
 	/// Call this from the main thread.
@@ -92,6 +141,27 @@ public:
 
 	void flushVertexState();
 	void flushStencilState();
+
+	/// glEnable or glDisable a capability if it's not already in that state. Only a few capabilities are tracked.
+	void enableCapability(GLenum cap, Bool enable);
+
+	/// glBindTextures only the units that changed.
+	void bindTextures(U first, U count, const GLuint* names);
+
+	/// glBindSamplers only the units that changed.
+	/// @param names If nullptr it will bind zero to all units.
+	void bindSamplers(U first, U count, const GLuint* names);
+
+	/// glBindBufferRange if the binding changed.
+	/// @param target GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER.
+	void bindBufferRange(GLenum target, U binding, GLuint name, GLintptr offset, GLsizeiptr range);
+
+	/// Bind the element array buffer if it changed.
+	void bindIndexBuffer(GLuint name);
+
+	/// Forget the bound textures, samplers and buffers. Call it when GL objects get deleted because GL unbinds them and
+	/// their names can be recycled.
+	void invalidateResourceBindings();
 };
 /// @}
 
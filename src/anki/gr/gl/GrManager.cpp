@@ -4,6 +4,8 @@
 // http://www.anki3d.org/LICENSE
 
 #include <anki/gr/GrManager.h>
+#include <anki/gr/common/PipelinePersistentCache.h>
+#include <anki/core/Config.h>
 #include <anki/gr/gl/GrManagerImpl.h>
 #include <anki/gr/gl/RenderingThread.h>
 #include <anki/gr/gl/TransientMemoryManager.h>
@@ -21,6 +23,7 @@ GrManager::GrManager()
 GrManager::~GrManager()
 {
 	// Destroy in reverse order
+	m_pplinePersistentCache.reset(nullptr);
 	m_impl.reset(nullptr);
 	m_cacheDir.destroy(m_alloc);
 }
@@ -34,6 +37,10 @@ Error GrManager::init(GrManagerInitInfo& init)
 	m_impl.reset(m_alloc.newInstance<GrManagerImpl>(this));
 	ANKI_CHECK(m_impl->init(init));
 
+	m_pplinePersistentCache.reset(m_alloc.newInstance<PipelinePersistentCache>(this));
+	ANKI_CHECK(m_pplinePersistentCache->init(
+		init.m_cacheDirectory, init.m_config->getNumber("gr.pipelineCacheThreads")));
+
 	return ErrorCode::NONE;
 }
 
@@ -52,6 +59,11 @@ void GrManager::finish()
 	m_impl->getRenderingThread().syncClientServer();
 }
 
+F64 GrManager::getGpuFrameTime() const
+{
+	return m_impl->getRenderingThread().getGpuFrameTime();
+}
+
 void* GrManager::allocateFrameTransientMemory(PtrSize size, BufferUsageBit usage, TransientMemoryToken& token)
 {
 	void* data = nullptr;
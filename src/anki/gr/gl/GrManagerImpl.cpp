@@ -52,7 +52,7 @@ Error GrManagerImpl::init(GrManagerInitInfo& init)
 	m_thread = m_manager->getAllocator().newInstance<RenderingThread>(m_manager);
 
 	// Start it
-	m_thread->start();
+	m_thread->start(*init.m_config);
 	m_thread->syncClientServer();
 
 	return ErrorCode::NONE;
@@ -9,6 +9,7 @@
 #include <anki/gr/common/Misc.h>
 #include <anki/util/Logger.h>
 #include <anki/util/Hash.h>
+#include <anki/core/Trace.h>
 
 namespace anki
 {
@@ -210,14 +211,49 @@ void PipelineImpl::bind(GlState& state)
 		return;
 	}
 
-	// Set state
-	setVertexState(state);
-	setInputAssemblerState(state);
-	setTessellationState(state);
-	setViewportState(state);
-	setRasterizerState(state);
-	setDepthStencilState(state);
-	setColorState(state);
+	// Set only the sub-states that differ from the bound ones
+	PipelineSubStateBit dirty = m_hashes.diff(state.m_stateHashes);
+	if(!m_tessellation)
+	{
+		dirty &= ~PipelineSubStateBit::TESSELLATION;
+	}
+
+	if(!!(dirty & PipelineSubStateBit::VERTEX))
+	{
+		setVertexState(state);
+	}
+
+	if(!!(dirty & PipelineSubStateBit::INPUT_ASSEMBLER))
+	{
+		setInputAssemblerState(state);
+	}
+
+	if(!!(dirty & PipelineSubStateBit::TESSELLATION))
+	{
+		setTessellationState(state);
+	}
+
+	if(!!(dirty & PipelineSubStateBit::VIEWPORT))
+	{
+		setViewportState(state);
+	}
+
+	if(!!(dirty & PipelineSubStateBit::RASTERIZER))
+	{
+		setRasterizerState(state);
+	}
+
+	if(!!(dirty & PipelineSubStateBit::DEPTH_STENCIL))
+	{
+		setDepthStencilState(state);
+	}
+
+	if(!!(dirty & PipelineSubStateBit::COLOR))
+	{
+		setColorState(state);
+	}
+
+	ANKI_TRACE_INC_COUNTER(GR_PIPELINE_SUB_STATES_SKIPPED, 7 - countBits(U32(dirty)));
 }
 
 void PipelineImpl::initVertexState()
@@ -264,6 +300,18 @@ void PipelineImpl::initVertexState()
 			cache.m_type = GL_UNSIGNED_SHORT;
 			cache.m_normalized = true;
 		}
+		else if(binding.m_format == PixelFormat(ComponentFormat::R16G16B16A16, TransformFormat::SNORM))
+		{
+			cache.m_compCount = 4;
+			cache.m_type = GL_SHORT;
+			cache.m_normalized = true;
+		}
+		else if(binding.m_format == PixelFormat(ComponentFormat::R8G8, TransformFormat::SNORM))
+		{
+			cache.m_compCount = 2;
+			cache.m_type = GL_BYTE;
+			cache.m_normalized = true;
+		}
 		else if(binding.m_format == PixelFormat(ComponentFormat::R10G10B10A2, TransformFormat::SNORM))
 		{
 			cache.m_compCount = 4;
@@ -437,11 +485,6 @@ void PipelineImpl::initColorState()
 
 void PipelineImpl::setVertexState(GlState& state) const
 {
-	if(state.m_stateHashes.m_vertex == m_hashes.m_vertex)
-	{
-		return;
-	}
-
 	state.m_stateHashes.m_vertex = m_hashes.m_vertex;
 
 	for(U i = 0; i < m_in.m_vertex.m_attributeCount; ++i)
@@ -470,32 +513,15 @@ void PipelineImpl::setVertexState(GlState& state) const
 
 void PipelineImpl::setInputAssemblerState(GlState& state) const
 {
-	if(state.m_stateHashes.m_inputAssembler == m_hashes.m_inputAssembler)
-	{
-		return;
-	}
-
 	state.m_stateHashes.m_inputAssembler = m_hashes.m_inputAssembler;
 
 	state.m_topology = m_cache.m_topology;
 
-	if(m_in.m_inputAssembler.m_primitiveRestartEnabled)
-	{
-		glEnable(GL_PRIMITIVE_RESTART);
-	}
-	else
-	{
-		glDisable(GL_PRIMITIVE_RESTART);
-	}
+	state.enableCapability(GL_PRIMITIVE_RESTART, m_in.m_inputAssembler.m_primitiveRestartEnabled);
 }
 
 void PipelineImpl::setTessellationState(GlState& state) const
 {
-	if(!m_tessellation || state.m_stateHashes.m_tessellation == m_hashes.m_tessellation)
-	{
-		return;
-	}
-
 	state.m_stateHashes.m_tessellation = m_hashes.m_tessellation;
 
 	glPatchParameteri(GL_PATCH_VERTICES, m_in.m_tessellation.m_patchControlPointCount);
@@ -503,120 +529,144 @@ void PipelineImpl::setTessellationState(GlState& state) const
 
 void PipelineImpl::setRasterizerState(GlState& state) const
 {
-	if(state.m_stateHashes.m_rasterizer == m_hashes.m_rasterizer)
+	state.m_stateHashes.m_rasterizer = m_hashes.m_rasterizer;
+
+	if(state.m_polygonMode != m_cache.m_fillMode)
 	{
-		return;
+		glPolygonMode(GL_FRONT_AND_BACK, m_cache.m_fillMode);
+		state.m_polygonMode = m_cache.m_fillMode;
+	}
+	else
+	{
+		ANKI_TRACE_INC_COUNTER(GR_RASTERIZER_CALLS_SKIPPED, 1);
 	}
 
-	state.m_stateHashes.m_rasterizer = m_hashes.m_rasterizer;
+	if(state.m_cullFace != m_cache.m_cullMode)
+	{
+		glCullFace(m_cache.m_cullMode);
+		state.m_cullFace = m_cache.m_cullMode;
+	}
+	else
+	{
+		ANKI_TRACE_INC_COUNTER(GR_RASTERIZER_CALLS_SKIPPED, 1);
+	}
 
-	glPolygonMode(GL_FRONT_AND_BACK, m_cache.m_fillMode);
-	glCullFace(m_cache.m_cullMode);
-	glEnable(GL_CULL_FACE);
+	state.enableCapability(GL_CULL_FACE, true);
 }
 
 void PipelineImpl::setDepthStencilState(GlState& state) const
 {
-	if(state.m_stateHashes.m_depthStencil == m_hashes.m_depthStencil)
-	{
-		return;
-	}
-
 	state.m_stateHashes.m_depthStencil = m_hashes.m_depthStencil;
 
 	// Depth
-	glDepthMask(m_in.m_depthStencil.m_depthWriteEnabled);
-	state.m_depthWriteMask = m_in.m_depthStencil.m_depthWriteEnabled;
-
-	if(m_cache.m_depthCompareFunction == GL_ALWAYS && !m_in.m_depthStencil.m_depthWriteEnabled)
+	if(state.m_depthWriteMask != m_in.m_depthStencil.m_depthWriteEnabled)
 	{
-		glDisable(GL_DEPTH_TEST);
+		glDepthMask(m_in.m_depthStencil.m_depthWriteEnabled);
+		state.m_depthWriteMask = m_in.m_depthStencil.m_depthWriteEnabled;
 	}
 	else
 	{
-		glEnable(GL_DEPTH_TEST);
+		ANKI_TRACE_INC_COUNTER(GR_DEPTH_STENCIL_CALLS_SKIPPED, 1);
 	}
 
-	glDepthFunc(m_cache.m_depthCompareFunction);
+	state.enableCapability(GL_DEPTH_TEST,
+		!(m_cache.m_depthCompareFunction == GL_ALWAYS && !m_in.m_depthStencil.m_depthWriteEnabled));
 
-	// Stencil
-	if(m_stencilTestEnabled)
+	if(state.m_depthCompareFunc != m_cache.m_depthCompareFunction)
 	{
-		glEnable(GL_STENCIL_TEST);
+		glDepthFunc(m_cache.m_depthCompareFunction);
+		state.m_depthCompareFunc = m_cache.m_depthCompareFunction;
 	}
 	else
 	{
-		glDisable(GL_STENCIL_TEST);
+		ANKI_TRACE_INC_COUNTER(GR_DEPTH_STENCIL_CALLS_SKIPPED, 1);
 	}
 
-	glStencilOpSeparate(
-		GL_FRONT, m_cache.m_stencilFailOp[0], m_cache.m_stencilPassDepthFailOp[0], m_cache.m_stencilPassDepthPassOp[0]);
-
-	glStencilOpSeparate(
-		GL_BACK, m_cache.m_stencilFailOp[1], m_cache.m_stencilPassDepthFailOp[1], m_cache.m_stencilPassDepthPassOp[1]);
+	// Stencil
+	state.enableCapability(GL_STENCIL_TEST, m_stencilTestEnabled);
 
-	if(state.m_stencilCompareFunc[0] != m_cache.m_stencilCompareFunc[0])
+	static const Array<GLenum, 2> faces = {{GL_FRONT, GL_BACK}};
+	for(U face = 0; face < 2; ++face)
 	{
-		state.m_stencilCompareFunc[0] = m_cache.m_stencilCompareFunc[0];
-		state.m_glStencilFuncSeparateDirtyMask |= 1 << 0;
-	}
+		Array<GLenum, 3>& ops = state.m_stencilOps[face];
+		if(ops[0] != m_cache.m_stencilFailOp[face] || ops[1] != m_cache.m_stencilPassDepthFailOp[face]
+			|| ops[2] != m_cache.m_stencilPassDepthPassOp[face])
+		{
+			glStencilOpSeparate(faces[face],
+				m_cache.m_stencilFailOp[face],
+				m_cache.m_stencilPassDepthFailOp[face],
+				m_cache.m_stencilPassDepthPassOp[face]);
+
+			ops[0] = m_cache.m_stencilFailOp[face];
+			ops[1] = m_cache.m_stencilPassDepthFailOp[face];
+			ops[2] = m_cache.m_stencilPassDepthPassOp[face];
+		}
+		else
+		{
+			ANKI_TRACE_INC_COUNTER(GR_DEPTH_STENCIL_CALLS_SKIPPED, 1);
+		}
 
-	if(state.m_stencilCompareFunc[1] != m_cache.m_stencilCompareFunc[1])
-	{
-		state.m_stencilCompareFunc[1] = m_cache.m_stencilCompareFunc[1];
-		state.m_glStencilFuncSeparateDirtyMask |= 1 << 1;
+		if(state.m_stencilCompareFunc[face] != m_cache.m_stencilCompareFunc[face])
+		{
+			state.m_stencilCompareFunc[face] = m_cache.m_stencilCompareFunc[face];
+			state.m_glStencilFuncSeparateDirtyMask |= 1 << face;
+		}
 	}
 }
 
 void PipelineImpl::setColorState(GlState& state) const
 {
-	if(state.m_stateHashes.m_color == m_hashes.m_color)
-	{
-		return;
-	}
-
 	state.m_stateHashes.m_color = m_hashes.m_color;
 
-	if(m_blendEnabled)
+	state.enableCapability(GL_BLEND, m_blendEnabled);
+
+	for(U i = 0; i < m_in.m_color.m_attachmentCount; ++i)
 	{
-		glEnable(GL_BLEND);
+		const Attachment& att = m_cache.m_attachments[i];
 
-		for(U i = 0; i < m_in.m_color.m_attachmentCount; ++i)
+		if(m_blendEnabled)
 		{
-			const Attachment& att = m_cache.m_attachments[i];
-
-			glBlendFunci(i, att.m_srcBlendMethod, att.m_dstBlendMethod);
-			glBlendEquationi(i, att.m_blendFunction);
-			glColorMaski(i,
-				att.m_channelWriteMask[0],
-				att.m_channelWriteMask[1],
-				att.m_channelWriteMask[2],
-				att.m_channelWriteMask[3]);
+			if(state.m_blendSrcFuncs[i] != att.m_srcBlendMethod || state.m_blendDstFuncs[i] != att.m_dstBlendMethod)
+			{
+				glBlendFunci(i, att.m_srcBlendMethod, att.m_dstBlendMethod);
+				state.m_blendSrcFuncs[i] = att.m_srcBlendMethod;
+				state.m_blendDstFuncs[i] = att.m_dstBlendMethod;
+			}
+			else
+			{
+				ANKI_TRACE_INC_COUNTER(GR_BLEND_CALLS_SKIPPED, 1);
+			}
 
-			state.m_colorWriteMasks[i][0] = att.m_channelWriteMask[0];
-			state.m_colorWriteMasks[i][1] = att.m_channelWriteMask[1];
-			state.m_colorWriteMasks[i][2] = att.m_channelWriteMask[2];
-			state.m_colorWriteMasks[i][3] = att.m_channelWriteMask[3];
+			if(state.m_blendEquations[i] != att.m_blendFunction)
+			{
+				glBlendEquationi(i, att.m_blendFunction);
+				state.m_blendEquations[i] = att.m_blendFunction;
+			}
+			else
+			{
+				ANKI_TRACE_INC_COUNTER(GR_BLEND_CALLS_SKIPPED, 1);
+			}
 		}
-	}
-	else
-	{
-		glDisable(GL_BLEND);
 
-		for(U i = 0; i < m_in.m_color.m_attachmentCount; ++i)
+		Array<Bool, 4>& mask = state.m_colorWriteMasks[i];
+		if(mask[0] != att.m_channelWriteMask[0] || mask[1] != att.m_channelWriteMask[1]
+			|| mask[2] != att.m_channelWriteMask[2]
+			|| mask[3] != att.m_channelWriteMask[3])
 		{
-			const Attachment& att = m_cache.m_attachments[i];
-
 			glColorMaski(i,
 				att.m_channelWriteMask[0],
 				att.m_channelWriteMask[1],
 				att.m_channelWriteMask[2],
 				att.m_channelWriteMask[3]);
 
-			state.m_colorWriteMasks[i][0] = att.m_channelWriteMask[0];
-			state.m_colorWriteMasks[i][1] = att.m_channelWriteMask[1];
-			state.m_colorWriteMasks[i][2] = att.m_channelWriteMask[2];
-			state.m_colorWriteMasks[i][3] = att.m_channelWriteMask[3];
+			mask[0] = att.m_channelWriteMask[0];
+			mask[1] = att.m_channelWriteMask[1];
+			mask[2] = att.m_channelWriteMask[2];
+			mask[3] = att.m_channelWriteMask[3];
+		}
+		else
+		{
+			ANKI_TRACE_INC_COUNTER(GR_BLEND_CALLS_SKIPPED, 1);
 		}
 	}
 }
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <anki/gr/gl/GlObject.h>
+#include <anki/gr/gl/GlState.h>
 #include <anki/gr/Pipeline.h>
 
 namespace anki
@@ -75,17 +76,7 @@ private:
 	} m_cache;
 
 	/// State hashes.
-	class
-	{
-	public:
-		U64 m_vertex = 0;
-		U64 m_inputAssembler = 0;
-		U64 m_tessellation = 0;
-		U64 m_viewport = 0;
-		U64 m_rasterizer = 0;
-		U64 m_depthStencil = 0;
-		U64 m_color = 0;
-	} m_hashes;
+	GlPipelineStateHashes m_hashes;
 
 	/// Attach all the programs
 	ANKI_USE_RESULT Error createGlPipeline();
@@ -10,12 +10,17 @@
 #include <anki/gr/gl/GlState.h>
 #include <anki/gr/gl/TransientMemoryManager.h>
 #include <anki/util/Logger.h>
+#include <anki/util/HighRezTimer.h>
 #include <anki/core/Trace.h>
+#include <anki/misc/ConfigSet.h>
 #include <cstdlib>
 
 namespace anki
 {
 
+/// The nanoseconds that the rendering thread waits on a fence before it checks the queue again.
+static const GLuint64 FENCE_WAIT_SLICE = 1000000;
+
 /// Sync rendering thread command.
 class SyncCommand final : public GlCommand
 {
@@ -64,8 +69,6 @@ public:
 
 RenderingThread::RenderingThread(GrManager* manager)
 	: m_manager(manager)
-	, m_tail(0)
-	, m_head(0)
 	, m_renderingThreadSignal(0)
 	, m_thread("anki_gl")
 {
@@ -81,25 +84,31 @@ void RenderingThread::flushCommandBuffer(CommandBufferPtr cmdb)
 {
 	cmdb->m_impl->makeImmutable();
 
+	if(ANKI_UNLIKELY(!m_queue.tryPush(cmdb)))
 	{
+		// Queue is full. Wait for the server to make some room
 		LockGuard<Mutex> lock(m_mtx);
-
-		// Set commands
-		U64 diff = m_tail - m_head;
-
-		if(diff < m_queue.getSize())
-		{
-			U64 idx = m_tail % m_queue.getSize();
-
-			m_queue[idx] = cmdb;
-			++m_tail;
-		}
-		else
+		m_producersWaiting.fetchAdd(1);
+		while(!m_queue.tryPush(cmdb))
 		{
-			ANKI_LOGW("Rendering queue too small");
+			m_condVar.notifyOne();
+			m_queueFullCondVar.wait(m_mtx);
 		}
+		m_producersWaiting.fetchSub(1);
+	}
 
-		m_condVar.notifyOne(); // Wake the thread
+	wakeServer();
+}
+
+void RenderingThread::wakeServer()
+{
+	// The server sets the flag before re-checking the queue so either it will see the new command buffer or this
+	// thread will see the flag
+	atomicThreadFence();
+	if(m_consumerSleeping.load())
+	{
+		LockGuard<Mutex> lock(m_mtx);
+		m_condVar.notifyOne();
 	}
 }
 
@@ -110,11 +119,13 @@ void RenderingThread::finishCommandBuffer(CommandBufferPtr commands)
 	syncClientServer();
 }
 
-void RenderingThread::start()
+void RenderingThread::start(const ConfigSet& config)
 {
-	ANKI_ASSERT(m_tail == 0 && m_head == 0);
 	m_queue.create(m_manager->getAllocator(), QUEUE_SIZE);
 
+	// The frame that is being recorded needs its own part of the transient memory ring
+	m_framesInFlight = clamp<U32>(config.getNumber("gr.framesInFlight"), 1, MAX_FRAMES_IN_FLIGHT - 1);
+
 	// Swap buffers stuff
 	m_swapBuffersCommands = m_manager->newInstance<CommandBuffer>(CommandBufferInitInfo());
 	m_swapBuffersCommands->m_impl->pushBackNewCommand<SwapBuffersCommand>(this);
@@ -167,17 +178,29 @@ void RenderingThread::prepare()
 
 void RenderingThread::finish()
 {
-	// Iterate the queue and release the refcounts
-	for(U i = 0; i < m_queue.getSize(); i++)
+	// Drain the queue and release the refcounts
+	CommandBufferPtr cmdb;
+	while(m_queue.tryPop(cmdb))
 	{
-		if(m_queue[i].isCreated())
-		{
-			// Fake that it's executed to avoid warnings
-			m_queue[i]->m_impl->makeExecuted();
+		// Fake that it's executed to avoid warnings
+		cmdb->m_impl->makeExecuted();
+	}
+	cmdb.reset(nullptr);
 
-			// Release
-			m_queue[i] = CommandBufferPtr();
+	// Release the fences and unblock the main thread
+	{
+		LockGuard<Mutex> lock(m_frameMtx);
+		for(GLsync& fence : m_fences)
+		{
+			if(fence)
+			{
+				glDeleteSync(fence);
+				fence = 0;
+			}
 		}
+
+		m_framesRetired = MAX_U64 / 2;
+		m_frameCondVar.notifyAll();
 	}
 
 	m_manager->getImplementation().getTransientMemoryManager().destroyRenderThread();
@@ -205,27 +228,45 @@ void RenderingThread::threadLoop()
 	{
 		CommandBufferPtr cmd;
 
+		// While there are frames on the GPU wait on their fences in slices and check the queue in between. The main
+		// thread might be waiting for them
+		while(!m_queue.tryPop(cmd) && m_framesFenced.load() > m_framesRetired)
+		{
+			retireFrame(FENCE_WAIT_SLICE);
+		}
+
 		// Wait for something
+		if(!cmd)
 		{
 			LockGuard<Mutex> lock(m_mtx);
-			while(m_tail == m_head)
+			m_consumerSleeping.store(1);
+			atomicThreadFence();
+			while(!m_queue.tryPop(cmd))
 			{
 				m_condVar.wait(m_mtx);
 			}
+			m_consumerSleeping.store(0);
+		}
 
-			// Check signals
-			if(m_renderingThreadSignal == 1)
-			{
-				// Requested to stop
-				break;
-			}
+		// Some producer might wait for room
+		if(m_producersWaiting.load())
+		{
+			LockGuard<Mutex> lock(m_mtx);
+			m_queueFullCondVar.notifyAll();
+		}
 
-			U64 idx = m_head % m_queue.getSize();
-			// Pop a command
-			cmd = m_queue[idx];
-			m_queue[idx] = CommandBufferPtr(); // Insert empty cmd buffer
+		// Check signals
+		if(m_renderingThreadSignal == 1)
+		{
+			// Requested to stop
+			break;
+		}
 
-			++m_head;
+		// The GPU can't start a frame before its first command
+		if(!m_frameStarted)
+		{
+			m_frameStartTimes[m_framesFenced.load() % MAX_FRAMES_IN_FLIGHT] = HighRezTimer::getCurrentTime();
+			m_frameStarted = true;
 		}
 
 		ANKI_TRACE_START_EVENT(GL_THREAD);
@@ -237,6 +278,8 @@ void RenderingThread::threadLoop()
 			ANKI_LOGE("Error in rendering thread. Aborting");
 			abort();
 		}
+
+		pollFences();
 	}
 
 	finish();
@@ -259,35 +302,88 @@ void RenderingThread::swapBuffersInternal()
 	// Do the swap buffers
 	m_manager->getImplementation().swapBuffers();
 
-	// Notify the main thread that we are done
+	// The main thread doesn't let that happen. It's just for the size of the array
+	while(m_framesFenced.load() - m_framesRetired >= MAX_FRAMES_IN_FLIGHT)
 	{
-		LockGuard<Mutex> lock(m_frameMtx);
-		m_frameWait = false;
-
-		m_frameCondVar.notifyOne();
+		retireFrame(FENCE_WAIT_SLICE);
 	}
 
+	// Fence the frame
+	const U64 frame = m_framesFenced.load();
+	GLsync& fence = m_fences[frame % MAX_FRAMES_IN_FLIGHT];
+	ANKI_ASSERT(fence == 0);
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_framesFenced.store(frame + 1);
+	m_frameStarted = false;
+
 	ANKI_TRACE_STOP_EVENT(SWAP_BUFFERS);
 }
 
+Bool RenderingThread::retireFrame(U64 timeout)
+{
+	// m_framesRetired is only written by this thread so it's safe to read it without the lock
+	ANKI_ASSERT(m_framesFenced.load() > m_framesRetired);
+	GLsync& fence = m_fences[m_framesRetired % MAX_FRAMES_IN_FLIGHT];
+	ANKI_ASSERT(fence);
+
+	const GLenum res = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+	if(res == GL_TIMEOUT_EXPIRED)
+	{
+		return false;
+	}
+
+	if(res == GL_WAIT_FAILED)
+	{
+		ANKI_LOGW("Waiting on a fence failed");
+	}
+
+	glDeleteSync(fence);
+	fence = 0;
+
+	// The GPU worked on the frame from its first command or from the end of the previous frame, whichever came last.
+	// The fences are waited in slices or polled after every command buffer so the end is a bit late at worst
+	const F64 now = HighRezTimer::getCurrentTime();
+	const F64 start = max(m_frameStartTimes[m_framesRetired % MAX_FRAMES_IN_FLIGHT], m_prevRetireTime);
+	m_prevRetireTime = now;
+
+	// Notify the main thread
+	LockGuard<Mutex> lock(m_frameMtx);
+	m_gpuFrameTime = now - start;
+	++m_framesRetired;
+	m_frameCondVar.notifyOne();
+	return true;
+}
+
+void RenderingThread::pollFences()
+{
+	while(m_framesFenced.load() > m_framesRetired && retireFrame(0))
+	{
+	}
+}
+
 void RenderingThread::swapBuffers()
 {
 	ANKI_TRACE_START_EVENT(SWAP_BUFFERS);
-	// Wait for the rendering thread to finish swap buffers...
+
+	flushCommandBuffer(m_swapBuffersCommands);
+	++m_framesSubmitted;
+
+	// The frames that the rendering thread hasn't swapped yet. More than zero means that the threads overlap
+	ANKI_TRACE_INC_COUNTER(GR_FRAMES_AHEAD, m_framesSubmitted - m_framesFenced.load());
+
+	// Throttle. The next frame reuses the transient memory of the frame m_framesInFlight + 1 frames before it. Wait for
+	// the GPU to finish that one
 	{
+		ANKI_TRACE_START_EVENT(GL_THROTTLE);
 		LockGuard<Mutex> lock(m_frameMtx);
-		while(m_frameWait)
+		while(m_framesRetired + m_framesInFlight < m_framesSubmitted)
 		{
 			m_frameCondVar.wait(m_frameMtx);
 		}
-
-		m_frameWait = true;
+		ANKI_TRACE_STOP_EVENT(GL_THROTTLE);
 	}
 
 	m_manager->getImplementation().getTransientMemoryManager().endFrame();
-
-	// ...and then flush a new swap buffers
-	flushCommandBuffer(m_swapBuffersCommands);
 	ANKI_TRACE_STOP_EVENT(SWAP_BUFFERS);
 }
 
@@ -5,16 +5,22 @@
 
 #pragma once
 
+#include <anki/gr/gl/Common.h>
 #include <anki/gr/CommandBuffer.h>
 #include <anki/util/Thread.h>
+#include <anki/util/MpscQueue.h>
 
 namespace anki
 {
 
+// Forward
+class ConfigSet;
+
 /// @addtogroup opengl
 /// @{
 
-/// Command queue. It's essentialy a queue of command buffers waiting for execution and a server
+/// Command queue. It's essentialy a queue of command buffers waiting for execution and a server. The submissions go
+/// through a lock-free queue and the main thread is throttled by fences when it gets too many frames ahead of the GPU.
 class RenderingThread
 {
 	friend class SyncCommand;
@@ -27,12 +33,13 @@ public:
 
 	/// Start the working thread
 	/// @note Don't free the context before calling #stop
-	void start();
+	void start(const ConfigSet& config);
 
 	/// Stop the working thread
 	void stop();
 
-	/// Push a command buffer to the queue for deferred execution
+	/// Push a command buffer to the queue for deferred execution. It's thread-safe and it doesn't lock unless the
+	/// queue is full.
 	void flushCommandBuffer(CommandBufferPtr commands);
 
 	/// Push a command buffer to the queue and wait for it
@@ -50,16 +57,24 @@ public:
 	/// Swap buffers
 	void swapBuffers();
 
+	/// See GrManager::getGpuFrameTime().
+	F64 getGpuFrameTime()
+	{
+		LockGuard<Mutex> lock(m_frameMtx);
+		return m_gpuFrameTime;
+	}
+
 private:
 	WeakPtr<GrManager> m_manager;
 
 	static const U QUEUE_SIZE = 1024 * 2;
-	DynamicArray<CommandBufferPtr> m_queue; ///< Command queue
-	U64 m_tail; ///< Tail of queue
-	U64 m_head; ///< Head of queue. Points to the end
+	MpscQueue<CommandBufferPtr> m_queue; ///< Command queue
+	Atomic<U32, AtomicMemoryOrder::SEQ_CST> m_consumerSleeping = {0}; ///< The thread waits on m_condVar.
+	Atomic<U32, AtomicMemoryOrder::SEQ_CST> m_producersWaiting = {0}; ///< Producers wait on m_queueFullCondVar.
 	U8 m_renderingThreadSignal; ///< Signal to the thread
 	Mutex m_mtx; ///< Wake the thread
 	ConditionVariable m_condVar; ///< To wake up the thread
+	ConditionVariable m_queueFullCondVar; ///< To wake up the producers when the queue was full.
 	Thread m_thread;
 
 	/// @name Swap_buffers_vars
@@ -67,7 +82,17 @@ private:
 	CommandBufferPtr m_swapBuffersCommands;
 	ConditionVariable m_frameCondVar;
 	Mutex m_frameMtx;
-	Bool8 m_frameWait = false;
+	U32 m_framesInFlight = MAX_FRAMES_IN_FLIGHT - 1; ///< How many frames the GPU can have besides the recorded one.
+	U64 m_framesSubmitted = 0; ///< Main thread counter.
+	U64 m_framesRetired = 0; ///< Frames the GPU is done with. Protected by m_frameMtx.
+	Atomic<U64> m_framesFenced = {0}; ///< Rendering thread counter. The main thread reads it for the traces.
+	Array<GLsync, MAX_FRAMES_IN_FLIGHT> m_fences = {};
+
+	/// When the rendering thread executed the first command of the frames that are fenced.
+	Array<F64, MAX_FRAMES_IN_FLIGHT> m_frameStartTimes = {};
+	Bool8 m_frameStarted = false; ///< The frame that will be fenced next has started.
+	F64 m_prevRetireTime = 0.0;
+	F64 m_gpuFrameTime = 0.0; ///< Protected by m_frameMtx.
 	/// @}
 
 	ThreadId m_serverThreadId;
@@ -87,6 +112,17 @@ private:
 	void finish();
 
 	void swapBuffersInternal();
+
+	/// Wake the rendering thread if it sleeps.
+	void wakeServer();
+
+	/// Retire the frame of the oldest fence if the GPU is done with it.
+	/// @param timeout The nanoseconds to wait for the fence.
+	/// @return True if the frame was retired.
+	Bool retireFrame(U64 timeout);
+
+	/// Retire the frames that the GPU has finished without waiting.
+	void pollFences();
 };
 /// @}
 
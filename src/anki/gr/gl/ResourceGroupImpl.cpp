@@ -233,15 +233,15 @@ void ResourceGroupImpl::bind(U slot, const TransientMemoryInfo& transientInfo, G
 	// Bind textures
 	if(m_textureNamesCount)
 	{
-		glBindTextures(MAX_TEXTURE_BINDINGS * slot, m_textureNamesCount, &m_textureNames[0]);
+		state.bindTextures(MAX_TEXTURE_BINDINGS * slot, m_textureNamesCount, &m_textureNames[0]);
 
 		if(m_allSamplersZero)
 		{
-			glBindSamplers(MAX_TEXTURE_BINDINGS * slot, m_textureNamesCount, nullptr);
+			state.bindSamplers(MAX_TEXTURE_BINDINGS * slot, m_textureNamesCount, nullptr);
 		}
 		else
 		{
-			glBindSamplers(MAX_TEXTURE_BINDINGS * slot, m_textureNamesCount, &m_samplerNames[0]);
+			state.bindSamplers(MAX_TEXTURE_BINDINGS * slot, m_textureNamesCount, &m_samplerNames[0]);
 		}
 	}
 
@@ -257,7 +257,7 @@ void ResourceGroupImpl::bind(U slot, const TransientMemoryInfo& transientInfo, G
 
 			if(!token.isUnused())
 			{
-				glBindBufferRange(GL_UNIFORM_BUFFER,
+				state.bindBufferRange(GL_UNIFORM_BUFFER,
 					MAX_UNIFORM_BUFFER_BINDINGS * slot + i,
 					getManager().getImplementation().getTransientMemoryManager().getGlName(token),
 					token.m_offset,
@@ -271,7 +271,7 @@ void ResourceGroupImpl::bind(U slot, const TransientMemoryInfo& transientInfo, G
 		else if(binding.m_name != 0)
 		{
 			// Static
-			glBindBufferRange(GL_UNIFORM_BUFFER,
+			state.bindBufferRange(GL_UNIFORM_BUFFER,
 				MAX_UNIFORM_BUFFER_BINDINGS * slot + i,
 				binding.m_name,
 				binding.m_offset,
@@ -291,7 +291,7 @@ void ResourceGroupImpl::bind(U slot, const TransientMemoryInfo& transientInfo, G
 
 			if(!token.isUnused())
 			{
-				glBindBufferRange(GL_SHADER_STORAGE_BUFFER,
+				state.bindBufferRange(GL_SHADER_STORAGE_BUFFER,
 					MAX_STORAGE_BUFFER_BINDINGS * slot + i,
 					getManager().getImplementation().getTransientMemoryManager().getGlName(token),
 					token.m_offset,
@@ -305,7 +305,7 @@ void ResourceGroupImpl::bind(U slot, const TransientMemoryInfo& transientInfo, G
 		else if(binding.m_name != 0)
 		{
 			// Static
-			glBindBufferRange(GL_SHADER_STORAGE_BUFFER,
+			state.bindBufferRange(GL_SHADER_STORAGE_BUFFER,
 				MAX_STORAGE_BUFFER_BINDINGS * slot + i,
 				binding.m_name,
 				binding.m_offset,
@@ -376,7 +376,7 @@ void ResourceGroupImpl::bind(U slot, const TransientMemoryInfo& transientInfo, G
 	if(m_indexSize > 0)
 	{
 		ANKI_ASSERT(slot == 0 && "Only slot 0 can have index buffers");
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffName);
+		state.bindIndexBuffer(m_indexBuffName);
 		state.m_indexSize = m_indexSize;
 	}
 }
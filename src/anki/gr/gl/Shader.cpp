@@ -7,6 +7,7 @@
 #include <anki/gr/gl/ShaderImpl.h>
 #include <anki/gr/gl/CommandBufferImpl.h>
 #include <anki/gr/GrManager.h>
+#include <anki/gr/common/PipelinePersistentCache.h>
 
 namespace anki
 {
@@ -18,6 +19,11 @@ Shader::Shader(GrManager* manager, U64 hash, GrObjectCache* cache)
 
 Shader::~Shader()
 {
+	PipelinePersistentCache* pcache = getManager().getPipelinePersistentCache();
+	if(pcache && m_impl)
+	{
+		pcache->unregisterShader(*this);
+	}
 }
 
 class ShaderCreateCommand final : public GlCommand
@@ -59,6 +65,12 @@ void Shader::init(ShaderType shaderType, const CString& source)
 
 	m_impl.reset(getAllocator().newInstance<ShaderImpl>(&getManager()));
 
+	PipelinePersistentCache* pcache = getManager().getPipelinePersistentCache();
+	if(pcache)
+	{
+		pcache->registerShader(*this, shaderType, source);
+	}
+
 	CommandBufferPtr cmdb = getManager().newInstance<CommandBuffer>(CommandBufferInitInfo());
 
 	// Copy source to the command buffer
@@ -9,6 +9,7 @@
 #include <anki/util/Functions.h>
 #include <anki/gr/GrManager.h>
 #include <anki/gr/gl/GrManagerImpl.h>
+#include <anki/gr/gl/GlState.h>
 #include <anki/gr/gl/RenderingThread.h>
 #include <anki/gr/CommandBuffer.h>
 #include <anki/gr/gl/CommandBufferImpl.h>
@@ -293,6 +294,8 @@ public:
 			glDeleteTextures(1, &m_tex);
 		}
 
+		state.invalidateResourceBindings();
+
 		return ErrorCode::NONE;
 	}
 };
@@ -323,6 +326,9 @@ void TextureImpl::bind()
 {
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(m_target, m_glName);
+
+	// Unit 0 changed behind the state's back
+	getManager().getImplementation().getState().m_textureUnits[0] = MAX_U32;
 }
 
 void TextureImpl::preInit(const TextureInitInfo& init)
@@ -4,6 +4,8 @@
 // http://www.anki3d.org/LICENSE
 
 #include <anki/gr/GrManager.h>
+#include <anki/gr/common/PipelinePersistentCache.h>
+#include <anki/core/Config.h>
 #include <anki/gr/vulkan/GrManagerImpl.h>
 #include <anki/gr/vulkan/TextureImpl.h>
 #include <anki/gr/Texture.h>
@@ -18,6 +20,7 @@ GrManager::GrManager()
 GrManager::~GrManager()
 {
 	// Destroy in reverse order
+	m_pplinePersistentCache.reset(nullptr);
 	m_impl.reset(nullptr);
 	m_cacheDir.destroy(m_alloc);
 }
@@ -31,6 +34,10 @@ Error GrManager::init(GrManagerInitInfo& init)
 	m_impl.reset(m_alloc.newInstance<GrManagerImpl>(this));
 	ANKI_CHECK(m_impl->init(init));
 
+	m_pplinePersistentCache.reset(m_alloc.newInstance<PipelinePersistentCache>(this));
+	ANKI_CHECK(m_pplinePersistentCache->init(
+		init.m_cacheDirectory, init.m_config->getNumber("gr.pipelineCacheThreads")));
+
 	return ErrorCode::NONE;
 }
 
@@ -48,6 +55,11 @@ void GrManager::finish()
 {
 }
 
+F64 GrManager::getGpuFrameTime() const
+{
+	return m_impl->getGpuFrameTime();
+}
+
 void* GrManager::allocateFrameTransientMemory(PtrSize size, BufferUsageBit usage, TransientMemoryToken& token)
 {
 	void* ptr = nullptr;
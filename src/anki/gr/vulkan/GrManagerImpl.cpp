@@ -12,6 +12,8 @@
 #include <anki/gr/GrObjectCache.h>
 
 #include <anki/core/Config.h>
+#include <anki/util/File.h>
+#include <anki/util/Filesystem.h>
 #include <glslang/Public/ShaderLang.h>
 
 namespace anki
@@ -50,6 +52,16 @@ GrManagerImpl::~GrManagerImpl()
 
 	m_perThread.destroy(getAllocator());
 
+	if(m_timestampCmdbPool)
+	{
+		vkDestroyCommandPool(m_device, m_timestampCmdbPool, nullptr);
+	}
+
+	if(m_timestampPool)
+	{
+		vkDestroyQueryPool(m_device, m_timestampPool, nullptr);
+	}
+
 	if(m_samplerCache)
 	{
 		getAllocator().deleteInstance(m_samplerCache);
@@ -73,6 +85,11 @@ GrManagerImpl::~GrManagerImpl()
 
 	if(m_pplineCache)
 	{
+		if(savePipelineCache())
+		{
+			ANKI_LOGW("Failed to save the pipeline cache");
+		}
+
 		vkDestroyPipelineCache(m_device, m_pplineCache, nullptr);
 	}
 
@@ -118,11 +135,7 @@ Error GrManagerImpl::initInternal(const GrManagerInitInfo& init)
 	vkGetDeviceQueue(m_device, m_queueIdx, 0, &m_queue);
 	ANKI_CHECK(initSwapchain(init));
 
-	{
-		VkPipelineCacheCreateInfo ci = {};
-		ci.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-		vkCreatePipelineCache(m_device, &ci, nullptr, &m_pplineCache);
-	}
+	ANKI_CHECK(initPipelineCache(init));
 
 	ANKI_CHECK(initMemory(*init.m_config));
 	ANKI_CHECK(m_dsetAlloc.init(getAllocator(), m_device));
@@ -138,6 +151,7 @@ Error GrManagerImpl::initInternal(const GrManagerInitInfo& init)
 	m_semaphores.init(getAllocator(), m_device);
 
 	m_queryAlloc.init(getAllocator(), m_device);
+	ANKI_CHECK(initTimestamps());
 
 	m_samplerCache = getAllocator().newInstance<GrObjectCache>(m_manager);
 
@@ -516,6 +530,81 @@ Error GrManagerImpl::initMemory(const ConfigSet& cfg)
 	return ErrorCode::NONE;
 }
 
+static const char* PIPELINE_CACHE_FILENAME = "vk_pipeline_cache.bin";
+
+Error GrManagerImpl::initPipelineCache(const GrManagerInitInfo& init)
+{
+	StringAuto filename(getAllocator());
+	filename.sprintf("%s/%s", &init.m_cacheDirectory[0], PIPELINE_CACHE_FILENAME);
+
+	// Load the blob of the previous run if it was created by the same driver and device
+	DynamicArrayAuto<U8> blob(getAllocator());
+	Bool blobValid = false;
+	if(fileExists(filename.toCString()))
+	{
+		File file;
+		ANKI_CHECK(file.open(filename.toCString(), FileOpenFlag::READ | FileOpenFlag::BINARY));
+
+		const PtrSize headerSize = 4 * sizeof(U32) + VK_UUID_SIZE;
+		const PtrSize size = file.getSize();
+		if(size > headerSize)
+		{
+			blob.create(size);
+			ANKI_CHECK(file.read(&blob[0], size));
+
+			Array<U32, 4> header;
+			memcpy(&header[0], &blob[0], sizeof(header));
+			blobValid = header[0] >= headerSize && header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+				&& header[2] == m_devProps.vendorID
+				&& header[3] == m_devProps.deviceID
+				&& memcmp(&blob[sizeof(header)], &m_devProps.pipelineCacheUUID[0], VK_UUID_SIZE) == 0;
+
+			if(!blobValid)
+			{
+				ANKI_LOGW("Ignoring the pipeline cache of a different device or driver");
+			}
+		}
+	}
+
+	VkPipelineCacheCreateInfo ci = {};
+	ci.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	if(blobValid)
+	{
+		ci.initialDataSize = blob.getSize();
+		ci.pInitialData = &blob[0];
+		ANKI_LOGI("Loading pipeline cache of %u bytes", U(blob.getSize()));
+	}
+
+	ANKI_VK_CHECK(vkCreatePipelineCache(m_device, &ci, nullptr, &m_pplineCache));
+
+	return ErrorCode::NONE;
+}
+
+Error GrManagerImpl::savePipelineCache()
+{
+	ANKI_ASSERT(m_pplineCache);
+
+	size_t size = 0;
+	ANKI_VK_CHECK(vkGetPipelineCacheData(m_device, m_pplineCache, &size, nullptr));
+	if(size == 0)
+	{
+		return ErrorCode::NONE;
+	}
+
+	DynamicArrayAuto<U8> blob(getAllocator());
+	blob.create(size);
+	ANKI_VK_CHECK(vkGetPipelineCacheData(m_device, m_pplineCache, &size, &blob[0]));
+
+	StringAuto filename(getAllocator());
+	filename.sprintf("%s/%s", &m_manager->getCacheDirectory()[0], PIPELINE_CACHE_FILENAME);
+
+	File file;
+	ANKI_CHECK(file.open(filename.toCString(), FileOpenFlag::WRITE | FileOpenFlag::BINARY));
+	ANKI_CHECK(file.write(&blob[0], size));
+
+	return ErrorCode::NONE;
+}
+
 void* GrManagerImpl::allocateCallback(
 	void* userData, size_t size, size_t alignment, VkSystemAllocationScope allocationScope)
 {
@@ -541,6 +630,103 @@ void GrManagerImpl::freeCallback(void* userData, void* ptr)
 	}
 }
 
+Error GrManagerImpl::initTimestamps()
+{
+	if(!m_devProps.limits.timestampComputeAndGraphics)
+	{
+		ANKI_LOGI("Timestamps are not supported. The GPU frame time will not be measured");
+		return ErrorCode::NONE;
+	}
+
+	VkQueryPoolCreateInfo qci = {};
+	qci.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	qci.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	qci.queryCount = MAX_FRAMES_IN_FLIGHT * 2;
+	ANKI_VK_CHECK(vkCreateQueryPool(m_device, &qci, nullptr, &m_timestampPool));
+
+	VkCommandPoolCreateInfo pci = {};
+	pci.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	pci.queueFamilyIndex = m_queueIdx;
+	ANKI_VK_CHECK(vkCreateCommandPool(m_device, &pci, nullptr, &m_timestampCmdbPool));
+
+	VkCommandBufferAllocateInfo aci = {};
+	aci.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	aci.commandPool = m_timestampCmdbPool;
+	aci.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	aci.commandBufferCount = 1;
+
+	// They never change so record them once. They are submitted again while the GPU might still execute them
+	VkCommandBufferBeginInfo begin = {};
+	begin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+
+	for(U f = 0; f < MAX_FRAMES_IN_FLIGHT; ++f)
+	{
+		for(U i = 0; i < 2; ++i)
+		{
+			VkCommandBuffer& cmdb = m_timestampCmdbs[f][i];
+			ANKI_VK_CHECK(vkAllocateCommandBuffers(m_device, &aci, &cmdb));
+			ANKI_VK_CHECK(vkBeginCommandBuffer(cmdb, &begin));
+
+			if(i == 0)
+			{
+				vkCmdResetQueryPool(cmdb, m_timestampPool, f * 2, 2);
+			}
+
+			vkCmdWriteTimestamp(cmdb,
+				(i == 0) ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+				m_timestampPool,
+				f * 2 + i);
+
+			ANKI_VK_CHECK(vkEndCommandBuffer(cmdb));
+		}
+	}
+
+	return ErrorCode::NONE;
+}
+
+void GrManagerImpl::submitTimestamp(PerFrame& frame, U frameIdx)
+{
+	ANKI_ASSERT(m_timestampPool && frame.m_timestampCount < 2);
+
+	VkSubmitInfo submit = {};
+	submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit.commandBufferCount = 1;
+	submit.pCommandBuffers = &m_timestampCmdbs[frameIdx][frame.m_timestampCount];
+	ANKI_VK_CHECKF(vkQueueSubmit(m_queue, 1, &submit, VK_NULL_HANDLE));
+
+	++frame.m_timestampCount;
+}
+
+void GrManagerImpl::readTimestamps(const PerFrame& frame, U frameIdx)
+{
+	if(frame.m_timestampCount < 2)
+	{
+		return;
+	}
+
+	// The last timestamp is submitted after the present fence so it might not be there yet. Don't wait for it
+	Array<U64, 2> timestamps;
+	const VkResult res = vkGetQueryPoolResults(m_device,
+		m_timestampPool,
+		frameIdx * 2,
+		2,
+		sizeof(timestamps),
+		&timestamps[0],
+		sizeof(U64),
+		VK_QUERY_RESULT_64_BIT);
+
+	if(res != VK_SUCCESS)
+	{
+		return;
+	}
+
+	// The GPU worked on the frame from its first submit or from the end of the previous frame, whichever came last
+	const U64 start = max(timestamps[0], m_prevFrameEndTimestamp);
+	m_prevFrameEndTimestamp = timestamps[1];
+	m_gpuFrameTime = F64(timestamps[1] - min(start, timestamps[1])) * m_devProps.limits.timestampPeriod / 1000000000.0;
+}
+
 void GrManagerImpl::beginFrame()
 {
 	PerFrame& frame = m_perFrame[m_frame % MAX_FRAMES_IN_FLIGHT];
@@ -566,6 +752,12 @@ void GrManagerImpl::endFrame()
 
 	PerFrame& frame = m_perFrame[m_frame % MAX_FRAMES_IN_FLIGHT];
 
+	// Close the frame's work
+	if(frame.m_timestampCount == 1)
+	{
+		submitTimestamp(frame, m_frame % MAX_FRAMES_IN_FLIGHT);
+	}
+
 	// Wait for the fence of N-2 frame
 	U waitFrameIdx = (m_frame + 1) % MAX_FRAMES_IN_FLIGHT;
 	PerFrame& waitFrame = m_perFrame[waitFrameIdx];
@@ -574,6 +766,7 @@ void GrManagerImpl::endFrame()
 		waitFrame.m_presentFence->wait();
 	}
 
+	readTimestamps(waitFrame, waitFrameIdx);
 	resetFrame(waitFrame);
 
 	if(!frame.m_renderSemaphore)
@@ -596,6 +789,7 @@ void GrManagerImpl::endFrame()
 	ANKI_VK_CHECKF(res);
 
 	m_transientMem.endFrame();
+	m_dsetAlloc.endFrame();
 
 	// Finalize
 	++m_frame;
@@ -608,6 +802,7 @@ void GrManagerImpl::resetFrame(PerFrame& frame)
 	frame.m_renderSemaphore.reset(nullptr);
 
 	frame.m_cmdbsSubmitted.destroy(getAllocator());
+	frame.m_timestampCount = 0;
 }
 
 GrManagerImpl::PerThread& GrManagerImpl::getPerThreadCache(ThreadId tid)
@@ -695,6 +890,12 @@ void GrManagerImpl::flushCommandBuffer(CommandBufferPtr cmdb, Bool wait)
 
 	frame.m_cmdbsSubmitted.pushBack(getAllocator(), cmdb);
 
+	// The first submit of the frame starts its work
+	if(m_timestampPool && frame.m_timestampCount == 0)
+	{
+		submitTimestamp(frame, m_frame % MAX_FRAMES_IN_FLIGHT);
+	}
+
 	ANKI_TRACE_START_EVENT(VK_QUEUE_SUBMIT);
 	ANKI_VK_CHECKF(vkQueueSubmit(m_queue, 1, &submit, fence->getHandle()));
 	ANKI_TRACE_STOP_EVENT(VK_QUEUE_SUBMIT);
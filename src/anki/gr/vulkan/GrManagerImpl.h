@@ -57,6 +57,12 @@ public:
 
 	void endFrame();
 
+	/// See GrManager::getGpuFrameTime().
+	F64 getGpuFrameTime() const
+	{
+		return m_gpuFrameTime;
+	}
+
 	VkDevice getDevice() const
 	{
 		ANKI_ASSERT(m_device);
@@ -229,6 +235,8 @@ private:
 
 		/// Keep it here for deferred cleanup.
 		List<CommandBufferPtr> m_cmdbsSubmitted;
+
+		U8 m_timestampCount = 0; ///< The timestamps of the frame that were submitted.
 	};
 
 	VkSurfaceKHR m_surface = VK_NULL_HANDLE;
@@ -301,6 +309,16 @@ private:
 
 	GrObjectCache* m_samplerCache = nullptr;
 
+	/// @name GPU_frame_time
+	/// The work of every frame is bracketed by two timestamps. They are read when the frame is done.
+	/// @{
+	VkQueryPool m_timestampPool = VK_NULL_HANDLE; ///< Two timestamps per frame in flight.
+	VkCommandPool m_timestampCmdbPool = VK_NULL_HANDLE;
+	Array2d<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT, 2> m_timestampCmdbs = {};
+	U64 m_prevFrameEndTimestamp = 0;
+	F64 m_gpuFrameTime = 0.0;
+	/// @}
+
 	ANKI_USE_RESULT Error initInternal(const GrManagerInitInfo& init);
 	ANKI_USE_RESULT Error initInstance(const GrManagerInitInfo& init);
 	ANKI_USE_RESULT Error initSurface(const GrManagerInitInfo& init);
@@ -308,6 +326,17 @@ private:
 	ANKI_USE_RESULT Error initSwapchain(const GrManagerInitInfo& init);
 	ANKI_USE_RESULT Error initFramebuffers(const GrManagerInitInfo& init);
 	ANKI_USE_RESULT Error initMemory(const ConfigSet& cfg);
+	ANKI_USE_RESULT Error initPipelineCache(const GrManagerInitInfo& init);
+	ANKI_USE_RESULT Error initTimestamps();
+
+	/// Submit the command buffer that writes the first or the last timestamp of a frame. m_globalMtx should be locked.
+	void submitTimestamp(PerFrame& frame, U frameIdx);
+
+	/// Compute the GPU time of a frame that is done.
+	void readTimestamps(const PerFrame& frame, U frameIdx);
+
+	/// Write the driver's pipeline cache to the cache directory.
+	ANKI_USE_RESULT Error savePipelineCache();
 
 	static void* allocateCallback(
 		void* userData, size_t size, size_t alignment, VkSystemAllocationScope allocationScope);
@@ -4,6 +4,7 @@
 // http://www.anki3d.org/LICENSE
 
 #include <anki/gr/vulkan/ResourceGroupExtra.h>
+#include <anki/util/Hash.h>
 
 namespace anki
 {
@@ -101,70 +102,216 @@ Error DescriptorSetLayoutFactory::getOrCreateLayout(const DescriptorSetLayoutInf
 	return ErrorCode::NONE;
 }
 
+/// The per thread part of DescriptorSetAllocator. It owns a cache and the pools the sets of the cache come from.
+class DescriptorSetAllocator::ThreadCache final : public DescriptorSetCacheInterface
+{
+public:
+	class Set : public DescriptorSetCacheSet
+	{
+	public:
+		VkDescriptorSet m_handle = VK_NULL_HANDLE;
+		U32 m_poolIdx = MAX_U32;
+	};
+
+	class Pool
+	{
+	public:
+		VkDescriptorPool m_handle = VK_NULL_HANDLE;
+		U32 m_setCount = 0;
+	};
+
+	/// The userData of writeSet.
+	class WriteInfo
+	{
+	public:
+		VkWriteDescriptorSet* m_writes;
+		U m_writeCount;
+	};
+
+	static const U SETS_PER_POOL = 128;
+
+	GrAllocator<U8> m_alloc;
+	VkDevice m_dev;
+	DynamicArray<Pool> m_pools;
+	DescriptorSetCache m_cache;
+
+	ThreadCache(GrAllocator<U8> alloc, VkDevice dev)
+		: m_alloc(alloc)
+		, m_dev(dev)
+	{
+		m_cache.init(alloc, this);
+	}
+
+	~ThreadCache()
+	{
+		m_cache.destroy();
+
+		for(Pool& pool : m_pools)
+		{
+			ANKI_ASSERT(pool.m_setCount == 0);
+			vkDestroyDescriptorPool(m_dev, pool.m_handle, nullptr);
+		}
+
+		m_pools.destroy(m_alloc);
+	}
+
+	ANKI_USE_RESULT Error newSet(U64 layout, DescriptorSetCacheSet*& set) override
+	{
+		// Find a pool with free space
+		U poolIdx = 0;
+		while(poolIdx < m_pools.getSize() && m_pools[poolIdx].m_setCount >= SETS_PER_POOL)
+		{
+			++poolIdx;
+		}
+
+		if(poolIdx == m_pools.getSize())
+		{
+			ANKI_CHECK(newPool());
+		}
+
+		Pool& pool = m_pools[poolIdx];
+		VkDescriptorSetLayout vkLayout = reinterpret_cast<VkDescriptorSetLayout>(layout);
+
+		VkDescriptorSetAllocateInfo ci = {};
+		ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		ci.descriptorPool = pool.m_handle;
+		ci.descriptorSetCount = 1;
+		ci.pSetLayouts = &vkLayout;
+
+		VkDescriptorSet handle;
+		ANKI_VK_CHECK(vkAllocateDescriptorSets(m_dev, &ci, &handle));
+		++pool.m_setCount;
+
+		Set* s = m_alloc.newInstance<Set>();
+		s->m_handle = handle;
+		s->m_poolIdx = poolIdx;
+		set = s;
+
+		return ErrorCode::NONE;
+	}
+
+	void deleteSet(DescriptorSetCacheSet* set) override
+	{
+		Set* s = static_cast<Set*>(set);
+		Pool& pool = m_pools[s->m_poolIdx];
+
+		ANKI_ASSERT(pool.m_setCount > 0);
+		--pool.m_setCount;
+		ANKI_VK_CHECKF(vkFreeDescriptorSets(m_dev, pool.m_handle, 1, &s->m_handle));
+
+		m_alloc.deleteInstance(s);
+	}
+
+	void writeSet(DescriptorSetCacheSet* set, void* userData) override
+	{
+		const Set& s = *static_cast<Set*>(set);
+		const WriteInfo& inf = *static_cast<WriteInfo*>(userData);
+
+		for(U i = 0; i < inf.m_writeCount; ++i)
+		{
+			inf.m_writes[i].dstSet = s.m_handle;
+		}
+
+		if(inf.m_writeCount)
+		{
+			vkUpdateDescriptorSets(m_dev, inf.m_writeCount, inf.m_writes, 0, nullptr);
+		}
+	}
+
+	ANKI_USE_RESULT Error newPool()
+	{
+		Array<VkDescriptorPoolSize, 4> pools = {{}};
+		pools[0] = VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_TEXTURE_BINDINGS * SETS_PER_POOL};
+		pools[1] =
+			VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, MAX_UNIFORM_BUFFER_BINDINGS * SETS_PER_POOL};
+		pools[2] =
+			VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, MAX_STORAGE_BUFFER_BINDINGS * SETS_PER_POOL};
+		pools[3] = VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, MAX_IMAGE_BINDINGS * SETS_PER_POOL};
+
+		VkDescriptorPoolCreateInfo ci = {};
+		ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		ci.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+		ci.maxSets = SETS_PER_POOL;
+		ci.poolSizeCount = pools.getSize();
+		ci.pPoolSizes = &pools[0];
+
+		VkDescriptorPool handle;
+		ANKI_VK_CHECK(vkCreateDescriptorPool(m_dev, &ci, nullptr, &handle));
+
+		m_pools.resize(m_alloc, m_pools.getSize() + 1);
+		m_pools.getBack().m_handle = handle;
+		m_pools.getBack().m_setCount = 0;
+
+		return ErrorCode::NONE;
+	}
+};
+
 Error DescriptorSetAllocator::init(GrAllocator<U8> alloc, VkDevice dev)
 {
 	ANKI_ASSERT(dev);
+	m_alloc = alloc;
 	m_dev = dev;
-	ANKI_CHECK(initGlobalDsetPool());
 	m_layoutFactory.init(alloc, dev);
 
+	m_threadCaches.create(m_alloc, THREAD_CACHE_COUNT);
+	for(ThreadCache*& cache : m_threadCaches)
+	{
+		cache = m_alloc.newInstance<ThreadCache>(m_alloc, m_dev);
+	}
+
 	return ErrorCode::NONE;
 }
 
 void DescriptorSetAllocator::destroy()
 {
-	if(m_globalDPool)
+	for(ThreadCache* cache : m_threadCaches)
 	{
-		vkDestroyDescriptorPool(m_dev, m_globalDPool, nullptr);
-		m_globalDPool = VK_NULL_HANDLE;
+		m_alloc.deleteInstance(cache);
 	}
 
+	m_threadCaches.destroy(m_alloc);
+
 	m_layoutFactory.destroy();
 }
 
-Error DescriptorSetAllocator::initGlobalDsetPool()
+Error DescriptorSetAllocator::allocate(const DescriptorSetLayoutInfo& dsinf,
+	DescriptorSetCacheKey& key,
+	VkWriteDescriptorSet* writes,
+	U writeCount,
+	DescriptorSetHandle& out)
 {
-	Array<VkDescriptorPoolSize, 4> pools = {{}};
-	pools[0] =
-		VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_TEXTURE_BINDINGS * MAX_RESOURCE_GROUPS};
-	pools[1] = VkDescriptorPoolSize{
-		VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, MAX_UNIFORM_BUFFER_BINDINGS * MAX_RESOURCE_GROUPS};
-	pools[2] = VkDescriptorPoolSize{
-		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, MAX_STORAGE_BUFFER_BINDINGS * MAX_RESOURCE_GROUPS};
-	pools[3] = VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, MAX_IMAGE_BINDINGS * MAX_RESOURCE_GROUPS};
-
-	VkDescriptorPoolCreateInfo ci = {};
-	ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	ci.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-	ci.maxSets = MAX_RESOURCE_GROUPS;
-	ci.poolSizeCount = pools.getSize();
-	ci.pPoolSizes = &pools[0];
-
-	ANKI_VK_CHECK(vkCreateDescriptorPool(m_dev, &ci, nullptr, &m_globalDPool));
+	VkDescriptorSetLayout layout;
+	ANKI_CHECK(m_layoutFactory.getOrCreateLayout(dsinf, layout));
+	key.m_layout = reinterpret_cast<U64>(layout);
+
+	// Pick the cache of this thread. Threads that end up in the same cache will only contend on its lock
+	const ThreadId tid = Thread::getCurrentThreadId();
+	const U cacheIdx = computeHash(&tid, sizeof(tid)) % THREAD_CACHE_COUNT;
+
+	ThreadCache::WriteInfo writeInfo;
+	writeInfo.m_writes = writes;
+	writeInfo.m_writeCount = writeCount;
+	ANKI_CHECK(m_threadCaches[cacheIdx]->m_cache.acquire(key, &writeInfo, out.m_cacheHandle));
+
+	out.m_handle = static_cast<ThreadCache::Set*>(out.m_cacheHandle.m_set)->m_handle;
+	out.m_threadCacheIdx = cacheIdx;
 
 	return ErrorCode::NONE;
 }
 
-Error DescriptorSetAllocator::allocate(const DescriptorSetLayoutInfo& dsinf, VkDescriptorSet& out)
+void DescriptorSetAllocator::free(DescriptorSetHandle& handle)
 {
-	VkDescriptorSetLayout layout;
-	ANKI_CHECK(m_layoutFactory.getOrCreateLayout(dsinf, layout));
-
-	out = VK_NULL_HANDLE;
-	VkDescriptorSetAllocateInfo ci = {};
-	ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	ci.descriptorPool = m_globalDPool;
-	ci.descriptorSetCount = 1;
-	ci.pSetLayouts = &layout;
+	ANKI_ASSERT(handle.m_threadCacheIdx < THREAD_CACHE_COUNT);
+	m_threadCaches[handle.m_threadCacheIdx]->m_cache.release(handle.m_cacheHandle);
+	handle = DescriptorSetHandle();
+}
 
-	LockGuard<Mutex> lock(m_mtx);
-	if(++m_descriptorSetAllocationCount > MAX_RESOURCE_GROUPS)
+void DescriptorSetAllocator::endFrame()
+{
+	for(ThreadCache* cache : m_threadCaches)
 	{
-		ANKI_LOGE("Exceeded the MAX_RESOURCE_GROUPS");
-		return ErrorCode::OUT_OF_MEMORY;
+		cache->m_cache.endFrame();
 	}
-	ANKI_VK_CHECK(vkAllocateDescriptorSets(m_dev, &ci, &out));
-	return ErrorCode::NONE;
 }
 
 } // end namespace anki
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <anki/gr/vulkan/Common.h>
+#include <anki/gr/common/DescriptorSetCache.h>
 #include <anki/util/HashMap.h>
 
 namespace anki
@@ -100,7 +101,21 @@ private:
 	Mutex m_mtx;
 };
 
-/// Allocator of descriptor sets.
+/// A descriptor set that DescriptorSetAllocator returns.
+class DescriptorSetHandle
+{
+	friend class DescriptorSetAllocator;
+
+public:
+	VkDescriptorSet m_handle = VK_NULL_HANDLE;
+
+private:
+	DescriptorSetCacheHandle m_cacheHandle;
+	U8 m_threadCacheIdx = MAX_U8;
+};
+
+/// Allocator of descriptor sets. The sets are cached by their bindings so identical resource groups share the same set.
+/// Every thread allocates from its own cache and descriptor pools.
 class DescriptorSetAllocator : public NonCopyable
 {
 public:
@@ -110,23 +125,29 @@ public:
 
 	~DescriptorSetAllocator()
 	{
-		ANKI_ASSERT(m_globalDPool == VK_NULL_HANDLE);
+		ANKI_ASSERT(m_threadCaches.getSize() == 0);
 	}
 
 	ANKI_USE_RESULT Error init(GrAllocator<U8> alloc, VkDevice dev);
 
 	void destroy();
 
-	ANKI_USE_RESULT Error allocate(const DescriptorSetLayoutInfo& dsinf, VkDescriptorSet& out);
+	/// Get a set with the given bindings.
+	/// @param dsinf The layout of the set.
+	/// @param key The bindings.
+	/// @param writes The writes to apply if the set is not in the cache. Their dstSet will be overwritten.
+	/// @param writeCount The number of writes.
+	/// @param[out] out The set.
+	ANKI_USE_RESULT Error allocate(const DescriptorSetLayoutInfo& dsinf,
+		DescriptorSetCacheKey& key,
+		VkWriteDescriptorSet* writes,
+		U writeCount,
+		DescriptorSetHandle& out);
 
-	void free(VkDescriptorSet ds)
-	{
-		ANKI_ASSERT(ds);
-		LockGuard<Mutex> lock(m_mtx);
-		ANKI_ASSERT(m_descriptorSetAllocationCount > 0);
-		--m_descriptorSetAllocationCount;
-		ANKI_VK_CHECKF(vkFreeDescriptorSets(m_dev, m_globalDPool, 1, &ds));
-	}
+	void free(DescriptorSetHandle& handle);
+
+	/// Age the cached sets.
+	void endFrame();
 
 	DescriptorSetLayoutFactory& getDescriptorSetLayoutFactory()
 	{
@@ -134,14 +155,15 @@ public:
 	}
 
 private:
+	class ThreadCache;
+
+	static const U THREAD_CACHE_COUNT = 8;
+
+	GrAllocator<U8> m_alloc;
 	VkDevice m_dev = VK_NULL_HANDLE;
-	VkDescriptorPool m_globalDPool = VK_NULL_HANDLE;
-	Mutex m_mtx;
-	U32 m_descriptorSetAllocationCount = 0;
+	DynamicArray<ThreadCache*> m_threadCaches;
 
 	DescriptorSetLayoutFactory m_layoutFactory;
-
-	Error initGlobalDsetPool();
 };
 /// @}
 
@@ -17,7 +17,7 @@ ResourceGroupImpl::~ResourceGroupImpl()
 {
 	if(m_handle)
 	{
-		getGrManagerImpl().getDescriptorSetAllocator().free(m_handle);
+		getGrManagerImpl().getDescriptorSetAllocator().free(m_dsetHandle);
 	}
 
 	m_refs.destroy(getAllocator());
@@ -203,15 +203,7 @@ Error ResourceGroupImpl::init(const ResourceGroupInitInfo& init)
 		m_refs.create(getAllocator(), refCount);
 	}
 
-	// Create DSet
-	//
-	if(needsDSet)
-	{
-		ANKI_CHECK(getGrManagerImpl().getDescriptorSetAllocator().allocate(m_descriptorSetLayoutInfo, m_handle));
-		ANKI_ASSERT(m_bindPoint != VK_PIPELINE_BIND_POINT_MAX_ENUM);
-	}
-
-	// Update
+	// Gather the writes and the key of the DSet
 	//
 	Array<VkDescriptorImageInfo, MAX_TEXTURE_BINDINGS> texes = {{}};
 	Array<VkDescriptorBufferInfo, MAX_UNIFORM_BUFFER_BINDINGS> unis = {{}};
@@ -223,6 +215,7 @@ Error ResourceGroupImpl::init(const ResourceGroupInitInfo& init)
 	Bool hole = false;
 	(void)hole;
 	U count = 0;
+	DescriptorSetCacheKey key;
 
 	// 1st the textures
 	for(U i = 0; i < MAX_TEXTURE_BINDINGS; ++i)
@@ -242,15 +235,20 @@ Error ResourceGroupImpl::init(const ResourceGroupInitInfo& init)
 				inf.sampler = init.m_textures[i].m_sampler->m_impl->m_handle;
 
 				m_refs[refCount++] = init.m_textures[i].m_sampler;
+				key.pushBack(init.m_textures[i].m_sampler->getUuid());
 			}
 			else
 			{
 				inf.sampler = teximpl.m_sampler->m_impl->m_handle;
 				// No need to ref
+				key.pushBack(teximpl.m_sampler->getUuid());
 			}
 
 			inf.imageLayout = teximpl.computeLayout(init.m_textures[i].m_usage, 0);
 
+			key.pushBack(init.m_textures[i].m_texture->getUuid());
+			key.pushBack((U64(init.m_textures[i].m_aspect) << 32) | U64(init.m_textures[i].m_usage));
+
 			++count;
 		}
 		else
@@ -267,7 +265,6 @@ Error ResourceGroupImpl::init(const ResourceGroupInitInfo& init)
 		w.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 		w.dstBinding = 0;
 		w.pImageInfo = &texes[0];
-		w.dstSet = m_handle;
 	}
 
 	// 2nd the uniform buffers
@@ -288,6 +285,9 @@ Error ResourceGroupImpl::init(const ResourceGroupInitInfo& init)
 			}
 
 			m_refs[refCount++] = init.m_uniformBuffers[i].m_buffer;
+			key.pushBack(init.m_uniformBuffers[i].m_buffer->getUuid());
+			key.pushBack(inf.offset);
+			key.pushBack(inf.range);
 
 			++count;
 		}
@@ -300,6 +300,11 @@ Error ResourceGroupImpl::init(const ResourceGroupInitInfo& init)
 
 			m_dynamicBuffersMask.set(i);
 
+			// The offset is dynamic so all the transient bindings look the same
+			key.pushBack(MAX_U64);
+			key.pushBack(0);
+			key.pushBack(VK_WHOLE_SIZE);
+
 			++count;
 		}
 		else
@@ -316,7 +321,6 @@ Error ResourceGroupImpl::init(const ResourceGroupInitInfo& init)
 		w.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		w.dstBinding = MAX_TEXTURE_BINDINGS;
 		w.pBufferInfo = &unis[0];
-		w.dstSet = m_handle;
 	}
 
 	m_uniBindingCount = count;
@@ -339,6 +343,9 @@ Error ResourceGroupImpl::init(const ResourceGroupInitInfo& init)
 			}
 
 			m_refs[refCount++] = init.m_storageBuffers[i].m_buffer;
+			key.pushBack(init.m_storageBuffers[i].m_buffer->getUuid());
+			key.pushBack(inf.offset);
+			key.pushBack(inf.range);
 			++count;
 		}
 		else if(init.m_storageBuffers[i].m_uploadedMemory)
@@ -349,6 +356,10 @@ Error ResourceGroupImpl::init(const ResourceGroupInitInfo& init)
 			inf.range = VK_WHOLE_SIZE;
 
 			m_dynamicBuffersMask.set(MAX_UNIFORM_BUFFER_BINDINGS + i);
+
+			key.pushBack(MAX_U64);
+			key.pushBack(0);
+			key.pushBack(VK_WHOLE_SIZE);
 			++count;
 		}
 		else
@@ -365,7 +376,6 @@ Error ResourceGroupImpl::init(const ResourceGroupInitInfo& init)
 		w.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
 		w.dstBinding = MAX_TEXTURE_BINDINGS + MAX_UNIFORM_BUFFER_BINDINGS;
 		w.pBufferInfo = &storages[0];
-		w.dstSet = m_handle;
 	}
 
 	m_storageBindingCount = count;
@@ -386,6 +396,8 @@ Error ResourceGroupImpl::init(const ResourceGroupInitInfo& init)
 			inf.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
 			m_refs[refCount++] = binding.m_texture;
+			key.pushBack(binding.m_texture->getUuid());
+			key.pushBack(binding.m_level);
 			++count;
 		}
 		else
@@ -402,13 +414,16 @@ Error ResourceGroupImpl::init(const ResourceGroupInitInfo& init)
 		w.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
 		w.dstBinding = MAX_TEXTURE_BINDINGS + MAX_UNIFORM_BUFFER_BINDINGS + MAX_STORAGE_BUFFER_BINDINGS;
 		w.pImageInfo = &images[0];
-		w.dstSet = m_handle;
 	}
 
-	// Check if it was created. It's not created only if the rc group contains only vertex info.
-	if(m_handle)
+	// Get the DSet. It's not created only if the rc group contains only vertex info. If an identical DSet exists the
+	// writes will be skipped
+	if(needsDSet)
 	{
-		vkUpdateDescriptorSets(getDevice(), writeCount, &write[0], 0, nullptr);
+		ANKI_CHECK(getGrManagerImpl().getDescriptorSetAllocator().allocate(
+			m_descriptorSetLayoutInfo, key, &write[0], writeCount, m_dsetHandle));
+		m_handle = m_dsetHandle.m_handle;
+		ANKI_ASSERT(m_bindPoint != VK_PIPELINE_BIND_POINT_MAX_ENUM);
 	}
 
 	// Vertex stuff
@@ -66,6 +66,8 @@ private:
 	U8 m_storageBindingCount = 0;
 	BitSet<MAX_UNIFORM_BUFFER_BINDINGS + MAX_STORAGE_BUFFER_BINDINGS> m_dynamicBuffersMask = {false};
 
+	DescriptorSetHandle m_dsetHandle;
+
 	// Index info
 	VkBuffer m_indexBuffHandle = VK_NULL_HANDLE;
 	U32 m_indexBufferOffset = MAX_U32;
@@ -5,6 +5,8 @@
 
 #include <anki/gr/Shader.h>
 #include <anki/gr/vulkan/ShaderImpl.h>
+#include <anki/gr/GrManager.h>
+#include <anki/gr/common/PipelinePersistentCache.h>
 
 namespace anki
 {
@@ -16,6 +18,11 @@ Shader::Shader(GrManager* manager, U64 hash, GrObjectCache* cache)
 
 Shader::~Shader()
 {
+	PipelinePersistentCache* pcache = getManager().getPipelinePersistentCache();
+	if(pcache && m_impl)
+	{
+		pcache->unregisterShader(*this);
+	}
 }
 
 void Shader::init(ShaderType shaderType, const CString& source)
@@ -24,6 +31,12 @@ void Shader::init(ShaderType shaderType, const CString& source)
 
 	m_impl.reset(getAllocator().newInstance<ShaderImpl>(&getManager()));
 
+	PipelinePersistentCache* pcache = getManager().getPipelinePersistentCache();
+	if(pcache)
+	{
+		pcache->registerShader(*this, shaderType, source);
+	}
+
 	if(m_impl->init(shaderType, source))
 	{
 		ANKI_LOGF("Cannot recover");
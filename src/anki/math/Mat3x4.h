@@ -159,7 +159,7 @@ public:
 		}
 		else
 		{
-			setRotationPart(rot * scale);
+			Base::setRotationPart(rot * scale);
 		}
 
 		Base::setTranslationPart(transl);
@@ -89,9 +89,39 @@ Error PhysicsBody::create(const PhysicsBodyInitInfo& init)
 
 void PhysicsBody::setTransform(const Transform& trf)
 {
-	Mat4 mat(trf);
-	mat.transpose();
-	NewtonBodySetMatrix(m_body, &mat(0, 0));
+	m_trf = trf;
+	m_updated = true;
+
+	if(m_world->isUpdating())
+	{
+		// Newton will get it in the next sync
+		m_trfSet = true;
+	}
+	else
+	{
+		Mat4 mat(trf);
+		mat.transpose();
+		NewtonBodySetMatrix(m_body, &mat(0, 0));
+	}
+}
+
+void PhysicsBody::syncResults()
+{
+	if(m_trfSet)
+	{
+		// The transform that was set overrides the step
+		Mat4 mat(m_trf);
+		mat.transpose();
+		NewtonBodySetMatrix(m_body, &mat(0, 0));
+		m_trfSet = false;
+	}
+	else if(m_stepUpdated)
+	{
+		m_trf = m_stepTrf;
+		m_updated = true;
+	}
+
+	m_stepUpdated = false;
 }
 
 void PhysicsBody::onTransformCallback(const NewtonBody* const body, const dFloat* const matrix, int threadIndex)
@@ -107,8 +137,8 @@ void PhysicsBody::onTransformCallback(const NewtonBody* const body, const dFloat
 	memcpy(&trf, matrix, sizeof(Mat4));
 	trf.transpose();
 	trf(3, 3) = 0.0;
-	self->m_trf = Transform(trf);
-	self->m_updated = true;
+	self->m_stepTrf = Transform(trf);
+	self->m_stepUpdated = true;
 }
 
 void PhysicsBody::applyGravityForce(const NewtonBody* body, dFloat timestep, int threadIndex)
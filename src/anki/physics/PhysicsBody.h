@@ -35,6 +35,7 @@ public:
 
 	ANKI_USE_RESULT Error create(const PhysicsBodyInitInfo& init);
 
+	/// Get the transform of the last step that was synced.
 	const Transform& getTransform(Bool& updated)
 	{
 		updated = m_updated;
@@ -42,6 +43,7 @@ public:
 		return m_trf;
 	}
 
+	/// Set the transform. It's visible immediately and Newton gets it before the next step.
 	void setTransform(const Transform& trf);
 
 	F32 getFriction() const
@@ -69,6 +71,9 @@ public:
 		m_materialBits = bits;
 	}
 
+anki_internal:
+	void syncResults() override;
+
 private:
 	NewtonBody* m_body = nullptr;
 	void* m_sceneCollisionProxy = nullptr;
@@ -78,6 +83,14 @@ private:
 	PhysicsMaterialBit m_materialBits = PhysicsMaterialBit::ALL;
 	Bool8 m_updated = true;
 
+	/// @name Written by the step
+	/// @{
+	Transform m_stepTrf = Transform::getIdentity();
+	Bool8 m_stepUpdated = false;
+	/// @}
+
+	Bool8 m_trfSet = false; ///< setTransform() was called since the last sync.
+
 	/// Newton callback.
 	static void onTransformCallback(const NewtonBody* const body, const dFloat* const matrix, int threadIndex);
 
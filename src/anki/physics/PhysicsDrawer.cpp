@@ -17,6 +17,9 @@ struct CallbackData
 
 void PhysicsDrawer::drawWorld(const PhysicsWorld& world)
 {
+	// The bodies can't be read while the step is running
+	world.waitUpdateToFinish();
+
 	NewtonWorld* nworld = world.getNewtonWorld();
 	for(NewtonBody* body = NewtonWorldGetFirstBody(nworld); body != nullptr;
 		body = NewtonWorldGetNextBody(nworld, body))
@@ -59,6 +59,13 @@ public:
 		return m_refcount;
 	}
 
+anki_internal:
+	/// Called by PhysicsWorld::waitUpdate() when the step is not running. Publish the results of the last step and
+	/// apply the inputs that were set while it was running.
+	virtual void syncResults()
+	{
+	}
+
 protected:
 	PhysicsWorld* m_world = nullptr;
 
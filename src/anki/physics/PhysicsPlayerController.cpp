@@ -342,13 +342,14 @@ Vec4 PhysicsPlayerController::calculateDesiredVelocity(
 
 void PhysicsPlayerController::calculateVelocity(F32 dt)
 {
-	Vec4 omega(calculateDesiredOmega(m_forwardDir, dt));
-	Vec4 veloc(calculateDesiredVelocity(m_forwardSpeed, m_strafeSpeed, m_jumpSpeed, m_gravity, dt));
+	const Input& in = m_stepInput;
+	Vec4 omega(calculateDesiredOmega(in.m_forwardDir, dt));
+	Vec4 veloc(calculateDesiredVelocity(in.m_forwardSpeed, in.m_strafeSpeed, in.m_jumpSpeed, m_gravity, dt));
 
 	NewtonBodySetOmega(m_body, &omega[0]);
 	NewtonBodySetVelocity(m_body, &veloc[0]);
 
-	if(m_jumpSpeed > 0.0)
+	if(in.m_jumpSpeed > 0.0)
 	{
 		m_isJumping = true;
 	}
@@ -625,13 +626,30 @@ void PhysicsPlayerController::postUpdateKernelCallback(NewtonWorld* const world,
 	x->postUpdate(x->m_world->getDeltaTime(), threadIndex);
 }
 
-void PhysicsPlayerController::moveToPosition(const Vec4& position)
+void PhysicsPlayerController::syncResults()
 {
-	Mat4 trf;
-	NewtonBodyGetMatrix(m_body, &trf[0]);
-	trf.transpose();
-	trf.setTranslationPart(position.xyz1());
-	NewtonBodySetMatrix(m_body, &trf[0]);
+	if(m_stepUpdated)
+	{
+		m_trf = m_stepTrf;
+		m_updated = true;
+		m_stepUpdated = false;
+	}
+
+	m_stepInput = m_input;
+
+	if(m_moveToPosition)
+	{
+		Mat4 trf;
+		NewtonBodyGetMatrix(m_body, &trf[0]);
+		trf.transpose();
+		trf.setTranslationPart(m_newPosition.xyz1());
+		trf.transpose();
+		NewtonBodySetMatrix(m_body, &trf[0]);
+
+		m_trf.setOrigin(m_newPosition.xyz0());
+		m_updated = true;
+		m_moveToPosition = false;
+	}
 }
 
 void PhysicsPlayerController::onTransformCallback(
@@ -656,8 +674,8 @@ void PhysicsPlayerController::onTransform(Mat4 trf)
 		m_prevTrf = trf;
 		trf.transpose();
 
-		m_trf = Transform(trf);
-		m_updated = true;
+		m_stepTrf = Transform(trf);
+		m_stepUpdated = true;
 	}
 }
 
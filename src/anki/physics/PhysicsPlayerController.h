@@ -38,17 +38,23 @@ public:
 
 	ANKI_USE_RESULT Error create(const PhysicsPlayerControllerInitInfo& init);
 
-	// Update the state machine
+	/// Update the state machine. The step gets it after the next sync.
 	void setVelocity(F32 forwardSpeed, F32 strafeSpeed, F32 jumpSpeed, const Vec4& forwardDir)
 	{
-		m_forwardSpeed = forwardSpeed;
-		m_strafeSpeed = strafeSpeed;
-		m_jumpSpeed = jumpSpeed;
-		m_forwardDir = forwardDir;
+		m_input.m_forwardSpeed = forwardSpeed;
+		m_input.m_strafeSpeed = strafeSpeed;
+		m_input.m_jumpSpeed = jumpSpeed;
+		m_input.m_forwardDir = forwardDir;
 	}
 
-	void moveToPosition(const Vec4& position);
+	/// Teleport. It's applied in the next sync.
+	void moveToPosition(const Vec4& position)
+	{
+		m_newPosition = position;
+		m_moveToPosition = true;
+	}
 
+	/// Get the transform of the last step that was synced.
 	const Transform& getTransform(Bool& updated)
 	{
 		updated = m_updated;
@@ -60,6 +66,8 @@ anki_internal:
 	/// Called by Newton thread to update the controller.
 	static void postUpdateKernelCallback(NewtonWorld* const world, void* const context, int threadIndex);
 
+	void syncResults() override;
+
 private:
 	Vec4 m_upDir;
 	Vec4 m_frontDir;
@@ -78,17 +86,29 @@ private:
 	NewtonCollision* m_supportShape;
 	NewtonCollision* m_upperBodyShape;
 
+	/// The input of the state machine.
+	class Input
+	{
+	public:
+		F32 m_forwardSpeed = 0.0;
+		F32 m_strafeSpeed = 0.0;
+		F32 m_jumpSpeed = 0.0;
+		Vec4 m_forwardDir = Vec4(0.0, 0.0, -1.0, 0.0);
+	};
+
 	// State
-	F32 m_forwardSpeed = 0.0;
-	F32 m_strafeSpeed = 0.0;
-	F32 m_jumpSpeed = 0.0;
-	Vec4 m_forwardDir = Vec4(0.0, 0.0, -1.0, 0.0);
+	Input m_input; ///< What the user set.
+	Input m_stepInput; ///< What the step uses. It's copied from m_input in the sync.
 	Vec4 m_gravity;
+	Vec4 m_newPosition = Vec4(0.0);
+	Bool8 m_moveToPosition = false;
 
 	// Motion state
 	Bool8 m_updated = true;
 	Transform m_trf = {Transform::getIdentity()};
 	Mat4 m_prevTrf = {Mat4::getIdentity()};
+	Transform m_stepTrf = {Transform::getIdentity()}; ///< Written by the step.
+	Bool8 m_stepUpdated = false;
 
 	static constexpr F32 MIN_RESTRAINING_DISTANCE = 1.0e-2;
 	static constexpr U DESCRETE_MOTION_STEPS = 8;
@@ -7,6 +7,8 @@
 #include <anki/physics/PhysicsPlayerController.h>
 #include <anki/physics/PhysicsCollisionShape.h>
 #include <anki/physics/PhysicsBody.h>
+#include <anki/misc/ConfigSet.h>
+#include <anki/util/ThreadHive.h>
 
 namespace anki
 {
@@ -30,6 +32,11 @@ PhysicsWorld::PhysicsWorld()
 
 PhysicsWorld::~PhysicsWorld()
 {
+	if(m_world)
+	{
+		waitUpdateToFinish();
+	}
+
 	cleanupMarkedForDeletion();
 
 	if(m_sceneBody)
@@ -53,7 +60,7 @@ PhysicsWorld::~PhysicsWorld()
 	gAlloc = nullptr;
 }
 
-Error PhysicsWorld::create(AllocAlignedCallback allocCb, void* allocCbData)
+Error PhysicsWorld::create(AllocAlignedCallback allocCb, void* allocCbData, const ConfigSet& config)
 {
 	Error err = ErrorCode::NONE;
 
@@ -74,6 +81,9 @@ Error PhysicsWorld::create(AllocAlignedCallback allocCb, void* allocCbData)
 	// Set the simplified solver mode (faster but less accurate)
 	NewtonSetSolverModel(m_world, 1);
 
+	// Set the worker threads of the step
+	NewtonSetThreadsCount(m_world, max<I32>(config.getNumber("physics.threadCount"), 1));
+
 	// Create scene collision
 	m_sceneCollision = NewtonCreateSceneCollision(m_world, 0);
 	Mat4 trf = Mat4::getIdentity();
@@ -99,20 +109,62 @@ Error PhysicsWorld::create(AllocAlignedCallback allocCb, void* allocCbData)
 
 Error PhysicsWorld::updateAsync(F32 dt)
 {
+	ANKI_ASSERT(!m_updating && "Forgot to wait the previous update");
 	m_dt = dt;
 
 	// Do cleanup of marked for deletion
 	cleanupMarkedForDeletion();
 
 	// Update
+	LockGuard<Mutex> lock(m_updateMtx);
+	m_updating = true;
+	m_stepRunning = true;
 	NewtonUpdateAsync(m_world, dt);
 
 	return ErrorCode::NONE;
 }
 
+void PhysicsWorld::waitUpdateToFinish() const
+{
+	LockGuard<Mutex> lock(m_updateMtx);
+	if(m_stepRunning)
+	{
+		NewtonWaitForUpdateToFinish(m_world);
+		m_stepRunning = false;
+	}
+}
+
 void PhysicsWorld::waitUpdate()
 {
-	NewtonWaitForUpdateToFinish(m_world);
+	waitUpdateToFinish();
+
+	LockGuard<Mutex> lock(m_mtx);
+	for(PhysicsObject* obj : m_syncObjects)
+	{
+		obj->syncResults();
+	}
+
+	// Only now the inputs can go to Newton directly. A query that waited for the step in between doesn't end the
+	// update or the step results would overwrite the inputs that were set after it
+	LockGuard<Mutex> lock2(m_updateMtx);
+	m_updating = false;
+}
+
+/// Remove an object from a list of objects.
+template<typename T>
+static void removeObject(HeapAllocator<U8> alloc, List<T*>& list, PhysicsObject* obj)
+{
+	auto it = list.getBegin();
+	for(; it != list.getEnd(); ++it)
+	{
+		if(*it == obj)
+		{
+			break;
+		}
+	}
+
+	ANKI_ASSERT(it != list.getEnd());
+	list.erase(alloc, it);
 }
 
 void PhysicsWorld::cleanupMarkedForDeletion()
@@ -127,21 +179,15 @@ void PhysicsWorld::cleanupMarkedForDeletion()
 		// Remove from objects marked for deletion
 		m_forDeletion.erase(m_alloc, it);
 
-		// Remove from player controllers
+		// Remove from player controllers and the objects that sync
 		if(obj->getType() == PhysicsObjectType::PLAYER_CONTROLLER)
 		{
-			auto it2 = m_playerControllers.getBegin();
-			for(; it2 != m_playerControllers.getEnd(); ++it2)
-			{
-				PhysicsObject* obj2 = *it2;
-				if(obj2 == obj)
-				{
-					break;
-				}
-			}
-
-			ANKI_ASSERT(it2 != m_playerControllers.getEnd());
-			m_playerControllers.erase(m_alloc, it2);
+			removeObject(m_alloc, m_playerControllers, obj);
+		}
+
+		if(obj->getType() == PhysicsObjectType::PLAYER_CONTROLLER || obj->getType() == PhysicsObjectType::BODY)
+		{
+			removeObject(m_alloc, m_syncObjects, obj);
 		}
 
 		// Finaly, delete it
@@ -159,11 +205,187 @@ void PhysicsWorld::postUpdate(F32 dt)
 
 void PhysicsWorld::registerObject(PhysicsObject* ptr)
 {
+	LockGuard<Mutex> lock(m_mtx);
+
 	if(ptr->getType() == PhysicsObjectType::PLAYER_CONTROLLER)
 	{
-		LockGuard<Mutex> lock(m_mtx);
 		m_playerControllers.pushBack(m_alloc, static_cast<PhysicsPlayerController*>(ptr));
 	}
+
+	if(ptr->getType() == PhysicsObjectType::PLAYER_CONTROLLER || ptr->getType() == PhysicsObjectType::BODY)
+	{
+		m_syncObjects.pushBack(m_alloc, ptr);
+	}
+}
+
+/// A range of queries to run in a thread of the hive.
+class PhysicsWorld::QueryTask
+{
+public:
+	const PhysicsWorld* m_world ANKI_DBG_NULLIFY_PTR;
+	const PhysicsRay* m_rays = nullptr;
+	const PhysicsSweep* m_sweeps = nullptr;
+	PhysicsHit* m_hits ANKI_DBG_NULLIFY_PTR;
+	U32 m_begin;
+	U32 m_end;
+	I32 m_newtonThread; ///< Newton needs a different thread index for every concurrent query.
+};
+
+/// Keeps the closest hit of a query.
+class QueryFilter
+{
+public:
+	PhysicsHit* m_hit;
+	PhysicsMaterialBit m_materials;
+
+	static dFloat filterCallback(const NewtonBody* const body,
+		const NewtonCollision* const shapeHit,
+		const dFloat* const hitContact,
+		const dFloat* const hitNormal,
+		dLong collisionId,
+		void* const userData,
+		dFloat intersectParam)
+	{
+		QueryFilter& filter = *static_cast<QueryFilter*>(userData);
+		PhysicsHit& hit = *filter.m_hit;
+
+		if(intersectParam < hit.m_fraction)
+		{
+			hit.m_position = Vec4(hitContact[0], hitContact[1], hitContact[2], 0.0);
+			hit.m_normal = Vec4(hitNormal[0], hitNormal[1], hitNormal[2], 0.0);
+			hit.m_fraction = intersectParam;
+			hit.m_object = static_cast<PhysicsObject*>(NewtonBodyGetUserData(body));
+			hit.m_hit = true;
+		}
+
+		// Clip the rest of the query to the closest hit
+		return intersectParam;
+	}
+
+	static unsigned prefilterCallback(
+		const NewtonBody* const body, const NewtonCollision* const collision, void* const userData)
+	{
+		const QueryFilter& filter = *static_cast<const QueryFilter*>(userData);
+
+		// Only the scene collision has no user data
+		const PhysicsMaterialBit material = (NewtonBodyGetUserData(body)) ? PhysicsMaterialBit::DYNAMIC_GEOMETRY
+																		   : PhysicsMaterialBit::STATIC_GEOMETRY;
+
+		return (filter.m_materials & material) != PhysicsMaterialBit::NONE;
+	}
+};
+
+void PhysicsWorld::queryCallback(void* arg, U32 threadId, ThreadHive& hive)
+{
+	runQueryTask(*static_cast<const QueryTask*>(arg));
+}
+
+void PhysicsWorld::runQueryTask(const QueryTask& task)
+{
+	NewtonWorld* world = task.m_world->m_world;
+
+	for(U32 i = task.m_begin; i < task.m_end; ++i)
+	{
+		PhysicsHit& hit = task.m_hits[i];
+		hit = PhysicsHit();
+
+		QueryFilter filter;
+		filter.m_hit = &hit;
+
+		if(task.m_rays)
+		{
+			const PhysicsRay& ray = task.m_rays[i];
+			filter.m_materials = ray.m_materials;
+
+			NewtonWorldRayCast(world,
+				&ray.m_from[0],
+				&ray.m_to[0],
+				QueryFilter::filterCallback,
+				&filter,
+				QueryFilter::prefilterCallback,
+				task.m_newtonThread);
+		}
+		else
+		{
+			const PhysicsSweep& sweep = task.m_sweeps[i];
+			ANKI_ASSERT(sweep.m_shape);
+			filter.m_materials = sweep.m_materials;
+
+			Mat4 from = toNewton(Mat4(sweep.m_from));
+			NewtonWorldConvexRayCast(world,
+				sweep.m_shape->getNewtonShape(),
+				&from(0, 0),
+				&sweep.m_to[0],
+				QueryFilter::filterCallback,
+				&filter,
+				QueryFilter::prefilterCallback,
+				task.m_newtonThread);
+		}
+	}
+}
+
+void PhysicsWorld::runQueries(
+	const PhysicsRay* rays, const PhysicsSweep* sweeps, PhysicsHit* hits, U32 count, ThreadHive* hive) const
+{
+	ANKI_ASSERT(hits);
+	if(count == 0)
+	{
+		return;
+	}
+
+	// Newton can't query while it's stepping
+	waitUpdateToFinish();
+
+	// Newton has scratch memory per thread so there can't be more tasks than its threads
+	const U32 MIN_QUERIES_PER_TASK = 64;
+	U32 taskCount = 1;
+	if(hive)
+	{
+		taskCount = min<U32>(hive->getThreadCount(), NewtonGetThreadsCount(m_world));
+		taskCount = min<U32>(taskCount, ThreadHive::MAX_THREADS);
+		taskCount = max<U32>(min<U32>(taskCount, count / MIN_QUERIES_PER_TASK), 1);
+	}
+
+	const U32 taskSize = (count + taskCount - 1) / taskCount;
+
+	Array<QueryTask, ThreadHive::MAX_THREADS> tasks;
+	Array<ThreadHiveTask, ThreadHive::MAX_THREADS> hiveTasks;
+	for(U32 i = 0; i < taskCount; ++i)
+	{
+		QueryTask& task = tasks[i];
+		task.m_world = this;
+		task.m_rays = rays;
+		task.m_sweeps = sweeps;
+		task.m_hits = hits;
+		task.m_begin = min(i * taskSize, count);
+		task.m_end = min(task.m_begin + taskSize, count);
+		task.m_newtonThread = i;
+
+		hiveTasks[i].m_callback = queryCallback;
+		hiveTasks[i].m_argument = &task;
+	}
+
+	if(taskCount == 1)
+	{
+		runQueryTask(tasks[0]);
+	}
+	else
+	{
+		hive->submitTasks(&hiveTasks[0], taskCount);
+		hive->waitAllTasks();
+	}
+}
+
+void PhysicsWorld::castRays(const PhysicsRay* rays, PhysicsHit* hits, U32 count, ThreadHive* hive) const
+{
+	ANKI_ASSERT(rays);
+	runQueries(rays, nullptr, hits, count, hive);
+}
+
+void PhysicsWorld::sweep(const PhysicsSweep* sweeps, PhysicsHit* hits, U32 count, ThreadHive* hive) const
+{
+	ANKI_ASSERT(sweeps);
+	runQueries(nullptr, sweeps, hits, count, hive);
 }
 
 void PhysicsWorld::onContactCallback(const NewtonJoint* contactJoint, F32 timestep, int threadIndex)
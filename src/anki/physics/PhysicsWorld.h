@@ -11,27 +11,87 @@
 namespace anki
 {
 
+// Forward
+class ConfigSet;
+class ThreadHive;
+
 /// @addtogroup physics
 /// @{
 
+/// A ray for PhysicsWorld::castRays().
+class PhysicsRay
+{
+public:
+	Vec4 m_from = Vec4(0.0);
+	Vec4 m_to = Vec4(0.0);
+	PhysicsMaterialBit m_materials = PhysicsMaterialBit::ALL; ///< What it can hit.
+};
+
+/// A convex sweep for PhysicsWorld::sweep().
+class PhysicsSweep
+{
+public:
+	const PhysicsCollisionShape* m_shape = nullptr; ///< A convex shape.
+	Transform m_from = Transform::getIdentity();
+	Vec4 m_to = Vec4(0.0); ///< Where the origin of the shape goes.
+	PhysicsMaterialBit m_materials = PhysicsMaterialBit::ALL; ///< What it can hit.
+};
+
+/// The closest hit of a ray or a sweep.
+class PhysicsHit
+{
+public:
+	Vec4 m_position = Vec4(0.0); ///< The contact point.
+	Vec4 m_normal = Vec4(0.0);
+	F32 m_fraction = 1.0; ///< How far from the start to the end.
+	PhysicsObject* m_object = nullptr; ///< The body or the player controller. nullptr for the static geometry.
+	Bool8 m_hit = false;
+};
+
 /// The master container for all physics related stuff.
+///
+/// The step runs in the Newton threads between updateAsync() and waitUpdate() and it can overlap other work. While it
+/// runs the objects keep returning the results of the previous step and the inputs that are set on them are applied
+/// when waitUpdate() syncs the results.
 class PhysicsWorld
 {
 public:
 	PhysicsWorld();
 	~PhysicsWorld();
 
-	ANKI_USE_RESULT Error create(AllocAlignedCallback allocCb, void* allocCbData);
+	ANKI_USE_RESULT Error create(AllocAlignedCallback allocCb, void* allocCbData, const ConfigSet& config);
 
 	template<typename T, typename... TArgs>
 	PhysicsPtr<T> newInstance(TArgs&&... args);
 
-	/// Start asynchronous update.
+	/// Start asynchronous update. The previous one should have been waited.
 	Error updateAsync(F32 dt);
 
-	/// End asynchronous update.
+	/// End asynchronous update and sync the results of the step to the objects. It's the only point where the results
+	/// change.
 	void waitUpdate();
 
+	/// Between updateAsync() and waitUpdate(). The inputs that are set in that window are buffered until the sync even
+	/// if the step has already finished.
+	Bool isUpdating() const
+	{
+		return m_updating;
+	}
+
+	/// Wait for the step without syncing the results. Use it before touching the Newton world. It doesn't end the
+	/// update, isUpdating() stays true until waitUpdate().
+	void waitUpdateToFinish() const;
+
+	/// Cast many rays and get the closest hit of each. It waits for the step if it's running.
+	/// @param rays The rays.
+	/// @param[out] hits One per ray.
+	/// @param count The number of rays.
+	/// @param hive If it's not nullptr the rays are split across its threads.
+	void castRays(const PhysicsRay* rays, PhysicsHit* hits, U32 count, ThreadHive* hive = nullptr) const;
+
+	/// Same as castRays() for convex shapes.
+	void sweep(const PhysicsSweep* sweeps, PhysicsHit* hits, U32 count, ThreadHive* hive = nullptr) const;
+
 	const Vec4& getGravity() const
 	{
 		return m_gravity;
@@ -71,10 +131,17 @@ private:
 	F32 m_dt = 0.0;
 
 	List<PhysicsPlayerController*> m_playerControllers;
+	List<PhysicsObject*> m_syncObjects; ///< The objects that get the results of the steps.
 
 	Mutex m_mtx;
 	List<PhysicsObject*> m_forDeletion;
 
+	mutable Mutex m_updateMtx;
+	Bool8 m_updating = false; ///< Between updateAsync() and waitUpdate().
+	mutable Bool8 m_stepRunning = false; ///< Newton is stepping.
+
+	class QueryTask;
+
 	template<typename T, typename... TArgs>
 	PhysicsPtr<T> newObjectInternal(TArgs&&... args);
 
@@ -88,6 +155,13 @@ private:
 
 	void postUpdate(F32 dt);
 
+	void runQueries(
+		const PhysicsRay* rays, const PhysicsSweep* sweeps, PhysicsHit* hits, U32 count, ThreadHive* hive) const;
+
+	static void queryCallback(void* arg, U32 threadId, ThreadHive& hive);
+
+	static void runQueryTask(const QueryTask& task);
+
 	static void destroyCallback(const NewtonWorld* const world, void* const listenerUserData)
 	{
 	}
@@ -115,6 +189,9 @@ inline PhysicsPtr<T> PhysicsWorld::newInstance(TArgs&&... args)
 	Error err = ErrorCode::NONE;
 	PhysicsPtr<T> out;
 
+	// Newton can't create objects while it's stepping
+	waitUpdateToFinish();
+
 	T* ptr = m_alloc.template newInstance<T>(this);
 	err = ptr->create(std::forward<TArgs>(args)...);
 
@@ -27,22 +27,9 @@ Error BloomExposure::init(const ConfigSet& config)
 	m_threshold = config.getNumber("bloom.threshold");
 	m_scale = config.getNumber("bloom.scale");
 
-	// Create RT
-	m_r->createRenderTarget(m_width,
-		m_height,
-		BLOOM_RT_PIXEL_FORMAT,
-		TextureUsageBit::SAMPLED_FRAGMENT | TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE,
-		SamplingFilter::LINEAR,
-		1,
-		m_rt);
-
-	// Create FBs
-	FramebufferInitInfo fbInit;
-	fbInit.m_colorAttachmentCount = 1;
-	fbInit.m_colorAttachments[0].m_texture = m_rt;
-	fbInit.m_colorAttachments[0].m_loadOperation = AttachmentLoadOperation::DONT_CARE;
-	fbInit.m_colorAttachments[0].m_usageInsideRenderPass = TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE;
-	m_fb = gr.newInstance<Framebuffer>(fbInit);
+	// The RT is in the render graph
+	m_rtInit = m_r->createRenderTargetInitInfo(
+		m_width, m_height, BLOOM_RT_PIXEL_FORMAT, TextureUsageBit::NONE, SamplingFilter::LINEAR, 1);
 
 	// init shaders
 	StringAuto pps(getAllocator());
@@ -75,24 +62,39 @@ Error BloomExposure::init(const ConfigSet& config)
 	return ErrorCode::NONE;
 }
 
-void BloomExposure::setPreRunBarriers(RenderingContext& ctx)
+void BloomExposure::populateRenderGraph(RenderingContext& ctx)
 {
-	ctx.m_commandBuffer->setTextureSurfaceBarrier(
-		m_rt, TextureUsageBit::NONE, TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE, TextureSurfaceInfo(0, 0, 0, 0));
+	RenderGraph& graph = m_r->getRenderGraph();
+
+	ctx.m_bloom.m_exposureRt = graph.newTexture(m_rtInit, "Bloom exposure");
+
+	U pass = graph.newPass("Bloom exposure", runCallback, this);
+	graph.newWrite(pass, ctx.m_bloom.m_exposureRt, TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE);
 }
 
-void BloomExposure::setPostRunBarriers(RenderingContext& ctx)
+Error BloomExposure::runCallback(RenderGraphRunContext& rctx)
 {
-	ctx.m_commandBuffer->setTextureSurfaceBarrier(m_rt,
-		TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE,
-		TextureUsageBit::SAMPLED_FRAGMENT,
-		TextureSurfaceInfo(0, 0, 0, 0));
+	static_cast<BloomExposure*>(rctx.m_userData)->run(*static_cast<RenderingContext*>(rctx.m_frameUserData));
+	return ErrorCode::NONE;
 }
 
 void BloomExposure::run(RenderingContext& ctx)
 {
 	CommandBufferPtr& cmdb = ctx.m_commandBuffer;
 
+	TexturePtr rt = m_r->getRenderGraph().getTexture(ctx.m_bloom.m_exposureRt);
+	if(rt != m_rt)
+	{
+		m_rt = rt;
+
+		FramebufferInitInfo fbInit;
+		fbInit.m_colorAttachmentCount = 1;
+		fbInit.m_colorAttachments[0].m_texture = m_rt;
+		fbInit.m_colorAttachments[0].m_loadOperation = AttachmentLoadOperation::DONT_CARE;
+		fbInit.m_colorAttachments[0].m_usageInsideRenderPass = TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE;
+		m_fb = getGrManager().newInstance<Framebuffer>(fbInit);
+	}
+
 	cmdb->beginRenderPass(m_fb);
 	cmdb->setViewport(0, 0, m_width, m_height);
 	cmdb->bindPipeline(m_ppline);
@@ -114,27 +116,12 @@ BloomUpscale::~BloomUpscale()
 
 Error BloomUpscale::init(const ConfigSet& config)
 {
-	GrManager& gr = getGrManager();
-
 	m_width = m_r->getWidth() / BLOOM_FRACTION;
 	m_height = m_r->getHeight() / BLOOM_FRACTION;
 
-	// Create RTs
-	m_r->createRenderTarget(m_width,
-		m_height,
-		BLOOM_RT_PIXEL_FORMAT,
-		TextureUsageBit::SAMPLED_FRAGMENT | TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE,
-		SamplingFilter::LINEAR,
-		1,
-		m_rt);
-
-	// Create FBs
-	FramebufferInitInfo fbInit;
-	fbInit.m_colorAttachmentCount = 1;
-	fbInit.m_colorAttachments[0].m_texture = m_rt;
-	fbInit.m_colorAttachments[0].m_loadOperation = AttachmentLoadOperation::DONT_CARE;
-	fbInit.m_colorAttachments[0].m_usageInsideRenderPass = TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE;
-	m_fb = gr.newInstance<Framebuffer>(fbInit);
+	// The RT is in the render graph
+	m_rtInit = m_r->createRenderTargetInitInfo(
+		m_width, m_height, BLOOM_RT_PIXEL_FORMAT, TextureUsageBit::NONE, SamplingFilter::LINEAR, 1);
 
 	// init shaders
 	StringAuto pps(getAllocator());
@@ -152,33 +139,54 @@ Error BloomUpscale::init(const ConfigSet& config)
 	colorInf.m_attachments[0].m_format = BLOOM_RT_PIXEL_FORMAT;
 	m_r->createDrawQuadPipeline(m_frag->getGrShader(), colorInf, m_ppline);
 
-	// Set descriptors
-	ResourceGroupInitInfo descInit;
-	descInit.m_textures[0].m_texture = m_r->getBloom().m_extractExposure.m_rt;
-	m_rsrc = gr.newInstance<ResourceGroup>(descInit);
-
 	return ErrorCode::NONE;
 }
 
-void BloomUpscale::setPreRunBarriers(RenderingContext& ctx)
+void BloomUpscale::populateRenderGraph(RenderingContext& ctx)
 {
-	ctx.m_commandBuffer->setTextureSurfaceBarrier(m_rt,
-		TextureUsageBit::NONE,
-		TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE,
-		TextureSurfaceInfo(0, 0, 0, 0));
+	RenderGraph& graph = m_r->getRenderGraph();
+
+	ctx.m_bloom.m_upscaleRt = graph.newTexture(m_rtInit, "Bloom upscale");
+
+	// The SSLF reads the exposure as well and blends
+	U pass = graph.newPass("Bloom upscale", runCallback, this);
+	graph.newRead(pass, ctx.m_bloom.m_exposureRt, TextureUsageBit::SAMPLED_FRAGMENT);
+	graph.newWrite(pass, ctx.m_bloom.m_upscaleRt, TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE);
 }
 
-void BloomUpscale::setPostRunBarriers(RenderingContext& ctx)
+Error BloomUpscale::runCallback(RenderGraphRunContext& rctx)
 {
-	ctx.m_commandBuffer->setTextureSurfaceBarrier(m_rt,
-		TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE,
-		TextureUsageBit::SAMPLED_FRAGMENT,
-		TextureSurfaceInfo(0, 0, 0, 0));
+	static_cast<BloomUpscale*>(rctx.m_userData)->run(*static_cast<RenderingContext*>(rctx.m_frameUserData));
+	return ErrorCode::NONE;
 }
 
 void BloomUpscale::run(RenderingContext& ctx)
 {
 	CommandBufferPtr& cmdb = ctx.m_commandBuffer;
+	const RenderGraph& graph = m_r->getRenderGraph();
+
+	TexturePtr rt = graph.getTexture(ctx.m_bloom.m_upscaleRt);
+	if(rt != m_rt)
+	{
+		m_rt = rt;
+
+		FramebufferInitInfo fbInit;
+		fbInit.m_colorAttachmentCount = 1;
+		fbInit.m_colorAttachments[0].m_texture = m_rt;
+		fbInit.m_colorAttachments[0].m_loadOperation = AttachmentLoadOperation::DONT_CARE;
+		fbInit.m_colorAttachments[0].m_usageInsideRenderPass = TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE;
+		m_fb = getGrManager().newInstance<Framebuffer>(fbInit);
+	}
+
+	TexturePtr exposureRt = graph.getTexture(ctx.m_bloom.m_exposureRt);
+	if(exposureRt != m_exposureRt)
+	{
+		m_exposureRt = exposureRt;
+
+		ResourceGroupInitInfo descInit;
+		descInit.m_textures[0].m_texture = m_exposureRt;
+		m_rsrc = getGrManager().newInstance<ResourceGroup>(descInit);
+	}
 
 	cmdb->setViewport(0, 0, m_width, m_height);
 	cmdb->beginRenderPass(m_fb);
@@ -26,7 +26,6 @@ class BloomExposure : public RenderingPass
 anki_internal:
 	U32 m_width = 0;
 	U32 m_height = 0;
-	TexturePtr m_rt;
 
 	BloomExposure(Renderer* r)
 		: RenderingPass(r)
@@ -37,13 +36,12 @@ anki_internal:
 
 	ANKI_USE_RESULT Error init(const ConfigSet& initializer);
 
-	void setPreRunBarriers(RenderingContext& ctx);
-
-	void run(RenderingContext& ctx);
-
-	void setPostRunBarriers(RenderingContext& ctx);
+	/// Add the pass. The result is RenderingContext::m_bloom.m_exposureRt.
+	void populateRenderGraph(RenderingContext& ctx);
 
 private:
+	TextureInitInfo m_rtInit; ///< The render graph sets the usage.
+	TexturePtr m_rt; ///< The texture that the render graph gave the last time. m_fb uses it.
 	FramebufferPtr m_fb;
 	ShaderResourcePtr m_frag;
 	PipelinePtr m_ppline;
@@ -51,6 +49,10 @@ private:
 
 	F32 m_threshold = 10.0; ///< How bright it is
 	F32 m_scale = 1.0;
+
+	void run(RenderingContext& ctx);
+
+	static ANKI_USE_RESULT Error runCallback(RenderGraphRunContext& rctx);
 };
 
 class BloomUpscale : public RenderingPass
@@ -58,7 +60,6 @@ class BloomUpscale : public RenderingPass
 anki_internal:
 	U32 m_width = 0;
 	U32 m_height = 0;
-	TexturePtr m_rt;
 
 	BloomUpscale(Renderer* r)
 		: RenderingPass(r)
@@ -69,17 +70,24 @@ anki_internal:
 
 	ANKI_USE_RESULT Error init(const ConfigSet& initializer);
 
-	void setPreRunBarriers(RenderingContext& ctx);
+	/// Add the pass. It draws the SSLF as well. The result is RenderingContext::m_bloom.m_upscaleRt.
+	void populateRenderGraph(RenderingContext& ctx);
 
-	void run(RenderingContext& ctx);
+private:
+	TextureInitInfo m_rtInit; ///< The render graph sets the usage.
 
-	void setPostRunBarriers(RenderingContext& ctx);
+	/// The textures that the render graph gave the last time. m_fb and m_rsrc use them.
+	TexturePtr m_rt;
+	TexturePtr m_exposureRt;
 
-private:
 	FramebufferPtr m_fb;
 	ShaderResourcePtr m_frag;
 	PipelinePtr m_ppline;
 	ResourceGroupPtr m_rsrc;
+
+	void run(RenderingContext& ctx);
+
+	static ANKI_USE_RESULT Error runCallback(RenderGraphRunContext& rctx);
 };
 
 /// Bloom pass.
@@ -34,6 +34,7 @@ class Smaa;
 
 class RenderingContext;
 class DebugDrawer;
+class RenderGraphRunContext;
 
 /// @addtogroup renderer
 /// @{
@@ -11,6 +11,7 @@
 #include <anki/scene/RenderComponent.h>
 #include <anki/scene/Visibility.h>
 #include <anki/scene/SceneGraph.h>
+#include <anki/scene/SpatialComponent.h>
 #include <anki/resource/TextureResource.h>
 #include <anki/renderer/Renderer.h>
 #include <anki/core/Trace.h>
@@ -35,6 +36,11 @@ static Bool canMergeBuildInfo(const RenderingBuildInfoOut& a, const RenderingBui
 		return false;
 	}
 
+	if(a.m_boneMatrices != b.m_boneMatrices)
+	{
+		return false;
+	}
+
 	for(U i = 0; i < U(ShaderType::COUNT); ++i)
 	{
 		if(a.m_state->m_shaders[i] != b.m_state->m_shaders[i])
@@ -91,6 +97,7 @@ class CompleteRenderingBuildInfo
 {
 public:
 	F32 m_flod = 0.0;
+	F32 m_screenSize = 0.0; ///< The size on the screen in pixels. Zero if it doesn't matter for the textures.
 	RenderComponent* m_rc = nullptr;
 	RenderingBuildInfoIn m_in;
 	RenderingBuildInfoOut m_out;
@@ -123,6 +130,15 @@ public:
 	Array<PipelineInitInfo, 2> m_state;
 	U m_crntBuildInfo = 0;
 
+	/// @name LOD
+	/// @{
+	F32 m_lodProjectionScale = 0.0; ///< Zero if the LODs depend only on the distance.
+	Bool8 m_cameraPass = false; ///< The LODs remember the previous frame and the triangles count in the budget.
+	Array<U32, MAX_LODS> m_lodCounts = {};
+	U32 m_lodTransitionCount = 0;
+	U32 m_triangleCount = 0;
+	/// @}
+
 	DrawContext()
 		: m_buildInfo{{&m_state[0], &m_state[1]}}
 	{
@@ -138,6 +154,7 @@ public:
 	WeakArray<U8> m_uniformBuffer;
 	const MaterialVariant* m_variant ANKI_DBG_NULLIFY_PTR;
 	F32 m_flod;
+	F32 m_screenSize;
 
 	/// Set a uniform in a client block
 	template<typename T>
@@ -276,7 +293,12 @@ void SetupRenderableVariableVisitor::uniSet<TextureResourcePtr>(
 	const MaterialVariable& mtlvar, const TextureResourcePtr* values, U32 size)
 {
 	ANKI_ASSERT(size == 1);
-	// Do nothing
+
+	// Tell the streamer the mips that are needed
+	if(m_screenSize > 0.0)
+	{
+		values[0]->requestScreenSize(m_screenSize);
+	}
 }
 
 RenderableDrawer::~RenderableDrawer()
@@ -299,6 +321,7 @@ void RenderableDrawer::setupUniforms(DrawContext& ctx, CompleteRenderingBuildInf
 	visitor.m_uniformBuffer = WeakArray<U8>(uniforms, variant.getDefaultBlockSize());
 	visitor.m_variant = &variant;
 	visitor.m_flod = build.m_flod;
+	visitor.m_screenSize = build.m_screenSize;
 
 	for(auto it = build.m_rc->getVariablesBegin(); it != build.m_rc->getVariablesEnd(); ++it)
 	{
@@ -330,6 +353,15 @@ Error RenderableDrawer::drawRange(Pass pass,
 	ctx.m_state[0] = state;
 	ctx.m_state[1] = state;
 
+	// The shadows keep the LODs of the distance
+	const Frustum& fr = frc.getFrustum();
+	if(pass == Pass::MS_FS && fr.getType() == FrustumType::PERSPECTIVE)
+	{
+		ctx.m_lodProjectionScale = LodSelector::computeProjectionScale(
+			static_cast<const PerspectiveFrustum&>(fr).getFovY(), F32(m_r->getHeight()));
+		ctx.m_cameraPass = m_r->isCameraFrustum(frc);
+	}
+
 	for(; begin != end; ++begin)
 	{
 		ctx.m_visibleNode = begin;
@@ -343,6 +375,18 @@ Error RenderableDrawer::drawRange(Pass pass,
 	CompleteRenderingBuildInfo& build = ctx.m_buildInfo[!ctx.m_crntBuildInfo];
 	ANKI_CHECK(flushDrawcall(ctx, build));
 
+	if(ctx.m_cameraPass)
+	{
+		m_r->getLodSelector().addTriangles(ctx.m_triangleCount);
+
+		static_assert(MAX_LODS == 3, "Update the counters");
+		ANKI_TRACE_INC_COUNTER(RENDERER_LOD_0, ctx.m_lodCounts[0]);
+		ANKI_TRACE_INC_COUNTER(RENDERER_LOD_1, ctx.m_lodCounts[1]);
+		ANKI_TRACE_INC_COUNTER(RENDERER_LOD_2, ctx.m_lodCounts[2]);
+		ANKI_TRACE_INC_COUNTER(RENDERER_LOD_TRANSITIONS, ctx.m_lodTransitionCount);
+		ANKI_TRACE_INC_COUNTER(RENDERER_TRIANGLES, ctx.m_triangleCount);
+	}
+
 	return ErrorCode::NONE;
 }
 
@@ -372,6 +416,8 @@ Error RenderableDrawer::flushDrawcall(DrawContext& ctx, CompleteRenderingBuildIn
 	setupUniforms(ctx, build);
 
 	// Finaly, touch the command buffer
+	ctx.m_dynBufferInfo.m_storageBuffers[0] =
+		(build.m_out.m_boneMatrices) ? *build.m_out.m_boneMatrices : TransientMemoryToken();
 	ctx.m_cmdb->bindResourceGroup(build.m_out.m_resourceGroup, 0, &ctx.m_dynBufferInfo);
 	ctx.m_cmdb->bindPipeline(ppline);
 	if(!build.m_out.m_drawArrays)
@@ -380,12 +426,14 @@ Error RenderableDrawer::flushDrawcall(DrawContext& ctx, CompleteRenderingBuildIn
 
 		ctx.m_cmdb->drawElements(
 			drawc.m_count, drawc.m_instanceCount, drawc.m_firstIndex, drawc.m_baseVertex, drawc.m_baseInstance);
+		ctx.m_triangleCount += drawc.m_count / 3 * drawc.m_instanceCount;
 	}
 	else
 	{
 		const DrawArraysIndirectInfo& drawc = build.m_out.m_drawcall.m_arrays;
 
 		ctx.m_cmdb->drawArrays(drawc.m_count, drawc.m_instanceCount, drawc.m_first, drawc.m_baseInstance);
+		ctx.m_triangleCount += drawc.m_count / 3 * drawc.m_instanceCount;
 	}
 
 	// Rendered something, reset the cached transforms
@@ -398,6 +446,56 @@ Error RenderableDrawer::flushDrawcall(DrawContext& ctx, CompleteRenderingBuildIn
 	return ErrorCode::NONE;
 }
 
+F32 RenderableDrawer::computeScreenSize(const DrawContext& ctx, F32 dist) const
+{
+	// Only the camera passes choose texture mips
+	const Frustum& fr = ctx.m_frc->getFrustum();
+	if(ctx.m_pass != Pass::MS_FS || fr.getType() != FrustumType::PERSPECTIVE)
+	{
+		return 0.0;
+	}
+
+	const SpatialComponent* sp = ctx.m_visibleNode->m_node->tryGetComponent<SpatialComponent>();
+	if(sp == nullptr)
+	{
+		return 0.0;
+	}
+
+	// The projected diameter of the bounding sphere
+	const Aabb& box = sp->getAabb();
+	const F32 radius = (box.getMax() - box.getMin()).xyz().getLength() / 2.0;
+	const F32 tanHalfFov = tan(static_cast<const PerspectiveFrustum&>(fr).getFovY() / 2.0);
+
+	return radius * m_r->getHeight() / max(dist * tanHalfFov, EPSILON);
+}
+
+U RenderableDrawer::selectLod(DrawContext& ctx, RenderComponent& renderable, F32 dist, F32 flod) const
+{
+	U lod = U(flod);
+
+	Array<F32, MAX_LODS> errors;
+	const U lodCount = (ctx.m_lodProjectionScale > 0.0) ? renderable.getLodErrors(errors) : 0;
+	if(lodCount > 0)
+	{
+		const U prevLod = (ctx.m_cameraPass) ? renderable.getLastLod() : MAX_U;
+		lod = m_r->getLodSelector().selectLod(
+			WeakArray<const F32>(&errors[0], lodCount), dist, ctx.m_lodProjectionScale, prevLod);
+
+		if(ctx.m_cameraPass)
+		{
+			ctx.m_lodTransitionCount += (prevLod != MAX_U && prevLod != lod) ? 1 : 0;
+			renderable.setLastLod(lod);
+		}
+	}
+
+	if(ctx.m_cameraPass)
+	{
+		++ctx.m_lodCounts[lod];
+	}
+
+	return lod;
+}
+
 Error RenderableDrawer::drawSingle(DrawContext& ctx)
 {
 	// Get components
@@ -410,13 +508,15 @@ Error RenderableDrawer::drawSingle(DrawContext& ctx)
 	ctx.m_crntBuildInfo = !ctx.m_crntBuildInfo;
 
 	// Fill the crntBuild
-	F32 flod = m_r->calculateLod(sqrt(ctx.m_visibleNode->m_frustumDistanceSquared));
+	const F32 dist = sqrt(ctx.m_visibleNode->m_frustumDistanceSquared);
+	F32 flod = m_r->calculateLod(dist);
 	flod = min<F32>(flod, MAX_LODS - 1);
 
 	crntBuild.m_rc = &renderable;
 	crntBuild.m_flod = flod;
+	crntBuild.m_screenSize = computeScreenSize(ctx, dist);
 
-	crntBuild.m_in.m_key.m_lod = flod;
+	crntBuild.m_in.m_key.m_lod = selectLod(ctx, renderable, dist, flod);
 	crntBuild.m_in.m_key.m_pass = ctx.m_pass;
 	crntBuild.m_in.m_key.m_tessellation = m_r->getTessellationEnabled() && mtl.getTessellationEnabled()
 		&& crntBuild.m_in.m_key.m_lod == 0 && ctx.m_pass != Pass::SM;
@@ -444,6 +544,9 @@ Error RenderableDrawer::drawSingle(DrawContext& ctx)
 		// Can merge, will cache the drawcall and skip the drawcall
 
 		ctx.m_cachedTrfs[ctx.m_cachedTrfCount++] = crntBuild.m_out.m_transform;
+
+		// The textures should be sharp enough for the closest instance
+		crntBuild.m_screenSize = max(crntBuild.m_screenSize, prevBuild.m_screenSize);
 	}
 	else
 	{
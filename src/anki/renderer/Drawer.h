@@ -49,6 +49,12 @@ private:
 	void setupUniforms(DrawContext& ctx, CompleteRenderingBuildInfo& build);
 
 	ANKI_USE_RESULT Error drawSingle(DrawContext& ctx);
+
+	/// Compute the size of a node on the screen. The textures use it to request their mips.
+	F32 computeScreenSize(const DrawContext& ctx, F32 dist) const;
+
+	/// Pick the LOD from the errors of the renderable on the screen or from the distance if it has no errors.
+	U selectLod(DrawContext& ctx, RenderComponent& renderable, F32 dist, F32 flod) const;
 };
 /// @}
 
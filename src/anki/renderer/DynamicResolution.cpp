@@ -0,0 +1,93 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/renderer/DynamicResolution.h>
+#include <anki/util/Assert.h>
+#include <anki/util/Functions.h>
+#include <anki/math/Functions.h>
+
+namespace anki
+{
+
+/// @name The gains of the controller
+/// @{
+static const F32 KP = 0.1;
+static const F32 KI = 0.05;
+static const F32 KD = 0.05;
+/// @}
+
+/// The weight of the new frame time in the moving average. The frame times are noisy.
+static const F32 SMOOTHING = 0.25;
+
+/// Relative errors smaller than that are ignored. It's larger than the change in the frame time that a step of the
+/// scale causes so the controller doesn't bounce between two steps.
+static const F32 DEAD_ZONE = 0.04;
+
+/// It's better to recover the resolution slowly than to drop a frame.
+static const F32 GROW_FACTOR = 0.5;
+
+void DynamicResolution::init(F32 targetFrameTime, F32 minScale, F32 maxScale)
+{
+	ANKI_ASSERT(targetFrameTime > 0.0);
+	ANKI_ASSERT(minScale > 0.0 && minScale <= maxScale && maxScale <= 1.0);
+
+	m_targetFrameTime = targetFrameTime;
+	m_minScale = minScale;
+	m_maxScale = maxScale;
+
+	m_scale = maxScale;
+	m_appliedScale = maxScale;
+	m_smoothFrameTime = 0.0;
+	m_integral = 0.0;
+	m_prevError = 0.0;
+}
+
+F32 DynamicResolution::update(F32 frameTime)
+{
+	ANKI_ASSERT(frameTime >= 0.0);
+
+	m_smoothFrameTime =
+		(m_smoothFrameTime > 0.0) ? m_smoothFrameTime + (frameTime - m_smoothFrameTime) * SMOOTHING : frameTime;
+
+	// Positive when there is time to spare
+	F32 error = (m_targetFrameTime - m_smoothFrameTime) / m_targetFrameTime;
+	if(absolute(error) < DEAD_ZONE)
+	{
+		error = 0.0;
+	}
+	else if(error > 0.0)
+	{
+		error *= GROW_FACTOR;
+	}
+
+	const F32 derivative = error - m_prevError;
+	m_prevError = error;
+
+	// Don't accumulate when the output can't move any further in that direction
+	const Bool saturated = (error > 0.0 && m_scale >= m_maxScale) || (error < 0.0 && m_scale <= m_minScale);
+	if(!saturated)
+	{
+		const F32 maxIntegral = (m_maxScale - m_minScale) / KI;
+		m_integral = min<F32>(max<F32>(m_integral + error, -maxIntegral), 0.0);
+	}
+
+	// The integral holds the offset from the max scale that the load needs
+	m_scale = m_maxScale + KP * error + KI * m_integral + KD * derivative;
+	m_scale = min<F32>(max<F32>(m_scale, m_minScale), m_maxScale);
+
+	// Quantize. Move only when the output is a step away so the size doesn't flicker
+	if(m_scale == m_minScale || m_scale == m_maxScale)
+	{
+		m_appliedScale = m_scale;
+	}
+	else if(absolute(m_scale - m_appliedScale) >= SCALE_STEP)
+	{
+		m_appliedScale = min<F32>(max<F32>(round(m_scale / SCALE_STEP) * SCALE_STEP, m_minScale), m_maxScale);
+	}
+
+	return m_appliedScale;
+}
+
+} // end namespace anki
@@ -0,0 +1,59 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/util/StdTypes.h>
+
+namespace anki
+{
+
+/// @addtogroup renderer
+/// @{
+
+/// Suggests the fraction of the resolution to render every frame. It's a PID controller that is fed the measured GPU
+/// frame times and tries to keep them at a target. The scale it outputs moves in steps and it doesn't change for small
+/// errors so the image doesn't flicker between two sizes.
+///
+/// It's the controller only. The MainRenderer feeds it and reports its scale but no pass renders in it yet. Applying
+/// it needs MS and IS to render to part of their render targets and a final upscale. The tiler, the light binning and
+/// the clusterer split the screen in tiles of a fixed size and the materials bake the renderer size in their shaders so
+/// that is left for later.
+class DynamicResolution
+{
+public:
+	/// The scale moves in steps of that size.
+	static constexpr F32 SCALE_STEP = 1.0 / 32.0;
+
+	/// @param targetFrameTime The frame time to aim for in seconds.
+	/// @param minScale The minimum fraction of the resolution.
+	/// @param maxScale The maximum fraction of the resolution.
+	void init(F32 targetFrameTime, F32 minScale, F32 maxScale = 1.0);
+
+	/// Feed the time of the last frame.
+	/// @return The scale of the next frame.
+	F32 update(F32 frameTime);
+
+	/// Get the scale of the next frame.
+	F32 getScale() const
+	{
+		return m_appliedScale;
+	}
+
+private:
+	F32 m_targetFrameTime = 1.0 / 60.0;
+	F32 m_minScale = 1.0;
+	F32 m_maxScale = 1.0;
+
+	F32 m_scale = 1.0; ///< The continuous output of the controller.
+	F32 m_appliedScale = 1.0; ///< The quantized scale.
+
+	F32 m_smoothFrameTime = 0.0;
+	F32 m_integral = 0.0;
+	F32 m_prevError = 0.0;
+};
+/// @}
+
+} // end namespace anki
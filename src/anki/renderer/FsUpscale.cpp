@@ -16,31 +16,37 @@
 namespace anki
 {
 
-Error FsUpscale::init(const ConfigSet& config)
+void FsUpscale::createResourceGroup(TexturePtr ssaoRt)
 {
-	GrManager& gr = getGrManager();
-
-	// Create RC group
 	ResourceGroupInitInfo rcInit;
-	SamplerInitInfo sinit;
-	sinit.m_repeat = false;
 
 	rcInit.m_textures[0].m_texture = m_r->getMs().m_depthRt;
 	rcInit.m_textures[0].m_usage = TextureUsageBit::SAMPLED_FRAGMENT | TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ;
 
-	sinit.m_mipmapFilter = SamplingFilter::NEAREST;
 	rcInit.m_textures[1].m_texture = m_r->getDepthDownscale().m_hd.m_depthRt;
-	rcInit.m_textures[1].m_sampler = gr.newInstance<Sampler>(sinit);
+	rcInit.m_textures[1].m_sampler = m_hdSampler;
 	rcInit.m_textures[1].m_usage = TextureUsageBit::SAMPLED_FRAGMENT | TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ;
 
 	rcInit.m_textures[2].m_texture = m_r->getFs().getRt();
 
-	rcInit.m_textures[3].m_texture = m_r->getSsao().getRt();
+	rcInit.m_textures[3].m_texture = ssaoRt;
 
 	rcInit.m_uniformBuffers[0].m_uploadedMemory = true;
 	rcInit.m_uniformBuffers[0].m_usage = BufferUsageBit::UNIFORM_FRAGMENT;
 
 	m_rcGroup = getGrManager().newInstance<ResourceGroup>(rcInit);
+	m_ssaoRt = ssaoRt;
+}
+
+Error FsUpscale::init(const ConfigSet& config)
+{
+	GrManager& gr = getGrManager();
+
+	// The resource group needs the SSAO texture of the render graph so it's created when it runs
+	SamplerInitInfo sinit;
+	sinit.m_repeat = false;
+	sinit.m_mipmapFilter = SamplingFilter::NEAREST;
+	m_hdSampler = gr.newInstance<Sampler>(sinit);
 
 	// Shader
 	StringAuto pps(getFrameAllocator());
@@ -83,6 +89,13 @@ Error FsUpscale::init(const ConfigSet& config)
 void FsUpscale::run(RenderingContext& ctx)
 {
 	CommandBufferPtr cmdb = ctx.m_commandBuffer;
+
+	TexturePtr ssaoRt = m_r->getRenderGraph().getTexture(ctx.m_ssao.m_rt);
+	if(ssaoRt != m_ssaoRt)
+	{
+		createResourceGroup(ssaoRt);
+	}
+
 	TransientMemoryInfo dyn;
 
 	Vec4* linearDepth = static_cast<Vec4*>(getGrManager().allocateFrameTransientMemory(
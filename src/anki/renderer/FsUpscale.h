@@ -28,10 +28,14 @@ public:
 
 private:
 	ResourceGroupPtr m_rcGroup;
+	TexturePtr m_ssaoRt; ///< The SSAO texture of m_rcGroup. The render graph may give another.
+	SamplerPtr m_hdSampler;
 	FramebufferPtr m_fb;
 	ShaderResourcePtr m_frag;
 	ShaderResourcePtr m_vert;
 	PipelinePtr m_ppline;
+
+	void createResourceGroup(TexturePtr ssaoRt);
 };
 /// @}
 
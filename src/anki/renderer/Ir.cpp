@@ -74,7 +74,16 @@ Error Ir::init(const ConfigSet& config)
 		return ErrorCode::USER_DATA;
 	}
 
+	m_maxFacesPerFrame = config.getNumber("ir.maxFacesPerFrame");
+
+	if(m_maxFacesPerFrame < 1)
+	{
+		ANKI_LOGE("Too low ir.maxFacesPerFrame");
+		return ErrorCode::USER_DATA;
+	}
+
 	m_cacheEntries.create(getAllocator(), m_cubemapArrSize);
+	m_probeCache.init(getAllocator(), m_cubemapArrSize);
 
 	ANKI_CHECK(initIs());
 	ANKI_CHECK(initIrradiance());
@@ -115,13 +124,7 @@ Error Ir::loadMesh(CString fname, BufferPtr& vert, BufferPtr& idx, U32& idxCount
 	Vec3* verts = static_cast<Vec3*>(
 		getGrManager().allocateFrameTransientMemory(vertBuffSize, BufferUsageBit::BUFFER_UPLOAD_SOURCE, token));
 
-	const U8* ptr = loader.getVertexData();
-	for(U i = 0; i < loader.getHeader().m_totalVerticesCount; ++i)
-	{
-		*verts = *reinterpret_cast<const Vec3*>(ptr);
-		++verts;
-		ptr += loader.getVertexSize();
-	}
+	memcpy(verts, loader.getPositions(), vertBuffSize);
 
 	cmdb->uploadBuffer(vert, 0, token);
 
@@ -651,62 +654,97 @@ Error Ir::run(RenderingContext& rctx)
 	FrustumComponent& frc = *rctx.m_frustumComponent;
 	VisibilityTestResults& visRez = frc.getVisibilityTestResults();
 
-	if(visRez.getCount(VisibilityGroupType::REFLECTION_PROBES) > m_cubemapArrSize)
+	// The probes are sorted by distance. The ones that don't fit in the cache are dropped
+	VisibleNode* probes = visRez.getBegin(VisibilityGroupType::REFLECTION_PROBES);
+	const U visibleCount = visRez.getCount(VisibilityGroupType::REFLECTION_PROBES);
+	const U probeCount = min<U>(visibleCount, m_cubemapArrSize);
+
+	for(U i = probeCount; i < visibleCount; ++i)
 	{
-		ANKI_LOGW("Increase the ir.cubemapTextureArraySize");
+		ReflectionProbeComponent& reflc = probes[i].m_node->getComponent<ReflectionProbeComponent>();
+		reflc.unsetTextureArrayIndex();
+		reflc.setFacesMarkedForRendering(0);
 	}
 
-	// Render some of the probes
-	const VisibleNode* it = visRez.getBegin(VisibilityGroupType::REFLECTION_PROBES);
-	const VisibleNode* end = visRez.getEnd(VisibilityGroupType::REFLECTION_PROBES);
+	// Give cache entries to the probes
+	DynamicArrayAuto<U64> ids(rctx.m_tempAllocator);
+	DynamicArrayAuto<U32> entries(rctx.m_tempAllocator);
+	DynamicArrayAuto<Bool8> newEntries(rctx.m_tempAllocator);
+	if(probeCount > 0)
+	{
+		ids.create(probeCount);
+		entries.create(probeCount);
+		newEntries.create(probeCount);
 
-	U probesRendered = 0;
-	U probeIdx = 0;
-	while(it != end)
+		for(U i = 0; i < probeCount; ++i)
+		{
+			ids[i] = probes[i].m_node->getUuid();
+		}
+
+		m_probeCache.assign(WeakArray<const U64>(&ids[0], probeCount),
+			WeakArray<U32>(&entries[0], probeCount),
+			WeakArray<Bool8>(&newEntries[0], probeCount));
+	}
+
+	// Render the faces that were marked in the previous frame
+	for(U i = 0; i < probeCount; ++i)
 	{
-		// Write and render probe
-		ANKI_CHECK(tryRender(rctx, *it->m_node, probesRendered));
+		SceneNode& node = *probes[i].m_node;
+		ReflectionProbeComponent& reflc = node.getComponent<ReflectionProbeComponent>();
 
-		++it;
-		++probeIdx;
+		const U entry = entries[i];
+		reflc.setTextureArrayIndex(entry);
+
+		if(newEntries[i])
+		{
+			m_cacheEntries[entry].resetFaces();
+		}
+
+		const U8 faces = reflc.getFacesMarkedForRendering();
+		if(faces)
+		{
+			reflc.setFacesMarkedForRendering(0);
+			ANKI_CHECK(renderReflection(rctx, node, entry, faces));
+		}
 	}
-	ANKI_ASSERT(probeIdx == visRez.getCount(VisibilityGroupType::REFLECTION_PROBES));
+
+	// Mark the faces of the next frame
+	scheduleFaces(rctx, WeakArray<VisibleNode>(probes, probeCount));
 
 	// Bye
 	ANKI_TRACE_STOP_EVENT(RENDER_IR);
 	return ErrorCode::NONE;
 }
 
-Error Ir::tryRender(RenderingContext& ctx, SceneNode& node, U& probesRendered)
+/// Compute a hash of what a face of a probe sees.
+static U64 computeFaceContentHash(FrustumComponent& frc)
 {
-	ReflectionProbeComponent& reflc = node.getComponent<ReflectionProbeComponent>();
-
-	Bool render = false;
-	U entry;
-	findCacheEntry(node, entry, render);
-
-	// Write shader var
-	reflc.setTextureArrayIndex(entry);
+	const VisibilityTestResults& vis = frc.getVisibilityTestResults();
+	const Array<VisibilityGroupType, 3> groups = {
+		{VisibilityGroupType::RENDERABLES_MS, VisibilityGroupType::LIGHTS_POINT, VisibilityGroupType::LIGHTS_SPOT}};
 
-	if(reflc.getMarkedForRendering() && probesRendered < MAX_PROBE_RENDERS_PER_FRAME)
+	// Add the hashes so the order of the nodes doesn't matter
+	U64 hash = 0;
+	for(VisibilityGroupType group : groups)
 	{
-		++probesRendered;
-		reflc.setMarkedForRendering(false);
-		ANKI_CHECK(renderReflection(ctx, node, entry));
-	}
+		for(const VisibleNode* it = vis.getBegin(group); it != vis.getEnd(group); ++it)
+		{
+			const SceneNode& node = *it->m_node;
+			const MoveComponent* movc = node.tryGetComponent<MoveComponent>();
 
-	// If you need to render it mark it for the next frame
-	if(render)
-	{
-		reflc.setMarkedForRendering(true);
+			Array<U64, 2> key = {{node.getUuid(), (movc) ? movc->getTimestamp() : 0}};
+			hash += computeHash(&key[0], sizeof(key));
+		}
 	}
 
-	return ErrorCode::NONE;
+	return hash;
 }
 
-Error Ir::renderReflection(RenderingContext& ctx, SceneNode& node, U cubemapIdx)
+Error Ir::renderReflection(RenderingContext& ctx, SceneNode& node, U cubemapIdx, U8 faces)
 {
+	ANKI_ASSERT(faces && faces <= ALL_FACES);
 	ANKI_TRACE_INC_COUNTER(RENDERER_REFLECTIONS, 1);
+	CacheEntry& entry = m_cacheEntries[cubemapIdx];
 
 	// Gather the frustum components
 	Array<FrustumComponent*, 6> frustumComponents;
@@ -718,81 +756,132 @@ Error Ir::renderReflection(RenderingContext& ctx, SceneNode& node, U cubemapIdx)
 	(void)err;
 	ANKI_ASSERT(count == 6);
 
-	// Render cubemap
+	// Render the faces
 	for(U i = 0; i < 6; ++i)
 	{
+		const U8 bit = 1 << i;
+		if(!(faces & bit))
+		{
+			continue;
+		}
+
+		ANKI_TRACE_INC_COUNTER(RENDERER_REFLECTION_FACES, 1);
+
 		ANKI_CHECK(runMs(ctx, *frustumComponents[i], cubemapIdx, i));
 		runIs(ctx, *frustumComponents[i], cubemapIdx, i);
-		computeIrradiance(ctx, cubemapIdx, i);
+
+		// If the face changed since its last render it will probably change again
+		const U64 hash = computeFaceContentHash(*frustumComponents[i]);
+		if((entry.m_renderedFaces & bit) && hash != entry.m_faceContentHashes[i])
+		{
+			entry.m_dynamicFaces |= bit;
+		}
+		else
+		{
+			entry.m_dynamicFaces &= ~bit;
+		}
+
+		entry.m_faceContentHashes[i] = hash;
+		entry.m_faceTimestamps[i] = m_r->getGlobalTimestamp();
+	}
+
+	entry.m_dirtyFaces &= ~faces;
+
+	// Irradiance samples the whole cube so wait for all the faces. After that update the faces that were rendered
+	const Bool firstTime = entry.m_renderedFaces != ALL_FACES;
+	entry.m_renderedFaces |= faces;
+	if(entry.m_renderedFaces == ALL_FACES)
+	{
+		const U8 irradianceFaces = (firstTime) ? ALL_FACES : faces;
+		for(U i = 0; i < 6; ++i)
+		{
+			if(irradianceFaces & (1 << i))
+			{
+				computeIrradiance(ctx, cubemapIdx, i);
+			}
+		}
 	}
 
 	return ErrorCode::NONE;
 }
 
-void Ir::findCacheEntry(SceneNode& node, U& entry, Bool& render)
+void Ir::scheduleFaces(RenderingContext& ctx, WeakArray<VisibleNode> probes)
 {
-	CacheEntry* it = m_cacheEntries.getBegin();
-	const CacheEntry* const end = m_cacheEntries.getEnd();
+	const U probeCount = probes.getSize();
+	if(probeCount == 0)
+	{
+		return;
+	}
 
-	CacheEntry* canditate = nullptr;
-	CacheEntry* empty = nullptr;
-	CacheEntry* kick = nullptr;
-	Timestamp kickTime = MAX_TIMESTAMP;
+	// Faces that were never rendered come first. The rest are prioritized by how long ago they were rendered
+	const F32 NEW_FACE_PRIORITY = 1000.0;
 
-	while(it != end)
+	const Timestamp crntTimestamp = m_r->getGlobalTimestamp();
+	const Bool resourcesLoaded = m_r->resourcesLoaded();
+
+	DynamicArrayAuto<FaceCandidate> candidates(ctx.m_tempAllocator);
+	candidates.create(probeCount * 6);
+	U candidateCount = 0;
+
+	for(U i = 0; i < probeCount; ++i)
 	{
-		if(it->m_nodeUuid == node.getUuid())
-		{
-			// Already there
-			ANKI_ASSERT(it->m_node == &node);
-			canditate = it;
-			break;
-		}
-		else if(empty == nullptr && it->m_node == nullptr)
+		SceneNode& node = *probes[i].m_node;
+		ReflectionProbeComponent& reflc = node.getComponent<ReflectionProbeComponent>();
+		CacheEntry& entry = m_cacheEntries[reflc.getTextureArrayIndex()];
+
+		if(resourcesLoaded)
 		{
-			// Found empty
-			empty = it;
+			entry.m_dirtyFaces = ALL_FACES;
 		}
-		else if(it->m_timestamp < kickTime)
+
+		// Closer probes are more important
+		const F32 distance = max<F32>(sqrt(probes[i].m_frustumDistanceSquared) - reflc.getRadius(), 0.0);
+		const Timestamp moveTimestamp = node.getComponent<MoveComponent>().getTimestamp();
+
+		for(U f = 0; f < 6; ++f)
 		{
-			// Found one to kick
-			kick = it;
-			kickTime = it->m_timestamp;
-		}
+			const U8 bit = 1 << f;
 
-		++it;
-	}
+			if(moveTimestamp > entry.m_faceTimestamps[f])
+			{
+				entry.m_dirtyFaces |= bit;
+			}
 
-	if(canditate)
-	{
-		// Update timestamp
-		canditate->m_timestamp = m_r->getFrameCount();
-		it = canditate;
-		render = m_r->resourcesLoaded();
-	}
-	else if(empty)
-	{
-		ANKI_ASSERT(empty->m_node == nullptr);
-		empty->m_node = &node;
-		empty->m_nodeUuid = node.getUuid();
-		empty->m_timestamp = m_r->getFrameCount();
+			if(!((entry.m_dirtyFaces | entry.m_dynamicFaces) & bit))
+			{
+				continue;
+			}
 
-		it = empty;
-		render = true;
+			F32 priority = F32(crntTimestamp - entry.m_faceTimestamps[f]);
+			if(!(entry.m_renderedFaces & bit))
+			{
+				priority += NEW_FACE_PRIORITY;
+			}
+
+			FaceCandidate& candidate = candidates[candidateCount++];
+			candidate.m_probe = &reflc;
+			candidate.m_face = f;
+			candidate.m_priority = priority / (1.0 + distance);
+		}
 	}
-	else
+
+	// Mark the most important
+	const U markCount = min<U>(candidateCount, m_maxFacesPerFrame);
+	if(markCount == 0)
 	{
-		ANKI_ASSERT(kick);
+		return;
+	}
 
-		kick->m_node = &node;
-		kick->m_nodeUuid = node.getUuid();
-		kick->m_timestamp = m_r->getFrameCount();
+	std::partial_sort(candidates.getBegin(),
+		candidates.getBegin() + markCount,
+		candidates.getBegin() + candidateCount,
+		[](const FaceCandidate& a, const FaceCandidate& b) { return a.m_priority > b.m_priority; });
 
-		it = kick;
-		render = true;
+	for(U i = 0; i < markCount; ++i)
+	{
+		ReflectionProbeComponent& reflc = *candidates[i].m_probe;
+		reflc.setFacesMarkedForRendering(reflc.getFacesMarkedForRendering() | (1 << candidates[i].m_face));
 	}
-
-	entry = it - m_cacheEntries.getBegin();
 }
 
 } // end namespace anki
@@ -8,6 +8,7 @@
 #include <anki/renderer/Renderer.h>
 #include <anki/renderer/RenderingPass.h>
 #include <anki/renderer/Clusterer.h>
+#include <anki/renderer/ProbeCache.h>
 #include <anki/resource/TextureResource.h>
 
 namespace anki
@@ -22,7 +23,8 @@ class ReflectionProbeComponent;
 /// @addtogroup renderer
 /// @{
 
-/// Image based reflections.
+/// Image based reflections. The faces of the probes are rendered progressively. Every frame a number of faces is picked
+/// based on the distance of the probe, how old the face is and if its contents change.
 class Ir : public RenderingPass
 {
 	friend class IrTask;
@@ -87,18 +89,46 @@ private:
 	class CacheEntry
 	{
 	public:
-		const SceneNode* m_node = nullptr;
-		U64 m_nodeUuid;
-		Timestamp m_timestamp = 0; ///< When last accessed.
-
 		Array<FaceInfo, 6> m_faces;
+
+		/// @name Face updates
+		/// @{
+		Array<Timestamp, 6> m_faceTimestamps; ///< When the faces were last rendered.
+		Array<U64, 6> m_faceContentHashes; ///< The visible nodes of the faces when they were last rendered.
+		U8 m_renderedFaces = 0; ///< The faces that have valid contents.
+		U8 m_dirtyFaces = 0; ///< The faces that need to be rendered.
+		U8 m_dynamicFaces = 0; ///< The faces that changed between the last two renders.
+		/// @}
+
+		void resetFaces()
+		{
+			for(U i = 0; i < 6; ++i)
+			{
+				m_faceTimestamps[i] = 0;
+				m_faceContentHashes[i] = 0;
+			}
+
+			m_renderedFaces = 0;
+			m_dirtyFaces = ALL_FACES;
+			m_dynamicFaces = 0;
+		}
+	};
+
+	/// A face that needs to be rendered.
+	class FaceCandidate
+	{
+	public:
+		ReflectionProbeComponent* m_probe;
+		U8 m_face;
+		F32 m_priority;
 	};
 
 	static const U IRRADIANCE_TEX_SIZE = 32;
-	static const U MAX_PROBE_RENDERS_PER_FRAME = 1;
+	static const U8 ALL_FACES = (1 << 6) - 1;
 
 	U16 m_cubemapArrSize = 0;
 	U16 m_fbSize = 0;
+	U16 m_maxFacesPerFrame = 0;
 
 	// IS
 	class
@@ -134,6 +164,7 @@ private:
 	} m_irradiance;
 
 	DynamicArray<CacheEntry> m_cacheEntries;
+	ProbeCache m_probeCache; ///< Gives the cache entries to the probes.
 
 	// Other
 	TextureResourcePtr m_integrationLut;
@@ -146,16 +177,15 @@ private:
 	ANKI_USE_RESULT Error loadMesh(CString fname, BufferPtr& vert, BufferPtr& idx, U32& idxCount);
 
 	// Rendering
-	ANKI_USE_RESULT Error tryRender(RenderingContext& ctx, SceneNode& node, U& probesRendered);
+	/// Decide which faces will be rendered in the next frame.
+	void scheduleFaces(RenderingContext& ctx, WeakArray<VisibleNode> probes);
 
 	ANKI_USE_RESULT Error runMs(RenderingContext& rctx, FrustumComponent& frc, U layer, U faceIdx);
 	void runIs(RenderingContext& rctx, FrustumComponent& frc, U layer, U faceIdx);
 	void computeIrradiance(RenderingContext& rctx, U layer, U faceIdx);
 
-	ANKI_USE_RESULT Error renderReflection(RenderingContext& ctx, SceneNode& node, U cubemapIdx);
-
-	/// Find a cache entry to store the reflection.
-	void findCacheEntry(SceneNode& node, U& entry, Bool& render);
+	/// Render some faces of a probe and update the irradiance.
+	ANKI_USE_RESULT Error renderReflection(RenderingContext& ctx, SceneNode& node, U cubemapIdx, U8 faces);
 };
 /// @}
 
@@ -710,12 +710,19 @@ I LightBin::writeSpotLight(const LightComponent& lightc,
 	ShaderSpotLight& light = ctx.m_spotLights[i];
 	F32 shadowmapIndex = INVALID_TEXTURE_INDEX;
 
-	if(lightc.getShadowEnabled() && ctx.m_shadowsEnabled)
+	if(lightc.getShadowEnabled() && ctx.m_shadowsEnabled && lightc.hasShadowMapIndex())
 	{
 		// Write matrix
 		static const Mat4 biasMat4(0.5, 0.0, 0.0, 0.5, 0.0, 0.5, 0.0, 0.5, 0.0, 0.0, 0.5, 0.5, 0.0, 0.0, 0.0, 1.0);
-		// bias * proj_l * view_l * world_c
-		light.m_texProjectionMat = biasMat4 * lightFrc->getViewProjectionMatrix() * Mat4(camMove.getWorldTransform());
+
+		// Map to the region of the shadow atlas
+		const Vec4& region = lightc.getShadowMapRegion();
+		const Mat4 regionMat4(
+			region.x(), 0.0, 0.0, region.z(), 0.0, region.y(), 0.0, region.w(), 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0);
+
+		// region * bias * proj_l * view_l * world_c
+		light.m_texProjectionMat =
+			regionMat4 * biasMat4 * lightFrc->getViewProjectionMatrix() * Mat4(camMove.getWorldTransform());
 
 		shadowmapIndex = F32(lightc.getShadowMapIndex());
 	}
@@ -795,6 +802,12 @@ void LightBin::writeAndBinProbe(
 	const ReflectionProbeComponent& reflc = node.getComponent<ReflectionProbeComponent>();
 	const SpatialComponent& sp = node.getComponent<SpatialComponent>();
 
+	// The probes that didn't fit in the texture array are ignored
+	if(!reflc.hasTextureArrayIndex())
+	{
+		return;
+	}
+
 	// Write it
 	ShaderProbe probe;
 	probe.m_pos = (camFrc.getViewMatrix() * reflc.getPosition().xyz1()).xyz();
@@ -0,0 +1,98 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/renderer/LodSelector.h>
+#include <anki/util/Assert.h>
+#include <anki/util/Functions.h>
+#include <anki/math/Functions.h>
+
+namespace anki
+{
+
+/// The bias goes back down only when the frames are well below the budget. Otherwise it would move every frame.
+static const F32 UNDER_BUDGET = 0.9;
+
+void LodSelector::init(F32 maxScreenError, F32 hysteresis, U32 triangleBudget)
+{
+	ANKI_ASSERT(maxScreenError > 0.0);
+	ANKI_ASSERT(hysteresis >= 0.0 && hysteresis < 1.0);
+
+	m_maxScreenError = maxScreenError;
+	m_hysteresis = hysteresis;
+	m_triangleBudget = triangleBudget;
+	m_bias = 1.0;
+	m_triangleCount.set(0);
+}
+
+F32 LodSelector::computeProjectionScale(F32 fovY, F32 screenHeight)
+{
+	ANKI_ASSERT(fovY > 0.0 && screenHeight > 0.0);
+	return screenHeight / (2.0 * tan(fovY / 2.0));
+}
+
+F32 LodSelector::computeScreenError(F32 error, F32 distance, F32 projectionScale) const
+{
+	return error * projectionScale / max(distance, EPSILON);
+}
+
+U LodSelector::selectLod(WeakArray<const F32> errors, F32 distance, F32 projectionScale, U prevLod) const
+{
+	ANKI_ASSERT(errors.getSize() > 0);
+	const U lastLod = errors.getSize() - 1;
+	const F32 threshold = m_maxScreenError * m_bias;
+
+	// Without history take the coarsest LOD that is good enough
+	if(prevLod == MAX_U)
+	{
+		U lod = 0;
+		while(lod < lastLod && computeScreenError(errors[lod + 1], distance, projectionScale) <= threshold)
+		{
+			++lod;
+		}
+
+		return lod;
+	}
+
+	// Move away from the previous LOD only when the error is out of the band around the threshold
+	U lod = min(prevLod, lastLod);
+	const U startLod = lod;
+	while(lod < lastLod
+		&& computeScreenError(errors[lod + 1], distance, projectionScale) <= threshold * (1.0 - m_hysteresis))
+	{
+		++lod;
+	}
+
+	if(lod == startLod)
+	{
+		while(lod > 0 && computeScreenError(errors[lod], distance, projectionScale) > threshold * (1.0 + m_hysteresis))
+		{
+			--lod;
+		}
+	}
+
+	return lod;
+}
+
+U32 LodSelector::beginFrame()
+{
+	const U32 triangleCount = m_triangleCount.exchange(0);
+
+	if(m_triangleBudget == 0)
+	{
+		m_bias = 1.0;
+	}
+	else if(triangleCount > m_triangleBudget)
+	{
+		m_bias = min(m_bias * BIAS_STEP, MAX_BIAS);
+	}
+	else if(F32(triangleCount) < F32(m_triangleBudget) * UNDER_BUDGET)
+	{
+		m_bias = max(m_bias / BIAS_STEP, 1.0f);
+	}
+
+	return triangleCount;
+}
+
+} // end namespace anki
@@ -0,0 +1,75 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/util/StdTypes.h>
+#include <anki/util/DynamicArray.h>
+#include <anki/util/Atomic.h>
+
+namespace anki
+{
+
+/// @addtogroup renderer
+/// @{
+
+/// Picks the LODs from the size of their geometric error on the screen. A LOD is good enough if its error covers less
+/// pixels than a threshold. The threshold has a band around it that a renderable has to cross to change its LOD so the
+/// LODs don't pop back and forth at the boundary. An optional budget of triangles scales the threshold every frame.
+class LodSelector
+{
+public:
+	/// The bias changes by that factor every frame that is outside the budget.
+	static constexpr F32 BIAS_STEP = 1.1;
+
+	/// The max bias. It's the max factor of the threshold.
+	static constexpr F32 MAX_BIAS = 16.0;
+
+	/// @param maxScreenError The max error of a LOD on the screen in pixels.
+	/// @param hysteresis The width of the band around the threshold as a fraction of it.
+	/// @param triangleBudget The triangles to aim for every frame. Zero to disable the budget.
+	void init(F32 maxScreenError, F32 hysteresis, U32 triangleBudget = 0);
+
+	/// Compute the factor that takes a length at a distance of 1 to pixels.
+	/// @param fovY The vertical FOV of the camera.
+	/// @param screenHeight The height of the screen in pixels.
+	static F32 computeProjectionScale(F32 fovY, F32 screenHeight);
+
+	/// Pick a LOD. Thread safe.
+	/// @param errors The geometric errors of the LODs in world space. They grow with the LOD.
+	/// @param distance The distance from the camera.
+	/// @param projectionScale See computeProjectionScale().
+	/// @param prevLod The LOD of the previous frame or MAX_U if there is no previous frame.
+	U selectLod(WeakArray<const F32> errors, F32 distance, F32 projectionScale, U prevLod = MAX_U) const;
+
+	/// Add the triangles that a renderable draws in this frame. Thread safe.
+	void addTriangles(U32 count)
+	{
+		m_triangleCount.fetchAdd(count);
+	}
+
+	/// Start a new frame. It compares the triangles of the previous frame with the budget and moves the bias.
+	/// @return The triangles of the previous frame.
+	U32 beginFrame();
+
+	/// The factor of the threshold. It's more than one when the frames are over the budget.
+	F32 getErrorBias() const
+	{
+		return m_bias;
+	}
+
+private:
+	F32 m_maxScreenError = 1.0;
+	F32 m_hysteresis = 0.0;
+	U32 m_triangleBudget = 0;
+
+	F32 m_bias = 1.0;
+	Atomic<U32> m_triangleCount = {0};
+
+	F32 computeScreenError(F32 error, F32 distance, F32 projectionScale) const;
+};
+/// @}
+
+} // end namespace anki
@@ -77,6 +77,14 @@ Error MainRenderer::create(ThreadPool* threadpool,
 		m_r->getHeight(),
 		TILE_SIZE);
 
+	// Init dynamic resolution
+	m_dynamicResEnabled = config.getNumber("dynamicResolution");
+	if(m_dynamicResEnabled)
+	{
+		m_dynamicRes.init(
+			config.getNumber("dynamicResolutionTargetFrameTime"), config.getNumber("dynamicResolutionMinScale"));
+	}
+
 	// Init other
 	if(!m_rDrawToDefaultFb)
 	{
@@ -126,6 +134,20 @@ Error MainRenderer::render(SceneGraph& scene)
 
 	ctx.m_commandBuffer = cmdb;
 	ctx.m_frustumComponent = &scene.getActiveCamera().getComponent<FrustumComponent>();
+
+	// Feed the GPU time of the last frame that the GPU finished. The CPU time would lower the resolution of frames that
+	// are bound by the CPU
+	if(m_dynamicResEnabled)
+	{
+		const F64 gpuFrameTime = gl.getGpuFrameTime();
+		if(gpuFrameTime > 0.0)
+		{
+			m_dynamicRes.update(gpuFrameTime);
+		}
+	}
+
+	ANKI_TRACE_INC_COUNTER(RENDERER_RESOLUTION_SCALE, U(m_dynamicRes.getScale() * 100.0 + 0.5));
+
 	ANKI_CHECK(m_r->render(ctx));
 
 	// Blit renderer's result to default FB if needed
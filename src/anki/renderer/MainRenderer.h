@@ -6,6 +6,7 @@
 #pragma once
 
 #include <anki/renderer/Common.h>
+#include <anki/renderer/DynamicResolution.h>
 #include <anki/resource/Forward.h>
 #include <anki/core/Timestamp.h>
 
@@ -59,6 +60,12 @@ public:
 		return *m_r;
 	}
 
+	/// Get the fraction of the resolution that DynamicResolution suggests for the next frame. Nothing renders in it yet.
+	F32 getSuggestedResolutionScale() const
+	{
+		return m_dynamicRes.getScale();
+	}
+
 private:
 	HeapAllocator<U8> m_alloc;
 	StackAllocator<U8> m_frameAlloc;
@@ -78,6 +85,12 @@ private:
 
 	F32 m_renderingQuality = 1.0;
 
+	/// @name Dynamic resolution
+	/// @{
+	DynamicResolution m_dynamicRes;
+	Bool8 m_dynamicResEnabled = false;
+	/// @}
+
 	/// Optimize job chain
 	CommandBufferInitHints m_cbInitHints;
 };
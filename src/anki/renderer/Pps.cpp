@@ -40,13 +40,16 @@ Error Pps::initInternal(const ConfigSet& config)
 
 	if(!m_r->getDrawToDefaultFramebuffer())
 	{
-		m_r->createRenderTarget(m_r->getWidth(),
+		m_rtInit = m_r->createRenderTargetInitInfo(m_r->getWidth(),
 			m_r->getHeight(),
 			RT_PIXEL_FORMAT,
-			TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE | TextureUsageBit::SAMPLED_FRAGMENT,
+			TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE | TextureUsageBit::SAMPLED_FRAGMENT | TextureUsageBit::CLEAR,
 			SamplingFilter::LINEAR,
-			1,
-			m_rt);
+			1);
+		m_rt = getGrManager().newInstance<Texture>(m_rtInit);
+
+		// Every frame starts with it sampled
+		m_r->clearRenderTarget(m_rt, ClearValue(), TextureUsageBit::SAMPLED_FRAGMENT);
 
 		FramebufferInitInfo fbInit;
 		fbInit.m_colorAttachmentCount = 1;
@@ -82,6 +85,36 @@ Error Pps::loadColorGradingTexture(CString filename)
 	return ErrorCode::NONE;
 }
 
+void Pps::populateRenderGraph(RenderingContext& ctx)
+{
+	RenderGraph& graph = m_r->getRenderGraph();
+
+	U pass = graph.newPass("PPS", runCallback, this);
+	graph.newRead(pass, ctx.m_bloom.m_upscaleRt, TextureUsageBit::SAMPLED_FRAGMENT);
+
+	if(ctx.m_outFb.isCreated())
+	{
+		// Draws outside the graph
+		graph.setSideEffect(pass);
+	}
+	else
+	{
+		// The MainRenderer of the previous frame left it sampled
+		ctx.m_pps.m_rt = graph.importTexture(m_rt, m_rtInit, TextureUsageBit::SAMPLED_FRAGMENT, "PPS");
+		graph.newWrite(pass, ctx.m_pps.m_rt, TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE);
+
+		// Leave it sampled for the MainRenderer
+		pass = graph.newPass("PPS out", nullptr, nullptr);
+		graph.newRead(pass, ctx.m_pps.m_rt, TextureUsageBit::SAMPLED_FRAGMENT);
+		graph.setSideEffect(pass);
+	}
+}
+
+Error Pps::runCallback(RenderGraphRunContext& rctx)
+{
+	return static_cast<Pps*>(rctx.m_userData)->run(*static_cast<RenderingContext*>(rctx.m_frameUserData));
+}
+
 Error Pps::run(RenderingContext& ctx)
 {
 	CommandBufferPtr& cmdb = ctx.m_commandBuffer;
@@ -165,12 +198,13 @@ Error Pps::run(RenderingContext& ctx)
 	}
 
 	// Get or create the resource group
+	TexturePtr bloomRt = m_r->getRenderGraph().getTexture(ctx.m_bloom.m_upscaleRt);
 	ResourceGroupPtr& rsrc = m_rcGroup[dbgEnabled];
-	if(!rsrc || m_lutDirty)
+	if(!rsrc || m_lutDirty || bloomRt != m_rcGroupBloomRt[dbgEnabled])
 	{
 		ResourceGroupInitInfo rcInit;
 		rcInit.m_textures[0].m_texture = m_r->getIs().getRt();
-		rcInit.m_textures[1].m_texture = m_r->getBloom().m_upscale.m_rt;
+		rcInit.m_textures[1].m_texture = bloomRt;
 		rcInit.m_textures[2].m_texture = m_lut->getGrTexture();
 		rcInit.m_textures[3].m_texture = m_r->getSmaa().m_weights.m_rt;
 		if(dbgEnabled)
@@ -182,6 +216,7 @@ Error Pps::run(RenderingContext& ctx)
 		rcInit.m_storageBuffers[0].m_usage = BufferUsageBit::STORAGE_FRAGMENT_READ;
 
 		rsrc = getGrManager().newInstance<ResourceGroup>(rcInit);
+		m_rcGroupBloomRt[dbgEnabled] = bloomRt;
 
 		m_lutDirty = false;
 	}
@@ -209,14 +244,6 @@ Error Pps::run(RenderingContext& ctx)
 	m_r->drawQuad(cmdb);
 	cmdb->endRenderPass();
 
-	if(!drawToDefaultFb)
-	{
-		cmdb->setTextureSurfaceBarrier(m_rt,
-			TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE,
-			TextureUsageBit::SAMPLED_FRAGMENT,
-			TextureSurfaceInfo(0, 0, 0, 0));
-	}
-
 	return ErrorCode::NONE;
 }
 
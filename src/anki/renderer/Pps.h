@@ -28,7 +28,9 @@ anki_internal:
 	~Pps();
 
 	ANKI_USE_RESULT Error init(const ConfigSet& config);
-	ANKI_USE_RESULT Error run(RenderingContext& ctx);
+
+	/// Add the pass. The MainRenderer samples the result after the render graph.
+	void populateRenderGraph(RenderingContext& ctx);
 
 	const TexturePtr& getRt() const
 	{
@@ -47,8 +49,10 @@ private:
 	Array2d<ShaderResourcePtr, 2, 2> m_frag; ///< One with Dbg and one without
 	ShaderResourcePtr m_vert;
 	Array2d<PipelinePtr, 2, 2> m_ppline; ///< With Dbg, Default FB or not
-	TexturePtr m_rt;
+	TexturePtr m_rt; ///< It outlives the render graph so it's imported.
+	TextureInitInfo m_rtInit;
 	Array<ResourceGroupPtr, 2> m_rcGroup; ///< One with Dbg and one without
+	Array<TexturePtr, 2> m_rcGroupBloomRt; ///< The bloom of m_rcGroup. The render graph may give another.
 
 	TextureResourcePtr m_lut; ///< Color grading lookup texture.
 	Bool8 m_lutDirty = true;
@@ -56,6 +60,10 @@ private:
 	Bool8 m_sharpenEnabled = false;
 
 	ANKI_USE_RESULT Error initInternal(const ConfigSet& config);
+
+	ANKI_USE_RESULT Error run(RenderingContext& ctx);
+
+	static ANKI_USE_RESULT Error runCallback(RenderGraphRunContext& rctx);
 };
 /// @}
 
@@ -0,0 +1,83 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/renderer/ProbeCache.h>
+
+namespace anki
+{
+
+ProbeCache::~ProbeCache()
+{
+	m_entries.destroy(m_alloc);
+}
+
+void ProbeCache::init(GenericMemoryPoolAllocator<U8> alloc, U32 entryCount)
+{
+	ANKI_ASSERT(entryCount > 0);
+	m_alloc = alloc;
+	m_entries.create(m_alloc, entryCount);
+}
+
+void ProbeCache::assign(WeakArray<const U64> ids, WeakArray<U32> entries, WeakArray<Bool8> newEntries)
+{
+	ANKI_ASSERT(ids.getSize() <= m_entries.getSize());
+	ANKI_ASSERT(entries.getSize() == ids.getSize() && newEntries.getSize() == ids.getSize());
+
+	++m_frame;
+
+	// First touch the entries of all the probes that are already in. If a new probe came first it could evict the
+	// entry of a probe that is visible but not touched yet
+	for(U i = 0; i < ids.getSize(); ++i)
+	{
+		ANKI_ASSERT(ids[i] != MAX_U64);
+		entries[i] = MAX_U32;
+		newEntries[i] = false;
+
+		for(U j = 0; j < m_entries.getSize(); ++j)
+		{
+			if(m_entries[j].m_id == ids[i])
+			{
+				m_entries[j].m_lastUsedFrame = m_frame;
+				entries[i] = j;
+				break;
+			}
+		}
+	}
+
+	// Then give the rest the empty or the least recently used entries. The entries of this frame are never taken
+	for(U i = 0; i < ids.getSize(); ++i)
+	{
+		if(entries[i] != MAX_U32)
+		{
+			continue;
+		}
+
+		U kick = MAX_U32;
+		for(U j = 0; j < m_entries.getSize(); ++j)
+		{
+			const Entry& entry = m_entries[j];
+			if(entry.m_id == MAX_U64)
+			{
+				kick = j;
+				break;
+			}
+
+			if(entry.m_lastUsedFrame < m_frame
+				&& (kick == MAX_U32 || entry.m_lastUsedFrame < m_entries[kick].m_lastUsedFrame))
+			{
+				kick = j;
+			}
+		}
+
+		// There are not more probes than entries so there is always one
+		ANKI_ASSERT(kick != MAX_U32);
+		m_entries[kick].m_id = ids[i];
+		m_entries[kick].m_lastUsedFrame = m_frame;
+		entries[i] = kick;
+		newEntries[i] = true;
+	}
+}
+
+} // end namespace anki
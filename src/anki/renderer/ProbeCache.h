@@ -0,0 +1,55 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/util/DynamicArray.h>
+
+namespace anki
+{
+
+/// @addtogroup renderer
+/// @{
+
+/// Gives the entries of a fixed size cache to the probes of a frame. A probe keeps its entry for as long as it's in the
+/// cache. The new probes take the empty entries first and then the least recently used entries of the probes that are
+/// not in the frame. The probes of a frame never take entries from each other.
+class ProbeCache : public NonCopyable
+{
+public:
+	ProbeCache()
+	{
+	}
+
+	~ProbeCache();
+
+	void init(GenericMemoryPoolAllocator<U8> alloc, U32 entryCount);
+
+	/// Give entries to the probes of a frame. Call it once per frame.
+	/// @param[in] ids The probes. Their IDs should be unique and not MAX_U64. Not more than the entries.
+	/// @param[out] entries The entry of each probe. Same size as the IDs.
+	/// @param[out] newEntries True for the probes that got a new entry. Its old contents are not valid for them.
+	void assign(WeakArray<const U64> ids, WeakArray<U32> entries, WeakArray<Bool8> newEntries);
+
+	U32 getEntryCount() const
+	{
+		return m_entries.getSize();
+	}
+
+private:
+	class Entry
+	{
+	public:
+		U64 m_id = MAX_U64; ///< MAX_U64 if it's empty.
+		U64 m_lastUsedFrame = 0;
+	};
+
+	GenericMemoryPoolAllocator<U8> m_alloc;
+	DynamicArray<Entry> m_entries;
+	U64 m_frame = 0;
+};
+/// @}
+
+} // end namespace anki
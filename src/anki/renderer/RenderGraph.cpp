@@ -0,0 +1,487 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/renderer/RenderGraph.h>
+#include <anki/gr/common/Misc.h>
+
+namespace anki
+{
+
+TexturePtr RenderGraphGrInterface::newTexture(const TextureInitInfo& init)
+{
+	return m_gr->newInstance<Texture>(init);
+}
+
+void RenderGraphGrInterface::setTextureBarrier(CommandBufferPtr& cmdb,
+	TexturePtr tex,
+	const TextureInitInfo& init,
+	TextureUsageBit before,
+	TextureUsageBit after)
+{
+	const U faceCount = (init.m_type == TextureType::CUBE || init.m_type == TextureType::CUBE_ARRAY) ? 6 : 1;
+	const U layerCount =
+		(init.m_type == TextureType::_2D_ARRAY || init.m_type == TextureType::CUBE_ARRAY) ? init.m_layerCount : 1;
+
+	for(U level = 0; level < init.m_mipmapsCount; ++level)
+	{
+		if(init.m_type == TextureType::_3D)
+		{
+			cmdb->setTextureVolumeBarrier(tex, before, after, TextureVolumeInfo(level));
+			continue;
+		}
+
+		for(U layer = 0; layer < layerCount; ++layer)
+		{
+			for(U face = 0; face < faceCount; ++face)
+			{
+				cmdb->setTextureSurfaceBarrier(tex, before, after, TextureSurfaceInfo(level, 0, face, layer));
+			}
+		}
+	}
+}
+
+RenderGraph::~RenderGraph()
+{
+	reset();
+}
+
+void RenderGraph::init(RenderGraphInterface* iface, U32 maxUnusedFrames)
+{
+	ANKI_ASSERT(iface);
+	m_iface = iface;
+	m_maxUnusedFrames = maxUnusedFrames;
+}
+
+RenderGraphHandle RenderGraph::newTexture(const TextureInitInfo& init, CString name)
+{
+	ANKI_ASSERT(!m_compiled && "Reset first");
+	ANKI_ASSERT(m_textureCount < MAX_TEXTURES);
+
+	LogicalTexture& tex = m_textures[m_textureCount];
+	tex.m_name = name;
+	tex.m_init = init;
+	tex.m_init.m_usage = TextureUsageBit::NONE;
+	tex.m_importedTexture.reset(nullptr);
+	tex.m_usage = TextureUsageBit::NONE;
+	tex.m_imported = false;
+	tex.m_written = false;
+
+	return m_textureCount++;
+}
+
+RenderGraphHandle RenderGraph::importTexture(
+	TexturePtr tex, const TextureInitInfo& init, TextureUsageBit crntUsage, CString name)
+{
+	ANKI_ASSERT(!m_compiled && "Reset first");
+	ANKI_ASSERT(m_textureCount < MAX_TEXTURES);
+
+	LogicalTexture& t = m_textures[m_textureCount];
+	t.m_name = name;
+	t.m_init = init;
+	t.m_importedTexture = tex;
+	t.m_usage = crntUsage;
+	t.m_imported = true;
+	t.m_written = false;
+
+	return m_textureCount++;
+}
+
+U RenderGraph::newPass(CString name, RenderGraphPassCallback callback, void* userData)
+{
+	ANKI_ASSERT(!m_compiled && "Reset first");
+	ANKI_ASSERT(m_passCount < MAX_PASSES);
+
+	Pass& pass = m_passes[m_passCount];
+	pass.m_name = name;
+	pass.m_callback = callback;
+	pass.m_userData = userData;
+	pass.m_depCount = 0;
+	pass.m_barrierCount = 0;
+	pass.m_sideEffect = false;
+	pass.m_alive = false;
+
+	return m_passCount++;
+}
+
+void RenderGraph::newDependency(U pass, RenderGraphHandle tex, TextureUsageBit usage, Bool write)
+{
+	ANKI_ASSERT(!m_compiled && "Reset first");
+	ANKI_ASSERT(pass < m_passCount && tex < m_textureCount);
+	ANKI_ASSERT(usage != TextureUsageBit::NONE);
+
+	Pass& p = m_passes[pass];
+	ANKI_ASSERT(p.m_depCount < MAX_PASS_DEPENDENCIES);
+
+	Dependency& dep = p.m_deps[p.m_depCount++];
+	dep.m_texture = tex;
+	dep.m_usage = usage;
+	dep.m_write = write;
+}
+
+void RenderGraph::newRead(U pass, RenderGraphHandle tex, TextureUsageBit usage)
+{
+	newDependency(pass, tex, usage, false);
+}
+
+void RenderGraph::newWrite(U pass, RenderGraphHandle tex, TextureUsageBit usage)
+{
+	newDependency(pass, tex, usage, true);
+}
+
+void RenderGraph::setSideEffect(U pass)
+{
+	ANKI_ASSERT(pass < m_passCount);
+	m_passes[pass].m_sideEffect = true;
+}
+
+void RenderGraph::cullPasses()
+{
+	for(U t = 0; t < m_textureCount; ++t)
+	{
+		m_textures[t].m_needed = false;
+	}
+
+	// Walk backwards. A pass is needed if something outside the graph or a needed pass depends on what it writes
+	for(I p = I(m_passCount) - 1; p >= 0; --p)
+	{
+		Pass& pass = m_passes[p];
+		pass.m_alive = pass.m_sideEffect;
+
+		for(U d = 0; d < pass.m_depCount && !pass.m_alive; ++d)
+		{
+			const Dependency& dep = pass.m_deps[d];
+			const LogicalTexture& tex = m_textures[dep.m_texture];
+			pass.m_alive = dep.m_write && (tex.m_imported || tex.m_needed);
+		}
+
+		if(pass.m_alive)
+		{
+			for(U d = 0; d < pass.m_depCount; ++d)
+			{
+				const Dependency& dep = pass.m_deps[d];
+				if(!dep.m_write)
+				{
+					m_textures[dep.m_texture].m_needed = true;
+				}
+			}
+		}
+		else
+		{
+			++m_stats.m_culledPassCount;
+		}
+	}
+}
+
+void RenderGraph::computeLifetimes()
+{
+	for(U t = 0; t < m_textureCount; ++t)
+	{
+		m_textures[t].m_firstPass = MAX_U32;
+		m_textures[t].m_lastPass = 0;
+		m_textures[t].m_physical = MAX_U32;
+	}
+
+	for(U p = 0; p < m_passCount; ++p)
+	{
+		const Pass& pass = m_passes[p];
+		if(!pass.m_alive)
+		{
+			continue;
+		}
+
+		for(U d = 0; d < pass.m_depCount; ++d)
+		{
+			const Dependency& dep = pass.m_deps[d];
+			LogicalTexture& tex = m_textures[dep.m_texture];
+
+			tex.m_firstPass = min<U32>(tex.m_firstPass, p);
+			tex.m_lastPass = max<U32>(tex.m_lastPass, p);
+
+			// The texture that backs a transient texture should support all of its usages
+			if(!tex.m_imported)
+			{
+				tex.m_init.m_usage |= dep.m_usage;
+			}
+		}
+	}
+}
+
+Bool RenderGraph::compatible(const TextureInitInfo& a, const TextureInitInfo& b)
+{
+	return a.m_type == b.m_type && a.m_usage == b.m_usage && a.m_width == b.m_width && a.m_height == b.m_height
+		&& a.m_depth == b.m_depth
+		&& a.m_layerCount == b.m_layerCount
+		&& a.m_mipmapsCount == b.m_mipmapsCount
+		&& a.m_format == b.m_format
+		&& a.m_samples == b.m_samples
+		&& a.m_sampling.computeHash() == b.m_sampling.computeHash();
+}
+
+PtrSize RenderGraph::computeMemory(const TextureInitInfo& init)
+{
+	const U faceCount = (init.m_type == TextureType::CUBE || init.m_type == TextureType::CUBE_ARRAY) ? 6 : 1;
+	const U layerCount =
+		(init.m_type == TextureType::_2D_ARRAY || init.m_type == TextureType::CUBE_ARRAY) ? init.m_layerCount : 1;
+
+	PtrSize size = 0;
+	for(U level = 0; level < init.m_mipmapsCount; ++level)
+	{
+		const U width = max<U>(init.m_width >> level, 1);
+		const U height = max<U>(init.m_height >> level, 1);
+
+		if(init.m_type == TextureType::_3D)
+		{
+			size += computeVolumeSize(width, height, max<U>(init.m_depth >> level, 1), init.m_format);
+		}
+		else
+		{
+			size += computeSurfaceSize(width, height, init.m_format) * faceCount * layerCount;
+		}
+	}
+
+	return size * init.m_samples;
+}
+
+U32 RenderGraph::acquirePhysicalTexture(const LogicalTexture& tex)
+{
+	// Prefer the textures that were released earlier in this frame so the rest can expire
+	U32 idx = MAX_U32;
+	U32 emptyIdx = MAX_U32;
+	for(U32 i = 0; i < MAX_PHYSICAL_TEXTURES; ++i)
+	{
+		const PhysicalTexture& phys = m_physicalTextures[i];
+
+		if(phys.m_init.m_usage == TextureUsageBit::NONE)
+		{
+			emptyIdx = (emptyIdx == MAX_U32) ? i : emptyIdx;
+			continue;
+		}
+
+		const Bool free = !phys.m_usedThisFrame || phys.m_releasePass < tex.m_firstPass;
+		if(!free || !compatible(phys.m_init, tex.m_init))
+		{
+			continue;
+		}
+
+		if(idx == MAX_U32 || (phys.m_usedThisFrame && !m_physicalTextures[idx].m_usedThisFrame))
+		{
+			idx = i;
+		}
+	}
+
+	if(idx == MAX_U32)
+	{
+		ANKI_ASSERT(emptyIdx != MAX_U32 && "Increase MAX_PHYSICAL_TEXTURES");
+		idx = emptyIdx;
+
+		PhysicalTexture& phys = m_physicalTextures[idx];
+		phys.m_init = tex.m_init;
+		phys.m_texture = m_iface->newTexture(tex.m_init);
+		phys.m_usage = tex.m_init.m_initialUsage;
+	}
+
+	PhysicalTexture& phys = m_physicalTextures[idx];
+	if(!phys.m_usedThisFrame)
+	{
+		phys.m_usedThisFrame = true;
+		phys.m_lastUsedFrame = m_frame;
+		++m_stats.m_physicalTextureCount;
+		m_stats.m_physicalMemory += computeMemory(phys.m_init);
+	}
+
+	phys.m_releasePass = tex.m_lastPass;
+	return idx;
+}
+
+void RenderGraph::aliasTextures()
+{
+	// Acquire in the order of the first use. Lifetimes are intervals of pass indices so a texture can take the place
+	// of another that was last used by an earlier pass
+	for(U p = 0; p < m_passCount; ++p)
+	{
+		const Pass& pass = m_passes[p];
+		if(!pass.m_alive)
+		{
+			continue;
+		}
+
+		for(U d = 0; d < pass.m_depCount; ++d)
+		{
+			LogicalTexture& tex = m_textures[pass.m_deps[d].m_texture];
+			if(tex.m_imported || tex.m_firstPass != p || tex.m_physical != MAX_U32)
+			{
+				continue;
+			}
+
+			tex.m_physical = acquirePhysicalTexture(tex);
+			++m_stats.m_transientTextureCount;
+			m_stats.m_transientMemory += computeMemory(tex.m_init);
+		}
+	}
+}
+
+void RenderGraph::computeBarriers()
+{
+	for(U p = 0; p < m_passCount; ++p)
+	{
+		Pass& pass = m_passes[p];
+		if(!pass.m_alive)
+		{
+			continue;
+		}
+
+		// A pass may use a texture more than once. Transition it once to all the usages
+		for(U d = 0; d < pass.m_depCount; ++d)
+		{
+			const RenderGraphHandle handle = pass.m_deps[d].m_texture;
+
+			Bool seen = false;
+			Bool write = false;
+			TextureUsageBit usage = TextureUsageBit::NONE;
+			for(U dd = 0; dd < pass.m_depCount; ++dd)
+			{
+				if(pass.m_deps[dd].m_texture == handle)
+				{
+					seen = seen || dd < d;
+					write = write || pass.m_deps[dd].m_write;
+					usage |= pass.m_deps[dd].m_usage;
+				}
+			}
+
+			if(seen)
+			{
+				continue;
+			}
+
+			LogicalTexture& tex = m_textures[handle];
+			TextureUsageBit* crntUsage;
+			Bool8* written;
+			Bool aliased = false;
+			if(tex.m_imported)
+			{
+				crntUsage = &tex.m_usage;
+				written = &tex.m_written;
+			}
+			else
+			{
+				PhysicalTexture& phys = m_physicalTextures[tex.m_physical];
+				crntUsage = &phys.m_usage;
+				written = &phys.m_written;
+
+				// Another transient texture of this or of a previous frame may still access the memory
+				aliased = tex.m_firstPass == p && phys.m_usage != TextureUsageBit::NONE;
+			}
+
+			// The same usage doesn't make the writes of the previous pass visible
+			if(*crntUsage != usage || *written || aliased)
+			{
+				RenderGraphBarrier& barrier = pass.m_barriers[pass.m_barrierCount++];
+				barrier.m_texture = handle;
+				barrier.m_before = *crntUsage;
+				barrier.m_after = usage;
+
+				++m_stats.m_barrierCount;
+			}
+
+			*crntUsage = usage;
+			*written = write;
+		}
+	}
+}
+
+void RenderGraph::compile()
+{
+	ANKI_ASSERT(m_iface && "Not initialized");
+	ANKI_ASSERT(!m_compiled && "Reset first");
+
+	++m_frame;
+	m_stats = RenderGraphStats();
+	m_stats.m_passCount = m_passCount;
+
+	cullPasses();
+	computeLifetimes();
+	aliasTextures();
+	computeBarriers();
+
+	m_compiled = true;
+}
+
+Error RenderGraph::run(CommandBufferPtr cmdb, void* frameUserData)
+{
+	ANKI_ASSERT(m_compiled);
+
+	RenderGraphRunContext ctx;
+	ctx.m_graph = this;
+	ctx.m_commandBuffer = cmdb;
+	ctx.m_frameUserData = frameUserData;
+
+	for(U p = 0; p < m_passCount; ++p)
+	{
+		const Pass& pass = m_passes[p];
+		if(!pass.m_alive)
+		{
+			continue;
+		}
+
+		for(U b = 0; b < pass.m_barrierCount; ++b)
+		{
+			const RenderGraphBarrier& barrier = pass.m_barriers[b];
+			const LogicalTexture& tex = m_textures[barrier.m_texture];
+			const TextureInitInfo& init = (tex.m_imported) ? tex.m_init : m_physicalTextures[tex.m_physical].m_init;
+
+			m_iface->setTextureBarrier(cmdb, getTexture(barrier.m_texture), init, barrier.m_before, barrier.m_after);
+		}
+
+		if(pass.m_callback)
+		{
+			ctx.m_userData = pass.m_userData;
+			ANKI_CHECK(pass.m_callback(ctx));
+		}
+	}
+
+	return ErrorCode::NONE;
+}
+
+void RenderGraph::reset()
+{
+	for(U t = 0; t < m_textureCount; ++t)
+	{
+		m_textures[t].m_importedTexture.reset(nullptr);
+	}
+
+	m_textureCount = 0;
+	m_passCount = 0;
+	m_compiled = false;
+
+	// Release the textures that were not used for a while
+	for(PhysicalTexture& phys : m_physicalTextures)
+	{
+		if(phys.m_init.m_usage == TextureUsageBit::NONE)
+		{
+			continue;
+		}
+
+		phys.m_usedThisFrame = false;
+		if(m_frame - phys.m_lastUsedFrame > m_maxUnusedFrames)
+		{
+			phys = PhysicalTexture();
+		}
+	}
+}
+
+TexturePtr RenderGraph::getTexture(RenderGraphHandle tex) const
+{
+	ANKI_ASSERT(m_compiled && tex < m_textureCount);
+	const LogicalTexture& t = m_textures[tex];
+	if(t.m_imported)
+	{
+		return t.m_importedTexture;
+	}
+
+	ANKI_ASSERT(t.m_physical != MAX_U32 && "The texture is not used by any pass");
+	return m_physicalTextures[t.m_physical].m_texture;
+}
+
+} // end namespace anki
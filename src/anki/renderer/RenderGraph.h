@@ -0,0 +1,274 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/renderer/Common.h>
+#include <anki/util/Array.h>
+
+namespace anki
+{
+
+// Forward
+class RenderGraph;
+
+/// @addtogroup renderer
+/// @{
+
+/// A texture of the RenderGraph.
+using RenderGraphHandle = U32;
+
+/// What a pass gets when it runs.
+class RenderGraphRunContext
+{
+public:
+	RenderGraph* m_graph;
+	CommandBufferPtr m_commandBuffer;
+	void* m_userData; ///< What was given to RenderGraph::newPass.
+	void* m_frameUserData; ///< What was given to RenderGraph::run.
+};
+
+using RenderGraphPassCallback = Error (*)(RenderGraphRunContext& ctx);
+
+/// A transition of a texture that happens before a pass.
+class RenderGraphBarrier
+{
+public:
+	RenderGraphHandle m_texture;
+	TextureUsageBit m_before;
+	TextureUsageBit m_after;
+};
+
+/// The user defined methods that touch the GPU. They are virtual so the graph can be tested without one.
+class RenderGraphInterface
+{
+public:
+	virtual ~RenderGraphInterface()
+	{
+	}
+
+	/// Create a texture that will back one or more transient textures.
+	virtual TexturePtr newTexture(const TextureInitInfo& init) = 0;
+
+	/// Transition all the surfaces of a texture.
+	virtual void setTextureBarrier(CommandBufferPtr& cmdb,
+		TexturePtr tex,
+		const TextureInitInfo& init,
+		TextureUsageBit before,
+		TextureUsageBit after) = 0;
+};
+
+/// The RenderGraphInterface that talks to the GrManager.
+class RenderGraphGrInterface : public RenderGraphInterface
+{
+public:
+	RenderGraphGrInterface(GrManager* gr)
+		: m_gr(gr)
+	{
+		ANKI_ASSERT(gr);
+	}
+
+	TexturePtr newTexture(const TextureInitInfo& init) override;
+
+	void setTextureBarrier(CommandBufferPtr& cmdb,
+		TexturePtr tex,
+		const TextureInitInfo& init,
+		TextureUsageBit before,
+		TextureUsageBit after) override;
+
+private:
+	GrManager* m_gr;
+};
+
+class RenderGraphStats
+{
+public:
+	U32 m_passCount = 0;
+	U32 m_culledPassCount = 0;
+	U32 m_transientTextureCount = 0; ///< The transient textures that the passes that survived use.
+	U32 m_physicalTextureCount = 0; ///< The textures that back them.
+	U32 m_barrierCount = 0;
+	PtrSize m_transientMemory = 0; ///< What the transient textures would need without aliasing.
+	PtrSize m_physicalMemory = 0; ///< What they need with aliasing. It's the peak of the frame.
+
+	PtrSize getSavedMemory() const
+	{
+		return m_transientMemory - m_physicalMemory;
+	}
+};
+
+/// A graph of the passes of a frame. The passes declare the textures they read and write and the graph:
+/// - Culls the passes that don't contribute to an imported texture or to something outside the graph.
+/// - Computes the lifetimes of the transient textures and makes the ones that don't overlap share the same memory.
+/// - Places the barriers between the passes. A pass gets a barrier when the usage of a texture changes, when the
+///   previous pass wrote it and when a transient texture takes memory that was used before.
+///
+/// Build it, compile it, run it and reset it every frame. The textures that back the transient textures are kept
+/// across frames and they are released when they are not used for a number of frames.
+class RenderGraph : public NonCopyable
+{
+public:
+	static const U MAX_PASSES = 64;
+	static const U MAX_TEXTURES = 64;
+	static const U MAX_PHYSICAL_TEXTURES = 64;
+	static const U MAX_PASS_DEPENDENCIES = 16;
+
+	RenderGraph()
+	{
+	}
+
+	~RenderGraph();
+
+	/// @param maxUnusedFrames The textures that are not used for more frames than that are released.
+	void init(RenderGraphInterface* iface, U32 maxUnusedFrames = 60);
+
+	/// @name Build
+	/// @{
+
+	/// Declare a texture that lives inside the frame. Its contents are undefined before the first pass that writes it.
+	/// @param name It should live until reset.
+	RenderGraphHandle newTexture(const TextureInitInfo& init, CString name);
+
+	/// Declare a texture that lives outside the graph. The passes that write it are never culled.
+	/// @param crntUsage The usage of the texture before the first pass.
+	RenderGraphHandle importTexture(
+		TexturePtr tex, const TextureInitInfo& init, TextureUsageBit crntUsage, CString name);
+
+	/// @param name It should live until reset.
+	/// @return The index of the pass.
+	U newPass(CString name, RenderGraphPassCallback callback, void* userData);
+
+	void newRead(U pass, RenderGraphHandle tex, TextureUsageBit usage);
+
+	void newWrite(U pass, RenderGraphHandle tex, TextureUsageBit usage);
+
+	/// The pass does something outside the graph so it shouldn't be culled.
+	void setSideEffect(U pass);
+	/// @}
+
+	/// Cull the passes, alias the transient textures and compute the barriers.
+	void compile();
+
+	/// Run the passes that survived. Call it after compile.
+	/// @param frameUserData It's given to all the passes.
+	ANKI_USE_RESULT Error run(CommandBufferPtr cmdb, void* frameUserData = nullptr);
+
+	/// Forget the passes and the textures of the frame.
+	void reset();
+
+	/// @name Valid after compile
+	/// @{
+	TexturePtr getTexture(RenderGraphHandle tex) const;
+
+	Bool isPassCulled(U pass) const
+	{
+		return !m_passes[pass].m_alive;
+	}
+
+	/// The index of the texture that backs a transient texture. Transient textures with the same index alias.
+	U getPhysicalTextureIndex(RenderGraphHandle tex) const
+	{
+		ANKI_ASSERT(tex < m_textureCount && !m_textures[tex].m_imported);
+		return m_textures[tex].m_physical;
+	}
+
+	/// Get the number of barriers that happen before a pass.
+	U getBarrierCount(U pass) const
+	{
+		ANKI_ASSERT(pass < m_passCount);
+		return m_passes[pass].m_barrierCount;
+	}
+
+	const RenderGraphBarrier& getBarrier(U pass, U idx) const
+	{
+		ANKI_ASSERT(idx < getBarrierCount(pass));
+		return m_passes[pass].m_barriers[idx];
+	}
+
+	void getStats(RenderGraphStats& stats) const
+	{
+		stats = m_stats;
+	}
+	/// @}
+
+private:
+	class Dependency
+	{
+	public:
+		RenderGraphHandle m_texture;
+		TextureUsageBit m_usage;
+		Bool8 m_write;
+	};
+
+	class Pass
+	{
+	public:
+		CString m_name;
+		RenderGraphPassCallback m_callback;
+		void* m_userData;
+		Array<Dependency, MAX_PASS_DEPENDENCIES> m_deps;
+		Array<RenderGraphBarrier, MAX_PASS_DEPENDENCIES> m_barriers;
+		U8 m_depCount;
+		U8 m_barrierCount;
+		Bool8 m_sideEffect;
+		Bool8 m_alive;
+	};
+
+	class LogicalTexture
+	{
+	public:
+		CString m_name;
+		TextureInitInfo m_init;
+		TexturePtr m_importedTexture;
+		TextureUsageBit m_usage; ///< The current usage of imported textures.
+		U32 m_firstPass;
+		U32 m_lastPass;
+		U32 m_physical;
+		Bool8 m_imported;
+		Bool8 m_needed;
+		Bool8 m_written; ///< The last pass that used an imported texture wrote it.
+	};
+
+	class PhysicalTexture
+	{
+	public:
+		TexturePtr m_texture;
+		TextureInitInfo m_init;
+		TextureUsageBit m_usage = TextureUsageBit::NONE; ///< The usage that the last pass left it in.
+		U64 m_lastUsedFrame = 0;
+		U32 m_releasePass = MAX_U32; ///< The last pass that uses it in this frame.
+		Bool8 m_usedThisFrame = false;
+		Bool8 m_written = false; ///< The last pass that used it wrote it.
+	};
+
+	RenderGraphInterface* m_iface = nullptr;
+	U32 m_maxUnusedFrames = 0;
+	U64 m_frame = 0;
+
+	Array<Pass, MAX_PASSES> m_passes;
+	U32 m_passCount = 0;
+	Array<LogicalTexture, MAX_TEXTURES> m_textures;
+	U32 m_textureCount = 0;
+	Array<PhysicalTexture, MAX_PHYSICAL_TEXTURES> m_physicalTextures;
+
+	Bool8 m_compiled = false;
+	RenderGraphStats m_stats;
+
+	void newDependency(U pass, RenderGraphHandle tex, TextureUsageBit usage, Bool write);
+
+	void cullPasses();
+	void computeLifetimes();
+	void aliasTextures();
+	void computeBarriers();
+
+	U32 acquirePhysicalTexture(const LogicalTexture& tex);
+
+	static Bool compatible(const TextureInitInfo& a, const TextureInitInfo& b);
+
+	static PtrSize computeMemory(const TextureInitInfo& init);
+};
+/// @}
+
+} // end namespace anki
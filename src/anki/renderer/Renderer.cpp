@@ -60,6 +60,10 @@ Renderer::Renderer()
 
 Renderer::~Renderer()
 {
+	if(m_graphIface)
+	{
+		m_alloc.deleteInstance(m_graphIface);
+	}
 }
 
 Error Renderer::init(ThreadPool* threadpool,
@@ -97,6 +101,8 @@ Error Renderer::initInternal(const ConfigSet& config)
 	ANKI_LOGI("Initializing offscreen renderer. Size %ux%u", m_width, m_height);
 
 	m_lodDistance = config.getNumber("lodDistance");
+	m_lodSelector.init(
+		config.getNumber("lodScreenError"), config.getNumber("lodHysteresis"), config.getNumber("lodTriangleBudget"));
 	m_frameCount = 0;
 	m_samples = config.getNumber("samples");
 	m_tileCountXY.x() = m_width / TILE_SIZE;
@@ -133,6 +139,10 @@ Error Renderer::initInternal(const ConfigSet& config)
 	// quad setup
 	ANKI_CHECK(m_resources->loadResource("shaders/Quad.vert.glsl", m_drawQuadVert));
 
+	// The render graph
+	m_graphIface = m_alloc.newInstance<RenderGraphGrInterface>(m_gr);
+	m_graph.init(m_graphIface);
+
 	// Init the stages. Careful with the order!!!!!!!!!!
 	m_ir.reset(m_alloc.newInstance<Ir>(this));
 	ANKI_CHECK(m_ir->init(config));
@@ -192,6 +202,11 @@ Error Renderer::render(RenderingContext& ctx)
 
 	ANKI_ASSERT(frc.getFrustum().getType() == FrustumType::PERSPECTIVE);
 
+	// The triangles of the previous frame move the LODs of this one
+	m_cameraFrc = &frc;
+	m_lodSelector.beginFrame();
+	ANKI_TRACE_INC_COUNTER(RENDERER_LOD_ERROR_BIAS, U(m_lodSelector.getErrorBias() * 100.0 + 0.5));
+
 	// Check if resources got loaded
 	if(m_prevLoadRequestCount != m_resources->getLoadingRequestCount()
 		|| m_prevAsyncTasksCompleted != m_resources->getAsyncTaskCompletedCount())
@@ -218,14 +233,10 @@ Error Renderer::render(RenderingContext& ctx)
 	m_ms->setPreRunBarriers(ctx);
 	m_is->setPreRunBarriers(ctx);
 	m_fs->setPreRunBarriers(ctx);
-	m_ssao->setPreRunBarriers(ctx);
-	m_bloom->m_extractExposure.setPreRunBarriers(ctx);
-	m_bloom->m_upscale.setPreRunBarriers(ctx);
 	m_depth->m_hd.setPreRunBarriers(ctx);
 	m_depth->m_qd.setPreRunBarriers(ctx);
 	m_smaa->m_edge.setPreRunBarriers(ctx);
 	m_smaa->m_weights.setPreRunBarriers(ctx);
-	m_vol->setPreRunBarriers(ctx);
 
 	// SM
 	m_sm->run(ctx);
@@ -245,65 +256,145 @@ Error Renderer::render(RenderingContext& ctx)
 
 	m_depth->m_qd.setPostRunBarriers(ctx);
 
-	m_vol->run(ctx);
-	m_vol->setPostRunBarriers(ctx);
-
 	m_lf->updateIndirectInfo(ctx, cmdb);
 
-	// Batch FS & SSAO & VOL
-	m_fs->run(ctx);
-	m_ssao->run(ctx);
+	// The rest goes through the render graph
+	populateRenderGraph(ctx);
+	m_graph.compile();
+	Error err = m_graph.run(cmdb, &ctx);
+
+	RenderGraphStats stats;
+	m_graph.getStats(stats);
+	m_graph.reset();
+	ANKI_CHECK(err);
+
+	ANKI_TRACE_INC_COUNTER(RENDERER_GRAPH_PEAK_MEMORY, stats.m_physicalMemory);
+	ANKI_TRACE_INC_COUNTER(RENDERER_GRAPH_SAVED_MEMORY, stats.getSavedMemory());
+
+	++m_frameCount;
+
+	return ErrorCode::NONE;
+}
+
+void Renderer::populateRenderGraph(RenderingContext& ctx)
+{
+	// The IS, the FS and the SMAA textures are not in the graph. Their passes transition them
+	m_vol->populateRenderGraph(ctx);
+
+	U pass = m_graph.newPass("FS", runFs, this);
+	m_graph.newRead(pass, ctx.m_vol.m_rt, TextureUsageBit::SAMPLED_FRAGMENT);
+	m_graph.setSideEffect(pass);
+
+	m_ssao->populateRenderGraph(ctx);
+
+	pass = m_graph.newPass("FS upscale", runFsUpscale, this);
+	m_graph.newRead(pass, ctx.m_ssao.m_rt, TextureUsageBit::SAMPLED_FRAGMENT);
+	m_graph.setSideEffect(pass);
 
-	m_ssao->setPostRunBarriers(ctx);
-	m_fs->setPostRunBarriers(ctx);
+	pass = m_graph.newPass("Downscale", runDownscale, this);
+	m_graph.setSideEffect(pass);
 
-	m_fsUpscale->run(ctx);
+	pass = m_graph.newPass("TM", runTm, this);
+	m_graph.setSideEffect(pass);
 
-	cmdb->setTextureSurfaceBarrier(m_is->getRt(),
+	pass = m_graph.newPass("SMAA edge", runSmaaEdge, this);
+	m_graph.setSideEffect(pass);
+
+	m_bloom->m_extractExposure.populateRenderGraph(ctx);
+
+	pass = m_graph.newPass("SMAA weights", runSmaaWeights, this);
+	m_graph.setSideEffect(pass);
+
+	m_bloom->m_upscale.populateRenderGraph(ctx);
+
+	if(m_dbg->getEnabled())
+	{
+		pass = m_graph.newPass("Dbg", runDbg, this);
+		m_graph.setSideEffect(pass);
+	}
+
+	m_pps->populateRenderGraph(ctx);
+}
+
+Error Renderer::runFs(RenderGraphRunContext& rctx)
+{
+	Renderer& r = *static_cast<Renderer*>(rctx.m_userData);
+	RenderingContext& ctx = *static_cast<RenderingContext*>(rctx.m_frameUserData);
+
+	r.m_fs->run(ctx);
+	r.m_fs->setPostRunBarriers(ctx);
+	return ErrorCode::NONE;
+}
+
+Error Renderer::runFsUpscale(RenderGraphRunContext& rctx)
+{
+	Renderer& r = *static_cast<Renderer*>(rctx.m_userData);
+	RenderingContext& ctx = *static_cast<RenderingContext*>(rctx.m_frameUserData);
+
+	r.m_fsUpscale->run(ctx);
+	return ErrorCode::NONE;
+}
+
+Error Renderer::runDownscale(RenderGraphRunContext& rctx)
+{
+	Renderer& r = *static_cast<Renderer*>(rctx.m_userData);
+	RenderingContext& ctx = *static_cast<RenderingContext*>(rctx.m_frameUserData);
+	CommandBufferPtr& cmdb = rctx.m_commandBuffer;
+
+	cmdb->setTextureSurfaceBarrier(r.m_is->getRt(),
 		TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE,
 		TextureUsageBit::SAMPLED_FRAGMENT,
 		TextureSurfaceInfo(0, 0, 0, 0));
 
-	m_downscale->run(ctx);
+	r.m_downscale->run(ctx);
 
-	cmdb->setTextureSurfaceBarrier(m_is->getRt(),
+	cmdb->setTextureSurfaceBarrier(r.m_is->getRt(),
 		TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE,
 		TextureUsageBit::SAMPLED_COMPUTE,
-		TextureSurfaceInfo(m_is->getRtMipmapCount() - 1, 0, 0, 0));
+		TextureSurfaceInfo(r.m_is->getRtMipmapCount() - 1, 0, 0, 0));
+	return ErrorCode::NONE;
+}
 
-	// Batch TM + SMAA_pass0
-	m_tm->run(ctx);
-	m_smaa->m_edge.run(ctx);
+Error Renderer::runTm(RenderGraphRunContext& rctx)
+{
+	Renderer& r = *static_cast<Renderer*>(rctx.m_userData);
+	RenderingContext& ctx = *static_cast<RenderingContext*>(rctx.m_frameUserData);
+
+	r.m_tm->run(ctx);
 
-	// Barriers
-	cmdb->setTextureSurfaceBarrier(m_is->getRt(),
+	rctx.m_commandBuffer->setTextureSurfaceBarrier(r.m_is->getRt(),
 		TextureUsageBit::SAMPLED_COMPUTE,
 		TextureUsageBit::SAMPLED_FRAGMENT,
-		TextureSurfaceInfo(m_is->getRtMipmapCount() - 1, 0, 0, 0));
-	m_smaa->m_edge.setPostRunBarriers(ctx);
-
-	// Batch bloom + SSLF + SMAA_pass1
-	m_bloom->m_extractExposure.run(ctx);
-	m_smaa->m_weights.run(ctx);
+		TextureSurfaceInfo(r.m_is->getRtMipmapCount() - 1, 0, 0, 0));
+	return ErrorCode::NONE;
+}
 
-	// Barriers
-	m_bloom->m_extractExposure.setPostRunBarriers(ctx);
-	m_smaa->m_weights.setPostRunBarriers(ctx);
+Error Renderer::runSmaaEdge(RenderGraphRunContext& rctx)
+{
+	Renderer& r = *static_cast<Renderer*>(rctx.m_userData);
+	RenderingContext& ctx = *static_cast<RenderingContext*>(rctx.m_frameUserData);
 
-	// Bloom last pass
-	m_bloom->m_upscale.run(ctx);
-	m_bloom->m_upscale.setPostRunBarriers(ctx);
+	r.m_smaa->m_edge.run(ctx);
+	r.m_smaa->m_edge.setPostRunBarriers(ctx);
+	return ErrorCode::NONE;
+}
 
-	if(m_dbg->getEnabled())
-	{
-		ANKI_CHECK(m_dbg->run(ctx));
-	}
+Error Renderer::runSmaaWeights(RenderGraphRunContext& rctx)
+{
+	Renderer& r = *static_cast<Renderer*>(rctx.m_userData);
+	RenderingContext& ctx = *static_cast<RenderingContext*>(rctx.m_frameUserData);
 
-	ANKI_CHECK(m_pps->run(ctx));
+	r.m_smaa->m_weights.run(ctx);
+	r.m_smaa->m_weights.setPostRunBarriers(ctx);
+	return ErrorCode::NONE;
+}
 
-	++m_frameCount;
+Error Renderer::runDbg(RenderGraphRunContext& rctx)
+{
+	Renderer& r = *static_cast<Renderer*>(rctx.m_userData);
+	RenderingContext& ctx = *static_cast<RenderingContext*>(rctx.m_frameUserData);
 
-	return ErrorCode::NONE;
+	return r.m_dbg->run(ctx);
 }
 
 Vec3 Renderer::unproject(
@@ -324,8 +415,8 @@ Vec3 Renderer::unproject(
 	return out.xyz();
 }
 
-void Renderer::createRenderTarget(
-	U32 w, U32 h, const PixelFormat& format, TextureUsageBit usage, SamplingFilter filter, U mipsCount, TexturePtr& rt)
+TextureInitInfo Renderer::createRenderTargetInitInfo(
+	U32 w, U32 h, const PixelFormat& format, TextureUsageBit usage, SamplingFilter filter, U mipsCount)
 {
 	// Not very important but keep the resolution of render targets aligned to 16
 	if(0)
@@ -357,7 +448,13 @@ void Renderer::createRenderTarget(
 	init.m_sampling.m_repeat = false;
 	init.m_sampling.m_anisotropyLevel = 0;
 
-	rt = m_gr->newInstance<Texture>(init);
+	return init;
+}
+
+void Renderer::createRenderTarget(
+	U32 w, U32 h, const PixelFormat& format, TextureUsageBit usage, SamplingFilter filter, U mipsCount, TexturePtr& rt)
+{
+	rt = m_gr->newInstance<Texture>(createRenderTargetInitInfo(w, h, format, usage, filter, mipsCount));
 }
 
 void Renderer::clearRenderTarget(TexturePtr rt, const ClearValue& clear, TextureUsageBit transferTo)
@@ -7,6 +7,8 @@
 
 #include <anki/renderer/Common.h>
 #include <anki/renderer/Drawer.h>
+#include <anki/renderer/LodSelector.h>
+#include <anki/renderer/RenderGraph.h>
 #include <anki/Math.h>
 #include <anki/Gr.h>
 #include <anki/scene/Forward.h>
@@ -78,14 +80,35 @@ public:
 		DynamicArrayAuto<FramebufferPtr> m_spotFramebuffers;
 		DynamicArrayAuto<Array<FramebufferPtr, 6>> m_omniFramebuffers;
 
-		DynamicArrayAuto<U> m_spotCacheIndices;
+		DynamicArrayAuto<U> m_spotCacheIndices; ///< The atlas pages of the spot lights.
 		DynamicArrayAuto<U> m_omniCacheIndices;
 
+		/// The regions of the spot lights in their atlas page. [casterIdx]
+		DynamicArrayAuto<UVec4> m_spotViewports;
+
 		/// [casterIdx][threadIdx]
 		DynamicArrayAuto<CommandBufferPtr> m_spotCommandBuffers;
 		/// [casterIdx][threadIdx][faceIdx]
 		DynamicArrayAuto<CommandBufferPtr> m_omniCommandBuffers;
 
+		/// @name Static layers
+		/// @{
+
+		/// Not created if the static layer doesn't need to be rendered.
+		DynamicArrayAuto<FramebufferPtr> m_spotStaticFramebuffers;
+		DynamicArrayAuto<Array<FramebufferPtr, 6>> m_omniStaticFramebuffers;
+
+		/// The number of static casters. They are in front of the visible renderables. [casterIdx]
+		DynamicArrayAuto<U32> m_spotStaticCasterCounts;
+		/// [casterIdx][faceIdx]
+		DynamicArrayAuto<Array<U32, 6>> m_omniStaticCasterCounts;
+
+		/// [casterIdx][threadIdx]
+		DynamicArrayAuto<CommandBufferPtr> m_spotStaticCommandBuffers;
+		/// [casterIdx][threadIdx][faceIdx]
+		DynamicArrayAuto<CommandBufferPtr> m_omniStaticCommandBuffers;
+		/// @}
+
 		DynamicArrayAuto<SceneNode*> m_spots;
 		DynamicArrayAuto<SceneNode*> m_omnis;
 
@@ -94,8 +117,15 @@ public:
 			, m_omniFramebuffers(alloc)
 			, m_spotCacheIndices(alloc)
 			, m_omniCacheIndices(alloc)
+			, m_spotViewports(alloc)
 			, m_spotCommandBuffers(alloc)
 			, m_omniCommandBuffers(alloc)
+			, m_spotStaticFramebuffers(alloc)
+			, m_omniStaticFramebuffers(alloc)
+			, m_spotStaticCasterCounts(alloc)
+			, m_omniStaticCasterCounts(alloc)
+			, m_spotStaticCommandBuffers(alloc)
+			, m_omniStaticCommandBuffers(alloc)
 			, m_spots(alloc)
 			, m_omnis(alloc)
 		{
@@ -113,6 +143,35 @@ public:
 	} m_fs;
 	/// @}
 
+	/// @name The textures of the render graph
+	/// @{
+	class Volumetric
+	{
+	public:
+		RenderGraphHandle m_rt;
+	} m_vol;
+
+	class Ssao
+	{
+	public:
+		RenderGraphHandle m_rt; ///< The result. The vertical blur writes it.
+		RenderGraphHandle m_hblurRt;
+	} m_ssao;
+
+	class Bloom
+	{
+	public:
+		RenderGraphHandle m_exposureRt;
+		RenderGraphHandle m_upscaleRt;
+	} m_bloom;
+
+	class Pps
+	{
+	public:
+		RenderGraphHandle m_rt; ///< Only if it doesn't draw to the default framebuffer.
+	} m_pps;
+	/// @}
+
 	FramebufferPtr m_outFb;
 	U32 m_outFbWidth = 0;
 	U32 m_outFbHeight = 0;
@@ -199,6 +258,11 @@ public:
 		return *m_smaa;
 	}
 
+	RenderGraph& getRenderGraph()
+	{
+		return m_graph;
+	}
+
 	U32 getWidth() const
 	{
 		return m_width;
@@ -294,9 +358,30 @@ anki_internal:
 		return distance / m_lodDistance;
 	}
 
+	/// Get the selector of the LODs that have geometric errors.
+	const LodSelector& getLodSelector() const
+	{
+		return m_lodSelector;
+	}
+
+	LodSelector& getLodSelector()
+	{
+		return m_lodSelector;
+	}
+
+	/// Check if it's the frustum of the camera of the current frame. Its LODs remember the previous frame.
+	Bool isCameraFrustum(const FrustumComponent& frc) const
+	{
+		return &frc == m_cameraFrc;
+	}
+
 	/// Create a pipeline object that has as a vertex shader the m_drawQuadVert and the given fragment progam
 	void createDrawQuadPipeline(ShaderPtr frag, const ColorStateInfo& colorState, PipelinePtr& ppline);
 
+	/// Create the init info of a framebuffer attachment texture.
+	TextureInitInfo createRenderTargetInitInfo(
+		U32 w, U32 h, const PixelFormat& format, TextureUsageBit usage, SamplingFilter filter, U mipsCount);
+
 	/// Create a framebuffer attachment texture
 	void createRenderTarget(U32 w,
 		U32 h,
@@ -384,10 +469,18 @@ private:
 	UniquePtr<Dbg> m_dbg; ///< Debug stage.
 	/// @}
 
+	/// @name Render graph
+	/// @{
+	RenderGraphGrInterface* m_graphIface = nullptr;
+	RenderGraph m_graph; ///< It runs the passes after the depth downscale.
+	/// @}
+
 	U32 m_width;
 	U32 m_height;
 
 	F32 m_lodDistance; ///< Distance that used to calculate the LOD
+	LodSelector m_lodSelector;
+	const FrustumComponent* m_cameraFrc = nullptr;
 	U8 m_samples; ///< Number of sample in multisampling
 	Bool8 m_tessellation;
 	U32 m_tileCount;
@@ -409,6 +502,20 @@ private:
 
 	ANKI_USE_RESULT Error buildCommandBuffers(RenderingContext& ctx);
 	ANKI_USE_RESULT Error buildCommandBuffersInternal(RenderingContext& ctx, U32 threadId, PtrSize threadCount);
+
+	/// Add the passes from the volumetric to the PPS to the render graph.
+	void populateRenderGraph(RenderingContext& ctx);
+
+	/// @name Render graph callbacks of the passes that transition their textures themselves
+	/// @{
+	static ANKI_USE_RESULT Error runFs(RenderGraphRunContext& rctx);
+	static ANKI_USE_RESULT Error runFsUpscale(RenderGraphRunContext& rctx);
+	static ANKI_USE_RESULT Error runDownscale(RenderGraphRunContext& rctx);
+	static ANKI_USE_RESULT Error runTm(RenderGraphRunContext& rctx);
+	static ANKI_USE_RESULT Error runSmaaEdge(RenderGraphRunContext& rctx);
+	static ANKI_USE_RESULT Error runSmaaWeights(RenderGraphRunContext& rctx);
+	static ANKI_USE_RESULT Error runDbg(RenderGraphRunContext& rctx);
+	/// @}
 };
 /// @}
 
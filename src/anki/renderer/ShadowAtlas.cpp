@@ -0,0 +1,366 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/renderer/ShadowAtlas.h>
+#include <anki/util/Functions.h>
+#include <algorithm>
+
+namespace anki
+{
+
+/// The desired size should go that far past the size of the current region before the region is resized. It stops
+/// the lights that are close to a power of two from bouncing between two sizes.
+static const F32 RESIZE_HYSTERESIS = 0.15;
+
+ShadowAtlas::~ShadowAtlas()
+{
+	m_nodeInfos.destroy(m_alloc);
+	m_nodeStates.destroy(m_alloc);
+	m_allocations.destroy(m_alloc);
+}
+
+void ShadowAtlas::init(GenericMemoryPoolAllocator<U8> alloc,
+	U32 pageSize,
+	U32 pageCount,
+	U32 minSize,
+	U32 maxSize,
+	U64 texelBudget,
+	U32 maxUnusedFrames)
+{
+	ANKI_ASSERT(isPowerOfTwo(pageSize) && isPowerOfTwo(minSize) && isPowerOfTwo(maxSize));
+	ANKI_ASSERT(minSize <= maxSize && maxSize <= pageSize);
+	ANKI_ASSERT(pageCount > 0);
+	ANKI_ASSERT(texelBudget >= U64(minSize) * minSize);
+
+	m_alloc = alloc;
+	m_pageSize = pageSize;
+	m_pageCount = pageCount;
+	m_minSize = minSize;
+	m_maxSize = maxSize;
+	m_texelBudget = texelBudget;
+	m_maxUnusedFrames = maxUnusedFrames;
+
+	m_depthCount = computeDepth(minSize) + 1;
+	m_nodesPerPage = getFirstNodeOfDepth(m_depthCount);
+
+	// The children of node n are 4n+1 to 4n+4
+	m_nodeInfos.create(m_alloc, m_nodesPerPage);
+	m_nodeInfos[0].m_x = 0;
+	m_nodeInfos[0].m_y = 0;
+	m_nodeInfos[0].m_size = pageSize;
+	for(U32 n = 0; n < getFirstNodeOfDepth(m_depthCount - 1); ++n)
+	{
+		const NodeInfo& parent = m_nodeInfos[n];
+		const U32 size = parent.m_size / 2;
+
+		for(U32 i = 0; i < 4; ++i)
+		{
+			NodeInfo& child = m_nodeInfos[4 * n + 1 + i];
+			child.m_x = parent.m_x + (i & 1) * size;
+			child.m_y = parent.m_y + (i >> 1) * size;
+			child.m_size = size;
+		}
+	}
+
+	m_nodeStates.create(m_alloc, m_nodesPerPage * m_pageCount, NodeState::FREE);
+}
+
+U32 ShadowAtlas::computeDepth(U32 size) const
+{
+	ANKI_ASSERT(size <= m_pageSize);
+	U32 depth = 0;
+	U32 s = m_pageSize;
+	while(s > size)
+	{
+		s >>= 1;
+		++depth;
+	}
+
+	return depth;
+}
+
+void ShadowAtlas::computeSizes(WeakArray<ShadowAtlasRequest> requests, WeakArray<U32> order, WeakArray<U32> sizes)
+{
+	const U count = requests.getSize();
+
+	U64 totalTexels = 0;
+	for(U i = 0; i < count; ++i)
+	{
+		const ShadowAtlasRequest& req = requests[i];
+		const F32 desired = max<F32>(req.m_desiredSize, 1.0);
+		U32 size = nextPowerOfTwo(U32(ceil(desired)));
+
+		auto it = m_allocations.find(req.m_id);
+		if(it != m_allocations.getEnd())
+		{
+			const U32 crntSize = m_nodeInfos[it->m_node].m_size;
+			if(desired > F32(crntSize / 2) * (1.0 - RESIZE_HYSTERESIS)
+				&& desired <= F32(crntSize) * (1.0 + RESIZE_HYSTERESIS))
+			{
+				size = crntSize;
+			}
+		}
+
+		size = clamp(size, m_minSize, m_maxSize);
+		sizes[i] = size;
+		totalTexels += U64(size) * size;
+	}
+
+	// Shrink the largest regions first. If there is a tie shrink the least important
+	while(totalTexels > m_texelBudget)
+	{
+		U32 largest = MAX_U32;
+		for(I k = count - 1; k >= 0; --k)
+		{
+			const U32 i = order[k];
+			if(sizes[i] > m_minSize && (largest == MAX_U32 || sizes[i] > sizes[largest]))
+			{
+				largest = i;
+			}
+		}
+
+		if(largest == MAX_U32)
+		{
+			break;
+		}
+
+		const U64 oldTexels = U64(sizes[largest]) * sizes[largest];
+		sizes[largest] /= 2;
+		totalTexels -= oldTexels - oldTexels / 4;
+	}
+
+	// Everything is at the minimum size, drop the least important
+	for(I k = count - 1; k >= 0 && totalTexels > m_texelBudget; --k)
+	{
+		const U32 i = order[k];
+		totalTexels -= U64(sizes[i]) * sizes[i];
+		sizes[i] = 0;
+	}
+}
+
+Bool ShadowAtlas::tryAllocate(U32 size, U32& page, U32& node)
+{
+	const I32 depth = computeDepth(size);
+
+	// Use the smallest free node that fits
+	for(I32 d = depth; d >= 0; --d)
+	{
+		const U32 first = getFirstNodeOfDepth(d);
+		const U32 end = getFirstNodeOfDepth(d + 1);
+
+		for(U32 p = 0; p < m_pageCount; ++p)
+		{
+			NodeState* states = &m_nodeStates[p * m_nodesPerPage];
+
+			for(U32 n = first; n < end; ++n)
+			{
+				// The nodes under free nodes are free as well so check the parent
+				if(states[n] != NodeState::FREE || (n > 0 && states[(n - 1) / 4] != NodeState::SPLIT))
+				{
+					continue;
+				}
+
+				// Split down to the requested size
+				U32 crnt = n;
+				for(I32 dd = d; dd < depth; ++dd)
+				{
+					states[crnt] = NodeState::SPLIT;
+					crnt = 4 * crnt + 1;
+				}
+
+				states[crnt] = NodeState::USED;
+				page = p;
+				node = crnt;
+
+				m_stats.m_allocatedTexels += U64(size) * size;
+				++m_stats.m_allocations;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void ShadowAtlas::free(U32 page, U32 node)
+{
+	NodeState* states = &m_nodeStates[page * m_nodesPerPage];
+	ANKI_ASSERT(states[node] == NodeState::USED);
+	states[node] = NodeState::FREE;
+
+	const U64 size = m_nodeInfos[node].m_size;
+	ANKI_ASSERT(m_stats.m_allocatedTexels >= size * size && m_stats.m_allocations > 0);
+	m_stats.m_allocatedTexels -= size * size;
+	--m_stats.m_allocations;
+
+	// Merge the free siblings
+	while(node > 0)
+	{
+		const U32 parent = (node - 1) / 4;
+		const U32 firstChild = 4 * parent + 1;
+
+		for(U32 i = 0; i < 4; ++i)
+		{
+			if(states[firstChild + i] != NodeState::FREE)
+			{
+				return;
+			}
+		}
+
+		states[parent] = NodeState::FREE;
+		node = parent;
+	}
+}
+
+Bool ShadowAtlas::evictOne()
+{
+	auto oldest = m_allocations.getEnd();
+	for(auto it = m_allocations.getBegin(); it != m_allocations.getEnd(); ++it)
+	{
+		if(it->m_lastUsedFrame < m_frame
+			&& (oldest == m_allocations.getEnd() || it->m_lastUsedFrame < oldest->m_lastUsedFrame))
+		{
+			oldest = it;
+		}
+	}
+
+	if(oldest == m_allocations.getEnd())
+	{
+		return false;
+	}
+
+	free(oldest->m_page, oldest->m_node);
+	m_allocations.erase(m_alloc, oldest);
+	++m_stats.m_evictions;
+	return true;
+}
+
+void ShadowAtlas::setRegion(const Allocation& alloc, ShadowAtlasRegion& region) const
+{
+	const NodeInfo& info = m_nodeInfos[alloc.m_node];
+	region.m_page = alloc.m_page;
+	region.m_x = info.m_x;
+	region.m_y = info.m_y;
+	region.m_size = info.m_size;
+	region.m_reused = false;
+}
+
+void ShadowAtlas::allocate(WeakArray<ShadowAtlasRequest> requests, WeakArray<ShadowAtlasRegion> regions)
+{
+	ANKI_ASSERT(m_pageCount > 0 && "Not initialized");
+	ANKI_ASSERT(requests.getSize() == regions.getSize());
+
+	++m_frame;
+	m_stats.m_reused = 0;
+	m_stats.m_evictions = 0;
+	m_stats.m_failures = 0;
+
+	const U count = requests.getSize();
+	if(count > 0)
+	{
+		DynamicArrayAuto<U32> order(m_alloc);
+		DynamicArrayAuto<U32> sizes(m_alloc);
+		order.create(count);
+		sizes.create(count);
+
+		// Sort by importance
+		for(U i = 0; i < count; ++i)
+		{
+			order[i] = i;
+		}
+
+		std::sort(order.getBegin(), order.getEnd(), [&](U32 a, U32 b) {
+			return requests[a].m_importance > requests[b].m_importance;
+		});
+
+		computeSizes(requests, WeakArray<U32>(&order[0], count), WeakArray<U32>(&sizes[0], count));
+
+		// Keep the regions that didn't change size and free the rest
+		for(U i = 0; i < count; ++i)
+		{
+			regions[i] = ShadowAtlasRegion();
+
+			auto it = m_allocations.find(requests[i].m_id);
+			if(it == m_allocations.getEnd())
+			{
+				continue;
+			}
+
+			Allocation& alloc = *it;
+			if(sizes[i] == m_nodeInfos[alloc.m_node].m_size)
+			{
+				alloc.m_lastUsedFrame = m_frame;
+				setRegion(alloc, regions[i]);
+				regions[i].m_reused = true;
+				++m_stats.m_reused;
+			}
+			else
+			{
+				free(alloc.m_page, alloc.m_node);
+				m_allocations.erase(m_alloc, it);
+			}
+		}
+
+		// Allocate the rest in order of importance. If there is no space evict the regions of the lights that are not
+		// visible and then try smaller sizes
+		for(U k = 0; k < count; ++k)
+		{
+			const U32 i = order[k];
+			if(regions[i].isValid() || sizes[i] == 0)
+			{
+				continue;
+			}
+
+			U32 size = sizes[i];
+			Allocation alloc;
+			Bool found = false;
+			while(!found)
+			{
+				found = tryAllocate(size, alloc.m_page, alloc.m_node);
+
+				if(!found && !evictOne())
+				{
+					if(size == m_minSize)
+					{
+						break;
+					}
+
+					size /= 2;
+				}
+			}
+
+			if(found)
+			{
+				alloc.m_lastUsedFrame = m_frame;
+				m_allocations.pushBack(m_alloc, requests[i].m_id, alloc);
+				setRegion(alloc, regions[i]);
+			}
+			else
+			{
+				++m_stats.m_failures;
+			}
+		}
+	}
+
+	// Free the regions of the lights that were not seen for a while
+	Bool evicted = true;
+	while(evicted)
+	{
+		evicted = false;
+		for(auto it = m_allocations.getBegin(); it != m_allocations.getEnd(); ++it)
+		{
+			if(m_frame - it->m_lastUsedFrame > m_maxUnusedFrames)
+			{
+				free(it->m_page, it->m_node);
+				m_allocations.erase(m_alloc, it);
+				++m_stats.m_evictions;
+				evicted = true;
+				break;
+			}
+		}
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,176 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/util/DynamicArray.h>
+#include <anki/util/HashMap.h>
+
+namespace anki
+{
+
+/// @addtogroup renderer
+/// @{
+
+/// A light that wants a region of the shadow atlas.
+class ShadowAtlasRequest
+{
+public:
+	U64 m_id = 0; ///< Something that identifies the light across frames. Its UUID for example.
+	F32 m_importance = 0.0; ///< Lights with higher importance are served first. Typically its screen coverage.
+	F32 m_desiredSize = 0.0; ///< The ideal resolution of the shadow map in texels.
+};
+
+/// A region of the shadow atlas.
+class ShadowAtlasRegion
+{
+public:
+	U32 m_page = MAX_U32;
+	U32 m_x = 0;
+	U32 m_y = 0;
+	U32 m_size = 0;
+	Bool8 m_reused = false; ///< The light had the same region in the previous frame so its contents are still there.
+
+	Bool isValid() const
+	{
+		return m_page != MAX_U32;
+	}
+};
+
+class ShadowAtlasStats
+{
+public:
+	U64 m_allocatedTexels = 0; ///< The texels of all the live regions.
+	U32 m_allocations = 0; ///< The number of live regions.
+
+	/// @name Of the last frame
+	/// @{
+	U32 m_reused = 0; ///< Regions that the lights kept.
+	U32 m_evictions = 0; ///< Regions taken from lights that were not visible.
+	U32 m_failures = 0; ///< Requests that didn't get a region.
+	/// @}
+};
+
+/// Gives regions of a number of square texture pages to lights. The size of each region is a power of two that is
+/// derived from the desired size of the light and a per-frame texel budget. Every page is a quadtree so regions don't
+/// fragment the page. A light keeps its region across frames as long as its size doesn't change and the regions of
+/// lights that are not visible are evicted when there is no space or when they get too old.
+class ShadowAtlas : public NonCopyable
+{
+public:
+	ShadowAtlas()
+	{
+	}
+
+	~ShadowAtlas();
+
+	/// @param pageSize The resolution of a page. Power of two.
+	/// @param minSize The minimum region size. Power of two.
+	/// @param maxSize The maximum region size. Power of two.
+	/// @param texelBudget The maximum number of texels that the visible lights will get.
+	/// @param maxUnusedFrames Regions of lights that were not seen for more frames than that are freed.
+	void init(GenericMemoryPoolAllocator<U8> alloc,
+		U32 pageSize,
+		U32 pageCount,
+		U32 minSize,
+		U32 maxSize,
+		U64 texelBudget,
+		U32 maxUnusedFrames = 30);
+
+	/// Give regions to the lights of a frame. Call it once per frame.
+	/// @param[in] requests The lights. Their IDs should be unique.
+	/// @param[out] regions The regions. Same size as the requests. Lights that didn't fit get an invalid region.
+	void allocate(WeakArray<ShadowAtlasRequest> requests, WeakArray<ShadowAtlasRegion> regions);
+
+	U32 getPageSize() const
+	{
+		return m_pageSize;
+	}
+
+	U32 getPageCount() const
+	{
+		return m_pageCount;
+	}
+
+	void getStats(ShadowAtlasStats& stats) const
+	{
+		stats = m_stats;
+	}
+
+private:
+	enum class NodeState : U8
+	{
+		FREE,
+		SPLIT,
+		USED
+	};
+
+	/// The coordinates of a node. They are the same for all pages.
+	class NodeInfo
+	{
+	public:
+		U32 m_x;
+		U32 m_y;
+		U32 m_size;
+	};
+
+	class Allocation
+	{
+	public:
+		U32 m_page;
+		U32 m_node;
+		U64 m_lastUsedFrame;
+	};
+
+	/// The IDs are random enough.
+	class Hasher
+	{
+	public:
+		U64 operator()(U64 id) const
+		{
+			return id;
+		}
+	};
+
+	GenericMemoryPoolAllocator<U8> m_alloc;
+	U32 m_pageSize = 0;
+	U32 m_pageCount = 0;
+	U32 m_minSize = 0;
+	U32 m_maxSize = 0;
+	U64 m_texelBudget = 0;
+	U32 m_maxUnusedFrames = 0;
+	U32 m_depthCount = 0; ///< The depth of the quadtrees plus one.
+	U32 m_nodesPerPage = 0;
+
+	DynamicArray<NodeInfo> m_nodeInfos;
+	DynamicArray<NodeState> m_nodeStates; ///< The nodes of all pages.
+
+	HashMap<U64, Allocation, Hasher> m_allocations;
+	U64 m_frame = 0;
+
+	ShadowAtlasStats m_stats;
+
+	U32 computeDepth(U32 size) const;
+
+	static U32 getFirstNodeOfDepth(U32 depth)
+	{
+		return ((1u << (2u * depth)) - 1u) / 3u;
+	}
+
+	/// Decide the sizes of the requests.
+	void computeSizes(WeakArray<ShadowAtlasRequest> requests, WeakArray<U32> order, WeakArray<U32> sizes);
+
+	Bool tryAllocate(U32 size, U32& page, U32& node);
+
+	void free(U32 page, U32 node);
+
+	/// Evict the least recently used region that wasn't used in this frame.
+	Bool evictOne();
+
+	void setRegion(const Allocation& alloc, ShadowAtlasRegion& region) const;
+};
+/// @}
+
+} // end namespace anki
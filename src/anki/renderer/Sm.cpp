@@ -11,6 +11,7 @@
 #include <anki/scene/Light.h>
 #include <anki/scene/FrustumComponent.h>
 #include <anki/scene/MoveComponent.h>
+#include <anki/scene/SpatialComponent.h>
 #include <anki/misc/ConfigSet.h>
 #include <anki/util/ThreadPool.h>
 
@@ -19,10 +20,17 @@ namespace anki
 
 const PixelFormat Sm::DEPTH_RT_PIXEL_FORMAT(ComponentFormat::D16, TransformFormat::UNORM);
 
+/// Casters that haven't changed for that number of frames are considered static.
+static const Timestamp STATIC_CASTER_MIN_AGE = 30;
+
 Sm::~Sm()
 {
 	m_spots.destroy(getAllocator());
 	m_omnis.destroy(getAllocator());
+	m_spotPageFbs.destroy(getAllocator());
+	m_spotStaticPages.destroy(getAllocator());
+	m_spotStaticPageFbs.destroy(getAllocator());
+	m_spotStaticPageRcs.destroy(getAllocator());
 
 	if(m_pplineCache)
 	{
@@ -35,18 +43,29 @@ Error Sm::init(const ConfigSet& config)
 	m_poissonEnabled = config.getNumber("sm.poissonEnabled");
 	m_bilinearEnabled = config.getNumber("sm.bilinearEnabled");
 	m_resolution = config.getNumber("sm.resolution");
+	m_staticCaching = config.getNumber("sm.staticCaching");
+
+	const U32 atlasResolution = config.getNumber("sm.spotAtlasResolution");
+	const U32 atlasPageCount = config.getNumber("sm.spotAtlasPages");
+	ANKI_ASSERT(atlasPageCount <= 64);
+	m_spotAtlas.init(getAllocator(),
+		atlasResolution,
+		atlasPageCount,
+		config.getNumber("sm.spotMinResolution"),
+		config.getNumber("sm.spotMaxResolution"),
+		config.getNumber("sm.spotTexelBudget"));
 
 	//
 	// Init the shadowmaps
 	//
 
-	// Create shadowmaps array
+	// Create the atlas of the spot lights
 	TextureInitInfo sminit;
 	sminit.m_usage = TextureUsageBit::SAMPLED_FRAGMENT | TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE;
 	sminit.m_type = TextureType::_2D_ARRAY;
-	sminit.m_width = m_resolution;
-	sminit.m_height = m_resolution;
-	sminit.m_layerCount = config.getNumber("sm.maxLights");
+	sminit.m_width = atlasResolution;
+	sminit.m_height = atlasResolution;
+	sminit.m_layerCount = atlasPageCount;
 	sminit.m_depth = 1;
 	sminit.m_format = DEPTH_RT_PIXEL_FORMAT;
 	sminit.m_mipmapsCount = 1;
@@ -55,33 +74,96 @@ Error Sm::init(const ConfigSet& config)
 
 	m_spotTexArray = getGrManager().newInstance<Texture>(sminit);
 
+	// Create the omni shadowmaps array
 	sminit.m_type = TextureType::CUBE_ARRAY;
+	sminit.m_width = m_resolution;
+	sminit.m_height = m_resolution;
+	sminit.m_layerCount = config.getNumber("sm.maxLights");
 	m_omniTexArray = getGrManager().newInstance<Texture>(sminit);
 
-	// Init 2D layers
+	if(m_staticCaching)
+	{
+		// The static layers are fetched by the restore quads so they are plain depth textures. The omni faces are
+		// fetched with texelFetch so they live in a 2D array and not in a cube array
+		sminit.m_usage = TextureUsageBit::SAMPLED_FRAGMENT | TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE;
+		sminit.m_sampling.m_minMagFilter = SamplingFilter::NEAREST;
+		sminit.m_sampling.m_compareOperation = CompareOperation::ALWAYS;
+		sminit.m_type = TextureType::_2D_ARRAY;
+		sminit.m_layerCount = config.getNumber("sm.maxLights") * 6;
+		m_omniStaticTexArray = getGrManager().newInstance<Texture>(sminit);
+
+		ResourceGroupInitInfo omniRcInit;
+		omniRcInit.m_textures[0].m_texture = m_omniStaticTexArray;
+		omniRcInit.m_uniformBuffers[0].m_uploadedMemory = true;
+		omniRcInit.m_uniformBuffers[0].m_usage = BufferUsageBit::UNIFORM_FRAGMENT;
+		m_omniStaticRc = getGrManager().newInstance<ResourceGroup>(omniRcInit);
+
+		// The static layers of the spot lights
+		sminit.m_type = TextureType::_2D;
+		sminit.m_width = atlasResolution;
+		sminit.m_height = atlasResolution;
+		sminit.m_layerCount = 1;
+
+		m_spotStaticPages.create(getAllocator(), atlasPageCount);
+		m_spotStaticPageFbs.create(getAllocator(), atlasPageCount);
+		m_spotStaticPageRcs.create(getAllocator(), atlasPageCount);
+		for(U i = 0; i < atlasPageCount; ++i)
+		{
+			m_spotStaticPages[i] = getGrManager().newInstance<Texture>(sminit);
+
+			ResourceGroupInitInfo rcinit;
+			rcinit.m_textures[0].m_texture = m_spotStaticPages[i];
+			m_spotStaticPageRcs[i] = getGrManager().newInstance<ResourceGroup>(rcinit);
+		}
+	}
+
+	// Init the spot light pages. The lights share them so the regions are cleared with a quad and not with the load
+	// operation
 	m_spots.create(getAllocator(), config.getNumber("sm.maxLights"));
+	m_spotPageFbs.create(getAllocator(), atlasPageCount);
 
-	FramebufferInitInfo fbInit;
-	fbInit.m_depthStencilAttachment.m_texture = m_spotTexArray;
-	fbInit.m_depthStencilAttachment.m_loadOperation = AttachmentLoadOperation::CLEAR;
-	fbInit.m_depthStencilAttachment.m_usageInsideRenderPass = TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE;
-	fbInit.m_depthStencilAttachment.m_clearValue.m_depthStencil.m_depth = 1.0;
+	FramebufferInitInfo pageFbInit;
+	pageFbInit.m_depthStencilAttachment.m_loadOperation = AttachmentLoadOperation::LOAD;
+	pageFbInit.m_depthStencilAttachment.m_usageInsideRenderPass = TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE;
+
+	for(U i = 0; i < atlasPageCount; ++i)
+	{
+		pageFbInit.m_depthStencilAttachment.m_texture = m_spotTexArray;
+		pageFbInit.m_depthStencilAttachment.m_surface.m_layer = i;
+		m_spotPageFbs[i] = getGrManager().newInstance<Framebuffer>(pageFbInit);
+
+		if(m_staticCaching)
+		{
+			pageFbInit.m_depthStencilAttachment.m_texture = m_spotStaticPages[i];
+			pageFbInit.m_depthStencilAttachment.m_surface.m_layer = 0;
+			m_spotStaticPageFbs[i] = getGrManager().newInstance<Framebuffer>(pageFbInit);
+		}
+	}
 
 	U layer = 0;
 	for(ShadowmapSpot& sm : m_spots)
 	{
-		sm.m_layerId = layer;
+		sm.m_layerId = layer++;
+	}
 
-		fbInit.m_depthStencilAttachment.m_surface.m_layer = layer;
-		sm.m_fb = getGrManager().newInstance<Framebuffer>(fbInit);
+	// With static caching the static layer is restored before the dynamic casters are drawn so don't clear
+	FramebufferInitInfo fbInit;
+	fbInit.m_depthStencilAttachment.m_loadOperation =
+		(m_staticCaching) ? AttachmentLoadOperation::LOAD : AttachmentLoadOperation::CLEAR;
+	fbInit.m_depthStencilAttachment.m_usageInsideRenderPass = TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE;
+	fbInit.m_depthStencilAttachment.m_clearValue.m_depthStencil.m_depth = 1.0;
 
-		++layer;
-	}
+	FramebufferInitInfo staticFbInit;
+	staticFbInit.m_depthStencilAttachment.m_loadOperation = AttachmentLoadOperation::CLEAR;
+	staticFbInit.m_depthStencilAttachment.m_usageInsideRenderPass =
+		TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE;
+	staticFbInit.m_depthStencilAttachment.m_clearValue.m_depthStencil.m_depth = 1.0;
 
 	// Init cube layers
 	m_omnis.create(getAllocator(), config.getNumber("sm.maxLights"));
 
 	fbInit.m_depthStencilAttachment.m_texture = m_omniTexArray;
+	staticFbInit.m_depthStencilAttachment.m_texture = m_omniStaticTexArray;
 
 	layer = 0;
 	for(ShadowmapOmni& sm : m_omnis)
@@ -93,6 +175,12 @@ Error Sm::init(const ConfigSet& config)
 			fbInit.m_depthStencilAttachment.m_surface.m_layer = layer;
 			fbInit.m_depthStencilAttachment.m_surface.m_face = i;
 			sm.m_fb[i] = getGrManager().newInstance<Framebuffer>(fbInit);
+
+			if(m_staticCaching)
+			{
+				staticFbInit.m_depthStencilAttachment.m_surface.m_layer = layer * 6 + i;
+				sm.m_staticFb[i] = getGrManager().newInstance<Framebuffer>(staticFbInit);
+			}
 		}
 
 		++layer;
@@ -101,6 +189,30 @@ Error Sm::init(const ConfigSet& config)
 	// Init state
 	m_state.m_depthStencil.m_format = Sm::DEPTH_RT_PIXEL_FORMAT;
 
+	// Init the region clear and restore
+	ANKI_CHECK(m_r->createShader("shaders/SmRegion.frag.glsl", m_regionClearFrag, "#define RESTORE 0\n"));
+	ANKI_CHECK(m_r->createShader("shaders/SmRegion.frag.glsl", m_regionRestoreFrag, "#define RESTORE 1\n"));
+
+	PipelineInitInfo ppinit;
+	ppinit.m_inputAssembler.m_topology = PrimitiveTopology::TRIANGLE_STRIP;
+	ppinit.m_depthStencil.m_depthWriteEnabled = true;
+	ppinit.m_depthStencil.m_depthCompareFunction = CompareOperation::ALWAYS;
+	ppinit.m_depthStencil.m_format = Sm::DEPTH_RT_PIXEL_FORMAT;
+	ppinit.m_shaders[ShaderType::VERTEX] = m_r->getDrawQuadVertexShader();
+
+	ppinit.m_shaders[ShaderType::FRAGMENT] = m_regionClearFrag->getGrShader();
+	m_regionClearPpline = getGrManager().newInstance<Pipeline>(ppinit);
+
+	ppinit.m_shaders[ShaderType::FRAGMENT] = m_regionRestoreFrag->getGrShader();
+	m_regionRestorePpline = getGrManager().newInstance<Pipeline>(ppinit);
+
+	if(m_staticCaching)
+	{
+		ANKI_CHECK(m_r->createShader("shaders/SmRegion.frag.glsl", m_omniRestoreFrag, "#define RESTORE 2\n"));
+		ppinit.m_shaders[ShaderType::FRAGMENT] = m_omniRestoreFrag->getGrShader();
+		m_omniRestorePpline = getGrManager().newInstance<Pipeline>(ppinit);
+	}
+
 	m_pplineCache = getAllocator().newInstance<GrObjectCache>(&getGrManager());
 
 	return ErrorCode::NONE;
@@ -116,6 +228,34 @@ void Sm::run(RenderingContext& ctx)
 	// Spot lights
 	for(U i = 0; i < ctx.m_sm.m_spots.getSize(); ++i)
 	{
+		if(m_staticCaching && ctx.m_sm.m_spotStaticFramebuffers[i].isCreated())
+		{
+			const TexturePtr& staticPage = m_spotStaticPages[ctx.m_sm.m_spotCacheIndices[i]];
+			const TextureSurfaceInfo surf(0, 0, 0, 0);
+
+			cmdb->setTextureSurfaceBarrier(staticPage,
+				TextureUsageBit::SAMPLED_FRAGMENT,
+				TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE,
+				surf);
+
+			cmdb->beginRenderPass(ctx.m_sm.m_spotStaticFramebuffers[i]);
+			for(U j = 0; j < threadCount; ++j)
+			{
+				CommandBufferPtr& cmdb2 = ctx.m_sm.m_spotStaticCommandBuffers[i * threadCount + j];
+				if(cmdb2.isCreated())
+				{
+					cmdb->pushSecondLevelCommandBuffer(cmdb2);
+				}
+			}
+			cmdb->endRenderPass();
+
+			cmdb->setTextureSurfaceBarrier(staticPage,
+				TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE,
+				TextureUsageBit::SAMPLED_FRAGMENT,
+				surf);
+		}
+
+		// The first command buffer clears or restores the region
 		cmdb->beginRenderPass(ctx.m_sm.m_spotFramebuffers[i]);
 		for(U j = 0; j < threadCount; ++j)
 		{
@@ -134,6 +274,34 @@ void Sm::run(RenderingContext& ctx)
 	{
 		for(U j = 0; j < 6; ++j)
 		{
+			if(m_staticCaching && ctx.m_sm.m_omniStaticFramebuffers[i][j].isCreated())
+			{
+				const U layer = ctx.m_sm.m_omniCacheIndices[i];
+				const TextureSurfaceInfo surf(0, 0, 0, layer * 6 + j);
+
+				cmdb->setTextureSurfaceBarrier(m_omniStaticTexArray,
+					TextureUsageBit::SAMPLED_FRAGMENT,
+					TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE,
+					surf);
+
+				cmdb->beginRenderPass(ctx.m_sm.m_omniStaticFramebuffers[i][j]);
+				for(U k = 0; k < threadCount; ++k)
+				{
+					CommandBufferPtr& cmdb2 = ctx.m_sm.m_omniStaticCommandBuffers[i * threadCount * 6 + k * 6 + j];
+					if(cmdb2.isCreated())
+					{
+						cmdb->pushSecondLevelCommandBuffer(cmdb2);
+					}
+				}
+				cmdb->endRenderPass();
+
+				cmdb->setTextureSurfaceBarrier(m_omniStaticTexArray,
+					TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE,
+					TextureUsageBit::SAMPLED_FRAGMENT,
+					surf);
+			}
+
+			// With static caching the first command buffer restores the face
 			cmdb->beginRenderPass(ctx.m_sm.m_omniFramebuffers[i][j]);
 
 			for(U k = 0; k < threadCount; ++k)
@@ -172,6 +340,7 @@ void Sm::bestCandidate(SceneNode& light, TContainer& arr, TShadowmap*& out)
 		{
 			sm.m_light = &light;
 			sm.m_timestamp = 0;
+			sm.m_staticHash = 0;
 			out = &sm;
 			return;
 		}
@@ -189,6 +358,7 @@ void Sm::bestCandidate(SceneNode& light, TContainer& arr, TShadowmap*& out)
 
 	sm->m_light = &light;
 	sm->m_timestamp = 0;
+	sm->m_staticHash = 0;
 	out = sm;
 }
 
@@ -214,110 +384,331 @@ Bool Sm::skip(SceneNode& light, ShadowmapBase& sm)
 		sm.m_timestamp = m_r->getGlobalTimestamp();
 	}
 
-	// Update the layer ID anyway
-	LightComponent& lcomp = light.getComponent<LightComponent>();
-	lcomp.setShadowMapIndex(sm.m_layerId);
-
 	return !shouldUpdate;
 }
 
+void Sm::allocateSpotRegions(RenderingContext& ctx, WeakArray<SceneNode*> lights, WeakArray<ShadowAtlasRegion> regions)
+{
+	const U count = lights.getSize();
+	const FrustumComponent& camFrc = *ctx.m_frustumComponent;
+	const Mat4& viewMat = camFrc.getViewMatrix();
+	const Mat4& projMat = camFrc.getProjectionMatrix();
+	const F32 screenTexels = F32(m_r->getWidth()) * F32(m_r->getHeight());
+
+	DynamicArrayAuto<ShadowAtlasRequest> requests(ctx.m_tempAllocator);
+	if(count > 0)
+	{
+		requests.create(count);
+	}
+
+	for(U i = 0; i < count; ++i)
+	{
+		const SceneNode& node = *lights[i];
+		const LightComponent& lightc = node.getComponent<LightComponent>();
+		const Transform& trf = node.getComponent<MoveComponent>().getWorldTransform();
+
+		// Approximate the cone with a sphere and compute the part of the screen it covers
+		const F32 radius = lightc.getDistance() / 2.0;
+		const Vec3 dir = -trf.getRotation().getZAxis();
+		const Vec4 center = trf.getOrigin().xyz1() + (dir * radius).xyz0();
+		const F32 dist = -(viewMat * center).z();
+
+		F32 coverage = 1.0;
+		if(dist > radius)
+		{
+			const F32 rx = radius * projMat(0, 0) / dist;
+			const F32 ry = radius * projMat(1, 1) / dist;
+			coverage = min<F32>(PI * rx * ry / 4.0, 1.0);
+		}
+
+		ShadowAtlasRequest& req = requests[i];
+		req.m_id = node.getUuid();
+		req.m_importance = coverage;
+		req.m_desiredSize = sqrt(coverage * screenTexels);
+	}
+
+	m_spotAtlas.allocate(WeakArray<ShadowAtlasRequest>((count) ? &requests[0] : nullptr, count), regions);
+}
+
+/// Get the last time a caster moved or changed shape.
+static Timestamp getCasterTimestamp(const SceneNode& node)
+{
+	Timestamp ts = 0;
+
+	const MoveComponent* movc = node.tryGetComponent<MoveComponent>();
+	if(movc)
+	{
+		ts = max(ts, movc->getTimestamp());
+	}
+
+	const SpatialComponent* spc = node.tryGetComponent<SpatialComponent>();
+	if(spc)
+	{
+		ts = max(ts, spc->getTimestamp());
+	}
+
+	return ts;
+}
+
+U64 Sm::partitionCasters(FrustumComponent& frc, StackAllocator<U8> alloc, U32& staticCount) const
+{
+	VisibilityTestResults& vis = frc.getVisibilityTestResults();
+	const U count = vis.getCount(VisibilityGroupType::RENDERABLES_MS);
+	staticCount = 0;
+	if(count == 0)
+	{
+		return 0;
+	}
+
+	VisibleNode* nodes = vis.getBegin(VisibilityGroupType::RENDERABLES_MS);
+	DynamicArrayAuto<VisibleNode> dynamicNodes(alloc);
+	dynamicNodes.create(count);
+	U dynamicCount = 0;
+
+	// Stable partition. The hash doesn't depend on the order of the casters
+	const Timestamp crntTimestamp = m_r->getGlobalTimestamp();
+	U64 hash = 0;
+	for(U i = 0; i < count; ++i)
+	{
+		const SceneNode& node = *nodes[i].m_node;
+		const Timestamp ts = getCasterTimestamp(node);
+
+		if(crntTimestamp - ts > STATIC_CASTER_MIN_AGE)
+		{
+			Array<U64, 2> key = {{node.getUuid(), ts}};
+			hash += computeHash(&key[0], sizeof(key));
+
+			nodes[staticCount++] = nodes[i];
+		}
+		else
+		{
+			dynamicNodes[dynamicCount++] = nodes[i];
+		}
+	}
+
+	for(U i = 0; i < dynamicCount; ++i)
+	{
+		nodes[staticCount + i] = dynamicNodes[i];
+	}
+
+	return appendHash(&staticCount, sizeof(staticCount), hash);
+}
+
+Bool Sm::updateStaticLayer(
+	SceneNode& light, ShadowmapBase& sm, StackAllocator<U8> alloc, WeakArray<U32> staticCounts) const
+{
+	// The static layer depends on the light as well
+	U64 hash = light.getComponent<MoveComponent>().getTimestamp();
+
+	U count = 0;
+	Error err = light.iterateComponentsOfType<FrustumComponent>([&](FrustumComponent& frc) -> Error {
+		hash = appendHash(&hash, sizeof(hash), partitionCasters(frc, alloc, staticCounts[count]));
+		hash = appendHash(&hash, sizeof(hash), frc.getTimestamp());
+		++count;
+		return ErrorCode::NONE;
+	});
+	(void)err;
+	ANKI_ASSERT(count == staticCounts.getSize());
+
+	// Zero means invalid
+	hash = max<U64>(hash, 1);
+
+	const Bool renderStatic = hash != sm.m_staticHash || m_r->resourcesLoaded();
+	sm.m_staticHash = hash;
+	return renderStatic;
+}
+
 Error Sm::buildCommandBuffers(RenderingContext& ctx, U threadId, U threadCount) const
 {
 	ANKI_TRACE_START_EVENT(RENDER_SM);
 
 	for(U i = 0; i < ctx.m_sm.m_spots.getSize(); ++i)
 	{
-		U idx = i * threadCount + threadId;
-
-		ANKI_CHECK(doSpotLight(*ctx.m_sm.m_spots[i],
-			ctx.m_sm.m_spotCommandBuffers[idx],
-			ctx.m_sm.m_spotFramebuffers[i],
-			threadId,
-			threadCount));
+		ANKI_CHECK(doSpotLight(ctx, i, threadId, threadCount));
 	}
 
 	for(U i = 0; i < ctx.m_sm.m_omnis.getSize(); ++i)
 	{
-		U idx = i * threadCount * 6 + threadId * 6 + 0;
-
-		ANKI_CHECK(doOmniLight(*ctx.m_sm.m_omnis[i],
-			&ctx.m_sm.m_omniCommandBuffers[idx],
-			ctx.m_sm.m_omniFramebuffers[i],
-			threadId,
-			threadCount));
+		ANKI_CHECK(doOmniLight(ctx, i, threadId, threadCount));
 	}
 
 	ANKI_TRACE_STOP_EVENT(RENDER_SM);
 	return ErrorCode::NONE;
 }
 
-Error Sm::doSpotLight(SceneNode& light, CommandBufferPtr& cmdb, FramebufferPtr& fb, U threadId, U threadCount) const
+Error Sm::drawCasters(FrustumComponent& frc,
+	U first,
+	U last,
+	const UVec4& viewport,
+	const FramebufferPtr& fb,
+	CommandBufferPtr& cmdb,
+	U threadId,
+	U threadCount) const
 {
-	FrustumComponent& frc = light.getComponent<FrustumComponent>();
-	VisibilityTestResults& vis = frc.getVisibilityTestResults();
-	U problemSize = vis.getCount(VisibilityGroupType::RENDERABLES_MS);
+	ANKI_ASSERT(first <= last);
 	PtrSize start, end;
-	ThreadPoolTask::choseStartEnd(threadId, threadCount, problemSize, start, end);
+	ThreadPoolTask::choseStartEnd(threadId, threadCount, last - first, start, end);
 
-	if(start == end)
+	if(start == end && !cmdb.isCreated())
 	{
 		return ErrorCode::NONE;
 	}
 
-	CommandBufferInitInfo cinf;
-	cinf.m_flags = CommandBufferFlag::SECOND_LEVEL;
-	cinf.m_framebuffer = fb;
-	cmdb = m_r->getGrManager().newInstance<CommandBuffer>(cinf);
-	cmdb->setViewport(0, 0, m_resolution, m_resolution);
+	if(!cmdb.isCreated())
+	{
+		CommandBufferInitInfo cinf;
+		cinf.m_flags = CommandBufferFlag::SECOND_LEVEL;
+		cinf.m_framebuffer = fb;
+		cmdb = m_r->getGrManager().newInstance<CommandBuffer>(cinf);
+	}
+
+	cmdb->setViewport(viewport.x(), viewport.y(), viewport.z(), viewport.w());
 	cmdb->setPolygonOffset(1.0, 2.0);
 
-	Error err = m_r->getSceneDrawer().drawRange(Pass::SM,
-		frc,
-		cmdb,
-		*m_pplineCache,
-		m_state,
-		vis.getBegin(VisibilityGroupType::RENDERABLES_MS) + start,
-		vis.getBegin(VisibilityGroupType::RENDERABLES_MS) + end);
+	Error err = ErrorCode::NONE;
+	if(start != end)
+	{
+		VisibilityTestResults& vis = frc.getVisibilityTestResults();
+		err = m_r->getSceneDrawer().drawRange(Pass::SM,
+			frc,
+			cmdb,
+			*m_pplineCache,
+			m_state,
+			vis.getBegin(VisibilityGroupType::RENDERABLES_MS) + first + start,
+			vis.getBegin(VisibilityGroupType::RENDERABLES_MS) + first + end);
+	}
 
 	cmdb->flush();
 
 	return err;
 }
 
-Error Sm::doOmniLight(
-	SceneNode& light, CommandBufferPtr cmdbs[], Array<FramebufferPtr, 6>& fbs, U threadId, U threadCount) const
+void Sm::initSpotRegion(
+	const UVec4& viewport, const FramebufferPtr& fb, const ResourceGroupPtr& staticRc, CommandBufferPtr& cmdb) const
 {
-	U frCount = 0;
+	ANKI_ASSERT(!cmdb.isCreated());
 
-	Error err = light.iterateComponentsOfType<FrustumComponent>([&](FrustumComponent& frc) -> Error {
-		VisibilityTestResults& vis = frc.getVisibilityTestResults();
-		U problemSize = vis.getCount(VisibilityGroupType::RENDERABLES_MS);
-		PtrSize start, end;
-		ThreadPoolTask::choseStartEnd(threadId, threadCount, problemSize, start, end);
+	CommandBufferInitInfo cinf;
+	cinf.m_flags = CommandBufferFlag::SECOND_LEVEL;
+	cinf.m_framebuffer = fb;
+	cmdb = m_r->getGrManager().newInstance<CommandBuffer>(cinf);
+	cmdb->setViewport(viewport.x(), viewport.y(), viewport.z(), viewport.w());
+
+	if(staticRc.isCreated())
+	{
+		cmdb->bindPipeline(m_regionRestorePpline);
+		cmdb->bindResourceGroup(staticRc, 0, nullptr);
+	}
+	else
+	{
+		cmdb->bindPipeline(m_regionClearPpline);
+	}
+
+	m_r->drawQuad(cmdb);
+}
+
+void Sm::initOmniFace(const UVec4& viewport, const FramebufferPtr& fb, U staticLayer, CommandBufferPtr& cmdb) const
+{
+	ANKI_ASSERT(!cmdb.isCreated());
 
-		if(start != end)
+	CommandBufferInitInfo cinf;
+	cinf.m_flags = CommandBufferFlag::SECOND_LEVEL;
+	cinf.m_framebuffer = fb;
+	cmdb = m_r->getGrManager().newInstance<CommandBuffer>(cinf);
+	cmdb->setViewport(viewport.x(), viewport.y(), viewport.z(), viewport.w());
+	cmdb->bindPipeline(m_omniRestorePpline);
+
+	TransientMemoryInfo transient;
+	UVec4* unis = static_cast<UVec4*>(m_r->getGrManager().allocateFrameTransientMemory(
+		sizeof(UVec4), BufferUsageBit::UNIFORM_ALL, transient.m_uniformBuffers[0]));
+	*unis = UVec4(staticLayer, 0, 0, 0);
+	cmdb->bindResourceGroup(m_omniStaticRc, 0, &transient);
+
+	m_r->drawQuad(cmdb);
+}
+
+Error Sm::doSpotLight(RenderingContext& ctx, U casterIdx, U threadId, U threadCount) const
+{
+	FrustumComponent& frc = ctx.m_sm.m_spots[casterIdx]->getComponent<FrustumComponent>();
+	const U count = frc.getVisibilityTestResults().getCount(VisibilityGroupType::RENDERABLES_MS);
+	const U idx = casterIdx * threadCount + threadId;
+	const UVec4& viewport = ctx.m_sm.m_spotViewports[casterIdx];
+	const ResourceGroupPtr noRc;
+
+	U staticCount = 0;
+	if(m_staticCaching)
+	{
+		staticCount = ctx.m_sm.m_spotStaticCasterCounts[casterIdx];
+
+		const FramebufferPtr& staticFb = ctx.m_sm.m_spotStaticFramebuffers[casterIdx];
+		if(staticFb.isCreated())
 		{
-			CommandBufferInitInfo cinf;
-			cinf.m_flags = CommandBufferFlag::SECOND_LEVEL;
-			cinf.m_framebuffer = fbs[frCount];
-			cmdbs[frCount] = m_r->getGrManager().newInstance<CommandBuffer>(cinf);
-			cmdbs[frCount]->setViewport(0, 0, m_resolution, m_resolution);
-			cmdbs[frCount]->setPolygonOffset(1.0, 2.0);
-
-			ANKI_CHECK(m_r->getSceneDrawer().drawRange(Pass::SM,
-				frc,
-				cmdbs[frCount],
-				*m_pplineCache,
-				m_state,
-				vis.getBegin(VisibilityGroupType::RENDERABLES_MS) + start,
-				vis.getBegin(VisibilityGroupType::RENDERABLES_MS) + end));
-
-			cmdbs[frCount]->flush();
+			CommandBufferPtr& staticCmdb = ctx.m_sm.m_spotStaticCommandBuffers[idx];
+			if(threadId == 0)
+			{
+				initSpotRegion(viewport, staticFb, noRc, staticCmdb);
+			}
+
+			ANKI_CHECK(drawCasters(frc, 0, staticCount, viewport, staticFb, staticCmdb, threadId, threadCount));
 		}
+	}
 
-		++frCount;
-		return ErrorCode::NONE;
-	});
+	// Thread 0 clears the region or copies the static layer to it
+	const FramebufferPtr& fb = ctx.m_sm.m_spotFramebuffers[casterIdx];
+	CommandBufferPtr& cmdb = ctx.m_sm.m_spotCommandBuffers[idx];
+	if(threadId == 0)
+	{
+		const U page = ctx.m_sm.m_spotCacheIndices[casterIdx];
+		initSpotRegion(viewport, fb, (m_staticCaching) ? m_spotStaticPageRcs[page] : noRc, cmdb);
+	}
+
+	return drawCasters(frc, staticCount, count, viewport, fb, cmdb, threadId, threadCount);
+}
+
+Error Sm::doOmniLight(RenderingContext& ctx, U casterIdx, U threadId, U threadCount) const
+{
+	const U idx = casterIdx * threadCount * 6 + threadId * 6;
+	const UVec4 viewport(0, 0, m_resolution, m_resolution);
+	U frCount = 0;
+
+	Error err = ctx.m_sm.m_omnis[casterIdx]->iterateComponentsOfType<FrustumComponent>(
+		[&](FrustumComponent& frc) -> Error {
+			const U count = frc.getVisibilityTestResults().getCount(VisibilityGroupType::RENDERABLES_MS);
+
+			const FramebufferPtr& fb = ctx.m_sm.m_omniFramebuffers[casterIdx][frCount];
+			CommandBufferPtr& cmdb = ctx.m_sm.m_omniCommandBuffers[idx + frCount];
+
+			U staticCount = 0;
+			if(m_staticCaching)
+			{
+				staticCount = ctx.m_sm.m_omniStaticCasterCounts[casterIdx][frCount];
+
+				// Thread 0 restores the face from the static layer
+				if(threadId == 0)
+				{
+					const U staticLayer = ctx.m_sm.m_omniCacheIndices[casterIdx] * 6 + frCount;
+					initOmniFace(viewport, fb, staticLayer, cmdb);
+				}
+
+				const FramebufferPtr& staticFb = ctx.m_sm.m_omniStaticFramebuffers[casterIdx][frCount];
+				if(staticFb.isCreated())
+				{
+					ANKI_CHECK(drawCasters(frc,
+						0,
+						staticCount,
+						viewport,
+						staticFb,
+						ctx.m_sm.m_omniStaticCommandBuffers[idx + frCount],
+						threadId,
+						threadCount));
+				}
+			}
+
+			ANKI_CHECK(drawCasters(frc, staticCount, count, viewport, fb, cmdb, threadId, threadCount));
+
+			++frCount;
+			return ErrorCode::NONE;
+		});
 
 	return err;
 }
@@ -331,6 +722,8 @@ void Sm::prepareBuildCommandBuffers(RenderingContext& ctx)
 
 	const U MAX = 64;
 	Array<SceneNode*, MAX> spotCasters;
+	Array<ShadowmapSpot*, MAX> spotShadowmaps;
+	Array<ShadowAtlasRegion, MAX> spotRegions;
 	Array<SceneNode*, MAX> omniCasters;
 	U spotCastersCount = 0;
 	U omniCastersCount = 0;
@@ -347,6 +740,7 @@ void Sm::prepareBuildCommandBuffers(RenderingContext& ctx)
 		{
 			ShadowmapOmni* sm;
 			bestCandidate(*node, m_omnis, sm);
+			light.setShadowMapIndex(sm->m_layerId);
 
 			if(!skip(*node, *sm))
 			{
@@ -355,9 +749,13 @@ void Sm::prepareBuildCommandBuffers(RenderingContext& ctx)
 		}
 	}
 
+	// The spot lights get a region of the atlas first
+	Array<SceneNode*, MAX> spots;
+	U spotCount = 0;
+
 	it = vi.getBegin(VisibilityGroupType::LIGHTS_SPOT);
 	lend = vi.getEnd(VisibilityGroupType::LIGHTS_SPOT);
-	for(; it != lend; ++it)
+	for(; it != lend && spotCount < MAX; ++it)
 	{
 		SceneNode* node = (*it).m_node;
 		LightComponent& light = node->getComponent<LightComponent>();
@@ -365,13 +763,46 @@ void Sm::prepareBuildCommandBuffers(RenderingContext& ctx)
 
 		if(light.getShadowEnabled())
 		{
-			ShadowmapSpot* sm;
-			bestCandidate(*node, m_spots, sm);
+			spots[spotCount++] = node;
+		}
+	}
 
-			if(!skip(*node, *sm))
-			{
-				spotCasters[spotCastersCount++] = node;
-			}
+	Array<ShadowAtlasRegion, MAX> regions;
+	allocateSpotRegions(
+		ctx, WeakArray<SceneNode*>(&spots[0], spotCount), WeakArray<ShadowAtlasRegion>(&regions[0], spotCount));
+
+	const F32 pageSize = m_spotAtlas.getPageSize();
+	for(U i = 0; i < spotCount; ++i)
+	{
+		SceneNode* node = spots[i];
+		LightComponent& light = node->getComponent<LightComponent>();
+		const ShadowAtlasRegion& region = regions[i];
+
+		if(!region.isValid())
+		{
+			light.unsetShadowMapIndex();
+			continue;
+		}
+
+		light.setShadowMapIndex(region.m_page);
+		light.setShadowMapRegion(
+			Vec4(region.m_size / pageSize, region.m_size / pageSize, region.m_x / pageSize, region.m_y / pageSize));
+
+		ShadowmapSpot* sm;
+		bestCandidate(*node, m_spots, sm);
+
+		// A new region has garbage
+		if(!region.m_reused)
+		{
+			sm->m_timestamp = 0;
+			sm->m_staticHash = 0;
+		}
+
+		if(!skip(*node, *sm))
+		{
+			spotShadowmaps[spotCastersCount] = sm;
+			spotRegions[spotCastersCount] = region;
+			spotCasters[spotCastersCount++] = node;
 		}
 	}
 
@@ -395,13 +826,38 @@ void Sm::prepareBuildCommandBuffers(RenderingContext& ctx)
 #endif
 
 		ctx.m_sm.m_spotFramebuffers.create(spotCastersCount);
+		ctx.m_sm.m_spotViewports.create(spotCastersCount);
+
+		if(m_staticCaching)
+		{
+			ctx.m_sm.m_spotStaticCommandBuffers.create(spotCastersCount * m_r->getThreadPool().getThreadsCount());
+			ctx.m_sm.m_spotStaticFramebuffers.create(spotCastersCount);
+			ctx.m_sm.m_spotStaticCasterCounts.create(spotCastersCount);
+		}
+
 		for(U i = 0; i < spotCastersCount; ++i)
 		{
-			const LightComponent& lightc = ctx.m_sm.m_spots[i]->getComponent<LightComponent>();
-			U idx = lightc.getShadowMapIndex();
+			const ShadowAtlasRegion& region = spotRegions[i];
+			const U page = region.m_page;
 
-			ctx.m_sm.m_spotFramebuffers[i] = m_spots[idx].m_fb;
-			ctx.m_sm.m_spotCacheIndices[i] = idx;
+			ctx.m_sm.m_spotFramebuffers[i] = m_spotPageFbs[page];
+			ctx.m_sm.m_spotCacheIndices[i] = page;
+			ctx.m_sm.m_spotViewports[i] =
+				UVec4(region.m_x, region.m_y, region.m_x + region.m_size, region.m_y + region.m_size);
+
+			if(m_staticCaching)
+			{
+				WeakArray<U32> staticCounts(&ctx.m_sm.m_spotStaticCasterCounts[i], 1);
+				if(updateStaticLayer(*ctx.m_sm.m_spots[i], *spotShadowmaps[i], ctx.m_tempAllocator, staticCounts))
+				{
+					ctx.m_sm.m_spotStaticFramebuffers[i] = m_spotStaticPageFbs[page];
+					ANKI_TRACE_INC_COUNTER(RENDERER_SHADOW_STATIC_RENDERS, 1);
+				}
+				else
+				{
+					ANKI_TRACE_INC_COUNTER(RENDERER_SHADOW_DYNAMIC_ONLY_PASSES, 1);
+				}
+			}
 		}
 	}
 
@@ -418,6 +874,14 @@ void Sm::prepareBuildCommandBuffers(RenderingContext& ctx)
 #endif
 
 		ctx.m_sm.m_omniFramebuffers.create(omniCastersCount);
+
+		if(m_staticCaching)
+		{
+			ctx.m_sm.m_omniStaticCommandBuffers.create(omniCastersCount * 6 * m_r->getThreadPool().getThreadsCount());
+			ctx.m_sm.m_omniStaticFramebuffers.create(omniCastersCount);
+			ctx.m_sm.m_omniStaticCasterCounts.create(omniCastersCount);
+		}
+
 		for(U i = 0; i < omniCastersCount; ++i)
 		{
 			const LightComponent& lightc = ctx.m_sm.m_omnis[i]->getComponent<LightComponent>();
@@ -429,9 +893,25 @@ void Sm::prepareBuildCommandBuffers(RenderingContext& ctx)
 			}
 
 			ctx.m_sm.m_omniCacheIndices[i] = idx;
+
+			if(m_staticCaching)
+			{
+				WeakArray<U32> staticCounts(&ctx.m_sm.m_omniStaticCasterCounts[i][0], 6);
+				if(updateStaticLayer(*ctx.m_sm.m_omnis[i], m_omnis[idx], ctx.m_tempAllocator, staticCounts))
+				{
+					ctx.m_sm.m_omniStaticFramebuffers[i] = m_omnis[idx].m_staticFb;
+					ANKI_TRACE_INC_COUNTER(RENDERER_SHADOW_STATIC_RENDERS, 1);
+				}
+				else
+				{
+					ANKI_TRACE_INC_COUNTER(RENDERER_SHADOW_DYNAMIC_ONLY_PASSES, 1);
+				}
+			}
 		}
 	}
 
+	ANKI_TRACE_INC_COUNTER(RENDERER_SHADOW_PASSES, spotCastersCount + omniCastersCount);
+
 	ANKI_TRACE_STOP_EVENT(RENDER_SM);
 }
 
@@ -440,13 +920,19 @@ void Sm::setPreRunBarriers(RenderingContext& ctx)
 	ANKI_TRACE_START_EVENT(RENDER_SM);
 	CommandBufferPtr& cmdb = ctx.m_commandBuffer;
 
-	// Spot lights
+	// Spot lights. The pages are shared and the other regions should be preserved
+	U64 pageMask = 0;
 	for(U i = 0; i < ctx.m_sm.m_spotCacheIndices.getSize(); ++i)
 	{
 		U layer = ctx.m_sm.m_spotCacheIndices[i];
+		if(pageMask & (U64(1) << layer))
+		{
+			continue;
+		}
+		pageMask |= U64(1) << layer;
 
 		cmdb->setTextureSurfaceBarrier(m_spotTexArray,
-			TextureUsageBit::NONE,
+			TextureUsageBit::SAMPLED_FRAGMENT,
 			TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE,
 			TextureSurfaceInfo(0, 0, 0, layer));
 	}
@@ -474,9 +960,15 @@ void Sm::setPostRunBarriers(RenderingContext& ctx)
 	CommandBufferPtr& cmdb = ctx.m_commandBuffer;
 
 	// Spot lights
+	U64 pageMask = 0;
 	for(U i = 0; i < ctx.m_sm.m_spotCacheIndices.getSize(); ++i)
 	{
 		U layer = ctx.m_sm.m_spotCacheIndices[i];
+		if(pageMask & (U64(1) << layer))
+		{
+			continue;
+		}
+		pageMask |= U64(1) << layer;
 
 		cmdb->setTextureSurfaceBarrier(m_spotTexArray,
 			TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE,
@@ -6,8 +6,10 @@
 #pragma once
 
 #include <anki/renderer/RenderingPass.h>
+#include <anki/renderer/ShadowAtlas.h>
 #include <anki/Gr.h>
 #include <anki/resource/TextureResource.h>
+#include <anki/resource/ShaderResource.h>
 #include <anki/util/Array.h>
 
 namespace anki
@@ -15,6 +17,7 @@ namespace anki
 
 // Forward
 class SceneNode;
+class FrustumComponent;
 
 /// @addtogroup renderer
 /// @{
@@ -49,11 +52,17 @@ anki_internal:
 		return m_poissonEnabled;
 	}
 
+	/// The pages of the spot light atlas.
 	TexturePtr getSpotTextureArray() const
 	{
 		return m_spotTexArray;
 	}
 
+	const ShadowAtlas& getSpotAtlas() const
+	{
+		return m_spotAtlas;
+	}
+
 	TexturePtr getOmniTextureArray() const
 	{
 		return m_omniTexArray;
@@ -63,24 +72,51 @@ private:
 	TexturePtr m_spotTexArray;
 	TexturePtr m_omniTexArray;
 
+	/// @name Spot light atlas
+	/// The spot lights share the layers of m_spotTexArray. Each light gets a region that depends on its screen
+	/// coverage. The regions are cleared or restored from the static layer with a quad before the casters are drawn.
+	/// @{
+	ShadowAtlas m_spotAtlas;
+	DynamicArray<FramebufferPtr> m_spotPageFbs;
+
+	ShaderResourcePtr m_regionClearFrag;
+	ShaderResourcePtr m_regionRestoreFrag;
+	PipelinePtr m_regionClearPpline;
+	PipelinePtr m_regionRestorePpline;
+	/// @}
+
+	/// @name Static caching
+	/// The static casters are rendered to a layer of those textures only when they change. Every frame that the
+	/// shadowmap needs update the static layer is restored with a quad and only the dynamic casters are drawn on top.
+	/// @{
+	TexturePtr m_omniStaticTexArray; ///< A 2D array with 6 layers per light. One for each face.
+	ResourceGroupPtr m_omniStaticRc;
+	ShaderResourcePtr m_omniRestoreFrag;
+	PipelinePtr m_omniRestorePpline;
+	DynamicArray<TexturePtr> m_spotStaticPages;
+	DynamicArray<FramebufferPtr> m_spotStaticPageFbs;
+	DynamicArray<ResourceGroupPtr> m_spotStaticPageRcs;
+	Bool8 m_staticCaching = false;
+	/// @}
+
 	class ShadowmapBase
 	{
 	public:
 		U32 m_layerId;
 		SceneNode* m_light = nullptr;
 		U32 m_timestamp = 0; ///< Timestamp of last render or light change
+		U64 m_staticHash = 0; ///< Identifies the casters of the static layer. Zero if it's not valid.
 	};
 
 	class ShadowmapSpot : public ShadowmapBase
 	{
-	public:
-		FramebufferPtr m_fb;
 	};
 
 	class ShadowmapOmni : public ShadowmapBase
 	{
 	public:
 		Array<FramebufferPtr, 6> m_fb;
+		Array<FramebufferPtr, 6> m_staticFb;
 	};
 
 	DynamicArray<ShadowmapSpot> m_spots;
@@ -92,7 +128,7 @@ private:
 	/// Shadowmap bilinear filtering for the first level. Better quality
 	Bool8 m_bilinearEnabled;
 
-	/// Shadowmap resolution
+	/// Shadowmap resolution of the omni lights
 	U32 m_resolution;
 
 	GrObjectCache* m_pplineCache = nullptr;
@@ -105,11 +141,41 @@ private:
 	/// Check if a shadow pass can be skipped.
 	Bool skip(SceneNode& light, ShadowmapBase& sm);
 
-	ANKI_USE_RESULT Error doSpotLight(
-		SceneNode& light, CommandBufferPtr& cmdBuff, FramebufferPtr& fb, U threadId, U threadCount) const;
-
-	ANKI_USE_RESULT Error doOmniLight(
-		SceneNode& light, CommandBufferPtr cmdbs[], Array<FramebufferPtr, 6>& fbs, U threadId, U threadCount) const;
+	/// Give atlas regions to the visible spot lights.
+	void allocateSpotRegions(RenderingContext& ctx, WeakArray<SceneNode*> lights, WeakArray<ShadowAtlasRegion> regions);
+
+	/// Move the static casters of a frustum in front of the dynamic ones.
+	/// @param[out] staticCount The number of static casters.
+	/// @return A hash of the static casters.
+	U64 partitionCasters(FrustumComponent& frc, StackAllocator<U8> alloc, U32& staticCount) const;
+
+	/// Partition the casters of a light and check if its static layer needs to be rendered.
+	Bool updateStaticLayer(
+		SceneNode& light, ShadowmapBase& sm, StackAllocator<U8> alloc, WeakArray<U32> staticCounts) const;
+
+	/// Draw a range of the visible renderables of a frustum.
+	/// @param[in,out] cmdb If it's already created the casters will be appended to it.
+	ANKI_USE_RESULT Error drawCasters(FrustumComponent& frc,
+		U first,
+		U last,
+		const UVec4& viewport,
+		const FramebufferPtr& fb,
+		CommandBufferPtr& cmdb,
+		U threadId,
+		U threadCount) const;
+
+	/// Clear a region of the atlas or restore it from the static layer.
+	void initSpotRegion(const UVec4& viewport,
+		const FramebufferPtr& fb,
+		const ResourceGroupPtr& staticRc,
+		CommandBufferPtr& cmdb) const;
+
+	/// Restore a face of an omni shadowmap from the static layers.
+	void initOmniFace(const UVec4& viewport, const FramebufferPtr& fb, U staticLayer, CommandBufferPtr& cmdb) const;
+
+	ANKI_USE_RESULT Error doSpotLight(RenderingContext& ctx, U casterIdx, U threadId, U threadCount) const;
+
+	ANKI_USE_RESULT Error doOmniLight(RenderingContext& ctx, U casterIdx, U threadId, U threadCount) const;
 };
 
 /// @}
@@ -56,26 +56,14 @@ static void genNoise(Array<I8, 4>* ANKI_RESTRICT arr, Array<I8, 4>* ANKI_RESTRIC
 
 const PixelFormat Ssao::RT_PIXEL_FORMAT(ComponentFormat::R8, TransformFormat::UNORM);
 
-Error Ssao::createFb(FramebufferPtr& fb, TexturePtr& rt)
+void Ssao::createFb(TexturePtr rt, FramebufferPtr& fb)
 {
-	// Set to bilinear because the blurring techniques take advantage of that
-	m_r->createRenderTarget(m_width,
-		m_height,
-		RT_PIXEL_FORMAT,
-		TextureUsageBit::SAMPLED_FRAGMENT | TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE,
-		SamplingFilter::LINEAR,
-		1,
-		rt);
-
-	// Create FB
 	FramebufferInitInfo fbInit;
 	fbInit.m_colorAttachmentCount = 1;
 	fbInit.m_colorAttachments[0].m_texture = rt;
 	fbInit.m_colorAttachments[0].m_loadOperation = AttachmentLoadOperation::DONT_CARE;
 	fbInit.m_colorAttachments[0].m_usageInsideRenderPass = TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE;
 	fb = getGrManager().newInstance<Framebuffer>(fbInit);
-
-	return ErrorCode::NONE;
 }
 
 Error Ssao::initInternal(const ConfigSet& config)
@@ -93,10 +81,10 @@ Error Ssao::initInternal(const ConfigSet& config)
 	ANKI_LOGI("Initializing SSAO. Size %ux%u", m_width, m_height);
 
 	//
-	// create FBOs
+	// The RTs are in the render graph. Set to bilinear because the blurring techniques take advantage of that
 	//
-	ANKI_CHECK(createFb(m_hblurFb, m_hblurRt));
-	ANKI_CHECK(createFb(m_vblurFb, m_vblurRt));
+	m_rtInit = m_r->createRenderTargetInitInfo(
+		m_width, m_height, RT_PIXEL_FORMAT, TextureUsageBit::NONE, SamplingFilter::LINEAR, 1);
 
 	//
 	// noise texture
@@ -242,14 +230,6 @@ Error Ssao::initInternal(const ConfigSet& config)
 	rcinit.m_uniformBuffers[0].m_usage = BufferUsageBit::UNIFORM_FRAGMENT;
 	m_rcFirst = gr.newInstance<ResourceGroup>(rcinit);
 
-	rcinit = ResourceGroupInitInfo();
-	rcinit.m_textures[0].m_texture = m_vblurRt;
-	m_hblurRc = gr.newInstance<ResourceGroup>(rcinit);
-
-	rcinit = ResourceGroupInitInfo();
-	rcinit.m_textures[0].m_texture = m_hblurRt;
-	m_vblurRc = gr.newInstance<ResourceGroup>(rcinit);
-
 	gr.finish();
 	return ErrorCode::NONE;
 }
@@ -266,34 +246,78 @@ Error Ssao::init(const ConfigSet& config)
 	return err;
 }
 
-void Ssao::setPreRunBarriers(RenderingContext& ctx)
+void Ssao::populateRenderGraph(RenderingContext& ctx)
 {
-	ctx.m_commandBuffer->setTextureSurfaceBarrier(m_vblurRt,
-		TextureUsageBit::NONE,
-		TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE,
-		TextureSurfaceInfo(0, 0, 0, 0));
+	RenderGraph& graph = m_r->getRenderGraph();
+
+	ctx.m_ssao.m_rt = graph.newTexture(m_rtInit, "SSAO");
+
+	U pass = graph.newPass("SSAO", runMain, this);
+	graph.newWrite(pass, ctx.m_ssao.m_rt, TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE);
+
+	if(m_blurringIterationsCount > 0)
+	{
+		ctx.m_ssao.m_hblurRt = graph.newTexture(m_rtInit, "SSAO hblur");
+	}
+
+	for(U i = 0; i < m_blurringIterationsCount; i++)
+	{
+		pass = graph.newPass("SSAO hblur", runHBlur, this);
+		graph.newRead(pass, ctx.m_ssao.m_rt, TextureUsageBit::SAMPLED_FRAGMENT);
+		graph.newWrite(pass, ctx.m_ssao.m_hblurRt, TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE);
+
+		pass = graph.newPass("SSAO vblur", runVBlur, this);
+		graph.newRead(pass, ctx.m_ssao.m_hblurRt, TextureUsageBit::SAMPLED_FRAGMENT);
+		graph.newWrite(pass, ctx.m_ssao.m_rt, TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE);
+	}
 }
 
-void Ssao::setPostRunBarriers(RenderingContext& ctx)
+void Ssao::updateRenderTargets(const RenderingContext& ctx)
 {
-	ctx.m_commandBuffer->setTextureSurfaceBarrier(m_vblurRt,
-		TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE,
-		TextureUsageBit::SAMPLED_FRAGMENT,
-		TextureSurfaceInfo(0, 0, 0, 0));
+	const RenderGraph& graph = m_r->getRenderGraph();
+
+	TexturePtr vblurRt = graph.getTexture(ctx.m_ssao.m_rt);
+	if(vblurRt != m_vblurRt)
+	{
+		m_vblurRt = vblurRt;
+		createFb(m_vblurRt, m_vblurFb);
+
+		ResourceGroupInitInfo rcinit;
+		rcinit.m_textures[0].m_texture = m_vblurRt;
+		m_hblurRc = getGrManager().newInstance<ResourceGroup>(rcinit);
+	}
+
+	if(m_blurringIterationsCount == 0)
+	{
+		return;
+	}
+
+	TexturePtr hblurRt = graph.getTexture(ctx.m_ssao.m_hblurRt);
+	if(hblurRt != m_hblurRt)
+	{
+		m_hblurRt = hblurRt;
+		createFb(m_hblurRt, m_hblurFb);
+
+		ResourceGroupInitInfo rcinit;
+		rcinit.m_textures[0].m_texture = m_hblurRt;
+		m_vblurRc = getGrManager().newInstance<ResourceGroup>(rcinit);
+	}
 }
 
-void Ssao::run(RenderingContext& ctx)
+Error Ssao::runMain(RenderGraphRunContext& rctx)
 {
-	CommandBufferPtr& cmdb = ctx.m_commandBuffer;
+	Ssao& self = *static_cast<Ssao*>(rctx.m_userData);
+	const RenderingContext& ctx = *static_cast<RenderingContext*>(rctx.m_frameUserData);
+	CommandBufferPtr& cmdb = rctx.m_commandBuffer;
 
-	// 1st pass
-	//
-	cmdb->beginRenderPass(m_vblurFb);
-	cmdb->setViewport(0, 0, m_width, m_height);
-	cmdb->bindPipeline(m_ssaoPpline);
+	self.updateRenderTargets(ctx);
+
+	cmdb->beginRenderPass(self.m_vblurFb);
+	cmdb->setViewport(0, 0, self.m_width, self.m_height);
+	cmdb->bindPipeline(self.m_ssaoPpline);
 
 	TransientMemoryInfo inf;
-	Vec4* unis = static_cast<Vec4*>(getGrManager().allocateFrameTransientMemory(
+	Vec4* unis = static_cast<Vec4*>(self.getGrManager().allocateFrameTransientMemory(
 		sizeof(Vec4) * 2, BufferUsageBit::UNIFORM_ALL, inf.m_uniformBuffers[0]));
 
 	const FrustumComponent& frc = *ctx.m_frustumComponent;
@@ -302,46 +326,41 @@ void Ssao::run(RenderingContext& ctx)
 	++unis;
 	*unis = Vec4(pmat(0, 0), pmat(1, 1), pmat(2, 2), pmat(2, 3));
 
-	cmdb->bindResourceGroup(m_rcFirst, 0, &inf);
+	cmdb->bindResourceGroup(self.m_rcFirst, 0, &inf);
 
 	// Draw
-	m_r->drawQuad(cmdb);
+	self.m_r->drawQuad(cmdb);
 	cmdb->endRenderPass();
 
-	// Blurring passes
-	//
-	for(U i = 0; i < m_blurringIterationsCount; i++)
-	{
-		// hpass
-		cmdb->setTextureSurfaceBarrier(m_vblurRt,
-			TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE,
-			TextureUsageBit::SAMPLED_FRAGMENT,
-			TextureSurfaceInfo(0, 0, 0, 0));
-		cmdb->setTextureSurfaceBarrier(m_hblurRt,
-			TextureUsageBit::NONE,
-			TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE,
-			TextureSurfaceInfo(0, 0, 0, 0));
-		cmdb->beginRenderPass(m_hblurFb);
-		cmdb->bindPipeline(m_hblurPpline);
-		cmdb->bindResourceGroup(m_hblurRc, 0, nullptr);
-		m_r->drawQuad(cmdb);
-		cmdb->endRenderPass();
-
-		// vpass
-		cmdb->setTextureSurfaceBarrier(m_hblurRt,
-			TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE,
-			TextureUsageBit::SAMPLED_FRAGMENT,
-			TextureSurfaceInfo(0, 0, 0, 0));
-		cmdb->setTextureSurfaceBarrier(m_vblurRt,
-			TextureUsageBit::NONE,
-			TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE,
-			TextureSurfaceInfo(0, 0, 0, 0));
-		cmdb->beginRenderPass(m_vblurFb);
-		cmdb->bindPipeline(m_vblurPpline);
-		cmdb->bindResourceGroup(m_vblurRc, 0, nullptr);
-		m_r->drawQuad(cmdb);
-		cmdb->endRenderPass();
-	}
+	return ErrorCode::NONE;
+}
+
+Error Ssao::runHBlur(RenderGraphRunContext& rctx)
+{
+	Ssao& self = *static_cast<Ssao*>(rctx.m_userData);
+	CommandBufferPtr& cmdb = rctx.m_commandBuffer;
+
+	cmdb->beginRenderPass(self.m_hblurFb);
+	cmdb->bindPipeline(self.m_hblurPpline);
+	cmdb->bindResourceGroup(self.m_hblurRc, 0, nullptr);
+	self.m_r->drawQuad(cmdb);
+	cmdb->endRenderPass();
+
+	return ErrorCode::NONE;
+}
+
+Error Ssao::runVBlur(RenderGraphRunContext& rctx)
+{
+	Ssao& self = *static_cast<Ssao*>(rctx.m_userData);
+	CommandBufferPtr& cmdb = rctx.m_commandBuffer;
+
+	cmdb->beginRenderPass(self.m_vblurFb);
+	cmdb->bindPipeline(self.m_vblurPpline);
+	cmdb->bindResourceGroup(self.m_vblurRc, 0, nullptr);
+	self.m_r->drawQuad(cmdb);
+	cmdb->endRenderPass();
+
+	return ErrorCode::NONE;
 }
 
 } // end namespace anki
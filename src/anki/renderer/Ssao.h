@@ -30,19 +30,16 @@ anki_internal:
 
 	ANKI_USE_RESULT Error init(const ConfigSet& initializer);
 
-	void setPreRunBarriers(RenderingContext& ctx);
-	void run(RenderingContext& ctx);
-	void setPostRunBarriers(RenderingContext& ctx);
-
-	TexturePtr& getRt()
-	{
-		return m_vblurRt;
-	}
+	/// Add the SSAO and the blurring passes. The result is RenderingContext::m_ssao.m_rt.
+	void populateRenderGraph(RenderingContext& ctx);
 
 private:
 	U32 m_width, m_height; ///< Blur passes size
 	U8 m_blurringIterationsCount;
 
+	TextureInitInfo m_rtInit; ///< The render graph sets the usage.
+
+	/// The textures that the render graph gave the last time. The framebuffers and the resource groups use them.
 	TexturePtr m_vblurRt;
 	TexturePtr m_hblurRt;
 	FramebufferPtr m_vblurFb;
@@ -62,8 +59,15 @@ private:
 	ResourceGroupPtr m_hblurRc;
 	ResourceGroupPtr m_vblurRc;
 
-	ANKI_USE_RESULT Error createFb(FramebufferPtr& fb, TexturePtr& rt);
+	void createFb(TexturePtr rt, FramebufferPtr& fb);
 	ANKI_USE_RESULT Error initInternal(const ConfigSet& initializer);
+
+	/// Recreate the framebuffers and the resource groups if the render graph gave other textures.
+	void updateRenderTargets(const RenderingContext& ctx);
+
+	static ANKI_USE_RESULT Error runMain(RenderGraphRunContext& rctx);
+	static ANKI_USE_RESULT Error runHBlur(RenderGraphRunContext& rctx);
+	static ANKI_USE_RESULT Error runVBlur(RenderGraphRunContext& rctx);
 };
 /// @}
 
@@ -41,16 +41,9 @@ Error Sslf::initInternal(const ConfigSet& config)
 
 	m_r->createDrawQuadPipeline(m_frag->getGrShader(), colorState, m_ppline);
 
-	// Textures
+	// Textures. The resource group needs the bloom exposure of the render graph so it's created when it runs
 	ANKI_CHECK(getResourceManager().loadResource("engine_data/LensDirt.ankitex", m_lensDirtTex));
 
-	// Create the resource group
-	ResourceGroupInitInfo rcInit;
-	rcInit.m_textures[0].m_texture = m_r->getBloom().m_extractExposure.m_rt;
-	rcInit.m_textures[1].m_texture = m_lensDirtTex->getGrTexture();
-
-	m_rcGroup = getGrManager().newInstance<ResourceGroup>(rcInit);
-
 	getGrManager().finish();
 	return ErrorCode::NONE;
 }
@@ -59,6 +52,17 @@ void Sslf::run(RenderingContext& ctx)
 {
 	CommandBufferPtr& cmdb = ctx.m_commandBuffer;
 
+	TexturePtr exposureRt = m_r->getRenderGraph().getTexture(ctx.m_bloom.m_exposureRt);
+	if(exposureRt != m_exposureRt)
+	{
+		m_exposureRt = exposureRt;
+
+		ResourceGroupInitInfo rcInit;
+		rcInit.m_textures[0].m_texture = m_exposureRt;
+		rcInit.m_textures[1].m_texture = m_lensDirtTex->getGrTexture();
+		m_rcGroup = getGrManager().newInstance<ResourceGroup>(rcInit);
+	}
+
 	// Draw to the SSLF FB
 	cmdb->bindPipeline(m_ppline);
 	cmdb->bindResourceGroup(m_rcGroup, 0, nullptr);
@@ -30,6 +30,7 @@ private:
 	PipelinePtr m_ppline;
 	TextureResourcePtr m_lensDirtTex;
 	ResourceGroupPtr m_rcGroup;
+	TexturePtr m_exposureRt; ///< The bloom exposure of m_rcGroup. The render graph may give another.
 
 	ANKI_USE_RESULT Error initInternal(const ConfigSet& config);
 };
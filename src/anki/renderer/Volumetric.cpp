@@ -24,13 +24,13 @@ Error Volumetric::init(const ConfigSet& config)
 	U height = m_r->getHeight() / VOLUMETRIC_FRACTION;
 
 	// Create RTs
-	m_r->createRenderTarget(width,
+	m_rtInit = m_r->createRenderTargetInitInfo(width,
 		height,
 		IS_COLOR_ATTACHMENT_PIXEL_FORMAT,
 		TextureUsageBit::SAMPLED_FRAGMENT | TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE | TextureUsageBit::CLEAR,
 		SamplingFilter::LINEAR,
-		1,
-		m_rt);
+		1);
+	m_rt = getGrManager().newInstance<Texture>(m_rtInit);
 
 	m_r->clearRenderTarget(m_rt, ClearValue(), TextureUsageBit::SAMPLED_FRAGMENT);
 
@@ -85,20 +85,21 @@ Error Volumetric::init(const ConfigSet& config)
 	return ErrorCode::NONE;
 }
 
-void Volumetric::setPreRunBarriers(RenderingContext& ctx)
+void Volumetric::populateRenderGraph(RenderingContext& ctx)
 {
-	ctx.m_commandBuffer->setTextureSurfaceBarrier(m_rt,
-		TextureUsageBit::NONE,
-		TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE,
-		TextureSurfaceInfo(0, 0, 0, 0));
+	RenderGraph& graph = m_r->getRenderGraph();
+
+	// The FS of the previous frame left it sampled
+	ctx.m_vol.m_rt = graph.importTexture(m_rt, m_rtInit, TextureUsageBit::SAMPLED_FRAGMENT, "Volumetric");
+
+	U pass = graph.newPass("Volumetric", runCallback, this);
+	graph.newWrite(pass, ctx.m_vol.m_rt, TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE);
 }
 
-void Volumetric::setPostRunBarriers(RenderingContext& ctx)
+Error Volumetric::runCallback(RenderGraphRunContext& rctx)
 {
-	ctx.m_commandBuffer->setTextureSurfaceBarrier(m_rt,
-		TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE,
-		TextureUsageBit::SAMPLED_FRAGMENT,
-		TextureSurfaceInfo(0, 0, 0, 0));
+	static_cast<Volumetric*>(rctx.m_userData)->run(*static_cast<RenderingContext*>(rctx.m_frameUserData));
+	return ErrorCode::NONE;
 }
 
 void Volumetric::run(RenderingContext& ctx)
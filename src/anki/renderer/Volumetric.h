@@ -24,7 +24,7 @@ public:
 	}
 
 anki_internal:
-	TexturePtr m_rt;
+	TexturePtr m_rt; ///< It blends with the previous frames so it's imported to the render graph.
 
 	Volumetric(Renderer* r)
 		: RenderingPass(r)
@@ -35,11 +35,10 @@ anki_internal:
 
 	ANKI_USE_RESULT Error init(const ConfigSet& config);
 
-	void setPreRunBarriers(RenderingContext& ctx);
-	void run(RenderingContext& ctx);
-	void setPostRunBarriers(RenderingContext& ctx);
+	void populateRenderGraph(RenderingContext& ctx);
 
 private:
+	TextureInitInfo m_rtInit;
 	ResourceGroupPtr m_rc;
 	ShaderResourcePtr m_frag;
 	PipelinePtr m_ppline;
@@ -47,6 +46,10 @@ private:
 
 	Vec3 m_fogColor = Vec3(1.0);
 	F32 m_fogFactor = 1.0;
+
+	void run(RenderingContext& ctx);
+
+	static ANKI_USE_RESULT Error runCallback(RenderGraphRunContext& rctx);
 };
 /// @}
 
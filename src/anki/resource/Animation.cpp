@@ -4,6 +4,7 @@
 // http://www.anki3d.org/LICENSE
 
 #include <anki/resource/Animation.h>
+#include <anki/resource/CompiledResourceCache.h>
 #include <anki/misc/Xml.h>
 
 namespace anki
@@ -22,253 +23,617 @@ Animation::~Animation()
 	}
 
 	m_channels.destroy(getAllocator());
+	m_keys.destroy(getAllocator());
 }
 
-Error Animation::load(const ResourceFilename& filename)
-{
-	XmlElement el;
-	I64 tmp;
-	F64 ftmp;
-
-	m_startTime = MAX_F32;
-	F32 maxTime = MIN_F32;
-
-	// Document
-	XmlDocument doc;
-	ANKI_CHECK(openFileParseXml(filename, doc));
-	XmlElement rootel;
-	ANKI_CHECK(doc.getChildElement("animation", rootel));
+/// The range of the 3 smallest components of a unit quaternion.
+static const F32 SMALLEST_THREE_RANGE = 1.0 / sqrt(2.0);
 
-	// Count the number of identity keys. If all of the keys are identities drop a vector
-	U identPosCount = 0;
-	U identRotCount = 0;
-	U identScaleCount = 0;
+/// The number of the padding keys at the end of the key memory. The SIMD loads read 4 keys at a time.
+static const U32 KEY_PADDING = 4;
 
-	// <repeat>
-	XmlElement repel;
-	ANKI_CHECK(rootel.getChildElementOptional("repeat", repel));
-	if(repel)
+static ANKI_USE_RESULT Error readKeyValue(const XmlElement& el, U32 componentCount, Vec4& value)
+{
+	value = Vec4(0.0);
+	if(componentCount == 3)
 	{
-		ANKI_CHECK(repel.getI64(tmp));
-		m_repeat = tmp;
+		Vec3 tmp;
+		ANKI_CHECK(el.getVec3(tmp));
+		value = Vec4(tmp, 0.0);
+	}
+	else if(componentCount == 4)
+	{
+		ANKI_CHECK(el.getVec4(value));
 	}
 	else
 	{
-		m_repeat = false;
+		F64 tmp;
+		ANKI_CHECK(el.getF64(tmp));
+		value.x() = tmp;
 	}
 
-	// <channels>
-	XmlElement channelsEl;
-	ANKI_CHECK(rootel.getChildElement("channels", channelsEl));
-	XmlElement chEl;
-	ANKI_CHECK(channelsEl.getChildElement("channel", chEl));
+	return ErrorCode::NONE;
+}
 
-	U32 channelCount = 0;
-	ANKI_CHECK(chEl.getSiblingElementsCount(channelCount));
-	if(channelCount == 0)
+/// Read the keys of a track. The values are stored in Vec4 no matter the type.
+static ANKI_USE_RESULT Error readKeys(const XmlElement& chEl,
+	CString tag,
+	U32 componentCount,
+	DynamicArrayAuto<F32>& times,
+	DynamicArrayAuto<Vec4>& values)
+{
+	XmlElement keysEl, keyEl, el;
+	ANKI_CHECK(chEl.getChildElementOptional(tag, keysEl));
+	if(!keysEl)
 	{
-		ANKI_LOGE("Didn't found any channels");
-		return ErrorCode::USER_DATA;
+		return ErrorCode::NONE;
 	}
-	m_channels.create(getAllocator(), channelCount);
 
-	// For all channels
-	channelCount = 0;
+	ANKI_CHECK(keysEl.getChildElement("key", keyEl));
+	U32 count = 0;
+	ANKI_CHECK(keyEl.getSiblingElementsCount(count));
+	++count;
+
+	times.create(count);
+	values.create(count);
+
+	U i = 0;
 	do
 	{
-		AnimationChannel& ch = m_channels[channelCount];
+		// <time>
+		F64 time;
+		ANKI_CHECK(keyEl.getChildElement("time", el));
+		ANKI_CHECK(el.getF64(time));
+		times[i] = time;
 
-		// <name>
-		ANKI_CHECK(chEl.getChildElement("name", el));
-		CString strtmp;
-		ANKI_CHECK(el.getText(strtmp));
-		ch.m_name.create(getAllocator(), strtmp);
+		if(i > 0 && times[i] < times[i - 1])
+		{
+			ANKI_LOGE("The keys are not sorted by time");
+			return ErrorCode::USER_DATA;
+		}
+
+		// <value>
+		ANKI_CHECK(keyEl.getChildElement("value", el));
+		ANKI_CHECK(readKeyValue(el, componentCount, values[i]));
+
+		// Move to next
+		++i;
+		ANKI_CHECK(keyEl.getNextSiblingElement("key", keyEl));
+	} while(keyEl);
+
+	return ErrorCode::NONE;
+}
 
-		XmlElement keysEl, keyEl;
+static Vec4 toVec4(const Quat& q)
+{
+	return Vec4(q.x(), q.y(), q.z(), q.w());
+}
 
-		// <positionKeys>
-		ANKI_CHECK(chEl.getChildElementOptional("positionKeys", keysEl));
-		if(keysEl)
+/// Evaluate the keys at a time. The cursor is the last key before the time and it's moved forward as the time grows.
+static Vec4 evaluateKeys(
+	const DynamicArrayAuto<F32>& times, const DynamicArrayAuto<Vec4>& values, Bool rotation, F32 time, U& cursor)
+{
+	const U count = times.getSize();
+	while(cursor + 1 < count && times[cursor + 1] <= time)
+	{
+		++cursor;
+	}
+
+	if(cursor + 1 == count || time <= times[cursor])
+	{
+		return values[cursor];
+	}
+
+	const F32 u = (time - times[cursor]) / (times[cursor + 1] - times[cursor]);
+	if(rotation)
+	{
+		return toVec4(Quat(values[cursor]).slerp(Quat(values[cursor + 1]), u));
+	}
+	else
+	{
+		return linearInterpolate(values[cursor], values[cursor + 1], u);
+	}
+}
+
+/// Quantize a unit quaternion to 3 U16. The 3 smallest components get 15 bits each and the index of the largest is
+/// stored in the top bits of the first two. The largest is positive so it can be reconstructed.
+static void quantizeRotation(Vec4 q, U16* out)
+{
+	U largest = 0;
+	for(U i = 1; i < 4; ++i)
+	{
+		if(absolute(q[i]) > absolute(q[largest]))
 		{
-			ANKI_CHECK(keysEl.getChildElement("key", keyEl));
+			largest = i;
+		}
+	}
 
-			U32 count = 0;
-			ANKI_CHECK(keyEl.getSiblingElementsCount(count));
-			ch.m_positions.create(getAllocator(), count);
+	if(q[largest] < 0.0)
+	{
+		q = -q;
+	}
 
-			count = 0;
-			do
-			{
-				Key<Vec3>& key = ch.m_positions[count++];
-
-				// <time>
-				ANKI_CHECK(keyEl.getChildElement("time", el));
-				ANKI_CHECK(el.getF64(ftmp));
-				key.m_time = ftmp;
-				m_startTime = std::min(m_startTime, key.m_time);
-				maxTime = std::max(maxTime, key.m_time);
-
-				// <value>
-				ANKI_CHECK(keyEl.getChildElement("value", el));
-				ANKI_CHECK(el.getVec3(key.m_value));
-
-				// Check ident
-				if(key.m_value == Vec3(0.0))
-				{
-					++identPosCount;
-				}
-
-				// Move to next
-				ANKI_CHECK(keyEl.getNextSiblingElement("key", keyEl));
-			} while(keyEl);
+	U j = 0;
+	for(U i = 0; i < 4; ++i)
+	{
+		if(i == largest)
+		{
+			continue;
 		}
 
-		// <rotationKeys>
-		ANKI_CHECK(chEl.getChildElement("rotationKeys", keysEl));
-		if(keysEl)
+		const F32 f = (clamp(q[i], -SMALLEST_THREE_RANGE, SMALLEST_THREE_RANGE) + SMALLEST_THREE_RANGE)
+			/ (2.0 * SMALLEST_THREE_RANGE);
+		out[j++] = U16(f * F32(MAX_I16) + 0.5);
+	}
+
+	out[0] |= U16((largest & 1) << 15);
+	out[1] |= U16((largest >> 1) << 15);
+}
+
+static Quat dequantizeRotation(const U16* in)
+{
+	const U largest = (in[0] >> 15) | ((in[1] >> 15) << 1);
+	const F32 scale = 2.0 * SMALLEST_THREE_RANGE / F32(MAX_I16);
+
+#if ANKI_SIMD == ANKI_SIMD_SSE
+	// Load 4 keys, the 4th is ignored
+	__m128i k = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in));
+	k = _mm_and_si128(k, _mm_set1_epi16(MAX_I16));
+	__m128 q = _mm_cvtepi32_ps(_mm_cvtepu16_epi32(k));
+	q = _mm_sub_ps(_mm_mul_ps(q, _mm_set1_ps(scale)), _mm_set1_ps(SMALLEST_THREE_RANGE));
+
+	// Reconstruct the largest in W
+	const __m128 sum = _mm_dp_ps(q, q, 0x7F);
+	const __m128 w = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.0), sum), _mm_setzero_ps()));
+	q = _mm_blend_ps(q, w, 8);
+
+	// Move the largest to its place
+	switch(largest)
+	{
+	case 0:
+		q = _mm_shuffle_ps(q, q, _MM_SHUFFLE(2, 1, 0, 3));
+		break;
+	case 1:
+		q = _mm_shuffle_ps(q, q, _MM_SHUFFLE(2, 1, 3, 0));
+		break;
+	case 2:
+		q = _mm_shuffle_ps(q, q, _MM_SHUFFLE(2, 3, 1, 0));
+		break;
+	default:
+		break;
+	}
+
+	return Quat(q);
+#else
+	Array<F32, 4> q;
+	F32 sum = 0.0;
+	U j = 0;
+	for(U i = 0; i < 4; ++i)
+	{
+		if(i == largest)
 		{
-			ANKI_CHECK(keysEl.getChildElement("key", keyEl));
+			continue;
+		}
 
-			U32 count = 0;
-			ANKI_CHECK(keysEl.getSiblingElementsCount(count));
-			ch.m_rotations.create(getAllocator(), count);
+		q[i] = F32(in[j++] & MAX_I16) * scale - SMALLEST_THREE_RANGE;
+		sum += q[i] * q[i];
+	}
 
-			count = 0;
-			do
-			{
-				Key<Quat>& key = ch.m_rotations[count++];
-
-				// <time>
-				ANKI_CHECK(keyEl.getChildElement("time", el));
-				ANKI_CHECK(el.getF64(ftmp));
-				key.m_time = ftmp;
-				m_startTime = std::min(m_startTime, key.m_time);
-				maxTime = std::max(maxTime, key.m_time);
-
-				// <value>
-				Vec4 tmp2;
-				ANKI_CHECK(keyEl.getChildElement("value", el));
-				ANKI_CHECK(el.getVec4(tmp2));
-				key.m_value = Quat(tmp2);
-
-				// Check ident
-				if(key.m_value == Quat::getIdentity())
-				{
-					++identRotCount;
-				}
-
-				// Move to next
-				ANKI_CHECK(keyEl.getNextSiblingElement("key", keyEl));
-			} while(keyEl);
+	q[largest] = sqrt(max<F32>(1.0 - sum, 0.0));
+	return Quat(q[0], q[1], q[2], q[3]);
+#endif
+}
+
+static void writeTrack(const AnimationTrack& track, BinaryWriter& out)
+{
+	out.write(track.m_min);
+	out.write(track.m_scale);
+	out.write(track.m_offset);
+	out.write(track.m_keyCount);
+}
+
+/// Resample the keys of a track at the times of the samples, quantize them and append them to the key memory.
+static void compileKeys(const DynamicArrayAuto<F32>& times,
+	const DynamicArrayAuto<Vec4>& values,
+	U32 componentCount,
+	F32 startTime,
+	F32 duration,
+	U32 sampleCount,
+	GenericMemoryPoolAllocator<U8> alloc,
+	DynamicArrayAuto<U16>& keys,
+	U32& keyCount,
+	BinaryWriter& out)
+{
+	const Bool rotation = componentCount == 4;
+
+	AnimationTrack track;
+	if(times.getSize() == 0)
+	{
+		writeTrack(track, out);
+		return;
+	}
+
+	// Resample
+	DynamicArrayAuto<Vec4> samples(alloc);
+	samples.create(sampleCount);
+	U cursor = 0;
+	for(U i = 0; i < sampleCount; ++i)
+	{
+		const F32 time = (sampleCount > 1) ? startTime + duration * F32(i) / F32(sampleCount - 1) : startTime;
+		samples[i] = evaluateKeys(times, values, rotation, time, cursor);
+
+		if(rotation)
+		{
+			samples[i] = toVec4(Quat(samples[i]).getNormalized());
 		}
+	}
 
-		// <scalingKeys>
-		ANKI_CHECK(chEl.getChildElementOptional("scalingKeys", keysEl));
-		if(keysEl)
+	// Compute the range. If there is none the track is constant
+	Vec4 minv(MAX_F32), maxv(MIN_F32);
+	Bool constant = true;
+	for(U i = 0; i < sampleCount; ++i)
+	{
+		for(U c = 0; c < 4; ++c)
 		{
-			ANKI_CHECK(keysEl.getChildElement("key", keyEl));
+			minv[c] = min(minv[c], samples[i][c]);
+			maxv[c] = max(maxv[c], samples[i][c]);
+		}
+
+		if(rotation)
+		{
+			constant = constant && absolute(samples[i].dot(samples[0])) >= 1.0 - EPSILON;
+		}
+	}
+
+	if(!rotation)
+	{
+		constant = (maxv - minv).getLength() <= EPSILON;
+		track.m_min = minv;
+		track.m_scale = (constant) ? Vec4(0.0) : (maxv - minv) / F32(MAX_U16);
+	}
 
-			U32 count = 0;
-			ANKI_CHECK(keyEl.getSiblingElementsCount(count));
-			ch.m_scales.create(getAllocator(), count);
+	track.m_offset = keyCount;
+	track.m_keyCount = (constant) ? 1 : sampleCount;
+	writeTrack(track, out);
 
-			count = 0;
-			do
+	// Quantize. Leave room for the padding as well
+	const U32 keySize = (rotation) ? 3 : min<U32>(componentCount, 3);
+	keyCount += track.m_keyCount * keySize;
+	if(keyCount + KEY_PADDING > keys.getSize())
+	{
+		keys.resize(max<PtrSize>(keyCount + KEY_PADDING, keys.getSize() * 2));
+	}
+
+	U16* key = &keys[track.m_offset];
+	for(U i = 0; i < track.m_keyCount; ++i)
+	{
+		if(rotation)
+		{
+			quantizeRotation(samples[i], key);
+		}
+		else
+		{
+			for(U c = 0; c < keySize; ++c)
 			{
-				Key<F32>& key = ch.m_scales[count++];
-
-				// <time>
-				ANKI_CHECK(keyEl.getChildElement("time", el));
-				ANKI_CHECK(el.getF64(ftmp));
-				key.m_time = ftmp;
-				m_startTime = std::min(m_startTime, key.m_time);
-				maxTime = std::max(maxTime, key.m_time);
-
-				// <value>
-				ANKI_CHECK(keyEl.getChildElement("value", el));
-				ANKI_CHECK(el.getF64(ftmp));
-				key.m_value = ftmp;
-
-				// Check ident
-				if(isZero(key.m_value - 1.0))
-				{
-					++identScaleCount;
-				}
-
-				// Move to next
-				ANKI_CHECK(keyEl.getNextSiblingElement("key", keyEl));
-			} while(keyEl);
+				const F32 range = maxv[c] - minv[c];
+				key[c] = (range > 0.0) ? U16((samples[i][c] - minv[c]) / range * F32(MAX_U16) + 0.5) : 0;
+			}
 		}
 
-		// Remove identity vectors
-		if(identPosCount == ch.m_positions.getSize())
+		key += keySize;
+	}
+}
+
+Error Animation::compileXml(const XmlDocument& doc, BinaryWriter& out, void* userData)
+{
+	ANKI_ASSERT(userData);
+	Animation& self = *static_cast<Animation*>(userData);
+	GenericMemoryPoolAllocator<U8> alloc = self.getTempAllocator();
+
+	XmlElement rootel;
+	ANKI_CHECK(doc.getChildElement("animation", rootel));
+
+	// <repeat>
+	XmlElement el;
+	ANKI_CHECK(rootel.getChildElementOptional("repeat", el));
+	I64 repeat = 0;
+	if(el)
+	{
+		ANKI_CHECK(el.getI64(repeat));
+	}
+	out.write<U8>(repeat != 0);
+
+	// <sampleRate>
+	ANKI_CHECK(rootel.getChildElementOptional("sampleRate", el));
+	I64 sampleRate = DEFAULT_SAMPLE_RATE;
+	if(el)
+	{
+		ANKI_CHECK(el.getI64(sampleRate));
+		if(sampleRate <= 0)
 		{
-			ch.m_positions.destroy(getAllocator());
+			ANKI_LOGE("Incorrect sample rate: %d", I32(sampleRate));
+			return ErrorCode::USER_DATA;
 		}
+	}
 
-		if(identRotCount == ch.m_rotations.getSize())
+	// <channels>
+	XmlElement channelsEl;
+	ANKI_CHECK(rootel.getChildElement("channels", channelsEl));
+	XmlElement firstChEl;
+	ANKI_CHECK(channelsEl.getChildElement("channel", firstChEl));
+
+	U32 channelCount = 0;
+	ANKI_CHECK(firstChEl.getSiblingElementsCount(channelCount));
+	++channelCount;
+
+	const Array<CString, 3> tags = {{"positionKeys", "rotationKeys", "scalingKeys"}};
+	const Array<U32, 3> componentCounts = {{3, 4, 1}};
+
+	// Find the time range of all the keys
+	F32 minTime = MAX_F32;
+	F32 maxTime = MIN_F32;
+	XmlElement chEl = firstChEl;
+	do
+	{
+		for(U i = 0; i < 3; ++i)
 		{
-			ch.m_rotations.destroy(getAllocator());
+			DynamicArrayAuto<F32> times(alloc);
+			DynamicArrayAuto<Vec4> values(alloc);
+			ANKI_CHECK(readKeys(chEl, tags[i], componentCounts[i], times, values));
+
+			if(times.getSize() > 0)
+			{
+				minTime = min(minTime, times[0]);
+				maxTime = max(maxTime, times[times.getSize() - 1]);
+			}
 		}
 
-		if(identScaleCount == ch.m_scales.getSize())
+		ANKI_CHECK(chEl.getNextSiblingElement("channel", chEl));
+	} while(chEl);
+
+	if(minTime > maxTime)
+	{
+		minTime = maxTime = 0.0;
+	}
+
+	const F32 duration = maxTime - minTime;
+	const U32 sampleCount = (duration > 0.0) ? U32(ceil(duration * F32(sampleRate))) + 1 : 1;
+
+	out.write(minTime);
+	out.write(duration);
+	out.write(sampleCount);
+	out.write(channelCount);
+
+	// Compile the channels
+	DynamicArrayAuto<U16> keys(alloc);
+	U32 keyCount = 0;
+	chEl = firstChEl;
+	do
+	{
+		// <name>
+		ANKI_CHECK(chEl.getChildElement("name", el));
+		CString name;
+		ANKI_CHECK(el.getText(name));
+		out.writeString(name);
+
+		// <positionKeys>, <rotationKeys> and <scalingKeys>
+		for(U i = 0; i < 3; ++i)
 		{
-			ch.m_scales.destroy(getAllocator());
+			DynamicArrayAuto<F32> times(alloc);
+			DynamicArrayAuto<Vec4> values(alloc);
+			ANKI_CHECK(readKeys(chEl, tags[i], componentCounts[i], times, values));
+
+			compileKeys(times, values, componentCounts[i], minTime, duration, sampleCount, alloc, keys, keyCount, out);
 		}
 
 		// Move to next channel
-		++channelCount;
 		ANKI_CHECK(chEl.getNextSiblingElement("channel", chEl));
 	} while(chEl);
 
-	m_duration = maxTime - m_startTime;
+	// Trim the keys and zero the padding
+	keys.resize(keyCount + KEY_PADDING);
+	for(U i = keyCount; i < keys.getSize(); ++i)
+	{
+		keys[i] = 0;
+	}
+
+	out.writeArray(keys);
 
 	return ErrorCode::NONE;
 }
 
-void Animation::interpolate(U channelIndex, F32 time, Vec3& pos, Quat& rot, F32& scale) const
+Error Animation::readTrack(BinaryReader& in, AnimationTrack& track)
 {
-	// Audjust time
-	if(m_repeat && time > m_startTime + m_duration)
+	ANKI_CHECK(in.read(track.m_min));
+	ANKI_CHECK(in.read(track.m_scale));
+	ANKI_CHECK(in.read(track.m_offset));
+	ANKI_CHECK(in.read(track.m_keyCount));
+
+	if(track.m_keyCount > 1 && track.m_keyCount != m_sampleCount)
 	{
-		time = mod(time - m_startTime, m_duration) + m_startTime;
+		ANKI_LOGE("Wrong key count");
+		return ErrorCode::USER_DATA;
 	}
 
-	ANKI_ASSERT(time >= m_startTime && time <= m_startTime + m_duration);
-	ANKI_ASSERT(channelIndex < m_channels.getSize());
+	return ErrorCode::NONE;
+}
 
-	const AnimationChannel& channel = m_channels[channelIndex];
+Error Animation::load(const ResourceFilename& filename)
+{
+	DynamicArrayAuto<U8> compiled(getTempAllocator());
+	ANKI_CHECK(openFileCompiled(filename, COMPILED_VERSION, compileXml, this, compiled));
+	BinaryReader in(&compiled[0], compiled.getSize());
 
-	// Position
-	if(channel.m_positions.getSize() > 1)
+	U8 repeat;
+	ANKI_CHECK(in.read(repeat));
+	m_repeat = repeat;
+
+	ANKI_CHECK(in.read(m_startTime));
+	ANKI_CHECK(in.read(m_duration));
+	ANKI_CHECK(in.read(m_sampleCount));
+
+	U32 channelCount;
+	ANKI_CHECK(in.read(channelCount));
+	if(channelCount == 0)
 	{
-		auto next = channel.m_positions.begin();
+		ANKI_LOGE("Didn't found any channels");
+		return ErrorCode::USER_DATA;
+	}
+	m_channels.create(getAllocator(), channelCount);
 
-		do
+	for(AnimationChannel& ch : m_channels)
+	{
+		CString name;
+		ANKI_CHECK(in.readString(name));
+		ch.m_name.create(getAllocator(), name);
+
+		ANKI_CHECK(readTrack(in, ch.m_positions));
+		ANKI_CHECK(readTrack(in, ch.m_rotations));
+		ANKI_CHECK(readTrack(in, ch.m_scales));
+	}
+
+	ANKI_CHECK(in.readArray(getAllocator(), m_keys));
+
+	// Check that the tracks point inside the keys
+	for(const AnimationChannel& ch : m_channels)
+	{
+		if(ch.m_positions.m_offset + ch.m_positions.m_keyCount * 3 + KEY_PADDING > m_keys.getSize()
+			|| ch.m_rotations.m_offset + ch.m_rotations.m_keyCount * 3 + KEY_PADDING > m_keys.getSize()
+			|| ch.m_scales.m_offset + ch.m_scales.m_keyCount + KEY_PADDING > m_keys.getSize())
 		{
-		} while((next->m_time < time) && (++next != channel.m_positions.end()));
+			ANKI_LOGE("The tracks are out of bounds");
+			return ErrorCode::USER_DATA;
+		}
+	}
 
-		ANKI_ASSERT(next != channel.m_positions.end());
-		auto prev = next - 1;
+	return ErrorCode::NONE;
+}
 
-		F32 u = (time - prev->m_time) / (next->m_time - prev->m_time);
-		pos = linearInterpolate(prev->m_value, next->m_value, u);
+void Animation::computeKey(F32 time, U32& key, F32& u) const
+{
+	key = 0;
+	u = 0.0;
+	if(m_sampleCount < 2)
+	{
+		return;
 	}
 
-	// Rotation
-	if(channel.m_rotations.getSize() > 1)
+	time -= m_startTime;
+	if(m_repeat && time > m_duration)
 	{
-		auto next = channel.m_rotations.begin();
+		time = mod(time, m_duration);
+	}
+
+	const F32 f = clamp(time / m_duration, 0.0f, 1.0f) * F32(m_sampleCount - 1);
+	key = min<U32>(U32(f), m_sampleCount - 2);
+	u = f - F32(key);
+}
 
-		do
+/// Normalized linear interpolation of two quaternions. It takes the short path.
+static Quat nlerp(const Quat& a, const Quat& b, F32 u)
+{
+#if ANKI_SIMD == ANKI_SIMD_SSE
+	const __m128 va = a.getSimd();
+	__m128 vb = b.getSimd();
+
+	// Flip b if it's on the other side of the sphere
+	const __m128 dot = _mm_dp_ps(va, vb, 0xFF);
+	vb = _mm_xor_ps(vb, _mm_and_ps(dot, _mm_set1_ps(-0.0f)));
+
+	const __m128 r = _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), _mm_set1_ps(u)));
+	return Quat(_mm_div_ps(r, _mm_sqrt_ps(_mm_dp_ps(r, r, 0xFF))));
+#else
+	const Quat bb = (a.dot(b) < 0.0) ? b * -1.0 : b;
+	return (a + (bb - a) * u).getNormalized();
+#endif
+}
+
+/// Dequantize and interpolate a key of 3 components.
+static Vec4 sampleVector(const AnimationTrack& track, const U16* key, F32 u)
+{
+#if ANKI_SIMD == ANKI_SIMD_SSE
+	__m128 q = _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(key))));
+
+	if(track.m_keyCount > 1)
+	{
+		const __m128 next =
+			_mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(key + 3))));
+		q = _mm_add_ps(q, _mm_mul_ps(_mm_sub_ps(next, q), _mm_set1_ps(u)));
+	}
+
+	// The W of the scale is zero so the 4th key that was loaded doesn't matter
+	return Vec4(_mm_add_ps(track.m_min.getSimd(), _mm_mul_ps(q, track.m_scale.getSimd())));
+#else
+	Vec4 q(key[0], key[1], key[2], 0.0);
+
+	if(track.m_keyCount > 1)
+	{
+		q = linearInterpolate(q, Vec4(key[3], key[4], key[5], 0.0), u);
+	}
+
+	return track.m_min + q * track.m_scale;
+#endif
+}
+
+void Animation::sampleChannel(const AnimationChannel& ch, U32 key, F32 u, Vec4& pos, Quat& rot, F32& scale) const
+{
+	if(ch.m_positions.m_keyCount)
+	{
+		const U32 k = (ch.m_positions.m_keyCount > 1) ? key : 0;
+		pos = sampleVector(ch.m_positions, &m_keys[ch.m_positions.m_offset + k * 3], u);
+	}
+
+	if(ch.m_rotations.m_keyCount)
+	{
+		const U16* k = &m_keys[ch.m_rotations.m_offset];
+		if(ch.m_rotations.m_keyCount > 1)
+		{
+			k += key * 3;
+			rot = nlerp(dequantizeRotation(k), dequantizeRotation(k + 3), u);
+		}
+		else
+		{
+			rot = dequantizeRotation(k);
+		}
+	}
+
+	if(ch.m_scales.m_keyCount)
+	{
+		const U16* k = &m_keys[ch.m_scales.m_offset];
+		F32 q = k[0];
+		if(ch.m_scales.m_keyCount > 1)
 		{
-		} while((next->m_time < time) && (++next != channel.m_rotations.end()));
+			q = linearInterpolate<F32>(k[key], k[key + 1], u);
+		}
+
+		scale = ch.m_scales.m_min.x() + q * ch.m_scales.m_scale.x();
+	}
+}
+
+void Animation::interpolate(U channelIndex, F32 time, Vec3& position, Quat& rotation, F32& scale) const
+{
+	ANKI_ASSERT(channelIndex < m_channels.getSize());
 
-		ANKI_ASSERT(next != channel.m_rotations.end());
-		auto prev = next - 1;
+	U32 key;
+	F32 u;
+	computeKey(time, key, u);
 
-		F32 u = (time - prev->m_time) / (next->m_time - prev->m_time);
-		rot = prev->m_value.slerp(next->m_value, u);
+	Vec4 pos(position, 0.0);
+	sampleChannel(m_channels[channelIndex], key, u, pos, rotation, scale);
+	position = pos.xyz();
+}
+
+void Animation::sample(F32 time, Vec4* positions, Quat* rotations, F32* scales) const
+{
+	ANKI_ASSERT(positions && rotations && scales);
+
+	U32 key;
+	F32 u;
+	computeKey(time, key, u);
+
+	for(U32 i = 0; i < m_channels.getSize(); ++i)
+	{
+		sampleChannel(m_channels[i], key, u, positions[i], rotations[i], scales[i]);
 	}
 }
 
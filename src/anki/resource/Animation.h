@@ -14,30 +14,19 @@ namespace anki
 
 // Forward
 class XmlElement;
+class BinaryReader;
 
 /// @addtogroup resource
 /// @{
 
-/// A keyframe
-template<typename T>
-class Key
+/// A quantized track of an animation channel. The keys are resampled at the sample rate of the animation.
+class AnimationTrack
 {
-	friend class Animation;
-
 public:
-	F32 getTime() const
-	{
-		return m_time;
-	}
-
-	const T& getValue() const
-	{
-		return m_value;
-	}
-
-private:
-	F32 m_time;
-	T m_value;
+	Vec4 m_min = Vec4(0.0); ///< The dequantized value is m_min + key * m_scale. Not used by the rotations.
+	Vec4 m_scale = Vec4(0.0);
+	U32 m_offset = 0; ///< The offset of the first key in the key memory of the animation.
+	U32 m_keyCount = 0; ///< 0 if the channel doesn't have the track, 1 if it's constant or the sample count.
 };
 
 /// Animation channel
@@ -48,25 +37,44 @@ public:
 
 	I32 m_boneIndex = -1; ///< For skeletal animations
 
-	DynamicArray<Key<Vec3>> m_positions;
-	DynamicArray<Key<Quat>> m_rotations;
-	DynamicArray<Key<F32>> m_scales;
-	DynamicArray<Key<F32>> m_cameraFovs;
+	AnimationTrack m_positions; ///< 3 U16 per key.
+	AnimationTrack m_rotations; ///< 3 U16 per key. Smallest three.
+	AnimationTrack m_scales; ///< 1 U16 per key.
 
 	void destroy(ResourceAllocator<U8> alloc)
 	{
 		m_name.destroy(alloc);
-		m_positions.destroy(alloc);
-		m_rotations.destroy(alloc);
-		m_scales.destroy(alloc);
-		m_cameraFovs.destroy(alloc);
 	}
 };
 
 /// Animation consists of keyframe data.
+///
+/// XML file format:
+/// @code
+/// <animation>
+/// 	[<repeat>0 or 1</repeat>]
+/// 	[<sampleRate>30</sampleRate>]
+/// 	<channels>
+/// 		<channel>
+/// 			<name>X</name>
+/// 			[<positionKeys><key><time>T</time><value>X Y Z</value></key>...</positionKeys>]
+/// 			[<rotationKeys><key><time>T</time><value>X Y Z W</value></key>...</rotationKeys>]
+/// 			[<scalingKeys><key><time>T</time><value>S</value></key>...</scalingKeys>]
+/// 		</channel>
+/// 		...
+/// 	</channels>
+/// </animation>
+/// @endcode
+///
+/// The keys are resampled at the sample rate when the animation is compiled so finding them is a division. The
+/// rotations are quantized to 48 bits (smallest three) and the positions and scales to 16 bits per component in the
+/// range of their channel.
 class Animation : public ResourceObject
 {
 public:
+	/// The sample rate of the animations that don't set one.
+	static const U32 DEFAULT_SAMPLE_RATE = 30;
+
 	Animation(ResourceManager* manager);
 
 	~Animation();
@@ -97,14 +105,42 @@ public:
 		return m_repeat;
 	}
 
-	/// Get the interpolated data
+	/// The number of keys of the tracks that are not constant.
+	U32 getSampleCount() const
+	{
+		return m_sampleCount;
+	}
+
+	/// Get the interpolated data. The values of the channel that don't have keys are left untouched. Outside the keys
+	/// the first or the last key is used.
 	void interpolate(U channelIndex, F32 time, Vec3& position, Quat& rotation, F32& scale) const;
 
+	/// Same as interpolate() for all the channels at once.
+	/// @param time The time.
+	/// @param[in,out] positions One per channel.
+	/// @param[in,out] rotations One per channel.
+	/// @param[in,out] scales One per channel.
+	void sample(F32 time, Vec4* positions, Quat* rotations, F32* scales) const;
+
 private:
+	/// Bump it when the compiled form changes.
+	static const U32 COMPILED_VERSION = 2;
+
 	DynamicArray<AnimationChannel> m_channels;
+	DynamicArray<U16> m_keys; ///< The keys of all the tracks.
 	F32 m_duration;
 	F32 m_startTime;
+	U32 m_sampleCount;
 	Bool8 m_repeat;
+
+	static ANKI_USE_RESULT Error compileXml(const XmlDocument& xml, BinaryWriter& out, void* userData);
+
+	ANKI_USE_RESULT Error readTrack(BinaryReader& in, AnimationTrack& track);
+
+	/// Find the key before the time and the interpolation factor to the next.
+	void computeKey(F32 time, U32& key, F32& u) const;
+
+	void sampleChannel(const AnimationChannel& channel, U32 key, F32 u, Vec4& pos, Quat& rot, F32& scale) const;
 };
 /// @}
 
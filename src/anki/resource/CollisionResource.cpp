@@ -52,8 +52,8 @@ Error CollisionResource::load(const ResourceFilename& filename)
 		ANKI_CHECK(loader.load(meshfname));
 
 		m_physicsShape = physics.newInstance<PhysicsTriangleSoup>(csInit,
-			reinterpret_cast<const Vec3*>(loader.getVertexData()),
-			loader.getVertexSize(),
+			loader.getPositions(),
+			sizeof(Vec3),
 			reinterpret_cast<const U16*>(loader.getIndexData()),
 			loader.getHeader().m_totalIndicesCount);
 	}
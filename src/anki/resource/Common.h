@@ -43,9 +43,7 @@ class ResourcePtrDeleter
 public:
 	void operator()(T* ptr)
 	{
-		ptr->getManager().unregisterResource(ptr);
-		auto alloc = ptr->getAllocator();
-		alloc.deleteInstance(ptr);
+		ptr->getManager().releaseResource(ptr);
 	}
 };
 
@@ -0,0 +1,200 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/resource/CompiledResourceCache.h>
+#include <anki/util/File.h>
+#include <anki/util/Filesystem.h>
+#include <anki/util/Hash.h>
+#include <anki/util/Logger.h>
+
+namespace anki
+{
+
+static const U32 ENGINE_VERSION = (ANKI_VERSION_MAJOR << 16) | ANKI_VERSION_MINOR;
+
+void BinaryWriter::writeBytes(const void* data, PtrSize size)
+{
+	ANKI_ASSERT(data && size > 0);
+
+	if(m_size + size > m_data.getSize())
+	{
+		// Grow it
+		const PtrSize newCapacity = max<PtrSize>(m_size + size, max<PtrSize>(m_data.getSize() * 2, 256));
+		DynamicArrayAuto<U8> newData(m_alloc);
+		newData.create(newCapacity);
+		if(m_size > 0)
+		{
+			memcpy(&newData[0], &m_data[0], m_size);
+		}
+
+		m_data = std::move(newData);
+	}
+
+	memcpy(&m_data[m_size], data, size);
+	m_size += size;
+}
+
+void BinaryWriter::writeString(CString str)
+{
+	const U32 length = (str.isEmpty()) ? 0 : str.getLength();
+	write(length);
+	writeBytes((length > 0) ? &str[0] : "", length + 1);
+}
+
+Error BinaryReader::checkSize(PtrSize size) const
+{
+	if(m_offset + size > m_size)
+	{
+		ANKI_LOGE("The compiled resource is truncated");
+		return ErrorCode::USER_DATA;
+	}
+
+	return ErrorCode::NONE;
+}
+
+Error BinaryReader::readBytes(void* data, PtrSize size)
+{
+	ANKI_CHECK(checkSize(size));
+	memcpy(data, m_data + m_offset, size);
+	m_offset += size;
+	return ErrorCode::NONE;
+}
+
+Error BinaryReader::readString(CString& str)
+{
+	U32 length;
+	ANKI_CHECK(read(length));
+	ANKI_CHECK(checkSize(length + 1));
+
+	const char* chars = reinterpret_cast<const char*>(m_data + m_offset);
+	if(chars[length] != '\0')
+	{
+		ANKI_LOGE("The compiled resource has a wrong string");
+		return ErrorCode::USER_DATA;
+	}
+
+	str = CString(chars);
+	m_offset += length + 1;
+	return ErrorCode::NONE;
+}
+
+/// The header of the cache files.
+class CompiledResourceCache::Header
+{
+public:
+	Array<U8, 8> m_magic;
+	U32 m_engineVersion;
+	U32 m_version;
+	U64 m_sourceHash;
+	U64 m_dataSize;
+	U64 m_dataHash; ///< Catches the broken files.
+};
+
+static const char* MAGIC = "ANKIBIN1";
+
+CompiledResourceCache::~CompiledResourceCache()
+{
+	m_cacheDir.destroy(m_alloc);
+}
+
+void CompiledResourceCache::init(ResourceAllocator<U8> alloc, CString cacheDir, Bool enabled)
+{
+	m_alloc = alloc;
+	m_cacheDir.create(m_alloc, cacheDir);
+	m_enabled = enabled;
+}
+
+void CompiledResourceCache::createCacheFilename(CString filename, StringAuto& out) const
+{
+	const U64 hash = computeHash(&filename[0], filename.getLength());
+	out.sprintf("%s/res_%llu.ankibin", &m_cacheDir[0], hash);
+}
+
+Error CompiledResourceCache::find(
+	CString filename, U32 version, U64 sourceHash, DynamicArrayAuto<U8>& data, Bool& found)
+{
+	found = false;
+	if(!m_enabled)
+	{
+		return ErrorCode::NONE;
+	}
+
+	StringAuto fname(m_alloc);
+	createCacheFilename(filename, fname);
+
+	if(!fileExists(fname.toCString()))
+	{
+		++m_stats.m_misses;
+		return ErrorCode::NONE;
+	}
+
+	File file;
+	ANKI_CHECK(file.open(fname.toCString(), FileOpenFlag::READ | FileOpenFlag::BINARY));
+
+	// Validate the header. An old or broken file is not an error, the resource will be compiled again
+	Header header;
+	if(file.getSize() < sizeof(header))
+	{
+		++m_stats.m_misses;
+		return ErrorCode::NONE;
+	}
+
+	ANKI_CHECK(file.read(&header, sizeof(header)));
+	if(memcmp(&header.m_magic[0], MAGIC, sizeof(header.m_magic)) != 0 || header.m_engineVersion != ENGINE_VERSION
+		|| header.m_version != version
+		|| header.m_sourceHash != sourceHash
+		|| header.m_dataSize != file.getSize() - sizeof(header)
+		|| header.m_dataSize == 0)
+	{
+		++m_stats.m_misses;
+		return ErrorCode::NONE;
+	}
+
+	// Read the compiled form
+	data.create(header.m_dataSize);
+	ANKI_CHECK(file.read(&data[0], header.m_dataSize));
+
+	if(computeHash(&data[0], header.m_dataSize) != header.m_dataHash)
+	{
+		ANKI_LOGW("Compiled resource is broken and it will be compiled again: %s", &filename[0]);
+		data.destroy();
+		++m_stats.m_misses;
+		return ErrorCode::NONE;
+	}
+
+	found = true;
+	++m_stats.m_hits;
+	return ErrorCode::NONE;
+}
+
+Error CompiledResourceCache::store(CString filename, U32 version, U64 sourceHash, const U8* data, PtrSize size)
+{
+	ANKI_ASSERT(data && size > 0);
+	if(!m_enabled)
+	{
+		return ErrorCode::NONE;
+	}
+
+	StringAuto fname(m_alloc);
+	createCacheFilename(filename, fname);
+
+	Header header;
+	memcpy(&header.m_magic[0], MAGIC, sizeof(header.m_magic));
+	header.m_engineVersion = ENGINE_VERSION;
+	header.m_version = version;
+	header.m_sourceHash = sourceHash;
+	header.m_dataSize = size;
+	header.m_dataHash = computeHash(data, size);
+
+	File file;
+	ANKI_CHECK(file.open(fname.toCString(), FileOpenFlag::WRITE | FileOpenFlag::BINARY));
+	ANKI_CHECK(file.write(&header, sizeof(header)));
+	ANKI_CHECK(file.write(const_cast<U8*>(data), size));
+
+	++m_stats.m_stores;
+	return ErrorCode::NONE;
+}
+
+} // end namespace anki
@@ -0,0 +1,178 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/resource/Common.h>
+#include <anki/util/DynamicArray.h>
+#include <anki/util/String.h>
+#include <cstring>
+
+namespace anki
+{
+
+/// @addtogroup resource
+/// @{
+
+/// Writes the compiled form of a resource. The values are written in the native endianness and layout. The cache
+/// files are not meant to be shared between platforms.
+class BinaryWriter : public NonCopyable
+{
+public:
+	BinaryWriter(GenericMemoryPoolAllocator<U8> alloc)
+		: m_alloc(alloc)
+		, m_data(alloc)
+	{
+	}
+
+	/// Write a POD value.
+	template<typename T>
+	void write(const T& x)
+	{
+		writeBytes(&x, sizeof(T));
+	}
+
+	void writeBytes(const void* data, PtrSize size);
+
+	/// Write an array of PODs. It writes the count first.
+	template<typename T>
+	void writeArray(const DynamicArray<T>& arr)
+	{
+		write<U32>(arr.getSize());
+		if(arr.getSize() > 0)
+		{
+			writeBytes(&arr[0], arr.getSizeInBytes());
+		}
+	}
+
+	/// Write a string. It writes the length first and it keeps the terminator so it can be read without copies.
+	void writeString(CString str);
+
+	void writeString(const String& str)
+	{
+		writeString((str.isEmpty()) ? CString() : str.toCString());
+	}
+
+	const U8* getData() const
+	{
+		return (m_size) ? &m_data[0] : nullptr;
+	}
+
+	PtrSize getSize() const
+	{
+		return m_size;
+	}
+
+private:
+	GenericMemoryPoolAllocator<U8> m_alloc;
+	DynamicArrayAuto<U8> m_data;
+	PtrSize m_size = 0;
+};
+
+/// Reads what BinaryWriter wrote. All the reads check the bounds.
+class BinaryReader
+{
+public:
+	BinaryReader(const U8* data, PtrSize size)
+		: m_data(data)
+		, m_size(size)
+	{
+	}
+
+	/// Read a POD value.
+	template<typename T>
+	ANKI_USE_RESULT Error read(T& x)
+	{
+		return readBytes(&x, sizeof(T));
+	}
+
+	ANKI_USE_RESULT Error readBytes(void* data, PtrSize size);
+
+	/// Read an array of PODs.
+	template<typename T, typename TAllocator>
+	ANKI_USE_RESULT Error readArray(TAllocator alloc, DynamicArray<T>& arr)
+	{
+		U32 count;
+		ANKI_CHECK(read(count));
+		if(count > 0)
+		{
+			ANKI_CHECK(checkSize(count * sizeof(T)));
+			arr.create(alloc, count);
+			ANKI_CHECK(readBytes(&arr[0], arr.getSizeInBytes()));
+		}
+		return ErrorCode::NONE;
+	}
+
+	/// Read a string. The result points to the data so it lives as long as the data.
+	ANKI_USE_RESULT Error readString(CString& str);
+
+	/// All the data was read.
+	Bool isEnd() const
+	{
+		return m_offset == m_size;
+	}
+
+private:
+	const U8* m_data;
+	PtrSize m_size;
+	PtrSize m_offset = 0;
+
+	ANKI_USE_RESULT Error checkSize(PtrSize size) const;
+};
+
+class CompiledResourceCacheStats
+{
+public:
+	U32 m_hits = 0;
+	U32 m_misses = 0; ///< Missing, old or invalid cache files.
+	U32 m_stores = 0;
+};
+
+/// Keeps the compiled form of the resources that are described in XML. The compiled forms are stored in the cache
+/// directory, one file per resource. A cache file is used only if it was written by the same engine version, with the
+/// same version of the compiled form and from the same source file.
+///
+/// It's not thread-safe. Neither is the resource loading.
+class CompiledResourceCache : public NonCopyable
+{
+public:
+	CompiledResourceCache() = default;
+
+	~CompiledResourceCache();
+
+	/// @param alloc The allocator.
+	/// @param cacheDir The directory to store the compiled resources.
+	/// @param enabled If it's false the find() never finds anything and store() does nothing.
+	void init(ResourceAllocator<U8> alloc, CString cacheDir, Bool enabled);
+
+	/// Find the compiled form of a resource.
+	/// @param filename The resource file.
+	/// @param version The version of the compiled form of this resource type. Bump it when the form changes.
+	/// @param sourceHash The hash of the contents of the resource file.
+	/// @param[out] data The compiled form.
+	/// @param[out] found True if it was found.
+	ANKI_USE_RESULT Error find(CString filename, U32 version, U64 sourceHash, DynamicArrayAuto<U8>& data, Bool& found);
+
+	/// Store the compiled form of a resource. The parameters are the same as find().
+	ANKI_USE_RESULT Error store(CString filename, U32 version, U64 sourceHash, const U8* data, PtrSize size);
+
+	void getStats(CompiledResourceCacheStats& stats) const
+	{
+		stats = m_stats;
+	}
+
+private:
+	class Header;
+
+	ResourceAllocator<U8> m_alloc;
+	String m_cacheDir;
+	Bool8 m_enabled = false;
+	CompiledResourceCacheStats m_stats;
+
+	void createCacheFilename(CString filename, StringAuto& out) const;
+};
+/// @}
+
+} // end namespace anki
@@ -36,6 +36,7 @@ public:
 		if(filename.find("error") == ResourceFilename::NPOS)
 		{
 			m_memory = getAllocator().allocate(128);
+			setMemorySize(128);
 			void* tempMem = getTempAllocator().allocate(128);
 			(void)tempMem;
 
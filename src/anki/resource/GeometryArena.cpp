@@ -0,0 +1,228 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/resource/GeometryArena.h>
+#include <anki/Gr.h>
+
+namespace anki
+{
+
+static const Array<BufferUsageBit, U(GeometryArenaBuffer::COUNT)> BUFFER_USAGES = {
+	{BufferUsageBit::VERTEX, BufferUsageBit::INDEX}};
+
+GeometryArena::~GeometryArena()
+{
+	for(DeferredFree& f : m_frees)
+	{
+		m_allocators[f.m_buffer].free(f.m_handle);
+	}
+
+	for(Upload& upload : m_uploads)
+	{
+		upload.m_data.destroy(m_alloc);
+	}
+
+	m_frees.destroy(m_alloc);
+	m_uploads.destroy(m_alloc);
+	m_fills.destroy(m_alloc);
+}
+
+void GeometryArena::init(ResourceAllocator<U8> alloc, GrManager* gr, PtrSize vertexMemorySize, PtrSize indexMemorySize)
+{
+	ANKI_ASSERT(gr);
+	m_alloc = alloc;
+	m_gr = gr;
+
+	const Array<PtrSize, U(GeometryArenaBuffer::COUNT)> sizes = {{vertexMemorySize, indexMemorySize}};
+	for(U i = 0; i < U(GeometryArenaBuffer::COUNT); ++i)
+	{
+		m_buffers[i] = gr->newInstance<Buffer>(sizes[i],
+			BUFFER_USAGES[i] | BufferUsageBit::BUFFER_UPLOAD_DESTINATION | BufferUsageBit::FILL,
+			BufferMapAccessBit::NONE);
+
+		m_allocators[i].init(alloc, sizes[i]);
+	}
+}
+
+Error GeometryArena::allocate(GeometryArenaBuffer buffer, PtrSize size, U32 alignment, GeometryArenaAllocation& out)
+{
+	ANKI_ASSERT(!out);
+	LockGuard<Mutex> lock(m_mtx);
+
+	if(m_allocators[buffer].allocate(size, alignment, out.m_handle))
+	{
+		TlsfGpuAllocatorStats stats;
+		m_allocators[buffer].getStats(stats);
+		ANKI_LOGE("Out of geometry memory. Requested %u bytes, the largest free block is %u bytes",
+			U32(size),
+			U32(stats.m_largestFreeSize));
+		return ErrorCode::OUT_OF_MEMORY;
+	}
+
+	out.m_size = size;
+	out.m_buffer = buffer;
+
+	// The memory might have the data of an older allocation
+	Fill fill;
+	fill.m_offset = out.getOffset();
+	fill.m_size = getAlignedRoundUp(TlsfGpuAllocator::GRANULARITY, size);
+	fill.m_buffer = buffer;
+	m_fills.pushBack(m_alloc, fill);
+
+	return ErrorCode::NONE;
+}
+
+Error GeometryArena::allocateVertices(U32 vertexCount, U32 vertexSize, GeometryArenaAllocation& out)
+{
+	ANKI_ASSERT(vertexCount > 0 && vertexSize > 0);
+	return allocate(GeometryArenaBuffer::VERTEX, PtrSize(vertexCount) * vertexSize, vertexSize, out);
+}
+
+Error GeometryArena::allocateIndices(U32 indexCount, GeometryArenaAllocation& out)
+{
+	ANKI_ASSERT(indexCount > 0);
+	return allocate(
+		GeometryArenaBuffer::INDEX, PtrSize(indexCount) * sizeof(U16), TlsfGpuAllocator::GRANULARITY, out);
+}
+
+void GeometryArena::free(GeometryArenaAllocation& allocation)
+{
+	ANKI_ASSERT(allocation);
+	LockGuard<Mutex> lock(m_mtx);
+
+	// The uploads that didn't make it are useless now
+	auto it = m_uploads.getBegin();
+	while(it != m_uploads.getEnd())
+	{
+		auto next = it;
+		++next;
+
+		if(it->m_buffer == allocation.m_buffer && it->m_offset == allocation.getOffset())
+		{
+			it->m_data.destroy(m_alloc);
+			m_uploads.erase(m_alloc, it);
+		}
+
+		it = next;
+	}
+
+	DeferredFree f;
+	f.m_handle = allocation.m_handle;
+	f.m_buffer = allocation.m_buffer;
+	f.m_frame = m_frame;
+	m_frees.pushBack(m_alloc, f);
+
+	allocation = GeometryArenaAllocation();
+}
+
+Bool GeometryArena::stage(Upload& upload, const void* data)
+{
+	void* mem =
+		m_gr->tryAllocateFrameTransientMemory(upload.m_size, BufferUsageBit::BUFFER_UPLOAD_SOURCE, upload.m_token);
+	if(mem)
+	{
+		memcpy(mem, data, upload.m_size);
+	}
+
+	return mem != nullptr;
+}
+
+void GeometryArena::upload(const GeometryArenaAllocation& allocation, const void* data, PtrSize size)
+{
+	ANKI_ASSERT(allocation && data);
+	ANKI_ASSERT(size > 0 && size <= allocation.getSize());
+	LockGuard<Mutex> lock(m_mtx);
+
+	m_uploads.emplaceBack(m_alloc);
+	Upload& upload = m_uploads.getBack();
+	upload.m_offset = allocation.getOffset();
+	upload.m_size = size;
+	upload.m_buffer = allocation.m_buffer;
+
+	if(!stage(upload, data))
+	{
+		// Try again on flush
+		upload.m_data.create(m_alloc, size);
+		memcpy(&upload.m_data[0], data, size);
+	}
+}
+
+void GeometryArena::flushUploads()
+{
+	LockGuard<Mutex> lock(m_mtx);
+	++m_frame;
+
+	// Release the memory that the GPU doesn't read any more
+	while(!m_frees.isEmpty() && m_frees.getFront().m_frame + MAX_FRAMES_IN_FLIGHT <= m_frame)
+	{
+		DeferredFree& f = m_frees.getFront();
+		m_allocators[f.m_buffer].free(f.m_handle);
+		m_frees.popFront(m_alloc);
+	}
+
+	// Stage the uploads that didn't find staging memory before
+	Bool uploadsReady = false;
+	for(Upload& upload : m_uploads)
+	{
+		if(upload.m_data.getSize() > 0 && stage(upload, &upload.m_data[0]))
+		{
+			upload.m_data.destroy(m_alloc);
+		}
+
+		uploadsReady = uploadsReady || upload.m_data.getSize() == 0;
+	}
+
+	if(m_fills.isEmpty() && !uploadsReady)
+	{
+		return;
+	}
+
+	// Record everything in one command buffer. The clears go first since they are for new allocations
+	CommandBufferInitInfo cmdbinit;
+	cmdbinit.m_flags = CommandBufferFlag::SMALL_BATCH;
+	CommandBufferPtr cmdb = m_gr->newInstance<CommandBuffer>(cmdbinit);
+
+	const BufferUsageBit transferUsage = BufferUsageBit::FILL | BufferUsageBit::BUFFER_UPLOAD_DESTINATION;
+	for(U i = 0; i < U(GeometryArenaBuffer::COUNT); ++i)
+	{
+		cmdb->setBufferBarrier(m_buffers[i], BUFFER_USAGES[i], transferUsage, 0, MAX_PTR_SIZE);
+	}
+
+	for(const Fill& fill : m_fills)
+	{
+		cmdb->fillBuffer(m_buffers[fill.m_buffer], fill.m_offset, fill.m_size, 0);
+	}
+	m_fills.destroy(m_alloc);
+
+	for(U i = 0; i < U(GeometryArenaBuffer::COUNT); ++i)
+	{
+		cmdb->setBufferBarrier(
+			m_buffers[i], BufferUsageBit::FILL, BufferUsageBit::BUFFER_UPLOAD_DESTINATION, 0, MAX_PTR_SIZE);
+	}
+
+	auto it = m_uploads.getBegin();
+	while(it != m_uploads.getEnd())
+	{
+		auto next = it;
+		++next;
+
+		if(it->m_data.getSize() == 0)
+		{
+			cmdb->uploadBuffer(m_buffers[it->m_buffer], it->m_offset, it->m_token);
+			m_uploads.erase(m_alloc, it);
+		}
+
+		it = next;
+	}
+
+	for(U i = 0; i < U(GeometryArenaBuffer::COUNT); ++i)
+	{
+		cmdb->setBufferBarrier(m_buffers[i], transferUsage, BUFFER_USAGES[i], 0, MAX_PTR_SIZE);
+	}
+
+	cmdb->flush();
+}
+
+} // end namespace anki
@@ -0,0 +1,148 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/resource/Common.h>
+#include <anki/gr/common/TlsfGpuAllocator.h>
+#include <anki/Gr.h>
+#include <anki/util/List.h>
+
+namespace anki
+{
+
+/// @addtogroup resource
+/// @{
+
+/// The buffers of the GeometryArena.
+enum class GeometryArenaBuffer : U8
+{
+	VERTEX,
+	INDEX,
+	COUNT
+};
+
+/// A range of a buffer of the GeometryArena.
+class GeometryArenaAllocation
+{
+	friend class GeometryArena;
+
+public:
+	PtrSize getOffset() const
+	{
+		return m_handle.m_offset;
+	}
+
+	PtrSize getSize() const
+	{
+		return m_size;
+	}
+
+	operator Bool() const
+	{
+		return m_handle;
+	}
+
+private:
+	TlsfGpuAllocatorHandle m_handle;
+	PtrSize m_size = 0;
+	GeometryArenaBuffer m_buffer = GeometryArenaBuffer::VERTEX;
+};
+
+/// The vertices and the indices of all the meshes live in two large buffers. That saves the GPU allocations, the
+/// meshes with the same vertex format can share a resource group and their drawcalls can be merged using the base
+/// vertex and the first index.
+///
+/// The uploads and the clears are gathered and flushUploads() records them in a single command buffer. The memory of
+/// a free is reused after MAX_FRAMES_IN_FLIGHT flushes since the GPU might still read it.
+class GeometryArena : public NonCopyable
+{
+public:
+	GeometryArena() = default;
+
+	~GeometryArena();
+
+	/// @param alloc The allocator.
+	/// @param gr The GrManager.
+	/// @param vertexMemorySize The size of the vertex buffer.
+	/// @param indexMemorySize The size of the index buffer.
+	void init(ResourceAllocator<U8> alloc, GrManager* gr, PtrSize vertexMemorySize, PtrSize indexMemorySize);
+
+	/// Allocate vertices. The offset is a multiple of the vertex size so it can be used as a base vertex. The memory
+	/// will be cleared with the next flush. It's thread-safe.
+	ANKI_USE_RESULT Error allocateVertices(U32 vertexCount, U32 vertexSize, GeometryArenaAllocation& out);
+
+	/// Allocate 16bit indices. The memory will be cleared with the next flush. It's thread-safe.
+	ANKI_USE_RESULT Error allocateIndices(U32 indexCount, GeometryArenaAllocation& out);
+
+	/// Free an allocation and drop its pending uploads. It's thread-safe.
+	void free(GeometryArenaAllocation& allocation);
+
+	/// Copy data to an allocation. The data are copied to staging memory or kept until there is staging memory
+	/// available so they can go away after the call. It's thread-safe.
+	void upload(const GeometryArenaAllocation& allocation, const void* data, PtrSize size);
+
+	/// Record the pending clears and uploads to the GPU. Call it once per frame before rendering.
+	void flushUploads();
+
+	BufferPtr getBuffer(GeometryArenaBuffer buffer) const
+	{
+		return m_buffers[buffer];
+	}
+
+	void getStats(GeometryArenaBuffer buffer, TlsfGpuAllocatorStats& stats) const
+	{
+		LockGuard<Mutex> lock(m_mtx);
+		m_allocators[buffer].getStats(stats);
+	}
+
+private:
+	class Fill
+	{
+	public:
+		PtrSize m_offset;
+		PtrSize m_size;
+		GeometryArenaBuffer m_buffer;
+	};
+
+	class Upload
+	{
+	public:
+		PtrSize m_offset = 0;
+		PtrSize m_size = 0;
+		GeometryArenaBuffer m_buffer = GeometryArenaBuffer::VERTEX;
+		TransientMemoryToken m_token;
+		DynamicArray<U8> m_data; ///< The data that didn't find staging memory.
+	};
+
+	class DeferredFree
+	{
+	public:
+		TlsfGpuAllocatorHandle m_handle;
+		GeometryArenaBuffer m_buffer;
+		U64 m_frame;
+	};
+
+	ResourceAllocator<U8> m_alloc;
+	GrManager* m_gr = nullptr;
+
+	Array<BufferPtr, U(GeometryArenaBuffer::COUNT)> m_buffers;
+	Array<TlsfGpuAllocator, U(GeometryArenaBuffer::COUNT)> m_allocators;
+
+	mutable Mutex m_mtx;
+	List<Fill> m_fills;
+	List<Upload> m_uploads;
+	List<DeferredFree> m_frees;
+	U64 m_frame = 0; ///< The flush count.
+
+	ANKI_USE_RESULT Error allocate(
+		GeometryArenaBuffer buffer, PtrSize size, U32 alignment, GeometryArenaAllocation& out);
+
+	/// Try to copy the data of an upload to staging memory.
+	Bool stage(Upload& upload, const void* data);
+};
+/// @}
+
+} // end namespace anki
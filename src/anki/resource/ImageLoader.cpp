@@ -317,6 +317,7 @@ static ANKI_USE_RESULT Error loadAnkiTexture(ResourceFilePtr file,
 	U32& depth,
 	U32& layerCount,
 	U8& toLoadMipCount,
+	U8& firstMip,
 	ImageLoader::TextureType& textureType,
 	ImageLoader::ColorFormat& colorFormat)
 {
@@ -378,9 +379,6 @@ static ANKI_USE_RESULT Error loadAnkiTexture(ResourceFilePtr file,
 		return ErrorCode::USER_DATA;
 	}
 
-	width = header.m_width;
-	height = header.m_height;
-
 	// Check mip levels
 	U size = min(header.m_width, header.m_height);
 	U maxSize = max(header.m_width, header.m_height);
@@ -389,19 +387,11 @@ static ANKI_USE_RESULT Error loadAnkiTexture(ResourceFilePtr file,
 		maxSize = max<U>(maxSize, header.m_depthOrLayerCount);
 		size = min<U>(size, header.m_depthOrLayerCount);
 	}
-	toLoadMipCount = 0;
 	U tmpMipLevels = 0;
 	while(size >= 4) // The minimum size is 4x4
 	{
 		++tmpMipLevels;
-
-		if(maxSize <= maxTextureSize)
-		{
-			++toLoadMipCount;
-		}
-
 		size /= 2;
-		maxSize /= 2;
 	}
 
 	if(header.m_mipLevels > tmpMipLevels)
@@ -410,7 +400,16 @@ static ANKI_USE_RESULT Error loadAnkiTexture(ResourceFilePtr file,
 		return ErrorCode::USER_DATA;
 	}
 
-	toLoadMipCount = min<U>(toLoadMipCount, header.m_mipLevels);
+	// Skip the mips that are bigger than the max size. Keep at least the smallest
+	firstMip = 0;
+	while(firstMip + 1u < header.m_mipLevels && (maxSize >> firstMip) > maxTextureSize)
+	{
+		++firstMip;
+	}
+	toLoadMipCount = header.m_mipLevels - firstMip;
+
+	width = header.m_width >> firstMip;
+	height = header.m_height >> firstMip;
 
 	colorFormat = header.m_colorFormat;
 
@@ -427,7 +426,7 @@ static ANKI_USE_RESULT Error loadAnkiTexture(ResourceFilePtr file,
 		faceCount = 6;
 		break;
 	case ImageLoader::TextureType::_3D:
-		depth = header.m_depthOrLayerCount;
+		depth = header.m_depthOrLayerCount >> firstMip;
 		layerCount = 1;
 		break;
 	case ImageLoader::TextureType::_2D_ARRAY:
@@ -497,7 +496,7 @@ static ANKI_USE_RESULT Error loadAnkiTexture(ResourceFilePtr file,
 					U dataSize = calcSurfaceSize(mipWidth, mipHeight, preferredCompression, header.m_colorFormat);
 
 					// Check if this mipmap can be skipped because of size
-					if(maxSize <= maxTextureSize)
+					if(mip >= firstMip)
 					{
 						ImageLoader::Surface& surf = surfaces[index++];
 						surf.m_width = mipWidth;
@@ -530,9 +529,9 @@ static ANKI_USE_RESULT Error loadAnkiTexture(ResourceFilePtr file,
 			U dataSize = calcVolumeSize(mipWidth, mipHeight, mipDepth, preferredCompression, header.m_colorFormat);
 
 			// Check if this mipmap can be skipped because of size
-			if(maxSize <= maxTextureSize)
+			if(mip >= firstMip)
 			{
-				ImageLoader::Volume& vol = volumes[mip];
+				ImageLoader::Volume& vol = volumes[mip - firstMip];
 				vol.m_width = mipWidth;
 				vol.m_height = mipHeight;
 				vol.m_depth = mipDepth;
@@ -577,6 +576,7 @@ Error ImageLoader::load(ResourceFilePtr file, const CString& filename, U32 maxTe
 		m_surfaces.create(m_alloc, 1);
 
 		m_mipLevels = 1;
+		m_firstMipLevel = 0;
 		m_depth = 1;
 		m_layerCount = 1;
 		ANKI_CHECK(loadTga(file, m_surfaces[0].m_width, m_surfaces[0].m_height, bpp, m_surfaces[0].m_data, m_alloc));
@@ -618,6 +618,7 @@ Error ImageLoader::load(ResourceFilePtr file, const CString& filename, U32 maxTe
 			m_depth,
 			m_layerCount,
 			m_mipLevels,
+			m_firstMipLevel,
 			m_textureType,
 			m_colorFormat));
 	}
@@ -664,6 +665,22 @@ const ImageLoader::Volume& ImageLoader::getVolume(U level) const
 	return m_volumes[level];
 }
 
+PtrSize ImageLoader::getDataSize() const
+{
+	PtrSize size = 0;
+	for(const Surface& surf : m_surfaces)
+	{
+		size += surf.m_data.getSize();
+	}
+
+	for(const Volume& vol : m_volumes)
+	{
+		size += vol.m_data.getSize();
+	}
+
+	return size;
+}
+
 void ImageLoader::destroy()
 {
 	for(Surface& surf : m_surfaces)
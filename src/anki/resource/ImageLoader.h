@@ -94,6 +94,14 @@ public:
 		return m_mipLevels;
 	}
 
+	/// The mips of the file that were skipped because of the maxTextureSize. The level 0 of the loader is that level
+	/// of the file.
+	U getFirstMipLevel() const
+	{
+		return m_firstMipLevel;
+	}
+
+	/// The width of the first loaded mip.
 	U getWidth() const
 	{
 		return m_width;
@@ -126,12 +134,18 @@ public:
 
 	const Volume& getVolume(U level) const;
 
+	/// Get the size of the data of all the surfaces or volumes.
+	PtrSize getDataSize() const;
+
 	GenericMemoryPoolAllocator<U8> getAllocator() const
 	{
 		return m_alloc;
 	}
 
 	/// Load an image file.
+	/// @param file The file.
+	/// @param filename The name of the file. Used for the extension.
+	/// @param maxTextureSize Skip the mips that are bigger than that. The smallest mip is always loaded.
 	ANKI_USE_RESULT Error load(ResourceFilePtr file, const CString& filename, U32 maxTextureSize = MAX_U32);
 
 	Atomic<I32>& getRefcount()
@@ -150,6 +164,7 @@ private:
 	DynamicArray<Volume> m_volumes;
 
 	U8 m_mipLevels = 0;
+	U8 m_firstMipLevel = 0;
 	U32 m_width = 0;
 	U32 m_height = 0;
 	U32 m_depth = 0;
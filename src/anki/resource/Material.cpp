@@ -5,6 +5,8 @@
 
 #include <anki/resource/Material.h>
 #include <anki/resource/MaterialLoader.h>
+#include <anki/resource/MaterialWarmList.h>
+#include <anki/resource/CompiledResourceCache.h>
 #include <anki/resource/ResourceManager.h>
 #include <anki/core/App.h>
 #include <anki/util/Logger.h>
@@ -46,6 +48,29 @@ Error UpdateTexturesVisitor::visit<MaterialVariableTemplate<TextureResourcePtr>>
 	return ErrorCode::NONE;
 }
 
+/// Visitor that sums the streaming versions of the textures.
+class TexturesVersionVisitor
+{
+public:
+	U32 m_version = 0;
+
+	template<typename TMaterialVariableTemplate>
+	Error visit(const TMaterialVariableTemplate& var)
+	{
+		// Do nothing
+		return ErrorCode::NONE;
+	}
+};
+
+// Specialize for texture
+template<>
+Error TexturesVersionVisitor::visit<MaterialVariableTemplate<TextureResourcePtr>>(
+	const MaterialVariableTemplate<TextureResourcePtr>& var)
+{
+	m_version += var.getValue()->getStreamingVersion();
+	return ErrorCode::NONE;
+}
+
 template<typename T>
 Error MaterialVariableTemplate<T>::init(U idx, const MaterialLoader::Input& in, Material& mtl)
 {
@@ -107,7 +132,7 @@ Error MaterialVariableTemplate<TextureResourcePtr>::init(U idx, const MaterialLo
 	{
 		ANKI_ASSERT(m_builtin == BuiltinMaterialVariableId::NONE);
 
-		ANKI_CHECK(mtl.getManager().loadResource(in.m_value.getBegin()->toCString(), m_value));
+		ANKI_CHECK(mtl.getManager().loadStreamedTexture(in.m_value.getBegin()->toCString(), m_value));
 	}
 	else
 	{
@@ -197,7 +222,7 @@ Error MaterialVariant::init(const RenderingKey& key2, Material& mtl, MaterialLoa
 		ANKI_CHECK(mtl.getManager().loadResource(filename.toCString(), shader));
 
 		// Update the hash
-		mtl.m_hash ^= computeHash(&src[0], src.getLength());
+		m_sourceHash ^= computeHash(&src[0], src.getLength());
 	}
 
 	return ErrorCode::NONE;
@@ -219,12 +244,30 @@ Material::~Material()
 {
 	auto alloc = getAllocator();
 
+	{
+		LockGuard<Mutex> lock(getManager()._getMaterialVariantMutex());
+		getManager()._removePendingMaterial(this);
+	}
+
+	// Remember what was drawn for the next run
+	MaterialWarmList& warmList = getManager()._getMaterialWarmList();
 	for(MaterialVariant& var : m_variants)
 	{
+		const U32 state = var.m_state.load();
+		if(state != MaterialVariant::NOT_BUILT && state != MaterialVariant::FAILED && !getFilename().isEmpty())
+		{
+			warmList.record(getFilename(), var.m_key);
+		}
+
 		var.destroy(alloc);
 	}
 	m_variants.destroy(alloc);
 
+	if(m_loader)
+	{
+		alloc.deleteInstance(m_loader);
+	}
+
 	for(MaterialVariable* var : m_vars)
 	{
 		var->destroy(alloc);
@@ -233,23 +276,62 @@ Material::~Material()
 	m_vars.destroy(alloc);
 }
 
-Error Material::load(const ResourceFilename& filename)
+Error Material::compileXml(const XmlDocument& doc, BinaryWriter& out, void* userData)
 {
-	XmlDocument doc;
-	ANKI_CHECK(openFileParseXml(filename, doc));
+	ANKI_ASSERT(userData);
+	Material& self = *static_cast<Material*>(userData);
 
-	MaterialLoader loader(getTempAllocator());
+	MaterialLoader loader(self.getTempAllocator());
 	ANKI_CHECK(loader.parseXmlDocument(doc));
+	loader.serialize(out);
+
+	return ErrorCode::NONE;
+}
+
+Error Material::load(const ResourceFilename& filename)
+{
+	DynamicArrayAuto<U8> compiled(getTempAllocator());
+	ANKI_CHECK(openFileCompiled(filename, COMPILED_VERSION, compileXml, this, compiled));
+	BinaryReader in(&compiled[0], compiled.getSize());
 
-	m_lodCount = loader.getLodCount();
-	m_shadow = loader.getShadowEnabled();
-	m_forwardShading = loader.isForwardShading();
-	m_tessellation = loader.getTessellationEnabled();
-	m_instanced = loader.isInstanced();
+	m_loader = getAllocator().newInstance<MaterialLoader>(getAllocator());
+	ANKI_CHECK(m_loader->deserialize(in));
+
+	m_lodCount = m_loader->getLodCount();
+	m_shadow = m_loader->getShadowEnabled();
+	m_forwardShading = m_loader->isForwardShading();
+	m_tessellation = m_loader->getTessellationEnabled();
+	m_instanced = m_loader->isInstanced();
 
 	// Start initializing
-	ANKI_CHECK(createVars(loader));
-	ANKI_CHECK(createVariants(loader));
+	ANKI_CHECK(createVars(*m_loader));
+	createVariants();
+
+	// Build the most common variant. It catches the errors early and it gives the hash
+	ANKI_CHECK(warmVariant(RenderingKey()));
+	m_hash = m_variants[getVariantIndex(RenderingKey())].m_sourceHash;
+
+	// When the builds are deferred the draws fall back to the variants of the last LOD without tessellation. Build
+	// them now so the draw path never builds
+	if(getManager()._getDeferMaterialVariantBuilds())
+	{
+		for(const MaterialVariant& variant : m_variants)
+		{
+			if(variant.m_key.m_lod == m_lodCount - 1 && !variant.m_key.m_tessellation)
+			{
+				ANKI_CHECK(warmVariant(variant.m_key));
+			}
+		}
+	}
+
+	// Build the variants that were drawn in previous runs
+	ANKI_CHECK(getManager()._getMaterialWarmList().iterateVariants(filename, [&](const RenderingKey& key) -> Error {
+		if(getVariantIndex(key) != MAX_U16)
+		{
+			ANKI_CHECK(warmVariant(key));
+		}
+		return ErrorCode::NONE;
+	}));
 
 	return ErrorCode::NONE;
 }
@@ -317,7 +399,7 @@ Error Material::createVars(const MaterialLoader& loader)
 	return err;
 }
 
-Error Material::createVariants(MaterialLoader& loader)
+void Material::createVariants()
 {
 	U tessStates = m_tessellation ? 2 : 1;
 	U instStates = m_instanced ? MAX_INSTANCE_GROUPS : 1;
@@ -340,7 +422,7 @@ Error Material::createVariants(MaterialLoader& loader)
 		}
 	}
 
-	// Create the variants
+	// Create the variants. They will be built when they are needed
 	m_variants.create(getAllocator(), variantsCount);
 
 	for(U p = 0; p < passStates; ++p)
@@ -357,21 +439,72 @@ Error Material::createVariants(MaterialLoader& loader)
 						continue;
 					}
 
-					RenderingKey key;
+					RenderingKey& key = m_variants[idx].m_key;
 					key.m_pass = Pass(p);
 					key.m_lod = l;
 					key.m_tessellation = t;
 					key.m_instanceCount = 1 << i;
-
-					ANKI_CHECK(m_variants[idx].init(key, *this, loader));
 				}
 			}
 		}
 	}
+}
+
+Error Material::buildVariant(MaterialVariant& variant) const
+{
+	ANKI_ASSERT(variant.m_state.load() != MaterialVariant::BUILT);
+
+	Error err = variant.init(variant.m_key, const_cast<Material&>(*this), *m_loader);
+	if(!err)
+	{
+		variant.m_state.store(MaterialVariant::BUILT, AtomicMemoryOrder::RELEASE);
+	}
+
+	return err;
+}
+
+Error Material::warmVariant(const RenderingKey& key)
+{
+	const U16 idx = getVariantIndex(key);
+	ANKI_ASSERT(idx != MAX_U16);
+	MaterialVariant& variant = m_variants[idx];
+
+	LockGuard<Mutex> lock(getManager()._getMaterialVariantMutex());
+	if(variant.m_state.load() != MaterialVariant::BUILT)
+	{
+		ANKI_CHECK(buildVariant(variant));
+	}
 
 	return ErrorCode::NONE;
 }
 
+Bool Material::buildPendingVariants(U& budget)
+{
+	Bool done = true;
+	for(MaterialVariant& variant : m_variants)
+	{
+		if(variant.m_state.load() != MaterialVariant::PENDING)
+		{
+			continue;
+		}
+
+		if(budget == 0)
+		{
+			done = false;
+			break;
+		}
+
+		--budget;
+		if(buildVariant(variant))
+		{
+			ANKI_LOGE("Failed to build a variant of material. Will use the fallback: %s", &getFilename()[0]);
+			variant.m_state.store(MaterialVariant::FAILED);
+		}
+	}
+
+	return done;
+}
+
 Error Material::createProgramSourceToCache(const String& source, ShaderType type, StringAuto& out)
 {
 	auto alloc = getTempAllocator();
@@ -414,13 +547,84 @@ void Material::fillResourceGroupInitInfo(ResourceGroupInitInfo& rcinit)
 	}
 }
 
-const MaterialVariant& Material::getVariant(const RenderingKey& key) const
+U32 Material::getTexturesVersion() const
+{
+	TexturesVersionVisitor visitor;
+
+	for(const auto& var : m_vars)
+	{
+		Error err = var->acceptVisitor(visitor);
+		(void)err;
+	}
+
+	return visitor.m_version;
+}
+
+U16 Material::getVariantIndex(const RenderingKey& key) const
 {
 	U lod = min<U>(m_lodCount - 1, key.m_lod);
-	U16 idx = m_variantMatrix[U(key.m_pass)][lod][key.m_tessellation][getInstanceGroupIdx(key.m_instanceCount)];
+	return m_variantMatrix[U(key.m_pass)][lod][key.m_tessellation][getInstanceGroupIdx(key.m_instanceCount)];
+}
 
+const MaterialVariant& Material::getVariant(const RenderingKey& key) const
+{
+	U16 idx = getVariantIndex(key);
 	ANKI_ASSERT(idx != MAX_U16);
-	return m_variants[idx];
+	MaterialVariant& variant = m_variants[idx];
+
+	if(ANKI_LIKELY(variant.m_state.load(AtomicMemoryOrder::ACQUIRE) == MaterialVariant::BUILT))
+	{
+		return variant;
+	}
+
+	ResourceManager& manager = const_cast<Material&>(*this).getManager();
+	LockGuard<Mutex> lock(manager._getMaterialVariantMutex());
+
+	if(variant.m_state.load() == MaterialVariant::BUILT)
+	{
+		return variant;
+	}
+
+	// Draw with a variant that has the same uniform block layout. The layout depends on the pass and the instance
+	// count only. Those variants were built at load time
+	if(manager._getDeferMaterialVariantBuilds())
+	{
+		if(variant.m_state.load() == MaterialVariant::NOT_BUILT)
+		{
+			variant.m_state.store(MaterialVariant::PENDING);
+			manager._addPendingMaterial(const_cast<Material*>(this));
+		}
+
+		return getFallbackVariant(variant);
+	}
+
+	if(variant.m_state.load() == MaterialVariant::NOT_BUILT && buildVariant(variant))
+	{
+		ANKI_LOGE("Failed to build a variant of material. Will use the fallback: %s", &getFilename()[0]);
+		variant.m_state.store(MaterialVariant::FAILED);
+	}
+
+	return (variant.m_state.load() == MaterialVariant::BUILT) ? variant : getFallbackVariant(variant);
+}
+
+const MaterialVariant& Material::getFallbackVariant(const MaterialVariant& variant) const
+{
+	RenderingKey fallbackKey = variant.m_key;
+	fallbackKey.m_lod = m_lodCount - 1;
+	fallbackKey.m_tessellation = false;
+	MaterialVariant& fallback = m_variants[getVariantIndex(fallbackKey)];
+
+	if(fallback.m_state.load() != MaterialVariant::BUILT)
+	{
+		// Only when the builds are not deferred. Without the fallback there is nothing to draw with
+		ANKI_ASSERT(!const_cast<Material&>(*this).getManager()._getDeferMaterialVariantBuilds());
+		if(&fallback == &variant || buildVariant(fallback))
+		{
+			ANKI_LOGF("Failed to build the fallback variant of material: %s", &getFilename()[0]);
+		}
+	}
+
+	return fallback;
 }
 
 U Material::getInstanceGroupIdx(U instanceCount)
@@ -12,6 +12,7 @@
 #include <anki/Math.h>
 #include <anki/util/Visitor.h>
 #include <anki/util/NonCopyable.h>
+#include <anki/util/Atomic.h>
 
 namespace anki
 {
@@ -158,7 +159,7 @@ private:
 	ANKI_USE_RESULT Error init(U idx, const MaterialLoaderInputVariable& in, Material& mtl);
 };
 
-/// Material variant.
+/// Material variant. The variants are built the first time they are asked for.
 class MaterialVariant : public NonCopyable
 {
 	friend class Material;
@@ -169,9 +170,10 @@ public:
 
 	~MaterialVariant();
 
+	/// Get the shader of a stage. It's empty if the variant doesn't have that stage.
 	ShaderPtr getShader(ShaderType type) const
 	{
-		return m_shaders[U(type)]->getGrShader();
+		return (m_shaders[U(type)].isCreated()) ? m_shaders[U(type)]->getGrShader() : ShaderPtr();
 	}
 
 	U getDefaultBlockSize() const
@@ -187,11 +189,22 @@ public:
 	}
 
 private:
+	/// @name The states of a variant
+	/// @{
+	static const U32 NOT_BUILT = 0;
+	static const U32 PENDING = 1; ///< Asked for but the build is deferred.
+	static const U32 BUILT = 2;
+	static const U32 FAILED = 3; ///< The build failed and the fallback is used instead.
+	/// @}
+
 	/// All shaders except compute and geometry.
 	Array<ShaderResourcePtr, 5> m_shaders;
 	U32 m_shaderBlockSize = 0;
 	DynamicArray<ShaderVariableBlockInfo> m_blockInfo;
 	DynamicArray<Bool8> m_varActive;
+	U64 m_sourceHash = 0;
+	RenderingKey m_key;
+	Atomic<U32> m_state = {NOT_BUILT};
 
 	ANKI_USE_RESULT Error init(const RenderingKey& key, Material& mtl, MaterialLoader& loader);
 
@@ -306,8 +319,14 @@ public:
 		return m_instanced;
 	}
 
+	/// Get a variant and build it if it's not built. It's thread-safe. If the manager defers the builds it never builds.
+	/// It returns a variant of the last LOD that was built at load time and has the same uniform block layout and it
+	/// queues the requested one. The same fallback is returned if the build of the requested variant failed.
 	const MaterialVariant& getVariant(const RenderingKey& key) const;
 
+	/// Build a variant now.
+	ANKI_USE_RESULT Error warmVariant(const RenderingKey& key);
+
 	const DynamicArray<MaterialVariable*>& getVariables() const
 	{
 		return m_vars;
@@ -315,9 +334,21 @@ public:
 
 	void fillResourceGroupInitInfo(ResourceGroupInitInfo& rcinit);
 
+	/// It changes when the streamed textures get new mips. The resource groups should be re-created then.
+	U32 getTexturesVersion() const;
+
 	static U getInstanceGroupIdx(U instanceCount);
 
+anki_internal:
+	/// Build the deferred variants. The manager's variant mutex should be locked.
+	/// @param[in,out] budget The number of variants that can be built. It's decremented.
+	/// @return True if there are no deferred variants left.
+	Bool buildPendingVariants(U& budget);
+
 private:
+	/// Bump it when the compiled form changes.
+	static const U32 COMPILED_VERSION = 1;
+
 	/// Used for sorting
 	U64 m_hash = 0;
 
@@ -327,7 +358,8 @@ private:
 	U8 m_lodCount = 1;
 	Bool8 m_instanced = false;
 
-	DynamicArray<MaterialVariant> m_variants;
+	/// The variants are built on demand so they are mutable. The manager's variant mutex protects them.
+	mutable DynamicArray<MaterialVariant> m_variants;
 
 	/// This is a matrix of variants. It holds indices to m_variants. If the
 	/// idx is MAX_U16 then the variant is not present
@@ -335,11 +367,26 @@ private:
 
 	DynamicArray<MaterialVariable*> m_vars;
 
+	/// It's kept to build the variants later.
+	MaterialLoader* m_loader = nullptr;
+
+	/// The compiled form is the parsed MaterialLoader.
+	static ANKI_USE_RESULT Error compileXml(const XmlDocument& xml, BinaryWriter& out, void* userData);
+
 	/// Populate the m_varNames.
 	ANKI_USE_RESULT Error createVars(const MaterialLoader& loader);
 
-	/// Create the variants.
-	ANKI_USE_RESULT Error createVariants(MaterialLoader& loader);
+	/// Allocate the variants. It doesn't build them.
+	void createVariants();
+
+	U16 getVariantIndex(const RenderingKey& key) const;
+
+	/// Build a variant. The manager's variant mutex should be locked.
+	ANKI_USE_RESULT Error buildVariant(MaterialVariant& variant) const;
+
+	/// Get the variant of the last LOD without tessellation that has the same uniform block layout. It builds it if the
+	/// builds are not deferred. The manager's variant mutex should be locked.
+	const MaterialVariant& getFallbackVariant(const MaterialVariant& variant) const;
 
 	/// Create a unique shader source in chache. If already exists do nothing
 	ANKI_USE_RESULT Error createProgramSourceToCache(const String& source, ShaderType type, StringAuto& out);
@@ -4,6 +4,7 @@
 // http://www.anki3d.org/LICENSE
 
 #include <anki/resource/MaterialLoader.h>
+#include <anki/resource/CompiledResourceCache.h>
 #include <anki/util/Assert.h>
 #include <anki/misc/Xml.h>
 #include <anki/util/Logger.h>
@@ -843,6 +844,113 @@ Error MaterialLoader::parseOperationTag(
 	return ErrorCode::NONE;
 }
 
+static void writeStringList(const StringList& list, BinaryWriter& out)
+{
+	out.write<U32>(list.getSize());
+	for(const String& str : list)
+	{
+		out.writeString(str);
+	}
+}
+
+static ANKI_USE_RESULT Error readStringList(BinaryReader& in, GenericMemoryPoolAllocator<char> alloc, StringList& list)
+{
+	U32 count;
+	ANKI_CHECK(in.read(count));
+	for(U i = 0; i < count; ++i)
+	{
+		CString str;
+		ANKI_CHECK(in.readString(str));
+		list.emplaceBack(alloc);
+		list.getBack().create(alloc, str);
+	}
+
+	return ErrorCode::NONE;
+}
+
+void MaterialLoader::serialize(BinaryWriter& out) const
+{
+	for(const StringList& lines : m_source)
+	{
+		writeStringList(lines, out);
+	}
+
+	// The block info is computed by mutate() so it's not written
+	out.write<U32>(m_inputs.getSize());
+	for(const Input& in : m_inputs)
+	{
+		out.writeString(in.m_name);
+		writeStringList(in.m_value, out);
+		out.writeString(in.m_line);
+		out.write(in.m_type);
+		out.write(in.m_builtin);
+		out.write(in.m_flags);
+		out.write(in.m_binding);
+		out.write(in.m_index);
+		out.write(in.m_shaderDefinedMask);
+		out.write(in.m_shaderReferencedMask);
+	}
+
+	out.write(m_uniformBlockReferencedMask);
+	out.write(m_instanced);
+	out.write(m_texBinding);
+	out.write(m_instanceIdMask);
+	out.write(m_tessellation);
+	out.write(m_lodCount);
+	out.write(m_shadow);
+	out.write(m_forwardShading);
+	out.write(m_nextIndex);
+}
+
+Error MaterialLoader::deserialize(BinaryReader& in)
+{
+	ANKI_ASSERT(m_inputs.isEmpty());
+
+	for(StringList& lines : m_source)
+	{
+		ANKI_CHECK(readStringList(in, m_alloc, lines));
+	}
+
+	U32 inputCount;
+	ANKI_CHECK(in.read(inputCount));
+	for(U i = 0; i < inputCount; ++i)
+	{
+		m_inputs.emplaceBack(m_alloc);
+		Input& inp = m_inputs.getBack();
+		inp.m_alloc = m_alloc;
+
+		CString str;
+		ANKI_CHECK(in.readString(str));
+		inp.m_name.create(m_alloc, str);
+		ANKI_CHECK(readStringList(in, m_alloc, inp.m_value));
+		ANKI_CHECK(in.readString(str));
+		if(!str.isEmpty())
+		{
+			inp.m_line.create(m_alloc, str);
+		}
+
+		ANKI_CHECK(in.read(inp.m_type));
+		ANKI_CHECK(in.read(inp.m_builtin));
+		ANKI_CHECK(in.read(inp.m_flags));
+		ANKI_CHECK(in.read(inp.m_binding));
+		ANKI_CHECK(in.read(inp.m_index));
+		ANKI_CHECK(in.read(inp.m_shaderDefinedMask));
+		ANKI_CHECK(in.read(inp.m_shaderReferencedMask));
+	}
+
+	ANKI_CHECK(in.read(m_uniformBlockReferencedMask));
+	ANKI_CHECK(in.read(m_instanced));
+	ANKI_CHECK(in.read(m_texBinding));
+	ANKI_CHECK(in.read(m_instanceIdMask));
+	ANKI_CHECK(in.read(m_tessellation));
+	ANKI_CHECK(in.read(m_lodCount));
+	ANKI_CHECK(in.read(m_shadow));
+	ANKI_CHECK(in.read(m_forwardShading));
+	ANKI_CHECK(in.read(m_nextIndex));
+
+	return ErrorCode::NONE;
+}
+
 void MaterialLoader::mutate(const RenderingKey& key)
 {
 	U instanceCount = key.m_instanceCount;
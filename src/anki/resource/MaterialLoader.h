@@ -15,6 +15,8 @@ namespace anki
 
 // Forward
 class XmlElement;
+class BinaryWriter;
+class BinaryReader;
 
 /// Material loader variable. It's the information on whatever is inside \<input\>
 class MaterialLoaderInputVariable : public NonCopyable
@@ -102,6 +104,12 @@ public:
 
 	ANKI_USE_RESULT Error parseXmlDocument(const XmlDocument& doc);
 
+	/// Write what parseXmlDocument() produced. deserialize() reads it back and it's much faster than parsing again.
+	void serialize(BinaryWriter& out) const;
+
+	/// Read what serialize() wrote. Use it instead of parseXmlDocument().
+	ANKI_USE_RESULT Error deserialize(BinaryReader& in);
+
 	/// Get the shader source code
 	const String& getShaderSource(ShaderType shaderType_) const
 	{
@@ -0,0 +1,187 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/resource/MaterialWarmList.h>
+#include <anki/util/File.h>
+#include <anki/util/Filesystem.h>
+#include <anki/util/StringList.h>
+#include <anki/util/Logger.h>
+
+namespace anki
+{
+
+MaterialWarmList::~MaterialWarmList()
+{
+	for(Entry* entry : m_entries)
+	{
+		entry->m_material.destroy(m_alloc);
+		m_alloc.deleteInstance(entry);
+	}
+
+	m_entries.destroy(m_alloc);
+	m_filename.destroy(m_alloc);
+}
+
+void MaterialWarmList::init(ResourceAllocator<U8> alloc, CString filename)
+{
+	m_alloc = alloc;
+	m_filename.create(m_alloc, filename);
+}
+
+U MaterialWarmList::computeVariantIndex(const RenderingKey& key)
+{
+	ANKI_ASSERT(key.m_lod < MAX_LODS);
+
+	U group = 0;
+	while((1u << group) < key.m_instanceCount)
+	{
+		++group;
+	}
+	ANKI_ASSERT(group < MAX_INSTANCE_GROUPS);
+
+	const U tess = key.m_tessellation ? 1 : 0;
+	const U idx = ((U(key.m_pass) * MAX_LODS + key.m_lod) * 2 + tess) * MAX_INSTANCE_GROUPS + group;
+	ANKI_ASSERT(idx < VARIANT_COUNT);
+	return idx;
+}
+
+RenderingKey MaterialWarmList::computeKey(U variantIdx)
+{
+	ANKI_ASSERT(variantIdx < VARIANT_COUNT);
+
+	const U group = variantIdx % MAX_INSTANCE_GROUPS;
+	variantIdx /= MAX_INSTANCE_GROUPS;
+	const Bool tessellation = variantIdx % 2;
+	variantIdx /= 2;
+	const U lod = variantIdx % MAX_LODS;
+	const Pass pass = Pass(variantIdx / MAX_LODS);
+
+	return RenderingKey(pass, lod, tessellation, 1 << group);
+}
+
+void MaterialWarmList::record(CString material, const RenderingKey& key)
+{
+	const U idx = computeVariantIndex(key);
+
+	LockGuard<Mutex> lock(m_mtx);
+
+	auto it = m_entries.find(material);
+	Entry* entry;
+	if(it != m_entries.getEnd())
+	{
+		entry = *it;
+	}
+	else
+	{
+		entry = m_alloc.newInstance<Entry>();
+		entry->m_material.create(m_alloc, material);
+		m_entries.pushBack(m_alloc, entry->m_material.toCString(), entry);
+	}
+
+	entry->m_variants.set(idx);
+}
+
+U MaterialWarmList::getVariantCount() const
+{
+	LockGuard<Mutex> lock(m_mtx);
+
+	U count = 0;
+	for(const Entry* entry : m_entries)
+	{
+		for(U i = 0; i < VARIANT_COUNT; ++i)
+		{
+			count += entry->m_variants.get(i) ? 1 : 0;
+		}
+	}
+
+	return count;
+}
+
+Error MaterialWarmList::parseLine(CString line)
+{
+	StringListAuto tokens(m_alloc);
+	tokens.splitString(line, ' ');
+
+	if(tokens.getSize() != 5)
+	{
+		return ErrorCode::USER_DATA;
+	}
+
+	Array<I64, 4> numbers;
+	auto it = tokens.getBegin();
+	for(U i = 0; i < numbers.getSize(); ++i)
+	{
+		ANKI_CHECK(it->toCString().toI64(numbers[i]));
+		++it;
+	}
+
+	if(numbers[0] < 0 || numbers[0] >= I64(Pass::COUNT) || numbers[1] < 0 || numbers[1] >= I64(MAX_LODS)
+		|| numbers[2] < 0 || numbers[2] > 1 || numbers[3] < 1 || numbers[3] > I64(MAX_INSTANCES))
+	{
+		return ErrorCode::USER_DATA;
+	}
+
+	record(it->toCString(), RenderingKey(Pass(numbers[0]), numbers[1], numbers[2], numbers[3]));
+	return ErrorCode::NONE;
+}
+
+Error MaterialWarmList::load()
+{
+	if(!fileExists(m_filename.toCString()))
+	{
+		return ErrorCode::NONE;
+	}
+
+	File file;
+	ANKI_CHECK(file.open(m_filename.toCString(), FileOpenFlag::READ));
+
+	StringAuto text(m_alloc);
+	ANKI_CHECK(file.readAllText(text));
+
+	StringListAuto lines(m_alloc);
+	lines.splitString(text.toCString(), '\n');
+
+	U lineNumber = 0;
+	for(const String& line : lines)
+	{
+		++lineNumber;
+		if(parseLine(line.toCString()))
+		{
+			ANKI_LOGE("Wrong line in material warm list %s:%u", &m_filename[0], lineNumber);
+			return ErrorCode::USER_DATA;
+		}
+	}
+
+	return ErrorCode::NONE;
+}
+
+Error MaterialWarmList::save() const
+{
+	File file;
+	ANKI_CHECK(file.open(m_filename.toCString(), FileOpenFlag::WRITE));
+
+	LockGuard<Mutex> lock(m_mtx);
+
+	for(const Entry* entry : m_entries)
+	{
+		for(U i = 0; i < VARIANT_COUNT; ++i)
+		{
+			if(entry->m_variants.get(i))
+			{
+				const RenderingKey key = computeKey(i);
+				ANKI_CHECK(file.writeText("%u %u %u %u %s\n",
+					U(key.m_pass),
+					U(key.m_lod),
+					U(key.m_tessellation),
+					U(key.m_instanceCount),
+					&entry->m_material[0]));
+			}
+		}
+	}
+
+	return ErrorCode::NONE;
+}
+
+} // end namespace anki
@@ -0,0 +1,103 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/resource/RenderingKey.h>
+#include <anki/util/HashMap.h>
+#include <anki/util/BitSet.h>
+#include <anki/util/String.h>
+#include <anki/util/Thread.h>
+
+namespace anki
+{
+
+/// @addtogroup resource
+/// @{
+
+/// The list of the material variants that were drawn. It's recorded while playing and it's used to build only those
+/// variants when the materials are loaded the next time.
+///
+/// The file is text and it has one variant per line:
+/// @code
+/// pass lod tessellation instanceCount path/to/material.ankimtl
+/// @endcode
+class MaterialWarmList : public NonCopyable
+{
+public:
+	MaterialWarmList() = default;
+
+	~MaterialWarmList();
+
+	/// @param filename The file to load from and save to.
+	void init(ResourceAllocator<U8> alloc, CString filename);
+
+	/// Load the file. It's not an error if it doesn't exist.
+	ANKI_USE_RESULT Error load();
+
+	/// Write all the variants to the file.
+	ANKI_USE_RESULT Error save() const;
+
+	/// Add a variant. It's thread-safe.
+	void record(CString material, const RenderingKey& key);
+
+	/// Iterate the variants of a material.
+	template<typename TFunc>
+	ANKI_USE_RESULT Error iterateVariants(CString material, TFunc func) const;
+
+	/// Get the number of the variants in the list.
+	U getVariantCount() const;
+
+	/// Map a key to a unique number less than VARIANT_COUNT.
+	static U computeVariantIndex(const RenderingKey& key);
+
+	/// The opposite of computeVariantIndex.
+	static RenderingKey computeKey(U variantIdx);
+
+private:
+	static const U VARIANT_COUNT = U(Pass::COUNT) * MAX_LODS * 2 * MAX_INSTANCE_GROUPS;
+
+	class Entry
+	{
+	public:
+		String m_material;
+		BitSet<VARIANT_COUNT> m_variants = {false};
+	};
+
+	ResourceAllocator<U8> m_alloc;
+	String m_filename;
+	HashMap<CString, Entry*, CStringHasher, CStringCompare> m_entries;
+	mutable Mutex m_mtx;
+
+	ANKI_USE_RESULT Error parseLine(CString line);
+};
+
+template<typename TFunc>
+inline Error MaterialWarmList::iterateVariants(CString material, TFunc func) const
+{
+	BitSet<VARIANT_COUNT> variants(false);
+	{
+		LockGuard<Mutex> lock(m_mtx);
+		auto& entries = const_cast<MaterialWarmList&>(*this).m_entries;
+		auto it = entries.find(material);
+		if(it != entries.getEnd())
+		{
+			variants = (*it)->m_variants;
+		}
+	}
+
+	for(U i = 0; i < VARIANT_COUNT; ++i)
+	{
+		if(variants.get(i))
+		{
+			ANKI_CHECK(func(computeKey(i)));
+		}
+	}
+
+	return ErrorCode::NONE;
+}
+/// @}
+
+} // end namespace anki
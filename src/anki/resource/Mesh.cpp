@@ -6,116 +6,31 @@
 #include <anki/resource/Mesh.h>
 #include <anki/resource/ResourceManager.h>
 #include <anki/resource/MeshLoader.h>
-#include <anki/resource/AsyncLoader.h>
 #include <anki/util/Functions.h>
+#include <anki/util/Hash.h>
 #include <anki/misc/Xml.h>
 
 namespace anki
 {
 
-/// Mesh upload async task.
-class MeshLoadTask : public AsyncLoaderTask
+Mesh::Mesh(ResourceManager* manager)
+	: ResourceObject(manager)
 {
-public:
-	ResourceManager* m_manager ANKI_DBG_NULLIFY_PTR;
-	BufferPtr m_vertBuff;
-	BufferPtr m_indicesBuff;
-	MeshLoader m_loader;
-
-	MeshLoadTask(ResourceManager* manager)
-		: m_manager(manager)
-		, m_loader(manager, manager->getAsyncLoader().getAllocator())
-	{
-	}
-
-	Error operator()(AsyncLoaderTaskContext& ctx) final;
-};
+}
 
-Error MeshLoadTask::operator()(AsyncLoaderTaskContext& ctx)
+Mesh::~Mesh()
 {
-	GrManager& gr = m_manager->getGrManager();
-	CommandBufferPtr cmdb;
+	m_subMeshes.destroy(getAllocator());
 
-	// Write vert buff
-	if(m_vertBuff)
+	if(m_vertAlloc)
 	{
-		TransientMemoryToken token;
-		void* data = gr.tryAllocateFrameTransientMemory(
-			m_loader.getVertexDataSize(), BufferUsageBit::BUFFER_UPLOAD_SOURCE, token);
-
-		if(data)
-		{
-			memcpy(data, m_loader.getVertexData(), m_loader.getVertexDataSize());
-			cmdb = gr.newInstance<CommandBuffer>(CommandBufferInitInfo());
-
-			cmdb->setBufferBarrier(
-				m_vertBuff, BufferUsageBit::VERTEX, BufferUsageBit::BUFFER_UPLOAD_DESTINATION, 0, MAX_PTR_SIZE);
-
-			cmdb->uploadBuffer(m_vertBuff, 0, token);
-
-			cmdb->setBufferBarrier(
-				m_vertBuff, BufferUsageBit::BUFFER_UPLOAD_DESTINATION, BufferUsageBit::VERTEX, 0, MAX_PTR_SIZE);
-
-			m_vertBuff.reset(nullptr);
-		}
-		else
-		{
-			ctx.m_pause = true;
-			ctx.m_resubmitTask = true;
-			return ErrorCode::NONE;
-		}
+		getManager().getGeometryArena().free(m_vertAlloc);
 	}
 
-	// Create index buffer
+	if(m_indicesAlloc)
 	{
-		TransientMemoryToken token;
-		void* data = gr.tryAllocateFrameTransientMemory(
-			m_loader.getIndexDataSize(), BufferUsageBit::BUFFER_UPLOAD_SOURCE, token);
-
-		if(data)
-		{
-			memcpy(data, m_loader.getIndexData(), m_loader.getIndexDataSize());
-
-			if(!cmdb)
-			{
-				cmdb = gr.newInstance<CommandBuffer>(CommandBufferInitInfo());
-			}
-
-			cmdb->setBufferBarrier(
-				m_indicesBuff, BufferUsageBit::INDEX, BufferUsageBit::BUFFER_UPLOAD_DESTINATION, 0, MAX_PTR_SIZE);
-
-			cmdb->uploadBuffer(m_indicesBuff, 0, token);
-
-			cmdb->setBufferBarrier(
-				m_indicesBuff, BufferUsageBit::BUFFER_UPLOAD_DESTINATION, BufferUsageBit::INDEX, 0, MAX_PTR_SIZE);
-
-			cmdb->flush();
-		}
-		else
-		{
-			// Submit prev work
-			if(cmdb)
-			{
-				cmdb->flush();
-			}
-
-			ctx.m_pause = true;
-			ctx.m_resubmitTask = true;
-			return ErrorCode::NONE;
-		}
+		getManager().getGeometryArena().free(m_indicesAlloc);
 	}
-
-	return ErrorCode::NONE;
-}
-
-Mesh::Mesh(ResourceManager* manager)
-	: ResourceObject(manager)
-{
-}
-
-Mesh::~Mesh()
-{
-	m_subMeshes.destroy(getAllocator());
 }
 
 Bool Mesh::isCompatible(const Mesh& other) const
@@ -126,55 +41,46 @@ Bool Mesh::isCompatible(const Mesh& other) const
 
 Error Mesh::load(const ResourceFilename& filename)
 {
-	MeshLoadTask* task = getManager().getAsyncLoader().newTask<MeshLoadTask>(&getManager());
-
-	MeshLoader& loader = task->m_loader;
+	MeshLoader loader(&getManager());
 	ANKI_CHECK(loader.load(filename));
 
 	const MeshLoader::Header& header = loader.getHeader();
 	m_indicesCount = header.m_totalIndicesCount;
 
-	PtrSize vertexSize = loader.getVertexSize();
 	m_obb.setFromPointCloud(
-		loader.getVertexData(), header.m_totalVerticesCount, vertexSize, loader.getVertexDataSize());
+		loader.getPositions(), header.m_totalVerticesCount, sizeof(Vec3), header.m_totalVerticesCount * sizeof(Vec3));
 	ANKI_ASSERT(m_indicesCount > 0);
 	ANKI_ASSERT(m_indicesCount % 3 == 0 && "Expecting triangles");
 
 	// Set the non-VBO members
 	m_vertsCount = header.m_totalVerticesCount;
 	ANKI_ASSERT(m_vertsCount > 0);
+	m_vertSize = loader.getVertexSize();
+
+	m_dequantization = Mat4(
+		Vec4(header.m_positionOffset[0], header.m_positionOffset[1], header.m_positionOffset[2], 0.0),
+		Mat3::getIdentity(),
+		header.m_positionScale);
+	m_lodError = header.m_lodError;
 
 	m_texChannelsCount = header.m_uvsChannelCount;
 	m_weights = loader.hasBoneInfo();
+	setMemorySize(loader.getVertexDataSize() + loader.getIndexDataSize());
 
-	// Allocate the buffers
-	GrManager& gr = getManager().getGrManager();
-
-	m_vertBuff = gr.newInstance<Buffer>(loader.getVertexDataSize(),
-		BufferUsageBit::VERTEX | BufferUsageBit::BUFFER_UPLOAD_DESTINATION | BufferUsageBit::FILL,
-		BufferMapAccessBit::NONE);
-
-	m_indicesBuff = gr.newInstance<Buffer>(loader.getIndexDataSize(),
-		BufferUsageBit::INDEX | BufferUsageBit::BUFFER_UPLOAD_DESTINATION | BufferUsageBit::FILL,
-		BufferMapAccessBit::NONE);
-
-	// Clear them
-	CommandBufferInitInfo cmdbinit;
-	cmdbinit.m_flags = CommandBufferFlag::SMALL_BATCH;
-	CommandBufferPtr cmdb = gr.newInstance<CommandBuffer>(cmdbinit);
-
-	cmdb->fillBuffer(m_vertBuff, 0, MAX_PTR_SIZE, 0);
-	cmdb->fillBuffer(m_indicesBuff, 0, MAX_PTR_SIZE, 0);
+	m_contentHash = computeHash(&header, sizeof(header));
+	m_contentHash = appendHash(loader.getVertexData(), loader.getVertexDataSize(), m_contentHash);
+	m_contentHash = appendHash(loader.getIndexData(), loader.getIndexDataSize(), m_contentHash);
 
-	cmdb->setBufferBarrier(m_vertBuff, BufferUsageBit::FILL, BufferUsageBit::VERTEX, 0, MAX_PTR_SIZE);
-	cmdb->setBufferBarrier(m_indicesBuff, BufferUsageBit::FILL, BufferUsageBit::INDEX, 0, MAX_PTR_SIZE);
+	// Allocate from the shared buffers and upload. The arena copies the data so the loader can go away
+	GeometryArena& arena = getManager().getGeometryArena();
+	ANKI_CHECK(arena.allocateVertices(m_vertsCount, m_vertSize, m_vertAlloc));
+	ANKI_CHECK(arena.allocateIndices(m_indicesCount, m_indicesAlloc));
 
-	cmdb->flush();
+	arena.upload(m_vertAlloc, loader.getVertexData(), loader.getVertexDataSize());
+	arena.upload(m_indicesAlloc, loader.getIndexData(), loader.getIndexDataSize());
 
-	// Submit the loading task
-	task->m_indicesBuff = m_indicesBuff;
-	task->m_vertBuff = m_vertBuff;
-	getManager().getAsyncLoader().submitTask(task);
+	m_vertBuff = arena.getBuffer(GeometryArenaBuffer::VERTEX);
+	m_indicesBuff = arena.getBuffer(GeometryArenaBuffer::INDEX);
 
 	return ErrorCode::NONE;
 }
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <anki/resource/ResourceObject.h>
+#include <anki/resource/GeometryArena.h>
 #include <anki/Math.h>
 #include <anki/Gr.h>
 #include <anki/collision/Obb.h>
@@ -19,7 +20,7 @@ class MeshLoader;
 /// @addtogroup resource
 /// @{
 
-/// Mesh Resource. It contains the geometry packed in GPU buffers.
+/// Mesh Resource. Its geometry lives in the buffers of the GeometryArena.
 class Mesh : public ResourceObject
 {
 public:
@@ -73,16 +74,48 @@ public:
 		return m_subMeshes.getSize();
 	}
 
+	/// The transform that moves the quantized positions of the vertex buffer to model space. See MeshLoader::Vertex.
+	const Mat4& getDequantizationTransform() const
+	{
+		return m_dequantization;
+	}
+
+	/// The geometric error of the mesh in model space if it's a simplified LOD. See MeshLoader::Header::m_lodError.
+	F32 getLodError() const
+	{
+		return m_lodError;
+	}
+
+	/// A hash of the loaded header, vertices and indices. It changes when the contents of the file change.
+	U64 getContentHash() const
+	{
+		return m_contentHash;
+	}
+
+	/// The vertex buffer is shared with other meshes. Draw with getBaseVertex().
 	BufferPtr getVertexBuffer() const
 	{
 		return m_vertBuff;
 	}
 
+	/// The index buffer is shared with other meshes. Draw with getFirstIndex().
 	BufferPtr getIndexBuffer() const
 	{
 		return m_indicesBuff;
 	}
 
+	/// The first vertex of the mesh in the vertex buffer.
+	U32 getBaseVertex() const
+	{
+		return m_vertAlloc.getOffset() / m_vertSize;
+	}
+
+	/// The first index of the mesh in the index buffer.
+	U32 getFirstIndex() const
+	{
+		return m_indicesAlloc.getOffset() / sizeof(U16);
+	}
+
 	/// Helper function for correct loading
 	Bool isCompatible(const Mesh& other) const;
 
@@ -102,11 +135,17 @@ protected:
 	U32 m_indicesCount;
 	U32 m_vertsCount;
 	Obb m_obb;
+	Mat4 m_dequantization;
+	F32 m_lodError = 0.0;
+	U64 m_contentHash = 0;
+	U32 m_vertSize;
 	U8 m_texChannelsCount;
 	Bool8 m_weights;
 
 	BufferPtr m_vertBuff;
 	BufferPtr m_indicesBuff;
+	GeometryArenaAllocation m_vertAlloc;
+	GeometryArenaAllocation m_indicesAlloc;
 };
 /// @}
 
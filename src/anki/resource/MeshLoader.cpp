@@ -6,10 +6,85 @@
 #include <anki/resource/MeshLoader.h>
 #include <anki/resource/ResourceManager.h>
 #include <anki/resource/ResourceFilesystem.h>
+#include <cmath>
 
 namespace anki
 {
 
+static I16 packSnorm16(F32 f)
+{
+	return I16(std::round(clamp(f, -1.0f, 1.0f) * 32767.0f));
+}
+
+static F32 unpackSnorm16(I16 i)
+{
+	return max(F32(i) / 32767.0f, -1.0f);
+}
+
+static F32 unpackSnorm8(I8 i)
+{
+	return max(F32(i) / 127.0f, -1.0f);
+}
+
+/// Unpack a signed R10G10B10A2.
+static Vec4 unpackR10G10B10A2Snorm(U32 packed)
+{
+	// Move every component to the top bits and shift it back to extend the sign
+	const I32 x = I32(packed << 22) >> 22;
+	const I32 y = I32(packed << 12) >> 22;
+	const I32 z = I32(packed << 2) >> 22;
+	const I32 w = I32(packed) >> 30;
+
+	return Vec4(max(F32(x) / 511.0f, -1.0f), max(F32(y) / 511.0f, -1.0f), max(F32(z) / 511.0f, -1.0f), F32(w));
+}
+
+static Vec3 unpackOctahedral(const Array<I8, 2>& enc)
+{
+	const F32 x = unpackSnorm8(enc[0]);
+	const F32 y = unpackSnorm8(enc[1]);
+	Vec3 n(x, y, 1.0f - absolute(x) - absolute(y));
+	if(n.z() < 0.0f)
+	{
+		n.x() = (1.0f - absolute(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+		n.y() = (1.0f - absolute(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+	}
+
+	return n.getNormalized();
+}
+
+/// Octahedral encoding of a unit vector. Of the 4 nearest quantized values it keeps the one that decodes closest to
+/// the input.
+static void packOctahedral(const Vec3& in, Array<I8, 2>& out)
+{
+	const F32 sum = absolute(in.x()) + absolute(in.y()) + absolute(in.z());
+	Vec3 n = (sum > 0.0f) ? in / sum : Vec3(0.0f, 0.0f, 1.0f);
+	if(n.z() < 0.0f)
+	{
+		const F32 x = n.x();
+		n.x() = (1.0f - absolute(n.y())) * ((x >= 0.0f) ? 1.0f : -1.0f);
+		n.y() = (1.0f - absolute(x)) * ((n.y() >= 0.0f) ? 1.0f : -1.0f);
+	}
+
+	const Vec3 dir = (sum > 0.0f) ? in.getNormalized() : Vec3(0.0f, 0.0f, 1.0f);
+	const F32 x = std::floor(clamp(n.x(), -1.0f, 1.0f) * 127.0f);
+	const F32 y = std::floor(clamp(n.y(), -1.0f, 1.0f) * 127.0f);
+
+	F32 bestDot = -2.0f;
+	for(U i = 0; i < 4; ++i)
+	{
+		Array<I8, 2> enc;
+		enc[0] = I8(clamp(x + F32(i & 1), -127.0f, 127.0f));
+		enc[1] = I8(clamp(y + F32(i >> 1), -127.0f, 127.0f));
+
+		const F32 dot = unpackOctahedral(enc).dot(dir);
+		if(dot > bestDot)
+		{
+			bestDot = dot;
+			out = enc;
+		}
+	}
+}
+
 MeshLoader::MeshLoader(ResourceManager* manager)
 	: MeshLoader(manager, manager->getTempAllocator())
 {
@@ -21,6 +96,7 @@ MeshLoader::~MeshLoader()
 	m_verts.destroy(m_alloc);
 	m_indices.destroy(m_alloc);
 	m_subMeshes.destroy(m_alloc);
+	m_positions.destroy(m_alloc);
 }
 
 Error MeshLoader::load(const ResourceFilename& filename)
@@ -35,7 +111,17 @@ Error MeshLoader::load(const ResourceFilename& filename)
 	//
 	// Check header
 	//
-	if(memcmp(&m_header.m_magic[0], "ANKIMES3", 8) != 0)
+	Bool optimized;
+	if(memcmp(&m_header.m_magic[0], "ANKIMES3", 8) == 0)
+	{
+		optimized = false;
+		m_header.m_lodError = 0.0;
+	}
+	else if(memcmp(&m_header.m_magic[0], "ANKIMES4", 8) == 0)
+	{
+		optimized = true;
+	}
+	else
 	{
 		ANKI_LOGE("Wrong magic word");
 		return ErrorCode::USER_DATA;
@@ -54,24 +140,37 @@ Error MeshLoader::load(const ResourceFilename& filename)
 	}
 
 	// Check positions
-	if(m_header.m_positionsFormat.m_components != ComponentFormat::R32G32B32
-		|| m_header.m_positionsFormat.m_transform != FormatTransform::FLOAT)
+	if((!optimized && !formatEquals(m_header.m_positionsFormat, ComponentFormat::R32G32B32, FormatTransform::FLOAT))
+		|| (optimized
+			   && !formatEquals(m_header.m_positionsFormat, ComponentFormat::R16G16B16A16, FormatTransform::SNORM)))
 	{
 		ANKI_LOGE("Incorrect/unsupported positions format");
 		return ErrorCode::USER_DATA;
 	}
 
+	if(optimized && !(m_header.m_positionScale > 0.0))
+	{
+		ANKI_LOGE("Incorrect position dequantization");
+		return ErrorCode::USER_DATA;
+	}
+
+	if(!(m_header.m_lodError >= 0.0))
+	{
+		ANKI_LOGE("Incorrect LOD error");
+		return ErrorCode::USER_DATA;
+	}
+
 	// Check normals
-	if(m_header.m_normalsFormat.m_components != ComponentFormat::R10G10B10A2
-		|| m_header.m_normalsFormat.m_transform != FormatTransform::SNORM)
+	if((!optimized && !formatEquals(m_header.m_normalsFormat, ComponentFormat::R10G10B10A2, FormatTransform::SNORM))
+		|| (optimized && !formatEquals(m_header.m_normalsFormat, ComponentFormat::R8G8, FormatTransform::SNORM)))
 	{
 		ANKI_LOGE("Incorrect/unsupported normals format");
 		return ErrorCode::USER_DATA;
 	}
 
 	// Check tangents
-	if(m_header.m_tangentsFormat.m_components != ComponentFormat::R10G10B10A2
-		|| m_header.m_tangentsFormat.m_transform != FormatTransform::SNORM)
+	if((!optimized && !formatEquals(m_header.m_tangentsFormat, ComponentFormat::R10G10B10A2, FormatTransform::SNORM))
+		|| (optimized && !formatEquals(m_header.m_tangentsFormat, ComponentFormat::R8G8, FormatTransform::SNORM)))
 	{
 		ANKI_LOGE("Incorrect/unsupported tangents format");
 		return ErrorCode::USER_DATA;
@@ -203,18 +302,139 @@ Error MeshLoader::load(const ResourceFilename& filename)
 	//
 	// Read vertices
 	//
-	m_vertSize = 3 * sizeof(F32) // pos
-		+ 1 * sizeof(U32) // norm
-		+ 1 * sizeof(U32) // tang
-		+ 2 * sizeof(U16) // uvs
-		+ ((hasBoneInfo) ? (4 * sizeof(U8) + 4 * sizeof(U16)) : 0);
-
+	m_vertSize = sizeof(Vertex) + ((hasBoneInfo) ? sizeof(VertexBoneInfo) : 0);
 	m_verts.create(alloc, m_header.m_totalVerticesCount * m_vertSize);
-	ANKI_CHECK(file->read(&m_verts[0], m_verts.getSizeInBytes()));
+	m_positions.create(alloc, m_header.m_totalVerticesCount);
+
+	if(optimized)
+	{
+		ANKI_CHECK(file->read(&m_verts[0], m_verts.getSizeInBytes()));
+
+		const Vec3 offset(m_header.m_positionOffset[0], m_header.m_positionOffset[1], m_header.m_positionOffset[2]);
+		for(U32 i = 0; i < m_header.m_totalVerticesCount; ++i)
+		{
+			const Vertex& vert = *reinterpret_cast<const Vertex*>(&m_verts[i * m_vertSize]);
+			const Vec3 pos(unpackSnorm16(vert.m_position[0]),
+				unpackSnorm16(vert.m_position[1]),
+				unpackSnorm16(vert.m_position[2]));
+
+			m_positions[i] = offset + pos * m_header.m_positionScale;
+		}
+	}
+	else
+	{
+		const PtrSize inVertSize = 3 * sizeof(F32) // pos
+			+ 2 * sizeof(U16) // uvs
+			+ 1 * sizeof(U32) // norm
+			+ 1 * sizeof(U32) // tang
+			+ ((hasBoneInfo) ? (4 * sizeof(U8) + 4 * sizeof(U16)) : 0);
+
+		DynamicArrayAuto<U8> in(alloc);
+		in.create(m_header.m_totalVerticesCount * inVertSize);
+		ANKI_CHECK(file->read(&in[0], in.getSizeInBytes()));
+
+		convertVertices(&in[0], inVertSize, hasBoneInfo);
+	}
 
 	return ErrorCode::NONE;
 }
 
+void MeshLoader::computePositionDequantization(const Vec3* positions, U32 count, Vec3& offset, F32& scale)
+{
+	ANKI_ASSERT(positions && count > 0);
+	Vec3 bmin(MAX_F32);
+	Vec3 bmax(MIN_F32);
+	for(U32 i = 0; i < count; ++i)
+	{
+		for(U c = 0; c < 3; ++c)
+		{
+			bmin[c] = min(bmin[c], positions[i][c]);
+			bmax[c] = max(bmax[c], positions[i][c]);
+		}
+	}
+
+	// A uniform scale keeps the dequantization a similarity transform so it can be folded into the world transform
+	offset = (bmin + bmax) * 0.5f;
+	const Vec3 halfSize = (bmax - bmin) * 0.5f;
+	scale = max(max(halfSize.x(), halfSize.y()), halfSize.z());
+	if(!(scale > 0.0f))
+	{
+		scale = 1.0f;
+	}
+}
+
+void MeshLoader::packVertex(
+	const Vec3& position, const Vec3& normal, const Vec4& tangent, const Vec3& offset, F32 scale, Vertex& out)
+{
+	const Vec3 pos = (position - offset) / scale;
+
+	out.m_position[0] = packSnorm16(pos.x());
+	out.m_position[1] = packSnorm16(pos.y());
+	out.m_position[2] = packSnorm16(pos.z());
+	out.m_position[3] = packSnorm16((tangent.w() < 0.0f) ? -1.0f : 1.0f);
+	packOctahedral(normal, out.m_normal);
+	packOctahedral(tangent.xyz(), out.m_tangent);
+}
+
+void MeshLoader::unpackVertexDirections(const Vertex& in, Vec3& normal, Vec4& tangent)
+{
+	normal = unpackOctahedral(in.m_normal);
+	tangent = Vec4(unpackOctahedral(in.m_tangent), (in.m_position[3] < 0) ? -1.0f : 1.0f);
+}
+
+void MeshLoader::convertVertices(const U8* in, PtrSize inVertSize, Bool hasBoneInfo)
+{
+	const U32 vertCount = m_header.m_totalVerticesCount;
+
+	for(U32 i = 0; i < vertCount; ++i)
+	{
+		memcpy(&m_positions[i][0], in + i * inVertSize, sizeof(Vec3));
+	}
+
+	Vec3 offset;
+	F32 scale;
+	computePositionDequantization(&m_positions[0], vertCount, offset, scale);
+
+	for(U32 i = 0; i < vertCount; ++i)
+	{
+		const U8* src = in + i * inVertSize;
+		Vertex& out = *reinterpret_cast<Vertex*>(&m_verts[i * m_vertSize]);
+
+		U32 normal, tangent;
+		memcpy(&out.m_uv, src + sizeof(Vec3), sizeof(HVec2));
+		memcpy(&normal, src + sizeof(Vec3) + sizeof(HVec2), sizeof(U32));
+		memcpy(&tangent, src + sizeof(Vec3) + sizeof(HVec2) + sizeof(U32), sizeof(U32));
+
+		packVertex(m_positions[i],
+			unpackR10G10B10A2Snorm(normal).xyz(),
+			unpackR10G10B10A2Snorm(tangent),
+			offset,
+			scale,
+			out);
+
+		if(hasBoneInfo)
+		{
+			memcpy(&m_verts[i * m_vertSize + sizeof(Vertex)],
+				src + sizeof(Vec3) + sizeof(HVec2) + 2 * sizeof(U32),
+				sizeof(VertexBoneInfo));
+		}
+	}
+
+	// The header describes the data in memory from now on
+	m_header.m_positionsFormat.m_components = ComponentFormat::R16G16B16A16;
+	m_header.m_positionsFormat.m_transform = FormatTransform::SNORM;
+	m_header.m_normalsFormat.m_components = ComponentFormat::R8G8;
+	m_header.m_normalsFormat.m_transform = FormatTransform::SNORM;
+	m_header.m_tangentsFormat = m_header.m_normalsFormat;
+
+	for(U c = 0; c < 3; ++c)
+	{
+		m_header.m_positionOffset[c] = offset[c];
+	}
+
+	m_header.m_positionScale = scale;
+}
+
 Error MeshLoader::checkFormat(const Format& fmt, const CString& attrib, Bool cannotBeEmpty)
 {
 	if(fmt.m_components >= ComponentFormat::COUNT)
@@ -15,7 +15,9 @@ namespace anki
 /// @addtogroup resource
 /// @{
 
-/// Mesh data. This class loads the mesh file and the Mesh class loads it to the CPU.
+/// Mesh data. This class loads the mesh file and the Mesh class loads it to the CPU. It reads the ANKIMES3 files and
+/// the optimized ANKIMES4 files. The vertices of ANKIMES3 are converted to the layout of ANKIMES4 so everything
+/// after the loader sees one layout (see Vertex).
 class MeshLoader
 {
 public:
@@ -90,11 +92,45 @@ public:
 		U32 m_uvsChannelCount;
 		U32 m_subMeshCount;
 
-		U8 m_padding[32];
+		/// @name Dequantization of the positions
+		/// The position is m_positionOffset + quantized position * m_positionScale. Zero in ANKIMES3 files.
+		/// @{
+		Array<F32, 3> m_positionOffset;
+		F32 m_positionScale;
+		/// @}
+
+		/// The max distance in model space between the surface of the mesh and the surface of the original mesh. Zero
+		/// for the original and for ANKIMES3 files.
+		F32 m_lodError;
+
+		U8 m_padding[12];
 	};
 
 	static_assert(sizeof(Header) == 128, "Check size of struct");
 
+	/// The vertex after loading. The vertex size is sizeof(Vertex) or sizeof(Vertex) + sizeof(VertexBoneInfo) if the
+	/// mesh has bone info.
+	class Vertex
+	{
+	public:
+		/// R16G16B16A16_SNORM. XYZ is the quantized position and W the sign of the bitangent.
+		Array<I16, 4> m_position;
+		HVec2 m_uv;
+		Array<I8, 2> m_normal; ///< R8G8_SNORM. Octahedral encoding.
+		Array<I8, 2> m_tangent; ///< R8G8_SNORM. Octahedral encoding.
+	};
+
+	static_assert(sizeof(Vertex) == 16, "Check size of struct");
+
+	class VertexBoneInfo
+	{
+	public:
+		Array<U8, 4> m_weights; ///< R8G8B8A8_UNORM.
+		Array<U16, 4> m_indices; ///< R16G16B16A16_UINT.
+	};
+
+	static_assert(sizeof(VertexBoneInfo) == 12, "Check size of struct");
+
 	class SubMesh
 	{
 	public:
@@ -138,6 +174,13 @@ public:
 		return m_vertSize;
 	}
 
+	/// The positions of the vertices before the quantization. Use them for collision and bounding volumes.
+	const Vec3* getPositions() const
+	{
+		ANKI_ASSERT(isLoaded());
+		return &m_positions[0];
+	}
+
 	const U8* getIndexData() const
 	{
 		ANKI_ASSERT(isLoaded());
@@ -150,12 +193,39 @@ public:
 		return m_indices.getSizeInBytes();
 	}
 
+	WeakArray<const SubMesh> getSubMeshes() const
+	{
+		ANKI_ASSERT(isLoaded());
+		return WeakArray<const SubMesh>(&m_subMeshes[0], m_subMeshes.getSize());
+	}
+
 	Bool hasBoneInfo() const
 	{
 		ANKI_ASSERT(isLoaded());
 		return m_header.m_boneWeightsFormat.m_components != ComponentFormat::NONE;
 	}
 
+	/// Compute the dequantization of a set of positions. The positions are quantized in a cube around their bounding
+	/// box.
+	/// @param positions The positions.
+	/// @param count The number of positions.
+	/// @param[out] offset The dequantization offset (see Header::m_positionOffset).
+	/// @param[out] scale The dequantization scale (see Header::m_positionScale).
+	static void computePositionDequantization(const Vec3* positions, U32 count, Vec3& offset, F32& scale);
+
+	/// Quantize the position, the normal and the tangent of a vertex. The UV is not touched.
+	/// @param position The position.
+	/// @param normal The normal.
+	/// @param tangent The tangent. The W is the sign of the bitangent.
+	/// @param offset The dequantization offset of the positions.
+	/// @param scale The dequantization scale of the positions.
+	/// @param[out] out The vertex.
+	static void packVertex(
+		const Vec3& position, const Vec3& normal, const Vec4& tangent, const Vec3& offset, F32 scale, Vertex& out);
+
+	/// Decode the normal and the tangent of a vertex. The W of the tangent is the sign of the bitangent.
+	static void unpackVertexDirections(const Vertex& in, Vec3& normal, Vec4& tangent);
+
 private:
 	template<typename T>
 	using MDynamicArray = DynamicArray<T>;
@@ -167,6 +237,7 @@ private:
 	MDynamicArray<U8> m_verts;
 	MDynamicArray<U8> m_indices;
 	MDynamicArray<SubMesh> m_subMeshes;
+	MDynamicArray<Vec3> m_positions;
 	U8 m_vertSize = 0;
 
 	Bool isLoaded() const
@@ -175,6 +246,14 @@ private:
 	}
 
 	static ANKI_USE_RESULT Error checkFormat(const Format& fmt, const CString& attrib, Bool cannotBeEmpty);
+
+	static Bool formatEquals(const Format& fmt, ComponentFormat components, FormatTransform transform)
+	{
+		return fmt.m_components == components && fmt.m_transform == transform;
+	}
+
+	/// Convert the vertices of an ANKIMES3 file to the Vertex layout.
+	void convertVertices(const U8* in, PtrSize inVertSize, Bool hasBoneInfo);
 };
 /// @}
 
@@ -0,0 +1,611 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/resource/MeshOptimizer.h>
+#include <anki/util/Functions.h>
+#include <algorithm>
+#include <cmath>
+
+namespace anki
+{
+
+/// @name The constants of Forsyth's scoring.
+/// @{
+static const U32 SCORING_CACHE_SIZE = 32;
+static const F32 CACHE_DECAY_POWER = 1.5;
+static const F32 LAST_TRIANGLE_SCORE = 0.75;
+static const F32 VALENCE_BOOST_SCALE = 2.0;
+static const F32 VALENCE_BOOST_POWER = 0.5;
+/// @}
+
+static const U32 MAX_SIMULATED_CACHE_SIZE = 64;
+
+/// The clusters of optimizeOverdraw() can have this much worse ACMR than the whole mesh.
+static const F32 OVERDRAW_ACMR_THRESHOLD = 1.05;
+static const U32 MAX_GRID_SIZE = 1024;
+
+static F32 computeVertexScore(I32 cachePosition, U32 remainingTriangles)
+{
+	if(remainingTriangles == 0)
+	{
+		// No triangle needs it
+		return -1.0;
+	}
+
+	F32 score = 0.0;
+	if(cachePosition >= 0)
+	{
+		if(cachePosition < 3)
+		{
+			// It's used by the last triangle. Don't favor it too much or the strips will turn back on themselves
+			score = LAST_TRIANGLE_SCORE;
+		}
+		else
+		{
+			const F32 scaler = 1.0 / (SCORING_CACHE_SIZE - 3);
+			score = std::pow(1.0f - F32(cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+		}
+	}
+
+	// Boost the vertices with few triangles left so they don't stay behind
+	score += VALENCE_BOOST_SCALE * std::pow(F32(remainingTriangles), -VALENCE_BOOST_POWER);
+
+	return score;
+}
+
+VertexCacheStatistics computeVertexCacheStatistics(WeakArray<const U16> indices, U32 vertexCount, U32 cacheSize)
+{
+	ANKI_ASSERT((indices.getSize() % 3) == 0);
+	ANKI_ASSERT(cacheSize > 0 && cacheSize <= MAX_SIMULATED_CACHE_SIZE);
+
+	VertexCacheStatistics stats;
+	if(indices.getSize() == 0 || vertexCount == 0)
+	{
+		return stats;
+	}
+
+	Array<U32, MAX_SIMULATED_CACHE_SIZE> fifo;
+	for(U32& v : fifo)
+	{
+		v = MAX_U32;
+	}
+
+	U32 head = 0;
+	U32 misses = 0;
+	for(U16 idx : indices)
+	{
+		Bool hit = false;
+		for(U32 i = 0; i < cacheSize && !hit; ++i)
+		{
+			hit = fifo[i] == idx;
+		}
+
+		if(!hit)
+		{
+			fifo[head] = idx;
+			head = (head + 1) % cacheSize;
+			++misses;
+		}
+	}
+
+	stats.m_acmr = F32(misses) / F32(indices.getSize() / 3);
+	stats.m_atvr = F32(misses) / F32(vertexCount);
+	return stats;
+}
+
+void optimizeVertexCache(WeakArray<U16> indices, U32 vertexCount, GenericMemoryPoolAllocator<U8> alloc)
+{
+	ANKI_ASSERT((indices.getSize() % 3) == 0);
+	const U32 triCount = indices.getSize() / 3;
+	if(triCount < 2)
+	{
+		return;
+	}
+
+	// Gather the triangles of every vertex. The emitted triangles are swapped to the end of the lists
+	DynamicArrayAuto<U32> remaining(alloc);
+	remaining.create(vertexCount, 0);
+	for(U16 idx : indices)
+	{
+		ANKI_ASSERT(idx < vertexCount);
+		++remaining[idx];
+	}
+
+	DynamicArrayAuto<U32> offsets(alloc);
+	offsets.create(vertexCount + 1);
+	offsets[0] = 0;
+	for(U32 v = 0; v < vertexCount; ++v)
+	{
+		offsets[v + 1] = offsets[v] + remaining[v];
+	}
+
+	DynamicArrayAuto<U32> vertTris(alloc);
+	vertTris.create(indices.getSize());
+	{
+		DynamicArrayAuto<U32> cursors(alloc);
+		cursors.create(vertexCount);
+		memcpy(&cursors[0], &offsets[0], vertexCount * sizeof(U32));
+
+		for(U32 i = 0; i < indices.getSize(); ++i)
+		{
+			vertTris[cursors[indices[i]]++] = i / 3;
+		}
+	}
+
+	// Initial scores
+	DynamicArrayAuto<I32> cachePositions(alloc);
+	cachePositions.create(vertexCount, -1);
+	DynamicArrayAuto<F32> vertScores(alloc);
+	vertScores.create(vertexCount);
+	for(U32 v = 0; v < vertexCount; ++v)
+	{
+		vertScores[v] = computeVertexScore(-1, remaining[v]);
+	}
+
+	DynamicArrayAuto<Bool8> triAdded(alloc);
+	triAdded.create(triCount, false);
+
+	U32 bestTri = 0;
+	F32 bestScore = -1.0;
+	for(U32 t = 0; t < triCount; ++t)
+	{
+		const F32 score =
+			vertScores[indices[t * 3]] + vertScores[indices[t * 3 + 1]] + vertScores[indices[t * 3 + 2]];
+		if(score > bestScore)
+		{
+			bestScore = score;
+			bestTri = t;
+		}
+	}
+
+	// Emit the triangles one by one
+	DynamicArrayAuto<U16> out(alloc);
+	out.create(indices.getSize());
+
+	Array<U32, SCORING_CACHE_SIZE + 3> cache;
+	Array<U32, SCORING_CACHE_SIZE + 3> newCache;
+	U32 cacheCount = 0;
+	U32 scanCursor = 0;
+
+	for(U32 emitted = 0; emitted < triCount; ++emitted)
+	{
+		if(bestTri == MAX_U32)
+		{
+			// The cache can't feed any triangle. Continue from the next triangle of the original order
+			while(triAdded[scanCursor])
+			{
+				++scanCursor;
+			}
+
+			bestTri = scanCursor;
+		}
+
+		ANKI_ASSERT(!triAdded[bestTri]);
+		triAdded[bestTri] = true;
+		const U16* tri = &indices[bestTri * 3];
+		memcpy(&out[emitted * 3], tri, 3 * sizeof(U16));
+
+		// Remove it from the lists of its vertices
+		for(U32 k = 0; k < 3; ++k)
+		{
+			const U32 v = tri[k];
+			const U32 begin = offsets[v];
+			const U32 end = begin + remaining[v];
+			for(U32 i = begin; i < end; ++i)
+			{
+				if(vertTris[i] == bestTri)
+				{
+					std::swap(vertTris[i], vertTris[end - 1]);
+					break;
+				}
+			}
+
+			--remaining[v];
+		}
+
+		// The vertices of the triangle move to the front of the cache
+		U32 newCount = 0;
+		for(U32 k = 0; k < 3; ++k)
+		{
+			if(std::find(&newCache[0], &newCache[0] + newCount, tri[k]) == &newCache[0] + newCount)
+			{
+				newCache[newCount++] = tri[k];
+			}
+		}
+
+		for(U32 i = 0; i < cacheCount; ++i)
+		{
+			const U32 v = cache[i];
+			if(v != tri[0] && v != tri[1] && v != tri[2])
+			{
+				newCache[newCount++] = v;
+			}
+		}
+
+		// It's never more than the size of the array. The clamp is for -Warray-bounds that can't prove it
+		newCount = min<U32>(newCount, newCache.getSize());
+		for(U32 i = 0; i < newCount; ++i)
+		{
+			const U32 v = newCache[i];
+			cachePositions[v] = (i < SCORING_CACHE_SIZE) ? I32(i) : -1;
+			vertScores[v] = computeVertexScore(cachePositions[v], remaining[v]);
+		}
+
+		cacheCount = min(newCount, SCORING_CACHE_SIZE);
+		memcpy(&cache[0], &newCache[0], cacheCount * sizeof(U32));
+
+		// Re-score the triangles of the touched vertices and pick the next one among them
+		bestTri = MAX_U32;
+		bestScore = -1.0;
+		for(U32 i = 0; i < newCount; ++i)
+		{
+			const U32 v = newCache[i];
+			const U32 begin = offsets[v];
+			const U32 end = begin + remaining[v];
+			for(U32 j = begin; j < end; ++j)
+			{
+				const U32 t = vertTris[j];
+				const F32 score =
+					vertScores[indices[t * 3]] + vertScores[indices[t * 3 + 1]] + vertScores[indices[t * 3 + 2]];
+				if(score > bestScore)
+				{
+					bestScore = score;
+					bestTri = t;
+				}
+			}
+		}
+	}
+
+	memcpy(&indices[0], &out[0], indices.getSizeInBytes());
+}
+
+/// A range of triangles that is reordered as a whole by optimizeOverdraw().
+class OverdrawCluster
+{
+public:
+	U32 m_begin;
+	U32 m_end;
+	F32 m_sortKey;
+};
+
+void optimizeOverdraw(
+	WeakArray<U16> indices, const Vec3* positions, U32 vertexCount, GenericMemoryPoolAllocator<U8> alloc)
+{
+	ANKI_ASSERT((indices.getSize() % 3) == 0);
+	const U32 triCount = indices.getSize() / 3;
+	if(triCount < 2)
+	{
+		return;
+	}
+
+	const F32 meshAcmr =
+		computeVertexCacheStatistics(WeakArray<const U16>(&indices[0], indices.getSize()), vertexCount).m_acmr;
+
+	// Break to clusters. Every cluster starts with a cold cache since it can end up anywhere after the sorting. A
+	// cluster ends as soon as its ACMR gets close enough to the ACMR of the whole mesh. A vertex is in the FIFO if it
+	// missed less than a cache size ago
+	DynamicArrayAuto<OverdrawCluster> clusters(alloc);
+	clusters.create(triCount);
+	U32 clusterCount = 0;
+	{
+		DynamicArrayAuto<U32> missTimes(alloc);
+		missTimes.create(vertexCount, 0);
+		U32 time = MESH_OPTIMIZER_CACHE_SIZE + 1;
+		U32 clusterMisses = 0;
+
+		clusters[0].m_begin = 0;
+		clusterCount = 1;
+
+		for(U32 t = 0; t < triCount; ++t)
+		{
+			for(U32 k = 0; k < 3; ++k)
+			{
+				const U32 v = indices[t * 3 + k];
+				if(time - missTimes[v] > MESH_OPTIMIZER_CACHE_SIZE)
+				{
+					missTimes[v] = time++;
+					++clusterMisses;
+				}
+			}
+
+			OverdrawCluster& cluster = clusters[clusterCount - 1];
+			const U32 clusterTris = t + 1 - cluster.m_begin;
+			if(t + 1 < triCount && F32(clusterMisses) <= F32(clusterTris) * meshAcmr * OVERDRAW_ACMR_THRESHOLD)
+			{
+				cluster.m_end = t + 1;
+				clusters[clusterCount].m_begin = t + 1;
+				++clusterCount;
+
+				// Flush the cache
+				time += MESH_OPTIMIZER_CACHE_SIZE + 1;
+				clusterMisses = 0;
+			}
+		}
+
+		clusters[clusterCount - 1].m_end = triCount;
+	}
+
+	if(clusterCount < 2)
+	{
+		return;
+	}
+
+	// The area weighted centroid of the mesh
+	Vec3 meshCentroid(0.0);
+	F32 meshArea = 0.0;
+	for(U32 t = 0; t < triCount; ++t)
+	{
+		const Vec3& a = positions[indices[t * 3]];
+		const Vec3& b = positions[indices[t * 3 + 1]];
+		const Vec3& c = positions[indices[t * 3 + 2]];
+		const F32 area = (b - a).cross(c - a).getLength();
+		meshCentroid += (a + b + c) * area;
+		meshArea += area;
+	}
+
+	if(meshArea > 0.0)
+	{
+		meshCentroid /= meshArea * 3.0;
+	}
+
+	// The clusters that are far from the center and face outwards go first since they are likely to occlude the rest
+	for(U32 i = 0; i < clusterCount; ++i)
+	{
+		OverdrawCluster& cluster = clusters[i];
+
+		Vec3 centroid(0.0);
+		Vec3 normal(0.0);
+		F32 area = 0.0;
+		for(U32 t = cluster.m_begin; t < cluster.m_end; ++t)
+		{
+			const Vec3& a = positions[indices[t * 3]];
+			const Vec3& b = positions[indices[t * 3 + 1]];
+			const Vec3& c = positions[indices[t * 3 + 2]];
+			const Vec3 cross = (b - a).cross(c - a);
+			const F32 triArea = cross.getLength();
+
+			centroid += (a + b + c) * triArea;
+			normal += cross;
+			area += triArea;
+		}
+
+		cluster.m_sortKey = 0.0;
+		if(area > 0.0)
+		{
+			centroid /= area * 3.0;
+			cluster.m_sortKey = (centroid - meshCentroid).dot(normal / area);
+		}
+	}
+
+	std::sort(&clusters[0], &clusters[0] + clusterCount, [](const OverdrawCluster& a, const OverdrawCluster& b) {
+		return (a.m_sortKey != b.m_sortKey) ? a.m_sortKey > b.m_sortKey : a.m_begin < b.m_begin;
+	});
+
+	DynamicArrayAuto<U16> out(alloc);
+	out.create(indices.getSize());
+	U32 count = 0;
+	for(U32 i = 0; i < clusterCount; ++i)
+	{
+		const OverdrawCluster& cluster = clusters[i];
+		const U32 indexCount = (cluster.m_end - cluster.m_begin) * 3;
+		memcpy(&out[count], &indices[cluster.m_begin * 3], indexCount * sizeof(U16));
+		count += indexCount;
+	}
+
+	ANKI_ASSERT(count == indices.getSize());
+	memcpy(&indices[0], &out[0], indices.getSizeInBytes());
+}
+
+U32 optimizeVertexFetch(WeakArray<U16> indices,
+	void* vertices,
+	U32 vertexCount,
+	PtrSize vertexSize,
+	GenericMemoryPoolAllocator<U8> alloc)
+{
+	if(indices.getSize() == 0)
+	{
+		return 0;
+	}
+
+	DynamicArrayAuto<U32> remap(alloc);
+	remap.create(vertexCount, MAX_U32);
+	U32 newCount = 0;
+	for(U16& idx : indices)
+	{
+		ANKI_ASSERT(idx < vertexCount);
+		if(remap[idx] == MAX_U32)
+		{
+			remap[idx] = newCount++;
+		}
+
+		idx = U16(remap[idx]);
+	}
+
+	DynamicArrayAuto<U8> out(alloc);
+	out.create(newCount * vertexSize);
+	const U8* in = static_cast<const U8*>(vertices);
+	for(U32 v = 0; v < vertexCount; ++v)
+	{
+		if(remap[v] != MAX_U32)
+		{
+			memcpy(&out[remap[v] * vertexSize], in + v * vertexSize, vertexSize);
+		}
+	}
+
+	memcpy(vertices, &out[0], out.getSizeInBytes());
+	return newCount;
+}
+
+/// A vertex and the grid cell it falls into.
+class ClusteredVertex
+{
+public:
+	U32 m_cell;
+	U32 m_vertex;
+};
+
+/// Cluster the vertices on a grid and write the triangles that don't collapse.
+/// @return The number of indices written.
+static U32 clusterMesh(WeakArray<const U16> indices,
+	const Vec3* positions,
+	U32 vertexCount,
+	const Vec3& origin,
+	F32 extent,
+	U32 gridSize,
+	DynamicArrayAuto<ClusteredVertex>& sorted,
+	DynamicArrayAuto<U32>& representatives,
+	U16* out)
+{
+	const F32 cellScale = F32(gridSize) / extent;
+	for(U32 v = 0; v < vertexCount; ++v)
+	{
+		const Vec3 cell = (positions[v] - origin) * cellScale;
+		const U32 x = min<U32>(U32(max(cell.x(), 0.0f)), gridSize - 1);
+		const U32 y = min<U32>(U32(max(cell.y(), 0.0f)), gridSize - 1);
+		const U32 z = min<U32>(U32(max(cell.z(), 0.0f)), gridSize - 1);
+
+		sorted[v].m_cell = x + (y + z * gridSize) * gridSize;
+		sorted[v].m_vertex = v;
+	}
+
+	std::sort(&sorted[0], &sorted[0] + vertexCount, [](const ClusteredVertex& a, const ClusteredVertex& b) {
+		return (a.m_cell != b.m_cell) ? a.m_cell < b.m_cell : a.m_vertex < b.m_vertex;
+	});
+
+	// The vertex that is closest to the average of its cell represents the cell
+	U32 begin = 0;
+	while(begin < vertexCount)
+	{
+		U32 end = begin + 1;
+		Vec3 average = positions[sorted[begin].m_vertex];
+		while(end < vertexCount && sorted[end].m_cell == sorted[begin].m_cell)
+		{
+			average += positions[sorted[end].m_vertex];
+			++end;
+		}
+
+		average /= F32(end - begin);
+
+		U32 best = sorted[begin].m_vertex;
+		F32 bestDist = MAX_F32;
+		for(U32 i = begin; i < end; ++i)
+		{
+			const F32 dist = (positions[sorted[i].m_vertex] - average).getLengthSquared();
+			if(dist < bestDist)
+			{
+				bestDist = dist;
+				best = sorted[i].m_vertex;
+			}
+		}
+
+		for(U32 i = begin; i < end; ++i)
+		{
+			representatives[sorted[i].m_vertex] = best;
+		}
+
+		begin = end;
+	}
+
+	U32 count = 0;
+	for(U32 i = 0; i < indices.getSize(); i += 3)
+	{
+		const U32 a = representatives[indices[i]];
+		const U32 b = representatives[indices[i + 1]];
+		const U32 c = representatives[indices[i + 2]];
+
+		if(a != b && b != c && a != c)
+		{
+			if(out)
+			{
+				out[count] = U16(a);
+				out[count + 1] = U16(b);
+				out[count + 2] = U16(c);
+			}
+
+			count += 3;
+		}
+	}
+
+	return count;
+}
+
+U32 simplifyMesh(WeakArray<U16> indices,
+	const Vec3* positions,
+	U32 vertexCount,
+	U32 targetIndexCount,
+	F32& error,
+	GenericMemoryPoolAllocator<U8> alloc)
+{
+	ANKI_ASSERT((indices.getSize() % 3) == 0);
+	error = 0.0;
+	if(indices.getSize() <= targetIndexCount || vertexCount == 0)
+	{
+		return indices.getSize();
+	}
+
+	// The grid is a cube that covers the bounding box
+	Vec3 bmin(MAX_F32);
+	Vec3 bmax(MIN_F32);
+	for(U32 v = 0; v < vertexCount; ++v)
+	{
+		for(U32 c = 0; c < 3; ++c)
+		{
+			bmin[c] = min(bmin[c], positions[v][c]);
+			bmax[c] = max(bmax[c], positions[v][c]);
+		}
+	}
+
+	const Vec3 size = bmax - bmin;
+	const F32 extent = max(max(max(size.x(), size.y()), size.z()), EPSILON);
+
+	DynamicArrayAuto<ClusteredVertex> sorted(alloc);
+	sorted.create(vertexCount);
+	DynamicArrayAuto<U32> representatives(alloc);
+	representatives.create(vertexCount);
+
+	WeakArray<const U16> in(&indices[0], indices.getSize());
+
+	// Find the finest grid that fits in the target. The index count grows with the grid size
+	U32 low = 1;
+	U32 high = MAX_GRID_SIZE;
+	U32 best = 1;
+	while(low <= high)
+	{
+		const U32 gridSize = (low + high) / 2;
+		const U32 count =
+			clusterMesh(in, positions, vertexCount, bmin, extent, gridSize, sorted, representatives, nullptr);
+
+		if(count <= targetIndexCount)
+		{
+			best = gridSize;
+			low = gridSize + 1;
+		}
+		else
+		{
+			high = gridSize - 1;
+		}
+	}
+
+	DynamicArrayAuto<U16> out(alloc);
+	out.create(indices.getSize());
+	const U32 count = clusterMesh(in, positions, vertexCount, bmin, extent, best, sorted, representatives, &out[0]);
+
+	// The vertices of the original triangles snap to their representatives
+	F32 maxDistSq = 0.0;
+	for(U16 idx : in)
+	{
+		maxDistSq = max(maxDistSq, (positions[idx] - positions[representatives[idx]]).getLengthSquared());
+	}
+	error = sqrt(maxDistSq);
+
+	if(count > 0)
+	{
+		memcpy(&indices[0], &out[0], count * sizeof(U16));
+	}
+
+	return count;
+}
+
+} // end namespace anki
@@ -0,0 +1,64 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/resource/Common.h>
+#include <anki/Math.h>
+
+namespace anki
+{
+
+/// @addtogroup resource
+/// @{
+
+/// The size of the FIFO post-transform vertex cache that the statistics simulate.
+const U32 MESH_OPTIMIZER_CACHE_SIZE = 16;
+
+/// Statistics of the post-transform vertex cache.
+class VertexCacheStatistics
+{
+public:
+	F32 m_acmr = 0.0; ///< Average cache miss ratio. Transformed vertices per triangle.
+	F32 m_atvr = 0.0; ///< Average transformed vertex ratio. Transformed vertices per unique vertex.
+};
+
+/// Simulate a FIFO post-transform vertex cache on a triangle list.
+VertexCacheStatistics computeVertexCacheStatistics(
+	WeakArray<const U16> indices, U32 vertexCount, U32 cacheSize = MESH_OPTIMIZER_CACHE_SIZE);
+
+/// Reorder the triangles to improve the hit rate of the post-transform vertex cache. It's the linear speed algorithm of
+/// Tom Forsyth.
+void optimizeVertexCache(WeakArray<U16> indices, U32 vertexCount, GenericMemoryPoolAllocator<U8> alloc);
+
+/// Reorder clusters of triangles to reduce the overdraw. The clusters are kept long enough to not hurt the vertex cache
+/// much and the ones that face outwards are drawn first. Call it after optimizeVertexCache().
+void optimizeOverdraw(
+	WeakArray<U16> indices, const Vec3* positions, U32 vertexCount, GenericMemoryPoolAllocator<U8> alloc);
+
+/// Reorder the vertices in the order the indices use them for the first time and remap the indices. The unused
+/// vertices are removed.
+/// @return The new vertex count.
+U32 optimizeVertexFetch(WeakArray<U16> indices,
+	void* vertices,
+	U32 vertexCount,
+	PtrSize vertexSize,
+	GenericMemoryPoolAllocator<U8> alloc);
+
+/// Simplify a triangle list by clustering its vertices on a grid. The finest grid that gives at most
+/// targetIndexCount indices is used. The simplified triangles are written at the start of the indices and they
+/// reference the original vertices.
+/// @param[out] error The max distance that a vertex of the original triangles moved. It's in the units of the
+///             positions and it's zero if the mesh didn't change.
+/// @return The new index count.
+U32 simplifyMesh(WeakArray<U16> indices,
+	const Vec3* positions,
+	U32 vertexCount,
+	U32 targetIndexCount,
+	F32& error,
+	GenericMemoryPoolAllocator<U8> alloc);
+/// @}
+
+} // end namespace anki
@@ -5,6 +5,7 @@
 
 #include <anki/resource/Model.h>
 #include <anki/resource/ResourceManager.h>
+#include <anki/resource/CompiledResourceCache.h>
 #include <anki/resource/Material.h>
 #include <anki/resource/Mesh.h>
 #include <anki/resource/MeshLoader.h>
@@ -69,31 +70,37 @@ void ModelPatch::getRenderingDataSub(
 		inf.m_state.m_shaders[ShaderType::FRAGMENT] = variant.getShader(ShaderType::FRAGMENT);
 	}
 
-	// Vertex
+	// Vertex. See MeshLoader::Vertex
 	VertexStateInfo& vert = inf.m_state.m_vertex;
 	vert.m_bindingCount = 1;
 	vert.m_attributeCount = 4;
-	vert.m_bindings[0].m_stride = sizeof(Vec3) + sizeof(HVec2) + 2 * sizeof(U32);
+	vert.m_bindings[0].m_stride = sizeof(MeshLoader::Vertex);
+	if(mesh.hasBoneWeights())
+	{
+		vert.m_bindings[0].m_stride += sizeof(MeshLoader::VertexBoneInfo);
+	}
 
-	vert.m_attributes[0].m_format = PixelFormat(ComponentFormat::R32G32B32, TransformFormat::FLOAT);
-	vert.m_attributes[0].m_offset = 0;
+	vert.m_attributes[0].m_format = PixelFormat(ComponentFormat::R16G16B16A16, TransformFormat::SNORM);
+	vert.m_attributes[0].m_offset = offsetof(MeshLoader::Vertex, m_position);
 
 	vert.m_attributes[1].m_format = PixelFormat(ComponentFormat::R16G16, TransformFormat::FLOAT);
-	vert.m_attributes[1].m_offset = sizeof(Vec3);
+	vert.m_attributes[1].m_offset = offsetof(MeshLoader::Vertex, m_uv);
 
 	if(key.m_pass == Pass::MS_FS)
 	{
-		vert.m_attributes[2].m_format = PixelFormat(ComponentFormat::R10G10B10A2, TransformFormat::SNORM);
-		vert.m_attributes[2].m_offset = sizeof(Vec3) + sizeof(U32);
+		vert.m_attributes[2].m_format = PixelFormat(ComponentFormat::R8G8, TransformFormat::SNORM);
+		vert.m_attributes[2].m_offset = offsetof(MeshLoader::Vertex, m_normal);
 
-		vert.m_attributes[3].m_format = PixelFormat(ComponentFormat::R10G10B10A2, TransformFormat::SNORM);
-		vert.m_attributes[3].m_offset = sizeof(Vec3) + sizeof(U32) * 2;
+		vert.m_attributes[3].m_format = PixelFormat(ComponentFormat::R8G8, TransformFormat::SNORM);
+		vert.m_attributes[3].m_offset = offsetof(MeshLoader::Vertex, m_tangent);
 	}
 	else
 	{
 		vert.m_attributeCount = 2;
 	}
 
+	inf.m_dequantizationTransform = mesh.getDequantizationTransform();
+
 	// Input assembly
 	inf.m_state.m_inputAssembler.m_topology = PrimitiveTopology::TRIANGLES;
 	inf.m_state.m_inputAssembler.m_primitiveRestartEnabled = false;
@@ -101,10 +108,11 @@ void ModelPatch::getRenderingDataSub(
 	inf.m_stateMask = PipelineSubStateBit::VERTEX | PipelineSubStateBit::SHADERS | PipelineSubStateBit::INPUT_ASSEMBLER;
 
 	// Other
+	inf.m_baseVertex = mesh.getBaseVertex();
 	if(subMeshIndicesArray.getSize() == 0 || mesh.getSubMeshesCount() == 0)
 	{
 		inf.m_drawcallCount = 1;
-		inf.m_indicesOffsetArray[0] = 0;
+		inf.m_indicesOffsetArray[0] = mesh.getFirstIndex() * sizeof(U16);
 		inf.m_indicesCountArray[0] = mesh.getIndicesCount();
 	}
 	else
@@ -113,6 +121,26 @@ void ModelPatch::getRenderingDataSub(
 	}
 }
 
+U ModelPatch::getLodErrors(F32 scale, Array<F32, MAX_LODS>& errors) const
+{
+	if(m_meshCount < 2)
+	{
+		return 0;
+	}
+
+	errors[0] = 0.0;
+	for(U lod = 1; lod < m_meshCount; ++lod)
+	{
+		errors[lod] = m_meshes[lod]->getLodError() * scale;
+		if(!(errors[lod] > 0.0))
+		{
+			return 0;
+		}
+	}
+
+	return m_meshCount;
+}
+
 U ModelPatch::getLodCount() const
 {
 	return max<U>(m_meshCount, getMaterial().getLodCount());
@@ -125,11 +153,7 @@ Error ModelPatch::create(WeakArray<CString> meshFNames, const CString& mtlFName,
 	// Load material
 	ANKI_CHECK(manager->loadResource(mtlFName, m_mtl));
 
-	// Iterate material variables for textures
-	ResourceGroupInitInfo rcinit;
-	m_mtl->fillResourceGroupInitInfo(rcinit);
-
-	// Load meshes and update resource group
+	// Load meshes
 	m_meshCount = 0;
 	for(U i = 0; i < meshFNames.getSize(); i++)
 	{
@@ -142,16 +166,37 @@ Error ModelPatch::create(WeakArray<CString> meshFNames, const CString& mtlFName,
 			return ErrorCode::USER_DATA;
 		}
 
+		++m_meshCount;
+	}
+
+	createResourceGroups();
+
+	return ErrorCode::NONE;
+}
+
+void ModelPatch::createResourceGroups()
+{
+	// Iterate material variables for textures
+	ResourceGroupInitInfo rcinit;
+	m_mtl->fillResourceGroupInitInfo(rcinit);
+	m_texturesVersion = m_mtl->getTexturesVersion();
+
+	for(U i = 0; i < m_meshCount; i++)
+	{
 		rcinit.m_vertexBuffers[0].m_buffer = m_meshes[i]->getVertexBuffer();
 		rcinit.m_indexBuffer.m_buffer = m_meshes[i]->getIndexBuffer();
 		rcinit.m_indexSize = 2;
 
-		m_grResources[i] = manager->getGrManager().newInstance<ResourceGroup>(rcinit);
-
-		++m_meshCount;
+		m_grResources[i] = m_model->getManager().getGrManager().newInstance<ResourceGroup>(rcinit);
 	}
+}
 
-	return ErrorCode::NONE;
+void ModelPatch::refreshResourceGroups()
+{
+	if(m_mtl->getTexturesVersion() != m_texturesVersion)
+	{
+		createResourceGroups();
+	}
 }
 
 Model::Model(ResourceManager* manager)
@@ -169,18 +214,19 @@ Model::~Model()
 	}
 
 	m_modelPatches.destroy(alloc);
+	m_animations.destroy(alloc);
 }
 
-Error Model::load(const ResourceFilename& filename)
+void Model::refreshResourceGroups()
 {
-	auto alloc = getAllocator();
-
-	// Load
-	//
-	XmlElement el;
-	XmlDocument doc;
-	ANKI_CHECK(openFileParseXml(filename, doc));
+	for(ModelPatch* patch : m_modelPatches)
+	{
+		patch->refreshResourceGroups();
+	}
+}
 
+Error Model::compileXml(const XmlDocument& doc, BinaryWriter& out, void* userData)
+{
 	XmlElement rootEl;
 	ANKI_CHECK(doc.getChildElement("model", rootEl));
 
@@ -191,33 +237,14 @@ Error Model::load(const ResourceFilename& filename)
 	XmlElement modelPatchEl;
 	ANKI_CHECK(modelPatchesEl.getChildElement("modelPatch", modelPatchEl));
 
-	// Count
-	U count = 0;
-	do
-	{
-		++count;
-		// Move to next
-		ANKI_CHECK(modelPatchEl.getNextSiblingElement("modelPatch", modelPatchEl));
-	} while(modelPatchEl);
+	U32 count = 0;
+	ANKI_CHECK(modelPatchEl.getSiblingElementsCount(count));
+	out.write<U32>(count + 1);
 
-	// Check number of model patches
-	if(count < 1)
-	{
-		ANKI_LOGE("Zero number of model patches");
-		return ErrorCode::USER_DATA;
-	}
-
-	m_modelPatches.create(alloc, count);
-
-	count = 0;
-	ANKI_CHECK(modelPatchesEl.getChildElement("modelPatch", modelPatchEl));
 	do
 	{
-		XmlElement materialEl;
-		ANKI_CHECK(modelPatchEl.getChildElement("material", materialEl));
-
 		Array<CString, 3> meshesFnames;
-		U meshesCount = 1;
+		U32 meshesCount = 1;
 
 		// Get mesh
 		XmlElement meshEl;
@@ -233,32 +260,136 @@ Error Model::load(const ResourceFilename& filename)
 
 		if(meshEl1)
 		{
-			++meshesCount;
-			ANKI_CHECK(meshEl1.getText(meshesFnames[1]));
+			ANKI_CHECK(meshEl1.getText(meshesFnames[meshesCount++]));
 		}
 
 		if(meshEl2)
 		{
-			++meshesCount;
-			ANKI_CHECK(meshEl2.getText(meshesFnames[2]));
+			ANKI_CHECK(meshEl2.getText(meshesFnames[meshesCount++]));
+		}
+
+		// Get material
+		XmlElement materialEl;
+		ANKI_CHECK(modelPatchEl.getChildElement("material", materialEl));
+		CString mtlFname;
+		ANKI_CHECK(materialEl.getText(mtlFname));
+
+		out.write(meshesCount);
+		for(U i = 0; i < meshesCount; ++i)
+		{
+			out.writeString(meshesFnames[i]);
 		}
+		out.writeString(mtlFname);
+
+		// Move to next
+		ANKI_CHECK(modelPatchEl.getNextSiblingElement("modelPatch", modelPatchEl));
+	} while(modelPatchEl);
+
+	// <skeleton>
+	XmlElement el;
+	ANKI_CHECK(rootEl.getChildElementOptional("skeleton", el));
+	CString skelFname;
+	if(el)
+	{
+		ANKI_CHECK(el.getText(skelFname));
+	}
+	out.writeString(skelFname);
 
-		CString cstr;
-		ANKI_CHECK(materialEl.getText(cstr));
-		ModelPatch* mpatch = alloc.newInstance<ModelPatch>(this);
+	// <skeletonAnimations>
+	XmlElement animsEl;
+	ANKI_CHECK(rootEl.getChildElementOptional("skeletonAnimations", animsEl));
+	if(animsEl)
+	{
+		if(skelFname.isEmpty())
+		{
+			ANKI_LOGE("Skeleton animations without a skeleton");
+			return ErrorCode::USER_DATA;
+		}
+
+		ANKI_CHECK(animsEl.getChildElement("animation", el));
+		ANKI_CHECK(el.getSiblingElementsCount(count));
+		out.write<U32>(count + 1);
+
+		do
+		{
+			CString animFname;
+			ANKI_CHECK(el.getText(animFname));
+			out.writeString(animFname);
+
+			ANKI_CHECK(el.getNextSiblingElement("animation", el));
+		} while(el);
+	}
+	else
+	{
+		out.write<U32>(0);
+	}
+
+	return ErrorCode::NONE;
+}
 
+Error Model::load(const ResourceFilename& filename)
+{
+	auto alloc = getAllocator();
+
+	DynamicArrayAuto<U8> compiled(getTempAllocator());
+	ANKI_CHECK(openFileCompiled(filename, COMPILED_VERSION, compileXml, nullptr, compiled));
+	BinaryReader in(&compiled[0], compiled.getSize());
+
+	// Model patches
+	U32 count;
+	ANKI_CHECK(in.read(count));
+	if(count < 1)
+	{
+		ANKI_LOGE("Zero number of model patches");
+		return ErrorCode::USER_DATA;
+	}
+
+	m_modelPatches.create(alloc, count, nullptr);
+
+	for(ModelPatch*& mpatch : m_modelPatches)
+	{
+		Array<CString, 3> meshesFnames;
+		U32 meshesCount;
+		ANKI_CHECK(in.read(meshesCount));
+		if(meshesCount < 1 || meshesCount > meshesFnames.getSize())
+		{
+			ANKI_LOGE("Wrong number of meshes");
+			return ErrorCode::USER_DATA;
+		}
+
+		for(U i = 0; i < meshesCount; ++i)
+		{
+			ANKI_CHECK(in.readString(meshesFnames[i]));
+		}
+
+		CString mtlFname;
+		ANKI_CHECK(in.readString(mtlFname));
+
+		mpatch = alloc.newInstance<ModelPatch>(this);
 		if(mpatch == nullptr)
 		{
 			return ErrorCode::OUT_OF_MEMORY;
 		}
 
-		ANKI_CHECK(mpatch->create(WeakArray<CString>(&meshesFnames[0], meshesCount), cstr, &getManager()));
+		ANKI_CHECK(mpatch->create(WeakArray<CString>(&meshesFnames[0], meshesCount), mtlFname, &getManager()));
+	}
 
-		m_modelPatches[count++] = mpatch;
+	// Skeleton and animations
+	CString skelFname;
+	ANKI_CHECK(in.readString(skelFname));
+	if(!skelFname.isEmpty())
+	{
+		ANKI_CHECK(getManager().loadResource(skelFname, m_skeleton));
+	}
 
-		// Move to next
-		ANKI_CHECK(modelPatchEl.getNextSiblingElement("modelPatch", modelPatchEl));
-	} while(modelPatchEl);
+	ANKI_CHECK(in.read(count));
+	m_animations.create(alloc, count);
+	for(AnimationResourcePtr& anim : m_animations)
+	{
+		CString animFname;
+		ANKI_CHECK(in.readString(animFname));
+		ANKI_CHECK(getManager().loadResource(animFname, anim));
+	}
 
 	// Calculate compound bounding volume
 	RenderingKey key;
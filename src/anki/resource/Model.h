@@ -27,8 +27,12 @@ class ModelRenderingInfo
 {
 public:
 	Array<U32, MAX_SUB_DRAWCALLS> m_indicesCountArray;
-	Array<PtrSize, MAX_SUB_DRAWCALLS> m_indicesOffsetArray;
+	Array<PtrSize, MAX_SUB_DRAWCALLS> m_indicesOffsetArray; ///< Offsets in the shared index buffer.
 	U32 m_drawcallCount;
+	U32 m_baseVertex; ///< The meshes share the vertex buffer.
+
+	/// Moves the quantized positions of the mesh to model space. Multiply it with the world transform.
+	Mat4 m_dequantizationTransform;
 
 	ResourceGroupPtr m_resourceGroup;
 	PipelineInitInfo& m_state;
@@ -79,12 +83,29 @@ public:
 		return m_meshes[0]->getSubMeshesCount();
 	}
 
+	/// The number of the LOD meshes.
+	U32 getMeshCount() const
+	{
+		return m_meshCount;
+	}
+
+	/// Get the geometric errors of the LOD meshes. See Mesh::getLodError().
+	/// @param scale The scale that takes the model space to world space.
+	/// @param[out] errors The errors in world space.
+	/// @return The number of LODs. Zero if there are no simplified LODs or if one has no error because the mesh tool
+	///         didn't build it.
+	U getLodErrors(F32 scale, Array<F32, MAX_LODS>& errors) const;
+
 	ANKI_USE_RESULT Error create(WeakArray<CString> meshFNames, const CString& mtlFName, ResourceManager* resources);
 
 	/// Get information for multiDraw rendering. Given an array of submeshes that are visible return the correct indices
 	/// offsets and counts.
 	void getRenderingDataSub(const RenderingKey& key, WeakArray<U8> subMeshIndicesArray, ModelRenderingInfo& inf) const;
 
+anki_internal:
+	/// Re-create the resource groups if the streamed textures of the material changed. Call it between frames.
+	void refreshResourceGroups();
+
 private:
 	Model* m_model ANKI_DBG_NULLIFY_PTR;
 
@@ -93,9 +114,12 @@ private:
 	MaterialResourcePtr m_mtl;
 
 	Array<ResourceGroupPtr, MAX_LODS> m_grResources;
+	U32 m_texturesVersion = 0; ///< The Material::getTexturesVersion() of the resource groups.
 
 	/// Return the maximum number of LODs
 	U getLodCount() const;
+
+	void createResourceGroups();
 };
 
 /// Model is an entity that acts as a container for other resources. Models are all the non static objects in a map.
@@ -142,13 +166,33 @@ public:
 		return m_visibilityShape;
 	}
 
+	/// Get the skeleton. It's empty if the model is not skinned.
+	const SkeletonResourcePtr& getSkeleton() const
+	{
+		return m_skeleton;
+	}
+
+	const DynamicArray<AnimationResourcePtr>& getAnimations() const
+	{
+		return m_animations;
+	}
+
 	ANKI_USE_RESULT Error load(const ResourceFilename& filename);
 
+anki_internal:
+	/// Refresh the resource groups of the patches. Call it between frames.
+	void refreshResourceGroups();
+
 private:
+	/// Bump it when the compiled form changes.
+	static const U32 COMPILED_VERSION = 2;
+
 	DynamicArray<ModelPatch*> m_modelPatches;
 	Obb m_visibilityShape;
 	SkeletonResourcePtr m_skeleton;
 	DynamicArray<AnimationResourcePtr> m_animations;
+
+	static ANKI_USE_RESULT Error compileXml(const XmlDocument& xml, BinaryWriter& out, void* userData);
 };
 /// @}
 
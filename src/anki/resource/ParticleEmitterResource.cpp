@@ -6,6 +6,7 @@
 #include <anki/resource/ParticleEmitterResource.h>
 #include <anki/resource/ResourceManager.h>
 #include <anki/resource/Model.h>
+#include <anki/resource/CompiledResourceCache.h>
 #include <anki/util/StringList.h>
 #include <anki/misc/Xml.h>
 #include <anki/renderer/Ms.h>
@@ -96,58 +97,56 @@ ParticleEmitterResource::~ParticleEmitterResource()
 {
 }
 
-Error ParticleEmitterResource::load(const ResourceFilename& filename)
+Error ParticleEmitterResource::compileXml(const XmlDocument& doc, BinaryWriter& out, void* userData)
 {
+	ParticleEmitterProperties props;
 	U32 tmp;
 
-	XmlDocument doc;
-	ANKI_CHECK(openFileParseXml(filename, doc));
 	XmlElement rel; // Root element
 	ANKI_CHECK(doc.getChildElement("particleEmitter", rel));
 
 	// XML load
 	//
-	ANKI_CHECK(xmlF32(rel, "life", m_particle.m_life));
-	ANKI_CHECK(xmlF32(rel, "lifeDeviation", m_particle.m_lifeDeviation));
+	ANKI_CHECK(xmlF32(rel, "life", props.m_particle.m_life));
+	ANKI_CHECK(xmlF32(rel, "lifeDeviation", props.m_particle.m_lifeDeviation));
 
-	ANKI_CHECK(xmlF32(rel, "mass", m_particle.m_mass));
-	ANKI_CHECK(xmlF32(rel, "massDeviation", m_particle.m_massDeviation));
+	ANKI_CHECK(xmlF32(rel, "mass", props.m_particle.m_mass));
+	ANKI_CHECK(xmlF32(rel, "massDeviation", props.m_particle.m_massDeviation));
 
-	ANKI_CHECK(xmlF32(rel, "size", m_particle.m_size));
-	ANKI_CHECK(xmlF32(rel, "sizeDeviation", m_particle.m_sizeDeviation));
-	ANKI_CHECK(xmlF32(rel, "sizeAnimation", m_particle.m_sizeAnimation));
+	ANKI_CHECK(xmlF32(rel, "size", props.m_particle.m_size));
+	ANKI_CHECK(xmlF32(rel, "sizeDeviation", props.m_particle.m_sizeDeviation));
+	ANKI_CHECK(xmlF32(rel, "sizeAnimation", props.m_particle.m_sizeAnimation));
 
-	ANKI_CHECK(xmlF32(rel, "alpha", m_particle.m_alpha));
-	ANKI_CHECK(xmlF32(rel, "alphaDeviation", m_particle.m_alphaDeviation));
+	ANKI_CHECK(xmlF32(rel, "alpha", props.m_particle.m_alpha));
+	ANKI_CHECK(xmlF32(rel, "alphaDeviation", props.m_particle.m_alphaDeviation));
 
-	tmp = m_particle.m_alphaAnimation;
+	tmp = props.m_particle.m_alphaAnimation;
 	ANKI_CHECK(xmlU32(rel, "alphaAnimationEnabled", tmp));
-	m_particle.m_alphaAnimation = tmp;
+	props.m_particle.m_alphaAnimation = tmp;
 
-	ANKI_CHECK(xmlVec3(rel, "forceDirection", m_particle.m_forceDirection));
-	ANKI_CHECK(xmlVec3(rel, "forceDirectionDeviation", m_particle.m_forceDirectionDeviation));
-	ANKI_CHECK(xmlF32(rel, "forceMagnitude", m_particle.m_forceMagnitude));
-	ANKI_CHECK(xmlF32(rel, "forceMagnitudeDeviation", m_particle.m_forceMagnitudeDeviation));
+	ANKI_CHECK(xmlVec3(rel, "forceDirection", props.m_particle.m_forceDirection));
+	ANKI_CHECK(xmlVec3(rel, "forceDirectionDeviation", props.m_particle.m_forceDirectionDeviation));
+	ANKI_CHECK(xmlF32(rel, "forceMagnitude", props.m_particle.m_forceMagnitude));
+	ANKI_CHECK(xmlF32(rel, "forceMagnitudeDeviation", props.m_particle.m_forceMagnitudeDeviation));
 
-	ANKI_CHECK(xmlVec3(rel, "gravity", m_particle.m_gravity));
-	ANKI_CHECK(xmlVec3(rel, "gravityDeviation", m_particle.m_gravityDeviation));
+	ANKI_CHECK(xmlVec3(rel, "gravity", props.m_particle.m_gravity));
+	ANKI_CHECK(xmlVec3(rel, "gravityDeviation", props.m_particle.m_gravityDeviation));
 
-	ANKI_CHECK(xmlVec3(rel, "startingPosition", m_particle.m_startingPos));
-	ANKI_CHECK(xmlVec3(rel, "startingPositionDeviation", m_particle.m_startingPosDeviation));
+	ANKI_CHECK(xmlVec3(rel, "startingPosition", props.m_particle.m_startingPos));
+	ANKI_CHECK(xmlVec3(rel, "startingPositionDeviation", props.m_particle.m_startingPosDeviation));
 
-	ANKI_CHECK(xmlU32(rel, "maxNumberOfParticles", m_maxNumOfParticles));
+	ANKI_CHECK(xmlU32(rel, "maxNumberOfParticles", props.m_maxNumOfParticles));
 
-	ANKI_CHECK(xmlF32(rel, "emissionPeriod", m_emissionPeriod));
-	ANKI_CHECK(xmlU32(rel, "particlesPerEmittion", m_particlesPerEmittion));
-	tmp = m_usePhysicsEngine;
+	ANKI_CHECK(xmlF32(rel, "emissionPeriod", props.m_emissionPeriod));
+	ANKI_CHECK(xmlU32(rel, "particlesPerEmittion", props.m_particlesPerEmittion));
+	tmp = props.m_usePhysicsEngine;
 	ANKI_CHECK(xmlU32(rel, "usePhysicsEngine", tmp));
-	m_usePhysicsEngine = tmp;
+	props.m_usePhysicsEngine = tmp;
 
 	XmlElement el;
 	CString cstr;
 	ANKI_CHECK(rel.getChildElement("material", el));
 	ANKI_CHECK(el.getText(cstr));
-	ANKI_CHECK(getManager().loadResource(cstr, m_material));
 
 	// sanity checks
 	//
@@ -155,37 +154,37 @@ Error ParticleEmitterResource::load(const ResourceFilename& filename)
 	static const char* ERROR = "Particle emmiter: "
 							   "Incorrect or missing value %s";
 
-	if(m_particle.m_life <= 0.0)
+	if(props.m_particle.m_life <= 0.0)
 	{
 		ANKI_LOGE(ERROR, "life");
 		return ErrorCode::USER_DATA;
 	}
 
-	if(m_particle.m_life - m_particle.m_lifeDeviation <= 0.0)
+	if(props.m_particle.m_life - props.m_particle.m_lifeDeviation <= 0.0)
 	{
 		ANKI_LOGE(ERROR, "lifeDeviation");
 		return ErrorCode::USER_DATA;
 	}
 
-	if(m_particle.m_size <= 0.0)
+	if(props.m_particle.m_size <= 0.0)
 	{
 		ANKI_LOGE(ERROR, "size");
 		return ErrorCode::USER_DATA;
 	}
 
-	if(m_maxNumOfParticles < 1)
+	if(props.m_maxNumOfParticles < 1)
 	{
 		ANKI_LOGE(ERROR, "maxNumOfParticles");
 		return ErrorCode::USER_DATA;
 	}
 
-	if(m_emissionPeriod <= 0.0)
+	if(props.m_emissionPeriod <= 0.0)
 	{
 		ANKI_LOGE(ERROR, "emissionPeriod");
 		return ErrorCode::USER_DATA;
 	}
 
-	if(m_particlesPerEmittion < 1)
+	if(props.m_particlesPerEmittion < 1)
 	{
 		ANKI_LOGE(ERROR, "particlesPerEmission");
 		return ErrorCode::USER_DATA;
@@ -193,7 +192,27 @@ Error ParticleEmitterResource::load(const ResourceFilename& filename)
 
 	// Calc some stuff
 	//
-	updateFlags();
+	props.updateFlags();
+
+	out.write(props);
+	out.writeString(cstr);
+
+	return ErrorCode::NONE;
+}
+
+Error ParticleEmitterResource::load(const ResourceFilename& filename)
+{
+	DynamicArrayAuto<U8> compiled(getTempAllocator());
+	ANKI_CHECK(openFileCompiled(filename, COMPILED_VERSION, compileXml, nullptr, compiled));
+	BinaryReader in(&compiled[0], compiled.getSize());
+
+	ParticleEmitterProperties props;
+	ANKI_CHECK(in.read(props));
+	static_cast<ParticleEmitterProperties&>(*this) = props;
+
+	CString mtlFname;
+	ANKI_CHECK(in.readString(mtlFname));
+	ANKI_CHECK(getManager().loadResource(mtlFname, m_material));
 
 	return ErrorCode::NONE;
 }
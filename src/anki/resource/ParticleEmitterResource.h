@@ -123,10 +123,15 @@ public:
 	ANKI_USE_RESULT Error load(const ResourceFilename& filename);
 
 private:
+	/// Bump it when the compiled form changes.
+	static const U32 COMPILED_VERSION = 1;
+
 	MaterialResourcePtr m_material;
 	U8 m_lodCount = 1; ///< Cache the value from the material
 
 	void loadInternal(const XmlElement& el);
+
+	static ANKI_USE_RESULT Error compileXml(const XmlDocument& xml, BinaryWriter& out, void* userData);
 };
 /// @}
 
@@ -16,6 +16,8 @@
 #include <anki/resource/TextureResource.h>
 #include <anki/resource/GenericResource.h>
 #include <anki/resource/TextureAtlas.h>
+#include <anki/resource/CollisionResource.h>
+#include <anki/resource/Skeleton.h>
 #include <anki/util/Logger.h>
 #include <anki/misc/ConfigSet.h>
 
@@ -28,9 +30,22 @@ ResourceManager::ResourceManager()
 
 ResourceManager::~ResourceManager()
 {
+	evictUnreferencedResources();
+
+	if(m_mtlWarmList.save())
+	{
+		ANKI_LOGW("Failed to save the material warm list");
+	}
+
+	ANKI_ASSERT(m_pendingMtls.isEmpty());
+	m_pendingMtls.destroy(m_alloc);
+
 	m_cacheDir.destroy(m_alloc);
 	m_shadersPrependedSource.destroy(m_alloc);
 	m_alloc.deleteInstance(m_asyncLoader);
+
+	// After the loader because the tasks push to it
+	m_streamedTextures.destroy(m_alloc);
 }
 
 Error ResourceManager::create(ResourceManagerInitInfo& init)
@@ -44,14 +59,49 @@ Error ResourceManager::create(ResourceManagerInitInfo& init)
 
 	m_cacheDir.create(m_alloc, init.m_cacheDir);
 
+	m_shaderSourceCache.init(m_alloc, m_fs);
+	m_compiledCache.init(m_alloc, m_cacheDir.toCString(), init.m_config->getNumber("compiledResourceCache"));
+
 	// Init some constants
 	//
 	m_maxTextureSize = init.m_config->getNumber("maxTextureSize");
 	m_textureAnisotropy = init.m_config->getNumber("textureAnisotropy");
+	m_mtlVariantBuildsPerFrame = init.m_config->getNumber("materialVariantBuildsPerFrame");
+
+	// The budgets of the unreferenced resources
+	const PtrSize defaultBudget = init.m_config->getNumber("resourceResidencyBudget");
+	const PtrSize textureBudget = init.m_config->getNumber("textureResidencyBudget");
+	const PtrSize meshBudget = init.m_config->getNumber("meshResidencyBudget");
+
+	// Texture streaming. Zero budget disables it
+	m_texStreamer.init(m_alloc,
+		init.m_config->getNumber("textureStreamingBudget"),
+		init.m_config->getNumber("textureStreamingUnseenFrames"));
+	m_texStreamingBaseSize = init.m_config->getNumber("textureStreamingBaseSize");
+
+	// The tools don't have a GrManager
+	if(m_gr)
+	{
+		m_geometryArena.init(m_alloc,
+			m_gr,
+			init.m_config->getNumber("geometryVertexMemorySize"),
+			init.m_config->getNumber("geometryIndexMemorySize"));
+	}
+
+	// The variants that were drawn in the previous runs
+	StringAuto warmListFname(m_tmpAlloc);
+	warmListFname.sprintf("%s/material_warm_list.txt", &m_cacheDir[0]);
+	m_mtlWarmList.init(m_alloc, warmListFname.toCString());
+	if(m_mtlWarmList.load())
+	{
+		ANKI_LOGW("Ignoring the material warm list");
+	}
 
 // Init type resource managers
 //
-#define ANKI_RESOURCE(type_) TypeResourceManager<type_>::init(m_alloc);
+#define ANKI_RESOURCE(type_)                                                                                           \
+	TypeResourceManager<type_>::init(m_alloc);                                                                         \
+	TypeResourceManager<type_>::setResidencyBudget(defaultBudget);
 
 	ANKI_RESOURCE(Animation)
 	ANKI_RESOURCE(TextureResource)
@@ -69,6 +119,9 @@ Error ResourceManager::create(ResourceManagerInitInfo& init)
 
 #undef ANKI_RESOURCE
 
+	TypeResourceManager<TextureResource>::setResidencyBudget(textureBudget);
+	TypeResourceManager<Mesh>::setResidencyBudget(meshBudget);
+
 	// Init the thread
 	m_asyncLoader = m_alloc.newInstance<AsyncLoader>();
 	m_asyncLoader->init(m_alloc);
@@ -76,6 +129,136 @@ Error ResourceManager::create(ResourceManagerInitInfo& init)
 	return ErrorCode::NONE;
 }
 
+void ResourceManager::_addPendingMaterial(Material* mtl)
+{
+	for(Material* other : m_pendingMtls)
+	{
+		if(other == mtl)
+		{
+			return;
+		}
+	}
+
+	m_pendingMtls.pushBack(m_alloc, mtl);
+}
+
+void ResourceManager::_removePendingMaterial(Material* mtl)
+{
+	for(auto it = m_pendingMtls.getBegin(); it != m_pendingMtls.getEnd(); ++it)
+	{
+		if(*it == mtl)
+		{
+			m_pendingMtls.erase(m_alloc, it);
+			break;
+		}
+	}
+}
+
+void ResourceManager::buildPendingMaterialVariants()
+{
+	LockGuard<Mutex> lock(m_mtlVariantMtx);
+
+	U budget = m_mtlVariantBuildsPerFrame;
+	while(!m_pendingMtls.isEmpty() && budget > 0)
+	{
+		if(m_pendingMtls.getFront()->buildPendingVariants(budget))
+		{
+			m_pendingMtls.popFront(m_alloc);
+		}
+	}
+}
+
+Error ResourceManager::loadStreamedTexture(const CString& filename, TextureResourcePtr& out)
+{
+	const Bool stream = m_texStreamer.getBudget() > 0;
+	return loadResource(filename, out, stream);
+}
+
+void ResourceManager::_pushStreamedTexture(U32 handle, U64 uuid, U32 firstMip, TexturePtr tex)
+{
+	StreamedTexture streamed;
+	streamed.m_tex = tex;
+	streamed.m_uuid = uuid;
+	streamed.m_handle = handle;
+	streamed.m_firstMip = firstMip;
+
+	LockGuard<Mutex> lock(m_streamedTexturesMtx);
+	m_streamedTextures.pushBack(m_alloc, streamed);
+}
+
+void ResourceManager::updateTextureStreaming()
+{
+	if(m_texStreamer.getBudget() == 0)
+	{
+		return;
+	}
+
+	// Swap the textures that finished loading
+	Bool texturesChanged = false;
+	{
+		LockGuard<Mutex> lock(m_streamedTexturesMtx);
+		while(!m_streamedTextures.isEmpty())
+		{
+			StreamedTexture& streamed = m_streamedTextures.getFront();
+
+			// The texture might be gone and its handle reused
+			TextureResource* tex = static_cast<TextureResource*>(m_texStreamer.getUserData(streamed.m_handle));
+			if(tex && tex->getUuid() == streamed.m_uuid)
+			{
+				texturesChanged = texturesChanged || streamed.m_tex.isCreated();
+				tex->finishStreaming(streamed.m_tex, streamed.m_firstMip);
+			}
+
+			m_streamedTextures.popFront(m_alloc);
+		}
+	}
+
+	// The models have the textures in their resource groups. The particle emitters check the version themselves
+	if(texturesChanged)
+	{
+		TypeResourceManager<Model>::iterateResources([](Model& model) { model.refreshResourceGroups(); });
+	}
+
+	// Decide what to load and what to drop
+	WeakArray<TextureStreamerRequest> requests;
+	m_texStreamer.update(++m_texStreamingFrame, requests);
+
+	for(U i = 0; i < requests.getSize(); ++i)
+	{
+		TextureResource* tex = static_cast<TextureResource*>(m_texStreamer.getUserData(requests[i].m_handle));
+		tex->startStreaming(requests[i].m_firstMip);
+	}
+}
+
+void ResourceManager::evictUnreferencedResources()
+{
+	// The resources that hold other resources go first. Loop anyway because the deletions release other resources
+	U count;
+	do
+	{
+		count = 0;
+#define ANKI_RESOURCE(type_) count += TypeResourceManager<type_>::evictUnreferenced(0);
+
+		ANKI_RESOURCE(Model)
+		ANKI_RESOURCE(ParticleEmitterResource)
+		ANKI_RESOURCE(Material)
+		ANKI_RESOURCE(TextureAtlas)
+		ANKI_RESOURCE(Animation)
+		ANKI_RESOURCE(TextureResource)
+		ANKI_RESOURCE(ShaderResource)
+		ANKI_RESOURCE(Mesh)
+		ANKI_RESOURCE(Skeleton)
+		ANKI_RESOURCE(Script)
+		ANKI_RESOURCE(DummyRsrc)
+		ANKI_RESOURCE(CollisionResource)
+		ANKI_RESOURCE(GenericResource)
+
+#undef ANKI_RESOURCE
+
+		m_residencyStats.m_evictions += count;
+	} while(count > 0);
+}
+
 U64 ResourceManager::getAsyncTaskCompletedCount() const
 {
 	return m_asyncLoader->getCompletedTaskCount();
@@ -6,6 +6,12 @@
 #pragma once
 
 #include <anki/resource/Common.h>
+#include <anki/resource/CompiledResourceCache.h>
+#include <anki/resource/MaterialWarmList.h>
+#include <anki/resource/ShaderSourceCache.h>
+#include <anki/resource/TextureStreamer.h>
+#include <anki/resource/GeometryArena.h>
+#include <anki/gr/Common.h>
 #include <anki/util/List.h>
 #include <anki/util/Functions.h>
 #include <anki/util/String.h>
@@ -25,7 +31,8 @@ class Renderer;
 /// @addtogroup resource
 /// @{
 
-/// Manage resources of a certain type
+/// Manage resources of a certain type. The resources that lost all their references stay loaded (unreferenced) as long
+/// as they fit in the residency budget of the type. If the budget is exceeded the least recently used ones are deleted.
 template<typename Type>
 class TypeResourceManager
 {
@@ -39,6 +46,7 @@ protected:
 
 	~TypeResourceManager()
 	{
+		ANKI_ASSERT(m_unreferenced.isEmpty() && "Should have been evicted");
 		ANKI_ASSERT(m_ptrs.isEmpty() && "Forgot to delete some resources");
 		m_ptrs.destroy(m_alloc);
 	}
@@ -63,6 +71,87 @@ protected:
 		m_ptrs.erase(m_alloc, it);
 	}
 
+	/// The last reference of a resource is gone. Keep it loaded if the budget allows it.
+	/// @return The number of the unreferenced resources that got evicted.
+	U releaseResource(Type* ptr)
+	{
+		ANKI_ASSERT(ptr->getRefcount().load() == 0);
+
+		if(m_residencyBudget == 0)
+		{
+			deleteResource(ptr);
+			return 0;
+		}
+
+		m_unreferenced.pushBack(m_alloc, ptr);
+		m_unreferencedSize += getResidencySize(ptr);
+		return evictUnreferenced(m_residencyBudget);
+	}
+
+	/// Take a resource out of the unreferenced ones because it will get a reference.
+	void reviveResource(Type* ptr)
+	{
+		ANKI_ASSERT(ptr->getRefcount().load() == 0);
+
+		for(auto it = m_unreferenced.getBegin(); it != m_unreferenced.getEnd(); ++it)
+		{
+			if(*it == ptr)
+			{
+				m_unreferenced.erase(m_alloc, it);
+				m_unreferencedSize -= getResidencySize(ptr);
+				return;
+			}
+		}
+
+		ANKI_ASSERT(0 && "Not found");
+	}
+
+	/// Delete the least recently used unreferenced resources until the rest fit in a budget.
+	/// @return The number of the resources that got evicted.
+	U evictUnreferenced(PtrSize budget)
+	{
+		U count = 0;
+		while(m_unreferencedSize > budget)
+		{
+			ANKI_ASSERT(!m_unreferenced.isEmpty());
+
+			// Update the list before deleting because the deletion may release other resources
+			Type* ptr = m_unreferenced.getFront();
+			m_unreferenced.popFront(m_alloc);
+			m_unreferencedSize -= getResidencySize(ptr);
+
+			deleteResource(ptr);
+			++count;
+		}
+
+		return count;
+	}
+
+	void setResidencyBudget(PtrSize budget)
+	{
+		m_residencyBudget = budget;
+	}
+
+	PtrSize getResidencyBudget() const
+	{
+		return m_residencyBudget;
+	}
+
+	PtrSize getUnreferencedSize() const
+	{
+		return m_unreferencedSize;
+	}
+
+	/// Iterate all the loaded resources. The functor shouldn't load or release resources of the same type.
+	template<typename TFunc>
+	void iterateResources(TFunc func)
+	{
+		for(Type* ptr : m_ptrs)
+		{
+			func(*ptr);
+		}
+	}
+
 	void init(ResourceAllocator<U8> alloc)
 	{
 		m_alloc = alloc;
@@ -71,6 +160,9 @@ protected:
 private:
 	ResourceAllocator<U8> m_alloc;
 	Container m_ptrs;
+	Container m_unreferenced; ///< The least recently used is first.
+	PtrSize m_unreferencedSize = 0;
+	PtrSize m_residencyBudget = 0;
 
 	typename Container::Iterator find(const CString& filename)
 	{
@@ -86,6 +178,28 @@ private:
 
 		return it;
 	}
+
+	/// The resources that don't know their memory size cost something so they are not kept forever.
+	static PtrSize getResidencySize(const Type* ptr)
+	{
+		return max<PtrSize>(ptr->getMemorySize(), sizeof(Type));
+	}
+
+	void deleteResource(Type* ptr)
+	{
+		unregisterResource(ptr);
+		auto alloc = ptr->getAllocator();
+		alloc.deleteInstance(ptr);
+	}
+};
+
+/// Statistics of the residency of the resources.
+class ResourceResidencyStats
+{
+public:
+	U64 m_hits = 0; ///< The loadResource() calls that found the resource loaded.
+	U64 m_misses = 0; ///< The loadResource() calls that loaded the resource.
+	U64 m_evictions = 0; ///< The unreferenced resources that were deleted to respect the budgets.
 };
 
 class ResourceManagerInitInfo
@@ -126,13 +240,69 @@ public:
 	ANKI_USE_RESULT Error create(ResourceManagerInitInfo& init);
 
 	/// Load a resource.
-	template<typename T>
-	ANKI_USE_RESULT Error loadResource(const CString& filename, ResourcePtr<T>& out);
+	/// @param args Extra arguments for the load() of the resource. They are ignored if the resource is already loaded.
+	template<typename T, typename... TArgs>
+	ANKI_USE_RESULT Error loadResource(const CString& filename, ResourcePtr<T>& out, TArgs&&... args);
 
 	/// Load a resource to cache.
 	template<typename T, typename... TArgs>
 	ANKI_USE_RESULT Error loadResourceToCache(ResourcePtr<T>& out, TArgs&&... args);
 
+	/// Load a texture that is used by materials. If the texture streaming is enabled it will be loaded with its small
+	/// mips only and the rest will be streamed in when the renderer requests them.
+	ANKI_USE_RESULT Error loadStreamedTexture(const CString& filename, TextureResourcePtr& out);
+
+	/// Build some of the material variants that were deferred. Call it between frames.
+	void buildPendingMaterialVariants();
+
+	/// Swap the streamed textures that finished loading and start loading the mips the renderer requested. Call it
+	/// between frames while the async loader is paused.
+	void updateTextureStreaming();
+
+	const TextureStreamer& getTextureStreamer() const
+	{
+		return m_texStreamer;
+	}
+
+	/// Upload the geometry of the meshes that were loaded. Call it once per frame before rendering.
+	void flushGeometryUploads()
+	{
+		if(m_gr)
+		{
+			m_geometryArena.flushUploads();
+		}
+	}
+
+	/// Set the memory budget of the unreferenced resources of a type. If it's zero the resources are deleted when the
+	/// last reference is gone.
+	template<typename T>
+	void setResidencyBudget(PtrSize budget)
+	{
+		TypeResourceManager<T>::setResidencyBudget(budget);
+		m_residencyStats.m_evictions += TypeResourceManager<T>::evictUnreferenced(budget);
+	}
+
+	template<typename T>
+	PtrSize getResidencyBudget() const
+	{
+		return TypeResourceManager<T>::getResidencyBudget();
+	}
+
+	/// Get the memory of the unreferenced resources of a type that are still loaded.
+	template<typename T>
+	PtrSize getUnreferencedResourcesSize() const
+	{
+		return TypeResourceManager<T>::getUnreferencedSize();
+	}
+
+	/// Delete all the unreferenced resources. Call it when a big part of the scene goes away (eg at level change).
+	void evictUnreferencedResources();
+
+	void getResidencyStats(ResourceResidencyStats& stats) const
+	{
+		stats = m_residencyStats;
+	}
+
 anki_internal:
 	U32 getMaxTextureSize() const
 	{
@@ -188,6 +358,16 @@ anki_internal:
 		return m_shadersPrependedSource;
 	}
 
+	ShaderSourceCache& _getShaderSourceCache()
+	{
+		return m_shaderSourceCache;
+	}
+
+	CompiledResourceCache& _getCompiledResourceCache()
+	{
+		return m_compiledCache;
+	}
+
 	template<typename T>
 	T* findLoadedResource(const CString& filename)
 	{
@@ -206,6 +386,19 @@ anki_internal:
 		TypeResourceManager<T>::unregisterResource(ptr);
 	}
 
+	/// Called by the ResourcePtrDeleter.
+	template<typename T>
+	void releaseResource(T* ptr)
+	{
+		m_residencyStats.m_evictions += TypeResourceManager<T>::releaseResource(ptr);
+	}
+
+	GeometryArena& getGeometryArena()
+	{
+		ANKI_ASSERT(m_gr);
+		return m_geometryArena;
+	}
+
 	AsyncLoader& getAsyncLoader()
 	{
 		return *m_asyncLoader;
@@ -220,7 +413,57 @@ anki_internal:
 	/// Get the total number of completed async tasks.
 	U64 getAsyncTaskCompletedCount() const;
 
+	/// It serializes the builds of the material variants since the resource loading is not thread-safe.
+	Mutex& _getMaterialVariantMutex()
+	{
+		return m_mtlVariantMtx;
+	}
+
+	MaterialWarmList& _getMaterialWarmList()
+	{
+		return m_mtlWarmList;
+	}
+
+	/// If true the materials will draw with a built variant and they will build the requested ones later.
+	Bool _getDeferMaterialVariantBuilds() const
+	{
+		return m_mtlVariantBuildsPerFrame > 0;
+	}
+
+	/// The material variant mutex should be locked.
+	void _addPendingMaterial(Material* mtl);
+
+	/// The material variant mutex should be locked.
+	void _removePendingMaterial(Material* mtl);
+
+	TextureStreamer& _getTextureStreamer()
+	{
+		return m_texStreamer;
+	}
+
+	/// The max size of the mips that the streamed textures always keep resident.
+	U32 _getTextureStreamingBaseSize() const
+	{
+		return m_texStreamingBaseSize;
+	}
+
+	/// Called by the async loader when the mips of a streamed texture were loaded. It's thread-safe.
+	/// @param handle The TextureStreamer handle.
+	/// @param uuid The UUID of the TextureResource. The texture may be gone by the time it's called.
+	/// @param firstMip The first mip of the new texture.
+	/// @param tex The new texture. It's empty if the loading failed.
+	void _pushStreamedTexture(U32 handle, U64 uuid, U32 firstMip, TexturePtr tex);
+
 private:
+	class StreamedTexture
+	{
+	public:
+		TexturePtr m_tex;
+		U64 m_uuid;
+		U32 m_handle;
+		U32 m_firstMip;
+	};
+
 	GrManager* m_gr = nullptr;
 	PhysicsWorld* m_physics = nullptr;
 	ResourceFilesystem* m_fs = nullptr;
@@ -233,6 +476,24 @@ private:
 	AsyncLoader* m_asyncLoader = nullptr; ///< Async loading thread
 	U64 m_uuid = 0;
 	U64 m_loadRequestCount = 0;
+
+	ShaderSourceCache m_shaderSourceCache;
+	CompiledResourceCache m_compiledCache;
+
+	MaterialWarmList m_mtlWarmList;
+	Mutex m_mtlVariantMtx;
+	List<Material*> m_pendingMtls; ///< Materials with deferred variants.
+	U32 m_mtlVariantBuildsPerFrame = 0;
+
+	ResourceResidencyStats m_residencyStats;
+
+	TextureStreamer m_texStreamer;
+	U32 m_texStreamingBaseSize = 0;
+	U64 m_texStreamingFrame = 0;
+	Mutex m_streamedTexturesMtx;
+	List<StreamedTexture> m_streamedTextures; ///< The loads that completed.
+
+	GeometryArena m_geometryArena; ///< The GPU memory of the meshes.
 };
 /// @}
 
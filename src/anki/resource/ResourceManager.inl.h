@@ -8,8 +8,8 @@
 namespace anki
 {
 
-template<typename T>
-Error ResourceManager::loadResource(const CString& filename, ResourcePtr<T>& out)
+template<typename T, typename... TArgs>
+Error ResourceManager::loadResource(const CString& filename, ResourcePtr<T>& out, TArgs&&... args)
 {
 	ANKI_ASSERT(!out.isCreated() && "Already loaded");
 
@@ -20,11 +20,19 @@ Error ResourceManager::loadResource(const CString& filename, ResourcePtr<T>& out
 
 	if(other)
 	{
-		// Found
+		// Found. It may be an unreferenced one that was kept loaded
+		if(other->getRefcount().load() == 0)
+		{
+			TypeResourceManager<T>::reviveResource(other);
+		}
+
+		++m_residencyStats.m_hits;
 		out.reset(other);
 	}
 	else
 	{
+		++m_residencyStats.m_misses;
+
 		// Allocate ptr
 		T* ptr = m_alloc.newInstance<T>(this);
 		ANKI_ASSERT(ptr->getRefcount().load() == 0);
@@ -36,7 +44,7 @@ Error ResourceManager::loadResource(const CString& filename, ResourcePtr<T>& out
 			U allocsCountBefore = pool.getAllocationsCount();
 			(void)allocsCountBefore;
 
-			err = ptr->load(filename);
+			err = ptr->load(filename, std::forward<TArgs>(args)...);
 			if(err)
 			{
 				ANKI_LOGE("Failed to load resource: %s", &filename[0]);
@@ -5,7 +5,9 @@
 
 #include <anki/resource/ResourceObject.h>
 #include <anki/resource/ResourceManager.h>
+#include <anki/resource/CompiledResourceCache.h>
 #include <anki/misc/Xml.h>
+#include <anki/util/Hash.h>
 
 namespace anki
 {
@@ -59,4 +61,47 @@ Error ResourceObject::openFileParseXml(const CString& filename, XmlDocument& xml
 	return ErrorCode::NONE;
 }
 
+Error ResourceObject::openFileCompiled(const ResourceFilename& filename,
+	U32 version,
+	ResourceCompileCallback callback,
+	void* userData,
+	DynamicArrayAuto<U8>& compiled)
+{
+	ANKI_ASSERT(callback);
+
+	StringAuto txt(getTempAllocator());
+	ANKI_CHECK(openFileReadAllText(filename, txt));
+	if(txt.isEmpty())
+	{
+		ANKI_LOGE("File is empty: %s", &filename[0]);
+		return ErrorCode::USER_DATA;
+	}
+
+	// Try the cache
+	const U64 hash = computeHash(&txt[0], txt.getLength());
+	CompiledResourceCache& cache = m_manager->_getCompiledResourceCache();
+
+	Bool found;
+	ANKI_CHECK(cache.find(filename, version, hash, compiled, found));
+	if(found)
+	{
+		return ErrorCode::NONE;
+	}
+
+	// Compile it
+	XmlDocument xml;
+	ANKI_CHECK(xml.parse(txt.toCString(), getTempAllocator()));
+
+	BinaryWriter writer(getTempAllocator());
+	ANKI_CHECK(callback(xml, writer, userData));
+	ANKI_ASSERT(writer.getSize() > 0);
+
+	ANKI_CHECK(cache.store(filename, version, hash, writer.getData(), writer.getSize()));
+
+	compiled.create(writer.getSize());
+	memcpy(&compiled[0], writer.getData(), writer.getSize());
+
+	return ErrorCode::NONE;
+}
+
 } // end namespace anki
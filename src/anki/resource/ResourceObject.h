@@ -15,10 +15,14 @@ namespace anki
 
 // Forward
 class XmlDocument;
+class BinaryWriter;
 
 /// @addtogroup resource
 /// @{
 
+/// Writes the compiled form of a resource that is described in XML.
+using ResourceCompileCallback = Error (*)(const XmlDocument& xml, BinaryWriter& out, void* userData);
+
 /// The base of all resource objects.
 class ResourceObject
 {
@@ -54,6 +58,12 @@ public:
 		return m_fname.toCString();
 	}
 
+	/// Get the memory that the resource holds. The residency budgets use it.
+	PtrSize getMemorySize() const
+	{
+		return m_memorySize;
+	}
+
 anki_internal:
 	void setFilename(const CString& fname)
 	{
@@ -74,17 +84,38 @@ anki_internal:
 		return m_uuid;
 	}
 
+	/// Set it on load. It's an estimate of the CPU and GPU memory of the resource.
+	void setMemorySize(PtrSize size)
+	{
+		m_memorySize = size;
+	}
+
 	ANKI_USE_RESULT Error openFile(const ResourceFilename& filename, ResourceFilePtr& file);
 
 	ANKI_USE_RESULT Error openFileReadAllText(const ResourceFilename& filename, StringAuto& file);
 
 	ANKI_USE_RESULT Error openFileParseXml(const ResourceFilename& filename, XmlDocument& xml);
 
+	/// Get the compiled form of a resource that is described in XML. If the file didn't change since the last time it
+	/// was compiled the compiled form is read from the cache. If not the XML is parsed, the callback compiles it and
+	/// the result goes to the cache.
+	/// @param filename The resource file.
+	/// @param version The version of the compiled form. Bump it when the callback changes.
+	/// @param callback The callback that compiles the XML.
+	/// @param userData Passed to the callback.
+	/// @param[out] compiled The compiled form.
+	ANKI_USE_RESULT Error openFileCompiled(const ResourceFilename& filename,
+		U32 version,
+		ResourceCompileCallback callback,
+		void* userData,
+		DynamicArrayAuto<U8>& compiled);
+
 private:
 	ResourceManager* m_manager;
 	Atomic<I32> m_refcount;
 	String m_fname; ///< Unique resource name.
 	U64 m_uuid = 0;
+	PtrSize m_memorySize = 0;
 };
 /// @}
 
@@ -13,7 +13,8 @@
 namespace anki
 {
 
-/// Helper class used for shader program loading. The class adds the include preprocessor directive.
+/// Helper class used for shader program loading. The class adds the include preprocessor directive. The files are read
+/// through the manager's ShaderSourceCache so the common includes are read and parsed once.
 class ShaderLoader
 {
 public:
@@ -28,7 +29,6 @@ public:
 	~ShaderLoader()
 	{
 		m_shaderSource.destroy(m_alloc);
-		m_sourceLines.destroy(m_alloc);
 	}
 
 	/// Parse a PrePreprocessor formated GLSL file. Use the accessors to get the output
@@ -53,22 +53,11 @@ protected:
 	/// The final program source
 	String m_shaderSource;
 
-	/// The parseFileForPragmas fills this
-	StringList m_sourceLines;
-
 	/// Shader type
 	ShaderType m_type = ShaderType::COUNT;
 
 	/// Keep the manager for some path conversions.
 	ResourceManager* m_manager;
-
-	/// A recursive function that parses a file for #include and updates the output.
-	/// @param filename The file to parse
-	/// @param depth The #line in GLSL does not support filename so an depth it being used. It also tracks the
-	///        includance depth
-	ANKI_USE_RESULT Error parseFileIncludes(ResourceFilename filename, U32 depth);
-
-	void printSourceLines() const; ///< For debugging
 };
 
 } // end namespace anki
@@ -5,6 +5,7 @@
 
 #include <anki/resource/ShaderResource.h>
 #include <anki/resource/ShaderLoader.h>
+#include <anki/resource/ShaderSourceCache.h>
 #include <anki/resource/ResourceManager.h>
 #include <anki/core/App.h> // To get cache dir
 #include <anki/util/File.h>
@@ -32,6 +33,30 @@ Error ShaderResource::load(const ResourceFilename& filename)
 Error ShaderResource::load(const ResourceFilename& filename, const CString& extraSrc)
 {
 	auto alloc = getTempAllocator();
+	ShaderSourceCache& cache = getManager()._getShaderSourceCache();
+	const String& prependedSrc = getManager()._getShadersPrependedSource();
+
+	ANKI_CHECK(fileExtensionToShaderType(filename, m_type));
+
+	// The same file with the same defines gives the same source
+	U64 key = computeHash(&filename[0], filename.getLength());
+	if(extraSrc.getLength() > 0)
+	{
+		key = appendHash(&extraSrc[0], extraSrc.getLength(), key);
+	}
+
+	if(!prependedSrc.isEmpty())
+	{
+		key = appendHash(&prependedSrc[0], prependedSrc.getLength(), key);
+	}
+
+	const String* cachedSource;
+	ANKI_CHECK(cache.findSource(filename, key, cachedSource));
+	if(cachedSource)
+	{
+		m_shader = getManager().getGrManager().newInstance<Shader>(m_type, cachedSource->toCString());
+		return ErrorCode::NONE;
+	}
 
 	ShaderLoader pars(&getManager());
 	ANKI_CHECK(pars.parseFile(filename));
@@ -39,7 +64,7 @@ Error ShaderResource::load(const ResourceFilename& filename, const CString& extr
 	// Allocate new source
 	StringAuto source(alloc);
 
-	source.append(getManager()._getShadersPrependedSource());
+	source.append(prependedSrc);
 
 	if(extraSrc.getLength() > 0)
 	{
@@ -49,9 +74,9 @@ Error ShaderResource::load(const ResourceFilename& filename, const CString& extr
 	source.append(pars.getShaderSource());
 
 	// Create
-	m_shader = getManager().getGrManager().newInstance<Shader>(pars.getShaderType(), source.toCString());
+	m_shader = getManager().getGrManager().newInstance<Shader>(m_type, source.toCString());
 
-	m_type = pars.getShaderType();
+	cache.storeSource(filename, key, source.toCString());
 
 	return ErrorCode::NONE;
 }
@@ -0,0 +1,261 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/resource/ShaderSourceCache.h>
+#include <anki/resource/ResourceFilesystem.h>
+#include <anki/util/Hash.h>
+#include <anki/util/Logger.h>
+
+namespace anki
+{
+
+const U32 MAX_INCLUDE_DEPTH = 8;
+
+/// A file split in lines.
+class ShaderSourceCacheFile
+{
+public:
+	String m_filename;
+	StringList m_lines;
+	DynamicArray<ShaderSourceCacheFile*> m_includes; ///< One per line. If it's not nullptr the line is an #include.
+	U64 m_treeHash = 0; ///< The hash of the contents of the file and of the files it includes.
+	U32 m_treeDepth = 0; ///< The depth of the include tree under the file.
+
+	void destroy(ResourceAllocator<U8> alloc)
+	{
+		m_filename.destroy(alloc);
+		m_lines.destroy(alloc);
+		m_includes.destroy(alloc);
+	}
+};
+
+/// The final source of a shader instance.
+class ShaderSourceCacheSource
+{
+public:
+	String m_source;
+	U64 m_treeHash = 0; ///< The m_treeHash of the file when the source was stored.
+};
+
+ShaderSourceCache::~ShaderSourceCache()
+{
+	destroyFiles();
+
+	for(Source* source : m_sources)
+	{
+		source->m_source.destroy(m_alloc);
+		m_alloc.deleteInstance(source);
+	}
+	m_sources.destroy(m_alloc);
+}
+
+void ShaderSourceCache::init(ResourceAllocator<U8> alloc, ResourceFilesystem* fs)
+{
+	m_alloc = alloc;
+	m_fs = fs;
+}
+
+void ShaderSourceCache::destroyFiles()
+{
+	for(File* file : m_files)
+	{
+		file->destroy(m_alloc);
+		m_alloc.deleteInstance(file);
+	}
+	m_files.destroy(m_alloc);
+}
+
+void ShaderSourceCache::reloadFiles()
+{
+	destroyFiles();
+}
+
+Error ShaderSourceCache::getFile(CString filename, U depth, File*& file)
+{
+	if(depth > MAX_INCLUDE_DEPTH)
+	{
+		ANKI_LOGE("The include depth is too high. Probably circular includance");
+		return ErrorCode::USER_DATA;
+	}
+
+	auto it = m_files.find(filename);
+	if(it != m_files.getEnd())
+	{
+		file = *it;
+		if(depth + file->m_treeDepth > MAX_INCLUDE_DEPTH)
+		{
+			ANKI_LOGE("The include depth is too high. Probably circular includance");
+			return ErrorCode::USER_DATA;
+		}
+
+		++m_stats.m_fileHits;
+		return ErrorCode::NONE;
+	}
+
+	File* newFile = m_alloc.newInstance<File>();
+	Error err = parseFile(filename, depth, *newFile);
+	if(err)
+	{
+		newFile->destroy(m_alloc);
+		m_alloc.deleteInstance(newFile);
+		return err;
+	}
+
+	newFile->m_filename.create(m_alloc, filename);
+	m_files.pushBack(m_alloc, newFile->m_filename.toCString(), newFile);
+	file = newFile;
+
+	return ErrorCode::NONE;
+}
+
+Error ShaderSourceCache::parseFile(CString filename, U depth, File& file)
+{
+	ANKI_ASSERT(m_fs);
+
+	// Load the file in lines
+	StringAuto txt(m_alloc);
+	ResourceFilePtr rfile;
+	ANKI_CHECK(m_fs->openFile(filename, rfile));
+	ANKI_CHECK(rfile->readAllText(m_alloc, txt));
+	++m_stats.m_fileReads;
+
+	file.m_lines.splitString(m_alloc, txt.toCString(), '\n');
+	if(file.m_lines.getSize() < 1)
+	{
+		ANKI_LOGE("File is empty: %s", &filename[0]);
+		return ErrorCode::USER_DATA;
+	}
+
+	file.m_includes.create(m_alloc, file.m_lines.getSize(), nullptr);
+	file.m_treeHash = computeHash(&txt[0], txt.getLength());
+
+	// Resolve the includes
+	U i = 0;
+	for(const String& line : file.m_lines)
+	{
+		static const CString token = "#include \"";
+
+		if(line.find(token) == 0)
+		{
+			// - Expect something between the quotes
+			// - Expect the last char to be a quote
+			if(line.getLength() >= token.getLength() + 2 && line[line.getLength() - 1] == '\"')
+			{
+				StringAuto filen(m_alloc);
+				filen.create(line.begin() + token.getLength(), line.end() - 1);
+
+				File* include;
+				ANKI_CHECK(getFile(filen.toCString(), depth + 1, include));
+
+				file.m_includes[i] = include;
+				file.m_treeHash = appendHash(&include->m_treeHash, sizeof(include->m_treeHash), file.m_treeHash);
+				file.m_treeDepth = max<U32>(file.m_treeDepth, include->m_treeDepth + 1);
+			}
+			else
+			{
+				ANKI_LOGE("Malformed #include: %s", &line[0]);
+				return ErrorCode::USER_DATA;
+			}
+		}
+
+		++i;
+	}
+
+	return ErrorCode::NONE;
+}
+
+PtrSize ShaderSourceCache::computeExpandedLength(const File& file)
+{
+	PtrSize length = 0;
+	U i = 0;
+	for(const String& line : file.m_lines)
+	{
+		// Every line is followed by a new line
+		length += (file.m_includes[i]) ? computeExpandedLength(*file.m_includes[i]) : line.getLength() + 1;
+		++i;
+	}
+
+	return length;
+}
+
+void ShaderSourceCache::writeExpanded(const File& file, char*& out)
+{
+	U i = 0;
+	for(const String& line : file.m_lines)
+	{
+		if(file.m_includes[i])
+		{
+			writeExpanded(*file.m_includes[i], out);
+		}
+		else
+		{
+			memcpy(out, &line[0], line.getLength());
+			out += line.getLength();
+			*out = '\n';
+			++out;
+		}
+
+		++i;
+	}
+}
+
+Error ShaderSourceCache::expandIncludes(CString filename, GenericMemoryPoolAllocator<U8> alloc, String& out)
+{
+	File* file;
+	ANKI_CHECK(getFile(filename, 0, file));
+
+	// The last new line is not needed
+	const PtrSize length = computeExpandedLength(*file);
+	ANKI_ASSERT(length > 0);
+	out.create(alloc, '?', length - 1);
+
+	char* ptr = &out[0];
+	writeExpanded(*file, ptr);
+	ANKI_ASSERT(ptr == &out[0] + length);
+	*(ptr - 1) = '\0';
+
+	return ErrorCode::NONE;
+}
+
+Error ShaderSourceCache::findSource(CString filename, U64 key, const String*& source)
+{
+	source = nullptr;
+
+	auto it = m_sources.find(key);
+	if(it != m_sources.getEnd())
+	{
+		File* file;
+		ANKI_CHECK(getFile(filename, 0, file));
+
+		if((*it)->m_treeHash == file->m_treeHash)
+		{
+			source = &(*it)->m_source;
+			++m_stats.m_sourceHits;
+			return ErrorCode::NONE;
+		}
+
+		// One of the files changed
+		(*it)->m_source.destroy(m_alloc);
+		m_alloc.deleteInstance(*it);
+		m_sources.erase(m_alloc, it);
+	}
+
+	++m_stats.m_sourceMisses;
+	return ErrorCode::NONE;
+}
+
+void ShaderSourceCache::storeSource(CString filename, U64 key, CString source)
+{
+	auto fileIt = m_files.find(filename);
+	ANKI_ASSERT(fileIt != m_files.getEnd() && "Should have been expanded");
+	ANKI_ASSERT(m_sources.find(key) == m_sources.getEnd());
+
+	Source* newSource = m_alloc.newInstance<Source>();
+	newSource->m_source.create(m_alloc, source);
+	newSource->m_treeHash = (*fileIt)->m_treeHash;
+	m_sources.pushBack(m_alloc, key, newSource);
+}
+
+} // end namespace anki
@@ -0,0 +1,108 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/resource/Common.h>
+#include <anki/util/HashMap.h>
+#include <anki/util/StringList.h>
+
+namespace anki
+{
+
+// Forward
+class ResourceFilesystem;
+class ShaderSourceCacheFile;
+class ShaderSourceCacheSource;
+
+/// @addtogroup resource
+/// @{
+
+class ShaderSourceCacheStats
+{
+public:
+	U32 m_fileReads = 0; ///< Files that were read from the disk.
+	U32 m_fileHits = 0; ///< Files or #includes that were found parsed.
+	U32 m_sourceHits = 0; ///< Shader sources that were found expanded.
+	U32 m_sourceMisses = 0;
+};
+
+/// Caches the shader files and the final shader sources. Every file is read and split in lines once and the parsed
+/// files are shared by all the files that #include them. The final source of a shader instance is kept as well,
+/// keyed by the file and the defines, so loading the same shader again skips the preprocessing.
+///
+/// The files are identified by name and content hash. If the files are reloaded the sources that were expanded from
+/// files that changed will be expanded again.
+///
+/// It's not thread-safe. Neither is the resource loading.
+class ShaderSourceCache : public NonCopyable
+{
+public:
+	ShaderSourceCache() = default;
+
+	~ShaderSourceCache();
+
+	void init(ResourceAllocator<U8> alloc, ResourceFilesystem* fs);
+
+	/// Expand all the #include directives of a file. The lines are joined with a new line.
+	ANKI_USE_RESULT Error expandIncludes(CString filename, GenericMemoryPoolAllocator<U8> alloc, String& out);
+
+	/// Find the final source of a shader instance.
+	/// @param filename The shader file.
+	/// @param key A hash of the file name and of the defines.
+	/// @param[out] source The source or nullptr if it's not found or if the files changed.
+	ANKI_USE_RESULT Error findSource(CString filename, U64 key, const String*& source);
+
+	/// Keep the final source of a shader instance.
+	/// @param filename The shader file. It should have been expanded already.
+	/// @param key A hash of the file name and of the defines.
+	/// @param source The final source.
+	void storeSource(CString filename, U64 key, CString source);
+
+	/// Forget the parsed files. They will be read again the next time they are needed.
+	void reloadFiles();
+
+	void getStats(ShaderSourceCacheStats& stats) const
+	{
+		stats = m_stats;
+	}
+
+private:
+	using File = ShaderSourceCacheFile;
+	using Source = ShaderSourceCacheSource;
+
+	/// The hashes are already there.
+	class Hasher
+	{
+	public:
+		U64 operator()(U64 hash) const
+		{
+			return hash;
+		}
+	};
+
+	ResourceAllocator<U8> m_alloc;
+	ResourceFilesystem* m_fs = nullptr;
+
+	HashMap<CString, File*, CStringHasher, CStringCompare> m_files;
+	HashMap<U64, Source*, Hasher> m_sources;
+
+	ShaderSourceCacheStats m_stats;
+
+	/// Get a parsed file. Read it and parse it if it's not there.
+	/// @param depth The depth of the file in the include tree. It catches the circular includes.
+	ANKI_USE_RESULT Error getFile(CString filename, U depth, File*& file);
+
+	ANKI_USE_RESULT Error parseFile(CString filename, U depth, File& file);
+
+	static PtrSize computeExpandedLength(const File& file);
+
+	static void writeExpanded(const File& file, char*& out);
+
+	void destroyFiles();
+};
+/// @}
+
+} // end namespace anki
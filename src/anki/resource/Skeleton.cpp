@@ -6,6 +6,7 @@
 #include <anki/resource/Skeleton.h>
 #include <anki/misc/Xml.h>
 #include <anki/util/StringList.h>
+#include <algorithm>
 
 namespace anki
 {
@@ -18,6 +19,7 @@ Skeleton::~Skeleton()
 	}
 
 	m_bones.destroy(getAllocator());
+	m_boneOrder.destroy(getAllocator());
 }
 
 Error Skeleton::load(const ResourceFilename& filename)
@@ -39,6 +41,8 @@ Error Skeleton::load(const ResourceFilename& filename)
 	++bonesCount;
 
 	m_bones.create(getAllocator(), bonesCount);
+	DynamicArrayAuto<CString> parentNames(getTempAllocator());
+	parentNames.create(bonesCount);
 
 	// Load every bone
 	bonesCount = 0;
@@ -57,12 +61,107 @@ Error Skeleton::load(const ResourceFilename& filename)
 		XmlElement trfEl;
 		ANKI_CHECK(boneEl.getChildElement("transform", trfEl));
 		ANKI_CHECK(trfEl.getMat4(bone.m_transform));
+		bone.m_offset = Mat3x4(bone.m_transform);
+
+		// <parent>
+		XmlElement parentEl;
+		ANKI_CHECK(boneEl.getChildElementOptional("parent", parentEl));
+		if(parentEl)
+		{
+			ANKI_CHECK(parentEl.getText(parentNames[bonesCount - 1]));
+		}
 
 		// Advance
 		ANKI_CHECK(boneEl.getNextSiblingElement("bone", boneEl));
 	} while(boneEl);
 
+	// Resolve the parents
+	for(U32 i = 0; i < m_bones.getSize(); ++i)
+	{
+		if(parentNames[i].isEmpty())
+		{
+			continue;
+		}
+
+		m_bones[i].m_parent = findBone(parentNames[i]);
+		if(m_bones[i].m_parent == MAX_U32 || m_bones[i].m_parent == i)
+		{
+			ANKI_LOGE("Bone %s has a wrong parent: %s", &m_bones[i].m_name[0], &parentNames[i][0]);
+			return ErrorCode::USER_DATA;
+		}
+	}
+
+	return computeHierarchy();
+}
+
+Error Skeleton::computeHierarchy()
+{
+	const U32 boneCount = m_bones.getSize();
+
+	// Find the depth of every bone. A depth bigger than the bone count means a loop
+	DynamicArrayAuto<U32> depths(getTempAllocator());
+	depths.create(boneCount);
+	for(U32 i = 0; i < boneCount; ++i)
+	{
+		U32 depth = 0;
+		U32 parent = m_bones[i].m_parent;
+		while(parent != MAX_U32 && depth <= boneCount)
+		{
+			++depth;
+			parent = m_bones[parent].m_parent;
+		}
+
+		if(depth > boneCount)
+		{
+			ANKI_LOGE("The hierarchy of the bones has a loop");
+			return ErrorCode::USER_DATA;
+		}
+
+		depths[i] = depth;
+	}
+
+	// Order by depth. The parents end up before their children and the siblings keep the order of the file
+	m_boneOrder.create(getAllocator(), boneCount);
+	for(U32 i = 0; i < boneCount; ++i)
+	{
+		m_boneOrder[i] = i;
+	}
+
+	std::stable_sort(m_boneOrder.getBegin(), m_boneOrder.getEnd(), [&](U32 a, U32 b) { return depths[a] < depths[b]; });
+
+	// The bind pose relative to the parent. The bind pose in model space is the inverse of the transform
+	for(Bone& bone : m_bones)
+	{
+		Mat4 local = bone.m_transform.getInverse();
+		if(bone.m_parent != MAX_U32)
+		{
+			local = m_bones[bone.m_parent].m_transform * local;
+		}
+
+		Mat3 rot = local.getRotationPart();
+		const F32 scale = rot.getColumn(0).getLength();
+		ANKI_ASSERT(scale > EPSILON);
+		rot *= 1.0 / scale;
+
+		bone.m_bindPosition = Vec4(local.getTranslationPart().xyz(), 0.0);
+		bone.m_bindRotation = Quat(rot);
+		bone.m_bindScale = scale;
+	}
+
 	return ErrorCode::NONE;
 }
 
+U32 Skeleton::findBone(const CString& name) const
+{
+	for(U32 i = 0; i < m_bones.getSize(); ++i)
+	{
+		if(m_bones[i].m_name.toCString() == name)
+		{
+			return i;
+		}
+	}
+
+	return MAX_U32;
+}
+
 } // end namespace anki
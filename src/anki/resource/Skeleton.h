@@ -29,11 +29,42 @@ public:
 		return m_name;
 	}
 
+	/// The transformation from the model space to the space of the bone in the bind pose.
 	const Mat4& getTransform() const
 	{
 		return m_transform;
 	}
 
+	/// Same as getTransform() in a form that is faster to combine.
+	const Mat3x4& getOffsetTransform() const
+	{
+		return m_offset;
+	}
+
+	/// The index of the parent bone or MAX_U32 if it's a root.
+	U32 getParent() const
+	{
+		return m_parent;
+	}
+
+	/// The position of the bone relative to its parent in the bind pose.
+	const Vec4& getBindPosition() const
+	{
+		return m_bindPosition;
+	}
+
+	/// The rotation of the bone relative to its parent in the bind pose.
+	const Quat& getBindRotation() const
+	{
+		return m_bindRotation;
+	}
+
+	/// The scale of the bone relative to its parent in the bind pose.
+	F32 getBindScale() const
+	{
+		return m_bindScale;
+	}
+
 	/// @privatesection
 	/// @{
 	void _destroy(ResourceAllocator<U8> alloc)
@@ -48,6 +79,11 @@ private:
 
 	// see the class notes
 	Mat4 m_transform;
+	Mat3x4 m_offset;
+	Vec4 m_bindPosition = Vec4(0.0);
+	Quat m_bindRotation = Quat::getIdentity();
+	F32 m_bindScale = 1.0;
+	U32 m_parent = MAX_U32;
 };
 
 /// It contains the bones with their position and hierarchy
@@ -60,11 +96,15 @@ private:
 /// 		<bone>
 /// 			<name>X</name>
 /// 			<transform></transform>
+/// 			[<parent>Y</parent>]
 /// 		<bone>
 ///         ...
 /// 	</bones>
 /// </skeleton>
 /// @endcode
+///
+/// The transform is the inverse of the bind pose of the bone in model space. The bones without a parent are roots.
+/// The bones keep the order of the file because the meshes index them.
 class Skeleton : public ResourceObject
 {
 public:
@@ -83,8 +123,23 @@ public:
 		return m_bones;
 	}
 
+	/// The indices of all the bones ordered so that the parents come before their children. Walking it once is enough
+	/// to compute the transforms of the whole hierarchy.
+	const DynamicArray<U32>& getBoneOrder() const
+	{
+		return m_boneOrder;
+	}
+
+	/// Find a bone by name.
+	/// @return The index of the bone or MAX_U32 if there is no such bone.
+	U32 findBone(const CString& name) const;
+
 private:
 	DynamicArray<Bone> m_bones;
+	DynamicArray<U32> m_boneOrder;
+
+	/// Compute the order and the bind pose of the bones relative to their parents.
+	ANKI_USE_RESULT Error computeHierarchy();
 };
 /// @}
 
@@ -5,6 +5,7 @@
 
 #include <anki/resource/TextureAtlas.h>
 #include <anki/resource/ResourceManager.h>
+#include <anki/resource/CompiledResourceCache.h>
 #include <anki/misc/Xml.h>
 
 namespace anki
@@ -21,11 +22,8 @@ TextureAtlas::~TextureAtlas()
 	m_subTexNames.destroy(getAllocator());
 }
 
-Error TextureAtlas::load(const ResourceFilename& filename)
+Error TextureAtlas::compileXml(const XmlDocument& doc, BinaryWriter& out, void* userData)
 {
-	XmlDocument doc;
-	ANKI_CHECK(openFileParseXml(filename, doc));
-
 	XmlElement rootel, el;
 
 	//
@@ -39,10 +37,7 @@ Error TextureAtlas::load(const ResourceFilename& filename)
 	ANKI_CHECK(rootel.getChildElement("texture", el));
 	CString texFname;
 	ANKI_CHECK(el.getText(texFname));
-	ANKI_CHECK(getManager().loadResource<TextureResource>(texFname, m_tex));
-
-	m_size[0] = m_tex->getWidth();
-	m_size[1] = m_tex->getHeight();
+	out.writeString(texFname);
 
 	//
 	// <subTextureMargin>
@@ -50,23 +45,24 @@ Error TextureAtlas::load(const ResourceFilename& filename)
 	ANKI_CHECK(rootel.getChildElement("subTextureMargin", el));
 	I64 margin = 0;
 	ANKI_CHECK(el.getI64(margin));
-	if(margin >= I(m_tex->getWidth()) || margin >= I(m_tex->getHeight()) || margin < 0)
+	if(margin < 0 || margin > MAX_U32)
 	{
-		ANKI_LOGE("Too big margin %d", U(margin));
+		ANKI_LOGE("Wrong margin %d", I(margin));
 		return ErrorCode::USER_DATA;
 	}
-	m_margin = margin;
+	out.write(U32(margin));
 
 	//
 	// <subTextures>
 	//
-
-	// Get counts
-	PtrSize namesSize = 0;
-	PtrSize subTexesCount = 0;
 	XmlElement subTexesEl, subTexEl;
 	ANKI_CHECK(rootel.getChildElement("subTextures", subTexesEl));
 	ANKI_CHECK(subTexesEl.getChildElement("subTexture", subTexEl));
+
+	U32 subTexesCount = 0;
+	ANKI_CHECK(subTexEl.getSiblingElementsCount(subTexesCount));
+	out.write<U32>(subTexesCount + 1);
+
 	do
 	{
 		ANKI_CHECK(subTexEl.getChildElement("name", el));
@@ -79,40 +75,71 @@ Error TextureAtlas::load(const ResourceFilename& filename)
 			return ErrorCode::USER_DATA;
 		}
 
-		namesSize += name.getLength() + 1;
-		++subTexesCount;
+		ANKI_CHECK(subTexEl.getChildElement("uv", el));
+		Vec4 uv;
+		ANKI_CHECK(el.getVec4(uv));
+
+		out.writeString(name);
+		out.write(Array<F32, 4>{{uv[0], uv[1], uv[2], uv[3]}});
 
 		ANKI_CHECK(subTexEl.getNextSiblingElement("subTexture", subTexEl));
 	} while(subTexEl);
 
-	// Allocate
+	return ErrorCode::NONE;
+}
+
+Error TextureAtlas::load(const ResourceFilename& filename)
+{
+	DynamicArrayAuto<U8> compiled(getTempAllocator());
+	ANKI_CHECK(openFileCompiled(filename, COMPILED_VERSION, compileXml, nullptr, compiled));
+	BinaryReader in(&compiled[0], compiled.getSize());
+
+	// Texture
+	CString texFname;
+	ANKI_CHECK(in.readString(texFname));
+	ANKI_CHECK(getManager().loadResource<TextureResource>(texFname, m_tex));
+
+	m_size[0] = m_tex->getWidth();
+	m_size[1] = m_tex->getHeight();
+
+	// Margin
+	ANKI_CHECK(in.read(m_margin));
+	if(m_margin >= m_tex->getWidth() || m_margin >= m_tex->getHeight())
+	{
+		ANKI_LOGE("Too big margin %u", m_margin);
+		return ErrorCode::USER_DATA;
+	}
+
+	// Sub textures. Read them once to get the names size
+	U32 subTexesCount;
+	ANKI_CHECK(in.read(subTexesCount));
+
+	BinaryReader in2 = in;
+	PtrSize namesSize = 0;
+	for(U i = 0; i < subTexesCount; ++i)
+	{
+		CString name;
+		ANKI_CHECK(in2.readString(name));
+		Array<F32, 4> uv;
+		ANKI_CHECK(in2.read(uv));
+
+		namesSize += name.getLength() + 1;
+	}
+
 	m_subTexNames.create(getAllocator(), namesSize);
 	m_subTexes.create(getAllocator(), subTexesCount);
 
-	// Iterate again and populate
-	subTexesCount = 0;
 	char* names = &m_subTexNames[0];
-	ANKI_CHECK(subTexesEl.getChildElement("subTexture", subTexEl));
-	do
+	for(SubTex& subTex : m_subTexes)
 	{
-		ANKI_CHECK(subTexEl.getChildElement("name", el));
 		CString name;
-		ANKI_CHECK(el.getText(name));
-
+		ANKI_CHECK(in.readString(name));
 		memcpy(names, &name[0], name.getLength() + 1);
-
-		m_subTexes[subTexesCount].m_name = names;
-
-		ANKI_CHECK(subTexEl.getChildElement("uv", el));
-		Vec4 uv;
-		ANKI_CHECK(el.getVec4(uv));
-		m_subTexes[subTexesCount].m_uv = {{uv[0], uv[1], uv[2], uv[3]}};
-
+		subTex.m_name = names;
 		names += name.getLength() + 1;
-		++subTexesCount;
 
-		ANKI_CHECK(subTexEl.getNextSiblingElement("subTexture", subTexEl));
-	} while(subTexEl);
+		ANKI_CHECK(in.read(subTex.m_uv));
+	}
 
 	return ErrorCode::NONE;
 }
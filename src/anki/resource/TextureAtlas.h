@@ -73,11 +73,16 @@ private:
 		Array<F32, 4> m_uv;
 	};
 
+	/// Bump it when the compiled form changes.
+	static const U32 COMPILED_VERSION = 1;
+
 	TextureResourcePtr m_tex;
 	DynamicArray<char> m_subTexNames;
 	DynamicArray<SubTex> m_subTexes;
 	Array<U32, 2> m_size;
 	U32 m_margin = 0;
+
+	static ANKI_USE_RESULT Error compileXml(const XmlDocument& xml, BinaryWriter& out, void* userData);
 };
 /// @}
 
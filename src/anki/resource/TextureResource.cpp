@@ -7,6 +7,8 @@
 #include <anki/resource/ImageLoader.h>
 #include <anki/resource/ResourceManager.h>
 #include <anki/resource/AsyncLoader.h>
+#include <anki/resource/TextureStreamer.h>
+#include <anki/util/Logger.h>
 
 namespace anki
 {
@@ -30,16 +32,59 @@ public:
 		U m_layer = 0;
 	} m_ctx;
 
+	/// @name Streaming. If there is a manager the task loads the image first and it reports back to the manager.
+	/// @{
+	ResourceManager* m_manager = nullptr;
+	StringAuto m_filename;
+	U32 m_maxTextureSize = MAX_U32;
+	U32 m_streamingHandle = MAX_U32;
+	U64 m_uuid = 0;
+	U8 m_firstMip = 0;
+	Bool8 m_loaded = false;
+	/// @}
+
 	TexUploadTask(GenericMemoryPoolAllocator<U8> alloc)
 		: m_loader(alloc)
+		, m_filename(alloc)
 	{
 	}
 
 	Error operator()(AsyncLoaderTaskContext& ctx) final;
+
+private:
+	ANKI_USE_RESULT Error loadStreamedMips();
 };
 
+Error TexUploadTask::loadStreamedMips()
+{
+	ResourceFilePtr file;
+	ANKI_CHECK(m_manager->getFilesystem().openFile(m_filename.toCString(), file));
+	ANKI_CHECK(m_loader.load(file, m_filename.toCString(), m_maxTextureSize));
+
+	if(m_loader.getFirstMipLevel() != m_firstMip)
+	{
+		ANKI_LOGE("The texture file changed");
+		return ErrorCode::USER_DATA;
+	}
+
+	return ErrorCode::NONE;
+}
+
 Error TexUploadTask::operator()(AsyncLoaderTaskContext& ctx)
 {
+	if(m_manager && !m_loaded)
+	{
+		if(loadStreamedMips())
+		{
+			// Don't return the error, it will stop the loader
+			ANKI_LOGE("Failed to stream the mips of texture: %s", &m_filename[0]);
+			m_manager->_pushStreamedTexture(m_streamingHandle, m_uuid, m_firstMip, TexturePtr());
+			return ErrorCode::NONE;
+		}
+
+		m_loaded = true;
+	}
+
 	CommandBufferPtr cmdb;
 
 	// Upload the data
@@ -145,14 +190,23 @@ Error TexUploadTask::operator()(AsyncLoaderTaskContext& ctx)
 		cmdb->flush();
 	}
 
+	if(m_manager)
+	{
+		m_manager->_pushStreamedTexture(m_streamingHandle, m_uuid, m_firstMip, m_tex);
+	}
+
 	return ErrorCode::NONE;
 }
 
 TextureResource::~TextureResource()
 {
+	if(isStreamed())
+	{
+		getManager()._getTextureStreamer().unregisterTexture(m_streamingHandle);
+	}
 }
 
-Error TextureResource::load(const ResourceFilename& filename)
+Error TextureResource::load(const ResourceFilename& filename, Bool stream)
 {
 	TextureInitInfo init;
 	init.m_usage =
@@ -167,7 +221,15 @@ Error TextureResource::load(const ResourceFilename& filename)
 	ResourceFilePtr file;
 	ANKI_CHECK(openFile(filename, file));
 
-	ANKI_CHECK(loader.load(file, filename, getManager().getMaxTextureSize()));
+	// The streamed textures load only their small mips
+	U32 maxTextureSize = getManager().getMaxTextureSize();
+	if(stream)
+	{
+		maxTextureSize = min(maxTextureSize, getManager()._getTextureStreamingBaseSize());
+	}
+
+	ANKI_CHECK(loader.load(file, filename, maxTextureSize));
+	setMemorySize(loader.getDataSize());
 
 	// Various sizes
 	init.m_width = loader.getWidth();
@@ -279,7 +341,105 @@ Error TextureResource::load(const ResourceFilename& filename)
 	// Done
 	m_size = UVec3(init.m_width, init.m_height, init.m_depth);
 	m_layerCount = init.m_layerCount;
+
+	// Register the texture for streaming if the file has larger mips that can be loaded
+	const U baseMip = loader.getFirstMipLevel();
+	if(stream && baseMip > 0)
+	{
+		m_mip0Init = init;
+		m_mip0Init.m_width <<= baseMip;
+		m_mip0Init.m_height <<= baseMip;
+		m_mip0Init.m_mipmapsCount += baseMip;
+		U32 mip0Size = max(m_mip0Init.m_width, m_mip0Init.m_height);
+		if(init.m_type == TextureType::_3D)
+		{
+			m_mip0Init.m_depth <<= baseMip;
+			mip0Size = max(mip0Size, m_mip0Init.m_depth);
+		}
+
+		U topMip = 0;
+		while((mip0Size >> topMip) > getManager().getMaxTextureSize())
+		{
+			++topMip;
+		}
+
+		if(topMip < baseMip)
+		{
+			m_streamingHandle = getManager()._getTextureStreamer().registerTexture(mip0Size,
+				m_mip0Init.m_mipmapsCount,
+				topMip,
+				baseMip,
+				loader.getDataSize(),
+				init.m_type == TextureType::_3D,
+				this);
+
+			m_faceCount = faces;
+			m_residentMip = baseMip;
+			m_size = UVec3(m_mip0Init.m_width >> topMip,
+				m_mip0Init.m_height >> topMip,
+				(init.m_type == TextureType::_3D) ? (m_mip0Init.m_depth >> topMip) : 1);
+		}
+	}
+
 	return ErrorCode::NONE;
 }
 
+void TextureResource::requestScreenSize(F32 screenSize)
+{
+	if(isStreamed())
+	{
+		getManager()._getTextureStreamer().requestScreenSize(m_streamingHandle, screenSize);
+	}
+}
+
+void TextureResource::startStreaming(U32 firstMip)
+{
+	ANKI_ASSERT(isStreamed());
+	ResourceManager& manager = getManager();
+
+	TextureInitInfo init = m_mip0Init;
+	init.m_width >>= firstMip;
+	init.m_height >>= firstMip;
+	init.m_mipmapsCount -= firstMip;
+	U32 maxTextureSize = max(init.m_width, init.m_height);
+	if(init.m_type == TextureType::_3D)
+	{
+		init.m_depth >>= firstMip;
+		maxTextureSize = max(maxTextureSize, init.m_depth);
+	}
+
+	// Create a new texture and load all the resident mips in it. The old one is used until the new is ready
+	TexUploadTask* task =
+		manager.getAsyncLoader().newTask<TexUploadTask>(manager.getAsyncLoader().getAllocator());
+
+	task->m_tex = manager.getGrManager().newInstance<Texture>(init);
+	task->m_layers = init.m_layerCount;
+	task->m_faces = m_faceCount;
+	task->m_gr = &manager.getGrManager();
+	task->m_texType = init.m_type;
+
+	task->m_manager = &manager;
+	task->m_filename.create(getFilename());
+	task->m_maxTextureSize = maxTextureSize;
+	task->m_streamingHandle = m_streamingHandle;
+	task->m_uuid = getUuid();
+	task->m_firstMip = firstMip;
+
+	manager.getAsyncLoader().submitTask(task);
+}
+
+void TextureResource::finishStreaming(TexturePtr tex, U32 firstMip)
+{
+	ANKI_ASSERT(isStreamed());
+
+	if(tex)
+	{
+		m_tex = tex;
+		m_residentMip = firstMip;
+		++m_streamingVersion;
+	}
+
+	getManager()._getTextureStreamer().markResident(m_streamingHandle, m_residentMip);
+}
+
 } // end namespace anki
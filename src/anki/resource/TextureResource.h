@@ -29,7 +29,8 @@ public:
 	~TextureResource();
 
 	/// Load a texture
-	ANKI_USE_RESULT Error load(const ResourceFilename& filename);
+	/// @param stream If true only the small mips are loaded and the rest are streamed.
+	ANKI_USE_RESULT Error load(const ResourceFilename& filename, Bool stream = false);
 
 	/// Get the texture
 	const TexturePtr& getGrTexture() const
@@ -67,10 +68,42 @@ public:
 		return m_layerCount;
 	}
 
+	/// Ask for the mips that cover some pixels on the screen. It does nothing if the texture is not streamed. It's
+	/// thread-safe.
+	void requestScreenSize(F32 screenSize);
+
+anki_internal:
+	/// It's incremented every time the streaming replaces the GR texture. The holders of the GR texture should get it
+	/// again when it changes.
+	U32 getStreamingVersion() const
+	{
+		return m_streamingVersion;
+	}
+
+	/// Start the loading of a new set of resident mips.
+	void startStreaming(U32 firstMip);
+
+	/// The streaming finished. If the texture is nullptr it failed.
+	void finishStreaming(TexturePtr tex, U32 firstMip);
+
 private:
 	TexturePtr m_tex;
 	UVec3 m_size = UVec3(0u);
 	U32 m_layerCount = 0;
+
+	/// @name Streaming
+	/// @{
+	U32 m_streamingHandle = MAX_U32;
+	U32 m_streamingVersion = 0;
+	TextureInitInfo m_mip0Init; ///< The texture of the mip 0 of the file.
+	U8 m_faceCount = 0;
+	U8 m_residentMip = 0;
+	/// @}
+
+	Bool isStreamed() const
+	{
+		return m_streamingHandle != MAX_U32;
+	}
 };
 /// @}
 
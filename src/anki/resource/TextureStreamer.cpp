@@ -0,0 +1,258 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/resource/TextureStreamer.h>
+#include <algorithm>
+
+namespace anki
+{
+
+TextureStreamer::~TextureStreamer()
+{
+	for(Entry* e : m_entries)
+	{
+		m_alloc.deleteInstance(e);
+	}
+
+	m_entries.destroy(m_alloc);
+	m_requests.destroy(m_alloc);
+}
+
+void TextureStreamer::init(ResourceAllocator<U8> alloc, PtrSize budget, U32 unseenFrameCount)
+{
+	m_alloc = alloc;
+	m_budget = budget;
+	m_unseenFrameCount = unseenFrameCount;
+}
+
+U32 TextureStreamer::computeRequiredMip(U32 size, U32 mipCount, F32 screenSize)
+{
+	ANKI_ASSERT(mipCount > 0);
+
+	// Pick the smallest mip that is not smaller than the screen size
+	U32 mip = 0;
+	while(mip + 1 < mipCount && F32(size >> (mip + 1)) >= screenSize)
+	{
+		++mip;
+	}
+
+	return mip;
+}
+
+PtrSize TextureStreamer::computeMemory(const Entry& e, U32 firstMip)
+{
+	const U32 shift = (e.m_volume) ? 3 : 2;
+
+	PtrSize size = 0;
+	for(U32 mip = firstMip; mip < e.m_mipCount; ++mip)
+	{
+		size += (mip <= e.m_baseMip) ? (e.m_baseSize << (shift * (e.m_baseMip - mip)))
+									 : (e.m_baseSize >> (shift * (mip - e.m_baseMip)));
+	}
+
+	return size;
+}
+
+U32 TextureStreamer::registerTexture(
+	U32 size, U32 mipCount, U32 topMip, U32 baseMip, PtrSize baseSize, Bool volume, void* userData)
+{
+	ANKI_ASSERT(size > 0 && mipCount > 0 && mipCount <= MAX_U8);
+	ANKI_ASSERT(topMip <= baseMip && baseMip < mipCount);
+
+	// Find a free handle
+	U32 handle = 0;
+	while(handle < m_entries.getSize() && m_entries[handle])
+	{
+		++handle;
+	}
+
+	if(handle == m_entries.getSize())
+	{
+		const U32 oldSize = m_entries.getSize();
+		m_entries.resize(m_alloc, max<U32>(oldSize * 2, 64));
+		for(U32 i = oldSize; i < m_entries.getSize(); ++i)
+		{
+			m_entries[i] = nullptr;
+		}
+	}
+
+	Entry* e = m_alloc.newInstance<Entry>();
+	e->m_baseSize = baseSize;
+	e->m_size = size;
+	e->m_mipCount = mipCount;
+	e->m_topMip = topMip;
+	e->m_baseMip = baseMip;
+	e->m_residentMip = baseMip;
+	e->m_pendingMip = baseMip;
+	e->m_wantedMip = baseMip;
+	e->m_volume = volume;
+	e->m_userData = userData;
+	m_entries[handle] = e;
+
+	m_committedMemory += computeMemory(*e, baseMip);
+
+	return handle;
+}
+
+void TextureStreamer::unregisterTexture(U32 handle)
+{
+	Entry& e = getEntry(handle);
+	m_committedMemory -= computeMemory(e, e.m_pendingMip);
+
+	m_alloc.deleteInstance(&e);
+	m_entries[handle] = nullptr;
+}
+
+void TextureStreamer::markResident(U32 handle, U32 firstMip)
+{
+	Entry& e = getEntry(handle);
+	ANKI_ASSERT(firstMip >= e.m_topMip && firstMip < e.m_mipCount);
+
+	m_committedMemory -= computeMemory(e, e.m_pendingMip);
+	m_committedMemory += computeMemory(e, firstMip);
+	e.m_residentMip = firstMip;
+	e.m_pendingMip = firstMip;
+}
+
+void TextureStreamer::changePendingMip(U32 handle, U32 mip)
+{
+	Entry& e = getEntry(handle);
+	ANKI_ASSERT(e.m_pendingMip == e.m_residentMip && "Already in flight");
+	ANKI_ASSERT(mip != e.m_pendingMip);
+
+	m_committedMemory -= computeMemory(e, e.m_pendingMip);
+	m_committedMemory += computeMemory(e, mip);
+	e.m_pendingMip = mip;
+
+	if(m_requestCount == m_requests.getSize())
+	{
+		m_requests.resize(m_alloc, max<U32>(m_requests.getSize() * 2, 16));
+	}
+
+	TextureStreamerRequest& req = m_requests[m_requestCount++];
+	req.m_handle = handle;
+	req.m_firstMip = mip;
+}
+
+Bool TextureStreamer::dropLeastRecentlyUsed(U64 frame, U32 excludeHandle)
+{
+	U32 victim = MAX_U32;
+	U64 victimFrame = MAX_U64;
+	U32 victimMip = 0;
+
+	for(U32 handle = 0; handle < m_entries.getSize(); ++handle)
+	{
+		const Entry* e = m_entries[handle];
+		if(e == nullptr || handle == excludeHandle || e->m_pendingMip != e->m_residentMip)
+		{
+			continue;
+		}
+
+		// The unseen textures keep only the base mips, the seen the ones they asked for
+		const U32 keepMip = (isSeen(*e, frame)) ? e->m_wantedMip : e->m_baseMip;
+		if(e->m_residentMip >= keepMip)
+		{
+			continue;
+		}
+
+		if(victim == MAX_U32 || e->m_lastRequestFrame < victimFrame)
+		{
+			victim = handle;
+			victimFrame = e->m_lastRequestFrame;
+			victimMip = keepMip;
+		}
+	}
+
+	if(victim == MAX_U32)
+	{
+		return false;
+	}
+
+	changePendingMip(victim, victimMip);
+	return true;
+}
+
+void TextureStreamer::update(U64 frame, WeakArray<TextureStreamerRequest>& requests)
+{
+	m_requestCount = 0;
+
+	// Gather the requests and find the textures that need more mips
+	DynamicArrayAuto<U32> loads(m_alloc);
+	U32 loadCount = 0;
+
+	for(U32 handle = 0; handle < m_entries.getSize(); ++handle)
+	{
+		Entry* e = m_entries[handle];
+		if(e == nullptr)
+		{
+			continue;
+		}
+
+		const U32 requestedMip = e->m_requestedMip.exchange(MAX_U32);
+		if(requestedMip != MAX_U32)
+		{
+			e->m_lastRequestFrame = frame;
+			e->m_wantedMip = clamp<U32>(requestedMip, e->m_topMip, e->m_baseMip);
+		}
+
+		if(isSeen(*e, frame) && e->m_wantedMip < e->m_residentMip && e->m_pendingMip == e->m_residentMip)
+		{
+			if(loadCount == loads.getSize())
+			{
+				loads.resize(max<U32>(loads.getSize() * 2, 16));
+			}
+
+			loads[loadCount++] = handle;
+		}
+	}
+
+	// Respect the budget even if it changed
+	while(m_committedMemory > m_budget && dropLeastRecentlyUsed(frame, MAX_U32))
+	{
+	}
+
+	// The textures that miss the most mips go first
+	if(loadCount > 0)
+	{
+		std::sort(&loads[0], &loads[0] + loadCount, [&](U32 a, U32 b) {
+			const Entry& ea = *m_entries[a];
+			const Entry& eb = *m_entries[b];
+			const U32 missingA = ea.m_residentMip - ea.m_wantedMip;
+			const U32 missingB = eb.m_residentMip - eb.m_wantedMip;
+			return (missingA != missingB) ? missingA > missingB : a < b;
+		});
+	}
+
+	for(U32 i = 0; i < loadCount; ++i)
+	{
+		const U32 handle = loads[i];
+		const Entry& e = *m_entries[handle];
+
+		// Make room. If there is not enough try fewer mips
+		U32 mip = e.m_wantedMip;
+		while(mip < e.m_residentMip)
+		{
+			const PtrSize extra = computeMemory(e, mip) - computeMemory(e, e.m_residentMip);
+			if(m_committedMemory + extra <= m_budget)
+			{
+				break;
+			}
+
+			if(!dropLeastRecentlyUsed(frame, handle))
+			{
+				++mip;
+			}
+		}
+
+		if(mip < e.m_residentMip)
+		{
+			changePendingMip(handle, mip);
+		}
+	}
+
+	requests = WeakArray<TextureStreamerRequest>((m_requestCount) ? &m_requests[0] : nullptr, m_requestCount);
+}
+
+} // end namespace anki
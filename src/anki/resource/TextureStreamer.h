@@ -0,0 +1,168 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/resource/Common.h>
+#include <anki/util/DynamicArray.h>
+#include <anki/util/Atomic.h>
+
+namespace anki
+{
+
+/// @addtogroup resource
+/// @{
+
+/// A change of the resident mips of a texture that the TextureStreamer decided.
+class TextureStreamerRequest
+{
+public:
+	U32 m_handle;
+	U8 m_firstMip; ///< The new first resident mip. The mips from that to the smallest should be resident.
+};
+
+/// Decides which mips of the streamed textures should be resident. It only does the bookkeeping, the actual loading
+/// is someone else's job so it doesn't need a GPU.
+///
+/// The mip indices are the mip levels of the texture file. Mip 0 is the largest.
+///
+/// Every texture keeps its base mips resident all the time. The renderer requests the mips it needs every frame and
+/// the streamer loads them if they fit in the memory budget. If they don't fit it drops the high mips of the textures
+/// that were not requested for the longest time.
+class TextureStreamer : public NonCopyable
+{
+public:
+	TextureStreamer() = default;
+
+	~TextureStreamer();
+
+	/// @param alloc The allocator.
+	/// @param budget The memory of all the resident mips of all the textures.
+	/// @param unseenFrameCount The frames without requests after which a texture is considered unseen.
+	void init(ResourceAllocator<U8> alloc, PtrSize budget, U32 unseenFrameCount);
+
+	/// Register a texture that has its base mips resident.
+	/// @param size The max size (width, height or depth) of the mip 0.
+	/// @param mipCount The mip count of the texture file.
+	/// @param topMip The largest mip that can be resident. The larger ones are capped by the maxTextureSize.
+	/// @param baseMip The first mip that is always resident.
+	/// @param baseSize The memory of the baseMip. All the faces and layers of it.
+	/// @param volume If true the mips grow 8 times (3D textures) and not 4.
+	/// @param userData Something to identify the texture with.
+	/// @return A handle to the texture.
+	U32 registerTexture(
+		U32 size, U32 mipCount, U32 topMip, U32 baseMip, PtrSize baseSize, Bool volume, void* userData = nullptr);
+
+	void unregisterTexture(U32 handle);
+
+	/// Request a mip of a texture. It's thread-safe.
+	void requestMip(U32 handle, U32 mip)
+	{
+		getEntry(handle).m_requestedMip.min(mip);
+	}
+
+	/// Request the mip that covers some pixels on the screen. It's thread-safe.
+	void requestScreenSize(U32 handle, F32 screenSize)
+	{
+		const Entry& e = getEntry(handle);
+		requestMip(handle, computeRequiredMip(e.m_size, e.m_mipCount, screenSize));
+	}
+
+	/// Gather the requests of the frame and decide what to load and what to drop. The requests will be in flight
+	/// until markResident() is called for them.
+	/// @param frame The current frame. It should grow.
+	/// @param[out] requests The changes of the resident mips. Valid until the next update.
+	void update(U64 frame, WeakArray<TextureStreamerRequest>& requests);
+
+	/// A request was completed.
+	/// @param handle The texture.
+	/// @param firstMip The first resident mip. It's different from the requested one if the loading failed.
+	void markResident(U32 handle, U32 firstMip);
+
+	/// Get the user data of a texture. It's nullptr if the handle is not in use.
+	void* getUserData(U32 handle) const
+	{
+		return (handle < m_entries.getSize() && m_entries[handle]) ? m_entries[handle]->m_userData : nullptr;
+	}
+
+	/// The first resident mip of a texture.
+	U32 getResidentMip(U32 handle) const
+	{
+		return getEntry(handle).m_residentMip;
+	}
+
+	/// The memory of the resident mips plus the memory of the mips that are being loaded.
+	PtrSize getCommittedMemory() const
+	{
+		return m_committedMemory;
+	}
+
+	PtrSize getBudget() const
+	{
+		return m_budget;
+	}
+
+	/// Compute the mip that has at least as many texels as the pixels it covers.
+	/// @param size The max size of the mip 0.
+	/// @param mipCount The number of mips.
+	/// @param screenSize The size on the screen in pixels.
+	static U32 computeRequiredMip(U32 size, U32 mipCount, F32 screenSize);
+
+private:
+	class Entry
+	{
+	public:
+		Atomic<U32> m_requestedMip = {MAX_U32};
+		void* m_userData = nullptr;
+		U64 m_lastRequestFrame = MAX_U64; ///< MAX_U64 if it was never requested.
+		PtrSize m_baseSize = 0;
+		U32 m_size = 0;
+		U8 m_mipCount = 0;
+		U8 m_topMip = 0;
+		U8 m_baseMip = 0;
+		U8 m_residentMip = 0;
+		U8 m_pendingMip = 0; ///< If it's not equal to m_residentMip there is a request in flight.
+		U8 m_wantedMip = 0; ///< The last mip that was requested.
+		Bool8 m_volume = false;
+	};
+
+	ResourceAllocator<U8> m_alloc;
+	DynamicArray<Entry*> m_entries; ///< Indexed by the handles. The unused handles are nullptr.
+	DynamicArray<TextureStreamerRequest> m_requests;
+	U32 m_requestCount = 0;
+	PtrSize m_budget = 0;
+	PtrSize m_committedMemory = 0;
+	U32 m_unseenFrameCount = 0;
+
+	Entry& getEntry(U32 handle)
+	{
+		ANKI_ASSERT(handle < m_entries.getSize() && m_entries[handle]);
+		return *m_entries[handle];
+	}
+
+	const Entry& getEntry(U32 handle) const
+	{
+		ANKI_ASSERT(handle < m_entries.getSize() && m_entries[handle]);
+		return *m_entries[handle];
+	}
+
+	/// The memory of the mips from a mip to the smallest.
+	static PtrSize computeMemory(const Entry& e, U32 firstMip);
+
+	Bool isSeen(const Entry& e, U64 frame) const
+	{
+		return e.m_lastRequestFrame != MAX_U64 && frame - e.m_lastRequestFrame <= m_unseenFrameCount;
+	}
+
+	/// Move the committed mip of a texture and create a request.
+	void changePendingMip(U32 handle, U32 mip);
+
+	/// Drop the high mips of the texture that was not requested for the longest time.
+	/// @return False if there was nothing to drop.
+	Bool dropLeastRecentlyUsed(U64 frame, U32 excludeHandle);
+};
+/// @}
+
+} // end namespace anki
@@ -0,0 +1,277 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/scene/AnimationPlayer.h>
+#include <anki/resource/ResourceManager.h>
+#include <anki/util/ThreadHive.h>
+
+namespace anki
+{
+
+/// A range of players to update in a thread of the hive.
+class AnimationPlayer::Task
+{
+public:
+	AnimationPlayer* const* m_players ANKI_DBG_NULLIFY_PTR;
+	U32 m_begin;
+	U32 m_end;
+	F32 m_crntTime;
+};
+
+AnimationPlayer::~AnimationPlayer()
+{
+	for(U32 i = 0; i < m_animationCount; ++i)
+	{
+		m_animations[i].destroy(m_alloc);
+	}
+
+	if(m_mem)
+	{
+		m_alloc.deallocate(m_mem, 0);
+	}
+}
+
+void AnimationPlayer::init(GenericMemoryPoolAllocator<U8> alloc, SkeletonResourcePtr skeleton)
+{
+	ANKI_ASSERT(m_mem == nullptr);
+	ANKI_ASSERT(skeleton.isCreated());
+	m_alloc = alloc;
+	m_skeleton = skeleton;
+	m_boneCount = m_skeleton->getBones().getSize();
+
+	// Allocate everything at once. The scalars have room for a multiple of 4 bones so the rest stay aligned
+	const PtrSize scalarsSize = getAlignedRoundUp(4, m_boneCount) * sizeof(F32);
+	const PtrSize size = m_boneCount * (sizeof(Vec4) + sizeof(Quat) + 2 * sizeof(Mat3x4)) + 2 * scalarsSize;
+	m_mem = static_cast<U8*>(m_alloc.allocate(size + 16));
+
+	U8* mem = getAlignedRoundUp(16, m_mem);
+	m_positions = reinterpret_cast<Vec4*>(mem);
+	mem += m_boneCount * sizeof(Vec4);
+	m_rotations = reinterpret_cast<Quat*>(mem);
+	mem += m_boneCount * sizeof(Quat);
+	m_boneTransforms = reinterpret_cast<Mat3x4*>(mem);
+	mem += m_boneCount * sizeof(Mat3x4);
+	m_boneMatrices = reinterpret_cast<Mat3x4*>(mem);
+	mem += m_boneCount * sizeof(Mat3x4);
+	m_scales = reinterpret_cast<F32*>(mem);
+	mem += scalarsSize;
+	m_weights = reinterpret_cast<F32*>(mem);
+
+	// Start from the bind pose
+	for(U32 i = 0; i < m_boneCount; ++i)
+	{
+		m_boneMatrices[i] = Mat3x4::getIdentity();
+		m_boneTransforms[i] = Mat3x4(m_skeleton->getBones()[i].getTransform().getInverse());
+	}
+}
+
+U32 AnimationPlayer::play(AnimationResourcePtr anim, F32 crntTime, F32 weight)
+{
+	ANKI_ASSERT(m_mem && "Not initialized");
+	ANKI_ASSERT(anim.isCreated());
+
+	if(m_animationCount == MAX_ANIMATIONS)
+	{
+		return MAX_U32;
+	}
+
+	PlayingAnimation& p = m_animations[m_animationCount];
+	p.m_animation = anim;
+	p.m_startTime = crntTime;
+	p.m_weight = weight;
+
+	// Bind the channels to the bones and start from their bind pose
+	const DynamicArray<AnimationChannel>& channels = anim->getChannels();
+	const U32 channelCount = channels.getSize();
+	p.m_channelBones.create(m_alloc, channelCount);
+	p.m_positions.create(m_alloc, channelCount, Vec4(0.0));
+	p.m_rotations.create(m_alloc, channelCount, Quat::getIdentity());
+	p.m_scales.create(m_alloc, channelCount, 1.0);
+	for(U32 i = 0; i < channelCount; ++i)
+	{
+		const U32 boneIdx = m_skeleton->findBone(channels[i].m_name.toCString());
+		p.m_channelBones[i] = boneIdx;
+
+		if(boneIdx != MAX_U32)
+		{
+			const Bone& bone = m_skeleton->getBones()[boneIdx];
+			p.m_positions[i] = bone.getBindPosition();
+			p.m_rotations[i] = bone.getBindRotation();
+			p.m_scales[i] = bone.getBindScale();
+		}
+	}
+
+	return m_animationCount++;
+}
+
+void AnimationPlayer::stop(U32 idx)
+{
+	ANKI_ASSERT(idx < m_animationCount);
+
+	m_animations[idx].destroy(m_alloc);
+
+	for(U32 i = idx + 1; i < m_animationCount; ++i)
+	{
+		PlayingAnimation& dst = m_animations[i - 1];
+		PlayingAnimation& src = m_animations[i];
+
+		dst.m_animation = src.m_animation;
+		dst.m_channelBones = std::move(src.m_channelBones);
+		dst.m_positions = std::move(src.m_positions);
+		dst.m_rotations = std::move(src.m_rotations);
+		dst.m_scales = std::move(src.m_scales);
+		dst.m_startTime = src.m_startTime;
+		dst.m_weight = src.m_weight;
+		src.m_animation.reset(nullptr);
+	}
+
+	--m_animationCount;
+}
+
+void AnimationPlayer::blend(U32 bone, const Vec4& pos, const Quat& rot, F32 scale, F32 weight)
+{
+	// The rotations that point to the other side of the sphere are flipped before they are added
+	Quat& accumRot = m_rotations[bone];
+	const F32 rotWeight = (accumRot.dot(rot) < 0.0) ? -weight : weight;
+
+	m_positions[bone] += pos * weight;
+	accumRot += rot * rotWeight;
+	m_scales[bone] += scale * weight;
+	m_weights[bone] += weight;
+}
+
+void AnimationPlayer::update(F32 crntTime)
+{
+	const DynamicArray<Bone>& bones = m_skeleton->getBones();
+
+	for(U32 i = 0; i < m_boneCount; ++i)
+	{
+		m_positions[i] = Vec4(0.0);
+		m_rotations[i] = Quat(0.0);
+		m_scales[i] = 0.0;
+		m_weights[i] = 0.0;
+	}
+
+	// Sample the channels of the animations
+	for(U32 a = 0; a < m_animationCount; ++a)
+	{
+		PlayingAnimation& p = m_animations[a];
+		const Animation& anim = *p.m_animation;
+		if(p.m_weight <= 0.0)
+		{
+			continue;
+		}
+
+		F32 time = max<F32>(crntTime - p.m_startTime, 0.0);
+		if(!anim.getRepeat())
+		{
+			time = min(time, anim.getDuration());
+		}
+		time += anim.getStartingTime();
+
+		anim.sample(time, &p.m_positions[0], &p.m_rotations[0], &p.m_scales[0]);
+
+		for(U32 ch = 0; ch < p.m_channelBones.getSize(); ++ch)
+		{
+			const U32 boneIdx = p.m_channelBones[ch];
+			if(boneIdx != MAX_U32)
+			{
+				blend(boneIdx, p.m_positions[ch], p.m_rotations[ch], p.m_scales[ch], p.m_weight);
+			}
+		}
+	}
+
+	// Fill the rest of the weights with the bind pose and normalize
+	for(U32 i = 0; i < m_boneCount; ++i)
+	{
+		const F32 weight = m_weights[i];
+		if(weight < 1.0)
+		{
+			const Bone& bone = bones[i];
+			blend(i, bone.getBindPosition(), bone.getBindRotation(), bone.getBindScale(), 1.0 - weight);
+		}
+		else if(weight > 1.0)
+		{
+			m_positions[i] /= weight;
+			m_scales[i] /= weight;
+		}
+
+		m_rotations[i].normalize();
+	}
+
+	// Walk the hierarchy. The parents are always computed before their children
+	for(U32 i : m_skeleton->getBoneOrder())
+	{
+		const Bone& bone = bones[i];
+		const Mat3x4 local(m_positions[i].xyz(), Mat3(m_rotations[i]), m_scales[i]);
+
+		if(bone.getParent() == MAX_U32)
+		{
+			m_boneTransforms[i] = local;
+		}
+		else
+		{
+			m_boneTransforms[i] = m_boneTransforms[bone.getParent()].combineTransformations(local);
+		}
+
+		m_boneMatrices[i] = m_boneTransforms[i].combineTransformations(bone.getOffsetTransform());
+	}
+}
+
+void AnimationPlayer::updateCallback(void* arg, U32 threadId, ThreadHive& hive)
+{
+	const Task& task = *static_cast<const Task*>(arg);
+
+	for(U32 i = task.m_begin; i < task.m_end; ++i)
+	{
+		task.m_players[i]->update(task.m_crntTime);
+	}
+}
+
+void AnimationPlayer::updateMany(WeakArray<AnimationPlayer*> players, F32 crntTime, ThreadHive* hive)
+{
+	const U32 playerCount = players.getSize();
+	if(playerCount == 0)
+	{
+		return;
+	}
+
+	U32 taskCount = 1;
+	if(hive)
+	{
+		taskCount = min<U32>(min<U32>(hive->getThreadCount(), ThreadHive::MAX_THREADS), playerCount);
+	}
+
+	if(taskCount == 1)
+	{
+		for(AnimationPlayer* player : players)
+		{
+			player->update(crntTime);
+		}
+
+		return;
+	}
+
+	const U32 taskSize = (playerCount + taskCount - 1) / taskCount;
+
+	Array<Task, ThreadHive::MAX_THREADS> tasks;
+	Array<ThreadHiveTask, ThreadHive::MAX_THREADS> hiveTasks;
+	for(U32 i = 0; i < taskCount; ++i)
+	{
+		Task& task = tasks[i];
+		task.m_players = &players[0];
+		task.m_begin = min(i * taskSize, playerCount);
+		task.m_end = min(task.m_begin + taskSize, playerCount);
+		task.m_crntTime = crntTime;
+
+		hiveTasks[i].m_callback = updateCallback;
+		hiveTasks[i].m_argument = &task;
+	}
+
+	hive->submitTasks(&hiveTasks[0], taskCount);
+	hive->waitAllTasks();
+}
+
+} // end namespace anki
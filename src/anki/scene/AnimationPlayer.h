@@ -0,0 +1,146 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/scene/Common.h>
+#include <anki/resource/Skeleton.h>
+#include <anki/resource/Animation.h>
+#include <anki/Math.h>
+
+namespace anki
+{
+
+// Forward
+class ThreadHive;
+
+/// @addtogroup scene
+/// @{
+
+/// Plays the animations of a skeleton and computes the matrices that skin the meshes. Many animations can play at the
+/// same time and they are blended by their weights. It doesn't depend on the scene so it can be updated in isolation.
+class AnimationPlayer : public NonCopyable
+{
+public:
+	/// The maximum number of animations that can be blended.
+	static const U MAX_ANIMATIONS = 4;
+
+	AnimationPlayer() = default;
+
+	~AnimationPlayer();
+
+	void init(GenericMemoryPoolAllocator<U8> alloc, SkeletonResourcePtr skeleton);
+
+	const Skeleton& getSkeleton() const
+	{
+		return *m_skeleton;
+	}
+
+	/// Start playing an animation. Its channels animate the bones with the same name.
+	/// @param anim The animation.
+	/// @param crntTime The current time. The animation starts from its beginning.
+	/// @param weight The weight of the animation in the blend.
+	/// @return The index of the animation or MAX_U32 if MAX_ANIMATIONS are already playing.
+	U32 play(AnimationResourcePtr anim, F32 crntTime, F32 weight = 1.0);
+
+	/// Stop playing an animation. The animations that come after it move one index down.
+	void stop(U32 idx);
+
+	/// Set the weight of a playing animation. Use it to fade the animations in and out.
+	void setWeight(U32 idx, F32 weight)
+	{
+		ANKI_ASSERT(idx < m_animationCount);
+		m_animations[idx].m_weight = weight;
+	}
+
+	U32 getAnimationCount() const
+	{
+		return m_animationCount;
+	}
+
+	/// Sample and blend the animations and compute the bone matrices. If the weights of a bone add up to less than 1.0
+	/// the rest is taken from the bind pose.
+	void update(F32 crntTime);
+
+	/// Update many players at once.
+	/// @param players The players.
+	/// @param crntTime The current time.
+	/// @param hive If it's not nullptr the players are split across the threads of the hive.
+	static void updateMany(WeakArray<AnimationPlayer*> players, F32 crntTime, ThreadHive* hive = nullptr);
+
+	/// The matrices that move the vertices from the bind pose to the current pose. One per bone in the order of
+	/// Skeleton::getBones().
+	const Mat3x4* getBoneMatrices() const
+	{
+		return m_boneMatrices;
+	}
+
+	/// Same as getBoneMatrices() in model space without the inverse bind pose. Use it to attach things to the bones.
+	const Mat3x4* getBoneTransforms() const
+	{
+		return m_boneTransforms;
+	}
+
+	U32 getBoneCount() const
+	{
+		return m_boneCount;
+	}
+
+private:
+	class Task;
+
+	/// A playing animation.
+	class PlayingAnimation
+	{
+	public:
+		AnimationResourcePtr m_animation;
+		DynamicArray<U32> m_channelBones; ///< The bone of every channel of the animation or MAX_U32.
+
+		/// @name The samples of the channels. The channels without keys keep the bind pose.
+		/// @{
+		DynamicArray<Vec4> m_positions;
+		DynamicArray<Quat> m_rotations;
+		DynamicArray<F32> m_scales;
+		/// @}
+
+		F32 m_startTime = 0.0;
+		F32 m_weight = 0.0;
+
+		void destroy(GenericMemoryPoolAllocator<U8> alloc)
+		{
+			m_channelBones.destroy(alloc);
+			m_positions.destroy(alloc);
+			m_rotations.destroy(alloc);
+			m_scales.destroy(alloc);
+			m_animation.reset(nullptr);
+		}
+	};
+
+	GenericMemoryPoolAllocator<U8> m_alloc;
+	SkeletonResourcePtr m_skeleton;
+	Array<PlayingAnimation, MAX_ANIMATIONS> m_animations;
+	U32 m_animationCount = 0;
+
+	/// @name The pose. They point to m_mem and they are aligned to 16 bytes.
+	/// @{
+	Vec4* m_positions = nullptr;
+	Quat* m_rotations = nullptr;
+	F32* m_scales = nullptr;
+	F32* m_weights = nullptr;
+	Mat3x4* m_boneTransforms = nullptr;
+	Mat3x4* m_boneMatrices = nullptr;
+	/// @}
+
+	U8* m_mem = nullptr;
+	U32 m_boneCount = 0;
+
+	/// Add a sample to the blend of a bone.
+	void blend(U32 bone, const Vec4& pos, const Quat& rot, F32 scale, F32 weight);
+
+	static void updateCallback(void* arg, U32 threadId, ThreadHive& hive);
+};
+/// @}
+
+} // end namespace anki
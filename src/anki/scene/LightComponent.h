@@ -135,6 +135,28 @@ public:
 		m_shadowMapIndex = static_cast<U8>(i);
 	}
 
+	/// The light didn't get a shadow map this frame.
+	void unsetShadowMapIndex()
+	{
+		m_shadowMapIndex = 0xFF;
+	}
+
+	Bool hasShadowMapIndex() const
+	{
+		return m_shadowMapIndex != 0xFF;
+	}
+
+	/// The region of the shadow map. xy is the scale and zw the offset of the texture coordinates.
+	const Vec4& getShadowMapRegion() const
+	{
+		return m_shadowMapRegion;
+	}
+
+	void setShadowMapRegion(const Vec4& x)
+	{
+		m_shadowMapRegion = x;
+	}
+
 	ANKI_USE_RESULT Error update(SceneNode&, F32, F32, Bool& updated) override;
 
 private:
@@ -153,6 +175,7 @@ private:
 
 	Bool8 m_shadow = false;
 	U8 m_shadowMapIndex = 0xFF; ///< Used by the renderer
+	Vec4 m_shadowMapRegion = Vec4(1.0, 1.0, 0.0, 0.0); ///< Used by the renderer
 
 	Bool8 m_dirty = true;
 };
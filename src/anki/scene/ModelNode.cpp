@@ -6,6 +6,7 @@
 #include <anki/scene/ModelNode.h>
 #include <anki/scene/SceneGraph.h>
 #include <anki/scene/BodyComponent.h>
+#include <anki/scene/SkinComponent.h>
 #include <anki/scene/Misc.h>
 #include <anki/resource/Model.h>
 #include <anki/resource/ResourceManager.h>
@@ -33,6 +34,13 @@ public:
 	{
 		return getNode().buildRendering(in, out);
 	}
+
+	U getLodErrors(Array<F32, MAX_LODS>& errors) const override
+	{
+		const ModelPatch& patch = *getNode().m_modelPatch;
+		const F32 scale = getNode().getParent()->getComponent<MoveComponent>().getWorldTransform().getScale();
+		return patch.getLodErrors(scale, errors);
+	}
 };
 
 ModelPatchNode::ModelPatchNode(SceneGraph* scene, CString name)
@@ -84,9 +92,17 @@ Error ModelPatchNode::buildRendering(const RenderingBuildInfoIn& in, RenderingBu
 	out.m_drawcall.m_elements.m_count = modelInf.m_indicesCountArray[0];
 	out.m_drawcall.m_elements.m_instanceCount = in.m_key.m_instanceCount;
 	out.m_drawcall.m_elements.m_firstIndex = modelInf.m_indicesOffsetArray[0] / sizeof(U16);
+	out.m_drawcall.m_elements.m_baseVertex = modelInf.m_baseVertex;
 
 	out.m_hasTransform = true;
-	out.m_transform = Mat4(getParent()->getComponent<MoveComponent>().getWorldTransform());
+	out.m_transform =
+		Mat4(getParent()->getComponent<MoveComponent>().getWorldTransform()) * modelInf.m_dequantizationTransform;
+
+	const SkinComponent* skin = getParent()->tryGetComponent<SkinComponent>();
+	if(skin)
+	{
+		out.m_boneMatrices = &skin->getBoneMatricesToken();
+	}
 
 	return ErrorCode::NONE;
 }
@@ -154,6 +170,13 @@ Error ModelNode::init(const CString& modelFname)
 	comp = getSceneAllocator().newInstance<ModelMoveFeedbackComponent>(this);
 	addComponent(comp, true);
 
+	// Skin component
+	if(m_model->getSkeleton().isCreated())
+	{
+		comp = getSceneAllocator().newInstance<SkinComponent>(this, m_model->getSkeleton());
+		addComponent(comp, true);
+	}
+
 	return ErrorCode::NONE;
 }
 
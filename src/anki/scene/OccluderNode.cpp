@@ -50,16 +50,13 @@ Error OccluderNode::init(const CString& meshFname)
 
 	const U16* indices = reinterpret_cast<const U16*>(loader.getIndexData());
 	U indexCount = loader.getIndexDataSize() / sizeof(U16);
-	U vertSize = loader.getVertexSize();
 
 	m_vertsL.create(getSceneAllocator(), indexCount);
 	m_vertsW.create(getSceneAllocator(), indexCount);
 
 	for(U i = 0; i < indexCount; ++i)
 	{
-		U idx = indices[i];
-		const Vec3* vert = reinterpret_cast<const Vec3*>(loader.getVertexData() + idx * vertSize);
-		m_vertsL[i] = *vert;
+		m_vertsL[i] = loader.getPositions()[indices[i]];
 	}
 
 	// Create the components
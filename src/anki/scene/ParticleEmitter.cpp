@@ -15,65 +15,6 @@
 namespace anki
 {
 
-static F32 getRandom(F32 initial, F32 deviation)
-{
-	return (deviation == 0.0) ? initial : initial + randFloat(deviation) * 2.0 - deviation;
-}
-
-static Vec3 getRandom(const Vec3& initial, const Vec3& deviation)
-{
-	if(deviation == Vec3(0.0))
-	{
-		return initial;
-	}
-	else
-	{
-		Vec3 out;
-		for(U i = 0; i < 3; i++)
-		{
-			out[i] = getRandom(initial[i], deviation[i]);
-		}
-		return out;
-	}
-}
-
-void ParticleBase::revive(const ParticleEmitter& pe, const Transform& trf, F32 /*prevUpdateTime*/, F32 crntTime)
-{
-	ANKI_ASSERT(isDead());
-	const ParticleEmitterProperties& props = pe;
-
-	// life
-	m_timeOfDeath = getRandom(crntTime + props.m_particle.m_life, props.m_particle.m_lifeDeviation);
-	m_timeOfBirth = crntTime;
-}
-
-void ParticleSimple::simulate(const ParticleEmitter& pe, F32 prevUpdateTime, F32 crntTime)
-{
-	F32 dt = crntTime - prevUpdateTime;
-
-	Vec4 xp = m_position;
-	Vec4 xc = m_acceleration * (dt * dt) + m_velocity * dt + xp;
-
-	m_position = xc;
-
-	m_velocity += m_acceleration * dt;
-}
-
-void ParticleSimple::revive(const ParticleEmitter& pe, const Transform& trf, F32 prevUpdateTime, F32 crntTime)
-{
-	ParticleBase::revive(pe, trf, prevUpdateTime, crntTime);
-	m_velocity = Vec4(0.0);
-
-	const ParticleEmitterProperties& props = pe;
-
-	m_acceleration = getRandom(props.m_particle.m_gravity, props.m_particle.m_gravityDeviation).xyz0();
-
-	// Set the initial position
-	m_position = getRandom(props.m_particle.m_startingPos, props.m_particle.m_startingPosDeviation).xyz0();
-
-	m_position += trf.getOrigin();
-}
-
 #if 0
 
 
@@ -210,16 +151,6 @@ ParticleEmitter::ParticleEmitter(SceneGraph* scene, CString name)
 
 ParticleEmitter::~ParticleEmitter()
 {
-	// Delete simple particles
-	if(m_simulationType == SimulationType::SIMPLE)
-	{
-		for(ParticleBase* part : m_particles)
-		{
-			getSceneAllocator().deleteInstance(part);
-		}
-	}
-
-	m_particles.destroy(getSceneAllocator());
 }
 
 Error ParticleEmitter::init(const CString& filename)
@@ -270,23 +201,34 @@ Error ParticleEmitter::init(const CString& filename)
 	}
 
 	// Create the vertex buffer and object
-	m_vertBuffSize = m_maxNumOfParticles * VERTEX_SIZE;
+	m_vertBuffSize = m_maxNumOfParticles * ParticleSimulation::VERTEX_SIZE;
 
 	GrManager& gr = getSceneGraph().getGrManager();
 
-	ResourceGroupInitInfo rcinit;
-	m_particleEmitterResource->getMaterial().fillResourceGroupInitInfo(rcinit);
-
 	for(U i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
 	{
 		m_vertBuffs[i] = gr.newInstance<Buffer>(m_vertBuffSize, BufferUsageBit::VERTEX, BufferMapAccessBit::WRITE);
+	}
+
+	createResourceGroups();
+
+	return ErrorCode::NONE;
+}
 
+void ParticleEmitter::createResourceGroups()
+{
+	Material& mtl = m_particleEmitterResource->getMaterial();
+
+	ResourceGroupInitInfo rcinit;
+	mtl.fillResourceGroupInitInfo(rcinit);
+	m_texturesVersion = mtl.getTexturesVersion();
+
+	for(U i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+	{
 		rcinit.m_vertexBuffers[0].m_buffer = m_vertBuffs[i];
 
-		m_grGroups[i] = gr.newInstance<ResourceGroup>(rcinit);
+		m_grGroups[i] = getSceneGraph().getGrManager().newInstance<ResourceGroup>(rcinit);
 	}
-
-	return ErrorCode::NONE;
 }
 
 Error ParticleEmitter::buildRendering(const RenderingBuildInfoIn& in, RenderingBuildInfoOut& out) const
@@ -306,7 +248,7 @@ Error ParticleEmitter::buildRendering(const RenderingBuildInfoIn& in, RenderingB
 
 	VertexStateInfo& vertState = out.m_state->m_vertex;
 	vertState.m_bindingCount = 1;
-	vertState.m_bindings[0].m_stride = VERTEX_SIZE;
+	vertState.m_bindings[0].m_stride = ParticleSimulation::VERTEX_SIZE;
 	vertState.m_attributeCount = 3;
 	vertState.m_attributes[0].m_format = PixelFormat(ComponentFormat::R32G32B32, TransformFormat::FLOAT);
 	vertState.m_attributes[0].m_offset = 0;
@@ -373,91 +315,48 @@ void ParticleEmitter::createParticlesSimulation(SceneGraph* scene)
 
 void ParticleEmitter::createParticlesSimpleSimulation()
 {
-	m_particles.create(getSceneAllocator(), m_maxNumOfParticles);
+	m_simulation.init(getSceneAllocator(), m_maxNumOfParticles);
+}
 
-	for(U i = 0; i < m_maxNumOfParticles; i++)
+Error ParticleEmitter::frameUpdate(F32 prevUpdateTime, F32 crntTime)
+{
+	// The streamed textures of the material changed their resident mips
+	if(m_particleEmitterResource->getMaterial().getTexturesVersion() != m_texturesVersion)
 	{
-		ParticleSimple* part = getSceneAllocator().newInstance<ParticleSimple>();
-
-		part->m_size = getRandom(m_particle.m_size, m_particle.m_sizeDeviation);
-		part->m_alpha = getRandom(m_particle.m_alpha, m_particle.m_alphaDeviation);
+		createResourceGroups();
+	}
 
-		m_particles[i] = part;
+	// The nodes update in parallel and they can't share the hive. The scene simulates the large emitters across the
+	// hive after the node update
+	if(m_simulation.getAliveParticleCount() > ParticleSimulation::PARALLEL_PARTICLE_COUNT)
+	{
+		getSceneGraph().deferParticleEmitterSimulation(*this);
+	}
+	else
+	{
+		simulate(prevUpdateTime, crntTime, nullptr);
 	}
+
+	return ErrorCode::NONE;
 }
 
-Error ParticleEmitter::frameUpdate(F32 prevUpdateTime, F32 crntTime)
+void ParticleEmitter::simulate(F32 prevUpdateTime, F32 crntTime, ThreadHive* hive)
 {
 	// - Deactivate the dead particles
 	// - Calc the AABB
 	// - Calc the instancing stuff
 	//
-	Vec4 aabbmin(MAX_F32, MAX_F32, MAX_F32, 0.0);
-	Vec4 aabbmax(MIN_F32, MIN_F32, MIN_F32, 0.0);
-	m_aliveParticlesCount = 0;
-
 	U frame = getGlobalTimestamp() % 3;
-	F32* verts = static_cast<F32*>(m_vertBuffs[frame]->map(0, m_vertBuffSize, BufferMapAccessBit::WRITE));
-	const F32* verts_base = verts;
-	(void)verts_base;
+	void* verts = m_vertBuffs[frame]->map(0, m_vertBuffSize, BufferMapAccessBit::WRITE);
 
-	for(ParticleBase* p : m_particles)
-	{
-		if(p->isDead())
-		{
-			// if its already dead so dont deactivate it again
-			continue;
-		}
-
-		if(p->getTimeOfDeath() < crntTime)
-		{
-			// Just died
-			p->kill();
-		}
-		else
-		{
-			// It's alive
-
-			// Do checks
-			ANKI_ASSERT((PtrSize(verts) + VERTEX_SIZE - PtrSize(verts_base)) <= m_vertBuffSize);
-
-			// This will calculate a new world transformation
-			p->simulate(*this, prevUpdateTime, crntTime);
-
-			const Vec4& origin = p->getPosition();
-
-			for(U i = 0; i < 3; i++)
-			{
-				aabbmin[i] = std::min(aabbmin[i], origin[i]);
-				aabbmax[i] = std::max(aabbmax[i], origin[i]);
-			}
-
-			F32 lifePercent = (crntTime - p->getTimeOfBirth()) / (p->getTimeOfDeath() - p->getTimeOfBirth());
-
-			verts[0] = origin.x();
-			verts[1] = origin.y();
-			verts[2] = origin.z();
-
-			// XXX set a flag for scale
-			verts[3] = p->m_size + (lifePercent * m_particle.m_sizeAnimation);
-
-			// Set alpha
-			if(m_particle.m_alphaAnimation)
-			{
-				verts[4] = sin((lifePercent)*PI) * p->m_alpha;
-			}
-			else
-			{
-				verts[4] = p->m_alpha;
-			}
-
-			++m_aliveParticlesCount;
-			verts += 5;
-		}
-	}
+	Vec4 aabbmin, aabbmax;
+	m_simulation.update(*this, prevUpdateTime, crntTime, verts, aabbmin, aabbmax, hive);
 
 	m_vertBuffs[frame]->unmap();
 
+	// The particles that will be emitted below will be drawn in the next frame
+	m_aliveParticlesCount = m_simulation.getAliveParticleCount();
+
 	if(m_aliveParticlesCount != 0)
 	{
 		Vec4 min = aabbmin - m_particle.m_size;
@@ -480,25 +379,7 @@ Error ParticleEmitter::frameUpdate(F32 prevUpdateTime, F32 crntTime)
 	{
 		MoveComponent& move = getComponent<MoveComponent>();
 
-		U particlesCount = 0; // How many particles I am allowed to emmit
-		for(ParticleBase* pp : m_particles)
-		{
-			ParticleBase& p = *pp;
-			if(!p.isDead())
-			{
-				// its alive so skip it
-				continue;
-			}
-
-			p.revive(*this, move.getWorldTransform(), prevUpdateTime, crntTime);
-
-			// do the rest
-			++particlesCount;
-			if(particlesCount >= m_particlesPerEmittion)
-			{
-				break;
-			}
-		} // end for all particles
+		m_simulation.emit(*this, move.getWorldTransform().getOrigin(), crntTime, m_particlesPerEmittion);
 
 		m_timeLeftForNextEmission = m_emissionPeriod;
 	} // end if can emit
@@ -506,8 +387,6 @@ Error ParticleEmitter::frameUpdate(F32 prevUpdateTime, F32 crntTime)
 	{
 		m_timeLeftForNextEmission -= crntTime - prevUpdateTime;
 	}
-
-	return ErrorCode::NONE;
 }
 
 } // end namespace anki
@@ -9,116 +9,15 @@
 #include <anki/scene/MoveComponent.h>
 #include <anki/scene/SpatialComponent.h>
 #include <anki/scene/RenderComponent.h>
+#include <anki/scene/ParticleSimulation.h>
 #include <anki/resource/ParticleEmitterResource.h>
 
 namespace anki
 {
 
-class ParticleEmitter;
-
 /// @addtogroup scene
 /// @{
 
-/// Particle base
-class ParticleBase
-{
-	friend class ParticleEmitter;
-
-public:
-	ParticleBase()
-	{
-	}
-
-	virtual ~ParticleBase()
-	{
-	}
-
-	F32 getTimeOfBirth() const
-	{
-		return m_timeOfBirth;
-	}
-
-	F32& getTimeOfBirth()
-	{
-		return m_timeOfBirth;
-	}
-
-	void setTimeOfBirth(const F32 x)
-	{
-		m_timeOfBirth = x;
-	}
-
-	F32 getTimeOfDeath() const
-	{
-		return m_timeOfDeath;
-	}
-
-	F32& getTimeOfDeath()
-	{
-		return m_timeOfDeath;
-	}
-
-	void setTimeOfDeath(const F32 x)
-	{
-		m_timeOfDeath = x;
-	}
-
-	Bool isDead() const
-	{
-		return m_timeOfDeath < 0.0;
-	}
-
-	/// Kill the particle
-	virtual void kill()
-	{
-		ANKI_ASSERT(m_timeOfDeath > 0.0);
-		m_timeOfDeath = -1.0;
-	}
-
-	/// Revive the particle
-	virtual void revive(const ParticleEmitter& pe, const Transform& trf, F32 prevUpdateTime, F32 crntTime);
-
-	/// Only relevant for non-bullet simulations
-	virtual void simulate(const ParticleEmitter& pe, F32 prevUpdateTime, F32 crntTime)
-	{
-		(void)pe;
-		(void)prevUpdateTime;
-		(void)crntTime;
-	}
-
-	virtual const Vec4& getPosition() const = 0;
-
-protected:
-	F32 m_timeOfBirth; ///< Keep the time of birth for nice effects
-	F32 m_timeOfDeath = -1.0; ///< Time of death. If < 0.0 then dead
-	F32 m_size = 1.0;
-	F32 m_alpha = 1.0;
-};
-
-/// Simple particle for simple simulation
-class ParticleSimple : public ParticleBase
-{
-public:
-	ParticleSimple()
-	{
-	}
-
-	void revive(const ParticleEmitter& pe, const Transform& trf, F32 prevUpdateTime, F32 crntTime) override;
-
-	void simulate(const ParticleEmitter& pe, F32 prevUpdateTime, F32 crntTime) override;
-
-	const Vec4& getPosition() const override
-	{
-		return m_position;
-	}
-
-private:
-	/// The velocity
-	Vec4 m_velocity = Vec4(0.0);
-	Vec4 m_acceleration = Vec4(0.0);
-	Vec4 m_position;
-};
-
 #if 0
 /// Particle for bullet simulations
 class Particle: public ParticleBase
@@ -148,9 +47,7 @@ private:
 /// The particle emitter scene node. This scene node emitts
 class ParticleEmitter : public SceneNode, private ParticleEmitterProperties
 {
-	friend class ParticleBase;
 	friend class Particle;
-	friend class ParticleSimple;
 	friend class ParticleEmitterRenderComponent;
 	friend class MoveFeedbackComponent;
 
@@ -166,6 +63,11 @@ public:
 	ANKI_USE_RESULT Error frameUpdate(F32 prevUpdateTime, F32 crntTime) override;
 	/// @}
 
+anki_internal:
+	/// Move the particles, write the vertices and emit the new ones.
+	/// @param hive If it's not nullptr the simulation is split across its threads. The caller should own the hive.
+	void simulate(F32 prevUpdateTime, F32 crntTime, ThreadHive* hive);
+
 private:
 	enum class SimulationType : U8
 	{
@@ -174,11 +76,8 @@ private:
 		PHYSICS_ENGINE
 	};
 
-	/// Size of a single vertex.
-	static const U VERTEX_SIZE = 5 * sizeof(F32);
-
 	ParticleEmitterResourcePtr m_particleEmitterResource;
-	DynamicArray<ParticleBase*> m_particles;
+	ParticleSimulation m_simulation;
 	F32 m_timeLeftForNextEmission = 0.0;
 	Obb m_obb;
 
@@ -192,6 +91,7 @@ private:
 	U32 m_vertBuffSize = 0;
 	Array<BufferPtr, MAX_FRAMES_IN_FLIGHT> m_vertBuffs;
 	Array<ResourceGroupPtr, MAX_FRAMES_IN_FLIGHT> m_grGroups;
+	U32 m_texturesVersion = 0; ///< The Material::getTexturesVersion() of m_grGroups.
 	/// @}
 
 	SimulationType m_simulationType = SimulationType::UNDEFINED;
@@ -199,6 +99,8 @@ private:
 	void createParticlesSimulation(SceneGraph* scene);
 	void createParticlesSimpleSimulation();
 
+	void createResourceGroups();
+
 	ANKI_USE_RESULT Error buildRendering(const RenderingBuildInfoIn& in, RenderingBuildInfoOut& out) const;
 
 	void onMoveComponentUpdate(MoveComponent& move);
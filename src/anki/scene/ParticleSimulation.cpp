@@ -0,0 +1,345 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/scene/ParticleSimulation.h>
+#include <anki/util/ThreadHive.h>
+#include <anki/util/Functions.h>
+
+namespace anki
+{
+
+static F32 getRandom(F32 initial, F32 deviation)
+{
+	return (deviation == 0.0) ? initial : initial + randFloat(deviation) * 2.0 - deviation;
+}
+
+static Vec3 getRandom(const Vec3& initial, const Vec3& deviation)
+{
+	if(deviation == Vec3(0.0))
+	{
+		return initial;
+	}
+	else
+	{
+		Vec3 out;
+		for(U i = 0; i < 3; i++)
+		{
+			out[i] = getRandom(initial[i], deviation[i]);
+		}
+		return out;
+	}
+}
+
+/// Approximation of sin(x * PI) for x in [0, 1]. Bhaskara's formula, the max error is 0.0016.
+static F32 sinPi(F32 x)
+{
+	const F32 a = x * (1.0f - x);
+	return 16.0f * a / (5.0f - 4.0f * a);
+}
+
+/// A range of the particles that a thread simulates.
+class ParticleSimulation::Task
+{
+public:
+	const ParticleSimulation* m_sim ANKI_DBG_NULLIFY_PTR;
+	const ParticleEmitterProperties* m_props ANKI_DBG_NULLIFY_PTR;
+	F32* m_verts ANKI_DBG_NULLIFY_PTR;
+	U32 m_begin;
+	U32 m_end;
+	F32 m_dt;
+	F32 m_crntTime;
+	Vec4 m_aabbMin;
+	Vec4 m_aabbMax;
+};
+
+ParticleSimulation::~ParticleSimulation()
+{
+	if(m_mem)
+	{
+		m_alloc.deallocate(m_mem, 0);
+	}
+}
+
+void ParticleSimulation::init(GenericMemoryPoolAllocator<U8> alloc, U32 maxParticleCount)
+{
+	ANKI_ASSERT(m_mem == nullptr);
+	m_alloc = alloc;
+	m_maxCount = maxParticleCount;
+
+	// Every attribute has room for a multiple of 4 particles so every one of them stays aligned
+	const PtrSize attribSize = getAlignedRoundUp(4, maxParticleCount);
+	m_mem = reinterpret_cast<F32*>(m_alloc.allocate(attribSize * sizeof(F32) * ATTRIBUTE_COUNT + 16));
+
+	F32* mem = getAlignedRoundUp(16, m_mem);
+	for(U i = 0; i < ATTRIBUTE_COUNT; ++i)
+	{
+		m_attribs[i] = mem + i * attribSize;
+	}
+}
+
+U32 ParticleSimulation::emit(const ParticleEmitterProperties& props, const Vec4& origin, F32 crntTime, U32 count)
+{
+	const U32 end = min(m_aliveCount + count, m_maxCount);
+	count = end - m_aliveCount;
+
+	for(U32 i = m_aliveCount; i < end; ++i)
+	{
+		m_attribs[TIME_OF_BIRTH][i] = crntTime;
+		m_attribs[TIME_OF_DEATH][i] = getRandom(crntTime + props.m_particle.m_life, props.m_particle.m_lifeDeviation);
+
+		const Vec3 pos = getRandom(props.m_particle.m_startingPos, props.m_particle.m_startingPosDeviation);
+		const Vec3 acc = getRandom(props.m_particle.m_gravity, props.m_particle.m_gravityDeviation);
+
+		for(U j = 0; j < 3; ++j)
+		{
+			m_attribs[POSITION_X + j][i] = pos[j] + origin[j];
+			m_attribs[VELOCITY_X + j][i] = 0.0;
+			m_attribs[ACCELERATION_X + j][i] = acc[j];
+		}
+
+		m_attribs[SIZE][i] = getRandom(props.m_particle.m_size, props.m_particle.m_sizeDeviation);
+		m_attribs[ALPHA][i] = getRandom(props.m_particle.m_alpha, props.m_particle.m_alphaDeviation);
+	}
+
+	m_aliveCount = end;
+	return count;
+}
+
+void ParticleSimulation::killDead(F32 crntTime)
+{
+	const F32* death = m_attribs[TIME_OF_DEATH];
+
+	U32 i = 0;
+	while(i < m_aliveCount)
+	{
+#if ANKI_SIMD == ANKI_SIMD_SSE
+		// Most of the particles are alive, skip them 4 at a time
+		if(i + 4 <= m_aliveCount
+			&& _mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(death + i), _mm_set1_ps(crntTime))) == 0)
+		{
+			i += 4;
+			continue;
+		}
+#endif
+
+		if(death[i] < crntTime)
+		{
+			// Move the last one here and check it again
+			--m_aliveCount;
+			for(U a = 0; a < ATTRIBUTE_COUNT; ++a)
+			{
+				m_attribs[a][i] = m_attribs[a][m_aliveCount];
+			}
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+void ParticleSimulation::simulateRange(const ParticleEmitterProperties& props,
+	U32 begin,
+	U32 end,
+	F32 dt,
+	F32 crntTime,
+	F32* verts,
+	Vec4& aabbMin,
+	Vec4& aabbMax) const
+{
+	ANKI_ASSERT((begin % 4) == 0 && begin <= end && end <= m_aliveCount);
+
+	F32* pos[3] = {m_attribs[POSITION_X], m_attribs[POSITION_Y], m_attribs[POSITION_Z]};
+	F32* vel[3] = {m_attribs[VELOCITY_X], m_attribs[VELOCITY_Y], m_attribs[VELOCITY_Z]};
+	const F32* acc[3] = {m_attribs[ACCELERATION_X], m_attribs[ACCELERATION_Y], m_attribs[ACCELERATION_Z]};
+	const F32* birth = m_attribs[TIME_OF_BIRTH];
+	const F32* death = m_attribs[TIME_OF_DEATH];
+	const F32* size = m_attribs[SIZE];
+	const F32* alpha = m_attribs[ALPHA];
+
+	const F32 dt2 = dt * dt;
+	const F32 sizeAnimation = props.m_particle.m_sizeAnimation;
+	const Bool alphaAnimation = props.m_particle.m_alphaAnimation;
+
+	Vec4 mn(MAX_F32, MAX_F32, MAX_F32, 0.0);
+	Vec4 mx(MIN_F32, MIN_F32, MIN_F32, 0.0);
+
+	U32 i = begin;
+
+#if ANKI_SIMD == ANKI_SIMD_SSE
+	{
+		const __m128 dtv = _mm_set1_ps(dt);
+		const __m128 dt2v = _mm_set1_ps(dt2);
+		const __m128 crntTimev = _mm_set1_ps(crntTime);
+		const __m128 sizeAnimationv = _mm_set1_ps(sizeAnimation);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 four = _mm_set1_ps(4.0f);
+		const __m128 five = _mm_set1_ps(5.0f);
+		const __m128 sixteen = _mm_set1_ps(16.0f);
+
+		__m128 mnv[3] = {_mm_set1_ps(MAX_F32), _mm_set1_ps(MAX_F32), _mm_set1_ps(MAX_F32)};
+		__m128 mxv[3] = {_mm_set1_ps(MIN_F32), _mm_set1_ps(MIN_F32), _mm_set1_ps(MIN_F32)};
+
+		for(; i + 4 <= end; i += 4)
+		{
+			// Integrate
+			__m128 p[3];
+			for(U j = 0; j < 3; ++j)
+			{
+				const __m128 a = _mm_load_ps(acc[j] + i);
+				const __m128 v = _mm_load_ps(vel[j] + i);
+
+				p[j] = _mm_add_ps(_mm_load_ps(pos[j] + i), _mm_add_ps(_mm_mul_ps(a, dt2v), _mm_mul_ps(v, dtv)));
+				_mm_store_ps(pos[j] + i, p[j]);
+				_mm_store_ps(vel[j] + i, _mm_add_ps(v, _mm_mul_ps(a, dtv)));
+
+				mnv[j] = _mm_min_ps(mnv[j], p[j]);
+				mxv[j] = _mm_max_ps(mxv[j], p[j]);
+			}
+
+			// Animate
+			const __m128 b = _mm_load_ps(birth + i);
+			const __m128 lifePercent =
+				_mm_div_ps(_mm_sub_ps(crntTimev, b), _mm_sub_ps(_mm_load_ps(death + i), b));
+
+			__m128 s = _mm_add_ps(_mm_load_ps(size + i), _mm_mul_ps(lifePercent, sizeAnimationv));
+			__m128 al = _mm_load_ps(alpha + i);
+			if(alphaAnimation)
+			{
+				const __m128 x = _mm_mul_ps(lifePercent, _mm_sub_ps(one, lifePercent));
+				const __m128 sinv = _mm_div_ps(_mm_mul_ps(sixteen, x), _mm_sub_ps(five, _mm_mul_ps(four, x)));
+				al = _mm_mul_ps(sinv, al);
+			}
+
+			// Write the vertices. Transpose to get the position and the size of every particle in one register
+			__m128 x = p[0];
+			__m128 y = p[1];
+			__m128 z = p[2];
+			_MM_TRANSPOSE4_PS(x, y, z, s);
+
+			Array<F32, 4> alphas;
+			_mm_storeu_ps(&alphas[0], al);
+
+			F32* out = verts + i * 5;
+			_mm_storeu_ps(out, x);
+			out[4] = alphas[0];
+			_mm_storeu_ps(out + 5, y);
+			out[9] = alphas[1];
+			_mm_storeu_ps(out + 10, z);
+			out[14] = alphas[2];
+			_mm_storeu_ps(out + 15, s);
+			out[19] = alphas[3];
+		}
+
+		// Reduce the bounds
+		for(U j = 0; j < 3; ++j)
+		{
+			Array<F32, 4> lanes;
+			_mm_storeu_ps(&lanes[0], mnv[j]);
+			mn[j] = min(min(lanes[0], lanes[1]), min(lanes[2], lanes[3]));
+			_mm_storeu_ps(&lanes[0], mxv[j]);
+			mx[j] = max(max(lanes[0], lanes[1]), max(lanes[2], lanes[3]));
+		}
+	}
+#endif
+
+	// The rest one at a time
+	for(; i < end; ++i)
+	{
+		F32* out = verts + i * 5;
+
+		for(U j = 0; j < 3; ++j)
+		{
+			pos[j][i] += acc[j][i] * dt2 + vel[j][i] * dt;
+			vel[j][i] += acc[j][i] * dt;
+
+			mn[j] = min(mn[j], pos[j][i]);
+			mx[j] = max(mx[j], pos[j][i]);
+			out[j] = pos[j][i];
+		}
+
+		const F32 lifePercent = (crntTime - birth[i]) / (death[i] - birth[i]);
+		out[3] = size[i] + lifePercent * sizeAnimation;
+		out[4] = (alphaAnimation) ? sinPi(lifePercent) * alpha[i] : alpha[i];
+	}
+
+	aabbMin = mn;
+	aabbMax = mx;
+}
+
+void ParticleSimulation::simulateCallback(void* arg, U32 threadId, ThreadHive& hive)
+{
+	Task& task = *static_cast<Task*>(arg);
+	task.m_sim->simulateRange(*task.m_props,
+		task.m_begin,
+		task.m_end,
+		task.m_dt,
+		task.m_crntTime,
+		task.m_verts,
+		task.m_aabbMin,
+		task.m_aabbMax);
+}
+
+void ParticleSimulation::update(const ParticleEmitterProperties& props,
+	F32 prevUpdateTime,
+	F32 crntTime,
+	void* verts,
+	Vec4& aabbMin,
+	Vec4& aabbMax,
+	ThreadHive* hive)
+{
+	killDead(crntTime);
+
+	const F32 dt = crntTime - prevUpdateTime;
+	F32* fverts = static_cast<F32*>(verts);
+
+	// Split in ranges of multiples of 4 particles
+	U32 taskCount = 1;
+	if(hive && m_aliveCount > PARALLEL_PARTICLE_COUNT)
+	{
+		taskCount = min<U32>(hive->getThreadCount(), ThreadHive::MAX_THREADS);
+	}
+	const U32 taskSize = getAlignedRoundUp(4, (m_aliveCount + taskCount - 1) / taskCount);
+
+	Array<Task, ThreadHive::MAX_THREADS> tasks;
+	Array<ThreadHiveTask, ThreadHive::MAX_THREADS> hiveTasks;
+	for(U32 i = 0; i < taskCount; ++i)
+	{
+		Task& task = tasks[i];
+		task.m_sim = this;
+		task.m_props = &props;
+		task.m_verts = fverts;
+		task.m_begin = min(i * taskSize, m_aliveCount);
+		task.m_end = min(task.m_begin + taskSize, m_aliveCount);
+		task.m_dt = dt;
+		task.m_crntTime = crntTime;
+
+		hiveTasks[i].m_callback = simulateCallback;
+		hiveTasks[i].m_argument = &task;
+	}
+
+	if(taskCount > 1)
+	{
+		hive->submitTasks(&hiveTasks[0], taskCount);
+		hive->waitAllTasks();
+	}
+	else
+	{
+		simulateRange(props, 0, m_aliveCount, dt, crntTime, fverts, tasks[0].m_aabbMin, tasks[0].m_aabbMax);
+	}
+
+	aabbMin = tasks[0].m_aabbMin;
+	aabbMax = tasks[0].m_aabbMax;
+	for(U32 i = 1; i < taskCount; ++i)
+	{
+		for(U j = 0; j < 3; ++j)
+		{
+			aabbMin[j] = min(aabbMin[j], tasks[i].m_aabbMin[j]);
+			aabbMax[j] = max(aabbMax[j], tasks[i].m_aabbMax[j]);
+		}
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,125 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/scene/Common.h>
+#include <anki/resource/ParticleEmitterResource.h>
+#include <anki/Math.h>
+
+namespace anki
+{
+
+// Forward
+class ThreadHive;
+
+/// @addtogroup scene
+/// @{
+
+/// The simulation of the simple particles. The state of the particles is stored in arrays (one per attribute) and the
+/// alive particles are packed at the beginning of them so 4 particles are processed at once. It doesn't depend on the
+/// scene so it can be simulated in isolation.
+class ParticleSimulation : public NonCopyable
+{
+public:
+	/// Size of a single vertex. The position, the size and the alpha.
+	static const U VERTEX_SIZE = 5 * sizeof(F32);
+
+	/// The simulations with more alive particles are split across the threads.
+	static const U32 PARALLEL_PARTICLE_COUNT = 8 * 1024;
+
+	ParticleSimulation() = default;
+
+	~ParticleSimulation();
+
+	void init(GenericMemoryPoolAllocator<U8> alloc, U32 maxParticleCount);
+
+	U32 getMaxParticleCount() const
+	{
+		return m_maxCount;
+	}
+
+	U32 getAliveParticleCount() const
+	{
+		return m_aliveCount;
+	}
+
+	/// Revive some dead particles.
+	/// @param props The properties of the emitter.
+	/// @param origin The origin of the emitter. The particles start relative to it.
+	/// @param crntTime The current time.
+	/// @param count The number of particles to revive.
+	/// @return The number of particles that were revived.
+	U32 emit(const ParticleEmitterProperties& props, const Vec4& origin, F32 crntTime, U32 count);
+
+	/// Kill the particles that reached their time of death, move the rest and write their vertices.
+	/// @param props The properties of the emitter.
+	/// @param prevUpdateTime The time of the previous update.
+	/// @param crntTime The current time.
+	/// @param[out] verts The vertices of the alive particles. It should have room for getMaxParticleCount() vertices.
+	/// @param[out] aabbMin The min of the positions of the alive particles.
+	/// @param[out] aabbMax The max of the positions of the alive particles.
+	/// @param hive If it's not nullptr the large simulations are split across the threads of the hive. It waits all the
+	///             tasks of the hive so only the owner of the hive should pass it.
+	void update(const ParticleEmitterProperties& props,
+		F32 prevUpdateTime,
+		F32 crntTime,
+		void* verts,
+		Vec4& aabbMin,
+		Vec4& aabbMax,
+		ThreadHive* hive = nullptr);
+
+	/// Get the position of an alive particle.
+	Vec4 getPosition(U32 idx) const
+	{
+		ANKI_ASSERT(idx < m_aliveCount);
+		return Vec4(m_attribs[POSITION_X][idx], m_attribs[POSITION_Y][idx], m_attribs[POSITION_Z][idx], 0.0);
+	}
+
+private:
+	class Task;
+
+	enum Attribute
+	{
+		POSITION_X,
+		POSITION_Y,
+		POSITION_Z,
+		VELOCITY_X,
+		VELOCITY_Y,
+		VELOCITY_Z,
+		ACCELERATION_X,
+		ACCELERATION_Y,
+		ACCELERATION_Z,
+		TIME_OF_BIRTH,
+		TIME_OF_DEATH,
+		SIZE,
+		ALPHA,
+		ATTRIBUTE_COUNT
+	};
+
+	GenericMemoryPoolAllocator<U8> m_alloc;
+	F32* m_mem = nullptr; ///< The memory of all the attributes.
+	Array<F32*, ATTRIBUTE_COUNT> m_attribs; ///< They point to m_mem and they are aligned to 16 bytes.
+	U32 m_maxCount = 0;
+	U32 m_aliveCount = 0;
+
+	/// Remove the dead particles by moving the last alive in their place.
+	void killDead(F32 crntTime);
+
+	/// Simulate a range of the alive particles. The begin should be a multiple of 4.
+	void simulateRange(const ParticleEmitterProperties& props,
+		U32 begin,
+		U32 end,
+		F32 dt,
+		F32 crntTime,
+		F32* verts,
+		Vec4& aabbMin,
+		Vec4& aabbMax) const;
+
+	static void simulateCallback(void* arg, U32 threadId, ThreadHive& hive);
+};
+/// @}
+
+} // end namespace anki
@@ -137,14 +137,15 @@ void ReflectionProbe::onMoveUpdate(MoveComponent& move)
 
 Error ReflectionProbe::frameUpdate(F32 prevUpdateTime, F32 crntTime)
 {
-	// Check the reflection probe component and if it's marked for rendering enable the frustum components
+	// Check the reflection probe component and enable the frustum components of the faces marked for rendering
 	const ReflectionProbeComponent& reflc = getComponent<ReflectionProbeComponent>();
+	const U8 faces = reflc.getFacesMarkedForRendering();
 
-	FrustumComponentVisibilityTestFlag testFlags =
-		reflc.getMarkedForRendering() ? FRUSTUM_TEST_FLAGS : FrustumComponentVisibilityTestFlag::NONE;
-
-	Error err = iterateComponentsOfType<FrustumComponent>([testFlags](FrustumComponent& frc) -> Error {
-		frc.setEnabledVisibilityTests(testFlags);
+	U count = 0;
+	Error err = iterateComponentsOfType<FrustumComponent>([&](FrustumComponent& frc) -> Error {
+		frc.setEnabledVisibilityTests(
+			(faces & (1 << count)) ? FRUSTUM_TEST_FLAGS : FrustumComponentVisibilityTestFlag::NONE);
+		++count;
 		return ErrorCode::NONE;
 	});
 	(void)err;
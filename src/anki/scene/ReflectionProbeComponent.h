@@ -46,21 +46,35 @@ public:
 		m_radius = radius;
 	}
 
-	Bool getMarkedForRendering() const
+	/// A mask of the cube faces that will be rendered in the next frame.
+	U8 getFacesMarkedForRendering() const
 	{
-		return m_markedForRendering;
+		return m_facesMarkedForRendering;
 	}
 
-	void setMarkedForRendering(Bool render)
+	void setFacesMarkedForRendering(U8 faces)
 	{
-		m_markedForRendering = render;
+		ANKI_ASSERT(faces < (1 << 6));
+		m_facesMarkedForRendering = faces;
 	}
 
 	void setTextureArrayIndex(U idx)
 	{
+		ANKI_ASSERT(idx < MAX_U16);
 		m_textureArrayIndex = idx;
 	}
 
+	/// The probe didn't get a place in the texture array.
+	void unsetTextureArrayIndex()
+	{
+		m_textureArrayIndex = MAX_U16;
+	}
+
+	Bool hasTextureArrayIndex() const
+	{
+		return m_textureArrayIndex != MAX_U16;
+	}
+
 	U getTextureArrayIndex() const
 	{
 		ANKI_ASSERT(m_textureArrayIndex < MAX_U16);
@@ -70,7 +84,7 @@ public:
 private:
 	Vec4 m_pos = Vec4(0.0);
 	F32 m_radius = 0.0;
-	Bool8 m_markedForRendering = false;
+	U8 m_facesMarkedForRendering = 0;
 
 	U16 m_textureArrayIndex = MAX_U16; ///< Used by the renderer
 };
@@ -61,8 +61,7 @@ Error ReflectionProxy::init(const CString& proxyMesh)
 	const U quadCount = indexCount / 4;
 	m_quadsLSpace.create(getSceneAllocator(), quadCount);
 
-	const U8* buff = loader.getVertexData();
-	const U8* buffEnd = loader.getVertexData() + loader.getVertexDataSize();
+	const U vertCount = loader.getHeader().m_totalVerticesCount;
 	WeakArray<const U16> indices(reinterpret_cast<const U16*>(loader.getIndexData()), indexCount);
 	for(U i = 0; i < quadCount; ++i)
 	{
@@ -71,12 +70,10 @@ Error ReflectionProxy::init(const CString& proxyMesh)
 		for(U j = 0; j < 4; ++j)
 		{
 			U index = indices[i * 4 + j];
+			ANKI_ASSERT(index < vertCount);
+			(void)vertCount;
 
-			const Vec3* vert = reinterpret_cast<const Vec3*>(buff + loader.getVertexSize() * index);
-			ANKI_ASSERT(vert + 1 < reinterpret_cast<const Vec3*>(buffEnd));
-			(void)buffEnd;
-
-			quad[j] = vert->xyz0();
+			quad[j] = loader.getPositions()[index].xyz0();
 		}
 	}
 
@@ -85,10 +82,7 @@ Error ReflectionProxy::init(const CString& proxyMesh)
 	addComponent(comp, true);
 
 	// Spatial component
-	m_boxLSpace.setFromPointCloud(loader.getVertexData(),
-		loader.getHeader().m_totalVerticesCount,
-		loader.getVertexSize(),
-		loader.getVertexDataSize());
+	m_boxLSpace.setFromPointCloud(loader.getPositions(), vertCount, sizeof(Vec3), vertCount * sizeof(Vec3));
 
 	m_boxWSpace = m_boxLSpace;
 
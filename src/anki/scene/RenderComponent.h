@@ -129,6 +129,9 @@ public:
 	Bool8 m_drawArrays = false;
 	Bool8 m_hasTransform = false;
 
+	/// The bone matrices of the skinned renderables. They are bound to the storage buffer 0.
+	const TransientMemoryToken* m_boneMatrices = nullptr;
+
 	PipelineInitInfo* m_state = nullptr;
 	PipelineSubStateBit m_stateMask = PipelineSubStateBit::NONE;
 
@@ -150,6 +153,7 @@ public:
 		m_drawcall.m_elements = b.m_drawcall.m_elements;
 		m_drawArrays = b.m_drawArrays;
 		m_hasTransform = b.m_hasTransform;
+		m_boneMatrices = b.m_boneMatrices;
 		m_state = b.m_state;
 		m_stateMask = b.m_stateMask;
 
@@ -207,6 +211,15 @@ public:
 		return mtl.getShadowEnabled();
 	}
 
+	/// Get the geometric errors of the LODs in world space. The renderer picks the LOD whose error is small enough on
+	/// the screen.
+	/// @return The number of LODs. Zero if the errors are unknown and the distance picks the LOD.
+	virtual U getLodErrors(Array<F32, MAX_LODS>& errors) const
+	{
+		(void)errors;
+		return 0;
+	}
+
 	/// Iterate variables using a lambda
 	template<typename Func>
 	ANKI_USE_RESULT Error iterateVariables(Func func)
@@ -247,6 +260,19 @@ public:
 		}
 	}
 
+anki_internal:
+	/// The LOD of the previous frame of the camera. MAX_U if there is none.
+	U getLastLod() const
+	{
+		return (m_lastLod == MAX_U8) ? MAX_U : m_lastLod;
+	}
+
+	void setLastLod(U lod)
+	{
+		ANKI_ASSERT(lod < MAX_LODS);
+		m_lastLod = lod;
+	}
+
 private:
 	using Key = U64;
 
@@ -276,6 +302,8 @@ private:
 	/// This is an optimization, a local hash of pipelines.
 	HashMap<U64, PipelinePtr, Hasher, Compare> m_localPplineCache;
 	SpinLock m_localPplineCacheMtx;
+
+	U8 m_lastLod = MAX_U8;
 };
 /// @}
 
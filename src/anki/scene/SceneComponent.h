@@ -35,9 +35,10 @@ enum class SceneComponentType : U16
 	OCCLUDER,
 	DECAL,
 	PLAYER_CONTROLLER,
+	SKIN,
 
 	COUNT,
-	LAST_COMPONENT_ID = PLAYER_CONTROLLER
+	LAST_COMPONENT_ID = SKIN
 };
 
 /// Scene node component
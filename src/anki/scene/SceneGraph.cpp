@@ -6,7 +6,12 @@
 #include <anki/scene/SceneGraph.h>
 #include <anki/scene/Camera.h>
 #include <anki/scene/ModelNode.h>
+#include <anki/scene/ParticleEmitter.h>
+#include <anki/scene/MoveComponent.h>
 #include <anki/scene/Sector.h>
+#include <anki/scene/SkinComponent.h>
+#include <anki/scene/StaticGeometryBatcher.h>
+#include <anki/scene/SectorStreamer.h>
 #include <anki/core/Trace.h>
 #include <anki/physics/PhysicsWorld.h>
 #include <anki/resource/ResourceManager.h>
@@ -49,6 +54,11 @@ SceneGraph::SceneGraph()
 
 SceneGraph::~SceneGraph()
 {
+	if(m_physics)
+	{
+		m_physics->waitUpdate();
+	}
+
 	Error err = iterateSceneNodes([&](SceneNode& s) -> Error {
 		s.setMarkedForDeletion();
 		return ErrorCode::NONE;
@@ -57,6 +67,18 @@ SceneGraph::~SceneGraph()
 
 	deleteNodesMarkedForDeletion();
 
+	if(m_staticGeometry)
+	{
+		m_alloc.deleteInstance(m_staticGeometry);
+		m_staticGeometry = nullptr;
+	}
+
+	if(m_sectorStreamer)
+	{
+		m_alloc.deleteInstance(m_sectorStreamer);
+		m_sectorStreamer = nullptr;
+	}
+
 	if(m_sectors)
 	{
 		m_alloc.deleteInstance(m_sectors);
@@ -91,6 +113,19 @@ Error SceneGraph::init(AllocAlignedCallback allocCb,
 
 	m_maxReflectionProxyDistance = config.getNumber("imageReflectionMaxDistance");
 
+	m_staticGeometry = m_alloc.newInstance<StaticGeometryBatcher>(this);
+	StaticGeometryClusterLimits limits;
+	limits.m_maxSize = config.getNumber("staticGeometryClusterSize");
+	m_staticGeometry->setLimits(limits);
+
+	m_sectorStreamer = m_alloc.newInstance<SectorStreamer>(this);
+	SectorStreamingLimits streamingLimits;
+	streamingLimits.m_loadDistance = config.getNumber("sectorStreamingLoadDistance");
+	streamingLimits.m_unloadDistance = max<U32>(config.getNumber("sectorStreamingUnloadDistance"),
+		streamingLimits.m_loadDistance);
+	streamingLimits.m_fileBudget = config.getNumber("sectorStreamingFileBudget");
+	m_sectorStreamer->setLimits(streamingLimits, config.getNumber("sectorStreamingTimeBudget"));
+
 	m_componentLists.init(m_alloc);
 
 	// Init the default main camera
@@ -205,12 +240,22 @@ Error SceneGraph::update(F32 prevUpdateTime, F32 crntTime, MainRenderer& rendere
 	ThreadPool& threadPool = *m_threadpool;
 	(void)threadPool;
 
-	// Update
+	// Sync the step of the previous frame and start the next. It overlaps the rest of the update and the rendering.
+	// The nodes see the results of the previous step
 	ANKI_TRACE_START_EVENT(SCENE_PHYSICS_UPDATE);
-	m_physics->updateAsync(crntTime - prevUpdateTime);
 	m_physics->waitUpdate();
+	ANKI_CHECK(m_physics->updateAsync(crntTime - prevUpdateTime));
 	ANKI_TRACE_STOP_EVENT(SCENE_PHYSICS_UPDATE);
 
+	// Merge the static geometry that was added since the previous update
+	if(m_staticGeometry->hasPending())
+	{
+		ANKI_CHECK(m_staticGeometry->build());
+	}
+
+	// Load the sectors around the camera and unload the far ones
+	ANKI_CHECK(m_sectorStreamer->update(m_mainCam->getComponent<MoveComponent>().getWorldTransform().getOrigin()));
+
 	ANKI_TRACE_START_EVENT(SCENE_NODES_UPDATE);
 	ANKI_CHECK(m_events.updateAllEvents(prevUpdateTime, crntTime));
 
@@ -229,15 +274,64 @@ Error SceneGraph::update(F32 prevUpdateTime, F32 crntTime, MainRenderer& rendere
 		threadPool.assignNewTask(i, &job);
 	}
 
-	ANKI_CHECK(threadPool.waitForAllThreadsToFinish());
+	Error err = threadPool.waitForAllThreadsToFinish();
+
+	// Always empty the list because its memory goes away with the frame allocator
+	simulateDeferredEmitters(prevUpdateTime, crntTime);
+	ANKI_CHECK(err);
 	ANKI_TRACE_STOP_EVENT(SCENE_NODES_UPDATE);
 
+	updateSkins(crntTime);
+
 	doVisibilityTests(*m_mainCam, *this, renderer.getOffscreenRenderer());
 
 	ANKI_TRACE_STOP_EVENT(SCENE_UPDATE);
 	return ErrorCode::NONE;
 }
 
+void SceneGraph::updateSkins(F32 crntTime)
+{
+	ANKI_TRACE_START_EVENT(SCENE_SKINNING);
+
+	// Gather the skins
+	U32 count = 0;
+	m_componentLists.iterateComponents<SkinComponent>([&](SkinComponent&) { ++count; });
+
+	if(count > 0)
+	{
+		DynamicArrayAuto<SkinComponent*> skins(m_frameAlloc);
+		DynamicArrayAuto<AnimationPlayer*> players(m_frameAlloc);
+		skins.create(count);
+		players.create(count);
+
+		count = 0;
+		m_componentLists.iterateComponents<SkinComponent>([&](SkinComponent& skin) {
+			skins[count] = &skin;
+			players[count] = &skin.getAnimationPlayer();
+			++count;
+		});
+
+		AnimationPlayer::updateMany(WeakArray<AnimationPlayer*>(&players[0], count), crntTime, m_threadHive);
+
+		for(SkinComponent* skin : skins)
+		{
+			skin->uploadBoneMatrices(*m_gr);
+		}
+	}
+
+	ANKI_TRACE_STOP_EVENT(SCENE_SKINNING);
+}
+
+void SceneGraph::simulateDeferredEmitters(F32 prevUpdateTime, F32 crntTime)
+{
+	for(ParticleEmitter* emitter : m_deferredEmitters)
+	{
+		emitter->simulate(prevUpdateTime, crntTime, m_threadHive);
+	}
+
+	m_deferredEmitters.destroy(m_frameAlloc);
+}
+
 Error SceneGraph::updateNode(F32 prevTime, F32 crntTime, SceneNode& node)
 {
 	ANKI_TRACE_INC_COUNTER(SCENE_NODES_UPDATED, 1);
@@ -25,8 +25,11 @@ class ResourceManager;
 class Camera;
 class Input;
 class SectorGroup;
+class StaticGeometryBatcher;
+class SectorStreamer;
 class ConfigSet;
 class PerspectiveCamera;
+class ParticleEmitter;
 class UpdateSceneNodesCtx;
 
 /// @addtogroup scene
@@ -180,6 +183,18 @@ anki_internal:
 		return *m_sectors;
 	}
 
+	StaticGeometryBatcher& getStaticGeometryBatcher()
+	{
+		ANKI_ASSERT(m_staticGeometry);
+		return *m_staticGeometry;
+	}
+
+	SectorStreamer& getSectorStreamer()
+	{
+		ANKI_ASSERT(m_sectorStreamer);
+		return *m_sectorStreamer;
+	}
+
 	F32 getMaxReflectionProxyDistance() const
 	{
 		ANKI_ASSERT(m_maxReflectionProxyDistance > 0.0);
@@ -196,6 +211,13 @@ anki_internal:
 		return m_componentLists;
 	}
 
+	/// Simulate a particle emitter after the node update. It's thread safe.
+	void deferParticleEmitterSimulation(ParticleEmitter& emitter)
+	{
+		LockGuard<SpinLock> lock(m_deferredEmittersLock);
+		m_deferredEmitters.pushBack(m_frameAlloc, &emitter);
+	}
+
 private:
 	const Timestamp* m_globalTimestamp = nullptr;
 	Timestamp m_timestamp = 0; ///< Cached timestamp
@@ -221,6 +243,8 @@ private:
 
 	EventManager m_events;
 	SectorGroup* m_sectors;
+	StaticGeometryBatcher* m_staticGeometry = nullptr;
+	SectorStreamer* m_sectorStreamer = nullptr;
 
 	Atomic<U32> m_objectsMarkedForDeletionCount;
 
@@ -230,6 +254,9 @@ private:
 
 	SceneComponentLists m_componentLists;
 
+	List<ParticleEmitter*> m_deferredEmitters; ///< Allocated from the frame allocator.
+	SpinLock m_deferredEmittersLock;
+
 	/// Put a node in the appropriate containers
 	ANKI_USE_RESULT Error registerNode(SceneNode* node);
 	void unregisterNode(SceneNode* node);
@@ -239,6 +266,12 @@ private:
 
 	ANKI_USE_RESULT Error updateNodes(UpdateSceneNodesCtx& ctx) const;
 	ANKI_USE_RESULT static Error updateNode(F32 prevTime, F32 crntTime, SceneNode& node);
+
+	/// Update the animations of all the SkinComponents in parallel and upload their bone matrices.
+	void updateSkins(F32 crntTime);
+
+	/// Simulate the deferred particle emitters one after the other, each across the hive.
+	void simulateDeferredEmitters(F32 prevUpdateTime, F32 crntTime);
 };
 
 template<typename Node, typename... Args>
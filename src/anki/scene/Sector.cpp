@@ -9,6 +9,7 @@
 #include <anki/scene/MoveComponent.h>
 #include <anki/scene/SceneGraph.h>
 #include <anki/scene/SoftwareRasterizer.h>
+#include <anki/scene/SectorStreamer.h>
 #include <anki/util/Logger.h>
 #include <anki/resource/ResourceManager.h>
 #include <anki/resource/MeshLoader.h>
@@ -80,7 +81,6 @@ Error PortalSectorBase::init(const CString& meshFname, Bool isSector)
 	// Convert Vec3 positions to Vec4
 	const MeshLoader::Header& header = loader.getHeader();
 	U vertsCount = header.m_totalVerticesCount;
-	PtrSize vertSize = loader.getVertexSize();
 
 	auto alloc = getSceneAllocator();
 	m_shapeStorageLSpace.create(alloc, vertsCount);
@@ -88,9 +88,7 @@ Error PortalSectorBase::init(const CString& meshFname, Bool isSector)
 
 	for(U i = 0; i < vertsCount; ++i)
 	{
-		const Vec3& pos = *reinterpret_cast<const Vec3*>(loader.getVertexData() + vertSize * i);
-
-		m_shapeStorageLSpace[i] = Vec4(pos, 0.0);
+		m_shapeStorageLSpace[i] = Vec4(loader.getPositions()[i], 0.0);
 	}
 
 	// Create shape
@@ -220,6 +218,8 @@ Sector::~Sector()
 {
 	auto alloc = getSceneAllocator();
 
+	getSceneGraph().getSectorStreamer().sectorDeleted(*this);
+
 	// Remove portals
 	for(Portal* p : m_portals)
 	{
@@ -242,6 +242,11 @@ Error Sector::init(const CString& meshFname)
 	return ErrorCode::NONE;
 }
 
+Error Sector::setStreamingManifest(const CString& filename)
+{
+	return getSceneGraph().getSectorStreamer().setManifest(*this, filename);
+}
+
 void Sector::tryAddPortal(Portal* portal)
 {
 	ANKI_ASSERT(portal);
@@ -94,6 +94,7 @@ protected:
 class Portal : public PortalSectorBase
 {
 	friend class SectorGroup;
+	friend class SectorStreamer;
 
 public:
 	using Base = PortalSectorBase;
@@ -125,6 +126,7 @@ private:
 class Sector : public PortalSectorBase
 {
 	friend class SectorGroup;
+	friend class SectorStreamer;
 
 public:
 	using Base = PortalSectorBase;
@@ -139,6 +141,9 @@ public:
 
 	ANKI_USE_RESULT Error init(const CString& modelFname);
 
+	/// Stream the content of the sector with a manifest. See SectorStreamer.
+	ANKI_USE_RESULT Error setStreamingManifest(const CString& filename);
+
 	void tryAddPortal(Portal* portal);
 	void tryRemovePortal(Portal* portal);
 
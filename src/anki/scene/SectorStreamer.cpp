@@ -0,0 +1,665 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/scene/SectorStreamer.h>
+#include <anki/scene/Sector.h>
+#include <anki/scene/ModelNode.h>
+#include <anki/scene/MoveComponent.h>
+#include <anki/scene/SceneGraph.h>
+#include <anki/resource/ResourceManager.h>
+#include <anki/resource/AsyncLoader.h>
+#include <anki/misc/Xml.h>
+#include <anki/core/Trace.h>
+#include <anki/util/HighRezTimer.h>
+#include <algorithm>
+
+namespace anki
+{
+
+/// The radius of the point that is tested against the sectors.
+static const F32 CAMERA_RADIUS = 0.01;
+
+void scheduleSectorStreaming(WeakArray<const SectorStreamingInfo> sectors,
+	WeakArray<const SectorStreamingLink> links,
+	U32 cameraSector,
+	const SectorStreamingLimits& limits,
+	DynamicArrayAuto<U32>& loads,
+	DynamicArrayAuto<U32>& unloads,
+	GenericMemoryPoolAllocator<U8> alloc)
+{
+	ANKI_ASSERT(limits.m_loadDistance <= limits.m_unloadDistance);
+	loads.destroy();
+	unloads.destroy();
+
+	const U32 count = sectors.getSize();
+	if(cameraSector >= count)
+	{
+		return;
+	}
+
+	// The neighbours of every sector
+	DynamicArrayAuto<U32> offsets(alloc);
+	offsets.create(count + 1, 0);
+	for(const SectorStreamingLink& link : links)
+	{
+		ANKI_ASSERT(link.m_sectorA < count && link.m_sectorB < count);
+		++offsets[link.m_sectorA + 1];
+		++offsets[link.m_sectorB + 1];
+	}
+
+	for(U32 i = 0; i < count; ++i)
+	{
+		offsets[i + 1] += offsets[i];
+	}
+
+	DynamicArrayAuto<U32> neighbours(alloc);
+	DynamicArrayAuto<U32> cursors(alloc);
+	neighbours.create(max<U32>(offsets[count], 1));
+	cursors.create(count);
+	for(U32 i = 0; i < count; ++i)
+	{
+		cursors[i] = offsets[i];
+	}
+
+	for(const SectorStreamingLink& link : links)
+	{
+		neighbours[cursors[link.m_sectorA]++] = link.m_sectorB;
+		neighbours[cursors[link.m_sectorB]++] = link.m_sectorA;
+	}
+
+	// Walk the portals from the camera. The queue ends up sorted by distance and nothing past the unload distance is
+	// needed
+	DynamicArrayAuto<U32> dists(alloc);
+	DynamicArrayAuto<U32> queue(alloc);
+	dists.create(count, MAX_U32);
+	queue.create(count);
+
+	dists[cameraSector] = 0;
+	queue[0] = cameraSector;
+	U32 queueBegin = 0;
+	U32 queueEnd = 1;
+	while(queueBegin < queueEnd)
+	{
+		const U32 s = queue[queueBegin++];
+		if(dists[s] >= limits.m_unloadDistance)
+		{
+			continue;
+		}
+
+		for(U32 i = offsets[s]; i < offsets[s + 1]; ++i)
+		{
+			const U32 n = neighbours[i];
+			if(dists[n] == MAX_U32)
+			{
+				dists[n] = dists[s] + 1;
+				queue[queueEnd++] = n;
+			}
+		}
+	}
+
+	// Unload the far sectors. The sectors that still load are left alone and they are unloaded once they are done
+	loads.create(count);
+	unloads.create(count);
+	U32 loadCount = 0;
+	U32 unloadCount = 0;
+	PtrSize fileSize = 0;
+	U32 loadingCount = 0;
+	for(U32 i = 0; i < count; ++i)
+	{
+		const SectorStreamingInfo& info = sectors[i];
+		if(!info.m_streamed || info.m_state == SectorStreamingState::UNLOADED)
+		{
+			continue;
+		}
+
+		if(info.m_state == SectorStreamingState::LOADED && dists[i] > limits.m_unloadDistance)
+		{
+			unloads[unloadCount++] = i;
+		}
+		else
+		{
+			fileSize += info.m_fileSize;
+			loadingCount += (info.m_state == SectorStreamingState::LOADING) ? 1 : 0;
+		}
+	}
+
+	// Load the close sectors, the closest first. The furthest of the loaded sectors that are past the load distance
+	// make room for them
+	U32 evictEnd = queueEnd;
+	for(U32 q = 0; q < queueEnd && loadingCount < limits.m_maxLoadingCount; ++q)
+	{
+		const U32 s = queue[q];
+		if(dists[s] > limits.m_loadDistance)
+		{
+			break;
+		}
+
+		const SectorStreamingInfo& info = sectors[s];
+		if(!info.m_streamed || info.m_state != SectorStreamingState::UNLOADED)
+		{
+			continue;
+		}
+
+		if(limits.m_fileBudget > 0)
+		{
+			// Find the sectors that have to go before evicting anything
+			PtrSize freed = 0;
+			U32 newEvictEnd = evictEnd;
+			while(fileSize - freed + info.m_fileSize > limits.m_fileBudget && newEvictEnd > 0
+				&& dists[queue[newEvictEnd - 1]] > limits.m_loadDistance)
+			{
+				const SectorStreamingInfo& e = sectors[queue[--newEvictEnd]];
+				freed += (e.m_streamed && e.m_state == SectorStreamingState::LOADED) ? e.m_fileSize : 0;
+			}
+
+			// Don't let a further sector that fits go before this one
+			if(fileSize - freed + info.m_fileSize > limits.m_fileBudget && fileSize - freed > 0)
+			{
+				break;
+			}
+
+			while(evictEnd > newEvictEnd)
+			{
+				const U32 e = queue[--evictEnd];
+				if(sectors[e].m_streamed && sectors[e].m_state == SectorStreamingState::LOADED)
+				{
+					unloads[unloadCount++] = e;
+				}
+			}
+
+			fileSize -= freed;
+		}
+
+		loads[loadCount++] = s;
+		fileSize += info.m_fileSize;
+		++loadingCount;
+	}
+
+	// Empty arrays can't be resized
+	if(loadCount > 0)
+	{
+		loads.resize(loadCount);
+	}
+	else
+	{
+		loads.destroy();
+	}
+
+	if(unloadCount > 0)
+	{
+		unloads.resize(unloadCount);
+	}
+	else
+	{
+		unloads.destroy();
+	}
+}
+
+/// Reads the files of a sector to bring them to the caches of the filesystem before the models are created. It doesn't
+/// create the resources.
+class SectorStreamer::PrefetchTask : public AsyncLoaderTask
+{
+public:
+	SectorStreamer* m_streamer;
+	StreamedSector* m_sector;
+
+	PrefetchTask(SectorStreamer* streamer, StreamedSector* sector)
+		: m_streamer(streamer)
+		, m_sector(sector)
+	{
+	}
+
+	Error operator()(AsyncLoaderTaskContext& ctx) final
+	{
+		ResourceFilesystem& fs = m_streamer->m_scene->getResourceManager().getFilesystem();
+
+		for(const String& filename : m_sector->m_resources)
+		{
+			ResourceFilePtr file;
+			Error err = fs.openFile(filename.toCString(), file);
+
+			Array<U8, 64 * 1024> buff;
+			PtrSize remaining = (!err) ? file->getSize() : 0;
+			while(!err && remaining > 0)
+			{
+				const PtrSize size = min<PtrSize>(remaining, sizeof(buff));
+				err = file->read(&buff[0], size);
+				remaining -= size;
+			}
+
+			// Don't return the error. The models load on the main thread anyway and they will report it
+			if(err)
+			{
+				ANKI_LOGW("Failed to prefetch the file of a sector: %s", &filename[0]);
+			}
+		}
+
+		m_sector->m_prefetchDone.store(1);
+		m_streamer->m_prefetchesInFlight.fetchSub(1);
+		return ErrorCode::NONE;
+	}
+};
+
+SectorStreamer::SectorStreamer(SceneGraph* scene)
+	: m_scene(scene)
+{
+	ANKI_ASSERT(scene);
+}
+
+SectorStreamer::~SectorStreamer()
+{
+	// The tasks point to the sectors
+	while(m_prefetchesInFlight.load() > 0)
+	{
+		HighRezTimer::sleep(0.001);
+	}
+
+	auto alloc = m_scene->getAllocator();
+	for(StreamedSector& s : m_sectors)
+	{
+		destroySector(s);
+	}
+
+	m_sectors.destroy(alloc);
+}
+
+void SectorStreamer::setLimits(const SectorStreamingLimits& limits, F64 timeBudget)
+{
+	ANKI_ASSERT(limits.m_loadDistance <= limits.m_unloadDistance);
+	ANKI_ASSERT(limits.m_maxLoadingCount > 0);
+	ANKI_ASSERT(timeBudget >= 0.0);
+	m_limits = limits;
+	m_timeBudget = timeBudget;
+}
+
+void SectorStreamer::destroySector(StreamedSector& s)
+{
+	auto alloc = m_scene->getAllocator();
+
+	for(String& str : s.m_resources)
+	{
+		str.destroy(alloc);
+	}
+	s.m_resources.destroy(alloc);
+
+	for(ManifestModel& model : s.m_models)
+	{
+		model.m_filename.destroy(alloc);
+	}
+	s.m_models.destroy(alloc);
+
+	s.m_name.destroy(alloc);
+}
+
+Error SectorStreamer::parseManifest(const CString& filename, StreamedSector& out)
+{
+	ResourceManager& resources = m_scene->getResourceManager();
+	auto alloc = m_scene->getAllocator();
+
+	ResourceFilePtr file;
+	ANKI_CHECK(resources.getFilesystem().openFile(filename, file));
+	StringAuto text(resources.getTempAllocator());
+	ANKI_CHECK(file->readAllText(resources.getTempAllocator(), text));
+
+	XmlDocument doc;
+	ANKI_CHECK(doc.parse(text.toCString(), resources.getTempAllocator()));
+
+	XmlElement rootEl;
+	ANKI_CHECK(doc.getChildElement("sectorManifest", rootEl));
+
+	// <resources>
+	XmlElement resourcesEl;
+	ANKI_CHECK(rootEl.getChildElementOptional("resources", resourcesEl));
+	if(resourcesEl)
+	{
+		XmlElement resourceEl;
+		ANKI_CHECK(resourcesEl.getChildElement("resource", resourceEl));
+		U32 count;
+		ANKI_CHECK(resourceEl.getSiblingElementsCount(count));
+		out.m_resources.create(alloc, count + 1);
+
+		U32 i = 0;
+		do
+		{
+			CString fname;
+			ANKI_CHECK(resourceEl.getText(fname));
+			out.m_resources[i++].create(alloc, fname);
+
+			// The budget counts the size of the files
+			ResourceFilePtr resourceFile;
+			ANKI_CHECK(resources.getFilesystem().openFile(fname, resourceFile));
+			out.m_fileSize += resourceFile->getSize();
+
+			ANKI_CHECK(resourceEl.getNextSiblingElement("resource", resourceEl));
+		} while(resourceEl);
+	}
+
+	// <models>
+	XmlElement modelsEl;
+	ANKI_CHECK(rootEl.getChildElementOptional("models", modelsEl));
+	if(modelsEl)
+	{
+		XmlElement modelEl;
+		ANKI_CHECK(modelsEl.getChildElement("model", modelEl));
+		U32 count;
+		ANKI_CHECK(modelEl.getSiblingElementsCount(count));
+		out.m_models.create(alloc, count + 1);
+
+		U32 i = 0;
+		do
+		{
+			ManifestModel& model = out.m_models[i++];
+			XmlElement el;
+
+			ANKI_CHECK(modelEl.getChildElement("file", el));
+			CString fname;
+			ANKI_CHECK(el.getText(fname));
+			model.m_filename.create(alloc, fname);
+
+			ANKI_CHECK(modelEl.getChildElement("position", el));
+			Vec3 pos;
+			ANKI_CHECK(el.getVec3(pos));
+
+			Vec4 rot(0.0, 0.0, 0.0, 1.0);
+			ANKI_CHECK(modelEl.getChildElementOptional("rotation", el));
+			if(el)
+			{
+				ANKI_CHECK(el.getVec4(rot));
+			}
+
+			F64 scale = 1.0;
+			ANKI_CHECK(modelEl.getChildElementOptional("scale", el));
+			if(el)
+			{
+				ANKI_CHECK(el.getF64(scale));
+			}
+
+			model.m_trf = Transform(pos.xyz0(), Mat3x4(Quat(rot)), scale);
+
+			ANKI_CHECK(modelEl.getNextSiblingElement("model", modelEl));
+		} while(modelEl);
+	}
+
+	return ErrorCode::NONE;
+}
+
+SectorStreamer::StreamedSector* SectorStreamer::findStreamedSector(const Sector& sector)
+{
+	for(StreamedSector& s : m_sectors)
+	{
+		if(s.m_sector == &sector)
+		{
+			return &s;
+		}
+	}
+
+	return nullptr;
+}
+
+Error SectorStreamer::setManifest(Sector& sector, const CString& filename)
+{
+	ANKI_ASSERT(findStreamedSector(sector) == nullptr && "Already has a manifest");
+	auto alloc = m_scene->getAllocator();
+
+	m_sectors.emplaceFront(alloc);
+	StreamedSector& s = m_sectors.getFront();
+	s.m_sector = &sector;
+	if(sector.getName())
+	{
+		s.m_name.sprintf(alloc, "%s_stream", &sector.getName()[0]);
+	}
+	else
+	{
+		s.m_name.sprintf(alloc, "sector%" PRIu64 "_stream", sector.getUuid());
+	}
+
+	Error err = parseManifest(filename, s);
+	if(err)
+	{
+		ANKI_LOGE("Failed to load the manifest of a sector: %s", &filename[0]);
+		destroySector(s);
+		m_sectors.erase(alloc, m_sectors.getBegin());
+	}
+
+	return err;
+}
+
+void SectorStreamer::sectorDeleted(Sector& sector)
+{
+	StreamedSector* s = findStreamedSector(sector);
+	if(s)
+	{
+		unload(*s);
+		s->m_sector = nullptr;
+	}
+}
+
+void SectorStreamer::startLoading(StreamedSector& s)
+{
+	ANKI_ASSERT(s.m_state == SectorStreamingState::UNLOADED);
+	ANKI_ASSERT(s.m_prefetchDone.load() == 1);
+
+	s.m_state = SectorStreamingState::LOADING;
+	s.m_createdModelCount = 0;
+	m_fileSize += s.m_fileSize;
+
+	if(s.m_resources.getSize() > 0)
+	{
+		s.m_prefetchDone.store(0);
+		m_prefetchesInFlight.fetchAdd(1);
+		m_scene->getResourceManager().getAsyncLoader().submitNewTask<PrefetchTask>(this, &s);
+	}
+}
+
+void SectorStreamer::unload(StreamedSector& s)
+{
+	if(s.m_state == SectorStreamingState::UNLOADED)
+	{
+		return;
+	}
+
+	// The resources stay in the ResourceManager until its residency budgets evict them. The file budget doesn't bound
+	// them
+	StringAuto name(m_scene->getFrameAllocator());
+	for(U32 i = 0; i < s.m_createdModelCount; ++i)
+	{
+		name.destroy();
+		name.sprintf("%s%u", &s.m_name[0], i);
+
+		SceneNode* node = m_scene->tryFindSceneNode(name.toCString());
+		if(node)
+		{
+			m_scene->deleteSceneNode(node);
+		}
+	}
+
+	s.m_createdModelCount = 0;
+	s.m_state = SectorStreamingState::UNLOADED;
+	ANKI_ASSERT(m_fileSize >= s.m_fileSize);
+	m_fileSize -= s.m_fileSize;
+	ANKI_TRACE_INC_COUNTER(SCENE_SECTORS_UNLOADED, 1);
+}
+
+Error SectorStreamer::createModels(StreamedSector& s, F64 deadline)
+{
+	ANKI_ASSERT(s.m_state == SectorStreamingState::LOADING);
+
+	StringAuto name(m_scene->getFrameAllocator());
+	while(s.m_createdModelCount < s.m_models.getSize())
+	{
+		const ManifestModel& model = s.m_models[s.m_createdModelCount];
+		name.destroy();
+		name.sprintf("%s%u", &s.m_name[0], s.m_createdModelCount);
+
+		ModelNode* node;
+		ANKI_CHECK(m_scene->newSceneNode<ModelNode>(name.toCString(), node, model.m_filename.toCString()));
+		node->getComponent<MoveComponent>().setLocalTransform(model.m_trf);
+		++s.m_createdModelCount;
+
+		if(HighRezTimer::getCurrentTime() >= deadline)
+		{
+			break;
+		}
+	}
+
+	if(s.m_createdModelCount == s.m_models.getSize())
+	{
+		s.m_state = SectorStreamingState::LOADED;
+		ANKI_TRACE_INC_COUNTER(SCENE_SECTORS_LOADED, 1);
+	}
+
+	return ErrorCode::NONE;
+}
+
+U32 SectorStreamer::findCameraSector(WeakArray<Sector*> sectors, const Vec4& cameraPos)
+{
+	const Sphere eye(cameraPos, CAMERA_RADIUS);
+
+	for(U32 i = 0; i < sectors.getSize(); ++i)
+	{
+		const Sector& sector = *sectors[i];
+		if(testCollisionShapes(eye, sector.m_aabb) && testCollisionShapes(eye, sector.getBoundingShape()))
+		{
+			return i;
+		}
+	}
+
+	return MAX_U32;
+}
+
+Error SectorStreamer::update(const Vec4& cameraPos)
+{
+	auto alloc = m_scene->getAllocator();
+	auto frameAlloc = m_scene->getFrameAllocator();
+
+	// Forget the deleted sectors once the AsyncLoader is done with them
+	auto it = m_sectors.getBegin();
+	while(it != m_sectors.getEnd())
+	{
+		auto next = it;
+		++next;
+		if(it->m_sector == nullptr && it->m_prefetchDone.load() == 1)
+		{
+			destroySector(*it);
+			m_sectors.erase(alloc, it);
+		}
+		it = next;
+	}
+
+	if(m_sectors.isEmpty())
+	{
+		return ErrorCode::NONE;
+	}
+
+	// Gather the sectors. Sort them so the streamed sectors find their index
+	U32 sectorCount = 0;
+	m_scene->getSceneComponentLists().iterateComponents<SectorComponent>([&](SectorComponent&) { ++sectorCount; });
+
+	DynamicArrayAuto<Sector*> sectors(frameAlloc);
+	sectors.create(sectorCount);
+	sectorCount = 0;
+	m_scene->getSceneComponentLists().iterateComponents<SectorComponent>([&](SectorComponent& comp) {
+		sectors[sectorCount++] = static_cast<Sector*>(&comp.getSceneNode());
+	});
+
+	std::sort(sectors.getBegin(), sectors.getEnd());
+	auto findSector = [&](const Sector* sector) -> U32 {
+		Sector** it = std::lower_bound(sectors.getBegin(), sectors.getEnd(), sector);
+		ANKI_ASSERT(it != sectors.getEnd() && *it == sector);
+		return it - sectors.getBegin();
+	};
+
+	const U32 cameraSector = findCameraSector(WeakArray<Sector*>(sectors.getBegin(), sectorCount), cameraPos);
+
+	// Every portal links all of its sectors
+	U32 linkCount = 0;
+	m_scene->getSceneComponentLists().iterateComponents<PortalComponent>([&](PortalComponent& comp) {
+		const U32 count = static_cast<Portal&>(comp.getSceneNode()).m_sectors.getSize();
+		linkCount += (count > 1) ? count * (count - 1) / 2 : 0;
+	});
+
+	DynamicArrayAuto<SectorStreamingLink> links(frameAlloc);
+	links.create(linkCount);
+	linkCount = 0;
+	m_scene->getSceneComponentLists().iterateComponents<PortalComponent>([&](PortalComponent& comp) {
+		const List<Sector*>& portalSectors = static_cast<Portal&>(comp.getSceneNode()).m_sectors;
+		for(auto a = portalSectors.getBegin(); a != portalSectors.getEnd(); ++a)
+		{
+			auto b = a;
+			for(++b; b != portalSectors.getEnd(); ++b)
+			{
+				SectorStreamingLink& link = links[linkCount++];
+				link.m_sectorA = findSector(*a);
+				link.m_sectorB = findSector(*b);
+			}
+		}
+	});
+
+	// The sectors without a manifest only connect the rest
+	DynamicArrayAuto<SectorStreamingInfo> infos(frameAlloc);
+	DynamicArrayAuto<StreamedSector*> streamed(frameAlloc);
+	infos.create(sectorCount);
+	streamed.create(sectorCount, nullptr);
+	for(U32 i = 0; i < sectorCount; ++i)
+	{
+		infos[i].m_streamed = false;
+	}
+
+	for(StreamedSector& s : m_sectors)
+	{
+		if(s.m_sector)
+		{
+			const U32 idx = findSector(s.m_sector);
+			infos[idx].m_fileSize = s.m_fileSize;
+			infos[idx].m_state = s.m_state;
+			infos[idx].m_streamed = true;
+			streamed[idx] = &s;
+		}
+	}
+
+	// Schedule
+	DynamicArrayAuto<U32> loads(frameAlloc);
+	DynamicArrayAuto<U32> unloads(frameAlloc);
+	scheduleSectorStreaming(WeakArray<const SectorStreamingInfo>(infos.getBegin(), sectorCount),
+		WeakArray<const SectorStreamingLink>(links.getBegin(), linkCount),
+		cameraSector,
+		m_limits,
+		loads,
+		unloads,
+		frameAlloc);
+
+	for(U32 idx : unloads)
+	{
+		unload(*streamed[idx]);
+	}
+
+	for(U32 idx : loads)
+	{
+		startLoading(*streamed[idx]);
+	}
+
+	// Create the models of the prefetched sectors. At least one model every frame so the loading always moves
+	const F64 deadline = HighRezTimer::getCurrentTime() + m_timeBudget;
+	Bool created = false;
+	for(StreamedSector& s : m_sectors)
+	{
+		if(s.m_sector == nullptr || s.m_state != SectorStreamingState::LOADING || s.m_prefetchDone.load() == 0)
+		{
+			continue;
+		}
+
+		if(created && HighRezTimer::getCurrentTime() >= deadline)
+		{
+			break;
+		}
+
+		ANKI_CHECK(createModels(s, deadline));
+		created = true;
+	}
+
+	return ErrorCode::NONE;
+}
+
+} // end namespace anki
@@ -0,0 +1,186 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/scene/Common.h>
+#include <anki/util/DynamicArray.h>
+#include <anki/util/List.h>
+#include <anki/util/Atomic.h>
+#include <anki/Math.h>
+
+namespace anki
+{
+
+// Forward
+class Sector;
+
+/// @addtogroup scene
+/// @{
+
+/// The streaming state of a sector.
+enum class SectorStreamingState : U8
+{
+	UNLOADED,
+	LOADING, ///< Its files are being prefetched or its nodes are being created.
+	LOADED
+};
+
+/// An input of scheduleSectorStreaming().
+class SectorStreamingInfo
+{
+public:
+	PtrSize m_fileSize = 0; ///< The size of the files of the resources of its manifest.
+	SectorStreamingState m_state = SectorStreamingState::UNLOADED;
+	Bool8 m_streamed = true; ///< If false the sector has no manifest. It only connects the sectors around it.
+};
+
+/// A portal that connects two sectors of scheduleSectorStreaming().
+class SectorStreamingLink
+{
+public:
+	U32 m_sectorA;
+	U32 m_sectorB;
+};
+
+/// The limits of scheduleSectorStreaming().
+class SectorStreamingLimits
+{
+public:
+	/// The sectors that are that many portals away from the camera or less get loaded.
+	U32 m_loadDistance = 1;
+
+	/// The sectors that are further than that get unloaded. The loaded sectors in between stay so walking back and
+	/// forth through a portal doesn't reload anything.
+	U32 m_unloadDistance = 2;
+
+	/// The max size of the files of the loaded and the loading sectors. Zero for no limit. It bounds the reading and the
+	/// sectors that are loaded at the same time. It doesn't bound the resident memory, the resources of the unloaded
+	/// sectors are left to the residency budgets of the ResourceManager.
+	PtrSize m_fileBudget = 0;
+
+	/// The max number of sectors that load at the same time.
+	U32 m_maxLoadingCount = 2;
+};
+
+/// Decide which sectors to load and which to unload. The distance of a sector is the number of portals between it and
+/// the sector of the camera. The closest sectors load first and if they don't fit in the file budget the furthest of
+/// the loaded sectors that are not needed make room. A sector that is larger than the budget loads only when nothing
+/// else is loaded. It doesn't depend on the scene.
+/// @param sectors The sectors.
+/// @param links The portals between the sectors.
+/// @param cameraSector The sector of the camera. MAX_U32 if it's outside of all of them and nothing changes.
+/// @param limits The limits.
+/// @param[out] loads The sectors to start loading, the closest first.
+/// @param[out] unloads The sectors to unload.
+/// @param alloc The allocator of the temp memory.
+void scheduleSectorStreaming(WeakArray<const SectorStreamingInfo> sectors,
+	WeakArray<const SectorStreamingLink> links,
+	U32 cameraSector,
+	const SectorStreamingLimits& limits,
+	DynamicArrayAuto<U32>& loads,
+	DynamicArrayAuto<U32>& unloads,
+	GenericMemoryPoolAllocator<U8> alloc);
+
+/// Streams the content of the sectors that have a manifest. The sectors close to the camera get their files read by the
+/// AsyncLoader to warm the caches of the filesystem and then their models are created in the scene a few at a time. The
+/// resources of the models are still created on the main thread when the models are. The distant sectors delete their
+/// models and the resources go to the unreferenced resources of the ResourceManager. Its residency budgets decide when
+/// they are freed.
+///
+/// Manifest XML format:
+/// @code
+/// <sectorManifest>
+/// 	[<resources>
+/// 		<resource>path/to/file</resource> <!-- Read ahead and counted in the file budget -->
+/// 		...
+/// 	</resources>]
+/// 	[<models>
+/// 		<model>
+/// 			<file>path/to/model.ankimdl</file>
+/// 			<position>x y z</position>
+/// 			[<rotation>x y z w</rotation>] <!-- A quaternion -->
+/// 			[<scale>1.0</scale>]
+/// 		</model>
+/// 		...
+/// 	</models>]
+/// </sectorManifest>
+/// @endcode
+class SectorStreamer : public NonCopyable
+{
+public:
+	SectorStreamer(SceneGraph* scene);
+
+	~SectorStreamer();
+
+	/// @param limits The limits of the scheduling.
+	/// @param timeBudget The time in seconds that the creation of the models can take in a frame.
+	void setLimits(const SectorStreamingLimits& limits, F64 timeBudget);
+
+	/// Tag a sector with a manifest. The sector is unloaded until the camera comes close.
+	ANKI_USE_RESULT Error setManifest(Sector& sector, const CString& filename);
+
+	/// Forget a sector and delete its models. Called by the Sector.
+	void sectorDeleted(Sector& sector);
+
+	/// Schedule the sectors around the camera and continue the loading. Call it once per frame.
+	ANKI_USE_RESULT Error update(const Vec4& cameraPos);
+
+	/// Get the size of the files of the loaded and the loading sectors.
+	PtrSize getFileSize() const
+	{
+		return m_fileSize;
+	}
+
+private:
+	class ManifestModel
+	{
+	public:
+		String m_filename;
+		Transform m_trf;
+	};
+
+	class StreamedSector
+	{
+	public:
+		Sector* m_sector = nullptr; ///< Null if the sector was deleted while it was loading.
+		String m_name; ///< The prefix of the names of the models.
+		DynamicArray<String> m_resources;
+		DynamicArray<ManifestModel> m_models;
+		PtrSize m_fileSize = 0;
+		SectorStreamingState m_state = SectorStreamingState::UNLOADED;
+		Atomic<U32> m_prefetchDone = {1}; ///< Zero while the AsyncLoader reads the files.
+		U32 m_createdModelCount = 0;
+	};
+
+	class PrefetchTask;
+
+	SceneGraph* m_scene;
+	SectorStreamingLimits m_limits;
+	F64 m_timeBudget = 0.002;
+	List<StreamedSector> m_sectors;
+	PtrSize m_fileSize = 0;
+
+	/// The prefetch tasks that haven't finished. The destructor waits for them.
+	Atomic<U32> m_prefetchesInFlight = {0};
+
+	StreamedSector* findStreamedSector(const Sector& sector);
+
+	ANKI_USE_RESULT Error parseManifest(const CString& filename, StreamedSector& out);
+
+	void startLoading(StreamedSector& s);
+	void unload(StreamedSector& s);
+
+	/// Create the models of the sector until the time budget runs out.
+	ANKI_USE_RESULT Error createModels(StreamedSector& s, F64 deadline);
+
+	void destroySector(StreamedSector& s);
+
+	/// Find the index of the sector of the camera in a sorted array of sectors.
+	static U32 findCameraSector(WeakArray<Sector*> sectors, const Vec4& cameraPos);
+};
+/// @}
+
+} // end namespace anki
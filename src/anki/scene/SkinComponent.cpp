@@ -0,0 +1,31 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/scene/SkinComponent.h>
+#include <anki/scene/SceneNode.h>
+#include <anki/resource/ResourceManager.h>
+#include <anki/gr/GrManager.h>
+
+namespace anki
+{
+
+SkinComponent::SkinComponent(SceneNode* node, SkeletonResourcePtr skeleton)
+	: SceneComponent(CLASS_TYPE, node)
+{
+	m_player.init(getAllocator(), skeleton);
+}
+
+SkinComponent::~SkinComponent()
+{
+}
+
+void SkinComponent::uploadBoneMatrices(GrManager& gr)
+{
+	const PtrSize size = m_player.getBoneCount() * sizeof(Mat3x4);
+	void* mem = gr.allocateFrameTransientMemory(size, BufferUsageBit::STORAGE_VERTEX_READ, m_token);
+	memcpy(mem, m_player.getBoneMatrices(), size);
+}
+
+} // end namespace anki
@@ -0,0 +1,56 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/scene/SceneComponent.h>
+#include <anki/scene/AnimationPlayer.h>
+#include <anki/gr/Common.h>
+
+namespace anki
+{
+
+/// @addtogroup scene
+/// @{
+
+/// Skeletal animation component. The SceneGraph updates all of them at once after the scene nodes and it uploads the
+/// bone matrices to the GPU.
+class SkinComponent : public SceneComponent
+{
+public:
+	static const SceneComponentType CLASS_TYPE = SceneComponentType::SKIN;
+
+	SkinComponent(SceneNode* node, SkeletonResourcePtr skeleton);
+
+	~SkinComponent();
+
+	AnimationPlayer& getAnimationPlayer()
+	{
+		return m_player;
+	}
+
+	const AnimationPlayer& getAnimationPlayer() const
+	{
+		return m_player;
+	}
+
+	/// The bone matrices of this frame in transient memory. Bind it as a storage buffer. It's valid after the
+	/// SceneGraph update.
+	const TransientMemoryToken& getBoneMatricesToken() const
+	{
+		return m_token;
+	}
+
+anki_internal:
+	/// Copy the bone matrices of the AnimationPlayer to the GPU.
+	void uploadBoneMatrices(GrManager& gr);
+
+private:
+	AnimationPlayer m_player;
+	TransientMemoryToken m_token;
+};
+/// @}
+
+} // end namespace anki
@@ -0,0 +1,479 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/scene/StaticGeometryBatcher.h>
+#include <anki/scene/StaticGeometryNode.h>
+#include <anki/scene/SceneGraph.h>
+#include <anki/resource/ResourceManager.h>
+#include <anki/resource/MeshLoader.h>
+#include <anki/resource/Mesh.h>
+#include <anki/resource/Material.h>
+#include <anki/util/Filesystem.h>
+#include <anki/util/File.h>
+#include <anki/util/Hash.h>
+#include <algorithm>
+
+namespace anki
+{
+
+class StaticGeometryClusterContext
+{
+public:
+	WeakArray<const StaticGeometryBatchItem> m_items;
+	const StaticGeometryClusterLimits* m_limits = nullptr;
+	U32* m_order = nullptr;
+	StaticGeometryCluster* m_clusters = nullptr;
+	U32 m_clusterCount = 0;
+};
+
+static Vec4 getCenter(const Aabb& box)
+{
+	return (box.getMin() + box.getMax()) * 0.5f;
+}
+
+static void splitCluster(StaticGeometryClusterContext& ctx, U32 begin, U32 end)
+{
+	ANKI_ASSERT(begin < end);
+	const StaticGeometryClusterLimits& limits = *ctx.m_limits;
+
+	Aabb bounds = ctx.m_items[ctx.m_order[begin]].m_bounds;
+	Vec4 centerMin = getCenter(bounds);
+	Vec4 centerMax = centerMin;
+	U64 vertCount = 0;
+	for(U32 i = begin; i < end; ++i)
+	{
+		const StaticGeometryBatchItem& item = ctx.m_items[ctx.m_order[i]];
+		bounds = bounds.getCompoundShape(item.m_bounds);
+		vertCount += item.m_vertexCount;
+
+		const Vec4 center = getCenter(item.m_bounds);
+		for(U c = 0; c < 3; ++c)
+		{
+			centerMin[c] = min(centerMin[c], center[c]);
+			centerMax[c] = max(centerMax[c], center[c]);
+		}
+	}
+
+	const Vec4 size = bounds.getMax() - bounds.getMin();
+	if(end - begin == 1
+		|| (vertCount <= limits.m_maxVertexCount && max(size.x(), max(size.y(), size.z())) <= limits.m_maxSize))
+	{
+		StaticGeometryCluster& cluster = ctx.m_clusters[ctx.m_clusterCount++];
+		cluster.m_firstItem = begin;
+		cluster.m_itemCount = end - begin;
+		cluster.m_bounds = bounds;
+		return;
+	}
+
+	// Split at the median of the longest axis of the centers. Same centers end up split by count
+	const Vec4 spread = centerMax - centerMin;
+	U axis = (spread.x() >= spread.y()) ? 0 : 1;
+	axis = (spread[axis] >= spread.z()) ? axis : 2;
+
+	const U32 middle = begin + (end - begin) / 2;
+	std::nth_element(
+		ctx.m_order + begin, ctx.m_order + middle, ctx.m_order + end, [&](U32 a, U32 b) {
+			return getCenter(ctx.m_items[a].m_bounds)[axis] < getCenter(ctx.m_items[b].m_bounds)[axis];
+		});
+
+	splitCluster(ctx, begin, middle);
+	splitCluster(ctx, middle, end);
+}
+
+void clusterStaticGeometry(WeakArray<const StaticGeometryBatchItem> items,
+	const StaticGeometryClusterLimits& limits,
+	DynamicArrayAuto<U32>& order,
+	DynamicArrayAuto<StaticGeometryCluster>& clusters)
+{
+	order.destroy();
+	clusters.destroy();
+
+	const U32 count = items.getSize();
+	if(count == 0)
+	{
+		return;
+	}
+
+	// Sort by key. The rest of the order is the order of the input so the output doesn't depend on the sort
+	order.create(count);
+	for(U32 i = 0; i < count; ++i)
+	{
+		order[i] = i;
+	}
+
+	std::sort(&order[0], &order[0] + count, [&](U32 a, U32 b) {
+		return (items[a].m_batchKey != items[b].m_batchKey) ? items[a].m_batchKey < items[b].m_batchKey : a < b;
+	});
+
+	// Split every range of the same key. There can't be more clusters than items
+	clusters.create(count);
+
+	StaticGeometryClusterContext ctx;
+	ctx.m_items = items;
+	ctx.m_limits = &limits;
+	ctx.m_order = &order[0];
+	ctx.m_clusters = &clusters[0];
+
+	U32 begin = 0;
+	while(begin < count)
+	{
+		U32 end = begin + 1;
+		while(end < count && items[order[end]].m_batchKey == items[order[begin]].m_batchKey)
+		{
+			++end;
+		}
+
+		splitCluster(ctx, begin, end);
+		begin = end;
+	}
+
+	if(ctx.m_clusterCount < count)
+	{
+		clusters.resize(ctx.m_clusterCount);
+	}
+}
+
+/// Bump it when the files that build() writes change.
+static const U32 CACHE_VERSION = 2;
+
+/// Get the mesh of a LOD or the last one if the patch has less LODs.
+static const Mesh& getLodMesh(const ModelPatch& patch, U lod)
+{
+	RenderingKey key;
+	key.m_lod = min<U>(lod, patch.getMeshCount() - 1);
+	return patch.getMesh(key);
+}
+
+StaticGeometryBatcher::StaticGeometryBatcher(SceneGraph* scene)
+	: m_scene(scene)
+{
+	ANKI_ASSERT(scene);
+}
+
+StaticGeometryBatcher::~StaticGeometryBatcher()
+{
+	m_pending.destroy(m_scene->getAllocator());
+}
+
+void StaticGeometryBatcher::setLimits(const StaticGeometryClusterLimits& limits)
+{
+	// The merged meshes have 16bit indices
+	ANKI_ASSERT(limits.m_maxVertexCount <= MAX_U16 + 1);
+	ANKI_ASSERT(limits.m_maxSize > 0.0);
+	m_limits = limits;
+}
+
+Error StaticGeometryBatcher::addModel(const ModelResourcePtr& model, const Transform& trf)
+{
+	if(model->getSkeleton().isCreated())
+	{
+		ANKI_LOGE("Static geometry can't be skinned: %s", &model->getFilename()[0]);
+		return ErrorCode::USER_DATA;
+	}
+
+	for(const ModelPatch* patch : model->getModelPatches())
+	{
+		for(U lod = 0; lod < patch->getMeshCount(); ++lod)
+		{
+			if(getLodMesh(*patch, lod).hasBoneWeights())
+			{
+				ANKI_LOGE("Static geometry can't have bone weights: %s", &model->getFilename()[0]);
+				return ErrorCode::USER_DATA;
+			}
+		}
+	}
+
+	for(const ModelPatch* patch : model->getModelPatches())
+	{
+		PendingPatch pending;
+		pending.m_model = model;
+		pending.m_patch = patch;
+		pending.m_trf = trf;
+		m_pending.pushBack(m_scene->getAllocator(), pending);
+	}
+
+	return ErrorCode::NONE;
+}
+
+Error StaticGeometryBatcher::build()
+{
+	ANKI_ASSERT(hasPending());
+	ResourceManager& resources = m_scene->getResourceManager();
+	const auto& pool = m_scene->getAllocator().getMemoryPool();
+	HeapAllocator<U8> alloc(pool.getAllocationCallback(), pool.getAllocationCallbackUserData());
+
+	// Gather the items. The name of the output depends on the input so a level that is loaded again finds it in the
+	// cache. The contents of the meshes are part of it so an edited mesh doesn't pick a stale model
+	const U32 count = m_pending.getSize();
+	DynamicArrayAuto<const PendingPatch*> patches(alloc);
+	DynamicArrayAuto<StaticGeometryBatchItem> items(alloc);
+	patches.create(count);
+	items.create(count);
+
+	U64 hash = computeHash(&m_limits, sizeof(m_limits));
+	hash = appendHash(&CACHE_VERSION, sizeof(CACHE_VERSION), hash);
+	U32 i = 0;
+	for(const PendingPatch& pending : m_pending)
+	{
+		const ModelPatch& patch = *pending.m_patch;
+		StaticGeometryBatchItem& item = items[i];
+		patches[i] = &pending;
+		++i;
+
+		patch.getBoundingShape().getTransformed(pending.m_trf).computeAabb(item.m_bounds);
+		item.m_batchKey = ptrToNumber(&patch.getMaterial());
+
+		for(U lod = 0; lod < patch.getMeshCount(); ++lod)
+		{
+			const Mesh& mesh = getLodMesh(patch, lod);
+			item.m_vertexCount = max(item.m_vertexCount, mesh.getVerticesCount());
+
+			const CString fname = mesh.getFilename();
+			hash = appendHash(&fname[0], fname.getLength(), hash);
+			const U64 contentHash = mesh.getContentHash();
+			hash = appendHash(&contentHash, sizeof(contentHash), hash);
+		}
+
+		const CString mtlFname = patch.getMaterial().getFilename();
+		hash = appendHash(&mtlFname[0], mtlFname.getLength(), hash);
+		hash = appendHash(&pending.m_trf.getOrigin(), sizeof(Vec4), hash);
+		hash = appendHash(&pending.m_trf.getRotation(), sizeof(Mat3x4), hash);
+		const F32 scale = pending.m_trf.getScale();
+		hash = appendHash(&scale, sizeof(scale), hash);
+	}
+
+	DynamicArrayAuto<U32> order(alloc);
+	DynamicArrayAuto<StaticGeometryCluster> clusters(alloc);
+	clusterStaticGeometry(
+		WeakArray<const StaticGeometryBatchItem>(&items[0], items.getSize()), m_limits, order, clusters);
+
+	StringAuto prefix(alloc);
+	StringAuto hashStr(alloc);
+	hashStr.toString(hash);
+	prefix.sprintf("staticgeom_%s", &hashStr[0]);
+
+	StringAuto modelFname(alloc);
+	modelFname.sprintf("%s.ankimdl", &prefix[0]);
+
+	StringAuto modelPath(alloc);
+	modelPath.sprintf("%s/%s", &resources._getCacheDirectory()[0], &modelFname[0]);
+
+	if(!fileExists(modelPath.toCString()))
+	{
+		ANKI_CHECK(writeModel(alloc,
+			WeakArray<const PendingPatch*>(&patches[0], patches.getSize()),
+			WeakArray<const U32>(&order[0], order.getSize()),
+			WeakArray<const StaticGeometryCluster>(&clusters[0], clusters.getSize()),
+			prefix.toCString(),
+			modelPath.toCString()));
+	}
+
+	ANKI_LOGI("Static geometry: %u patches merged in %u clusters", count, U32(clusters.getSize()));
+
+	// Create the nodes. The source models are released with the pending patches
+	ModelResourcePtr model;
+	ANKI_CHECK(resources.loadResource(modelFname.toCString(), model));
+
+	for(const ModelPatch* patch : model->getModelPatches())
+	{
+		StaticGeometryPatchNode* node;
+		ANKI_CHECK(m_scene->newSceneNode<StaticGeometryPatchNode>(CString(), node, model, patch));
+	}
+
+	m_pending.destroy(m_scene->getAllocator());
+
+	return ErrorCode::NONE;
+}
+
+Error StaticGeometryBatcher::writeModel(HeapAllocator<U8> alloc,
+	WeakArray<const PendingPatch*> patches,
+	WeakArray<const U32> order,
+	WeakArray<const StaticGeometryCluster> clusters,
+	CString prefix,
+	CString filename)
+{
+	const CString cacheDir = m_scene->getResourceManager()._getCacheDirectory().toCString();
+
+	// The existence of the model means that the cache is complete so write the meshes first
+	DynamicArrayAuto<U8> lodCounts(alloc);
+	lodCounts.create(clusters.getSize());
+	for(U32 c = 0; c < clusters.getSize(); ++c)
+	{
+		const StaticGeometryCluster& cluster = clusters[c];
+		WeakArray<const U32> clusterOrder(&order[cluster.m_firstItem], cluster.m_itemCount);
+
+		U lodCount = 0;
+		for(U32 idx : clusterOrder)
+		{
+			lodCount = max<U>(lodCount, patches[idx]->m_patch->getMeshCount());
+		}
+		lodCounts[c] = lodCount;
+
+		for(U lod = 0; lod < lodCount; ++lod)
+		{
+			StringAuto meshPath(alloc);
+			meshPath.sprintf("%s/%s_%u_%u.ankimesh", &cacheDir[0], &prefix[0], c, U32(lod));
+
+			ANKI_CHECK(writeMesh(alloc, patches, clusterOrder, lod, meshPath.toCString()));
+		}
+	}
+
+	// Write the model under a temporary name and put it in place when it's complete. An interrupted write doesn't leave
+	// a truncated model that the next run trusts
+	StringAuto tmpFilename(alloc);
+	tmpFilename.sprintf("%s.tmp", &filename[0]);
+
+	{
+		File file;
+		ANKI_CHECK(file.open(tmpFilename.toCString(), FileOpenFlag::WRITE));
+		ANKI_CHECK(file.writeText("<model>\n\t<modelPatches>\n"));
+
+		for(U32 c = 0; c < clusters.getSize(); ++c)
+		{
+			ANKI_CHECK(file.writeText("\t\t<modelPatch>\n"));
+
+			for(U lod = 0; lod < lodCounts[c]; ++lod)
+			{
+				StringAuto tag(alloc);
+				if(lod == 0)
+				{
+					tag.create("mesh");
+				}
+				else
+				{
+					tag.sprintf("mesh%u", U32(lod));
+				}
+
+				ANKI_CHECK(file.writeText(
+					"\t\t\t<%s>%s_%u_%u.ankimesh</%s>\n", &tag[0], &prefix[0], c, U32(lod), &tag[0]));
+			}
+
+			const U32 firstIdx = order[clusters[c].m_firstItem];
+			const CString mtlFname = patches[firstIdx]->m_patch->getMaterial().getFilename();
+			ANKI_CHECK(file.writeText("\t\t\t<material>%s</material>\n\t\t</modelPatch>\n", &mtlFname[0]));
+		}
+
+		ANKI_CHECK(file.writeText("\t</modelPatches>\n</model>\n"));
+	}
+
+	ANKI_CHECK(renameFile(tmpFilename.toCString(), filename));
+
+	return ErrorCode::NONE;
+}
+
+Error StaticGeometryBatcher::writeMesh(HeapAllocator<U8> alloc,
+	WeakArray<const PendingPatch*> patches,
+	WeakArray<const U32> clusterOrder,
+	U lod,
+	CString filename)
+{
+	U32 vertCount = 0;
+	U32 indexCount = 0;
+	for(U32 idx : clusterOrder)
+	{
+		const Mesh& mesh = getLodMesh(*patches[idx]->m_patch, lod);
+		vertCount += mesh.getVerticesCount();
+		indexCount += mesh.getIndicesCount();
+	}
+
+	// The indices are 16bit so only the vertices are limited. A single patch that is out of the limits is alone and it
+	// already has 16bit indices
+	ANKI_ASSERT(vertCount <= MAX_U16 + 1);
+
+	DynamicArrayAuto<MeshLoader::Vertex> verts(alloc);
+	DynamicArrayAuto<Vec3> positions(alloc);
+	DynamicArrayAuto<Vec3> normals(alloc);
+	DynamicArrayAuto<Vec4> tangents(alloc);
+	DynamicArrayAuto<U16> indices(alloc);
+	verts.create(vertCount);
+	positions.create(vertCount);
+	normals.create(vertCount);
+	tangents.create(vertCount);
+	indices.create(indexCount);
+
+	// Move the vertices to world space
+	MeshLoader::Header header;
+	U32 vertOffset = 0;
+	U32 indexOffset = 0;
+	F32 lodError = 0.0;
+	for(U32 idx : clusterOrder)
+	{
+		const PendingPatch& pending = *patches[idx];
+		const Mat3 rot = pending.m_trf.getRotation().getRotationPart();
+
+		MeshLoader loader(&m_scene->getResourceManager(), alloc);
+		ANKI_CHECK(loader.load(getLodMesh(*pending.m_patch, lod).getFilename()));
+		ANKI_ASSERT(!loader.hasBoneInfo());
+		header = loader.getHeader();
+
+		// The error of the merged mesh is the worst error of its parts
+		lodError = max(lodError, header.m_lodError * pending.m_trf.getScale());
+
+		const U32 loaderVertCount = header.m_totalVerticesCount;
+		for(U32 v = 0; v < loaderVertCount; ++v)
+		{
+			const U32 outIdx = vertOffset + v;
+			verts[outIdx] = *reinterpret_cast<const MeshLoader::Vertex*>(
+				loader.getVertexData() + v * loader.getVertexSize());
+
+			Vec3 normal;
+			Vec4 tangent;
+			MeshLoader::unpackVertexDirections(verts[outIdx], normal, tangent);
+
+			positions[outIdx] = pending.m_trf.transform(loader.getPositions()[v]);
+			normals[outIdx] = rot * normal;
+			tangents[outIdx] = Vec4(rot * tangent.xyz(), tangent.w());
+		}
+
+		const U16* inIndices = reinterpret_cast<const U16*>(loader.getIndexData());
+		for(U32 j = 0; j < header.m_totalIndicesCount; ++j)
+		{
+			indices[indexOffset + j] = U16(inIndices[j] + vertOffset);
+		}
+
+		vertOffset += loaderVertCount;
+		indexOffset += header.m_totalIndicesCount;
+	}
+
+	ANKI_ASSERT(vertOffset == vertCount && indexOffset == indexCount);
+
+	// Quantize in the bounds of the cluster
+	Vec3 offset;
+	F32 scale;
+	MeshLoader::computePositionDequantization(&positions[0], vertCount, offset, scale);
+
+	for(U32 v = 0; v < vertCount; ++v)
+	{
+		MeshLoader::packVertex(positions[v], normals[v], tangents[v], offset, scale, verts[v]);
+	}
+
+	// The formats of the loaded header are the formats of the merged vertices
+	memcpy(&header.m_magic[0], "ANKIMES4", 8);
+	header.m_flags = 0;
+	header.m_totalVerticesCount = vertCount;
+	header.m_totalIndicesCount = indexCount;
+	header.m_subMeshCount = 1;
+	for(U c = 0; c < 3; ++c)
+	{
+		header.m_positionOffset[c] = offset[c];
+	}
+	header.m_positionScale = scale;
+	header.m_lodError = lodError;
+
+	MeshLoader::SubMesh subMesh;
+	subMesh.m_firstIndex = 0;
+	subMesh.m_indicesCount = indexCount;
+
+	File file;
+	ANKI_CHECK(file.open(filename, FileOpenFlag::WRITE | FileOpenFlag::BINARY));
+	ANKI_CHECK(file.write(&header, sizeof(header)));
+	ANKI_CHECK(file.write(&subMesh, sizeof(subMesh)));
+	ANKI_CHECK(file.write(&indices[0], indices.getSizeInBytes()));
+	ANKI_CHECK(file.write(&verts[0], verts.getSizeInBytes()));
+
+	return ErrorCode::NONE;
+}
+
+} // end namespace anki
@@ -0,0 +1,112 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/scene/Common.h>
+#include <anki/resource/Model.h>
+#include <anki/collision/Aabb.h>
+#include <anki/util/List.h>
+#include <anki/Math.h>
+
+namespace anki
+{
+
+/// @addtogroup scene
+/// @{
+
+/// An input of clusterStaticGeometry().
+class StaticGeometryBatchItem
+{
+public:
+	Aabb m_bounds; ///< In world space.
+	U32 m_vertexCount = 0;
+	U64 m_batchKey = 0; ///< Only the items with the same key end up in the same cluster. Eg the material.
+};
+
+/// The limits of a cluster of clusterStaticGeometry(). A single item that exceeds them is a cluster of its own.
+class StaticGeometryClusterLimits
+{
+public:
+	U32 m_maxVertexCount = MAX_U16 + 1; ///< The merged meshes have 16bit indices. The index count is not limited.
+	F32 m_maxSize = 32.0; ///< The max size of the bounds of a cluster in any axis.
+};
+
+/// An output of clusterStaticGeometry().
+class StaticGeometryCluster
+{
+public:
+	U32 m_firstItem = 0; ///< The first item in the order array.
+	U32 m_itemCount = 0;
+	Aabb m_bounds; ///< The bounds of the items of the cluster.
+};
+
+/// Group items with the same batch key in spatially compact clusters. The items are split at the median of the longest
+/// axis of their centers until every cluster is inside the limits so the bounds of the clusters stay tight. It doesn't
+/// depend on the scene.
+/// @param items The items.
+/// @param limits The limits of a cluster.
+/// @param[out] order The indices of the items ordered by cluster.
+/// @param[out] clusters The clusters.
+void clusterStaticGeometry(WeakArray<const StaticGeometryBatchItem> items,
+	const StaticGeometryClusterLimits& limits,
+	DynamicArrayAuto<U32>& order,
+	DynamicArrayAuto<StaticGeometryCluster>& clusters);
+
+/// Merges the patches of the static models in a few large meshes. The patches that share a material are grouped with
+/// clusterStaticGeometry() and every cluster becomes a mesh in world space with its own bounds. The meshes and a model
+/// that puts them together are written to the cache directory and they are reused if the same input is built again.
+class StaticGeometryBatcher : public NonCopyable
+{
+public:
+	StaticGeometryBatcher(SceneGraph* scene);
+
+	~StaticGeometryBatcher();
+
+	void setLimits(const StaticGeometryClusterLimits& limits);
+
+	/// Queue the patches of a model for the next build().
+	ANKI_USE_RESULT Error addModel(const ModelResourcePtr& model, const Transform& trf);
+
+	Bool hasPending() const
+	{
+		return !m_pending.isEmpty();
+	}
+
+	/// Merge the queued patches and create a StaticGeometryPatchNode for every cluster.
+	ANKI_USE_RESULT Error build();
+
+private:
+	class PendingPatch
+	{
+	public:
+		ModelResourcePtr m_model;
+		const ModelPatch* m_patch;
+		Transform m_trf;
+	};
+
+	SceneGraph* m_scene;
+	StaticGeometryClusterLimits m_limits;
+	List<PendingPatch> m_pending;
+
+	/// Write the merged meshes of the clusters and then a model with a patch for every cluster. The model is renamed in
+	/// place when it's complete so it exists only if all the files were written.
+	ANKI_USE_RESULT Error writeModel(HeapAllocator<U8> alloc,
+		WeakArray<const PendingPatch*> patches,
+		WeakArray<const U32> order,
+		WeakArray<const StaticGeometryCluster> clusters,
+		CString prefix,
+		CString filename);
+
+	/// Merge a LOD of the patches of a cluster in a mesh file.
+	ANKI_USE_RESULT Error writeMesh(HeapAllocator<U8> alloc,
+		WeakArray<const PendingPatch*> patches,
+		WeakArray<const U32> clusterOrder,
+		U lod,
+		CString filename);
+};
+/// @}
+
+} // end namespace anki
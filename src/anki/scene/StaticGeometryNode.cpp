@@ -5,6 +5,7 @@
 
 #include <anki/scene/StaticGeometryNode.h>
 #include <anki/scene/SceneGraph.h>
+#include <anki/scene/StaticGeometryBatcher.h>
 #include <anki/resource/ResourceManager.h>
 #include <anki/resource/Model.h>
 
@@ -27,6 +28,12 @@ public:
 	{
 		return m_node->buildRendering(in, out);
 	}
+
+	U getLodErrors(Array<F32, MAX_LODS>& errors) const override
+	{
+		// The meshes are in world space already
+		return m_node->m_modelPatch->getLodErrors(1.0, errors);
+	}
 };
 
 StaticGeometryPatchNode::StaticGeometryPatchNode(SceneGraph* scene, CString name)
@@ -38,34 +45,47 @@ StaticGeometryPatchNode::~StaticGeometryPatchNode()
 {
 }
 
-Error StaticGeometryPatchNode::init(const ModelPatch* modelPatch)
+Error StaticGeometryPatchNode::init(const ModelResourcePtr& model, const ModelPatch* modelPatch)
 {
 	ANKI_ASSERT(modelPatch);
 
+	m_model = model;
 	m_modelPatch = modelPatch;
+	m_obb = m_modelPatch->getBoundingShape();
 
-	// Create spatial components
-	for(U i = 1; i < m_modelPatch->getSubMeshesCount(); i++)
-	{
-		SpatialComponent* spatial =
-			getSceneAllocator().newInstance<SpatialComponent>(this, &m_modelPatch->getBoundingShapeSub(i));
-
-		addComponent(spatial, true);
-
-		spatial->setSpatialOrigin(m_modelPatch->getBoundingShapeSub(i).getCenter());
-		spatial->setAutomaticCleanup(true);
-	}
+	// Spatial component
+	SpatialComponent* spatial = getSceneAllocator().newInstance<SpatialComponent>(this, &m_obb);
+	addComponent(spatial, true);
+	spatial->setSpatialOrigin(m_obb.getCenter());
 
-	// Create render component
+	// Render component
 	RenderComponent* rcomp = getSceneAllocator().newInstance<StaticGeometryRenderComponent>(this);
 	addComponent(rcomp, true);
+	ANKI_CHECK(rcomp->init());
 
 	return ErrorCode::NONE;
 }
 
 Error StaticGeometryPatchNode::buildRendering(const RenderingBuildInfoIn& in, RenderingBuildInfoOut& out) const
 {
-	ANKI_ASSERT(!"TODO");
+	ModelRenderingInfo modelInf(*out.m_state);
+	m_modelPatch->getRenderingDataSub(in.m_key, WeakArray<U8>(), modelInf);
+	ANKI_ASSERT(modelInf.m_stateMask
+		== (PipelineSubStateBit::VERTEX | PipelineSubStateBit::SHADERS | PipelineSubStateBit::INPUT_ASSEMBLER));
+
+	out.m_stateMask = modelInf.m_stateMask;
+
+	ANKI_ASSERT(modelInf.m_drawcallCount == 1 && "Cannot accept multi-draw");
+	out.m_resourceGroup = modelInf.m_resourceGroup;
+	out.m_drawcall.m_elements.m_count = modelInf.m_indicesCountArray[0];
+	out.m_drawcall.m_elements.m_instanceCount = in.m_key.m_instanceCount;
+	out.m_drawcall.m_elements.m_firstIndex = modelInf.m_indicesOffsetArray[0] / sizeof(U16);
+	out.m_drawcall.m_elements.m_baseVertex = modelInf.m_baseVertex;
+
+	// The vertices are in world space so the dequantization is the whole transform
+	out.m_hasTransform = true;
+	out.m_transform = modelInf.m_dequantizationTransform;
+
 	return ErrorCode::NONE;
 }
 
@@ -78,18 +98,11 @@ StaticGeometryNode::~StaticGeometryNode()
 {
 }
 
-Error StaticGeometryNode::init(const CString& filename)
+Error StaticGeometryNode::init(const CString& filename, const Transform& trf)
 {
-	ANKI_CHECK(getResourceManager().loadResource(filename, m_model));
-
-	U i = 0;
-	for(const ModelPatch* patch : m_model->getModelPatches())
-	{
-		StaticGeometryPatchNode* node;
-		ANKI_CHECK(getSceneGraph().newSceneNode<StaticGeometryPatchNode>(CString(), node, patch));
-
-		++i;
-	}
+	ModelResourcePtr model;
+	ANKI_CHECK(getResourceManager().loadResource(filename, model));
+	ANKI_CHECK(getSceneGraph().getStaticGeometryBatcher().addModel(model, trf));
 
 	return ErrorCode::NONE;
 }
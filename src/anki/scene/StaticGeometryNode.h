@@ -9,17 +9,16 @@
 #include <anki/scene/SceneNode.h>
 #include <anki/scene/SpatialComponent.h>
 #include <anki/scene/RenderComponent.h>
+#include <anki/resource/Model.h>
+#include <anki/collision/Obb.h>
 
 namespace anki
 {
 
-// Forward
-class ModelPatch;
-
 /// @addtogroup scene
 /// @{
 
-/// Static geometry scene node patch
+/// A cluster of merged static geometry. It's created by the StaticGeometryBatcher and the geometry is in world space.
 class StaticGeometryPatchNode : public SceneNode
 {
 	friend class StaticGeometryRenderComponent;
@@ -29,15 +28,21 @@ public:
 
 	~StaticGeometryPatchNode();
 
-	ANKI_USE_RESULT Error init(const ModelPatch* modelPatch);
+	/// @param model The merged model.
+	/// @param modelPatch A patch of the merged model.
+	ANKI_USE_RESULT Error init(const ModelResourcePtr& model, const ModelPatch* modelPatch);
 
 private:
-	const ModelPatch* m_modelPatch;
+	ModelResourcePtr m_model;
+	const ModelPatch* m_modelPatch = nullptr;
+	Obb m_obb; ///< In world space.
 
 	ANKI_USE_RESULT Error buildRendering(const RenderingBuildInfoIn& in, RenderingBuildInfoOut& out) const;
 };
 
-/// Static geometry scene node
+/// Static geometry scene node. It doesn't render anything itself. Its model is given to the StaticGeometryBatcher and
+/// it's merged with the rest of the static geometry in a few StaticGeometryPatchNodes on the next update. The model
+/// can't be skinned.
 class StaticGeometryNode : public SceneNode
 {
 public:
@@ -45,10 +50,9 @@ public:
 
 	~StaticGeometryNode();
 
-	ANKI_USE_RESULT Error init(const CString& filename);
-
-private:
-	ModelResourcePtr m_model;
+	/// @param filename The model.
+	/// @param trf The world transform of the model.
+	ANKI_USE_RESULT Error init(const CString& filename, const Transform& trf);
 };
 /// @}
 
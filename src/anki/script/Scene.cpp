@@ -2207,6 +2207,73 @@ static inline void wrapStaticCollisionNode(lua_State* l)
 	lua_settop(l, 0);
 }
 
+static const char* classnameStaticGeometryNode = "StaticGeometryNode";
+
+template<>
+I64 LuaBinder::getWrappedTypeSignature<StaticGeometryNode>()
+{
+	return -9111537891634040048;
+}
+
+template<>
+const char* LuaBinder::getWrappedTypeName<StaticGeometryNode>()
+{
+	return classnameStaticGeometryNode;
+}
+
+/// Pre-wrap method StaticGeometryNode::getSceneNodeBase.
+static inline int pwrapStaticGeometryNodegetSceneNodeBase(lua_State* l)
+{
+	UserData* ud;
+	(void)ud;
+	void* voidp;
+	(void)voidp;
+	PtrSize size;
+	(void)size;
+
+	LuaBinder::checkArgsCount(l, 1);
+
+	// Get "this" as "self"
+	if(LuaBinder::checkUserData(l, 1, classnameStaticGeometryNode, -9111537891634040048, ud))
+	{
+		return -1;
+	}
+
+	StaticGeometryNode* self = ud->getData<StaticGeometryNode>();
+
+	// Call the method
+	SceneNode& ret = *self;
+
+	// Push return value
+	voidp = lua_newuserdata(l, sizeof(UserData));
+	ud = static_cast<UserData*>(voidp);
+	luaL_setmetatable(l, "SceneNode");
+	ud->initPointed(-2220074417980276571, const_cast<SceneNode*>(&ret));
+
+	return 1;
+}
+
+/// Wrap method StaticGeometryNode::getSceneNodeBase.
+static int wrapStaticGeometryNodegetSceneNodeBase(lua_State* l)
+{
+	int res = pwrapStaticGeometryNodegetSceneNodeBase(l);
+	if(res >= 0)
+	{
+		return res;
+	}
+
+	lua_error(l);
+	return 0;
+}
+
+/// Wrap class StaticGeometryNode.
+static inline void wrapStaticGeometryNode(lua_State* l)
+{
+	LuaBinder::createClass(l, classnameStaticGeometryNode);
+	LuaBinder::pushLuaCFuncMethod(l, "getSceneNodeBase", wrapStaticGeometryNodegetSceneNodeBase);
+	lua_settop(l, 0);
+}
+
 static const char* classnamePortal = "Portal";
 
 template<>
@@ -2333,11 +2400,67 @@ static int wrapSectorgetSceneNodeBase(lua_State* l)
 	return 0;
 }
 
+/// Pre-wrap method Sector::setStreamingManifest.
+static inline int pwrapSectorsetStreamingManifest(lua_State* l)
+{
+	UserData* ud;
+	(void)ud;
+	void* voidp;
+	(void)voidp;
+	PtrSize size;
+	(void)size;
+
+	LuaBinder::checkArgsCount(l, 2);
+
+	// Get "this" as "self"
+	if(LuaBinder::checkUserData(l, 1, classnameSector, 2371391302432627552, ud))
+	{
+		return -1;
+	}
+
+	Sector* self = ud->getData<Sector>();
+
+	// Pop arguments
+	const char* arg0;
+	if(LuaBinder::checkString(l, 2, arg0))
+	{
+		return -1;
+	}
+
+	// Call the method
+	Error ret = self->setStreamingManifest(arg0);
+
+	// Push return value
+	if(ANKI_UNLIKELY(ret))
+	{
+		lua_pushstring(l, "Glue code returned an error");
+		return -1;
+	}
+
+	lua_pushnumber(l, ret);
+
+	return 1;
+}
+
+/// Wrap method Sector::setStreamingManifest.
+static int wrapSectorsetStreamingManifest(lua_State* l)
+{
+	int res = pwrapSectorsetStreamingManifest(l);
+	if(res >= 0)
+	{
+		return res;
+	}
+
+	lua_error(l);
+	return 0;
+}
+
 /// Wrap class Sector.
 static inline void wrapSector(lua_State* l)
 {
 	LuaBinder::createClass(l, classnameSector);
 	LuaBinder::pushLuaCFuncMethod(l, "getSceneNodeBase", wrapSectorgetSceneNodeBase);
+	LuaBinder::pushLuaCFuncMethod(l, "setStreamingManifest", wrapSectorsetStreamingManifest);
 	lua_settop(l, 0);
 }
 
@@ -3000,6 +3123,78 @@ static int wrapSceneGraphnewStaticCollisionNode(lua_State* l)
 	return 0;
 }
 
+/// Pre-wrap method SceneGraph::newStaticGeometryNode.
+static inline int pwrapSceneGraphnewStaticGeometryNode(lua_State* l)
+{
+	UserData* ud;
+	(void)ud;
+	void* voidp;
+	(void)voidp;
+	PtrSize size;
+	(void)size;
+
+	LuaBinder::checkArgsCount(l, 4);
+
+	// Get "this" as "self"
+	if(LuaBinder::checkUserData(l, 1, classnameSceneGraph, -7754439619132389154, ud))
+	{
+		return -1;
+	}
+
+	SceneGraph* self = ud->getData<SceneGraph>();
+
+	// Pop arguments
+	const char* arg0;
+	if(LuaBinder::checkString(l, 2, arg0))
+	{
+		return -1;
+	}
+
+	const char* arg1;
+	if(LuaBinder::checkString(l, 3, arg1))
+	{
+		return -1;
+	}
+
+	if(LuaBinder::checkUserData(l, 4, "Transform", 7048620195620777229, ud))
+	{
+		return -1;
+	}
+
+	Transform* iarg2 = ud->getData<Transform>();
+	const Transform& arg2(*iarg2);
+
+	// Call the method
+	StaticGeometryNode* ret = newSceneNode<StaticGeometryNode>(self, arg0, arg1, arg2);
+
+	// Push return value
+	if(ANKI_UNLIKELY(ret == nullptr))
+	{
+		lua_pushstring(l, "Glue code returned nullptr");
+		return -1;
+	}
+
+	voidp = lua_newuserdata(l, sizeof(UserData));
+	ud = static_cast<UserData*>(voidp);
+	luaL_setmetatable(l, "StaticGeometryNode");
+	ud->initPointed(-9111537891634040048, const_cast<StaticGeometryNode*>(ret));
+
+	return 1;
+}
+
+/// Wrap method SceneGraph::newStaticGeometryNode.
+static int wrapSceneGraphnewStaticGeometryNode(lua_State* l)
+{
+	int res = pwrapSceneGraphnewStaticGeometryNode(l);
+	if(res >= 0)
+	{
+		return res;
+	}
+
+	lua_error(l);
+	return 0;
+}
+
 /// Pre-wrap method SceneGraph::newPortal.
 static inline int pwrapSceneGraphnewPortal(lua_State* l)
 {
@@ -3499,6 +3694,7 @@ static inline void wrapSceneGraph(lua_State* l)
 	LuaBinder::pushLuaCFuncMethod(l, "newPointLight", wrapSceneGraphnewPointLight);
 	LuaBinder::pushLuaCFuncMethod(l, "newSpotLight", wrapSceneGraphnewSpotLight);
 	LuaBinder::pushLuaCFuncMethod(l, "newStaticCollisionNode", wrapSceneGraphnewStaticCollisionNode);
+	LuaBinder::pushLuaCFuncMethod(l, "newStaticGeometryNode", wrapSceneGraphnewStaticGeometryNode);
 	LuaBinder::pushLuaCFuncMethod(l, "newPortal", wrapSceneGraphnewPortal);
 	LuaBinder::pushLuaCFuncMethod(l, "newSector", wrapSceneGraphnewSector);
 	LuaBinder::pushLuaCFuncMethod(l, "newParticleEmitter", wrapSceneGraphnewParticleEmitter);
@@ -3566,6 +3762,7 @@ void wrapModuleScene(lua_State* l)
 	wrapPointLight(l);
 	wrapSpotLight(l);
 	wrapStaticCollisionNode(l);
+	wrapStaticGeometryNode(l);
 	wrapPortal(l);
 	wrapSector(l);
 	wrapParticleEmitter(l);
@@ -178,6 +178,16 @@ public:
 private:
 	Value m_val;
 };
+
+/// Memory fence.
+inline void atomicThreadFence(AtomicMemoryOrder memOrd = AtomicMemoryOrder::SEQ_CST)
+{
+#if defined(__GNUC__)
+	__atomic_thread_fence(static_cast<int>(memOrd));
+#else
+#error "TODO"
+#endif
+}
 /// @}
 
 } // end namespace anki
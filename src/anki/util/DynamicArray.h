@@ -303,6 +303,12 @@ public:
 		Base::resize(m_alloc, size);
 	}
 
+	/// Destroy the array.
+	void destroy()
+	{
+		Base::destroy(m_alloc);
+	}
+
 private:
 	GenericMemoryPoolAllocator<T> m_alloc;
 };
@@ -37,6 +37,10 @@ ANKI_USE_RESULT Error removeDirectory(const CString& dir);
 /// Equivalent to: mkdir dir
 ANKI_USE_RESULT Error createDirectory(const CString& dir);
 
+/// Rename a file. If the new file exists it's replaced. Use it to write a file under a temporary name and then put it
+/// in place atomically.
+ANKI_USE_RESULT Error renameFile(const CString& oldName, const CString& newName);
+
 /// Get the home directory.
 /// Write the home directory to @a buff. The @a buffSize is the size of the @a buff. If the @buffSize is not enough the
 /// function will throw an exception.
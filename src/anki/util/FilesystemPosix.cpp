@@ -7,6 +7,7 @@
 #include <anki/util/Assert.h>
 #include <anki/util/Thread.h>
 #include <cstring>
+#include <cstdio>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <dirent.h>
@@ -170,6 +171,18 @@ Error createDirectory(const CString& dir)
 	return err;
 }
 
+Error renameFile(const CString& oldName, const CString& newName)
+{
+	Error err = ErrorCode::NONE;
+	if(rename(oldName.get(), newName.get()))
+	{
+		ANKI_LOGE("%s : %s", strerror(errno), oldName.get());
+		err = ErrorCode::FUNCTION_FAILED;
+	}
+
+	return err;
+}
+
 Error getHomeDirectory(GenericMemoryPoolAllocator<U8> alloc, String& out)
 {
 	const char* home = getenv("HOME");
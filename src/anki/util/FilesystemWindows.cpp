@@ -72,6 +72,18 @@ Error createDirectory(const CString& dir)
 	return err;
 }
 
+Error renameFile(const CString& oldName, const CString& newName)
+{
+	Error err = ErrorCode::NONE;
+	if(MoveFileEx(oldName.get(), newName.get(), MOVEFILE_REPLACE_EXISTING) == 0)
+	{
+		ANKI_LOGE("Failed to rename file %s", oldName.get());
+		err = ErrorCode::FUNCTION_FAILED;
+	}
+
+	return err;
+}
+
 Error getHomeDirectory(GenericMemoryPoolAllocator<U8> alloc, String& out)
 {
 	const char* homed = getenv("HOMEDRIVE");
@@ -0,0 +1,142 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/util/DynamicArray.h>
+#include <anki/util/Atomic.h>
+#include <anki/util/Functions.h>
+
+namespace anki
+{
+
+/// @addtogroup util_containers
+/// @{
+
+/// A bounded lock-free queue with multiple producers and a single consumer. Every slot carries a sequence number that
+/// tells if it's free for the producers or ready for the consumer.
+template<typename T>
+class MpscQueue : public NonCopyable
+{
+public:
+	using Value = T;
+
+	MpscQueue()
+	{
+	}
+
+	~MpscQueue()
+	{
+		ANKI_ASSERT(m_slots.getSize() == 0 && "Requires manual destruction");
+	}
+
+	/// Create the queue.
+	/// @param capacity The number of slots. Needs to be power of two.
+	template<typename TAllocator>
+	void create(TAllocator alloc, U32 capacity)
+	{
+		ANKI_ASSERT(isPowerOfTwo(capacity));
+		m_slots.create(alloc, capacity);
+		for(U32 i = 0; i < capacity; ++i)
+		{
+			m_slots[i].m_sequence.set(i);
+		}
+
+		m_mask = capacity - 1;
+		m_tail.set(0);
+		m_head = 0;
+	}
+
+	/// Destroy the queue. It will destroy any values that haven't been popped.
+	template<typename TAllocator>
+	void destroy(TAllocator alloc)
+	{
+		m_slots.destroy(alloc);
+	}
+
+	/// Push a value. It's thread-safe.
+	/// @return false if the queue is full.
+	Bool tryPush(const Value& value)
+	{
+		Slot* slot;
+		U64 pos = m_tail.load(AtomicMemoryOrder::RELAXED);
+		while(1)
+		{
+			slot = &m_slots[pos & m_mask];
+			const U64 seq = slot->m_sequence.load(AtomicMemoryOrder::ACQUIRE);
+			const I64 diff = I64(seq) - I64(pos);
+
+			if(diff == 0)
+			{
+				// Slot is free, try to claim it
+				if(m_tail.compareExchange(pos, pos + 1, AtomicMemoryOrder::RELAXED))
+				{
+					break;
+				}
+			}
+			else if(diff < 0)
+			{
+				// The consumer hasn't released the slot yet
+				return false;
+			}
+			else
+			{
+				// Another producer got it
+				pos = m_tail.load(AtomicMemoryOrder::RELAXED);
+			}
+		}
+
+		slot->m_value = value;
+		slot->m_sequence.store(pos + 1, AtomicMemoryOrder::RELEASE);
+		return true;
+	}
+
+	/// Pop a value. Only one thread is allowed to call it.
+	/// @return false if the queue is empty.
+	Bool tryPop(Value& value)
+	{
+		Slot& slot = m_slots[m_head & m_mask];
+		const U64 seq = slot.m_sequence.load(AtomicMemoryOrder::ACQUIRE);
+		if(I64(seq) - I64(m_head + 1) < 0)
+		{
+			return false;
+		}
+
+		value = std::move(slot.m_value);
+		slot.m_value = Value();
+
+		// Release the slot for the producers of the next lap
+		slot.m_sequence.store(m_head + m_mask + 1, AtomicMemoryOrder::RELEASE);
+		++m_head;
+		return true;
+	}
+
+	/// Check if it's empty. Only the consumer thread can have an accurate picture.
+	Bool isEmpty() const
+	{
+		return I64(m_slots[m_head & m_mask].m_sequence.load(AtomicMemoryOrder::ACQUIRE)) - I64(m_head + 1) < 0;
+	}
+
+	U32 getCapacity() const
+	{
+		return m_slots.getSize();
+	}
+
+private:
+	class Slot
+	{
+	public:
+		Atomic<U64> m_sequence;
+		Value m_value;
+	};
+
+	DynamicArray<Slot> m_slots;
+	U64 m_mask = 0;
+	Atomic<U64> m_tail = {0}; ///< Written by the producers.
+	U64 m_head = 0; ///< Written by the consumer.
+};
+/// @}
+
+} // end namespace anki
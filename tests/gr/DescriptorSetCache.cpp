@@ -0,0 +1,168 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/common/DescriptorSetCache.h>
+#include <tests/framework/Framework.h>
+
+namespace anki
+{
+
+class DSet : public DescriptorSetCacheSet
+{
+public:
+	U64 m_layout = 0;
+	U32 m_writeCount = 0;
+	U32 m_lastWrite = 0;
+};
+
+class DSetInterface final : public DescriptorSetCacheInterface
+{
+public:
+	U32 m_liveSets = 0;
+
+	ANKI_USE_RESULT Error newSet(U64 layout, DescriptorSetCacheSet*& set)
+	{
+		DSet* s = new DSet();
+		s->m_layout = layout;
+		set = s;
+		++m_liveSets;
+		return ErrorCode::NONE;
+	}
+
+	void deleteSet(DescriptorSetCacheSet* set)
+	{
+		delete static_cast<DSet*>(set);
+		--m_liveSets;
+	}
+
+	void writeSet(DescriptorSetCacheSet* set, void* userData)
+	{
+		DSet& s = *static_cast<DSet*>(set);
+		++s.m_writeCount;
+		s.m_lastWrite = *static_cast<U32*>(userData);
+	}
+};
+
+static DescriptorSetCacheKey newKey(U64 layout, U64 a, U64 b)
+{
+	DescriptorSetCacheKey key;
+	key.m_layout = layout;
+	key.pushBack(a);
+	key.pushBack(b);
+	return key;
+}
+
+ANKI_TEST(Gr, DescriptorSetCache)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	DSetInterface iface;
+
+	// Hits and misses
+	{
+		DescriptorSetCache cache;
+		cache.init(alloc, &iface, 2, 10);
+
+		U32 userData = 1;
+		DescriptorSetCacheHandle a, b, c;
+		ANKI_TEST_EXPECT_NO_ERR(cache.acquire(newKey(1, 10, 20), &userData, a));
+		ANKI_TEST_EXPECT_NO_ERR(cache.acquire(newKey(1, 10, 20), &userData, b));
+		ANKI_TEST_EXPECT_NO_ERR(cache.acquire(newKey(1, 20, 10), &userData, c));
+
+		ANKI_TEST_EXPECT_EQ(a.m_set, b.m_set);
+		ANKI_TEST_EXPECT_NEQ(a.m_set, c.m_set);
+		ANKI_TEST_EXPECT_EQ(static_cast<DSet*>(a.m_set)->m_writeCount, 1);
+
+		DescriptorSetCacheStats stats;
+		cache.getStats(stats);
+		ANKI_TEST_EXPECT_EQ(stats.m_hits, 1);
+		ANKI_TEST_EXPECT_EQ(stats.m_misses, 2);
+		ANKI_TEST_EXPECT_EQ(stats.m_setCount, 2);
+
+		// Unreferenced sets are still found
+		DescriptorSetCacheSet* set = a.m_set;
+		cache.release(a);
+		cache.release(b);
+		cache.endFrame();
+		ANKI_TEST_EXPECT_NO_ERR(cache.acquire(newKey(1, 10, 20), &userData, a));
+		ANKI_TEST_EXPECT_EQ(a.m_set, set);
+		ANKI_TEST_EXPECT_EQ(static_cast<DSet*>(a.m_set)->m_writeCount, 1);
+
+		cache.release(a);
+		cache.release(c);
+	}
+	ANKI_TEST_EXPECT_EQ(iface.m_liveSets, 0);
+
+	// Recycling
+	{
+		DescriptorSetCache cache;
+		cache.init(alloc, &iface, 2, 10);
+
+		U32 userData = 1;
+		DescriptorSetCacheHandle a;
+		ANKI_TEST_EXPECT_NO_ERR(cache.acquire(newKey(1, 10, 20), &userData, a));
+		DescriptorSetCacheSet* set = a.m_set;
+		cache.release(a);
+
+		// Too young to be recycled
+		cache.endFrame();
+		DescriptorSetCacheHandle b;
+		userData = 2;
+		ANKI_TEST_EXPECT_NO_ERR(cache.acquire(newKey(1, 30, 40), &userData, b));
+		ANKI_TEST_EXPECT_NEQ(b.m_set, set);
+		cache.release(b);
+
+		// Old enough but a different layout
+		cache.endFrame();
+		DescriptorSetCacheHandle c;
+		userData = 3;
+		ANKI_TEST_EXPECT_NO_ERR(cache.acquire(newKey(2, 10, 20), &userData, c));
+		ANKI_TEST_EXPECT_NEQ(c.m_set, set);
+		cache.release(c);
+
+		// Same layout, the oldest set gets rewritten
+		DescriptorSetCacheHandle d;
+		userData = 4;
+		ANKI_TEST_EXPECT_NO_ERR(cache.acquire(newKey(1, 50, 60), &userData, d));
+		ANKI_TEST_EXPECT_EQ(d.m_set, set);
+		ANKI_TEST_EXPECT_EQ(static_cast<DSet*>(d.m_set)->m_writeCount, 2);
+		ANKI_TEST_EXPECT_EQ(static_cast<DSet*>(d.m_set)->m_lastWrite, 4);
+
+		// The old bindings are gone from the cache
+		DescriptorSetCacheHandle e;
+		ANKI_TEST_EXPECT_NO_ERR(cache.acquire(newKey(1, 10, 20), &userData, e));
+		ANKI_TEST_EXPECT_NEQ(e.m_set, set);
+
+		DescriptorSetCacheStats stats;
+		cache.getStats(stats);
+		ANKI_TEST_EXPECT_EQ(stats.m_recycled, 1);
+
+		cache.release(d);
+		cache.release(e);
+	}
+	ANKI_TEST_EXPECT_EQ(iface.m_liveSets, 0);
+
+	// Deletion of old sets
+	{
+		DescriptorSetCache cache;
+		cache.init(alloc, &iface, 2, 4);
+
+		U32 userData = 0;
+		for(U i = 0; i < 8; ++i)
+		{
+			DescriptorSetCacheHandle h;
+			ANKI_TEST_EXPECT_NO_ERR(cache.acquire(newKey(i, i, i), &userData, h));
+			cache.release(h);
+			cache.endFrame();
+		}
+
+		DescriptorSetCacheStats stats;
+		cache.getStats(stats);
+		ANKI_TEST_EXPECT_EQ(stats.m_setCount, 4);
+		ANKI_TEST_EXPECT_EQ(iface.m_liveSets, 4);
+	}
+	ANKI_TEST_EXPECT_EQ(iface.m_liveSets, 0);
+}
+
+} // end namespace anki
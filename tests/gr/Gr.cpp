@@ -8,6 +8,8 @@
 #include <anki/core/NativeWindow.h>
 #include <anki/core/Config.h>
 #include <anki/util/HighRezTimer.h>
+#include <anki/gr/common/PipelinePersistentCache.h>
+#include <cstdio>
 
 namespace anki
 {
@@ -367,6 +369,57 @@ ANKI_TEST(Gr, Pipeline)
 	COMMON_END()
 }
 
+ANKI_TEST(Gr, PipelinePersistentCache)
+{
+	remove("./pipelines.cache");
+
+	// First run records the pipeline
+	{
+		COMMON_BEGIN()
+
+		GrObjectCache cache(gr);
+		PipelineInitInfo init;
+		init.m_shaders[ShaderType::VERTEX] = gr->newInstance<Shader>(ShaderType::VERTEX, VERT_SRC);
+		init.m_shaders[ShaderType::FRAGMENT] = gr->newInstance<Shader>(ShaderType::FRAGMENT, FRAG_SRC);
+		init.m_color.m_attachments[0].m_format.m_components = ComponentFormat::DEFAULT_FRAMEBUFFER;
+		init.m_color.m_attachmentCount = 1;
+		PipelinePtr ppline = cache.newInstance<Pipeline>(init);
+
+		PipelinePersistentCacheStats stats;
+		gr->getPipelinePersistentCache()->getStats(stats);
+		ANKI_TEST_EXPECT_EQ(stats.m_misses, 1);
+		ANKI_TEST_EXPECT_EQ(stats.m_recorded, 1);
+
+		COMMON_END()
+	}
+
+	// Second run gets it pre-created
+	{
+		COMMON_BEGIN()
+
+		PipelinePersistentCache& pcache = *gr->getPipelinePersistentCache();
+		ANKI_TEST_EXPECT_NO_ERR(pcache.waitPrecreation());
+
+		GrObjectCache cache(gr);
+		PipelineInitInfo init;
+		init.m_shaders[ShaderType::VERTEX] = gr->newInstance<Shader>(ShaderType::VERTEX, VERT_SRC);
+		init.m_shaders[ShaderType::FRAGMENT] = gr->newInstance<Shader>(ShaderType::FRAGMENT, FRAG_SRC);
+		init.m_color.m_attachments[0].m_format.m_components = ComponentFormat::DEFAULT_FRAMEBUFFER;
+		init.m_color.m_attachmentCount = 1;
+		PipelinePtr ppline = cache.newInstance<Pipeline>(init);
+		PipelinePtr ppline2 = cache.newInstance<Pipeline>(init);
+		ANKI_TEST_EXPECT_EQ(ppline.get(), ppline2.get());
+
+		PipelinePersistentCacheStats stats;
+		pcache.getStats(stats);
+		ANKI_TEST_EXPECT_EQ(stats.m_precreated, 1);
+		ANKI_TEST_EXPECT_EQ(stats.m_hits, 1);
+		ANKI_TEST_EXPECT_EQ(stats.m_misses, 0);
+
+		COMMON_END()
+	}
+}
+
 ANKI_TEST(Gr, SimpleDrawcall)
 {
 	COMMON_BEGIN()
@@ -1348,4 +1401,61 @@ ANKI_TEST(Gr, 3DTextures)
 	COMMON_END()
 }
 
+ANKI_TEST(Gr, CommandBufferBench)
+{
+	COMMON_BEGIN()
+
+	const U DRAW_COUNT = 10000;
+	const U ITERATION_COUNT = 20;
+
+	PipelinePtr ppline = createSimplePpline(VERT_SRC, FRAG_SRC, *gr);
+	FramebufferPtr fb = createDefaultFb(*gr);
+
+	HighRezTimer::Scalar recordTime = 0.0;
+	HighRezTimer::Scalar submitTime = 0.0;
+	HighRezTimer timer;
+
+	for(U i = 0; i < ITERATION_COUNT; ++i)
+	{
+		gr->beginFrame();
+
+		// Record
+		timer.start();
+
+		CommandBufferInitInfo cinit;
+		CommandBufferPtr cmdb = gr->newInstance<CommandBuffer>(cinit);
+
+		cmdb->setViewport(0, 0, WIDTH, HEIGHT);
+		cmdb->setPolygonOffset(0.0, 0.0);
+		cmdb->beginRenderPass(fb);
+		for(U d = 0; d < DRAW_COUNT; ++d)
+		{
+			cmdb->bindPipeline(ppline);
+			cmdb->drawArrays(3);
+		}
+		cmdb->endRenderPass();
+
+		timer.stop();
+		recordTime += timer.getElapsedTime();
+
+		// Submit. Don't time the wait, it's the GPU and the thread sync and not the cost of the stream
+		timer.start();
+		cmdb->flush();
+		timer.stop();
+		submitTime += timer.getElapsedTime();
+
+		CommandBufferPtr syncCmdb = gr->newInstance<CommandBuffer>(cinit);
+		syncCmdb->finish();
+
+		gr->swapBuffers();
+	}
+
+	printf("Command buffer bench (per %u draws): record %fms submit %fms\n",
+		U32(DRAW_COUNT),
+		recordTime / ITERATION_COUNT * 1000.0,
+		submitTime / ITERATION_COUNT * 1000.0);
+
+	COMMON_END()
+}
+
 } // end namespace anki
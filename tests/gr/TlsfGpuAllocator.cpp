@@ -0,0 +1,175 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/common/TlsfGpuAllocator.h>
+#include <anki/util/HighRezTimer.h>
+#include <tests/framework/Framework.h>
+#include <random>
+#include <algorithm>
+
+namespace anki
+{
+
+class TlsfTestAllocation
+{
+public:
+	TlsfGpuAllocatorHandle m_handle;
+	PtrSize m_size;
+	U32 m_alignment;
+};
+
+/// Check that the allocations don't overlap and they are aligned.
+static Bool validateAllocations(std::vector<TlsfTestAllocation> allocs, PtrSize totalSize)
+{
+	std::sort(allocs.begin(), allocs.end(), [](const TlsfTestAllocation& a, const TlsfTestAllocation& b) {
+		return a.m_handle.m_offset < b.m_handle.m_offset;
+	});
+
+	PtrSize end = 0;
+	for(const TlsfTestAllocation& a : allocs)
+	{
+		if(a.m_handle.m_offset < end || (a.m_handle.m_offset % a.m_alignment) != 0)
+		{
+			return false;
+		}
+
+		end = a.m_handle.m_offset + a.m_size;
+	}
+
+	return end <= totalSize;
+}
+
+ANKI_TEST(Gr, TlsfGpuAllocator)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	const PtrSize SIZE = 16 * 1024 * 1024;
+
+	// Simple
+	{
+		TlsfGpuAllocator talloc;
+		talloc.init(alloc, SIZE);
+
+		// The whole memory
+		TlsfGpuAllocatorHandle a;
+		ANKI_TEST_EXPECT_NO_ERR(talloc.allocate(SIZE, 4, a));
+		ANKI_TEST_EXPECT_EQ(a.m_offset, 0);
+
+		TlsfGpuAllocatorHandle b;
+		ANKI_TEST_EXPECT_ERR(talloc.allocate(4, 4, b), ErrorCode::OUT_OF_MEMORY);
+		talloc.free(a);
+		ANKI_TEST_EXPECT_EQ(Bool(a), false);
+
+		// Non power of two alignment like the vertex strides
+		ANKI_TEST_EXPECT_NO_ERR(talloc.allocate(10, 4, a));
+		ANKI_TEST_EXPECT_NO_ERR(talloc.allocate(28 * 3, 28, b));
+		ANKI_TEST_EXPECT_EQ(a.m_offset, 0);
+		ANKI_TEST_EXPECT_EQ(b.m_offset, 28);
+
+		// The padding is free memory
+		TlsfGpuAllocatorHandle c;
+		ANKI_TEST_EXPECT_NO_ERR(talloc.allocate(16, 4, c));
+		ANKI_TEST_EXPECT_EQ(c.m_offset, 12);
+
+		talloc.free(a);
+		talloc.free(c);
+		talloc.free(b);
+
+		// Everything is merged back
+		TlsfGpuAllocatorStats stats;
+		talloc.getStats(stats);
+		ANKI_TEST_EXPECT_EQ(stats.m_freeBlockCount, 1);
+		ANKI_TEST_EXPECT_EQ(stats.m_largestFreeSize, SIZE);
+	}
+
+	// Random
+	{
+		TlsfGpuAllocator talloc;
+		talloc.init(alloc, SIZE);
+
+		std::mt19937 gen(0);
+		std::uniform_int_distribution<U32> sizeDis(1, 64 * 1024);
+		const Array<U32, 4> alignments = {{4, 16, 28, 256}};
+
+		std::vector<TlsfTestAllocation> allocs;
+		for(U i = 0; i < 20; ++i)
+		{
+			// Fill up the memory
+			while(1)
+			{
+				TlsfTestAllocation a;
+				a.m_size = sizeDis(gen);
+				a.m_alignment = alignments[gen() % alignments.getSize()];
+				if(talloc.allocate(a.m_size, a.m_alignment, a.m_handle))
+				{
+					break;
+				}
+
+				allocs.push_back(a);
+			}
+
+			ANKI_TEST_EXPECT_EQ(validateAllocations(allocs, SIZE), true);
+
+			// Most of the memory is used
+			TlsfGpuAllocatorStats stats;
+			talloc.getStats(stats);
+			ANKI_TEST_EXPECT_EQ(stats.m_allocationCount, allocs.size());
+			ANKI_TEST_EXPECT_EQ(stats.m_usedSize + stats.m_freeSize, SIZE);
+			ANKI_TEST_EXPECT_GT(F32(stats.m_usedSize) / SIZE, 0.9);
+
+			// Free half of them
+			std::shuffle(allocs.begin(), allocs.end(), gen);
+			const U half = allocs.size() / 2;
+			for(U j = half; j < allocs.size(); ++j)
+			{
+				talloc.free(allocs[j].m_handle);
+			}
+
+			allocs.erase(allocs.begin() + half, allocs.end());
+		}
+
+		for(TlsfTestAllocation& a : allocs)
+		{
+			talloc.free(a.m_handle);
+		}
+
+		TlsfGpuAllocatorStats stats;
+		talloc.getStats(stats);
+		ANKI_TEST_EXPECT_EQ(stats.m_freeBlockCount, 1);
+		ANKI_TEST_EXPECT_EQ(stats.m_usedSize, 0);
+	}
+
+	// Bench it
+	{
+		TlsfGpuAllocator talloc;
+		talloc.init(alloc, 256 * 1024 * 1024);
+
+		std::mt19937 gen(0);
+		std::uniform_int_distribution<U32> sizeDis(1, 64 * 1024);
+		const U COUNT = 1024;
+		std::vector<TlsfGpuAllocatorHandle> handles(COUNT);
+
+		HighRezTimer timer;
+		timer.start();
+		for(U i = 0; i < 100; ++i)
+		{
+			for(TlsfGpuAllocatorHandle& handle : handles)
+			{
+				ANKI_TEST_EXPECT_NO_ERR(talloc.allocate(sizeDis(gen), 16, handle));
+			}
+
+			std::shuffle(handles.begin(), handles.end(), gen);
+
+			for(TlsfGpuAllocatorHandle& handle : handles)
+			{
+				talloc.free(handle);
+			}
+		}
+		timer.stop();
+
+		printf("%u allocations and frees took %fms\n", U32(COUNT * 100), timer.getElapsedTime() * 1000.0);
+	}
+}
+
+} // end namespace anki
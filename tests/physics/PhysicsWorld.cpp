@@ -0,0 +1,178 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/physics/PhysicsWorld.h>
+#include <anki/physics/PhysicsBody.h>
+#include <anki/physics/PhysicsCollisionShape.h>
+#include <anki/resource/ResourceManager.h>
+#include <anki/resource/ResourceFilesystem.h>
+#include <anki/resource/MeshLoader.h>
+#include <anki/core/Config.h>
+#include <anki/util/ThreadHive.h>
+#include <anki/util/HighRezTimer.h>
+#include <anki/util/System.h>
+
+namespace anki
+{
+
+ANKI_TEST(Physics, Queries)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	ThreadHive hive(max<U32>(getCpuCoresCount(), 4), alloc);
+
+	Config config;
+	config.set("dataPaths", "../samples");
+	config.set("physics.threadCount", 4);
+
+	PhysicsWorld* world = alloc.newInstance<PhysicsWorld>();
+	ANKI_TEST_EXPECT_NO_ERR(world->create(allocAligned, nullptr, config));
+
+	ResourceFilesystem fs(alloc);
+	ANKI_TEST_EXPECT_NO_ERR(fs.init(config, "/tmp/"));
+
+	ResourceManagerInitInfo rinit;
+	rinit.m_physics = world;
+	rinit.m_resourceFs = &fs;
+	rinit.m_config = &config;
+	rinit.m_cacheDir = "/tmp/";
+	rinit.m_allocCallback = allocAligned;
+	ResourceManager* resources = alloc.newInstance<ResourceManager>();
+	ANKI_TEST_EXPECT_NO_ERR(resources->create(rinit));
+
+	{
+		PhysicsCollisionShapeInitInfo shapeInit;
+
+		// The static collision of the sample level
+		MeshLoader loader(resources);
+		ANKI_TEST_EXPECT_NO_ERR(loader.load("assets/room.ankimesh"));
+		PhysicsCollisionShapePtr roomShape = world->newInstance<PhysicsTriangleSoup>(shapeInit,
+			loader.getPositions(),
+			sizeof(Vec3),
+			reinterpret_cast<const U16*>(loader.getIndexData()),
+			loader.getHeader().m_totalIndicesCount);
+
+		PhysicsBodyInitInfo bodyInit;
+		bodyInit.m_shape = roomShape;
+		bodyInit.m_static = true;
+		PhysicsBodyPtr room = world->newInstance<PhysicsBody>(bodyInit);
+
+		// A static box of 2x2x2 and a dynamic sphere under the level
+		bodyInit.m_shape = world->newInstance<PhysicsBox>(shapeInit, Vec3(2.0));
+		bodyInit.m_startTrf = Transform(Vec4(0.0, -50.0, 0.0, 0.0), Mat3x4::getIdentity(), 1.0);
+		PhysicsBodyPtr box = world->newInstance<PhysicsBody>(bodyInit);
+
+		bodyInit.m_shape = world->newInstance<PhysicsSphere>(shapeInit, 1.0);
+		bodyInit.m_startTrf = Transform(Vec4(10.0, -50.0, 0.0, 0.0), Mat3x4::getIdentity(), 1.0);
+		bodyInit.m_static = false;
+		bodyInit.m_mass = 1.0;
+		PhysicsBodyPtr sphere = world->newInstance<PhysicsBody>(bodyInit);
+
+		// Rays
+		{
+			Array<PhysicsRay, 4> rays;
+			rays[0].m_from = Vec4(0.0, -40.0, 0.0, 0.0);
+			rays[0].m_to = Vec4(0.0, -60.0, 0.0, 0.0);
+			rays[1] = rays[0];
+			rays[1].m_materials = PhysicsMaterialBit::DYNAMIC_GEOMETRY;
+			rays[2].m_from = Vec4(10.0, -40.0, 0.0, 0.0);
+			rays[2].m_to = Vec4(10.0, -60.0, 0.0, 0.0);
+			rays[3].m_from = Vec4(1000.0, 1000.0, 1000.0, 0.0);
+			rays[3].m_to = Vec4(1001.0, 1000.0, 1000.0, 0.0);
+
+			Array<PhysicsHit, 4> hits;
+			world->castRays(&rays[0], &hits[0], rays.getSize());
+
+			ANKI_TEST_EXPECT_EQ(hits[0].m_hit, true);
+			ANKI_TEST_EXPECT_NEAR(hits[0].m_position.y(), -49.0, 0.001);
+			ANKI_TEST_EXPECT_NEAR(hits[0].m_normal.y(), 1.0, 0.001);
+			ANKI_TEST_EXPECT_NEAR(hits[0].m_fraction, 0.45, 0.001);
+			ANKI_TEST_EXPECT_EQ(hits[0].m_object, nullptr);
+
+			ANKI_TEST_EXPECT_EQ(hits[1].m_hit, false);
+
+			ANKI_TEST_EXPECT_EQ(hits[2].m_hit, true);
+			ANKI_TEST_EXPECT_NEAR(hits[2].m_position.y(), -49.0, 0.001);
+			ANKI_TEST_EXPECT_EQ(hits[2].m_object, sphere.get());
+
+			ANKI_TEST_EXPECT_EQ(hits[3].m_hit, false);
+		}
+
+		// Sweep a sphere with radius 0.5 on the box
+		{
+			PhysicsCollisionShapePtr shape = world->newInstance<PhysicsSphere>(shapeInit, 0.5);
+
+			PhysicsSweep sweep;
+			sweep.m_shape = shape.get();
+			sweep.m_from = Transform(Vec4(0.0, -40.0, 0.0, 0.0), Mat3x4::getIdentity(), 1.0);
+			sweep.m_to = Vec4(0.0, -60.0, 0.0, 0.0);
+
+			PhysicsHit hit;
+			world->sweep(&sweep, &hit, 1);
+
+			ANKI_TEST_EXPECT_EQ(hit.m_hit, true);
+			ANKI_TEST_EXPECT_NEAR(hit.m_fraction, 8.5 / 20.0, 0.01);
+			ANKI_TEST_EXPECT_NEAR(hit.m_position.y(), -49.0, 0.01);
+		}
+
+		// Bench it. Cast rays to all directions from the inside of the level
+		{
+			const U COUNT = 10 * 1024;
+			const U FRAMES = 16;
+
+			DynamicArrayAuto<PhysicsRay> rays(alloc);
+			rays.create(COUNT);
+			srand(0);
+			for(PhysicsRay& ray : rays)
+			{
+				Vec4 dir(F32(rand()) / RAND_MAX - 0.5, F32(rand()) / RAND_MAX - 0.5, F32(rand()) / RAND_MAX - 0.5, 0.0);
+				ray.m_from = Vec4(0.0, 2.0, 0.0, 0.0);
+				ray.m_to = ray.m_from + dir.getNormalized() * 100.0;
+			}
+
+			DynamicArrayAuto<PhysicsHit> hitsA(alloc);
+			hitsA.create(COUNT);
+			DynamicArrayAuto<PhysicsHit> hitsB(alloc);
+			hitsB.create(COUNT);
+
+			HighRezTimer timer;
+			timer.start();
+			for(U i = 0; i < FRAMES; ++i)
+			{
+				world->castRays(&rays[0], &hitsA[0], COUNT);
+			}
+			timer.stop();
+			const HighRezTimer::Scalar singleTime = timer.getElapsedTime() / FRAMES;
+
+			timer.start();
+			for(U i = 0; i < FRAMES; ++i)
+			{
+				world->castRays(&rays[0], &hitsB[0], COUNT, &hive);
+			}
+			timer.stop();
+			const HighRezTimer::Scalar hiveTime = timer.getElapsedTime() / FRAMES;
+
+			// The threads give the same results
+			U hitCount = 0;
+			for(U i = 0; i < COUNT; ++i)
+			{
+				ANKI_TEST_EXPECT_EQ(hitsA[i].m_hit, hitsB[i].m_hit);
+				ANKI_TEST_EXPECT_EQ(hitsA[i].m_fraction, hitsB[i].m_fraction);
+				hitCount += hitsA[i].m_hit;
+			}
+
+			printf("Casting %u rays (%u hits): single thread %fms, threads %fms\n",
+				U32(COUNT),
+				U32(hitCount),
+				singleTime * 1000.0,
+				hiveTime * 1000.0);
+		}
+	}
+
+	alloc.deleteInstance(resources);
+	alloc.deleteInstance(world);
+}
+
+} // end namespace anki
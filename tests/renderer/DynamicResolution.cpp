@@ -0,0 +1,99 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/renderer/DynamicResolution.h>
+#include <tests/framework/Framework.h>
+
+namespace anki
+{
+
+/// A frame that has a fixed cost and a cost that is proportional to the pixels.
+static F32 simulateFrame(F32 scale, F32 fixedTime, F32 pixelTime)
+{
+	return fixedTime + pixelTime * scale * scale;
+}
+
+ANKI_TEST(Renderer, DynamicResolution)
+{
+	const F32 target = 0.016;
+
+	// Too slow. It should converge to the target and stay there
+	{
+		DynamicResolution dr;
+		dr.init(target, 0.5);
+		ANKI_TEST_EXPECT_EQ(dr.getScale(), 1.0);
+
+		F32 scale = dr.getScale();
+		U lastChangeFrame = 0;
+		for(U i = 0; i < 300; ++i)
+		{
+			const F32 newScale = dr.update(simulateFrame(scale, 0.004, 0.020));
+			if(newScale != scale)
+			{
+				lastChangeFrame = i;
+			}
+			scale = newScale;
+		}
+
+		const F32 frameTime = simulateFrame(scale, 0.004, 0.020);
+		ANKI_TEST_EXPECT_LEQ(frameTime, target * 1.06);
+		ANKI_TEST_EXPECT_GEQ(frameTime, target * 0.9);
+		ANKI_TEST_EXPECT_LEQ(lastChangeFrame, 150);
+
+		// The scale is on a step
+		const F32 steps = scale / DynamicResolution::SCALE_STEP;
+		ANKI_TEST_EXPECT_NEAR(steps, round(steps), 0.001);
+
+		// The load goes away, back to the full resolution
+		for(U i = 0; i < 300; ++i)
+		{
+			scale = dr.update(simulateFrame(scale, 0.004, 0.008));
+		}
+
+		ANKI_TEST_EXPECT_EQ(scale, 1.0);
+	}
+
+	// Way too slow. It stops at the minimum
+	{
+		DynamicResolution dr;
+		dr.init(target, 0.5);
+
+		F32 scale = dr.getScale();
+		for(U i = 0; i < 200; ++i)
+		{
+			scale = dr.update(simulateFrame(scale, 0.020, 0.020));
+			ANKI_TEST_EXPECT_GEQ(scale, 0.5);
+		}
+
+		ANKI_TEST_EXPECT_EQ(scale, 0.5);
+
+		// It doesn't wind up. It recovers as soon as the load goes away
+		U framesToRecover = 0;
+		while(scale < 1.0 && framesToRecover < 1000)
+		{
+			scale = dr.update(simulateFrame(scale, 0.004, 0.008));
+			++framesToRecover;
+		}
+
+		ANKI_TEST_EXPECT_LEQ(framesToRecover, 200);
+	}
+
+	// Noise doesn't move the scale
+	{
+		DynamicResolution dr;
+		dr.init(target, 0.5);
+
+		F32 scale = dr.getScale();
+		for(U i = 0; i < 200; ++i)
+		{
+			const F32 noise = (i & 1) ? 0.0005 : -0.0005;
+			scale = dr.update(simulateFrame(scale, 0.004, 0.010) + noise);
+		}
+
+		ANKI_TEST_EXPECT_EQ(scale, 1.0);
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,136 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/renderer/LodSelector.h>
+#include <anki/util/HighRezTimer.h>
+#include <anki/Math.h>
+#include <tests/framework/Framework.h>
+
+namespace anki
+{
+
+ANKI_TEST(Renderer, LodSelector)
+{
+	// 1080p and 60 degrees. An error of 1 unit covers about 935 pixels at a distance of 1
+	const F32 projScale = LodSelector::computeProjectionScale(toRad(60.0), 1080.0);
+	ANKI_TEST_EXPECT_NEAR(projScale, 935.3, 0.1);
+
+	const Array<F32, 3> errorArr = {{0.0, 0.01, 0.04}};
+	const WeakArray<const F32> errors(&errorArr[0], errorArr.getSize());
+
+	// Without history. LOD 1 is good enough from 9.35 units and LOD 2 from 37.4
+	{
+		LodSelector sel;
+		sel.init(1.0, 0.25);
+
+		ANKI_TEST_EXPECT_EQ(sel.selectLod(errors, 1.0, projScale), 0);
+		ANKI_TEST_EXPECT_EQ(sel.selectLod(errors, 9.0, projScale), 0);
+		ANKI_TEST_EXPECT_EQ(sel.selectLod(errors, 10.0, projScale), 1);
+		ANKI_TEST_EXPECT_EQ(sel.selectLod(errors, 37.0, projScale), 1);
+		ANKI_TEST_EXPECT_EQ(sel.selectLod(errors, 38.0, projScale), 2);
+		ANKI_TEST_EXPECT_EQ(sel.selectLod(errors, 1000.0, projScale), 2);
+
+		// A larger screen keeps the fine LOD for longer
+		const F32 projScale4k = LodSelector::computeProjectionScale(toRad(60.0), 2160.0);
+		ANKI_TEST_EXPECT_EQ(sel.selectLod(errors, 10.0, projScale4k), 0);
+	}
+
+	// Hysteresis. Moving back and forth around the boundary doesn't change the LOD
+	{
+		LodSelector sel;
+		sel.init(1.0, 0.25);
+
+		U lod = sel.selectLod(errors, 9.0, projScale);
+		ANKI_TEST_EXPECT_EQ(lod, 0);
+
+		U transitions = 0;
+		for(U i = 0; i < 100; ++i)
+		{
+			const F32 dist = (i & 1) ? 9.0 : 10.0;
+			const U newLod = sel.selectLod(errors, dist, projScale, lod);
+			transitions += (newLod != lod) ? 1 : 0;
+			lod = newLod;
+		}
+
+		ANKI_TEST_EXPECT_EQ(transitions, 0);
+		ANKI_TEST_EXPECT_EQ(lod, 0);
+
+		// It changes once it's out of the band
+		lod = sel.selectLod(errors, 12.5, projScale, lod);
+		ANKI_TEST_EXPECT_EQ(lod, 1);
+		ANKI_TEST_EXPECT_EQ(sel.selectLod(errors, 9.0, projScale, lod), 1);
+		ANKI_TEST_EXPECT_EQ(sel.selectLod(errors, 7.0, projScale, lod), 0);
+
+		// A big jump skips LODs
+		ANKI_TEST_EXPECT_EQ(sel.selectLod(errors, 1000.0, projScale, 0), 2);
+		ANKI_TEST_EXPECT_EQ(sel.selectLod(errors, 1.0, projScale, 2), 0);
+
+		// A previous LOD that doesn't exist any more
+		ANKI_TEST_EXPECT_EQ(sel.selectLod(errors, 1000.0, projScale, 5), 2);
+	}
+
+	// The budget. Over it the LODs get coarser and when the load goes away the bias goes back
+	{
+		LodSelector sel;
+		sel.init(1.0, 0.25, 1000);
+
+		sel.addTriangles(5000);
+		ANKI_TEST_EXPECT_EQ(sel.beginFrame(), 5000);
+		ANKI_TEST_EXPECT_GT(sel.getErrorBias(), 1.0);
+
+		for(U i = 0; i < 100; ++i)
+		{
+			sel.addTriangles(5000);
+			sel.beginFrame();
+		}
+
+		ANKI_TEST_EXPECT_EQ(sel.getErrorBias(), LodSelector::MAX_BIAS);
+		ANKI_TEST_EXPECT_EQ(sel.selectLod(errors, 3.0, projScale), 2);
+
+		// Inside the budget the bias stays
+		sel.addTriangles(950);
+		sel.beginFrame();
+		ANKI_TEST_EXPECT_EQ(sel.getErrorBias(), LodSelector::MAX_BIAS);
+
+		for(U i = 0; i < 100; ++i)
+		{
+			sel.addTriangles(100);
+			sel.beginFrame();
+		}
+
+		ANKI_TEST_EXPECT_EQ(sel.getErrorBias(), 1.0);
+		ANKI_TEST_EXPECT_EQ(sel.selectLod(errors, 3.0, projScale), 0);
+
+		// Without a budget there is no bias
+		LodSelector noBudget;
+		noBudget.init(1.0, 0.25);
+		noBudget.addTriangles(MAX_U32);
+		noBudget.beginFrame();
+		ANKI_TEST_EXPECT_EQ(noBudget.getErrorBias(), 1.0);
+	}
+
+	// Bench it
+	{
+		LodSelector sel;
+		sel.init(1.0, 0.25);
+
+		const U COUNT = 1000000;
+		U lod = 0;
+		U sum = 0;
+
+		HighRezTimer timer;
+		timer.start();
+		for(U i = 0; i < COUNT; ++i)
+		{
+			lod = sel.selectLod(errors, F32(i % 100), projScale, lod);
+			sum += lod;
+		}
+		timer.stop();
+
+		printf("%u LOD selections (%u) took %fms\n", U32(COUNT), U32(sum), timer.getElapsedTime() * 1000.0);
+	}
+}
+
+} // end namespace anki
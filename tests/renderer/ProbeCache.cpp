@@ -0,0 +1,100 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/renderer/ProbeCache.h>
+#include <tests/framework/Framework.h>
+
+namespace anki
+{
+
+ANKI_TEST(Renderer, ProbeCache)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	ProbeCache cache;
+	cache.init(alloc, 4);
+
+	Array<U32, 4> entries;
+	Array<Bool8, 4> newEntries;
+
+	auto assign = [&](const Array<U64, 4>& ids, U count) {
+		cache.assign(WeakArray<const U64>(&ids[0], count),
+			WeakArray<U32>(&entries[0], count),
+			WeakArray<Bool8>(&newEntries[0], count));
+	};
+
+	// All the probes are new and take the empty entries
+	{
+		const Array<U64, 4> ids = {{0, 1, 2, 3}};
+		assign(ids, 4);
+
+		for(U i = 0; i < 4; ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(newEntries[i], true);
+			for(U j = 0; j < i; ++j)
+			{
+				ANKI_TEST_EXPECT_NEQ(entries[i], entries[j]);
+			}
+		}
+	}
+
+	const Array<U32, 4> prevEntries = entries;
+
+	// The same probes keep their entries
+	{
+		const Array<U64, 4> ids = {{3, 2, 1, 0}};
+		assign(ids, 4);
+
+		for(U i = 0; i < 4; ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(newEntries[i], false);
+			ANKI_TEST_EXPECT_EQ(entries[i], prevEntries[3 - i]);
+		}
+	}
+
+	// A new probe comes first and there are no empty entries. It takes the entry of the probe that is not visible and
+	// not the entry of a visible probe that comes after it
+	{
+		const Array<U64, 4> ids = {{10, 0, 1, 2}};
+		assign(ids, 4);
+
+		ANKI_TEST_EXPECT_EQ(newEntries[0], true);
+		ANKI_TEST_EXPECT_EQ(entries[0], prevEntries[3]);
+
+		for(U i = 1; i < 4; ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(newEntries[i], false);
+			ANKI_TEST_EXPECT_EQ(entries[i], prevEntries[i - 1]);
+		}
+	}
+
+	// Two new probes take the least recently used entries. Probe 10 was used in the last frame so it stays
+	{
+		const Array<U64, 4> ids = {{11, 12, 10, 0}};
+		assign(ids, 4);
+
+		ANKI_TEST_EXPECT_EQ(newEntries[2], false);
+		ANKI_TEST_EXPECT_EQ(entries[2], prevEntries[3]);
+		ANKI_TEST_EXPECT_EQ(newEntries[3], false);
+		ANKI_TEST_EXPECT_EQ(entries[3], prevEntries[0]);
+
+		ANKI_TEST_EXPECT_EQ(newEntries[0], true);
+		ANKI_TEST_EXPECT_EQ(newEntries[1], true);
+		ANKI_TEST_EXPECT_EQ(entries[0] == prevEntries[1] || entries[0] == prevEntries[2], true);
+		ANKI_TEST_EXPECT_EQ(entries[1] == prevEntries[1] || entries[1] == prevEntries[2], true);
+		ANKI_TEST_EXPECT_NEQ(entries[0], entries[1]);
+	}
+
+	// A frame with less probes than entries. The older probes are still there
+	{
+		const Array<U64, 4> ids = {{0, 0, 0, 0}};
+		assign(ids, 1);
+
+		ANKI_TEST_EXPECT_EQ(newEntries[0], false);
+		ANKI_TEST_EXPECT_EQ(entries[0], prevEntries[0]);
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,270 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/renderer/RenderGraph.h>
+#include <anki/gr/common/Misc.h>
+#include <tests/framework/Framework.h>
+
+namespace anki
+{
+
+/// Doesn't touch the GPU. It counts.
+class RenderGraphMockInterface : public RenderGraphInterface
+{
+public:
+	U32 m_textureCount = 0;
+	U32 m_barrierCount = 0;
+
+	TexturePtr newTexture(const TextureInitInfo& init) override
+	{
+		++m_textureCount;
+		return TexturePtr();
+	}
+
+	void setTextureBarrier(CommandBufferPtr& cmdb,
+		TexturePtr tex,
+		const TextureInitInfo& init,
+		TextureUsageBit before,
+		TextureUsageBit after) override
+	{
+		++m_barrierCount;
+	}
+};
+
+class RenderGraphTestPass
+{
+public:
+	U32 m_id;
+	U32* m_order;
+	U32* m_count;
+};
+
+static Error runTestPass(RenderGraphRunContext& ctx)
+{
+	RenderGraphTestPass& pass = *static_cast<RenderGraphTestPass*>(ctx.m_userData);
+	pass.m_order[(*pass.m_count)++] = pass.m_id;
+	return ErrorCode::NONE;
+}
+
+ANKI_TEST(Renderer, RenderGraph)
+{
+	const TextureUsageBit WRITE = TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE;
+	const TextureUsageBit READ = TextureUsageBit::SAMPLED_FRAGMENT;
+
+	TextureInitInfo fullInit;
+	fullInit.m_width = 1920;
+	fullInit.m_height = 1080;
+	fullInit.m_format = PixelFormat(ComponentFormat::R8G8B8A8, TransformFormat::UNORM);
+
+	TextureInitInfo halfInit = fullInit;
+	halfInit.m_width /= 2;
+	halfInit.m_height /= 2;
+
+	TextureInitInfo hdrInit = fullInit;
+	hdrInit.m_format = PixelFormat(ComponentFormat::R16G16B16A16, TransformFormat::FLOAT);
+
+	RenderGraphMockInterface iface;
+	RenderGraph graph;
+	graph.init(&iface, 5);
+
+	Array<U32, 8> order;
+	U32 count = 0;
+	Array<RenderGraphTestPass, 6> passes;
+	for(U i = 0; i < passes.getSize(); ++i)
+	{
+		passes[i].m_id = i;
+		passes[i].m_order = &order[0];
+		passes[i].m_count = &count;
+	}
+
+	RenderGraphHandle gbuffer, ssao, light, debug, bloom, final;
+	auto build = [&]() {
+		gbuffer = graph.newTexture(fullInit, "GBuffer");
+		ssao = graph.newTexture(halfInit, "Ssao");
+		light = graph.newTexture(hdrInit, "Light");
+		debug = graph.newTexture(fullInit, "Debug");
+		bloom = graph.newTexture(fullInit, "Bloom");
+		final = graph.importTexture(TexturePtr(), fullInit, READ, "Final");
+
+		U p = graph.newPass("GBuffer", runTestPass, &passes[0]);
+		graph.newWrite(p, gbuffer, WRITE);
+
+		p = graph.newPass("Ssao", runTestPass, &passes[1]);
+		graph.newRead(p, gbuffer, READ);
+		graph.newWrite(p, ssao, WRITE);
+
+		p = graph.newPass("Light", runTestPass, &passes[2]);
+		graph.newRead(p, gbuffer, READ);
+		graph.newRead(p, ssao, READ);
+		graph.newWrite(p, light, WRITE);
+
+		// Nobody reads it
+		p = graph.newPass("Debug", runTestPass, &passes[3]);
+		graph.newRead(p, gbuffer, READ);
+		graph.newWrite(p, debug, WRITE);
+
+		p = graph.newPass("Bloom", runTestPass, &passes[4]);
+		graph.newRead(p, light, READ);
+		graph.newWrite(p, bloom, WRITE);
+
+		p = graph.newPass("Final", runTestPass, &passes[5]);
+		graph.newRead(p, light, READ);
+		graph.newRead(p, bloom, READ);
+		graph.newWrite(p, final, WRITE);
+	};
+
+	// Culling, aliasing and barriers
+	{
+		build();
+		graph.compile();
+
+		ANKI_TEST_EXPECT_EQ(graph.isPassCulled(3), true);
+		for(U p = 0; p < 6; ++p)
+		{
+			ANKI_TEST_EXPECT_EQ(graph.isPassCulled(p), p == 3);
+		}
+
+		// The debug pass is gone so the bloom can take the place of the gbuffer
+		ANKI_TEST_EXPECT_EQ(graph.getPhysicalTextureIndex(bloom), graph.getPhysicalTextureIndex(gbuffer));
+		ANKI_TEST_EXPECT_NEQ(graph.getPhysicalTextureIndex(light), graph.getPhysicalTextureIndex(gbuffer));
+		ANKI_TEST_EXPECT_NEQ(graph.getPhysicalTextureIndex(ssao), graph.getPhysicalTextureIndex(gbuffer));
+
+		RenderGraphStats stats;
+		graph.getStats(stats);
+		ANKI_TEST_EXPECT_EQ(stats.m_passCount, 6);
+		ANKI_TEST_EXPECT_EQ(stats.m_culledPassCount, 1);
+		ANKI_TEST_EXPECT_EQ(stats.m_transientTextureCount, 4);
+		ANKI_TEST_EXPECT_EQ(stats.m_physicalTextureCount, 3);
+		ANKI_TEST_EXPECT_EQ(stats.getSavedMemory(), computeSurfaceSize(1920, 1080, fullInit.m_format));
+		ANKI_TEST_EXPECT_EQ(iface.m_textureCount, 3);
+
+		// The bloom starts from where the gbuffer was left
+		ANKI_TEST_EXPECT_EQ(graph.getBarrierCount(4), 2);
+		const RenderGraphBarrier& barrier = graph.getBarrier(4, 0);
+		ANKI_TEST_EXPECT_EQ(barrier.m_texture, light);
+		const RenderGraphBarrier& barrier2 = graph.getBarrier(4, 1);
+		ANKI_TEST_EXPECT_EQ(barrier2.m_texture, bloom);
+		ANKI_TEST_EXPECT_EQ(barrier2.m_before, READ);
+		ANKI_TEST_EXPECT_EQ(barrier2.m_after, WRITE);
+
+		// The light is already readable
+		ANKI_TEST_EXPECT_EQ(graph.getBarrierCount(5), 2);
+		ANKI_TEST_EXPECT_EQ(graph.getBarrier(5, 0).m_texture, bloom);
+		ANKI_TEST_EXPECT_EQ(graph.getBarrier(5, 1).m_texture, final);
+		ANKI_TEST_EXPECT_EQ(graph.getBarrier(5, 1).m_before, READ);
+
+		ANKI_TEST_EXPECT_NO_ERR(graph.run(CommandBufferPtr()));
+		ANKI_TEST_EXPECT_EQ(count, 5);
+		ANKI_TEST_EXPECT_EQ(order[3], 4);
+		ANKI_TEST_EXPECT_EQ(iface.m_barrierCount, stats.m_barrierCount);
+
+		graph.reset();
+	}
+
+	// The next frames reuse the textures
+	{
+		build();
+		graph.compile();
+		ANKI_TEST_EXPECT_EQ(iface.m_textureCount, 3);
+
+		// The gbuffer was left readable by the final pass of the previous frame
+		ANKI_TEST_EXPECT_EQ(graph.getBarrierCount(0), 1);
+		ANKI_TEST_EXPECT_EQ(graph.getBarrier(0, 0).m_before, READ);
+		graph.reset();
+	}
+
+	// Unused textures are released
+	{
+		for(U i = 0; i < 6; ++i)
+		{
+			graph.compile();
+			graph.reset();
+		}
+
+		build();
+		graph.compile();
+		ANKI_TEST_EXPECT_EQ(iface.m_textureCount, 6);
+		ANKI_TEST_EXPECT_EQ(graph.getBarrier(0, 0).m_before, TextureUsageBit::NONE);
+		graph.reset();
+	}
+}
+
+ANKI_TEST(Renderer, RenderGraphBarriers)
+{
+	const TextureUsageBit RW = TextureUsageBit::IMAGE_COMPUTE_READ_WRITE;
+	const TextureUsageBit WRITE = TextureUsageBit::IMAGE_COMPUTE_WRITE;
+	const TextureUsageBit READ = TextureUsageBit::SAMPLED_COMPUTE;
+
+	TextureInitInfo init;
+	init.m_width = 256;
+	init.m_height = 256;
+	init.m_format = PixelFormat(ComponentFormat::R8G8B8A8, TransformFormat::UNORM);
+
+	RenderGraphMockInterface iface;
+	RenderGraph graph;
+	graph.init(&iface);
+
+	const RenderGraphHandle a = graph.newTexture(init, "A");
+	const RenderGraphHandle b = graph.newTexture(init, "B");
+	const RenderGraphHandle c = graph.newTexture(init, "C");
+	const RenderGraphHandle out = graph.importTexture(TexturePtr(), init, READ, "Out");
+
+	U p = graph.newPass("A", nullptr, nullptr);
+	graph.newWrite(p, a, RW);
+
+	p = graph.newPass("B", nullptr, nullptr);
+	graph.newRead(p, a, RW);
+	graph.newWrite(p, b, WRITE);
+
+	p = graph.newPass("C", nullptr, nullptr);
+	graph.newRead(p, b, READ);
+	graph.newWrite(p, c, RW);
+
+	p = graph.newPass("C again", nullptr, nullptr);
+	graph.newWrite(p, c, RW);
+
+	p = graph.newPass("Out", nullptr, nullptr);
+	graph.newRead(p, c, RW);
+	graph.newWrite(p, out, WRITE);
+
+	graph.compile();
+
+	// C takes the memory of A
+	ANKI_TEST_EXPECT_EQ(graph.getPhysicalTextureIndex(c), graph.getPhysicalTextureIndex(a));
+
+	// Write to read with the same usage
+	ANKI_TEST_EXPECT_EQ(graph.getBarrierCount(1), 2);
+	ANKI_TEST_EXPECT_EQ(graph.getBarrier(1, 0).m_texture, a);
+	ANKI_TEST_EXPECT_EQ(graph.getBarrier(1, 0).m_before, RW);
+	ANKI_TEST_EXPECT_EQ(graph.getBarrier(1, 0).m_after, RW);
+
+	// A was only read last but C reuses its memory
+	ANKI_TEST_EXPECT_EQ(graph.getBarrierCount(2), 2);
+	ANKI_TEST_EXPECT_EQ(graph.getBarrier(2, 1).m_texture, c);
+	ANKI_TEST_EXPECT_EQ(graph.getBarrier(2, 1).m_before, RW);
+	ANKI_TEST_EXPECT_EQ(graph.getBarrier(2, 1).m_after, RW);
+
+	// Write to write with the same usage
+	ANKI_TEST_EXPECT_EQ(graph.getBarrierCount(3), 1);
+	ANKI_TEST_EXPECT_EQ(graph.getBarrier(3, 0).m_texture, c);
+	ANKI_TEST_EXPECT_EQ(graph.getBarrier(3, 0).m_before, RW);
+	ANKI_TEST_EXPECT_EQ(graph.getBarrier(3, 0).m_after, RW);
+
+	ANKI_TEST_EXPECT_EQ(graph.getBarrierCount(4), 2);
+
+	ANKI_TEST_EXPECT_NO_ERR(graph.run(CommandBufferPtr()));
+	ANKI_TEST_EXPECT_EQ(iface.m_barrierCount, 8);
+	graph.reset();
+
+	// The previous frame used the memory with the same usage
+	p = graph.newPass("C", nullptr, nullptr);
+	graph.newWrite(p, graph.newTexture(init, "C"), RW);
+	graph.setSideEffect(p);
+	graph.compile();
+	ANKI_TEST_EXPECT_EQ(graph.getBarrierCount(0), 1);
+	graph.reset();
+}
+
+} // end namespace anki
@@ -0,0 +1,184 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/renderer/ShadowAtlas.h>
+#include <tests/framework/Framework.h>
+
+namespace anki
+{
+
+static Bool regionsOverlap(const ShadowAtlasRegion& a, const ShadowAtlasRegion& b)
+{
+	return a.m_page == b.m_page && a.m_x < b.m_x + b.m_size && b.m_x < a.m_x + a.m_size && a.m_y < b.m_y + b.m_size
+		&& b.m_y < a.m_y + a.m_size;
+}
+
+ANKI_TEST(Renderer, ShadowAtlas)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	// Sizes
+	{
+		ShadowAtlas atlas;
+		atlas.init(alloc, 1024, 1, 64, 512, 1024 * 1024);
+
+		Array<ShadowAtlasRequest, 3> reqs;
+		reqs[0].m_id = 10;
+		reqs[0].m_importance = 0.5;
+		reqs[0].m_desiredSize = 300.0;
+		reqs[1].m_id = 20;
+		reqs[1].m_importance = 0.9;
+		reqs[1].m_desiredSize = 4000.0;
+		reqs[2].m_id = 30;
+		reqs[2].m_importance = 0.1;
+		reqs[2].m_desiredSize = 2.0;
+
+		Array<ShadowAtlasRegion, 3> regions;
+		atlas.allocate(WeakArray<ShadowAtlasRequest>(&reqs[0], 3), WeakArray<ShadowAtlasRegion>(&regions[0], 3));
+
+		ANKI_TEST_EXPECT_EQ(regions[0].m_size, 512);
+		ANKI_TEST_EXPECT_EQ(regions[1].m_size, 512);
+		ANKI_TEST_EXPECT_EQ(regions[2].m_size, 64);
+		ANKI_TEST_EXPECT_EQ(regions[0].m_reused, false);
+
+		for(U i = 0; i < 3; ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(regions[i].isValid(), true);
+			ANKI_TEST_EXPECT_LEQ(regions[i].m_x + regions[i].m_size, 1024);
+			ANKI_TEST_EXPECT_LEQ(regions[i].m_y + regions[i].m_size, 1024);
+
+			for(U j = i + 1; j < 3; ++j)
+			{
+				ANKI_TEST_EXPECT_EQ(regionsOverlap(regions[i], regions[j]), false);
+			}
+		}
+
+		// Same requests, same regions
+		Array<ShadowAtlasRegion, 3> regions2;
+		atlas.allocate(WeakArray<ShadowAtlasRequest>(&reqs[0], 3), WeakArray<ShadowAtlasRegion>(&regions2[0], 3));
+		for(U i = 0; i < 3; ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(regions2[i].m_reused, true);
+			ANKI_TEST_EXPECT_EQ(regions2[i].m_x, regions[i].m_x);
+			ANKI_TEST_EXPECT_EQ(regions2[i].m_y, regions[i].m_y);
+		}
+
+		// Small changes don't resize
+		reqs[0].m_desiredSize = 270.0;
+		atlas.allocate(WeakArray<ShadowAtlasRequest>(&reqs[0], 3), WeakArray<ShadowAtlasRegion>(&regions2[0], 3));
+		ANKI_TEST_EXPECT_EQ(regions2[0].m_size, 512);
+		ANKI_TEST_EXPECT_EQ(regions2[0].m_reused, true);
+
+		// Big changes do
+		reqs[0].m_desiredSize = 200.0;
+		atlas.allocate(WeakArray<ShadowAtlasRequest>(&reqs[0], 3), WeakArray<ShadowAtlasRegion>(&regions2[0], 3));
+		ANKI_TEST_EXPECT_EQ(regions2[0].m_size, 256);
+		ANKI_TEST_EXPECT_EQ(regions2[0].m_reused, false);
+		ANKI_TEST_EXPECT_EQ(regions2[1].m_reused, true);
+
+		ShadowAtlasStats stats;
+		atlas.getStats(stats);
+		ANKI_TEST_EXPECT_EQ(stats.m_allocations, 3);
+		ANKI_TEST_EXPECT_EQ(stats.m_allocatedTexels, 512 * 512 + 256 * 256 + 64 * 64);
+	}
+
+	// Budget
+	{
+		ShadowAtlas atlas;
+		atlas.init(alloc, 2048, 2, 64, 1024, 1024 * 1024);
+
+		Array<ShadowAtlasRequest, 8> reqs;
+		for(U i = 0; i < reqs.getSize(); ++i)
+		{
+			reqs[i].m_id = i + 1;
+			reqs[i].m_importance = F32(i);
+			reqs[i].m_desiredSize = 1024.0;
+		}
+
+		Array<ShadowAtlasRegion, 8> regions;
+		atlas.allocate(WeakArray<ShadowAtlasRequest>(&reqs[0], 8), WeakArray<ShadowAtlasRegion>(&regions[0], 8));
+
+		// The least important lights are shrunk first
+		U64 texels = 0;
+		for(U i = 0; i < 8; ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(regions[i].isValid(), true);
+			texels += U64(regions[i].m_size) * regions[i].m_size;
+			ANKI_TEST_EXPECT_LEQ(regions[i].m_size, regions[7].m_size);
+		}
+		ANKI_TEST_EXPECT_LEQ(texels, 1024 * 1024);
+		ANKI_TEST_EXPECT_EQ(regions[7].m_size, 512);
+		ANKI_TEST_EXPECT_EQ(regions[0].m_size, 256);
+
+		// A tiny budget drops the least important lights
+		ShadowAtlas atlas2;
+		atlas2.init(alloc, 2048, 1, 64, 1024, 3 * 64 * 64);
+		atlas2.allocate(WeakArray<ShadowAtlasRequest>(&reqs[0], 8), WeakArray<ShadowAtlasRegion>(&regions[0], 8));
+		for(U i = 0; i < 8; ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(regions[i].isValid(), i >= 5);
+		}
+	}
+
+	// Eviction
+	{
+		ShadowAtlas atlas;
+		atlas.init(alloc, 1024, 1, 256, 512, 4 * 1024 * 1024, 10);
+
+		// Fill the page
+		Array<ShadowAtlasRequest, 4> reqs;
+		for(U i = 0; i < reqs.getSize(); ++i)
+		{
+			reqs[i].m_id = i + 1;
+			reqs[i].m_importance = 1.0;
+			reqs[i].m_desiredSize = 512.0;
+		}
+
+		Array<ShadowAtlasRegion, 4> regions;
+		atlas.allocate(WeakArray<ShadowAtlasRequest>(&reqs[0], 4), WeakArray<ShadowAtlasRegion>(&regions[0], 4));
+
+		ShadowAtlasStats stats;
+		atlas.getStats(stats);
+		ANKI_TEST_EXPECT_EQ(stats.m_allocations, 4);
+
+		// Lights 1 and 2 are not visible any more. Two new lights take their space
+		reqs[0].m_id = 100;
+		reqs[1].m_id = 200;
+		atlas.allocate(WeakArray<ShadowAtlasRequest>(&reqs[0], 4), WeakArray<ShadowAtlasRegion>(&regions[0], 4));
+		atlas.getStats(stats);
+		ANKI_TEST_EXPECT_EQ(stats.m_evictions, 2);
+		ANKI_TEST_EXPECT_EQ(stats.m_reused, 2);
+		ANKI_TEST_EXPECT_EQ(stats.m_failures, 0);
+		ANKI_TEST_EXPECT_EQ(regions[0].m_size, 512);
+		ANKI_TEST_EXPECT_EQ(regions[1].m_size, 512);
+
+		// A fifth light doesn't fit since the others are visible
+		Array<ShadowAtlasRequest, 5> reqs5;
+		for(U i = 0; i < 4; ++i)
+		{
+			reqs5[i] = reqs[i];
+		}
+		reqs5[4].m_id = 500;
+		reqs5[4].m_importance = 0.5;
+		reqs5[4].m_desiredSize = 512.0;
+
+		Array<ShadowAtlasRegion, 5> regions5;
+		atlas.allocate(WeakArray<ShadowAtlasRequest>(&reqs5[0], 5), WeakArray<ShadowAtlasRegion>(&regions5[0], 5));
+		ANKI_TEST_EXPECT_EQ(regions5[4].isValid(), false);
+		atlas.getStats(stats);
+		ANKI_TEST_EXPECT_EQ(stats.m_failures, 1);
+
+		// Old regions are freed
+		for(U i = 0; i < 11; ++i)
+		{
+			atlas.allocate(WeakArray<ShadowAtlasRequest>(), WeakArray<ShadowAtlasRegion>());
+		}
+		atlas.getStats(stats);
+		ANKI_TEST_EXPECT_EQ(stats.m_allocations, 0);
+		ANKI_TEST_EXPECT_EQ(stats.m_allocatedTexels, 0);
+	}
+}
+
+} // end namespace anki
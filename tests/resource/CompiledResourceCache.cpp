@@ -0,0 +1,309 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include "tests/framework/Framework.h"
+#include "anki/resource/CompiledResourceCache.h"
+#include "anki/resource/MaterialLoader.h"
+#include "anki/resource/ResourceManager.h"
+#include "anki/resource/Animation.h"
+#include "anki/core/Config.h"
+#include "anki/misc/Xml.h"
+#include "anki/util/File.h"
+#include "anki/util/Filesystem.h"
+#include "anki/util/HighRezTimer.h"
+
+namespace anki
+{
+
+static const CString CACHE_DIR = "./compiled_resource_cache";
+
+static void recreateCacheDirectory()
+{
+	if(directoryExists(CACHE_DIR))
+	{
+		ANKI_TEST_EXPECT_NO_ERR(removeDirectory(CACHE_DIR));
+	}
+	ANKI_TEST_EXPECT_NO_ERR(createDirectory(CACHE_DIR));
+}
+
+/// Flip the last byte of every cache file.
+static Error breakCacheFile(const CString& fname, void* userData, Bool isDir)
+{
+	if(isDir)
+	{
+		return ErrorCode::NONE;
+	}
+
+	HeapAllocator<U8>& alloc = *static_cast<HeapAllocator<U8>*>(userData);
+	StringAuto path(alloc);
+	path.sprintf("%s/%s", &CACHE_DIR[0], &fname[0]);
+
+	DynamicArrayAuto<U8> data(alloc);
+	{
+		File file;
+		ANKI_CHECK(file.open(path.toCString(), FileOpenFlag::READ | FileOpenFlag::BINARY));
+		data.create(file.getSize());
+		ANKI_CHECK(file.read(&data[0], data.getSize()));
+	}
+
+	data[data.getSize() - 1] ^= 0xFF;
+
+	File file;
+	ANKI_CHECK(file.open(path.toCString(), FileOpenFlag::WRITE | FileOpenFlag::BINARY));
+	ANKI_CHECK(file.write(&data[0], data.getSize()));
+
+	return ErrorCode::NONE;
+}
+
+ANKI_TEST(Resource, CompiledResourceCache)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	// Write and read back
+	{
+		BinaryWriter out(alloc);
+		out.write<U32>(123);
+		out.writeString(CString("hello"));
+		out.writeString(CString());
+
+		DynamicArrayAuto<F32> floats(alloc);
+		floats.create(1000, 2.0f);
+		out.writeArray(floats);
+		out.write(Vec3(1.0f, 2.0f, 3.0f));
+
+		BinaryReader in(out.getData(), out.getSize());
+
+		U32 u;
+		ANKI_TEST_EXPECT_NO_ERR(in.read(u));
+		ANKI_TEST_EXPECT_EQ(u, 123);
+
+		CString str;
+		ANKI_TEST_EXPECT_NO_ERR(in.readString(str));
+		ANKI_TEST_EXPECT_EQ(str, "hello");
+		ANKI_TEST_EXPECT_NO_ERR(in.readString(str));
+		ANKI_TEST_EXPECT_EQ(str.isEmpty(), true);
+
+		DynamicArrayAuto<F32> floats2(alloc);
+		ANKI_TEST_EXPECT_NO_ERR(in.readArray(alloc, floats2));
+		ANKI_TEST_EXPECT_EQ(floats2.getSize(), 1000);
+		ANKI_TEST_EXPECT_EQ(floats2[999], 2.0f);
+
+		Vec3 v;
+		ANKI_TEST_EXPECT_NO_ERR(in.read(v));
+		ANKI_TEST_EXPECT_EQ(v, Vec3(1.0f, 2.0f, 3.0f));
+		ANKI_TEST_EXPECT_EQ(in.isEnd(), true);
+
+		// Reading past the end fails
+		ANKI_TEST_EXPECT_ERR(in.read(u), ErrorCode::USER_DATA);
+	}
+
+	// Store and find
+	{
+		recreateCacheDirectory();
+
+		CompiledResourceCache cache;
+		cache.init(alloc, CACHE_DIR, true);
+
+		const Array<U8, 4> data = {{1, 2, 3, 4}};
+		DynamicArrayAuto<U8> compiled(alloc);
+		Bool found;
+
+		ANKI_TEST_EXPECT_NO_ERR(cache.find("a.ankimtl", 1, 0xABC, compiled, found));
+		ANKI_TEST_EXPECT_EQ(found, false);
+
+		ANKI_TEST_EXPECT_NO_ERR(cache.store("a.ankimtl", 1, 0xABC, &data[0], data.getSize()));
+
+		ANKI_TEST_EXPECT_NO_ERR(cache.find("a.ankimtl", 1, 0xABC, compiled, found));
+		ANKI_TEST_EXPECT_EQ(found, true);
+		ANKI_TEST_EXPECT_EQ(compiled.getSize(), 4);
+		ANKI_TEST_EXPECT_EQ(compiled[3], 4);
+
+		// Another version, another source or another file are not found
+		DynamicArrayAuto<U8> compiled2(alloc);
+		ANKI_TEST_EXPECT_NO_ERR(cache.find("a.ankimtl", 2, 0xABC, compiled2, found));
+		ANKI_TEST_EXPECT_EQ(found, false);
+		ANKI_TEST_EXPECT_NO_ERR(cache.find("a.ankimtl", 1, 0xABD, compiled2, found));
+		ANKI_TEST_EXPECT_EQ(found, false);
+		ANKI_TEST_EXPECT_NO_ERR(cache.find("b.ankimtl", 1, 0xABC, compiled2, found));
+		ANKI_TEST_EXPECT_EQ(found, false);
+
+		// A broken file is not found
+		ANKI_TEST_EXPECT_NO_ERR(walkDirectoryTree(CACHE_DIR, &alloc, breakCacheFile));
+		ANKI_TEST_EXPECT_NO_ERR(cache.find("a.ankimtl", 1, 0xABC, compiled2, found));
+		ANKI_TEST_EXPECT_EQ(found, false);
+
+		CompiledResourceCacheStats stats;
+		cache.getStats(stats);
+		ANKI_TEST_EXPECT_EQ(stats.m_hits, 1);
+		ANKI_TEST_EXPECT_EQ(stats.m_misses, 5);
+		ANKI_TEST_EXPECT_EQ(stats.m_stores, 1);
+	}
+
+	// Disabled
+	{
+		CompiledResourceCache cache;
+		cache.init(alloc, CACHE_DIR, false);
+
+		const Array<U8, 4> data = {{1, 2, 3, 4}};
+		ANKI_TEST_EXPECT_NO_ERR(cache.store("c.ankimtl", 1, 0xABC, &data[0], data.getSize()));
+
+		DynamicArrayAuto<U8> compiled(alloc);
+		Bool found;
+		ANKI_TEST_EXPECT_NO_ERR(cache.find("c.ankimtl", 1, 0xABC, compiled, found));
+		ANKI_TEST_EXPECT_EQ(found, false);
+	}
+}
+
+/// Write an animation with many channels and keys.
+static void writeBenchAnimation(CString filename)
+{
+	File file;
+	ANKI_TEST_EXPECT_NO_ERR(file.open(filename, FileOpenFlag::WRITE));
+	ANKI_TEST_EXPECT_NO_ERR(
+		file.writeText("%s\n<animation><repeat>1</repeat><channels>\n", &XmlDocument::XML_HEADER[0]));
+
+	for(U c = 0; c < 64; ++c)
+	{
+		ANKI_TEST_EXPECT_NO_ERR(file.writeText("<channel><name>bone%u</name>\n", c));
+
+		ANKI_TEST_EXPECT_NO_ERR(file.writeText("<positionKeys>\n"));
+		for(U k = 0; k < 60; ++k)
+		{
+			ANKI_TEST_EXPECT_NO_ERR(file.writeText(
+				"<key><time>%f</time><value>%f 0.5 %f</value></key>\n", F32(k) / 30.0f, F32(k), F32(c)));
+		}
+		ANKI_TEST_EXPECT_NO_ERR(file.writeText("</positionKeys>\n<rotationKeys>\n"));
+		for(U k = 0; k < 60; ++k)
+		{
+			ANKI_TEST_EXPECT_NO_ERR(file.writeText(
+				"<key><time>%f</time><value>0.0 %f 0.0 %f</value></key>\n", F32(k) / 30.0f, sin(F32(k)), cos(F32(k))));
+		}
+		ANKI_TEST_EXPECT_NO_ERR(file.writeText("</rotationKeys>\n</channel>\n"));
+	}
+
+	ANKI_TEST_EXPECT_NO_ERR(file.writeText("</channels></animation>\n"));
+}
+
+ANKI_TEST(Resource, CompiledResourceCacheBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	HighRezTimer timer;
+	const U ITERATIONS = 200;
+
+	// Bench the material of the sample scene. It's parsed without the rest of the resource manager
+	{
+		StringAuto txt(alloc);
+		File file;
+		ANKI_TEST_EXPECT_NO_ERR(file.open("../samples/assets/room-material.ankimtl", FileOpenFlag::READ));
+		ANKI_TEST_EXPECT_NO_ERR(file.readAllText(txt));
+
+		// Compile it once
+		BinaryWriter out(alloc);
+		{
+			XmlDocument doc;
+			ANKI_TEST_EXPECT_NO_ERR(doc.parse(txt.toCString(), alloc));
+			MaterialLoader loader(alloc);
+			ANKI_TEST_EXPECT_NO_ERR(loader.parseXmlDocument(doc));
+			loader.serialize(out);
+		}
+
+		timer.start();
+		for(U i = 0; i < ITERATIONS; ++i)
+		{
+			XmlDocument doc;
+			ANKI_TEST_EXPECT_NO_ERR(doc.parse(txt.toCString(), alloc));
+			MaterialLoader loader(alloc);
+			ANKI_TEST_EXPECT_NO_ERR(loader.parseXmlDocument(doc));
+		}
+		timer.stop();
+		const HighRezTimer::Scalar xmlTime = timer.getElapsedTime();
+
+		timer.start();
+		for(U i = 0; i < ITERATIONS; ++i)
+		{
+			BinaryReader in(out.getData(), out.getSize());
+			MaterialLoader loader(alloc);
+			ANKI_TEST_EXPECT_NO_ERR(loader.deserialize(in));
+		}
+		timer.stop();
+		const HighRezTimer::Scalar binTime = timer.getElapsedTime();
+
+		printf("Material load bench: XML %f binary %f | %f%%\n", xmlTime, binTime, xmlTime / binTime * 100.0);
+
+		// Both produce the same shaders
+		XmlDocument doc;
+		ANKI_TEST_EXPECT_NO_ERR(doc.parse(txt.toCString(), alloc));
+		MaterialLoader xmlLoader(alloc);
+		ANKI_TEST_EXPECT_NO_ERR(xmlLoader.parseXmlDocument(doc));
+
+		BinaryReader in(out.getData(), out.getSize());
+		MaterialLoader binLoader(alloc);
+		ANKI_TEST_EXPECT_NO_ERR(binLoader.deserialize(in));
+		ANKI_TEST_EXPECT_EQ(in.isEnd(), true);
+
+		RenderingKey key(Pass::SM, 0, false, 4);
+		xmlLoader.mutate(key);
+		binLoader.mutate(key);
+		ANKI_TEST_EXPECT_EQ(
+			xmlLoader.getShaderSource(ShaderType::VERTEX), binLoader.getShaderSource(ShaderType::VERTEX));
+		ANKI_TEST_EXPECT_EQ(
+			xmlLoader.getShaderSource(ShaderType::FRAGMENT), binLoader.getShaderSource(ShaderType::FRAGMENT));
+		ANKI_TEST_EXPECT_EQ(xmlLoader.getUniformBlockSize(), binLoader.getUniformBlockSize());
+	}
+
+	// Bench a big animation loaded by the resource manager with and without the cache
+	{
+		recreateCacheDirectory();
+		writeBenchAnimation("./compiled_resource_cache_bench.ankianim");
+
+		Array<HighRezTimer::Scalar, 2> times;
+		Array<F32, 2> durations;
+		for(U enabled = 0; enabled < 2; ++enabled)
+		{
+			Config config;
+			config.set("dataPaths", ".");
+			config.set("compiledResourceCache", enabled);
+
+			ResourceFilesystem fs(alloc);
+			ANKI_TEST_EXPECT_NO_ERR(fs.init(config, CACHE_DIR));
+
+			ResourceManagerInitInfo rinit;
+			rinit.m_resourceFs = &fs;
+			rinit.m_config = &config;
+			rinit.m_cacheDir = CACHE_DIR;
+			rinit.m_allocCallback = allocAligned;
+			ResourceManager* resources = alloc.newInstance<ResourceManager>();
+			ANKI_TEST_EXPECT_NO_ERR(resources->create(rinit));
+
+			// The first load compiles it
+			{
+				AnimationResourcePtr anim;
+				ANKI_TEST_EXPECT_NO_ERR(resources->loadResource("compiled_resource_cache_bench.ankianim", anim));
+				durations[enabled] = anim->getDuration();
+				ANKI_TEST_EXPECT_EQ(anim->getChannels().getSize(), 64);
+			}
+
+			timer.start();
+			for(U i = 0; i < ITERATIONS / 10; ++i)
+			{
+				AnimationResourcePtr anim;
+				ANKI_TEST_EXPECT_NO_ERR(resources->loadResource("compiled_resource_cache_bench.ankianim", anim));
+			}
+			timer.stop();
+			times[enabled] = timer.getElapsedTime();
+
+			CompiledResourceCacheStats stats;
+			resources->_getCompiledResourceCache().getStats(stats);
+			ANKI_TEST_EXPECT_EQ(stats.m_hits, (enabled) ? ITERATIONS / 10 : 0);
+
+			alloc.deleteInstance(resources);
+		}
+
+		ANKI_TEST_EXPECT_EQ(durations[0], durations[1]);
+		printf("Animation load bench: XML %f binary %f | %f%%\n", times[0], times[1], times[0] / times[1] * 100.0);
+	}
+}
+
+} // end namespace anki
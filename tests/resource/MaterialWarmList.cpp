@@ -0,0 +1,89 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/resource/MaterialWarmList.h>
+
+namespace anki
+{
+
+ANKI_TEST(Resource, MaterialWarmList)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	// The keys map to unique indices and back
+	{
+		for(U p = 0; p < U(Pass::COUNT); ++p)
+		{
+			for(U l = 0; l < MAX_LODS; ++l)
+			{
+				for(U t = 0; t < 2; ++t)
+				{
+					for(U i = 1; i <= MAX_INSTANCES; i *= 2)
+					{
+						RenderingKey key(Pass(p), l, t, i);
+						RenderingKey key2 = MaterialWarmList::computeKey(MaterialWarmList::computeVariantIndex(key));
+
+						ANKI_TEST_EXPECT_EQ(RenderingKeyEqual()(key, key2), true);
+					}
+				}
+			}
+		}
+
+		// Instance counts of the same group share the index
+		ANKI_TEST_EXPECT_EQ(MaterialWarmList::computeVariantIndex(RenderingKey(Pass::SM, 1, false, 3)),
+			MaterialWarmList::computeVariantIndex(RenderingKey(Pass::SM, 1, false, 4)));
+	}
+
+	// Record, save and load it back
+	{
+		MaterialWarmList list;
+		list.init(alloc, "./material_warm_list.txt");
+
+		list.record("a.ankimtl", RenderingKey(Pass::MS_FS, 0, false, 1));
+		list.record("a.ankimtl", RenderingKey(Pass::SM, 2, false, 8));
+		list.record("a.ankimtl", RenderingKey(Pass::SM, 2, false, 8));
+		list.record("b.ankimtl", RenderingKey(Pass::MS_FS, 1, true, 1));
+		ANKI_TEST_EXPECT_EQ(list.getVariantCount(), 3);
+		ANKI_TEST_EXPECT_NO_ERR(list.save());
+	}
+
+	{
+		MaterialWarmList list;
+		list.init(alloc, "./material_warm_list.txt");
+		ANKI_TEST_EXPECT_NO_ERR(list.load());
+		ANKI_TEST_EXPECT_EQ(list.getVariantCount(), 3);
+
+		U count = 0;
+		Bool foundShadow = false;
+		ANKI_TEST_EXPECT_NO_ERR(list.iterateVariants("a.ankimtl", [&](const RenderingKey& key) -> Error {
+			++count;
+			if(key.m_pass == Pass::SM)
+			{
+				foundShadow = key.m_lod == 2 && key.m_instanceCount == 8 && !key.m_tessellation;
+			}
+			return ErrorCode::NONE;
+		}));
+		ANKI_TEST_EXPECT_EQ(count, 2);
+		ANKI_TEST_EXPECT_EQ(foundShadow, true);
+
+		count = 0;
+		ANKI_TEST_EXPECT_NO_ERR(list.iterateVariants("c.ankimtl", [&](const RenderingKey& key) -> Error {
+			++count;
+			return ErrorCode::NONE;
+		}));
+		ANKI_TEST_EXPECT_EQ(count, 0);
+	}
+
+	// A missing file is not an error
+	{
+		MaterialWarmList list;
+		list.init(alloc, "./material_warm_list_missing.txt");
+		ANKI_TEST_EXPECT_NO_ERR(list.load());
+		ANKI_TEST_EXPECT_EQ(list.getVariantCount(), 0);
+	}
+}
+
+} // end namespace anki
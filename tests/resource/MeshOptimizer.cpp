@@ -0,0 +1,197 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/resource/MeshOptimizer.h>
+#include <anki/util/HighRezTimer.h>
+#include <algorithm>
+#include <cstring>
+
+namespace anki
+{
+
+/// A grid of quads with shuffled triangles like the meshes that come out of the exporters.
+static void createGrid(U32 size, DynamicArrayAuto<Vec3>& positions, DynamicArrayAuto<U16>& indices)
+{
+	positions.create((size + 1) * (size + 1));
+	for(U32 y = 0; y <= size; ++y)
+	{
+		for(U32 x = 0; x <= size; ++x)
+		{
+			positions[y * (size + 1) + x] = Vec3(F32(x), F32(y), 0.0);
+		}
+	}
+
+	indices.create(size * size * 6);
+	U32 count = 0;
+	for(U32 y = 0; y < size; ++y)
+	{
+		for(U32 x = 0; x < size; ++x)
+		{
+			const U16 a = y * (size + 1) + x;
+			const U16 b = a + 1;
+			const U16 c = a + size + 1;
+			const U16 d = c + 1;
+
+			indices[count++] = a;
+			indices[count++] = b;
+			indices[count++] = d;
+			indices[count++] = a;
+			indices[count++] = d;
+			indices[count++] = c;
+		}
+	}
+
+	srand(0);
+	const U32 triCount = count / 3;
+	for(U32 t = triCount - 1; t > 0; --t)
+	{
+		const U32 other = rand() % (t + 1);
+		std::swap_ranges(&indices[t * 3], &indices[t * 3] + 3, &indices[other * 3]);
+	}
+}
+
+/// Sort the triangles so they can be compared regardless of their order and the rotation of their indices.
+static void sortTriangles(DynamicArrayAuto<U64>& out, const U16* indices, U32 indexCount)
+{
+	out.resize(indexCount / 3);
+	for(U32 i = 0; i < indexCount; i += 3)
+	{
+		const U16* tri = indices + i;
+		const U32 first = (tri[0] < tri[1] && tri[0] < tri[2]) ? 0 : ((tri[1] < tri[2]) ? 1 : 2);
+		out[i / 3] = (U64(tri[first]) << 32) | (U64(tri[(first + 1) % 3]) << 16) | U64(tri[(first + 2) % 3]);
+	}
+
+	std::sort(&out[0], &out[0] + out.getSize());
+}
+
+ANKI_TEST(Resource, MeshOptimizer)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	const U32 GRID_SIZE = 64;
+	DynamicArrayAuto<Vec3> positions(alloc);
+	DynamicArrayAuto<U16> indices(alloc);
+	createGrid(GRID_SIZE, positions, indices);
+	const U32 vertCount = positions.getSize();
+	const U32 indexCount = indices.getSize();
+
+	DynamicArrayAuto<U64> originalTris(alloc);
+	sortTriangles(originalTris, &indices[0], indexCount);
+
+	// The vertex cache
+	{
+		const VertexCacheStatistics before =
+			computeVertexCacheStatistics(WeakArray<const U16>(&indices[0], indexCount), vertCount);
+
+		optimizeVertexCache(WeakArray<U16>(&indices[0], indexCount), vertCount, alloc);
+
+		const VertexCacheStatistics after =
+			computeVertexCacheStatistics(WeakArray<const U16>(&indices[0], indexCount), vertCount);
+
+		// A shuffled grid misses almost every vertex. An optimized grid is close to the ideal 0.5
+		ANKI_TEST_EXPECT_GT(before.m_acmr, 2.0);
+		ANKI_TEST_EXPECT_LT(after.m_acmr, 0.8);
+		ANKI_TEST_EXPECT_LT(after.m_atvr, 1.6);
+
+		// Same triangles with the same winding
+		DynamicArrayAuto<U64> tris(alloc);
+		sortTriangles(tris, &indices[0], indexCount);
+		ANKI_TEST_EXPECT_EQ(memcmp(&tris[0], &originalTris[0], tris.getSizeInBytes()), 0);
+
+		// The overdraw reordering moves whole clusters so the cache stays efficient
+		optimizeOverdraw(WeakArray<U16>(&indices[0], indexCount), &positions[0], vertCount, alloc);
+
+		const VertexCacheStatistics afterOverdraw =
+			computeVertexCacheStatistics(WeakArray<const U16>(&indices[0], indexCount), vertCount);
+		ANKI_TEST_EXPECT_LT(afterOverdraw.m_acmr, after.m_acmr * 1.05);
+
+		sortTriangles(tris, &indices[0], indexCount);
+		ANKI_TEST_EXPECT_EQ(memcmp(&tris[0], &originalTris[0], tris.getSizeInBytes()), 0);
+	}
+
+	// The vertex fetch
+	{
+		DynamicArrayAuto<Vec3> verts(alloc);
+		verts.create(vertCount);
+		memcpy(&verts[0], &positions[0], positions.getSizeInBytes());
+
+		DynamicArrayAuto<U16> newIndices(alloc);
+		newIndices.create(indexCount);
+		memcpy(&newIndices[0], &indices[0], indices.getSizeInBytes());
+
+		const U32 newVertCount =
+			optimizeVertexFetch(WeakArray<U16>(&newIndices[0], indexCount), &verts[0], vertCount, sizeof(Vec3), alloc);
+		ANKI_TEST_EXPECT_EQ(newVertCount, vertCount);
+
+		// The vertices appear in the order they are used and the triangles point to the same positions
+		U32 maxIdx = 0;
+		for(U32 i = 0; i < indexCount; ++i)
+		{
+			ANKI_TEST_EXPECT_LEQ(newIndices[i], maxIdx);
+			maxIdx = max<U32>(maxIdx, newIndices[i] + 1);
+			ANKI_TEST_EXPECT_EQ(verts[newIndices[i]], positions[indices[i]]);
+		}
+	}
+
+	// Simplification
+	{
+		DynamicArrayAuto<U16> lod(alloc);
+		lod.create(indexCount);
+		memcpy(&lod[0], &indices[0], indices.getSizeInBytes());
+
+		const U32 target = indexCount / 4;
+		F32 error;
+		const U32 count =
+			simplifyMesh(WeakArray<U16>(&lod[0], indexCount), &positions[0], vertCount, target, error, alloc);
+		ANKI_TEST_EXPECT_LEQ(count, target);
+		ANKI_TEST_EXPECT_GT(count, target / 2);
+		ANKI_TEST_EXPECT_EQ(count % 3, 0);
+
+		// Nothing collapses
+		for(U32 i = 0; i < count; i += 3)
+		{
+			ANKI_TEST_EXPECT_NEQ(lod[i], lod[i + 1]);
+			ANKI_TEST_EXPECT_NEQ(lod[i + 1], lod[i + 2]);
+			ANKI_TEST_EXPECT_NEQ(lod[i], lod[i + 2]);
+		}
+
+		// The vertices stay in their cell. A quarter of the triangles needs cells of about 2 units
+		ANKI_TEST_EXPECT_GT(error, 0.0);
+		ANKI_TEST_EXPECT_LEQ(error, 3.0);
+
+		// A target above the index count leaves the mesh intact
+		ANKI_TEST_EXPECT_EQ(
+			simplifyMesh(WeakArray<U16>(&lod[0], count), &positions[0], vertCount, indexCount, error, alloc), count);
+		ANKI_TEST_EXPECT_EQ(error, 0.0);
+	}
+
+	// Bench it
+	{
+		const U32 BENCH_GRID_SIZE = 180;
+		DynamicArrayAuto<Vec3> benchPositions(alloc);
+		DynamicArrayAuto<U16> benchIndices(alloc);
+		createGrid(BENCH_GRID_SIZE, benchPositions, benchIndices);
+		WeakArray<U16> in(&benchIndices[0], benchIndices.getSize());
+
+		HighRezTimer timer;
+		timer.start();
+		optimizeVertexCache(in, benchPositions.getSize(), alloc);
+		timer.stop();
+		const HighRezTimer::Scalar cacheTime = timer.getElapsedTime();
+
+		timer.start();
+		optimizeOverdraw(in, &benchPositions[0], benchPositions.getSize(), alloc);
+		timer.stop();
+		const HighRezTimer::Scalar overdrawTime = timer.getElapsedTime();
+
+		printf("Optimizing %u triangles: vertex cache %fms, overdraw %fms\n",
+			U32(in.getSize() / 3),
+			cacheTime * 1000.0,
+			overdrawTime * 1000.0);
+	}
+}
+
+} // end namespace anki
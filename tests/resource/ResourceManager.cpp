@@ -87,4 +87,100 @@ ANKI_TEST(Resource, ResourceManager)
 	alloc.deleteInstance(resources);
 }
 
+ANKI_TEST(Resource, ResourceResidency)
+{
+	Config config;
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	ResourceManagerInitInfo rinit;
+	rinit.m_gr = nullptr;
+	rinit.m_config = &config;
+	rinit.m_cacheDir = "/tmp/";
+	rinit.m_allocCallback = allocAligned;
+	rinit.m_allocCallbackData = nullptr;
+	ResourceManager* resources = alloc.newInstance<ResourceManager>();
+	ANKI_TEST_EXPECT_NO_ERR(resources->create(rinit));
+
+	// Room for 2 dummy resources
+	resources->setResidencyBudget<DummyRsrc>(256);
+
+	ResourceResidencyStats stats;
+	U64 uuid;
+
+	// An unreferenced resource is revived
+	{
+		DummyResourcePtr a;
+		ANKI_TEST_EXPECT_NO_ERR(resources->loadResource("a", a));
+		uuid = a->getUuid();
+	}
+
+	ANKI_TEST_EXPECT_EQ(resources->getUnreferencedResourcesSize<DummyRsrc>(), 128);
+
+	{
+		DummyResourcePtr a;
+		ANKI_TEST_EXPECT_NO_ERR(resources->loadResource("a", a));
+		ANKI_TEST_EXPECT_EQ(a->getUuid(), uuid);
+		ANKI_TEST_EXPECT_EQ(a->getRefcount().load(), 1);
+		ANKI_TEST_EXPECT_EQ(resources->getUnreferencedResourcesSize<DummyRsrc>(), 0);
+	}
+
+	resources->getResidencyStats(stats);
+	ANKI_TEST_EXPECT_EQ(stats.m_hits, 1);
+	ANKI_TEST_EXPECT_EQ(stats.m_misses, 1);
+	ANKI_TEST_EXPECT_EQ(stats.m_evictions, 0);
+
+	// The least recently used is evicted
+	{
+		DummyResourcePtr b, c;
+		ANKI_TEST_EXPECT_NO_ERR(resources->loadResource("b", b));
+		ANKI_TEST_EXPECT_NO_ERR(resources->loadResource("c", c));
+	}
+
+	// "a" went first so it's gone
+	ANKI_TEST_EXPECT_EQ(resources->getUnreferencedResourcesSize<DummyRsrc>(), 256);
+	resources->getResidencyStats(stats);
+	ANKI_TEST_EXPECT_EQ(stats.m_evictions, 1);
+
+	{
+		DummyResourcePtr a;
+		ANKI_TEST_EXPECT_NO_ERR(resources->loadResource("a", a));
+		ANKI_TEST_EXPECT_NEQ(a->getUuid(), uuid);
+	}
+
+	resources->getResidencyStats(stats);
+	ANKI_TEST_EXPECT_EQ(stats.m_misses, 4);
+	ANKI_TEST_EXPECT_EQ(stats.m_evictions, 2);
+
+	// A referenced resource is never evicted
+	{
+		DummyResourcePtr a;
+		ANKI_TEST_EXPECT_NO_ERR(resources->loadResource("a", a));
+		resources->setResidencyBudget<DummyRsrc>(0);
+		ANKI_TEST_EXPECT_EQ(resources->getUnreferencedResourcesSize<DummyRsrc>(), 0);
+		ANKI_TEST_EXPECT_EQ(a->getRefcount().load(), 1);
+	}
+
+	resources->getResidencyStats(stats);
+	ANKI_TEST_EXPECT_EQ(stats.m_evictions, 3);
+
+	// Evict everything
+	resources->setResidencyBudget<DummyRsrc>(1024);
+	{
+		DummyResourcePtr a;
+		ANKI_TEST_EXPECT_NO_ERR(resources->loadResource("a", a));
+	}
+
+	ANKI_TEST_EXPECT_EQ(resources->getUnreferencedResourcesSize<DummyRsrc>(), 128);
+	resources->evictUnreferencedResources();
+	ANKI_TEST_EXPECT_EQ(resources->getUnreferencedResourcesSize<DummyRsrc>(), 0);
+
+	// The unreferenced resources are deleted with the manager
+	{
+		DummyResourcePtr a;
+		ANKI_TEST_EXPECT_NO_ERR(resources->loadResource("a", a));
+	}
+
+	alloc.deleteInstance(resources);
+}
+
 } // end namespace anki
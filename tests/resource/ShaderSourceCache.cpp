@@ -0,0 +1,112 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include "tests/framework/Framework.h"
+#include "anki/resource/ShaderSourceCache.h"
+#include "anki/util/File.h"
+#include "anki/util/Filesystem.h"
+#define private public
+#include "anki/resource/ResourceFilesystem.h"
+
+namespace anki
+{
+
+static void writeTestFile(CString filename, CString txt)
+{
+	File file;
+	ANKI_TEST_EXPECT_NO_ERR(file.open(filename, FileOpenFlag::WRITE));
+	ANKI_TEST_EXPECT_NO_ERR(file.writeText("%s", &txt[0]));
+}
+
+ANKI_TEST(Resource, ShaderSourceCache)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	if(directoryExists("./shader_source_cache"))
+	{
+		ANKI_TEST_EXPECT_NO_ERR(removeDirectory("./shader_source_cache"));
+	}
+	ANKI_TEST_EXPECT_NO_ERR(createDirectory("./shader_source_cache"));
+	writeTestFile("./shader_source_cache/Common.glsl", "#define COMMON 1\n");
+	writeTestFile("./shader_source_cache/Pack.glsl", "#include \"Common.glsl\"\nvoid pack();\n");
+	writeTestFile("./shader_source_cache/A.frag.glsl",
+		"#include \"Common.glsl\"\n#include \"Pack.glsl\"\nvoid main()\n{\n}\n");
+	writeTestFile("./shader_source_cache/B.frag.glsl", "#include \"Pack.glsl\"\nvoid main() {}\n");
+	writeTestFile("./shader_source_cache/Loop.glsl", "#include \"Loop.glsl\"\n");
+
+	ResourceFilesystem fs(alloc);
+	ANKI_TEST_EXPECT_NO_ERR(fs.addNewPath("./shader_source_cache"));
+
+	ShaderSourceCache cache;
+	cache.init(alloc, &fs);
+
+	// The includes are expanded in place
+	{
+		StringAuto src(alloc);
+		ANKI_TEST_EXPECT_NO_ERR(cache.expandIncludes("A.frag.glsl", alloc, src));
+		ANKI_TEST_EXPECT_EQ(src, "#define COMMON 1\n#define COMMON 1\nvoid pack();\nvoid main()\n{\n}");
+
+		ShaderSourceCacheStats stats;
+		cache.getStats(stats);
+		ANKI_TEST_EXPECT_EQ(stats.m_fileReads, 3);
+		ANKI_TEST_EXPECT_EQ(stats.m_fileHits, 1);
+	}
+
+	// The shared includes are not read again
+	{
+		StringAuto src(alloc);
+		ANKI_TEST_EXPECT_NO_ERR(cache.expandIncludes("B.frag.glsl", alloc, src));
+		ANKI_TEST_EXPECT_EQ(src, "#define COMMON 1\nvoid pack();\nvoid main() {}");
+
+		ShaderSourceCacheStats stats;
+		cache.getStats(stats);
+		ANKI_TEST_EXPECT_EQ(stats.m_fileReads, 4);
+		ANKI_TEST_EXPECT_EQ(stats.m_fileHits, 2);
+	}
+
+	// The final sources
+	{
+		const String* src;
+		ANKI_TEST_EXPECT_NO_ERR(cache.findSource("A.frag.glsl", 123, src));
+		ANKI_TEST_EXPECT_EQ(src == nullptr, true);
+
+		cache.storeSource("A.frag.glsl", 123, "#define X 1\nvoid main() {}");
+
+		ANKI_TEST_EXPECT_NO_ERR(cache.findSource("A.frag.glsl", 123, src));
+		ANKI_TEST_EXPECT_EQ(src != nullptr, true);
+		ANKI_TEST_EXPECT_EQ(*src, "#define X 1\nvoid main() {}");
+
+		ANKI_TEST_EXPECT_NO_ERR(cache.findSource("A.frag.glsl", 124, src));
+		ANKI_TEST_EXPECT_EQ(src == nullptr, true);
+	}
+
+	// A changed include invalidates the final source
+	{
+		writeTestFile("./shader_source_cache/Common.glsl", "#define COMMON 2\n");
+		cache.reloadFiles();
+
+		const String* src;
+		ANKI_TEST_EXPECT_NO_ERR(cache.findSource("A.frag.glsl", 123, src));
+		ANKI_TEST_EXPECT_EQ(src == nullptr, true);
+
+		// Back to the old contents the source is valid again
+		writeTestFile("./shader_source_cache/Common.glsl", "#define COMMON 1\n");
+		cache.reloadFiles();
+		StringAuto expanded(alloc);
+		ANKI_TEST_EXPECT_NO_ERR(cache.expandIncludes("A.frag.glsl", alloc, expanded));
+		cache.storeSource("A.frag.glsl", 123, "#define X 1\nvoid main() {}");
+		cache.reloadFiles();
+		ANKI_TEST_EXPECT_NO_ERR(cache.findSource("A.frag.glsl", 123, src));
+		ANKI_TEST_EXPECT_EQ(src != nullptr, true);
+	}
+
+	// Circular includes fail
+	{
+		StringAuto src(alloc);
+		ANKI_TEST_EXPECT_ERR(cache.expandIncludes("Loop.glsl", alloc, src), ErrorCode::USER_DATA);
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,125 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include "tests/framework/Framework.h"
+#include "anki/resource/TextureStreamer.h"
+
+namespace anki
+{
+
+ANKI_TEST(Resource, TextureStreamer)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	// Mip selection
+	{
+		ANKI_TEST_EXPECT_EQ(TextureStreamer::computeRequiredMip(1024, 9, 2000.0), 0);
+		ANKI_TEST_EXPECT_EQ(TextureStreamer::computeRequiredMip(1024, 9, 1024.0), 0);
+		ANKI_TEST_EXPECT_EQ(TextureStreamer::computeRequiredMip(1024, 9, 1000.0), 0);
+		ANKI_TEST_EXPECT_EQ(TextureStreamer::computeRequiredMip(1024, 9, 512.0), 1);
+		ANKI_TEST_EXPECT_EQ(TextureStreamer::computeRequiredMip(1024, 9, 300.0), 1);
+		ANKI_TEST_EXPECT_EQ(TextureStreamer::computeRequiredMip(1024, 9, 100.0), 3);
+		ANKI_TEST_EXPECT_EQ(TextureStreamer::computeRequiredMip(1024, 9, 1.0), 8);
+		ANKI_TEST_EXPECT_EQ(TextureStreamer::computeRequiredMip(1024, 9, 0.0), 8);
+	}
+
+	// 1024x1024 textures with 9 mips (1024 to 4). The mip 4 (64x64) is the base
+	const PtrSize baseSize = 64 * 64 * 4;
+	const PtrSize mip0Size = 1024 * 1024 * 4;
+	const U32 unseenFrames = 2;
+
+	// Room for the base mips of 2 textures and for a bit more than the full chain of one
+	TextureStreamer streamer;
+	streamer.init(alloc, 2 * baseSize + mip0Size + mip0Size / 2, unseenFrames);
+
+	const U32 a = streamer.registerTexture(1024, 9, 0, 4, baseSize, false);
+	const U32 b = streamer.registerTexture(1024, 9, 0, 4, baseSize, false);
+	ANKI_TEST_EXPECT_NEQ(a, b);
+	ANKI_TEST_EXPECT_EQ(streamer.getResidentMip(a), 4);
+
+	const PtrSize baseChainSize = streamer.getCommittedMemory() / 2;
+	ANKI_TEST_EXPECT_GEQ(baseChainSize, baseSize);
+
+	U64 frame = 1;
+	WeakArray<TextureStreamerRequest> requests;
+
+	// Nothing requested, nothing to do
+	streamer.update(frame++, requests);
+	ANKI_TEST_EXPECT_EQ(requests.getSize(), 0);
+
+	// Ask for the full "a"
+	streamer.requestScreenSize(a, 1024.0);
+	streamer.update(frame++, requests);
+	ANKI_TEST_EXPECT_EQ(requests.getSize(), 1);
+	ANKI_TEST_EXPECT_EQ(requests[0].m_handle, a);
+	ANKI_TEST_EXPECT_EQ(requests[0].m_firstMip, 0);
+	ANKI_TEST_EXPECT_LEQ(streamer.getCommittedMemory(), streamer.getBudget());
+
+	// In flight, no new requests
+	streamer.requestMip(a, 0);
+	streamer.update(frame++, requests);
+	ANKI_TEST_EXPECT_EQ(requests.getSize(), 0);
+
+	streamer.markResident(a, 0);
+	ANKI_TEST_EXPECT_EQ(streamer.getResidentMip(a), 0);
+
+	// "b" wants the full chain but "a" is still seen and it needs all its mips. Only some mips of "b" fit
+	streamer.requestMip(a, 0);
+	streamer.requestMip(b, 0);
+	streamer.update(frame++, requests);
+	ANKI_TEST_EXPECT_EQ(requests.getSize(), 1);
+	ANKI_TEST_EXPECT_EQ(requests[0].m_handle, b);
+	ANKI_TEST_EXPECT_EQ(requests[0].m_firstMip, 2);
+	streamer.markResident(b, 2);
+	ANKI_TEST_EXPECT_LEQ(streamer.getCommittedMemory(), streamer.getBudget());
+
+	// "a" is not requested any more. When it becomes unseen it's dropped to give room to "b"
+	for(U i = 0; i < unseenFrames; ++i)
+	{
+		streamer.requestMip(b, 0);
+		streamer.update(frame++, requests);
+		ANKI_TEST_EXPECT_EQ(requests.getSize(), 0);
+	}
+
+	streamer.requestMip(b, 0);
+	streamer.update(frame++, requests);
+	ANKI_TEST_EXPECT_EQ(requests.getSize(), 2);
+	ANKI_TEST_EXPECT_EQ(requests[0].m_handle, a);
+	ANKI_TEST_EXPECT_EQ(requests[0].m_firstMip, 4);
+	ANKI_TEST_EXPECT_EQ(requests[1].m_handle, b);
+	ANKI_TEST_EXPECT_EQ(requests[1].m_firstMip, 0);
+	ANKI_TEST_EXPECT_LEQ(streamer.getCommittedMemory(), streamer.getBudget());
+
+	streamer.markResident(a, 4);
+	streamer.markResident(b, 0);
+
+	// A far away object needs a smaller mip. It stays resident while there is room
+	streamer.requestScreenSize(b, 100.0);
+	streamer.update(frame++, requests);
+	ANKI_TEST_EXPECT_EQ(requests.getSize(), 0);
+	ANKI_TEST_EXPECT_EQ(streamer.getResidentMip(b), 0);
+
+	// "a" is needed again and the extra mips of "b" go. The load of "a" fails and it goes back to the base
+	streamer.requestMip(a, 1);
+	streamer.requestScreenSize(b, 100.0);
+	streamer.update(frame++, requests);
+	ANKI_TEST_EXPECT_EQ(requests.getSize(), 2);
+	ANKI_TEST_EXPECT_EQ(requests[0].m_handle, b);
+	ANKI_TEST_EXPECT_EQ(requests[0].m_firstMip, 3);
+	ANKI_TEST_EXPECT_EQ(requests[1].m_handle, a);
+	ANKI_TEST_EXPECT_EQ(requests[1].m_firstMip, 1);
+	streamer.markResident(b, 3);
+	streamer.markResident(a, 4);
+	ANKI_TEST_EXPECT_EQ(streamer.getResidentMip(a), 4);
+	ANKI_TEST_EXPECT_EQ(streamer.getResidentMip(b), 3);
+	ANKI_TEST_EXPECT_LEQ(streamer.getCommittedMemory(), streamer.getBudget());
+
+	// Unregister
+	streamer.unregisterTexture(a);
+	streamer.unregisterTexture(b);
+	ANKI_TEST_EXPECT_EQ(streamer.getCommittedMemory(), 0);
+}
+
+} // end namespace anki
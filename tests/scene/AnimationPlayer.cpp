@@ -0,0 +1,332 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/scene/AnimationPlayer.h>
+#include <anki/resource/ResourceManager.h>
+#include <anki/core/Config.h>
+#include <anki/misc/Xml.h>
+#include <anki/util/ThreadHive.h>
+#include <anki/util/HighRezTimer.h>
+#include <anki/util/System.h>
+#include <anki/util/File.h>
+#include <cstring>
+
+namespace anki
+{
+
+static const U BENCH_BONE_COUNT = 64;
+
+/// A chain of 3 bones. They are not in hierarchy order on purpose.
+static void writeTestSkeleton(CString filename)
+{
+	File file;
+	ANKI_TEST_EXPECT_NO_ERR(file.open(filename, FileOpenFlag::WRITE));
+	ANKI_TEST_EXPECT_NO_ERR(file.writeText("%s\n<skeleton><bones>\n"
+										   "<bone><name>hand</name><parent>arm</parent>"
+										   "<transform>1 0 0 0 0 1 0 -2 0 0 1 0 0 0 0 1</transform></bone>\n"
+										   "<bone><name>root</name>"
+										   "<transform>1 0 0 0 0 1 0 0 0 0 1 0 0 0 0 1</transform></bone>\n"
+										   "<bone><name>arm</name><parent>root</parent>"
+										   "<transform>1 0 0 0 0 1 0 -1 0 0 1 0 0 0 0 1</transform></bone>\n"
+										   "</bones></skeleton>\n",
+		&XmlDocument::XML_HEADER[0]));
+}
+
+/// The root moves 2 units in X and the arm rotates 90 degrees around Z in 1 second.
+static void writeTestAnimation(CString filename)
+{
+	File file;
+	ANKI_TEST_EXPECT_NO_ERR(file.open(filename, FileOpenFlag::WRITE));
+	ANKI_TEST_EXPECT_NO_ERR(file.writeText("%s\n<animation><repeat>0</repeat><channels>\n"
+										   "<channel><name>root</name><positionKeys>"
+										   "<key><time>0</time><value>0 0 0</value></key>"
+										   "<key><time>1</time><value>2 0 0</value></key>"
+										   "</positionKeys></channel>\n"
+										   "<channel><name>arm</name><rotationKeys>"
+										   "<key><time>0</time><value>0 0 0 1</value></key>"
+										   "<key><time>1</time><value>0 0 0.70710678 0.70710678</value></key>"
+										   "</rotationKeys></channel>\n"
+										   "<channel><name>tail</name><positionKeys>"
+										   "<key><time>0</time><value>1 1 1</value></key>"
+										   "</positionKeys></channel>\n"
+										   "</channels></animation>\n",
+		&XmlDocument::XML_HEADER[0]));
+}
+
+/// A binary tree of bones.
+static void writeBenchSkeleton(CString filename)
+{
+	File file;
+	ANKI_TEST_EXPECT_NO_ERR(file.open(filename, FileOpenFlag::WRITE));
+	ANKI_TEST_EXPECT_NO_ERR(file.writeText("%s\n<skeleton><bones>\n", &XmlDocument::XML_HEADER[0]));
+
+	for(U b = 0; b < BENCH_BONE_COUNT; ++b)
+	{
+		ANKI_TEST_EXPECT_NO_ERR(file.writeText("<bone><name>bone%u</name>", b));
+		if(b > 0)
+		{
+			ANKI_TEST_EXPECT_NO_ERR(file.writeText("<parent>bone%u</parent>", (b - 1) / 2));
+		}
+		ANKI_TEST_EXPECT_NO_ERR(
+			file.writeText("<transform>1 0 0 0 0 1 0 %f 0 0 1 0 0 0 0 1</transform></bone>\n", -F32(b) * 0.1f));
+	}
+
+	ANKI_TEST_EXPECT_NO_ERR(file.writeText("</bones></skeleton>\n"));
+}
+
+/// An animation with a channel for every bone.
+static void writeBenchAnimation(CString filename)
+{
+	File file;
+	ANKI_TEST_EXPECT_NO_ERR(file.open(filename, FileOpenFlag::WRITE));
+	ANKI_TEST_EXPECT_NO_ERR(
+		file.writeText("%s\n<animation><repeat>1</repeat><channels>\n", &XmlDocument::XML_HEADER[0]));
+
+	for(U c = 0; c < BENCH_BONE_COUNT; ++c)
+	{
+		ANKI_TEST_EXPECT_NO_ERR(file.writeText("<channel><name>bone%u</name>\n<positionKeys>\n", c));
+		for(U k = 0; k < 30; ++k)
+		{
+			ANKI_TEST_EXPECT_NO_ERR(file.writeText(
+				"<key><time>%f</time><value>%f 0.1 0</value></key>\n", F32(k) / 30.0f, sin(F32(k + c)) * 0.1f));
+		}
+		ANKI_TEST_EXPECT_NO_ERR(file.writeText("</positionKeys>\n<rotationKeys>\n"));
+		for(U k = 0; k < 30; ++k)
+		{
+			const F32 angle = F32(k + c) * 0.1f;
+			ANKI_TEST_EXPECT_NO_ERR(file.writeText("<key><time>%f</time><value>0 %f 0 %f</value></key>\n",
+				F32(k) / 30.0f,
+				sin(angle),
+				cos(angle)));
+		}
+		ANKI_TEST_EXPECT_NO_ERR(file.writeText("</rotationKeys>\n</channel>\n"));
+	}
+
+	ANKI_TEST_EXPECT_NO_ERR(file.writeText("</channels></animation>\n"));
+}
+
+/// The model space position of a point of the bind pose after skinning.
+static Vec3 skin(const AnimationPlayer& player, U32 bone, const Vec3& pos)
+{
+	return player.getBoneMatrices()[bone] * Vec4(pos, 1.0);
+}
+
+ANKI_TEST(Scene, AnimationPlayer)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	ThreadHive hive(max<U32>(getCpuCoresCount(), 4), alloc);
+
+	writeTestSkeleton("./animation_player_test.ankiskel");
+	writeTestAnimation("./animation_player_test.ankianim");
+	writeBenchSkeleton("./animation_player_bench.ankiskel");
+	writeBenchAnimation("./animation_player_bench.ankianim");
+
+	Config config;
+	config.set("dataPaths", ".");
+
+	ResourceFilesystem fs(alloc);
+	ANKI_TEST_EXPECT_NO_ERR(fs.init(config, "/tmp/"));
+
+	ResourceManagerInitInfo rinit;
+	rinit.m_resourceFs = &fs;
+	rinit.m_config = &config;
+	rinit.m_cacheDir = "/tmp/";
+	rinit.m_allocCallback = allocAligned;
+	ResourceManager* resources = alloc.newInstance<ResourceManager>();
+	ANKI_TEST_EXPECT_NO_ERR(resources->create(rinit));
+
+	// The hierarchy
+	{
+		SkeletonResourcePtr skel;
+		ANKI_TEST_EXPECT_NO_ERR(resources->loadResource("animation_player_test.ankiskel", skel));
+
+		const U32 hand = skel->findBone("hand");
+		const U32 root = skel->findBone("root");
+		const U32 arm = skel->findBone("arm");
+		ANKI_TEST_EXPECT_EQ(hand, 0);
+		ANKI_TEST_EXPECT_EQ(root, 1);
+		ANKI_TEST_EXPECT_EQ(arm, 2);
+		ANKI_TEST_EXPECT_EQ(skel->findBone("tail"), MAX_U32);
+
+		ANKI_TEST_EXPECT_EQ(skel->getBones()[root].getParent(), MAX_U32);
+		ANKI_TEST_EXPECT_EQ(skel->getBones()[arm].getParent(), root);
+		ANKI_TEST_EXPECT_EQ(skel->getBones()[hand].getParent(), arm);
+
+		const DynamicArray<U32>& order = skel->getBoneOrder();
+		ANKI_TEST_EXPECT_EQ(order[0], root);
+		ANKI_TEST_EXPECT_EQ(order[1], arm);
+		ANKI_TEST_EXPECT_EQ(order[2], hand);
+
+		ANKI_TEST_EXPECT_NEAR(skel->getBones()[hand].getBindPosition().y(), 1.0, EPSILON);
+		ANKI_TEST_EXPECT_NEAR(skel->getBones()[hand].getBindScale(), 1.0, EPSILON);
+	}
+
+	// The compressed tracks stay close to the keys
+	{
+		AnimationResourcePtr anim;
+		ANKI_TEST_EXPECT_NO_ERR(resources->loadResource("animation_player_test.ankianim", anim));
+		ANKI_TEST_EXPECT_EQ(anim->getSampleCount(), Animation::DEFAULT_SAMPLE_RATE + 1);
+
+		for(U i = 0; i <= 20; ++i)
+		{
+			const F32 time = F32(i) / 20.0;
+
+			Vec3 pos(0.0);
+			Quat rot = Quat::getIdentity();
+			F32 scale = 1.0;
+			anim->interpolate(0, time, pos, rot, scale);
+			ANKI_TEST_EXPECT_NEAR(pos.x(), 2.0 * time, 0.0001);
+			ANKI_TEST_EXPECT_NEAR(rot.w(), 1.0, EPSILON);
+			ANKI_TEST_EXPECT_NEAR(scale, 1.0, EPSILON);
+
+			anim->interpolate(1, time, pos, rot, scale);
+			const F32 halfAngle = toRad(45.0) * time;
+			ANKI_TEST_EXPECT_NEAR(rot.z(), sin(halfAngle), 0.0005);
+			ANKI_TEST_EXPECT_NEAR(rot.w(), cos(halfAngle), 0.0005);
+
+			anim->interpolate(2, time, pos, rot, scale);
+			ANKI_TEST_EXPECT_NEAR(pos.y(), 1.0, 0.0001);
+		}
+	}
+
+	// Play and blend
+	{
+		SkeletonResourcePtr skel;
+		ANKI_TEST_EXPECT_NO_ERR(resources->loadResource("animation_player_test.ankiskel", skel));
+		AnimationResourcePtr anim;
+		ANKI_TEST_EXPECT_NO_ERR(resources->loadResource("animation_player_test.ankianim", anim));
+
+		const U32 hand = 0;
+		const U32 arm = 2;
+		const F32 sin45 = sin(toRad(45.0));
+
+		AnimationPlayer player;
+		player.init(alloc, skel);
+
+		// Nothing plays, the bind pose
+		player.update(0.5);
+		Vec3 p = skin(player, hand, Vec3(0.0, 2.0, 0.0));
+		ANKI_TEST_EXPECT_NEAR(p.y(), 2.0, EPSILON);
+		ANKI_TEST_EXPECT_NEAR(player.getBoneTransforms()[hand](1, 3), 2.0, EPSILON);
+
+		// At the end of the animation
+		ANKI_TEST_EXPECT_EQ(player.play(anim, 10.0), 0);
+		player.update(11.0);
+		p = skin(player, hand, Vec3(0.0, 2.0, 0.0));
+		ANKI_TEST_EXPECT_NEAR(p.x(), 1.0, 0.0001);
+		ANKI_TEST_EXPECT_NEAR(p.y(), 1.0, 0.0001);
+		p = skin(player, arm, Vec3(0.0, 1.5, 0.0));
+		ANKI_TEST_EXPECT_NEAR(p.x(), 1.5, 0.0001);
+		ANKI_TEST_EXPECT_NEAR(p.y(), 1.0, 0.0001);
+
+		// It doesn't repeat
+		player.update(20.0);
+		p = skin(player, hand, Vec3(0.0, 2.0, 0.0));
+		ANKI_TEST_EXPECT_NEAR(p.x(), 1.0, 0.0001);
+
+		// Half of it is the bind pose
+		player.setWeight(0, 0.5);
+		player.update(11.0);
+		p = skin(player, hand, Vec3(0.0, 2.0, 0.0));
+		ANKI_TEST_EXPECT_NEAR(p.x(), 1.0 - sin45, 0.0001);
+		ANKI_TEST_EXPECT_NEAR(p.y(), 1.0 + sin45, 0.0001);
+
+		// The same with a second animation that just started
+		player.setWeight(0, 0.5);
+		ANKI_TEST_EXPECT_EQ(player.play(anim, 11.0, 0.5), 1);
+		player.update(11.0);
+		p = skin(player, hand, Vec3(0.0, 2.0, 0.0));
+		ANKI_TEST_EXPECT_NEAR(p.x(), 1.0 - sin45, 0.0001);
+		ANKI_TEST_EXPECT_NEAR(p.y(), 1.0 + sin45, 0.0001);
+
+		// Stop the first. The second takes its place
+		player.stop(0);
+		ANKI_TEST_EXPECT_EQ(player.getAnimationCount(), 1);
+		player.setWeight(0, 1.0);
+		player.update(12.0);
+		p = skin(player, hand, Vec3(0.0, 2.0, 0.0));
+		ANKI_TEST_EXPECT_NEAR(p.x(), 1.0, 0.0001);
+		ANKI_TEST_EXPECT_NEAR(p.y(), 1.0, 0.0001);
+
+		// Too many
+		for(U i = 1; i < AnimationPlayer::MAX_ANIMATIONS; ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(player.play(anim, 0.0), i);
+		}
+		ANKI_TEST_EXPECT_EQ(player.play(anim, 0.0), MAX_U32);
+	}
+
+	// Many characters
+	{
+		SkeletonResourcePtr skel;
+		ANKI_TEST_EXPECT_NO_ERR(resources->loadResource("animation_player_bench.ankiskel", skel));
+		AnimationResourcePtr anim;
+		ANKI_TEST_EXPECT_NO_ERR(resources->loadResource("animation_player_bench.ankianim", anim));
+
+		const U COUNT = 1024;
+		const U FRAMES = 16;
+		DynamicArrayAuto<AnimationPlayer> players(alloc);
+		DynamicArrayAuto<AnimationPlayer*> ptrs(alloc);
+		players.create(COUNT);
+		ptrs.create(COUNT);
+		for(U i = 0; i < COUNT; ++i)
+		{
+			players[i].init(alloc, skel);
+			players[i].play(anim, -F32(i) / COUNT, 0.7);
+			players[i].play(anim, F32(i) / COUNT, 0.3);
+			ptrs[i] = &players[i];
+		}
+
+		WeakArray<AnimationPlayer*> arr(&ptrs[0], COUNT);
+
+		// The threads give the same results
+		AnimationPlayer::updateMany(arr, 0.5);
+		DynamicArrayAuto<Mat3x4> matrices(alloc);
+		matrices.create(COUNT * BENCH_BONE_COUNT);
+		for(U i = 0; i < COUNT; ++i)
+		{
+			memcpy(&matrices[i * BENCH_BONE_COUNT], players[i].getBoneMatrices(), sizeof(Mat3x4) * BENCH_BONE_COUNT);
+		}
+
+		AnimationPlayer::updateMany(arr, 0.5, &hive);
+		for(U i = 0; i < COUNT; ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(memcmp(&matrices[i * BENCH_BONE_COUNT],
+									players[i].getBoneMatrices(),
+									sizeof(Mat3x4) * BENCH_BONE_COUNT),
+				0);
+		}
+
+		// Bench it
+		HighRezTimer timer;
+		timer.start();
+		for(U i = 0; i < FRAMES; ++i)
+		{
+			AnimationPlayer::updateMany(arr, F32(i) / 60.0);
+		}
+		timer.stop();
+		const HighRezTimer::Scalar singleTime = timer.getElapsedTime() / FRAMES;
+
+		timer.start();
+		for(U i = 0; i < FRAMES; ++i)
+		{
+			AnimationPlayer::updateMany(arr, F32(i) / 60.0, &hive);
+		}
+		timer.stop();
+		const HighRezTimer::Scalar hiveTime = timer.getElapsedTime() / FRAMES;
+
+		printf("Skinning %u characters of %u bones: single thread %fms, %u threads %fms\n",
+			U32(COUNT),
+			U32(BENCH_BONE_COUNT),
+			singleTime * 1000.0,
+			U32(hive.getThreadCount()),
+			hiveTime * 1000.0);
+	}
+
+	alloc.deleteInstance(resources);
+}
+
+} // end namespace anki
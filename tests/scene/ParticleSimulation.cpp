@@ -0,0 +1,160 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/scene/ParticleSimulation.h>
+#include <anki/util/ThreadHive.h>
+#include <anki/util/HighRezTimer.h>
+#include <anki/util/System.h>
+#include <cstring>
+
+namespace anki
+{
+
+ANKI_TEST(Scene, ParticleSimulation)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	ThreadHive hive(max<U32>(getCpuCoresCount(), 4), alloc);
+
+	ParticleEmitterProperties props;
+	props.m_particle.m_life = 1.0;
+	props.m_particle.m_gravity = Vec3(0.0, -10.0, 0.0);
+	props.m_particle.m_size = 2.0;
+	props.m_particle.m_sizeAnimation = 1.0;
+	props.m_particle.m_alpha = 0.5;
+	props.m_particle.m_alphaAnimation = false;
+
+	const Vec4 origin(1.0, 2.0, 3.0, 0.0);
+
+	// Simulate and kill. The count is not a multiple of 4 to test the remainder
+	{
+		ParticleSimulation sim;
+		sim.init(alloc, 10);
+
+		DynamicArrayAuto<F32> verts(alloc);
+		verts.create(10 * 5);
+		Vec4 aabbMin, aabbMax;
+
+		ANKI_TEST_EXPECT_EQ(sim.emit(props, origin, 0.0, 6), 6);
+		sim.update(props, 0.0, 0.5, &verts[0], aabbMin, aabbMax);
+		ANKI_TEST_EXPECT_EQ(sim.getAliveParticleCount(), 6);
+
+		for(U i = 0; i < 6; ++i)
+		{
+			const F32* v = &verts[i * 5];
+			ANKI_TEST_EXPECT_NEAR(v[0], 1.0, EPSILON);
+			ANKI_TEST_EXPECT_NEAR(v[1], -0.5, EPSILON);
+			ANKI_TEST_EXPECT_NEAR(v[2], 3.0, EPSILON);
+			ANKI_TEST_EXPECT_NEAR(v[3], 2.5, EPSILON);
+			ANKI_TEST_EXPECT_NEAR(v[4], 0.5, EPSILON);
+		}
+
+		ANKI_TEST_EXPECT_NEAR(aabbMin.y(), -0.5, EPSILON);
+		ANKI_TEST_EXPECT_NEAR(aabbMax.y(), -0.5, EPSILON);
+
+		// Only 4 fit
+		ANKI_TEST_EXPECT_EQ(sim.emit(props, origin, 0.5, 8), 4);
+		ANKI_TEST_EXPECT_EQ(sim.getAliveParticleCount(), 10);
+
+		// The first 6 die, the rest move for the first time
+		sim.update(props, 0.5, 1.2, &verts[0], aabbMin, aabbMax);
+		ANKI_TEST_EXPECT_EQ(sim.getAliveParticleCount(), 4);
+
+		for(U i = 0; i < 4; ++i)
+		{
+			const F32* v = &verts[i * 5];
+			ANKI_TEST_EXPECT_NEAR(v[1], 2.0 - 10.0 * 0.7 * 0.7, 0.0001);
+			ANKI_TEST_EXPECT_NEAR(v[3], 2.0 + 0.7, 0.0001);
+			ANKI_TEST_EXPECT_NEAR(sim.getPosition(i).y(), v[1], EPSILON);
+		}
+
+		ANKI_TEST_EXPECT_NEAR(aabbMin.x(), 1.0, EPSILON);
+		ANKI_TEST_EXPECT_NEAR(aabbMax.z(), 3.0, EPSILON);
+
+		// Everything dies
+		sim.update(props, 1.2, 2.0, &verts[0], aabbMin, aabbMax);
+		ANKI_TEST_EXPECT_EQ(sim.getAliveParticleCount(), 0);
+	}
+
+	// The threads give the same results
+	{
+		props.m_particle.m_lifeDeviation = 0.5;
+		props.m_particle.m_gravityDeviation = Vec3(1.0);
+		props.m_particle.m_startingPosDeviation = Vec3(10.0);
+		props.m_particle.m_alphaAnimation = true;
+
+		const U COUNT = 100 * 1024 + 3;
+		ParticleSimulation a, b;
+		a.init(alloc, COUNT);
+		b.init(alloc, COUNT);
+
+		srand(0);
+		a.emit(props, origin, 0.0, COUNT);
+		srand(0);
+		b.emit(props, origin, 0.0, COUNT);
+
+		DynamicArrayAuto<F32> vertsA(alloc);
+		vertsA.create(COUNT * 5);
+		DynamicArrayAuto<F32> vertsB(alloc);
+		vertsB.create(COUNT * 5);
+		Vec4 aabbMinA, aabbMaxA, aabbMinB, aabbMaxB;
+
+		a.update(props, 0.0, 0.8, &vertsA[0], aabbMinA, aabbMaxA);
+		b.update(props, 0.0, 0.8, &vertsB[0], aabbMinB, aabbMaxB, &hive);
+
+		ANKI_TEST_EXPECT_EQ(a.getAliveParticleCount(), b.getAliveParticleCount());
+		ANKI_TEST_EXPECT_GT(a.getAliveParticleCount(), 0);
+		ANKI_TEST_EXPECT_LT(a.getAliveParticleCount(), COUNT);
+		ANKI_TEST_EXPECT_EQ(memcmp(&vertsA[0], &vertsB[0], a.getAliveParticleCount() * 5 * sizeof(F32)), 0);
+		for(U i = 0; i < 3; ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(aabbMinA[i], aabbMinB[i]);
+			ANKI_TEST_EXPECT_EQ(aabbMaxA[i], aabbMaxB[i]);
+		}
+	}
+
+	// Bench it
+	{
+		props.m_particle.m_life = 1000.0;
+		props.m_particle.m_lifeDeviation = 0.0;
+
+		const U COUNT = 1024 * 1024;
+		const U FRAMES = 16;
+		ParticleSimulation sim;
+		sim.init(alloc, COUNT);
+		sim.emit(props, origin, 0.0, COUNT);
+
+		DynamicArrayAuto<F32> verts(alloc);
+		verts.create(COUNT * 5);
+		Vec4 aabbMin, aabbMax;
+
+		HighRezTimer timer;
+		timer.start();
+		for(U i = 0; i < FRAMES; ++i)
+		{
+			sim.update(props, F32(i) / 60.0, F32(i + 1) / 60.0, &verts[0], aabbMin, aabbMax);
+		}
+		timer.stop();
+		const HighRezTimer::Scalar singleTime = timer.getElapsedTime() / FRAMES;
+
+		timer.start();
+		for(U i = 0; i < FRAMES; ++i)
+		{
+			sim.update(props, F32(i) / 60.0, F32(i + 1) / 60.0, &verts[0], aabbMin, aabbMax, &hive);
+		}
+		timer.stop();
+		const HighRezTimer::Scalar hiveTime = timer.getElapsedTime() / FRAMES;
+
+		ANKI_TEST_EXPECT_EQ(sim.getAliveParticleCount(), COUNT);
+
+		printf("Simulating %u particles: single thread %fms, %u threads %fms\n",
+			U32(COUNT),
+			singleTime * 1000.0,
+			U32(hive.getThreadCount()),
+			hiveTime * 1000.0);
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,288 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/scene/SectorStreamer.h>
+#include <anki/util/HighRezTimer.h>
+#include <vector>
+
+namespace anki
+{
+
+/// A chain of sectors. Every sector has a portal to the next.
+static void createChain(U32 count, std::vector<SectorStreamingInfo>& sectors, std::vector<SectorStreamingLink>& links)
+{
+	sectors.clear();
+	links.clear();
+	for(U32 i = 0; i < count; ++i)
+	{
+		SectorStreamingInfo info;
+		info.m_fileSize = 100;
+		sectors.push_back(info);
+
+		if(i > 0)
+		{
+			SectorStreamingLink link;
+			link.m_sectorA = i - 1;
+			link.m_sectorB = i;
+			links.push_back(link);
+		}
+	}
+}
+
+/// Schedule and apply the result as if every load finished in the same frame.
+static void step(std::vector<SectorStreamingInfo>& sectors,
+	const std::vector<SectorStreamingLink>& links,
+	U32 cameraSector,
+	const SectorStreamingLimits& limits,
+	DynamicArrayAuto<U32>& loads,
+	DynamicArrayAuto<U32>& unloads,
+	GenericMemoryPoolAllocator<U8> alloc)
+{
+	scheduleSectorStreaming(WeakArray<const SectorStreamingInfo>(&sectors[0], sectors.size()),
+		WeakArray<const SectorStreamingLink>((links.size()) ? &links[0] : nullptr, links.size()),
+		cameraSector,
+		limits,
+		loads,
+		unloads,
+		alloc);
+
+	for(U32 idx : unloads)
+	{
+		sectors[idx].m_state = SectorStreamingState::UNLOADED;
+	}
+
+	for(U32 idx : loads)
+	{
+		sectors[idx].m_state = SectorStreamingState::LOADED;
+	}
+}
+
+static U32 countLoaded(const std::vector<SectorStreamingInfo>& sectors)
+{
+	U32 count = 0;
+	for(const SectorStreamingInfo& info : sectors)
+	{
+		count += (info.m_state != SectorStreamingState::UNLOADED) ? 1 : 0;
+	}
+
+	return count;
+}
+
+ANKI_TEST(Scene, SectorStreamer)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	DynamicArrayAuto<U32> loads(alloc);
+	DynamicArrayAuto<U32> unloads(alloc);
+
+	// The sectors around the camera load, the closest first
+	{
+		std::vector<SectorStreamingInfo> sectors;
+		std::vector<SectorStreamingLink> links;
+		createChain(8, sectors, links);
+
+		SectorStreamingLimits limits;
+		limits.m_maxLoadingCount = 10;
+
+		step(sectors, links, 3, limits, loads, unloads, alloc);
+		ANKI_TEST_EXPECT_EQ(loads.getSize(), 3);
+		ANKI_TEST_EXPECT_EQ(loads[0], 3);
+		ANKI_TEST_EXPECT_EQ(unloads.getSize(), 0);
+		ANKI_TEST_EXPECT_EQ(countLoaded(sectors), 3);
+
+		// Outside of all sectors nothing changes
+		step(sectors, links, MAX_U32, limits, loads, unloads, alloc);
+		ANKI_TEST_EXPECT_EQ(loads.getSize(), 0);
+		ANKI_TEST_EXPECT_EQ(unloads.getSize(), 0);
+
+		// Walk to the end. Only the sectors past the unload distance go away
+		step(sectors, links, 4, limits, loads, unloads, alloc);
+		ANKI_TEST_EXPECT_EQ(loads.getSize(), 1);
+		ANKI_TEST_EXPECT_EQ(loads[0], 5);
+		ANKI_TEST_EXPECT_EQ(unloads.getSize(), 0);
+
+		step(sectors, links, 6, limits, loads, unloads, alloc);
+		ANKI_TEST_EXPECT_EQ(sectors[2].m_state, SectorStreamingState::UNLOADED);
+		ANKI_TEST_EXPECT_EQ(sectors[3].m_state, SectorStreamingState::UNLOADED);
+		ANKI_TEST_EXPECT_EQ(sectors[4].m_state, SectorStreamingState::LOADED);
+		ANKI_TEST_EXPECT_EQ(sectors[7].m_state, SectorStreamingState::LOADED);
+	}
+
+	// Hysteresis. Walking back and forth through a portal doesn't load or unload anything
+	{
+		std::vector<SectorStreamingInfo> sectors;
+		std::vector<SectorStreamingLink> links;
+		createChain(8, sectors, links);
+
+		SectorStreamingLimits limits;
+		limits.m_maxLoadingCount = 10;
+
+		step(sectors, links, 3, limits, loads, unloads, alloc);
+		step(sectors, links, 4, limits, loads, unloads, alloc);
+
+		U32 changes = 0;
+		for(U32 i = 0; i < 100; ++i)
+		{
+			step(sectors, links, (i & 1) ? 3 : 4, limits, loads, unloads, alloc);
+			changes += loads.getSize() + unloads.getSize();
+		}
+
+		ANKI_TEST_EXPECT_EQ(changes, 0);
+		ANKI_TEST_EXPECT_EQ(countLoaded(sectors), 4);
+	}
+
+	// The sectors that load at the same time
+	{
+		std::vector<SectorStreamingInfo> sectors;
+		std::vector<SectorStreamingLink> links;
+		createChain(8, sectors, links);
+
+		SectorStreamingLimits limits;
+		limits.m_loadDistance = 3;
+		limits.m_unloadDistance = 3;
+		limits.m_maxLoadingCount = 2;
+
+		scheduleSectorStreaming(WeakArray<const SectorStreamingInfo>(&sectors[0], sectors.size()),
+			WeakArray<const SectorStreamingLink>(&links[0], links.size()),
+			0,
+			limits,
+			loads,
+			unloads,
+			alloc);
+		ANKI_TEST_EXPECT_EQ(loads.getSize(), 2);
+		ANKI_TEST_EXPECT_EQ(loads[0], 0);
+		ANKI_TEST_EXPECT_EQ(loads[1], 1);
+
+		// The loading sectors count
+		sectors[0].m_state = SectorStreamingState::LOADING;
+		scheduleSectorStreaming(WeakArray<const SectorStreamingInfo>(&sectors[0], sectors.size()),
+			WeakArray<const SectorStreamingLink>(&links[0], links.size()),
+			0,
+			limits,
+			loads,
+			unloads,
+			alloc);
+		ANKI_TEST_EXPECT_EQ(loads.getSize(), 1);
+		ANKI_TEST_EXPECT_EQ(loads[0], 1);
+	}
+
+	// The file budget. The far loaded sectors make room for the close ones
+	{
+		std::vector<SectorStreamingInfo> sectors;
+		std::vector<SectorStreamingLink> links;
+		createChain(8, sectors, links);
+
+		SectorStreamingLimits limits;
+		limits.m_loadDistance = 1;
+		limits.m_unloadDistance = 3;
+		limits.m_fileBudget = 450;
+		limits.m_maxLoadingCount = 10;
+
+		step(sectors, links, 0, limits, loads, unloads, alloc);
+		step(sectors, links, 1, limits, loads, unloads, alloc);
+		step(sectors, links, 2, limits, loads, unloads, alloc);
+		step(sectors, links, 3, limits, loads, unloads, alloc);
+		ANKI_TEST_EXPECT_EQ(countLoaded(sectors), 4);
+
+		step(sectors, links, 4, limits, loads, unloads, alloc);
+		ANKI_TEST_EXPECT_EQ(unloads.getSize(), 1);
+		ANKI_TEST_EXPECT_EQ(sectors[0].m_state, SectorStreamingState::UNLOADED);
+		ANKI_TEST_EXPECT_EQ(sectors[1].m_state, SectorStreamingState::UNLOADED);
+		ANKI_TEST_EXPECT_EQ(sectors[5].m_state, SectorStreamingState::LOADED);
+
+		PtrSize fileSize = 0;
+		for(const SectorStreamingInfo& info : sectors)
+		{
+			fileSize += (info.m_state != SectorStreamingState::UNLOADED) ? info.m_fileSize : 0;
+		}
+		ANKI_TEST_EXPECT_LEQ(fileSize, limits.m_fileBudget);
+
+		// A sector that doesn't fit waits and nothing is evicted for it
+		sectors[6].m_fileSize = 1000;
+		step(sectors, links, 5, limits, loads, unloads, alloc);
+		ANKI_TEST_EXPECT_EQ(loads.getSize(), 0);
+		ANKI_TEST_EXPECT_EQ(unloads.getSize(), 0);
+		ANKI_TEST_EXPECT_EQ(sectors[6].m_state, SectorStreamingState::UNLOADED);
+
+		// Alone it loads
+		for(SectorStreamingInfo& info : sectors)
+		{
+			info.m_state = SectorStreamingState::UNLOADED;
+		}
+		step(sectors, links, 6, limits, loads, unloads, alloc);
+		ANKI_TEST_EXPECT_EQ(loads.getSize(), 1);
+		ANKI_TEST_EXPECT_EQ(loads[0], 6);
+	}
+
+	// The sectors without a manifest connect the rest
+	{
+		std::vector<SectorStreamingInfo> sectors;
+		std::vector<SectorStreamingLink> links;
+		createChain(3, sectors, links);
+		sectors[1].m_streamed = false;
+
+		SectorStreamingLimits limits;
+		limits.m_loadDistance = 2;
+		limits.m_unloadDistance = 2;
+
+		step(sectors, links, 0, limits, loads, unloads, alloc);
+		ANKI_TEST_EXPECT_EQ(loads.getSize(), 2);
+		ANKI_TEST_EXPECT_EQ(loads[0], 0);
+		ANKI_TEST_EXPECT_EQ(loads[1], 2);
+		ANKI_TEST_EXPECT_EQ(sectors[1].m_state, SectorStreamingState::UNLOADED);
+	}
+
+	// Bench it
+	{
+		// A grid of sectors with portals to the 4 neighbours
+		const U32 SIZE = 64;
+		std::vector<SectorStreamingInfo> sectors(SIZE * SIZE);
+		std::vector<SectorStreamingLink> links;
+		for(U32 y = 0; y < SIZE; ++y)
+		{
+			for(U32 x = 0; x < SIZE; ++x)
+			{
+				SectorStreamingLink link;
+				link.m_sectorA = y * SIZE + x;
+				if(x + 1 < SIZE)
+				{
+					link.m_sectorB = y * SIZE + x + 1;
+					links.push_back(link);
+				}
+
+				if(y + 1 < SIZE)
+				{
+					link.m_sectorB = (y + 1) * SIZE + x;
+					links.push_back(link);
+				}
+			}
+		}
+
+		SectorStreamingLimits limits;
+		limits.m_loadDistance = 2;
+		limits.m_unloadDistance = 4;
+		limits.m_maxLoadingCount = 4;
+
+		const U32 COUNT = 1000;
+		U32 changes = 0;
+
+		HighRezTimer timer;
+		timer.start();
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			step(sectors, links, (i / 4) % U32(sectors.size()), limits, loads, unloads, alloc);
+			changes += loads.getSize() + unloads.getSize();
+		}
+		timer.stop();
+
+		printf("%u schedules of %u sectors (%u changes) took %fms\n",
+			COUNT,
+			U32(sectors.size()),
+			changes,
+			timer.getElapsedTime() * 1000.0);
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,156 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/scene/StaticGeometryBatcher.h>
+#include <anki/util/HighRezTimer.h>
+#include <vector>
+
+namespace anki
+{
+
+/// A grid of boxes of 1 unit with a distance of 2 units. The materials alternate.
+static void createGrid(U32 size, U32 materialCount, std::vector<StaticGeometryBatchItem>& items)
+{
+	items.clear();
+	for(U32 z = 0; z < size; ++z)
+	{
+		for(U32 x = 0; x < size; ++x)
+		{
+			StaticGeometryBatchItem item;
+			const Vec4 min(F32(x) * 2.0f, 0.0f, F32(z) * 2.0f, 0.0f);
+			item.m_bounds = Aabb(min, min + Vec4(1.0f, 1.0f, 1.0f, 0.0f));
+			item.m_vertexCount = 500;
+			item.m_batchKey = (x + z) % materialCount;
+			items.push_back(item);
+		}
+	}
+}
+
+ANKI_TEST(Scene, StaticGeometryBatcher)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	// Clusters of a grid
+	{
+		std::vector<StaticGeometryBatchItem> items;
+		createGrid(64, 2, items);
+
+		StaticGeometryClusterLimits limits;
+		limits.m_maxSize = 16.0f;
+
+		DynamicArrayAuto<U32> order(alloc);
+		DynamicArrayAuto<StaticGeometryCluster> clusters(alloc);
+		clusterStaticGeometry(
+			WeakArray<const StaticGeometryBatchItem>(&items[0], items.size()), limits, order, clusters);
+
+		ANKI_TEST_EXPECT_EQ(order.getSize(), items.size());
+
+		// Every item is in one cluster and the clusters don't mix keys
+		std::vector<U32> seen(items.size(), 0);
+		for(const StaticGeometryCluster& cluster : clusters)
+		{
+			ANKI_TEST_EXPECT_GT(cluster.m_itemCount, 0);
+
+			U32 vertCount = 0;
+			const U64 key = items[order[cluster.m_firstItem]].m_batchKey;
+			for(U32 i = cluster.m_firstItem; i < cluster.m_firstItem + cluster.m_itemCount; ++i)
+			{
+				const StaticGeometryBatchItem& item = items[order[i]];
+				++seen[order[i]];
+				vertCount += item.m_vertexCount;
+				ANKI_TEST_EXPECT_EQ(item.m_batchKey, key);
+
+				// The bounds of the cluster contain the item
+				for(U c = 0; c < 3; ++c)
+				{
+					ANKI_TEST_EXPECT_LEQ(cluster.m_bounds.getMin()[c], item.m_bounds.getMin()[c]);
+					ANKI_TEST_EXPECT_GEQ(cluster.m_bounds.getMax()[c], item.m_bounds.getMax()[c]);
+				}
+			}
+
+			// Inside the limits
+			ANKI_TEST_EXPECT_LEQ(vertCount, limits.m_maxVertexCount);
+			const Vec4 size = cluster.m_bounds.getMax() - cluster.m_bounds.getMin();
+			ANKI_TEST_EXPECT_LEQ(max(size.x(), max(size.y(), size.z())), limits.m_maxSize);
+		}
+
+		for(U32 count : seen)
+		{
+			ANKI_TEST_EXPECT_EQ(count, 1);
+		}
+
+		// An order of magnitude less
+		ANKI_TEST_EXPECT_LEQ(clusters.getSize() * 10, items.size());
+	}
+
+	// An item that is out of the limits stays alone
+	{
+		std::vector<StaticGeometryBatchItem> items;
+		createGrid(2, 1, items);
+		items[0].m_vertexCount = MAX_U16;
+
+		DynamicArrayAuto<U32> order(alloc);
+		DynamicArrayAuto<StaticGeometryCluster> clusters(alloc);
+		clusterStaticGeometry(WeakArray<const StaticGeometryBatchItem>(&items[0], items.size()),
+			StaticGeometryClusterLimits(),
+			order,
+			clusters);
+
+		// The median split leaves a neighbour of it alone as well
+		ANKI_TEST_EXPECT_EQ(clusters.getSize(), 3);
+		for(const StaticGeometryCluster& cluster : clusters)
+		{
+			if(order[cluster.m_firstItem] == 0)
+			{
+				ANKI_TEST_EXPECT_EQ(cluster.m_itemCount, 1);
+			}
+		}
+	}
+
+	// The index count is not limited. A cluster can use all the vertices that 16bit indices address
+	{
+		std::vector<StaticGeometryBatchItem> items;
+		createGrid(2, 1, items);
+		for(StaticGeometryBatchItem& item : items)
+		{
+			item.m_vertexCount = (MAX_U16 + 1) / 4; // Eg a patch of 16K vertices and more than 65535 indices
+		}
+
+		DynamicArrayAuto<U32> order(alloc);
+		DynamicArrayAuto<StaticGeometryCluster> clusters(alloc);
+		clusterStaticGeometry(WeakArray<const StaticGeometryBatchItem>(&items[0], items.size()),
+			StaticGeometryClusterLimits(),
+			order,
+			clusters);
+
+		ANKI_TEST_EXPECT_EQ(clusters.getSize(), 1);
+		ANKI_TEST_EXPECT_EQ(clusters[0].m_itemCount, 4);
+	}
+
+	// Bench it
+	{
+		std::vector<StaticGeometryBatchItem> items;
+		createGrid(256, 8, items);
+
+		DynamicArrayAuto<U32> order(alloc);
+		DynamicArrayAuto<StaticGeometryCluster> clusters(alloc);
+
+		HighRezTimer timer;
+		timer.start();
+		clusterStaticGeometry(WeakArray<const StaticGeometryBatchItem>(&items[0], items.size()),
+			StaticGeometryClusterLimits(),
+			order,
+			clusters);
+		timer.stop();
+
+		printf("%u items in %u clusters took %fms\n",
+			U32(items.size()),
+			U32(clusters.getSize()),
+			timer.getElapsedTime() * 1000.0);
+	}
+}
+
+} // end namespace anki
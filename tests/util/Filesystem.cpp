@@ -18,6 +18,31 @@ ANKI_TEST(Util, FileExists)
 	ANKI_TEST_EXPECT_EQ(fileExists("./tmp"), true);
 }
 
+ANKI_TEST(Util, RenameFile)
+{
+	File file;
+	ANKI_TEST_EXPECT_NO_ERR(file.open("./tmp_new", FileOpenFlag::WRITE));
+	ANKI_TEST_EXPECT_NO_ERR(file.writeText("new"));
+	file.close();
+
+	ANKI_TEST_EXPECT_NO_ERR(file.open("./tmp_old", FileOpenFlag::WRITE));
+	file.close();
+
+	// It replaces the existing file
+	ANKI_TEST_EXPECT_NO_ERR(renameFile("./tmp_new", "./tmp_old"));
+	ANKI_TEST_EXPECT_EQ(fileExists("./tmp_new"), false);
+	ANKI_TEST_EXPECT_EQ(fileExists("./tmp_old"), true);
+
+	HeapAllocator<char> alloc(allocAligned, nullptr);
+	StringAuto txt(alloc);
+	ANKI_TEST_EXPECT_NO_ERR(file.open("./tmp_old", FileOpenFlag::READ));
+	ANKI_TEST_EXPECT_NO_ERR(file.readAllText(txt));
+	ANKI_TEST_EXPECT_EQ(txt, "new");
+	file.close();
+
+	ANKI_TEST_EXPECT_ERR(renameFile("./tmp_new", "./tmp_old"), ErrorCode::FUNCTION_FAILED);
+}
+
 ANKI_TEST(Util, Directory)
 {
 	// Destroy previous
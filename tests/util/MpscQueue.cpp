@@ -0,0 +1,118 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include "tests/framework/Framework.h"
+#include "anki/util/MpscQueue.h"
+#include "anki/util/Thread.h"
+
+namespace anki
+{
+
+ANKI_TEST(Util, MpscQueue)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	// Single thread
+	{
+		MpscQueue<U32> queue;
+		queue.create(alloc, 4);
+
+		ANKI_TEST_EXPECT_EQ(queue.isEmpty(), true);
+
+		for(U32 i = 0; i < 4; ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(queue.tryPush(i), true);
+		}
+
+		ANKI_TEST_EXPECT_EQ(queue.tryPush(10), false);
+
+		// Wrap around a few times
+		for(U32 i = 0; i < 16; ++i)
+		{
+			U32 v;
+			ANKI_TEST_EXPECT_EQ(queue.tryPop(v), true);
+			ANKI_TEST_EXPECT_EQ(v, i);
+			ANKI_TEST_EXPECT_EQ(queue.tryPush(i + 4), true);
+		}
+
+		U32 count = 0;
+		U32 v;
+		while(queue.tryPop(v))
+		{
+			++count;
+		}
+
+		ANKI_TEST_EXPECT_EQ(count, 4);
+		ANKI_TEST_EXPECT_EQ(queue.isEmpty(), true);
+
+		queue.destroy(alloc);
+	}
+
+	// Many producers
+	{
+		const U PRODUCER_COUNT = 4;
+		const U32 ITERATIONS = 1024 * 4;
+
+		class Ctx
+		{
+		public:
+			MpscQueue<U32>* m_queue;
+			U32 m_producerIdx;
+		};
+
+		MpscQueue<U32> queue;
+		queue.create(alloc, 64);
+
+		Array<Thread*, PRODUCER_COUNT> threads;
+		Array<Ctx, PRODUCER_COUNT> ctxs;
+		for(U i = 0; i < PRODUCER_COUNT; ++i)
+		{
+			ctxs[i].m_queue = &queue;
+			ctxs[i].m_producerIdx = i;
+
+			threads[i] = new Thread(nullptr);
+			threads[i]->start(&ctxs[i], [](ThreadCallbackInfo& info) -> Error {
+				Ctx& ctx = *static_cast<Ctx*>(info.m_userData);
+
+				for(U32 i = 0; i < ITERATIONS; ++i)
+				{
+					// Encode the producer in the upper bits
+					while(!ctx.m_queue->tryPush((ctx.m_producerIdx << 24) | i))
+					{
+					}
+				}
+
+				return ErrorCode::NONE;
+			});
+		}
+
+		// Consume. Per producer the values should arrive in order
+		Array<U32, PRODUCER_COUNT> expected = {};
+		U32 count = 0;
+		while(count < ITERATIONS * PRODUCER_COUNT)
+		{
+			U32 v;
+			if(queue.tryPop(v))
+			{
+				const U32 producer = v >> 24;
+				ANKI_TEST_EXPECT_LT(producer, PRODUCER_COUNT);
+				ANKI_TEST_EXPECT_EQ(v & 0xFFFFFF, expected[producer]);
+				++expected[producer];
+				++count;
+			}
+		}
+
+		for(U i = 0; i < PRODUCER_COUNT; ++i)
+		{
+			ANKI_TEST_EXPECT_NO_ERR(threads[i]->join());
+			delete threads[i];
+		}
+
+		ANKI_TEST_EXPECT_EQ(queue.isEmpty(), true);
+		queue.destroy(alloc);
+	}
+}
+
+} // end namespace anki
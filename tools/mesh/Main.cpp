@@ -0,0 +1,339 @@
+// Copyright (C) 2009-2016, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/resource/ResourceManager.h>
+#include <anki/resource/ResourceFilesystem.h>
+#include <anki/resource/MeshLoader.h>
+#include <anki/resource/MeshOptimizer.h>
+#include <anki/core/Config.h>
+#include <anki/util/File.h>
+#include <cstring>
+
+using namespace anki;
+
+/// The fraction of the indices of the previous LOD that every LOD keeps.
+static const F32 LOD_RATIO = 0.5;
+
+class Options
+{
+public:
+	const char* m_inFile = nullptr;
+	const char* m_outFile = nullptr;
+	U32 m_lodCount = MAX_LODS;
+};
+
+/// An optimized LOD that is ready to be written.
+class Lod
+{
+public:
+	DynamicArrayAuto<U16> m_indices;
+	DynamicArrayAuto<U8> m_verts;
+	DynamicArrayAuto<MeshLoader::SubMesh> m_subMeshes;
+	U32 m_vertCount = 0;
+	F32 m_error = 0.0; ///< The geometric error against the original mesh.
+
+	Lod(GenericMemoryPoolAllocator<U8> alloc)
+		: m_indices(alloc)
+		, m_verts(alloc)
+		, m_subMeshes(alloc)
+	{
+	}
+};
+
+static Error parseCommandLineArgs(int argc, char** argv, Options& opts)
+{
+	static const char* usage = R"(Usage: %s in_file out_file [options]
+Converts an .ankimesh to the optimized format. The extra LODs are written next to out_file with a _lod<N> suffix.
+Options:
+-lods <number> : The number of LODs including the original (1 to %u, default %u)
+)";
+
+	if(argc < 3)
+	{
+		goto error;
+	}
+
+	opts.m_inFile = argv[1];
+	opts.m_outFile = argv[2];
+
+	for(I i = 3; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "-lods") == 0 && i + 1 < argc)
+		{
+			opts.m_lodCount = U32(atoi(argv[++i]));
+			if(opts.m_lodCount < 1 || opts.m_lodCount > MAX_LODS)
+			{
+				goto error;
+			}
+		}
+		else
+		{
+			goto error;
+		}
+	}
+
+	return ErrorCode::NONE;
+
+error:
+	printf(usage, argv[0], U32(MAX_LODS), U32(MAX_LODS));
+	return ErrorCode::USER_DATA;
+}
+
+/// Reorder the indices of every sub mesh for the vertex cache and the overdraw and then reorder the vertices.
+static void optimizeLod(const MeshLoader& loader, Lod& lod, GenericMemoryPoolAllocator<U8> alloc)
+{
+	const U32 vertCount = loader.getHeader().m_totalVerticesCount;
+
+	for(const MeshLoader::SubMesh& sm : lod.m_subMeshes)
+	{
+		WeakArray<U16> indices(&lod.m_indices[sm.m_firstIndex], sm.m_indicesCount);
+		optimizeVertexCache(indices, vertCount, alloc);
+		optimizeOverdraw(indices, loader.getPositions(), vertCount, alloc);
+	}
+
+	lod.m_verts.create(loader.getVertexDataSize());
+	memcpy(&lod.m_verts[0], loader.getVertexData(), loader.getVertexDataSize());
+	lod.m_vertCount = optimizeVertexFetch(WeakArray<U16>(&lod.m_indices[0], lod.m_indices.getSize()),
+		&lod.m_verts[0],
+		vertCount,
+		loader.getVertexSize(),
+		alloc);
+}
+
+/// Simplify every sub mesh to a fraction of the indices of the previous LOD.
+/// @return False if a sub mesh collapsed.
+static Bool simplifyLod(
+	const MeshLoader& loader, const DynamicArrayAuto<U32>& prevCounts, Lod& lod, GenericMemoryPoolAllocator<U8> alloc)
+{
+	// Start from the original indices since the vertices of the previous LOD are reordered
+	const U32 vertCount = loader.getHeader().m_totalVerticesCount;
+	const U16* srcIndices = reinterpret_cast<const U16*>(loader.getIndexData());
+
+	lod.m_indices.create(loader.getHeader().m_totalIndicesCount);
+	lod.m_subMeshes.create(prevCounts.getSize());
+
+	U32 count = 0;
+	for(U32 i = 0; i < prevCounts.getSize(); ++i)
+	{
+		const MeshLoader::SubMesh& src = loader.getSubMeshes()[i];
+		const U32 target = U32(F32(prevCounts[i]) * LOD_RATIO) / 3 * 3;
+
+		WeakArray<U16> indices(&lod.m_indices[count], src.m_indicesCount);
+		memcpy(&indices[0], srcIndices + src.m_firstIndex, src.m_indicesCount * sizeof(U16));
+		F32 error;
+		const U32 newCount = simplifyMesh(indices, loader.getPositions(), vertCount, target, error, alloc);
+		if(newCount < 3)
+		{
+			return false;
+		}
+
+		lod.m_error = max(lod.m_error, error);
+
+		lod.m_subMeshes[i].m_firstIndex = count;
+		lod.m_subMeshes[i].m_indicesCount = newCount;
+		count += newCount;
+	}
+
+	lod.m_indices.resize(count);
+	optimizeLod(loader, lod, alloc);
+	return true;
+}
+
+static Error writeLod(const MeshLoader& loader, const Lod& lod, CString filename)
+{
+	MeshLoader::Header header = loader.getHeader();
+	memcpy(&header.m_magic[0], "ANKIMES4", 8);
+	header.m_totalIndicesCount = lod.m_indices.getSize();
+	header.m_totalVerticesCount = lod.m_vertCount;
+	header.m_subMeshCount = lod.m_subMeshes.getSize();
+	header.m_lodError = lod.m_error;
+
+	File file;
+	ANKI_CHECK(file.open(filename, FileOpenFlag::WRITE | FileOpenFlag::BINARY));
+	ANKI_CHECK(file.write(&header, sizeof(header)));
+	ANKI_CHECK(file.write(const_cast<MeshLoader::SubMesh*>(&lod.m_subMeshes[0]), lod.m_subMeshes.getSizeInBytes()));
+	ANKI_CHECK(file.write(const_cast<U16*>(&lod.m_indices[0]), lod.m_indices.getSizeInBytes()));
+	ANKI_CHECK(file.write(const_cast<U8*>(&lod.m_verts[0]), lod.m_vertCount * loader.getVertexSize()));
+
+	return ErrorCode::NONE;
+}
+
+static void printStats(CString name, WeakArray<const U16> indices, U32 vertCount, F32 bytesPerVertex, Bool quads)
+{
+	if(quads)
+	{
+		printf("%-8s quads %7u vertices %7u bytes/vertex %.1f\n",
+			&name[0],
+			U32(indices.getSize() / 4),
+			vertCount,
+			bytesPerVertex);
+		return;
+	}
+
+	const VertexCacheStatistics stats = computeVertexCacheStatistics(indices, vertCount);
+	printf("%-8s triangles %7u vertices %7u ACMR %.3f ATVR %.3f bytes/vertex %.1f\n",
+		&name[0],
+		U32(indices.getSize() / 3),
+		vertCount,
+		stats.m_acmr,
+		stats.m_atvr,
+		bytesPerVertex);
+}
+
+static Error convertMesh(const Options& opts, ResourceManager* resources, CString fname, HeapAllocator<U8> alloc)
+{
+	MeshLoader loader(resources, alloc);
+	ANKI_CHECK(loader.load(fname));
+
+	const MeshLoader::Header& header = loader.getHeader();
+	const U32 subMeshCount = header.m_subMeshCount;
+	WeakArray<const U16> inIndices(reinterpret_cast<const U16*>(loader.getIndexData()), header.m_totalIndicesCount);
+
+	// The optimizer works on triangles. The quads only get their vertices converted
+	const Bool quads = (header.m_flags & MeshLoader::Flag::QUADS) == MeshLoader::Flag::QUADS;
+
+	// The vertices of the input file are what is left after the header, the sub meshes and the indices
+	{
+		File in;
+		ANKI_CHECK(in.open(opts.m_inFile, FileOpenFlag::READ | FileOpenFlag::BINARY));
+		const PtrSize vertBytes = in.getSize() - sizeof(header) - subMeshCount * sizeof(MeshLoader::SubMesh)
+			- loader.getIndexDataSize();
+		printStats(
+			"before", inIndices, header.m_totalVerticesCount, F32(vertBytes) / header.m_totalVerticesCount, quads);
+	}
+
+	// LOD 0 keeps all the triangles
+	Lod lod0(alloc);
+	lod0.m_indices.create(header.m_totalIndicesCount);
+	memcpy(&lod0.m_indices[0], &inIndices[0], inIndices.getSizeInBytes());
+	lod0.m_subMeshes.create(subMeshCount);
+	memcpy(&lod0.m_subMeshes[0], &loader.getSubMeshes()[0], lod0.m_subMeshes.getSizeInBytes());
+
+	if(quads)
+	{
+		lod0.m_verts.create(loader.getVertexDataSize());
+		memcpy(&lod0.m_verts[0], loader.getVertexData(), loader.getVertexDataSize());
+		lod0.m_vertCount = header.m_totalVerticesCount;
+	}
+	else
+	{
+		optimizeLod(loader, lod0, alloc);
+	}
+
+	printStats("lod 0",
+		WeakArray<const U16>(&lod0.m_indices[0], lod0.m_indices.getSize()),
+		lod0.m_vertCount,
+		F32(loader.getVertexSize()),
+		quads);
+	ANKI_CHECK(writeLod(loader, lod0, opts.m_outFile));
+
+	// The rest of the LODs are written next to the output with a suffix
+	StringAuto base(alloc);
+	CString ext = "";
+	const char* dot = strrchr(opts.m_outFile, '.');
+	if(dot)
+	{
+		base.create(opts.m_outFile, dot);
+		ext = dot;
+	}
+	else
+	{
+		base.create(opts.m_outFile);
+	}
+
+	DynamicArrayAuto<U32> prevCounts(alloc);
+	prevCounts.create(subMeshCount);
+	for(U32 i = 0; i < subMeshCount; ++i)
+	{
+		prevCounts[i] = lod0.m_subMeshes[i].m_indicesCount;
+	}
+
+	for(U32 l = 1; l < opts.m_lodCount && !quads; ++l)
+	{
+		Lod lod(alloc);
+		if(!simplifyLod(loader, prevCounts, lod, alloc))
+		{
+			printf("lod %u    the mesh can't be simplified further\n", l);
+			break;
+		}
+
+		StringAuto lodName(alloc);
+		lodName.sprintf("lod %u", l);
+		printStats(lodName.toCString(),
+			WeakArray<const U16>(&lod.m_indices[0], lod.m_indices.getSize()),
+			lod.m_vertCount,
+			F32(loader.getVertexSize()),
+			false);
+		printf("%-8s error %f\n", &lodName[0], lod.m_error);
+
+		StringAuto lodFname(alloc);
+		lodFname.sprintf("%s_lod%u%s", &base[0], l, &ext[0]);
+		ANKI_CHECK(writeLod(loader, lod, lodFname.toCString()));
+
+		for(U32 i = 0; i < subMeshCount; ++i)
+		{
+			prevCounts[i] = lod.m_subMeshes[i].m_indicesCount;
+		}
+	}
+
+	return ErrorCode::NONE;
+}
+
+static Error convert(const Options& opts, HeapAllocator<U8> alloc)
+{
+	// The directory of the input is the data path
+	StringAuto dir(alloc);
+	CString fname = opts.m_inFile;
+	const char* slash = strrchr(opts.m_inFile, '/');
+	if(slash)
+	{
+		dir.create(opts.m_inFile, slash);
+		fname = slash + 1;
+	}
+	else
+	{
+		dir.create(".");
+	}
+
+	Config config;
+	config.set("dataPaths", dir.toCString());
+
+	ResourceFilesystem fs(alloc);
+	ANKI_CHECK(fs.init(config, "/tmp/"));
+
+	ResourceManagerInitInfo rinit;
+	rinit.m_resourceFs = &fs;
+	rinit.m_config = &config;
+	rinit.m_cacheDir = "/tmp/";
+	rinit.m_allocCallback = allocAligned;
+	ResourceManager* resources = alloc.newInstance<ResourceManager>();
+
+	Error err = resources->create(rinit);
+	if(!err)
+	{
+		err = convertMesh(opts, resources, fname, alloc);
+	}
+
+	alloc.deleteInstance(resources);
+	return err;
+}
+
+int main(int argc, char** argv)
+{
+	Options opts;
+	if(parseCommandLineArgs(argc, argv, opts))
+	{
+		return 1;
+	}
+
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	if(convert(opts, alloc))
+	{
+		ANKI_LOGE("Converting %s failed", opts.m_inFile);
+		return 1;
+	}
+
+	return 0;
+}
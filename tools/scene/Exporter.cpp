@@ -325,10 +325,34 @@ void Exporter::exportSkeleton(const aiMesh& mesh) const
 		file << "\t\t\t<transform>";
 		for(uint32_t j = 0; j < 16; j++)
 		{
-			file << bone.mOffsetMatrix[j] << " ";
+			file << bone.mOffsetMatrix[j / 4][j % 4] << " ";
 		}
 		file << "</transform>\n";
 
+		// <parent>. The closest ancestor node that is a bone
+		const aiNode* node = m_scene->mRootNode->FindNode(bone.mName);
+		const aiNode* parent = (node) ? node->mParent : nullptr;
+		while(parent)
+		{
+			bool isBone = false;
+			for(uint32_t k = 0; k < mesh.mNumBones; k++)
+			{
+				if(mesh.mBones[k]->mName == parent->mName)
+				{
+					isBone = true;
+					break;
+				}
+			}
+
+			if(isBone)
+			{
+				file << "\t\t\t<parent>" << parent->mName.C_Str() << "</parent>\n";
+				break;
+			}
+
+			parent = parent->mParent;
+		}
+
 		file << "\t\t</bone>\n";
 	}
 